@@ -9,6 +9,13 @@
 #include "context.h"
 #include "value.h"
 #include "runtime/builtins/builtins_manager.h"
+#include "vm/interpreter/interpreter.h"
+#include "vm/interpreter/jit_bridge.h"
+#include "jit/tiered_jit_manager.h"
+#include "jit/jit_manager.h"
+#include "../utils/memory/allocators/size_class_allocator.h"
+#include "../utils/memory/gc/parallel_gc.h"
+#include "../utils/memory/gc/gc_controller.h"
 #include <memory>
 #include <stdexcept>
 #include <cstring>
@@ -22,13 +29,18 @@ namespace aerojs {
 namespace core {
 
 Engine::Engine() 
-    : memoryAllocator_(std::make_unique<utils::memory::StandardAllocator>()),
+    : memoryAllocator_(std::make_unique<utils::memory::SizeClassAllocator>()),
       memoryPool_(std::make_unique<utils::memory::MemoryPool>()),
       timer_(std::make_unique<utils::Timer>()),
       garbageCollector_(nullptr),
+      parallelGC_(nullptr),
+      gcController_(nullptr),
       builtinsManager_(nullptr),
       interpreter_(nullptr),
-      globalContext_(nullptr) {
+      globalContext_(nullptr),
+      tieredJIT_(nullptr),
+      jitManager_(nullptr),
+      jitBridge_(nullptr) {
     
     // デフォルト設定を適用
     config_ = EngineConfig{};
@@ -38,13 +50,18 @@ Engine::Engine()
 }
 
 Engine::Engine(const EngineConfig& config)
-    : memoryAllocator_(std::make_unique<utils::memory::StandardAllocator>()),
+    : memoryAllocator_(std::make_unique<utils::memory::SizeClassAllocator>()),
       memoryPool_(std::make_unique<utils::memory::MemoryPool>()),
       timer_(std::make_unique<utils::Timer>()),
       garbageCollector_(nullptr),
+      parallelGC_(nullptr),
+      gcController_(nullptr),
       builtinsManager_(nullptr),
       interpreter_(nullptr),
       globalContext_(nullptr),
+      tieredJIT_(nullptr),
+      jitManager_(nullptr),
+      jitBridge_(nullptr),
       config_(config) {
     
     jitEnabled_ = config_.enableJIT;
@@ -104,6 +121,9 @@ bool Engine::initialize(const EngineConfig& config) {
 
 bool Engine::initializeMemorySystem() {
     try {
+        // 以後に確保するヒープ領域に効くよう、アロケータより先に設定する
+        utils::memory::setLargePageMode(config_.largePageMode);
+        
         // メモリアロケータの初期化
         if (!memoryAllocator_->initialize()) {
             return false;
@@ -121,6 +141,18 @@ bool Engine::initializeMemorySystem() {
         garbageCollector_ = std::make_unique<utils::memory::GarbageCollector>(
             memoryAllocator_.get(), memoryPool_.get());
         
+        // 世代別並列GCとスケジューラの初期化
+        if (config_.enableParallelGC) {
+            utils::memory::ParallelGCConfig gcConfig;
+            gcConfig.maxHeapSize = config_.maxMemoryLimit;
+            gcConfig.heapNode = config_.numaHeapNode;
+            parallelGC_ = std::make_unique<utils::memory::ParallelGC>(gcConfig);
+            parallelGC_->setHeapLimitTerminationHandler([this]() {
+                terminationState_.request(TerminationReason::HeapLimit);
+            });
+            gcController_ = std::make_unique<utils::memory::GCController>(*parallelGC_);
+        }
+        
         return true;
     } catch (const std::exception& e) {
         (void)e; // 未使用パラメータ警告を回避
@@ -139,6 +171,33 @@ bool Engine::initializeRuntimeSystem() {
             builtinsManager_->initializeContext(globalContext_.get());
         }
         
+        interpreter_ = std::make_unique<Interpreter>();
+        // 打ち切り要求は命令ループと関数呼び出しで確認する
+        interpreter_->setTerminationState(&terminationState_);
+        
+        // ホットなループはOSRでJITコードへ入り、JITコードの脱最適化はインタプリタで続きを実行する
+        if (config_.enableJIT) {
+            tieredJIT_ = std::make_unique<TieredJITManager>(globalContext_.get());
+            tieredJIT_->setTerminationState(&terminationState_);
+            
+            JITOptimizerPolicy policy;
+            policy.osrThreshold = config_.osrThreshold;
+            jitManager_ = std::make_unique<JITManager>(globalContext_.get(), policy);
+            // 最適化コードはプロローグとループの後方分岐で打ち切りフラグを確認する
+            jitManager_->setTerminationState(&terminationState_);
+            // 脱最適化を繰り返した位置の投機は、次の最適化コンパイルから使わない
+            tieredJIT_->setSpeculationBlacklistListener(
+                [manager = jitManager_.get()](uint64_t functionId, const SpeculationBlacklist& blacklist) {
+                    manager->setSpeculationBlacklist(functionId, blacklist);
+                });
+            
+            // コンテキストの所有はエンジンのまま（ブリッジは shutdown で先に外す）
+            ContextPtr context(ContextPtr(), globalContext_.get());
+            jitBridge_ = std::make_unique<InterpreterJITBridge>(*interpreter_, context, *tieredJIT_,
+                                                                jitManager_.get());
+            jitBridge_->install(config_.osrThreshold);
+        }
+        
         return true;
     } catch (const std::exception& e) {
         (void)e; // 未使用パラメータ警告を回避
@@ -156,12 +215,29 @@ void Engine::shutdown() {
         cooldown();
         
         // リソースのクリーンアップ
+        // JITとの乗り換えを外してから、JIT・インタプリタ・コンテキストを破棄する
+        if (jitBridge_) {
+            jitBridge_->uninstall();
+            jitBridge_.reset();
+        }
+        if (tieredJIT_) {
+            tieredJIT_->setSpeculationBlacklistListener(nullptr);
+        }
+        jitManager_.reset();
+        tieredJIT_.reset();
+        interpreter_.reset();
         if (globalContext_) {
             globalContext_.reset();
         }
         if (builtinsManager_) {
             builtinsManager_.reset();
         }
+        if (gcController_) {
+            gcController_.reset();
+        }
+        if (parallelGC_) {
+            parallelGC_.reset();
+        }
         if (garbageCollector_) {
             garbageCollector_.reset();
         }
@@ -255,6 +331,21 @@ Value Engine::evaluateInternal(const std::string& source, const std::string& fil
         }
         
         return result;
+    } catch (const ExecutionTerminated& e) {
+        // 巻き戻しは完了したので、次の評価に備えてフラグを下ろす
+        terminationState_.cancel();
+        if (e.reason() == TerminationReason::HeapLimit) {
+            handleError(EngineError::OutOfMemory, "Execution terminated: heap limit reached");
+        } else {
+            handleError(EngineError::ExecutionTerminated, "Execution terminated");
+        }
+        return Value::undefined();
+    } catch (const utils::memory::HeapLimitExceeded& e) {
+        terminationState_.cancel();
+        handleError(EngineError::OutOfMemory,
+                    "Heap limit reached: " + std::to_string(e.used()) + " of " +
+                    std::to_string(e.limit()) + " bytes in use");
+        return Value::undefined();
     } catch (const std::exception& e) {
         handleError(EngineError::RuntimeError, e.what());
         return Value::undefined();
@@ -312,6 +403,52 @@ void Engine::collectGarbage() {
     }
 }
 
+bool Engine::startAllocationSampling(size_t sampleInterval, utils::memory::AllocationStackCapture capture) {
+    if (!parallelGC_) {
+        return false;
+    }
+    parallelGC_->getSamplingHeapProfiler().start(sampleInterval, std::move(capture));
+    return true;
+}
+
+void Engine::stopAllocationSampling() {
+    if (parallelGC_) {
+        parallelGC_->getSamplingHeapProfiler().stop();
+    }
+}
+
+bool Engine::writeAllocationProfile(const std::string& filename) const {
+    if (!parallelGC_) {
+        return false;
+    }
+    return parallelGC_->getSamplingHeapProfiler().writePprof(filename);
+}
+
+bool Engine::writeHeapSnapshot(const std::string& filename) {
+    if (!parallelGC_) {
+        return false;
+    }
+    return parallelGC_->writeHeapSnapshot(filename);
+}
+
+bool Engine::notifyIdle(std::chrono::steady_clock::time_point deadline) {
+    bool pending = false;
+    if (gcController_) {
+        pending = gcController_->notifyIdle(deadline);
+    } else if (memoryAllocator_ && std::chrono::steady_clock::now() < deadline &&
+               memoryAllocator_->getCurrentAllocatedSize() > config_.maxMemoryLimit / 2) {
+        // 基本GCではインクリメンタルな作業がないため、使用量が多い場合のみ回収する
+        collectGarbage();
+    }
+    
+    // アイドル期間はJITフレームがスタックにない安全点なので、コードエイジングの掃引を進める
+    // （コード量が予算を超えていれば期限を過ぎていても掃引する）
+    if (tieredJIT_ && (tieredJIT_->needsCodeAging() || std::chrono::steady_clock::now() < deadline)) {
+        tieredJIT_->ageCompiledCode();
+    }
+    return pending;
+}
+
 void Engine::performGCIfNeeded() {
     static size_t evaluationCount = 0;
     evaluationCount++;
@@ -319,6 +456,11 @@ void Engine::performGCIfNeeded() {
     if (evaluationCount >= gcFrequency_) {
         collectGarbage();
         evaluationCount = 0;
+        
+        // 評価を終えたGCの後は安全点なので、コードエイジングの掃引も行う
+        if (tieredJIT_) {
+            tieredJIT_->ageCompiledCode();
+        }
     }
 }
 
@@ -361,6 +503,27 @@ void Engine::setMemoryLimit(size_t limit) {
     if (memoryAllocator_) {
         memoryAllocator_->setMemoryLimit(limit);
     }
+    if (parallelGC_) {
+        parallelGC_->setHeapLimit(limit);
+    }
+}
+
+void Engine::setNearHeapLimitCallback(utils::memory::NearHeapLimitCallback callback) {
+    if (parallelGC_) {
+        parallelGC_->setNearHeapLimitCallback(std::move(callback));
+    }
+}
+
+void Engine::terminateExecution() {
+    terminationState_.request(TerminationReason::Requested);
+}
+
+void Engine::cancelTerminateExecution() {
+    terminationState_.cancel();
+}
+
+bool Engine::isExecutionTerminating() const {
+    return terminationState_.isRequested();
 }
 
 size_t Engine::getMemoryLimit() const {
@@ -388,6 +551,11 @@ size_t Engine::getPeakMemoryUsage() const {
     return getCurrentMemoryUsage();
 }
 
+utils::memory::LargePageStats Engine::getLargePageStats() const {
+    // プロセス全体の値（ヒープとJITコード領域の合計）
+    return utils::memory::getLargePageStats();
+}
+
 void Engine::optimizeMemory() {
     // メモリ最適化の実行
     collectGarbage();
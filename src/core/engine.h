@@ -9,9 +9,13 @@
 #define AEROJS_CORE_ENGINE_H
 
 #include "value.h"
+#include "../utils/memory/allocators/large_pages.h"
 #include "../utils/memory/allocators/memory_allocator.h"
 #include "../utils/memory/pool/memory_pool.h"
 #include "../utils/memory/gc/garbage_collector.h"
+#include "../utils/memory/gc/sampling_heap_profiler.h"
+#include "../utils/memory/gc/heap_limit.h"
+#include "vm/exception/termination.h"
 #include "../utils/time/timer.h"
 #include <memory>
 #include <string>
@@ -24,10 +28,21 @@
 #include <unordered_map>
 
 namespace aerojs {
+namespace utils {
+namespace memory {
+class ParallelGC;
+class GCController;
+}
+}
+
 namespace core {
 
 // 前方宣言
 class Context;
+class Interpreter;
+class InterpreterJITBridge;
+class TieredJITManager;
+class JITManager;
 
 namespace runtime {
 namespace builtins {
@@ -52,7 +67,8 @@ enum class EngineError {
     SecurityError,
     NetworkError,
     ModuleError,
-    QuantumError
+    QuantumError,
+    ExecutionTerminated
 };
 
 /**
@@ -82,12 +98,18 @@ struct EngineStats {
 struct EngineConfig {
     size_t maxMemoryLimit = 1024 * 1024 * 1024; // 1GB
     uint32_t jitThreshold = 100;
+    uint32_t osrThreshold = 1000;  // ループのバックエッジがこの回数に達するたびにOSRを試みる
     uint32_t optimizationLevel = 2;
     uint32_t gcFrequency = 1000;
     bool enableJIT = true;
     bool enableProfiling = false;
     bool enableDebugging = false;
     bool strictMode = false;
+    bool enableParallelGC = false;  // 世代別並列GCとアイドル時間スケジューラを使用
+    // ヒープとJITコード領域のラージページ（2MB）利用。使えない環境では通常ページで確保する
+    utils::memory::LargePageMode largePageMode = utils::memory::LargePageMode::Disabled;
+    // ヒープを固定するNUMAノード（enableParallelGC 時のみ。-1 は割り当てスレッドのノード）
+    int numaHeapNode = -1;
     std::string engineName = "AeroJS";
     std::string version = "1.0.0";
 };
@@ -125,6 +147,7 @@ public:
     void collectGarbage();
     size_t getGCFrequency() const;
     void setGCFrequency(size_t frequency);
+    bool notifyIdle(std::chrono::steady_clock::time_point deadline);  // アイドル期間の通知
 
     // JIT設定
     void enableJIT(bool enable);
@@ -140,7 +163,18 @@ public:
     size_t getCurrentMemoryUsage() const;
     size_t getTotalMemoryUsage() const;
     size_t getPeakMemoryUsage() const;
+    utils::memory::LargePageStats getLargePageStats() const;
     void optimizeMemory();
+    
+    // ヒープ上限（enableParallelGC 時のみ。GC後も上限を超える割り当てで呼ばれ、
+    // 上限の引き上げか打ち切りを選べる。どちらもしなければ全回収を試して打ち切る）
+    void setNearHeapLimitCallback(utils::memory::NearHeapLimitCallback callback);
+    
+    // 実行の打ち切り（任意のスレッドから要求でき、評価中のスクリプトは undefined で戻る）
+    void terminateExecution();
+    void cancelTerminateExecution();
+    bool isExecutionTerminating() const;
+    const TerminationState& getTerminationState() const { return terminationState_; }  // インタプリタ・JITに渡す
 
     // エラーハンドリング
     void setErrorHandler(ErrorHandler handler);
@@ -161,6 +195,15 @@ public:
     void enableProfiling(bool enable);
     bool isProfilingEnabled() const;
     std::string getProfilingReport() const;
+    
+    // 割り当てサンプリング（enableParallelGC 時のみ。capture はVMのスタック取得、例: Interpreter::captureAllocationStack）
+    bool startAllocationSampling(size_t sampleInterval = utils::memory::SamplingHeapProfiler::kDefaultSampleInterval,
+                                 utils::memory::AllocationStackCapture capture = utils::memory::AllocationStackCapture());
+    void stopAllocationSampling();
+    bool writeAllocationProfile(const std::string& filename) const;  // pprof形式
+    
+    // ヒープスナップショット（enableParallelGC 時のみ。解析は aerojs_heap_analyzer で行う）
+    bool writeHeapSnapshot(const std::string& filename);
 
     // アクセサ
     utils::memory::MemoryAllocator* getMemoryAllocator() const;
@@ -179,9 +222,14 @@ private:
     std::unique_ptr<utils::memory::MemoryPool> memoryPool_;
     std::unique_ptr<utils::Timer> timer_;
     std::unique_ptr<utils::memory::GarbageCollector> garbageCollector_;
+    std::unique_ptr<utils::memory::ParallelGC> parallelGC_;
+    std::unique_ptr<utils::memory::GCController> gcController_;
     std::unique_ptr<runtime::builtins::BuiltinsManager> builtinsManager_;
-    void* interpreter_;
+    std::unique_ptr<Interpreter> interpreter_;
     std::unique_ptr<Context> globalContext_;
+    std::unique_ptr<TieredJITManager> tieredJIT_;      // JITが有効なときだけ
+    std::unique_ptr<JITManager> jitManager_;           // JITが有効なときだけ（最適化コンパイラを持つ）
+    std::unique_ptr<InterpreterJITBridge> jitBridge_;  // JITが有効なときだけ（interpreter_ と tieredJIT_ より先に破棄）
 
     // 設定と状態
     EngineConfig config_;
@@ -190,6 +238,7 @@ private:
     std::atomic<uint32_t> jitThreshold_{100};
     std::atomic<uint32_t> optimizationLevel_{2};
     std::atomic<size_t> gcFrequency_{1000};
+    TerminationState terminationState_;
 
     // エラー管理
     std::atomic<EngineError> lastError_{EngineError::None};
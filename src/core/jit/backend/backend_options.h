@@ -0,0 +1,48 @@
+/**
+ * @file backend_options.h
+ * @brief 最適化JITからバックエンドへ渡すコード生成オプション
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "../deoptimizer/frame_state.h"
+#include "../deoptimizer/speculation.h"
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief バックエンドのコード生成オプション
+ *
+ * frameStates を渡すと、バックエンドは呼び出しの戻り先とガードの失敗箇所ごとに
+ * IR のフレーム状態をレジスタ・スタックスロットへ解決して記録する。
+ * speculationBlacklists は関数IDごとの禁止された投機で、禁止された位置のガードは生成しない。
+ */
+struct BackendOptions {
+    uint64_t functionId = 0;              ///< コンパイル中の関数（IRFrameState::functionId が 0 のフレーム）
+    int optimizationLevel = 2;
+    bool enableSIMD = true;
+    bool enableFastMath = false;
+    bool enableDeoptSupport = true;
+    FrameStateBuilder* frameStates = nullptr;
+    const std::unordered_map<uint64_t, SpeculationBlacklist>* speculationBlacklists = nullptr;
+
+    /**
+     * @brief 位置での投機が禁止されていないか
+     */
+    bool IsSpeculationAllowed(uint64_t function, uint32_t bytecodeOffset, SpeculationKind kind) const {
+        if (!speculationBlacklists) {
+            return true;
+        }
+        auto it = speculationBlacklists->find(function);
+        return it == speculationBlacklists->end() || it->second.IsAllowed(bytecodeOffset, kind);
+    }
+};
+
+}  // namespace core
+}  // namespace aerojs
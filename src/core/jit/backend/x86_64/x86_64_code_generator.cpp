@@ -1,4 +1,9 @@
 #include "x86_64_code_generator.h"
+#include "../../deoptimizer/deoptimizer.h"
+#include "../../../vm/exception/termination.h"
+#ifdef AEROJS_POINTER_COMPRESSION
+#include "../../../../utils/memory/allocators/heap_cage.h"
+#endif
 #include <cassert>
 #include <cstring>
 #if defined(__GNUC__) || defined(__clang__)
@@ -12,7 +17,8 @@ namespace core {
 namespace jit {
 
 X86_64CodeGenerator::X86_64CodeGenerator(Context* context, uint32_t optimizationFlags) noexcept 
-    : m_context(context), m_optimizationFlags(optimizationFlags), m_currentFrameSize(0), m_nextSpillOffset(0) {
+    : m_context(context), m_optimizationFlags(optimizationFlags), m_currentFrameSize(0), m_nextSpillOffset(0),
+      m_interruptFlag(nullptr) {
     ResetFrameInfo();
 }
 
@@ -119,8 +125,25 @@ bool X86_64CodeGenerator::ResolveLabels(std::vector<uint8_t>& code) noexcept {
 }
 
 bool X86_64CodeGenerator::Generate(const IRFunction& function, std::vector<uint8_t>& outCode) noexcept {
+    return Generate(function, outCode, BackendOptions());
+}
+
+bool X86_64CodeGenerator::Generate(const IRFunction& function, std::vector<uint8_t>& outCode,
+                                   const BackendOptions& options) noexcept {
     outCode.clear(); 
     ResetFrameInfo(); // 各関数生成前に状態をリセット
+    m_backendOptions = &options;
+    m_function = &function;
+    m_safepoints.clear();
+    m_deoptStubs.clear();
+    m_safepointError = false;
+    auto finish = [this](bool result) {
+        m_backendOptions = nullptr;
+        m_function = nullptr;
+        m_safepoints.clear();
+        m_deoptStubs.clear();
+        return result;
+    };
 
     JITProfiler* profiler = nullptr;
     if (m_context) { 
@@ -132,6 +155,11 @@ bool X86_64CodeGenerator::Generate(const IRFunction& function, std::vector<uint8
     // ここでは、一旦プロローグの基本部分のみ出力し、スタック確保はエピローグ前に行う戦略
     EncodePrologueMinimal(outCode); 
 
+    // 打ち切り要求の確認（再帰呼び出しだけで回り続けるコードもここで止まる）
+    if (m_interruptFlag) {
+        EmitInterruptPoll(outCode);
+    }
+
     for (const auto* block : function.blocks) { 
         if (!block) continue;
         
@@ -210,6 +238,21 @@ bool X86_64CodeGenerator::Generate(const IRFunction& function, std::vector<uint8
                     success = EncodeStoreMemory(inst, outCode);
                     break;
                 
+                case Opcode::kCheckNumber:
+                    success = EncodeCheckNumber(inst, outCode);
+                    break;
+                
+                case Opcode::kLoadCompressed:
+                    success = EncodeLoadCompressed(inst, outCode);
+                    break;
+                case Opcode::kStoreCompressed:
+                    success = EncodeStoreCompressed(inst, outCode);
+                    break;
+                
+                case Opcode::kDeoptimizeUnless:
+                    success = EncodeDeoptimizeUnless(inst, outCode);
+                    break;
+                
                 // ... 他のIROpcodeのケース ...
                 // case Opcode::kShiftLeft: success = EncodeShift(inst, outCode); break;
                 // case Opcode::kBitAnd: success = EncodeBitwise(inst, outCode); break;
@@ -224,21 +267,35 @@ bool X86_64CodeGenerator::Generate(const IRFunction& function, std::vector<uint8
             if (!success) {
                 // Log error: std::cerr << "Failed to encode instruction: " << static_cast<int>(inst.opcode) << std::endl;
                 outCode.clear(); // 生成途中のコードを破棄
-                return false; // エラー発生
+                return finish(false); // エラー発生
             }
         }
     }
 
+    // ガードの失敗時に即時脱最適化するスタブ
+    EmitDeoptimizationStubs(outCode);
+    if (m_safepointError) {
+        outCode.clear();
+        return finish(false);
+    }
+
+    // ポーリングの分岐先（フレームを畳んで打ち切りの番兵値を返す）
+    if (m_interruptFlag) {
+        EmitTerminationExit(outCode);
+    }
+
     // 全ての命令生成後、フレームサイズに基づいてプロローグのスタック確保部分を完成させ、エピローグを生成
     FinalizeFrame(outCode); // プロローグのSUB RSP, size とエピローグをここで行う
 
     if (!ResolveLabels(outCode)) { 
        // Log error: std::cerr << "Failed to resolve labels." << std::endl;
        outCode.clear();
-       return false;
+       return finish(false);
     }
 
-    return true;
+    // オフセットが確定したのでセーフポイントを記録する
+    FlushSafepoints();
+    return finish(true);
 }
 
 void X86_64CodeGenerator::SetRegisterMapping(int32_t virtualReg, X86_64Register physicalReg) noexcept {
@@ -2603,6 +2660,10 @@ bool X86_64CodeGenerator::EncodeJump(const IRInstruction& inst, std::vector<uint
     if (targetOp.type == IROperandType::kLabel) {
         // ラベルへの無条件ジャンプ
         std::string labelName = targetOp.value.label_name;
+        // 定義済みラベルへの分岐はループの後方分岐なので、打ち切り要求を確認してから飛ぶ
+        if (m_interruptFlag && GetLabelPosition(labelName) >= 0) {
+            EmitInterruptPoll(code);
+        }
         EmitJMP_Label(labelName, false); // 32ビットジャンプ
         return true;
     } else if (targetOp.type == IROperandType::kRegister) {
@@ -2759,6 +2820,12 @@ bool X86_64CodeGenerator::EncodeCall(const IRInstruction& inst, std::vector<uint
         AppendModRM(code, 0x03, 2, static_cast<uint8_t>(targetPhysReg) & 0x7);
     }
     
+    // 戻り先が遅延脱最適化のセーフポイント（呼び出し先で無効化されたらここから復元する）
+    if (inst.frameState >= 0 &&
+        !RecordSafepoint(static_cast<uint32_t>(code.size()), SafepointKind::Call, inst.frameState)) {
+        return false;
+    }
+    
     // スタック復元
     if (stackSpace > 0) {
         if (stackSpace <= 127) {
@@ -2808,6 +2875,180 @@ void X86_64CodeGenerator::EmitMOV_Reg_Imm(X86_64Register dest, int64_t imm) noex
     }
 }
 
+// ケージベースを kCageBaseRegister に読み込む（MOV R14, imm64）
+// R14 は callee-saved のため、EncodePrologueMinimal で退避した後にだけ呼ぶ
+void X86_64CodeGenerator::EmitLoadCageBase(std::vector<uint8_t>& code) noexcept {
+#ifdef AEROJS_POINTER_COMPRESSION
+    uint8_t reg = static_cast<uint8_t>(kCageBaseRegister);
+    AppendREXPrefix(code, true, false, false, reg >= 8);
+    code.push_back(0xB8 + (reg & 0x7));
+    uint64_t base = static_cast<uint64_t>(utils::memory::HeapCage::base());
+    for (int i = 0; i < 8; ++i) {
+        code.push_back(static_cast<uint8_t>(base >> (i * 8)));
+    }
+#else
+    (void)code;
+#endif
+}
+
+// 32ビットオフセットを読み込み、0（null）以外ならケージベースを加算して展開
+//   mov dest32, [base + disp32]   ; 上位32ビットはゼロ拡張
+//   test dest, dest
+//   jz +3
+//   add dest, r14
+void X86_64CodeGenerator::EmitLoadCompressedPointer(X86_64Register dest, X86_64Register base, int32_t disp,
+                                                    std::vector<uint8_t>& code) noexcept {
+    uint8_t d = static_cast<uint8_t>(dest);
+    uint8_t b = static_cast<uint8_t>(base);
+    uint8_t cage = static_cast<uint8_t>(kCageBaseRegister);
+    
+    if (d >= 8 || b >= 8) {
+        AppendREXPrefix(code, false, d >= 8, false, b >= 8);
+    }
+    code.push_back(0x8B); // MOV r32, r/m32
+    AppendModRM(code, 0x02, d & 0x7, b & 0x7);
+    if ((b & 0x7) == 0x4) {
+        AppendSIB(code, 0, 0x4, 0x4); // RSP/R12ベースはSIBが必要
+    }
+    AppendImmediate32(code, disp);
+    
+    AppendREXPrefix(code, true, d >= 8, false, d >= 8);
+    code.push_back(0x85); // TEST r/m64, r64
+    AppendModRM(code, 0x03, d & 0x7, d & 0x7);
+    code.push_back(0x74); // JZ rel8
+    code.push_back(0x03); // ADD r64, r14 は常にREX付きの3バイト
+    AppendREXPrefix(code, true, cage >= 8, false, d >= 8);
+    code.push_back(0x01); // ADD r/m64, r64
+    AppendModRM(code, 0x03, cage & 0x7, d & 0x7);
+}
+
+// 圧縮参照のフィールドのロード（dest, base, 即値のオフセット）
+// 退避されたオペランドは R11 を経由する（R11 はレジスタ割り当ての対象外）
+bool X86_64CodeGenerator::EncodeLoadCompressed(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept {
+    if (inst.num_operands() < 3 || !inst.operand(0).isVirtualReg() || !inst.operand(1).isVirtualReg() ||
+        !inst.operand(2).isImmediate()) {
+        return false;
+    }
+    int32_t destVirtualReg = inst.operand(0).getVirtualReg();
+    int32_t baseVirtualReg = inst.operand(1).getVirtualReg();
+    int32_t disp = static_cast<int32_t>(inst.operand(2).getImmediateValue());
+    
+    X86_64Register base = X86_64Register::R11;
+    if (std::optional<X86_64Register> physBase = GetPhysicalReg(baseVirtualReg)) {
+        base = physBase.value();
+    } else if (!EncodeLoadFromSpillSlot(base, baseVirtualReg, code)) {
+        return false;
+    }
+    std::optional<X86_64Register> physDest = GetPhysicalReg(destVirtualReg);
+    X86_64Register dest = physDest.value_or(X86_64Register::R11);
+    
+#ifdef AEROJS_POINTER_COMPRESSION
+    EmitLoadCompressedPointer(dest, base, disp, code);
+#else
+    // 圧縮しない場合のフィールドは生ポインタ（MOV r64, [base + disp32]）
+    uint8_t d = static_cast<uint8_t>(dest);
+    uint8_t b = static_cast<uint8_t>(base);
+    AppendREXPrefix(code, true, d >= 8, false, b >= 8);
+    code.push_back(0x8B);
+    AppendModRM(code, 0x02, d & 0x7, b & 0x7);
+    if ((b & 0x7) == 0x4) {
+        AppendSIB(code, 0, 0x4, 0x4);
+    }
+    AppendImmediate32(code, disp);
+#endif
+    
+    if (!physDest) {
+        return EncodeStoreToSpillSlot(destVirtualReg, dest, code);
+    }
+    return true;
+}
+
+// 参照を圧縮してフィールドへ保存（src, base, 即値のオフセット）
+// 圧縮の作業には R11 を使い、退避されたベースは R10 を退避して読み込む
+bool X86_64CodeGenerator::EncodeStoreCompressed(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept {
+    if (inst.num_operands() < 3 || !inst.operand(0).isVirtualReg() || !inst.operand(1).isVirtualReg() ||
+        !inst.operand(2).isImmediate()) {
+        return false;
+    }
+    int32_t srcVirtualReg = inst.operand(0).getVirtualReg();
+    int32_t baseVirtualReg = inst.operand(1).getVirtualReg();
+    int32_t disp = static_cast<int32_t>(inst.operand(2).getImmediateValue());
+    
+    X86_64Register src = X86_64Register::R11;
+    if (std::optional<X86_64Register> physSrc = GetPhysicalReg(srcVirtualReg)) {
+        src = physSrc.value();
+    } else if (!EncodeLoadFromSpillSlot(src, srcVirtualReg, code)) {
+        return false;
+    }
+    
+    X86_64Register base = X86_64Register::R10;
+    std::optional<X86_64Register> physBase = GetPhysicalReg(baseVirtualReg);
+    if (physBase) {
+        base = physBase.value();
+    } else {
+        code.push_back(0x41); code.push_back(0x52); // PUSH R10
+        if (!EncodeLoadFromSpillSlot(base, baseVirtualReg, code)) {
+            return false;
+        }
+    }
+    
+#ifdef AEROJS_POINTER_COMPRESSION
+    EmitStoreCompressedPointer(base, disp, src, X86_64Register::R11, code);
+#else
+    // 圧縮しない場合のフィールドは生ポインタ（MOV [base + disp32], r64）
+    uint8_t sr = static_cast<uint8_t>(src);
+    uint8_t b = static_cast<uint8_t>(base);
+    AppendREXPrefix(code, true, sr >= 8, false, b >= 8);
+    code.push_back(0x89);
+    AppendModRM(code, 0x02, sr & 0x7, b & 0x7);
+    if ((b & 0x7) == 0x4) {
+        AppendSIB(code, 0, 0x4, 0x4);
+    }
+    AppendImmediate32(code, disp);
+#endif
+    
+    if (!physBase) {
+        code.push_back(0x41); code.push_back(0x5A); // POP R10
+    }
+    return true;
+}
+
+// ポインタをオフセットへ圧縮して32ビットで格納（nullは0のまま）
+//   mov scratch, src
+//   test scratch, scratch
+//   jz +3
+//   sub scratch, r14
+//   mov [base + disp32], scratch32
+void X86_64CodeGenerator::EmitStoreCompressedPointer(X86_64Register base, int32_t disp, X86_64Register src,
+                                                     X86_64Register scratch, std::vector<uint8_t>& code) noexcept {
+    uint8_t sr = static_cast<uint8_t>(src);
+    uint8_t sc = static_cast<uint8_t>(scratch);
+    uint8_t b = static_cast<uint8_t>(base);
+    uint8_t cage = static_cast<uint8_t>(kCageBaseRegister);
+    
+    AppendREXPrefix(code, true, sr >= 8, false, sc >= 8);
+    code.push_back(0x89); // MOV r/m64, r64
+    AppendModRM(code, 0x03, sr & 0x7, sc & 0x7);
+    AppendREXPrefix(code, true, sc >= 8, false, sc >= 8);
+    code.push_back(0x85); // TEST r/m64, r64
+    AppendModRM(code, 0x03, sc & 0x7, sc & 0x7);
+    code.push_back(0x74); // JZ rel8
+    code.push_back(0x03); // SUB r64, r14 は常にREX付きの3バイト
+    AppendREXPrefix(code, true, cage >= 8, false, sc >= 8);
+    code.push_back(0x29); // SUB r/m64, r64
+    AppendModRM(code, 0x03, cage & 0x7, sc & 0x7);
+    
+    if (sc >= 8 || b >= 8) {
+        AppendREXPrefix(code, false, sc >= 8, false, b >= 8);
+    }
+    code.push_back(0x89); // MOV r/m32, r32
+    AppendModRM(code, 0x02, sc & 0x7, b & 0x7);
+    if ((b & 0x7) == 0x4) {
+        AppendSIB(code, 0, 0x4, 0x4);
+    }
+    AppendImmediate32(code, disp);
+}
+
 void X86_64CodeGenerator::EmitTEST_Reg_Reg(X86_64Register reg1, X86_64Register reg2) noexcept {
     bool rexR = static_cast<uint8_t>(reg1) >= 8;
     bool rexB = static_cast<uint8_t>(reg2) >= 8;
@@ -3010,6 +3251,274 @@ void X86_64CodeGenerator::EncodePrologueMinimal(std::vector<uint8_t>& code) noex
     code.push_back(0x41); code.push_back(0x55); // PUSH R13
     code.push_back(0x41); code.push_back(0x56); // PUSH R14
     code.push_back(0x41); code.push_back(0x57); // PUSH R15
+    
+    // 圧縮参照の展開を1回の加算で済ませるため、ケージベースを常駐させる
+    // （R14 は上で退避済みで、エピローグで呼び出し元の値に戻る）
+    EmitLoadCageBase(code);
+}
+
+// 打ち切りフラグのポーリング
+// フラグのアドレスはコード領域から±2GBに収まるとは限らないため64ビット即値で読み込む。
+// レジスタ割り当てに影響しないよう R11 を退避して使い、フラグを変えない POP で戻してから分岐する。
+void X86_64CodeGenerator::EmitInterruptPoll(std::vector<uint8_t>& code) noexcept {
+    code.push_back(0x41); code.push_back(0x53); // PUSH R11
+    code.push_back(0x49); code.push_back(0xBB); // MOV R11, imm64
+    uint64_t flagAddress = reinterpret_cast<uint64_t>(m_interruptFlag);
+    for (int i = 0; i < 8; ++i) {
+        code.push_back(static_cast<uint8_t>(flagAddress >> (i * 8)));
+    }
+    code.push_back(0x41); code.push_back(0x80); code.push_back(0x3B); code.push_back(0x00); // CMP BYTE PTR [R11], 0
+    code.push_back(0x41); code.push_back(0x5B); // POP R11
+    EmitJNE_Label("__aerojs_terminated", BranchHint::kLikelyNotTaken, false);
+}
+
+// 打ち切り時の出口（RAX に番兵値を入れて通常のエピローグで戻る）
+void X86_64CodeGenerator::EmitTerminationExit(std::vector<uint8_t>& code) noexcept {
+    DefineLabel("__aerojs_terminated", code);
+    code.push_back(0x48); code.push_back(0xB8); // MOV RAX, imm64
+    for (int i = 0; i < 8; ++i) {
+        code.push_back(static_cast<uint8_t>(kJITTerminationSentinel >> (i * 8)));
+    }
+    EncodeEpilogue(code);
+}
+
+// 投機の判定（値は NaN-boxing のビット列）
+//   Double: 数値（タグ付きの静かなNaNでない）なら1
+//     mov r11, src ; shr r11, 44 ; and r11d, 0x7FFFF ; cmp r11d, 0x7FF80 ; setbe r11b
+//   Int32: int32 へ切り捨てて戻したビット列が元と同じなら1（小数・範囲外・-0・NaN・タグ付きは0）
+//     XMM15 と RAX を退避して cvttsd2si / cvtsi2sd で往復させる
+bool X86_64CodeGenerator::EncodeCheckNumber(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept {
+    if (inst.num_operands() < 3 || !inst.operand(0).isVirtualReg() || !inst.operand(1).isVirtualReg() ||
+        !inst.operand(2).isImmediate()) {
+        return false;
+    }
+    int32_t destReg = inst.operand(0).getVirtualReg();
+    int32_t srcReg = inst.operand(1).getVirtualReg();
+    SpeculationKind kind = static_cast<SpeculationKind>(inst.operand(2).getImmediateValue());
+    
+    // 判定する値を R11 へ
+    if (std::optional<X86_64Register> physSrc = GetPhysicalReg(srcReg)) {
+        uint8_t src = static_cast<uint8_t>(physSrc.value());
+        AppendREXPrefix(code, true, src >= 8, false, true);
+        code.push_back(0x89); // MOV r/m64, r64
+        AppendModRM(code, 0x03, src & 0x7, static_cast<uint8_t>(X86_64Register::R11) & 0x7);
+    } else if (!EncodeLoadFromSpillSlot(X86_64Register::R11, srcReg, code)) {
+        return false;
+    }
+    
+    if (kind == SpeculationKind::Double) {
+        code.push_back(0x49); code.push_back(0xC1); code.push_back(0xEB); code.push_back(0x2C); // SHR R11, 44
+        code.push_back(0x41); code.push_back(0x81); code.push_back(0xE3);                       // AND R11D, 0x7FFFF
+        AppendImmediate32(code, 0x7FFFF);
+        code.push_back(0x41); code.push_back(0x81); code.push_back(0xFB);                       // CMP R11D, 0x7FF80
+        AppendImmediate32(code, 0x7FF80);
+        code.push_back(0x41); code.push_back(0x0F); code.push_back(0x96); code.push_back(0xC3); // SETBE R11B
+    } else if (kind == SpeculationKind::Int32) {
+        code.push_back(0x50);                                                                   // PUSH RAX
+        code.push_back(0x48); code.push_back(0x83); code.push_back(0xEC); code.push_back(0x10); // SUB RSP, 16
+        code.push_back(0xF3); code.push_back(0x44); code.push_back(0x0F); code.push_back(0x7F); // MOVDQU [RSP], XMM15
+        code.push_back(0x3C); code.push_back(0x24);
+        code.push_back(0x66); code.push_back(0x4D); code.push_back(0x0F); code.push_back(0x6E); // MOVQ XMM15, R11
+        code.push_back(0xFB);
+        code.push_back(0xF2); code.push_back(0x41); code.push_back(0x0F); code.push_back(0x2C); // CVTTSD2SI EAX, XMM15
+        code.push_back(0xC7);
+        code.push_back(0xF2); code.push_back(0x44); code.push_back(0x0F); code.push_back(0x2A); // CVTSI2SD XMM15, EAX
+        code.push_back(0xF8);
+        code.push_back(0x66); code.push_back(0x4C); code.push_back(0x0F); code.push_back(0x7E); // MOVQ RAX, XMM15
+        code.push_back(0xF8);
+        code.push_back(0x4C); code.push_back(0x39); code.push_back(0xD8);                       // CMP RAX, R11
+        code.push_back(0x41); code.push_back(0x0F); code.push_back(0x94); code.push_back(0xC3); // SETE R11B
+        code.push_back(0xF3); code.push_back(0x44); code.push_back(0x0F); code.push_back(0x6F); // MOVDQU XMM15, [RSP]
+        code.push_back(0x3C); code.push_back(0x24);
+        code.push_back(0x48); code.push_back(0x83); code.push_back(0xC4); code.push_back(0x10); // ADD RSP, 16
+        code.push_back(0x58);                                                                   // POP RAX
+    } else {
+        return false;
+    }
+    code.push_back(0x45); code.push_back(0x0F); code.push_back(0xB6); code.push_back(0xDB);     // MOVZX R11D, R11B
+    
+    if (std::optional<X86_64Register> physDest = GetPhysicalReg(destReg)) {
+        uint8_t dest = static_cast<uint8_t>(physDest.value());
+        AppendREXPrefix(code, true, true, false, dest >= 8);
+        code.push_back(0x89); // MOV r/m64, r64
+        AppendModRM(code, 0x03, static_cast<uint8_t>(X86_64Register::R11) & 0x7, dest & 0x7);
+        return true;
+    }
+    return EncodeStoreToSpillSlot(destReg, X86_64Register::R11, code);
+}
+
+// 投機のガード: オペランドが0なら本体の後ろのスタブへ飛ぶ
+//   test reg, reg
+//   jz __aerojs_deopt_N
+bool X86_64CodeGenerator::EncodeDeoptimizeUnless(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept {
+    if (inst.num_operands() < 1 || !inst.operand(0).isVirtualReg() || !m_function) {
+        return false;
+    }
+    const IRFrameState* state = m_function->GetFrameState(inst.frameState);
+    if (!state) {
+        return false;
+    }
+    // フレーム状態を記録しないなら脱最適化できないので投機もできない
+    if (!m_backendOptions || !m_backendOptions->enableDeoptSupport || !m_backendOptions->frameStates) {
+        return false;
+    }
+    // 禁止された投機は型特化の段階で外れているはず。残っていれば再び脱最適化ループになるので生成しない
+    uint64_t siteFunction = state->functionId ? state->functionId : m_backendOptions->functionId;
+    if (!m_backendOptions->IsSpeculationAllowed(siteFunction, state->bytecodeOffset, state->speculation)) {
+        return false;
+    }
+    
+    int32_t conditionReg = inst.operand(0).getVirtualReg();
+    X86_64Register reg = X86_64Register::R11;
+    if (std::optional<X86_64Register> physReg = GetPhysicalReg(conditionReg)) {
+        reg = physReg.value();
+    } else if (!EncodeLoadFromSpillSlot(reg, conditionReg, code)) {
+        return false;
+    }
+    uint8_t regBits = static_cast<uint8_t>(reg);
+    AppendREXPrefix(code, true, regBits >= 8, false, regBits >= 8);
+    code.push_back(0x85); // TEST r/m64, r64
+    AppendModRM(code, 0x03, regBits & 0x7, regBits & 0x7);
+    
+    std::string label = "__aerojs_deopt_" + std::to_string(m_deoptStubs.size());
+    code.push_back(0x2E); // 分岐しない予測のヒント
+    code.push_back(0x0F); code.push_back(0x84); // JE rel32
+    m_pendingJumps.emplace_back(static_cast<uint32_t>(code.size()), 4, label, false);
+    AppendImmediate32(code, 0);
+    m_deoptStubs.push_back({std::move(label), inst.frameState});
+    return true;
+}
+
+// ガードのスタブ（トランポリンは全レジスタを退避するので、R11 以外の値はそのまま読める）
+//   mov r11, imm64   ; Deoptimizer::EagerTrampoline()
+//   call r11         ; 戻り先がガードのセーフポイント
+void X86_64CodeGenerator::EmitDeoptimizationStubs(std::vector<uint8_t>& code) noexcept {
+    if (m_deoptStubs.empty()) {
+        return;
+    }
+    const void* trampoline = Deoptimizer::Instance().EagerTrampoline();
+    if (!trampoline) {
+        m_safepointError = true;
+        return;
+    }
+    uint64_t trampolineAddress = reinterpret_cast<uint64_t>(trampoline);
+    
+    for (const PendingDeoptStub& stub : m_deoptStubs) {
+        DefineLabel(stub.label, code);
+        code.push_back(0x49); code.push_back(0xBB); // MOV R11, imm64
+        for (int i = 0; i < 8; ++i) {
+            code.push_back(static_cast<uint8_t>(trampolineAddress >> (i * 8)));
+        }
+        code.push_back(0x41); code.push_back(0xFF); code.push_back(0xD3); // CALL R11
+        if (!RecordSafepoint(static_cast<uint32_t>(code.size()), SafepointKind::Guard, stub.frameState)) {
+            m_safepointError = true;
+            return;
+        }
+    }
+}
+
+// 命令のフレーム状態（インライン化した呼び出し元をたどる）を置き場所へ解決して保留する
+bool X86_64CodeGenerator::RecordSafepoint(uint32_t pcOffset, SafepointKind kind, int32_t frameStateIndex) noexcept {
+    if (!m_backendOptions || !m_backendOptions->frameStates || !m_function) {
+        return true;
+    }
+    
+    std::vector<const IRFrameState*> chain;  // 最内から
+    for (const IRFrameState* state = m_function->GetFrameState(frameStateIndex); state;
+         state = m_function->GetFrameState(state->parent)) {
+        if (chain.size() >= m_function->GetFrameStateCount()) {
+            return false;  // parent が循環している
+        }
+        chain.push_back(state);
+    }
+    if (chain.empty()) {
+        return false;
+    }
+    
+    PendingSafepoint safepoint;
+    safepoint.pcOffset = pcOffset;
+    safepoint.kind = kind;
+    safepoint.speculation = kind == SafepointKind::Guard ? chain.front()->speculation : SpeculationKind::None;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        const IRFrameState& state = **it;
+        if (state.values.size() != static_cast<size_t>(state.localCount) + state.stackCount) {
+            return false;
+        }
+        PendingSafepoint::Frame frame;
+        frame.functionId = state.functionId ? state.functionId : m_backendOptions->functionId;
+        frame.bytecodeOffset = state.bytecodeOffset;
+        frame.localCount = state.localCount;
+        frame.stackCount = state.stackCount;
+        frame.values.reserve(state.values.size());
+        for (size_t i = 0; i < state.values.size(); ++i) {
+            ValueRepresentation rep = i < state.representations.size()
+                ? state.representations[i] : ValueRepresentation::Tagged;
+            ValueLocation location;
+            if (!ResolveValueLocation(state.values[i], rep, kind, location)) {
+                return false;
+            }
+            frame.values.push_back(location);
+        }
+        safepoint.frames.push_back(std::move(frame));
+    }
+    m_safepoints.push_back(std::move(safepoint));
+    return true;
+}
+
+bool X86_64CodeGenerator::ResolveValueLocation(int32_t virtualReg, ValueRepresentation rep, SafepointKind kind,
+                                               ValueLocation& location) const noexcept {
+    if (virtualReg < 0) {
+        location = ValueLocation::DeadValue();
+        return true;
+    }
+    
+    if (std::optional<X86_64Register> physReg = GetPhysicalReg(virtualReg)) {
+        X86_64Register reg = physReg.value();
+        // 呼び出しの戻り先では呼び出し先保存レジスタの値しか残っていない。ガードのスタブは R11 を壊す
+        bool calleeSaved = reg == X86_64Register::RBX || reg == X86_64Register::R12 ||
+                           reg == X86_64Register::R13 || reg == X86_64Register::R14 ||
+                           reg == X86_64Register::R15;
+        if ((kind == SafepointKind::Call && !calleeSaved) ||
+            (kind == SafepointKind::Guard && reg == X86_64Register::R11)) {
+            return false;
+        }
+        location = ValueLocation::InRegister(static_cast<int32_t>(reg), rep);
+        return true;
+    }
+    
+    auto simd = m_simdRegisterMapping.find(virtualReg);
+    if (simd != m_simdRegisterMapping.end()) {
+        // XMM はすべて呼び出し元保存
+        if (kind == SafepointKind::Call) {
+            return false;
+        }
+        location = ValueLocation::InRegister(
+            ValueLocation::kFirstXmmRegister + static_cast<int32_t>(simd->second), rep);
+        return true;
+    }
+    
+    if (std::optional<int32_t> offset = GetSpillSlotOffset(virtualReg)) {
+        location = ValueLocation::OnStack(offset.value(), rep);
+        return true;
+    }
+    return false;
+}
+
+void X86_64CodeGenerator::FlushSafepoints() noexcept {
+    FrameStateBuilder* builder = m_backendOptions ? m_backendOptions->frameStates : nullptr;
+    if (!builder) {
+        return;
+    }
+    for (const PendingSafepoint& safepoint : m_safepoints) {
+        builder->BeginSafepoint(safepoint.pcOffset, safepoint.kind, safepoint.speculation);
+        for (const PendingSafepoint::Frame& frame : safepoint.frames) {
+            builder->BeginFrame(frame.functionId, frame.bytecodeOffset, frame.localCount, frame.stackCount);
+            for (const ValueLocation& value : frame.values) {
+                builder->AddValue(value);
+            }
+        }
+    }
+    m_safepoints.clear();
 }
 
 void X86_64CodeGenerator::FinalizeFrame(std::vector<uint8_t>& code) noexcept {
@@ -3040,6 +3549,23 @@ void X86_64CodeGenerator::FinalizeFrame(std::vector<uint8_t>& code) noexcept {
         
         if (insertPos > 0) {
             code.insert(code.begin() + insertPos, stackAlloc.begin(), stackAlloc.end());
+            // 挿入より後ろのラベル・未解決ジャンプ・セーフポイントをずらす
+            uint32_t shift = static_cast<uint32_t>(stackAlloc.size());
+            for (auto& label : m_labels) {
+                if (label.second >= insertPos) {
+                    label.second += shift;
+                }
+            }
+            for (PendingJump& jump : m_pendingJumps) {
+                if (jump.sourceOffset >= insertPos) {
+                    jump.sourceOffset += shift;
+                }
+            }
+            for (PendingSafepoint& safepoint : m_safepoints) {
+                if (safepoint.pcOffset >= insertPos) {
+                    safepoint.pcOffset += shift;
+                }
+            }
         }
     }
 }
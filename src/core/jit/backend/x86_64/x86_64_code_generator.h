@@ -8,6 +8,7 @@
 #ifndef AEROJS_CORE_JIT_BACKEND_X86_64_CODE_GENERATOR_H
 #define AEROJS_CORE_JIT_BACKEND_X86_64_CODE_GENERATOR_H
 
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <unordered_map>
@@ -16,6 +17,7 @@
 #include "x86_64_registers.h"
 #include <optional>
 #include "../../ir/ir.h"
+#include "../backend_options.h"
 
 namespace aerojs {
 namespace core {
@@ -213,6 +215,13 @@ public:
   void EmitMOV_Reg_Mem(X86_64Register dest, X86_64Register base, int32_t disp = 0, uint8_t size = 8);
   void EmitMOV_Mem_Reg(X86_64Register base, int32_t disp, X86_64Register src, uint8_t size = 8);
   
+  // 命令エンコーディング - 圧縮参照（ケージベースは kCageBaseRegister に常駐）
+  void EmitLoadCageBase(std::vector<uint8_t>& code) noexcept;
+  void EmitLoadCompressedPointer(X86_64Register dest, X86_64Register base, int32_t disp,
+                                 std::vector<uint8_t>& code) noexcept;
+  void EmitStoreCompressedPointer(X86_64Register base, int32_t disp, X86_64Register src, X86_64Register scratch,
+                                  std::vector<uint8_t>& code) noexcept;
+  
   // 命令エンコーディング - 算術演算命令
   void EmitADD_Reg_Reg(X86_64Register dest, X86_64Register src, uint8_t size = 8);
   void EmitADD_Reg_Imm(X86_64Register dest, int32_t imm, uint8_t size = 8);
@@ -326,6 +335,27 @@ public:
   
   bool Generate(const IRFunction& function, std::vector<uint8_t>& outCode) noexcept;
   
+  /**
+   * @brief オプションを指定してマシンコードを生成
+   *
+   * options.frameStates があれば、呼び出しの戻り先（SafepointKind::Call）と
+   * kDeoptimizeUnless の失敗箇所（SafepointKind::Guard）ごとに、命令のフレーム状態を
+   * レジスタ・スタックスロットへ解決して記録する。ガードは本体の後ろに置いたスタブから
+   * 即時脱最適化のトランポリンを call し、その戻り先をセーフポイントにする。
+   * 生きている値の置き場所が解決できない場合と、禁止された投機のガードがある場合は失敗する。
+   */
+  bool Generate(const IRFunction& function, std::vector<uint8_t>& outCode, const BackendOptions& options) noexcept;
+  
+  /**
+   * @brief 実行打ち切りフラグを設定
+   *
+   * 設定すると、生成コードはプロローグ直後とループの後方分岐の手前でフラグを確認し、
+   * 0以外ならフレームを畳んで kJITTerminationSentinel を返す
+   * （呼び出し側は checkJITResult() で ExecutionTerminated に変換する）。
+   * @param flag TerminationState::flagAddress()（nullptrで確認しない）
+   */
+  void SetInterruptFlag(const std::atomic<uint8_t>* flag) noexcept { m_interruptFlag = flag; }
+  
   void SetRegisterMapping(int32_t virtualReg, X86_64Register physicalReg) noexcept;
   std::optional<X86_64Register> GetPhysicalReg(int32_t virtualReg) const noexcept;
   
@@ -514,6 +544,21 @@ private:
   void EncodeInc(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept;
   void EncodeDec(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept;
   void EncodeNop(std::vector<uint8_t>& code) noexcept;
+  void EmitInterruptPoll(std::vector<uint8_t>& code) noexcept;
+  void EmitTerminationExit(std::vector<uint8_t>& code) noexcept;
+  
+  // 脱最適化のセーフポイント
+  bool EncodeCheckNumber(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept;
+  
+  // 圧縮参照のフィールド（ポインタ圧縮が無効なら64ビットの参照）
+  bool EncodeLoadCompressed(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept;
+  bool EncodeStoreCompressed(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept;
+  bool EncodeDeoptimizeUnless(const IRInstruction& inst, std::vector<uint8_t>& code) noexcept;
+  void EmitDeoptimizationStubs(std::vector<uint8_t>& code) noexcept;
+  bool RecordSafepoint(uint32_t pcOffset, SafepointKind kind, int32_t frameStateIndex) noexcept;
+  bool ResolveValueLocation(int32_t virtualReg, ValueRepresentation rep, SafepointKind kind,
+                            ValueLocation& location) const noexcept;
+  void FlushSafepoints() noexcept;
   void OptimizeForCacheLine(std::vector<uint8_t>& code) noexcept;
   void AppendImmediate32(int32_t value) noexcept;
   void AppendImmediate64(int64_t value) noexcept;
@@ -536,6 +581,37 @@ private:
   uint32_t m_nextSpillOffset; // 次に割り当てるスピルスロットのRBPからの負のオフセット開始点
 
   Context* m_context; // プロファイラ等へのアクセス用
+  
+  // 実行打ち切りフラグ（nullptrならポーリングを生成しない）
+  const std::atomic<uint8_t>* m_interruptFlag;
+  
+  // 生成中の関数のオプションとIR（Generate の間だけ有効）
+  const BackendOptions* m_backendOptions = nullptr;
+  const IRFunction* m_function = nullptr;
+  
+  // 解決済みのセーフポイント（FinalizeFrame の挿入分をずらしてから FrameStateBuilder へ移す）
+  struct PendingSafepoint {
+    struct Frame {
+      uint64_t functionId;
+      uint32_t bytecodeOffset;
+      uint32_t localCount;
+      uint32_t stackCount;
+      std::vector<ValueLocation> values;
+    };
+    uint32_t pcOffset;
+    SafepointKind kind;
+    SpeculationKind speculation;
+    std::vector<Frame> frames;  // 外側から
+  };
+  std::vector<PendingSafepoint> m_safepoints;
+  
+  // 本体の後ろに置くガードのスタブ（ラベルとフレーム状態の番号）
+  struct PendingDeoptStub {
+    std::string label;
+    int32_t frameState;
+  };
+  std::vector<PendingDeoptStub> m_deoptStubs;
+  bool m_safepointError = false;
 };
 
 } // namespace jit
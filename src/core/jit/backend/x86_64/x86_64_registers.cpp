@@ -54,9 +54,6 @@ static const std::array<std::array<const char*, 2>, 16> XMM_REG_NAMES = {{
 
 X86_64RegisterAllocator::X86_64RegisterAllocator() noexcept {
   Reset();
-  
-  // システム予約レジスタ
-  ReserveGPRegister(X86_64Register::RSP); // スタックポインタは常に予約
 }
 
 void X86_64RegisterAllocator::Reset() noexcept {
@@ -67,6 +64,9 @@ void X86_64RegisterAllocator::Reset() noexcept {
   
   // システム予約レジスタ
   ReserveGPRegister(X86_64Register::RSP); // スタックポインタは常に予約
+#ifdef AEROJS_POINTER_COMPRESSION
+  ReserveGPRegister(kCageBaseRegister);   // ケージベースは関数全体で常駐
+#endif
 }
 
 X86_64Register X86_64RegisterAllocator::AllocateGPRegister(X86_64Register preferred) noexcept {
@@ -42,6 +42,9 @@ enum class X86_64Register : uint8_t {
   None = 0xFF
 };
 
+// ポインタ圧縮時にヒープケージのベースアドレスを常駐させるレジスタ（callee-saved）
+constexpr X86_64Register kCageBaseRegister = X86_64Register::R14;
+
 /**
  * @brief x86_64のXMMレジスタを表す列挙型 (浮動小数点演算用)
  */
@@ -12,6 +12,7 @@
 #include "../code_cache.h"
 #include "../../context.h"
 #include "../../function.h"
+#include "../../vm/bytecode/feedback_vector.h"
 
 #include <cstring>  // for std::memcpy
 #include <algorithm>
@@ -36,6 +37,9 @@ namespace core {
 // 静的メンバ変数の定義
 JITProfiler BaselineJIT::m_profiler;
 
+// 型チェックICを別の型で作り直す回数の上限（超えたら汎用パス）
+static constexpr uint32_t TYPE_CHECK_RESPECIALIZE_LIMIT = 4;
+
 // BytecodeEmitterの完全な実装
 class BytecodeEmitter {
 public:
@@ -776,6 +780,19 @@ private:
         );
     }
     
+    // ミスしたシェイプを関数のフィードバックベクタに記録する
+    // 多型の上限を超えたサイトは false を返し、以降は汎用パスを使う
+    static bool recordShapeFeedback(InlineCachePoint* ic, JSShape* shape, PropertyOffset offset) {
+        FeedbackVector* feedback = ic->feedbackVector;
+        if (!feedback) {
+            return false;
+        }
+        feedback->recordProperty(ic->feedbackSlot, shape->id(),
+                                 encodePropertyHandler(PropertyHandlerKind::kInlineField,
+                                                       static_cast<uint32_t>(offset)));
+        return feedback->state(ic->feedbackSlot) != FeedbackState::kMegamorphic;
+    }
+    
     // インラインキャッシュミスハンドラ
     static void* handlePropertyCacheMiss(InlineCachePoint* ic) {
         if (!ic) return nullptr;
@@ -800,25 +817,17 @@ private:
         
         // プロパティオフセット検索
         PropertyOffset offset = shape->lookupProperty(propertyName);
-        if (offset != PropertyOffset::notFound) {
-            // キャッシュエントリ作成
-            ICEntry* entry = ic->allocateEntry();
-            if (entry) {
-                entry->setShape(shape);
-                entry->setOffset(offset);
-                
-                // このシェイプ用の専用パスを生成
-                void* handlerCode = ic->generateSpecializedHandler(shape, offset);
-                entry->setHandler(handlerCode);
-                
-                // プロファイラーに記録
-                if (ic->profiler) {
-                    ic->profiler->recordICHit(siteId, ICHitType::PropertyAccess, true);
-                }
-                
-                // 生成したハンドラーを返す
-                return handlerCode;
+        if (offset != PropertyOffset::notFound && recordShapeFeedback(ic, shape, offset)) {
+            // このシェイプ用の専用パスを生成
+            void* handlerCode = ic->generateSpecializedHandler(shape, offset);
+            
+            // プロファイラーに記録
+            if (ic->profiler) {
+                ic->profiler->recordICHit(siteId, ICHitType::PropertyAccess, true);
             }
+            
+            // 生成したハンドラーを返す
+            return handlerCode;
         }
         
         // 専用パスを生成できなかった場合はプロトタイプチェーンを探索する汎用パスを使用
@@ -854,24 +863,16 @@ private:
         if (offset != PropertyOffset::notFound) {
             // プロパティ値がメソッドかを確認
             JSValue method = obj->getProperty(offset);
-            if (method.isCallable()) {
-                // キャッシュエントリ作成
-                ICEntry* entry = ic->allocateEntry();
-                if (entry) {
-                    entry->setShape(shape);
-                    entry->setOffset(offset);
-                    
-                    // このシェイプとメソッド用の専用パスを生成
-                    void* handlerCode = ic->generateMethodHandler(shape, offset);
-                    entry->setHandler(handlerCode);
-                    
-                    // プロファイラーに記録
-                    if (ic->profiler) {
-                        ic->profiler->recordICHit(siteId, ICHitType::MethodCall, true);
-                    }
-                    
-                    return handlerCode;
+            if (method.isCallable() && recordShapeFeedback(ic, shape, offset)) {
+                // このシェイプとメソッド用の専用パスを生成
+                void* handlerCode = ic->generateMethodHandler(shape, offset);
+                
+                // プロファイラーに記録
+                if (ic->profiler) {
+                    ic->profiler->recordICHit(siteId, ICHitType::MethodCall, true);
                 }
+                
+                return handlerCode;
             }
         }
         
@@ -894,14 +895,13 @@ private:
         // 型情報の取得
         JSType actualType = value.type();
         
-        // 型に対応する特殊化されたチェックコードを生成
-        ICEntry* entry = ic->allocateEntry();
-        if (entry) {
-            entry->setType(actualType);
+        // 型に対応する特殊化されたチェックコードを生成（直前の型はサイト内に持つ）
+        if (ic->data.typeCheck.checkCount < TYPE_CHECK_RESPECIALIZE_LIMIT) {
+            ic->data.typeCheck.lastType = actualType;
+            ic->data.typeCheck.checkCount++;
             
             // この型用の専用パスを生成
             void* handlerCode = ic->generateTypeCheckHandler(actualType, expectedType);
-            entry->setHandler(handlerCode);
             
             // プロファイラーに記録
             if (ic->profiler) {
@@ -1039,6 +1039,30 @@ bool BaselineJIT::hasCompiledCode(uint64_t functionId) const {
     return _codeMap.find(functionId) != _codeMap.end();
 }
 
+bool BaselineJIT::compileOSREntry(Function* function, const OSRFrameState& state,
+                                  void*& loopHeader, OSREntryLayout& layout) {
+    // ベースラインコードは関数の入口からでもループヘッダからでも同じ本体を使う
+    if (!compile(function)) {
+        return false;
+    }
+    NativeCode* code = _codeMap[function->id()];
+    
+    // ループヘッダはバックエッジの飛び先なので、コード生成時に必ずラベルが置かれている
+    loopHeader = code->addressForBytecodeOffset(state.loopHeaderOffset);
+    if (!loopHeader) {
+        setError("OSR entry: no native code for the loop header");
+        return false;
+    }
+    
+    // ベースラインのフレームはすべてタグ付きの値で、ローカル変数・スタックの順に並ぶ
+    layout = OSREntryLayout::baseline(state.loopHeaderOffset, state.locals.size(), state.stack.size());
+    if (layout.frameSize != code->frameSize()) {
+        setError("OSR entry: frame size mismatch");
+        return false;
+    }
+    return true;
+}
+
 bool BaselineJIT::generateBytecodeLowering(Function* function, std::vector<uint8_t>& outputBuffer) {
     return _emitter->lower(function, outputBuffer);
 }
@@ -1056,6 +1080,9 @@ void BaselineJIT::setupInlineCaches(NativeCode* code, Function* function) {
     // プロファイラーの取得
     Profiler* profiler = _context->getProfiler();
     
+    // インタプリタと共有するフィードバックベクタ
+    FeedbackVector* feedback = function->feedbackVector();
+    
     // すべてのICポイントを設定
     for (size_t i = 0; i < code->icPoints.size(); i++) {
         InlineCachePoint& ic = code->icPoints[i];
@@ -1093,13 +1120,16 @@ void BaselineJIT::setupInlineCaches(NativeCode* code, Function* function) {
                 break;
         }
         
-        // ICの初期化
-        ic.entryCount = 0;
-        
-        // ICエントリを確保
-        ic.entries = new ICEntry[POLY_IC_CAPACITY];
-        for (int j = 0; j < POLY_IC_CAPACITY; j++) {
-            ic.entries[j].clear();
+        // サイトごとのICエントリは確保せず、関数のフィードバックベクタのスロットを使う
+        // （インタプリタが集めたシェイプを引き継ぎ、最適化JITもそのまま読む）
+        ic.feedbackVector = nullptr;
+        ic.feedbackSlot = 0;
+        if (feedback) {
+            int32_t slot = feedback->slotForOffset(ic.bytecodeOffset);
+            if (slot >= 0) {
+                ic.feedbackVector = feedback;
+                ic.feedbackSlot = static_cast<uint32_t>(slot);
+            }
         }
     }
 }
@@ -39,6 +39,8 @@ public:
     bool compile(Function* function) override;
     void* getCompiledCode(uint64_t functionId) override;
     bool hasCompiledCode(uint64_t functionId) const override;
+    bool compileOSREntry(Function* function, const OSRFrameState& state,
+                         void*& loopHeader, OSREntryLayout& layout) override;
     
     // 統計情報
     struct Stats {
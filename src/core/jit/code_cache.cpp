@@ -6,6 +6,8 @@
  */
 
 #include "code_cache.h"
+#include "code_space.h"
+#include "deoptimizer/deoptimizer.h"
 #include "../context.h"
 #include <algorithm>
 #include <chrono>
@@ -28,14 +30,20 @@ NativeCode::NativeCode(void* code, size_t codeSize, void* entryPoint)
 NativeCode::~NativeCode() {
     // アロケートされたコードメモリを解放
     if (_code) {
-        // 実行可能メモリを解放するため、munmapを使用
-        munmap(_code, _codeSize);
+        // 最適化コードならまだ戻ってくるフレームを遅延脱最適化に回す
+        core::Deoptimizer::Instance().InvalidateCode(_code);
+        // 二重マッピングのコード領域はそちらへ返し、それ以外は munmap する
+        if (!CodeSpace::shared().free(_code)) {
+            munmap(_code, _codeSize);
+        }
         _code = nullptr;
     }
 }
 
 void NativeCode::setProtection(MemoryProtection protection) {
     if (!_code) return;
+    // 二重マッピングのコード領域は保護を変えない（書き込みは別名から行う）
+    if (CodeSpace::shared().contains(_code)) return;
     
     int prot = 0;
     switch (protection) {
@@ -72,11 +80,19 @@ void NativeCode::patchCode(uint32_t patchId, const void* newCode, size_t newCode
                 return; // 範囲外へのパッチは適用しない
             }
             
+            uint8_t* target = static_cast<uint8_t*>(_code) + point.offset;
+            
+            // 二重マッピングのコード領域なら書き込み用の別名へ書き、mprotect を避ける
+            if (void* writable = CodeSpace::shared().writableAddress(target)) {
+                std::memcpy(writable, newCode, newCodeSize);
+                CodeSpace::flushRange(target, newCodeSize);
+                return;
+            }
+            
             // 現在のメモリ保護設定を記憶し、書き込み可能に設定
             setProtection(MemoryProtection::ReadWrite);
             
             // パッチを適用
-            uint8_t* target = static_cast<uint8_t*>(_code) + point.offset;
             std::memcpy(target, newCode, newCodeSize);
             
             // 実行可能に戻す
@@ -283,4 +299,57 @@ void CodeCache::evictIfNeeded() {
     }
 }
 
-} // namespace aerojs 
\ No newline at end of file
+//-----------------------------------------------------------------------------
+// CodeEntry の実行統計とリロケーション
+//-----------------------------------------------------------------------------
+
+namespace core {
+
+void CodeEntry::recordExecution(uint64_t cycles, uint64_t timeNs) {
+    _stats.recordExecution(cycles, timeNs);
+}
+
+void CodeEntry::addRelocation(uint32_t offset, uint32_t targetId, int32_t addend, bool isAbsolute) {
+    _relocations.emplace_back(offset, targetId, addend, isAbsolute);
+}
+
+bool CodeEntry::applyRelocations(const std::unordered_map<uint32_t, void*>& targetMap) {
+    // 絶対: 8バイトに S + A を書く
+    // 相対: 4バイトに S + A - P を書く（P は書き込む位置。x86-64 の rel32 なら A = -4）
+    // 途中まで書き換えた状態を残さないよう、先にすべてのターゲットと範囲を確かめる
+    uint8_t* code = static_cast<uint8_t*>(_code);
+    for (const RelocationInfo& relocation : _relocations) {
+        auto it = targetMap.find(relocation.targetId);
+        if (it == targetMap.end()) {
+            return false;
+        }
+        size_t width = relocation.isAbsolute ? 8 : 4;
+        if (relocation.offset > _size || width > _size - relocation.offset) {
+            return false;
+        }
+        if (!relocation.isAbsolute) {
+            int64_t value = reinterpret_cast<intptr_t>(it->second) + relocation.addend -
+                            reinterpret_cast<intptr_t>(code + relocation.offset);
+            if (value < INT32_MIN || value > INT32_MAX) {
+                return false;
+            }
+        }
+    }
+
+    for (const RelocationInfo& relocation : _relocations) {
+        uint8_t* site = code + relocation.offset;
+        intptr_t target = reinterpret_cast<intptr_t>(targetMap.find(relocation.targetId)->second);
+        if (relocation.isAbsolute) {
+            uint64_t value = static_cast<uint64_t>(target + relocation.addend);
+            std::memcpy(site, &value, sizeof(value));
+        } else {
+            int32_t value = static_cast<int32_t>(target + relocation.addend - reinterpret_cast<intptr_t>(site));
+            std::memcpy(site, &value, sizeof(value));
+        }
+    }
+    return true;
+}
+
+} // namespace core
+
+} // namespace aerojs
@@ -50,7 +50,7 @@ enum class CodeFlags : uint32_t {
     NeedsFlush         = 1 << 0,   // フラッシュ必要
     IsHot              = 1 << 1,   // ホットコード
     SelfModifying      = 1 << 2,   // 自己修正コード
-    UsesLargePages     = 1 << 3,   // 大きなページ使用
+    UsesLargePages     = 1 << 3,   // 大きなページ使用（MemoryManager::isLargePageBacked）
     IsOSRCode          = 1 << 4,   // OSRコード
     IsShared           = 1 << 5,   // 共有コード
     IsInline           = 1 << 6,   // インラインコード
@@ -255,6 +255,22 @@ public:
     void recordExecution(uint64_t cycles, uint64_t timeNs);
     const ExecutionStats& getExecutionStats() const { return _stats; }
     
+    // コードエイジング（掃引のたびに進め、前回の掃引から実行されていれば0に戻す）
+    uint32_t getAge() const { return _age; }
+    uint32_t advanceAge() {
+        if (_stats.executionCount != _agedExecutionCount) {
+            _agedExecutionCount = _stats.executionCount;
+            _age = 0;
+        } else if (_age != UINT32_MAX) {
+            _age++;
+        }
+        return _age;
+    }
+    void resetAge() {
+        _agedExecutionCount = _stats.executionCount;
+        _age = 0;
+    }
+    
     // 最適化情報
     OptimizationInfo& getOptimizationInfo() { return _optimizationInfo; }
     const OptimizationInfo& getOptimizationInfo() const { return _optimizationInfo; }
@@ -294,6 +310,9 @@ private:
     ExecutionStats _stats;         // 実行統計
     OptimizationInfo _optimizationInfo;  // 最適化情報
     
+    uint32_t _age = 0;                   // 実行されなかった掃引の回数
+    uint64_t _agedExecutionCount = 0;    // 前回の掃引時の実行回数
+    
     // メモリ保護変更
     bool changeProtection(CodePermissions newPerms);
     
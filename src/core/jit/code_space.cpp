@@ -0,0 +1,475 @@
+/**
+ * @file code_space.cpp
+ * @brief 二重マッピングで W^X を守る実行可能メモリのアロケータの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "code_space.h"
+#include "memory_manager.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__aarch64__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#endif
+
+namespace aerojs {
+namespace core {
+
+namespace {
+
+#if defined(__linux__) && defined(__aarch64__)
+// 他のスレッドが古い命令をパイプラインに持っていないことを保証するための登録
+std::atomic<bool> g_syncCoreRegistered{false};
+#endif
+
+// このスレッドで一番外側の FlushScope
+thread_local CodeSpace::FlushScope* g_flushScope = nullptr;
+
+}  // namespace
+
+std::atomic<uint64_t> CodeSpace::s_flushBatches{0};
+std::atomic<uint64_t> CodeSpace::s_flushedRanges{0};
+
+void CodeSpace::FlushBatch::add(const void* executable, size_t size) {
+    if (!executable || size == 0) {
+        return;
+    }
+    uintptr_t begin = reinterpret_cast<uintptr_t>(executable);
+    m_ranges.emplace_back(begin, begin + size);
+}
+
+void CodeSpace::FlushBatch::flush() {
+    if (m_ranges.empty()) {
+        return;
+    }
+
+    // 同じキャッシュラインに掛かる範囲は1つにまとめる
+    constexpr uintptr_t kCacheLine = 64;
+    std::sort(m_ranges.begin(), m_ranges.end());
+    size_t merged = 0;
+    for (size_t i = 1; i < m_ranges.size(); ++i) {
+        if (m_ranges[i].first <= m_ranges[merged].second + kCacheLine) {
+            m_ranges[merged].second = std::max(m_ranges[merged].second, m_ranges[i].second);
+        } else {
+            m_ranges[++merged] = m_ranges[i];
+        }
+    }
+    m_ranges.resize(merged + 1);
+
+    for (const auto& [begin, end] : m_ranges) {
+        #ifdef _WIN32
+        FlushInstructionCache(GetCurrentProcess(), reinterpret_cast<void*>(begin), end - begin);
+        #else
+        __builtin___clear_cache(reinterpret_cast<char*>(begin), reinterpret_cast<char*>(end));
+        #endif
+    }
+
+    #if defined(__linux__) && defined(__aarch64__)
+    if (g_syncCoreRegistered.load(std::memory_order_relaxed)) {
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED_SYNC_CORE, 0);
+    }
+    #endif
+
+    s_flushBatches.fetch_add(1, std::memory_order_relaxed);
+    s_flushedRanges.fetch_add(m_ranges.size(), std::memory_order_relaxed);
+    m_ranges.clear();
+}
+
+CodeSpace::FlushScope::FlushScope() : m_outermost(g_flushScope == nullptr) {
+    if (m_outermost) {
+        g_flushScope = this;
+    }
+}
+
+CodeSpace::FlushScope::~FlushScope() {
+    if (!m_outermost) {
+        return;
+    }
+    g_flushScope = nullptr;
+    if (!m_ranges.empty()) {
+        MemoryManager::flushInstructionCache(m_ranges);
+    }
+}
+
+void CodeSpace::flushRange(const void* executable, size_t size) {
+    if (!executable || size == 0) {
+        return;
+    }
+    if (g_flushScope) {
+        g_flushScope->m_ranges.emplace_back(const_cast<void*>(executable), size);
+        return;
+    }
+    FlushBatch batch;
+    batch.add(executable, size);
+}
+
+CodeSpace& CodeSpace::shared() {
+    // 生成コードがアドレスを持ち続けるため破棄しない
+    static CodeSpace* space = new CodeSpace();
+    return *space;
+}
+
+CodeSpace::CodeSpace() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_available = addRegion(kDefaultRegionSize);
+
+    #if defined(__linux__) && defined(__aarch64__)
+    if (m_available &&
+        syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_SYNC_CORE, 0) == 0) {
+        g_syncCoreRegistered.store(true, std::memory_order_relaxed);
+    }
+    #endif
+
+    #if defined(__linux__)
+    // 構築は shared() からの1回だけなので、登録も1回になる
+    if (m_available) {
+        pthread_atfork(&CodeSpace::prepareFork, &CodeSpace::parentAfterFork, &CodeSpace::childAfterFork);
+    }
+    #endif
+}
+
+void CodeSpace::prepareFork() {
+    // ブロックの状態が書きかけのまま子に写らないよう、fork の間は割り当てを止める
+    shared().m_mutex.lock();
+}
+
+void CodeSpace::parentAfterFork() {
+    shared().m_mutex.unlock();
+}
+
+void CodeSpace::childAfterFork() {
+    CodeSpace& space = shared();
+    size_t count = space.m_regionCount.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        if (!space.remapRegion(i)) {
+            // 親と共有したままなので、子では新しいコードを置かない（既存のコードは実行できる）
+            std::fprintf(stderr, "aerojs: failed to detach the JIT code space after fork\n");
+            space.m_available = false;
+            break;
+        }
+    }
+    space.m_mutex.unlock();
+}
+
+bool CodeSpace::remapRegion(size_t index) {
+    #if defined(__linux__)
+    Region& region = m_regions[index];
+    int fd = memfd_create("aerojs-code", MFD_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(region.size)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    // 使用中のブロックだけを写す（空きブロックは穴のままにして物理メモリを使わない）
+    const std::vector<Block>& blocks = m_blocks[index];
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (blocks[b].kind == BlockKind::Free) {
+            continue;
+        }
+        size_t offset = b * kBlockSize;
+        if (pwrite(fd, region.rw + offset, kBlockSize, static_cast<off_t>(offset)) !=
+            static_cast<ssize_t>(kBlockSize)) {
+            close(fd);
+            return false;
+        }
+    }
+
+    // 同じアドレスへ置き換えるので、生成コード中のアドレスはそのまま使える
+    if (mmap(region.rw, region.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    if (mmap(region.rx, region.size, PROT_READ | PROT_EXEC, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        // 書き込み用の別名を元に戻し、実行用と同じページを指すようにする
+        mmap(region.rw, region.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, region.fd, 0);
+        close(fd);
+        return false;
+    }
+    close(region.fd);
+    region.fd = fd;
+    return true;
+    #else
+    (void)index;
+    return true;
+    #endif
+}
+
+size_t CodeSpace::sizeClassFor(size_t size) {
+    if (size <= kMinChunkSize) {
+        return 0;
+    }
+    return static_cast<size_t>(std::bit_width(size - 1)) - std::bit_width(kMinChunkSize - 1);
+}
+
+const CodeSpace::Region* CodeSpace::findRegion(const void* executable) const {
+    const uint8_t* address = static_cast<const uint8_t*>(executable);
+    size_t count = m_regionCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const Region& region = m_regions[i];
+        if (address >= region.rx && address < region.rx + region.size) {
+            return &region;
+        }
+    }
+    return nullptr;
+}
+
+void* CodeSpace::writableAddress(const void* executable) const {
+    const Region* region = findRegion(executable);
+    if (!region) {
+        return nullptr;
+    }
+    return region->rw + (static_cast<const uint8_t*>(executable) - region->rx);
+}
+
+bool CodeSpace::addRegion(size_t size) {
+    #if defined(__linux__)
+    size_t count = m_regionCount.load(std::memory_order_relaxed);
+    if (count >= kMaxRegions) {
+        return false;
+    }
+
+    int fd = memfd_create("aerojs-code", MFD_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // ftruncate は予約だけで、物理ページは書き込んだときに割り当てられる
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        return false;
+    }
+    void* rw = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (rw == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    void* rx = mmap(nullptr, size, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+    if (rx == MAP_FAILED) {
+        munmap(rw, size);
+        close(fd);
+        return false;
+    }
+
+    Region& region = m_regions[count];
+    region.rx = static_cast<uint8_t*>(rx);
+    region.rw = static_cast<uint8_t*>(rw);
+    region.size = size;
+    region.fd = fd;
+    m_blocks.emplace_back(size / kBlockSize);
+    m_regionCount.store(count + 1, std::memory_order_release);
+    return true;
+    #else
+    (void)size;
+    return false;
+    #endif
+}
+
+bool CodeSpace::findFreeRun(size_t blockCount, BlockRef& ref) {
+    for (size_t r = 0; r < m_blocks.size(); ++r) {
+        const std::vector<Block>& blocks = m_blocks[r];
+        size_t run = 0;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            run = blocks[b].kind == BlockKind::Free ? run + 1 : 0;
+            if (run == blockCount) {
+                ref = BlockRef{static_cast<uint32_t>(r), static_cast<uint32_t>(b + 1 - blockCount)};
+                return true;
+            }
+        }
+    }
+
+    size_t regionSize = std::max(kDefaultRegionSize, blockCount * kBlockSize);
+    if (!addRegion(regionSize)) {
+        return false;
+    }
+    ref = BlockRef{static_cast<uint32_t>(m_blocks.size() - 1), 0};
+    return true;
+}
+
+void CodeSpace::releaseBlocks(uint32_t region, uint32_t firstBlock, uint32_t blockCount) {
+    std::vector<Block>& blocks = m_blocks[region];
+    for (uint32_t b = firstBlock; b < firstBlock + blockCount; ++b) {
+        blocks[b].kind = BlockKind::Free;
+        blocks[b].liveChunks = 0;
+        blocks[b].runLength = 0;
+        std::vector<uint16_t>().swap(blocks[b].freeSlots);
+    }
+    m_usedBlocks -= blockCount;
+
+    // 両方のビューから物理ページを外す（失敗しても中身が残るだけ）
+    #if defined(__linux__)
+    fallocate(m_regions[region].fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+              static_cast<off_t>(firstBlock) * kBlockSize, static_cast<off_t>(blockCount) * kBlockSize);
+    #endif
+}
+
+void* CodeSpace::allocateSmall(size_t sizeClass) {
+    std::vector<BlockRef>& partial = m_partial[sizeClass];
+    if (partial.empty()) {
+        BlockRef ref;
+        if (!findFreeRun(1, ref)) {
+            return nullptr;
+        }
+        Block& block = m_blocks[ref.region][ref.block];
+        block.kind = BlockKind::Small;
+        block.sizeClass = static_cast<uint8_t>(sizeClass);
+        block.liveChunks = 0;
+        // 末尾から取り出すので、ブロックの先頭から順に使われる
+        size_t chunkCount = kBlockSize / chunkSize(sizeClass);
+        block.freeSlots.resize(chunkCount);
+        for (size_t i = 0; i < chunkCount; ++i) {
+            block.freeSlots[i] = static_cast<uint16_t>(chunkCount - 1 - i);
+        }
+        m_usedBlocks++;
+        partial.push_back(ref);
+    }
+
+    BlockRef ref = partial.back();
+    Block& block = m_blocks[ref.region][ref.block];
+    uint16_t slot = block.freeSlots.back();
+    block.freeSlots.pop_back();
+    block.liveChunks++;
+    if (block.freeSlots.empty()) {
+        partial.pop_back();
+    }
+
+    m_allocatedBytes += chunkSize(sizeClass);
+    m_liveAllocations++;
+    return m_regions[ref.region].rx + size_t(ref.block) * kBlockSize + size_t(slot) * chunkSize(sizeClass);
+}
+
+void* CodeSpace::allocateLarge(size_t size) {
+    size_t blockCount = (size + kBlockSize - 1) / kBlockSize;
+    BlockRef ref;
+    if (!findFreeRun(blockCount, ref)) {
+        return nullptr;
+    }
+    std::vector<Block>& blocks = m_blocks[ref.region];
+    blocks[ref.block].kind = BlockKind::LargeHead;
+    blocks[ref.block].runLength = static_cast<uint32_t>(blockCount);
+    for (size_t b = 1; b < blockCount; ++b) {
+        blocks[ref.block + b].kind = BlockKind::LargeTail;
+    }
+    m_usedBlocks += blockCount;
+    m_allocatedBytes += blockCount * kBlockSize;
+    m_liveAllocations++;
+    return m_regions[ref.region].rx + size_t(ref.block) * kBlockSize;
+}
+
+void* CodeSpace::allocate(size_t size) {
+    if (!m_available || size == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (size <= kMaxSmallSize) {
+        return allocateSmall(sizeClassFor(size));
+    }
+    return allocateLarge(size);
+}
+
+bool CodeSpace::free(void* executable) {
+    const Region* region = findRegion(executable);
+    if (!region) {
+        return false;
+    }
+    uint32_t regionIndex = static_cast<uint32_t>(regionIndexOf(region));
+    size_t offset = static_cast<uint8_t*>(executable) - region->rx;
+    uint32_t blockIndex = static_cast<uint32_t>(offset / kBlockSize);
+    size_t offsetInBlock = offset % kBlockSize;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Block& block = m_blocks[regionIndex][blockIndex];
+    switch (block.kind) {
+        case BlockKind::Small: {
+            size_t size = chunkSize(block.sizeClass);
+            if (offsetInBlock % size != 0) {
+                return false;
+            }
+            bool wasFull = block.freeSlots.empty();
+            block.freeSlots.push_back(static_cast<uint16_t>(offsetInBlock / size));
+            block.liveChunks--;
+            m_allocatedBytes -= size;
+            m_liveAllocations--;
+
+            std::vector<BlockRef>& partial = m_partial[block.sizeClass];
+            if (block.liveChunks == 0) {
+                auto it = std::find_if(partial.begin(), partial.end(), [&](const BlockRef& ref) {
+                    return ref.region == regionIndex && ref.block == blockIndex;
+                });
+                if (it != partial.end()) {
+                    *it = partial.back();
+                    partial.pop_back();
+                }
+                releaseBlocks(regionIndex, blockIndex, 1);
+            } else if (wasFull) {
+                partial.push_back(BlockRef{regionIndex, blockIndex});
+            }
+            return true;
+        }
+        case BlockKind::LargeHead: {
+            if (offsetInBlock != 0) {
+                return false;
+            }
+            uint32_t blockCount = block.runLength;
+            m_allocatedBytes -= size_t(blockCount) * kBlockSize;
+            m_liveAllocations--;
+            releaseBlocks(regionIndex, blockIndex, blockCount);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+size_t CodeSpace::allocationSize(const void* executable) const {
+    const Region* region = findRegion(executable);
+    if (!region) {
+        return 0;
+    }
+    size_t offset = static_cast<const uint8_t*>(executable) - region->rx;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Block& block = m_blocks[regionIndexOf(region)][offset / kBlockSize];
+    switch (block.kind) {
+        case BlockKind::Small:
+            return chunkSize(block.sizeClass);
+        case BlockKind::LargeHead:
+            return size_t(block.runLength) * kBlockSize;
+        default:
+            return 0;
+    }
+}
+
+CodeSpace::Stats CodeSpace::getStats() const {
+    Stats stats;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = m_regionCount.load(std::memory_order_acquire);
+    stats.regions = count;
+    for (size_t i = 0; i < count; ++i) {
+        stats.reservedBytes += m_regions[i].size;
+    }
+    stats.usedBlocks = m_usedBlocks;
+    stats.allocatedBytes = m_allocatedBytes;
+    stats.liveAllocations = m_liveAllocations;
+    stats.flushBatches = s_flushBatches.load(std::memory_order_relaxed);
+    stats.flushedRanges = s_flushedRanges.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace core
+}  // namespace aerojs
@@ -0,0 +1,212 @@
+/**
+ * @file code_space.h
+ * @brief 二重マッピングで W^X を守る実行可能メモリのアロケータ
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief 二重マッピングによる W^X のコード領域
+ *
+ * 大きな領域（既定64MB）を memfd で予約し、同じページを読み書き用（RW）と
+ * 実行用（RX）の2つのアドレスにマップする。コードは RX 側のアドレスで識別し、
+ * 書き込み（コードの導入、ICのパッチ）は writableAddress() で得た RW 側から行う。
+ * どちらの保護も変えないので、書き込みのたびの mprotect が要らない。
+ *
+ * 領域は64KBのブロックに分け、32KB以下の要求はサイズクラス（64B〜32KB の2のべき）の
+ * チャンクをブロックから切り出し、それより大きい要求は連続したブロックを割り当てる。
+ * 空いたブロックは fallocate(PUNCH_HOLE) で物理メモリを返す。予約した領域は解放しない。
+ *
+ * memfd が使えない環境（Linux 以外、seccomp などで拒否された場合）では
+ * isAvailable() が false になり、呼び出し側は従来の確保方法を使う。
+ *
+ * MAP_SHARED のマッピングは fork で子に共有されたまま引き継がれ、子の書き込みが
+ * 親のコードを書き換えてしまう。子では使用中のブロックを新しい memfd へ写し、
+ * 同じアドレスにマップし直す（pthread_atfork で登録する）。
+ */
+class CodeSpace {
+public:
+    static constexpr size_t kBlockSize = 64 * 1024;
+    static constexpr size_t kMinChunkSize = 64;
+    static constexpr size_t kSizeClassCount = 10;             // 64B〜32KB
+    static constexpr size_t kMaxSmallSize = kMinChunkSize << (kSizeClassCount - 1);
+    static constexpr size_t kDefaultRegionSize = size_t(64) << 20;
+    static constexpr size_t kMaxRegions = 64;
+
+    struct Stats {
+        size_t regions = 0;
+        size_t reservedBytes = 0;
+        size_t usedBlocks = 0;        // チャンク用・大きな割り当て用に使っているブロック
+        size_t allocatedBytes = 0;    // 切り出したチャンク・ブロックの合計
+        uint64_t liveAllocations = 0;
+        uint64_t flushBatches = 0;
+        uint64_t flushedRanges = 0;   // まとめた後にフラッシュした範囲の数
+    };
+
+    /**
+     * @brief 命令キャッシュのフラッシュをまとめて行う
+     *
+     * 書き換えた範囲を add() で溜め、flush()（またはデストラクタ）で隣接・重複する範囲を
+     * まとめてから1回ずつフラッシュする。複数スレッドで実行中のコードを書き換える
+     * アーキテクチャでは、コアの同期もまとめて1回で済ませる。
+     */
+    class FlushBatch {
+    public:
+        FlushBatch() = default;
+        ~FlushBatch() { flush(); }
+
+        FlushBatch(const FlushBatch&) = delete;
+        FlushBatch& operator=(const FlushBatch&) = delete;
+
+        void add(const void* executable, size_t size);
+        void flush();
+        bool empty() const { return m_ranges.empty(); }
+
+    private:
+        std::vector<std::pair<uintptr_t, uintptr_t>> m_ranges;
+    };
+
+    /**
+     * @brief スコープ内の命令キャッシュのフラッシュを1回にまとめる
+     *
+     * コードの導入と、そのコードを指すICのパッチのように続けて書き換える処理を囲む。
+     * 有効な間、このスレッドの flushRange() は範囲を溜めるだけになり、一番外側の
+     * スコープを抜けるときに MemoryManager::flushInstructionCache() でまとめてフラッシュする。
+     */
+    class FlushScope {
+    public:
+        FlushScope();
+        ~FlushScope();
+
+        FlushScope(const FlushScope&) = delete;
+        FlushScope& operator=(const FlushScope&) = delete;
+
+    private:
+        friend class CodeSpace;
+
+        bool m_outermost;
+        std::vector<std::pair<void*, size_t>> m_ranges;
+    };
+
+    /**
+     * @brief 書き換えた範囲の命令キャッシュをフラッシュする
+     *
+     * このスレッドで FlushScope が有効ならその終わりまで溜め、なければすぐにフラッシュする。
+     */
+    static void flushRange(const void* executable, size_t size);
+
+    /**
+     * @brief プロセス全体で共有するコード領域（生成コードが相互に rel32 で届くよう1つにまとめる）
+     */
+    static CodeSpace& shared();
+
+    bool isAvailable() const { return m_available; }
+
+    /**
+     * @brief コード領域を確保する
+     * @return 実行用（RX）のアドレス。失敗したら nullptr
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief allocate() で得たアドレスを解放する
+     */
+    bool free(void* executable);
+
+    /**
+     * @brief このコード領域のアドレスか（ロックを取らない）
+     */
+    bool contains(const void* executable) const { return findRegion(executable) != nullptr; }
+
+    /**
+     * @brief 実行用アドレスに対応する書き込み用アドレス（ロックを取らない）
+     * @return このコード領域のアドレスでなければ nullptr
+     */
+    void* writableAddress(const void* executable) const;
+
+    /**
+     * @brief 割り当てられたチャンク・ブロックの大きさ
+     */
+    size_t allocationSize(const void* executable) const;
+
+    Stats getStats() const;
+
+    CodeSpace(const CodeSpace&) = delete;
+    CodeSpace& operator=(const CodeSpace&) = delete;
+
+private:
+    CodeSpace();
+    ~CodeSpace() = default;
+
+    enum class BlockKind : uint8_t { Free, Small, LargeHead, LargeTail };
+
+    struct Block {
+        BlockKind kind = BlockKind::Free;
+        uint8_t sizeClass = 0;
+        uint16_t liveChunks = 0;
+        uint32_t runLength = 0;              // LargeHead のとき連続するブロック数
+        std::vector<uint16_t> freeSlots;     // Small のとき空いているチャンク番号
+    };
+
+    // 読み手はロックなしで rw/rx/size を見るため、公開後は変更しない
+    struct Region {
+        uint8_t* rx = nullptr;
+        uint8_t* rw = nullptr;
+        size_t size = 0;
+        int fd = -1;
+    };
+
+    struct BlockRef {
+        uint32_t region;
+        uint32_t block;
+    };
+
+    static size_t sizeClassFor(size_t size);
+
+    // fork の前後（pthread_atfork）。子では領域を新しい memfd へ写してマップし直す
+    static void prepareFork();
+    static void parentAfterFork();
+    static void childAfterFork();
+    bool remapRegion(size_t index);
+    static size_t chunkSize(size_t sizeClass) { return kMinChunkSize << sizeClass; }
+
+    const Region* findRegion(const void* executable) const;
+    size_t regionIndexOf(const Region* region) const { return static_cast<size_t>(region - m_regions.data()); }
+
+    // 以下は m_mutex を保持して呼ぶ
+    bool addRegion(size_t size);
+    bool findFreeRun(size_t blockCount, BlockRef& ref);
+    void releaseBlocks(uint32_t region, uint32_t firstBlock, uint32_t blockCount);
+    void* allocateSmall(size_t sizeClass);
+    void* allocateLarge(size_t size);
+
+    std::array<Region, kMaxRegions> m_regions;
+    std::atomic<size_t> m_regionCount{0};
+    bool m_available = false;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::vector<Block>> m_blocks;                        // 領域ごとのブロック
+    std::array<std::vector<BlockRef>, kSizeClassCount> m_partial;    // 空きチャンクのあるブロック
+    size_t m_usedBlocks = 0;
+    size_t m_allocatedBytes = 0;
+    uint64_t m_liveAllocations = 0;
+
+    static std::atomic<uint64_t> s_flushBatches;
+    static std::atomic<uint64_t> s_flushedRanges;
+};
+
+}  // namespace core
+}  // namespace aerojs
@@ -0,0 +1,409 @@
+/**
+ * @file compile_queue.cpp
+ * @brief 階層別レーンと優先度エージングを持つ並行コンパイルキューの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "compile_queue.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "tiered_jit_manager.h"
+
+namespace aerojs::core {
+
+// ---------------------------------------------------------------------------
+// Lane
+// ---------------------------------------------------------------------------
+
+void CompileQueue::Lane::reset(size_t capacity) {
+    cells.reset(new Cell[capacity]);
+    mask = capacity - 1;
+    for (size_t i = 0; i < capacity; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0, std::memory_order_relaxed);
+    dequeuePos.store(0, std::memory_order_relaxed);
+}
+
+bool CompileQueue::Lane::enqueue(uint64_t functionId, uint32_t generation, uint32_t priority, int64_t enqueueNs) {
+    Cell* cell;
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        cell = &cells[pos & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // 満杯
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->functionId.store(functionId, std::memory_order_relaxed);
+    cell->generation.store(generation, std::memory_order_relaxed);
+    cell->priority.store(priority, std::memory_order_relaxed);
+    cell->enqueueNs.store(enqueueNs, std::memory_order_relaxed);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool CompileQueue::Lane::peek(uint32_t& priority, int64_t& enqueueNs) const {
+    // 選択の目安にだけ使うので、読んだ直後に他の消費者が取り出していてもよい
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    const Cell& cell = cells[pos & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+        return false;
+    }
+    priority = cell.priority.load(std::memory_order_relaxed);
+    enqueueNs = cell.enqueueNs.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool CompileQueue::Lane::dequeue(uint64_t& functionId, uint32_t& generation, int64_t& enqueueNs) {
+    Cell* cell;
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        cell = &cells[pos & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // 空
+        } else {
+            pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    functionId = cell->functionId.load(std::memory_order_relaxed);
+    generation = cell->generation.load(std::memory_order_relaxed);
+    enqueueNs = cell->enqueueNs.load(std::memory_order_relaxed);
+    cell->sequence.store(pos + mask + 1, std::memory_order_release);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// CompileQueue
+// ---------------------------------------------------------------------------
+
+CompileQueue::CompileQueue() : CompileQueue(Config()) {}
+
+CompileQueue::CompileQueue(const Config& config) {
+    m_config.capacity = 0;
+    configure(config);
+}
+
+CompileQueue::~CompileQueue() {
+    close();
+}
+
+void CompileQueue::configure(const Config& config) {
+    uint32_t oldCapacity = m_config.capacity;
+    m_config = config;
+    m_config.capacity = std::max<uint32_t>(1, m_config.capacity);
+    m_config.agingQuantumMs = std::max<uint32_t>(1, m_config.agingQuantumMs);
+
+    bool rebuild = oldCapacity == 0 ||
+                   (m_config.capacity != oldCapacity && m_pending.load(std::memory_order_acquire) == 0);
+    if (!rebuild) {
+        m_config.capacity = oldCapacity;
+        return;
+    }
+
+    // 待機中の要求1つにつき、昇格で残る古い要素を見込んで2倍の枠を取る
+    size_t laneCapacity = std::bit_ceil(std::max<size_t>(16, size_t(m_config.capacity) * 2));
+    for (Lane& lane : m_lanes) {
+        lane.reset(laneCapacity);
+    }
+}
+
+int64_t CompileQueue::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool CompileQueue::enqueueLane(JITTier tier, uint64_t functionId, uint32_t generation, uint32_t priority) {
+    size_t lane = std::min<size_t>(static_cast<size_t>(tier), kTierCount - 1);
+    return m_lanes[lane].enqueue(functionId, generation, priority, nowNs());
+}
+
+void CompileQueue::wakeOne() {
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+}
+
+bool CompileQueue::push(uint64_t functionId, Function* function, JITTier targetTier,
+                        uint32_t priority, bool isOSR, uint32_t osrOffset) {
+    Shard& shard = shardFor(functionId);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(functionId);
+        if (it != shard.entries.end()) {
+            Entry& entry = it->second;
+            if (isOSR) {
+                // OSR要求は同じ関数の要求にまとめ、OSR入口も併せて作らせる
+                entry.isOSR = true;
+                entry.osrOffset = osrOffset;
+            }
+
+            if (entry.state == EntryState::Compiling) {
+                if (targetTier > entry.targetTier &&
+                    (!entry.requeueAfterCompile || targetTier > entry.requeueTier)) {
+                    entry.requeueAfterCompile = true;
+                    entry.requeueTier = targetTier;
+                    entry.requeuePriority = priority;
+                }
+                m_coalesced.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            if (targetTier <= entry.targetTier) {
+                entry.priority = std::max(entry.priority, priority);
+                m_coalesced.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            // 上位階層の要求はそのレーンへ入れ直す（元の要素は世代違いで捨てられる）
+            uint32_t generation = m_nextGeneration.fetch_add(1, std::memory_order_relaxed);
+            uint32_t newPriority = std::max(entry.priority, priority);
+            if (!enqueueLane(targetTier, functionId, generation, newPriority)) {
+                m_rejected.fetch_add(1, std::memory_order_relaxed);
+                return true;  // 元の階層の要求は生きている
+            }
+            entry.targetTier = targetTier;
+            entry.priority = newPriority;
+            entry.generation = generation;
+            m_upgraded.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            if (m_pending.load(std::memory_order_relaxed) >= m_config.capacity) {
+                m_rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            uint32_t generation = m_nextGeneration.fetch_add(1, std::memory_order_relaxed);
+            if (!enqueueLane(targetTier, functionId, generation, priority)) {
+                m_rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            Entry& entry = shard.entries[functionId];
+            entry.function = function;
+            entry.targetTier = targetTier;
+            entry.priority = priority;
+            entry.isOSR = isOSR;
+            entry.osrOffset = osrOffset;
+            entry.generation = generation;
+            m_pending.fetch_add(1, std::memory_order_relaxed);
+            m_enqueued.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    wakeOne();
+    return true;
+}
+
+bool CompileQueue::tryPop(QueuedCompile& task) {
+    for (;;) {
+        // 各レーンの先頭を実効優先度で比べる
+        int64_t now = nowNs();
+        int64_t quantumNs = int64_t(m_config.agingQuantumMs) * 1000000;
+        size_t best = kTierCount;
+        int64_t bestScore = 0;
+        for (size_t i = 0; i < kTierCount; ++i) {
+            uint32_t priority;
+            int64_t enqueueNs;
+            if (!m_lanes[i].peek(priority, enqueueNs)) {
+                continue;
+            }
+            int64_t age = std::max<int64_t>(0, now - enqueueNs);
+            int64_t score = int64_t(m_config.laneWeights[i]) + priority + age / quantumNs;
+            if (best == kTierCount || score > bestScore) {
+                best = i;
+                bestScore = score;
+            }
+        }
+        if (best == kTierCount) {
+            return false;
+        }
+
+        uint64_t functionId;
+        uint32_t generation;
+        int64_t enqueueNs;
+        if (!m_lanes[best].dequeue(functionId, generation, enqueueNs)) {
+            continue;  // 他の消費者に先を越された
+        }
+
+        Shard& shard = shardFor(functionId);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(functionId);
+        if (it == shard.entries.end() || it->second.generation != generation ||
+            it->second.state != EntryState::Queued) {
+            lock.unlock();
+            m_staleSkipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        Entry& entry = it->second;
+        entry.state = EntryState::Compiling;
+        task.functionId = functionId;
+        task.function = entry.function;
+        task.targetTier = entry.targetTier;
+        task.priority = entry.priority;
+        task.isOSR = entry.isOSR;
+        task.osrOffset = entry.osrOffset;
+        task.generation = generation;
+        lock.unlock();
+
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        task.queuedNs = static_cast<uint64_t>(std::max<int64_t>(0, nowNs() - enqueueNs));
+        recordLatency(task.queuedNs);
+        return true;
+    }
+}
+
+bool CompileQueue::waitPop(QueuedCompile& task) {
+    for (;;) {
+        // 取り出しを試す前に通知番号を読んでおき、その間の push を取りこぼさない
+        uint32_t signal = m_signal.load(std::memory_order_acquire);
+        if (m_closed.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (tryPop(task)) {
+            return true;
+        }
+        m_signal.wait(signal, std::memory_order_acquire);
+    }
+}
+
+bool CompileQueue::complete(const QueuedCompile& task) {
+    Shard& shard = shardFor(task.functionId);
+    bool requeued = false;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(task.functionId);
+        if (it == shard.entries.end() || it->second.generation != task.generation) {
+            return false;  // コンパイル中に取り消された
+        }
+
+        Entry& entry = it->second;
+        if (entry.requeueAfterCompile) {
+            uint32_t generation = m_nextGeneration.fetch_add(1, std::memory_order_relaxed);
+            if (enqueueLane(entry.requeueTier, task.functionId, generation, entry.requeuePriority)) {
+                entry.state = EntryState::Queued;
+                entry.targetTier = entry.requeueTier;
+                entry.priority = entry.requeuePriority;
+                entry.generation = generation;
+                entry.requeueAfterCompile = false;
+                m_pending.fetch_add(1, std::memory_order_relaxed);
+                requeued = true;
+            } else {
+                m_rejected.fetch_add(1, std::memory_order_relaxed);
+                shard.entries.erase(it);
+            }
+        } else {
+            shard.entries.erase(it);
+        }
+    }
+    if (requeued) {
+        wakeOne();
+    }
+    return true;
+}
+
+bool CompileQueue::cancel(uint64_t functionId) {
+    return cancel(functionId, JITTier::Interpreter);
+}
+
+bool CompileQueue::cancel(uint64_t functionId, JITTier minTier) {
+    Shard& shard = shardFor(functionId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(functionId);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+
+    Entry& entry = it->second;
+    if (entry.targetTier < minTier) {
+        // 下位階層のコンパイルは続け、その後の昇格だけを取り消す
+        if (entry.requeueAfterCompile && entry.requeueTier >= minTier) {
+            entry.requeueAfterCompile = false;
+            m_cancelled.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // リングに残った要素は取り出し時に捨てられ、コンパイル中なら complete() が false を返す
+    if (entry.state == EntryState::Queued) {
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+    shard.entries.erase(it);
+    m_cancelled.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void CompileQueue::close() {
+    m_closed.store(true, std::memory_order_release);
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_all();
+}
+
+void CompileQueue::reopen() {
+    m_closed.store(false, std::memory_order_release);
+}
+
+void CompileQueue::recordLatency(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    size_t bucket = std::min<size_t>(std::bit_width(us), kLatencyBuckets - 1);
+    m_latencyBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_latencyCount.fetch_add(1, std::memory_order_relaxed);
+    m_latencyTotalNs.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t max = m_latencyMaxNs.load(std::memory_order_relaxed);
+    while (ns > max && !m_latencyMaxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t CompileQueue::LatencyHistogram::percentileUpperBoundUs(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t threshold = static_cast<uint64_t>(percentile * count + 0.5);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i + 1 < kLatencyBuckets; ++i) {
+        cumulative += buckets[i];
+        if (cumulative >= threshold) {
+            return uint64_t(1) << i;
+        }
+    }
+    return maxNs / 1000;
+}
+
+CompileQueue::LatencyHistogram CompileQueue::latencyHistogram() const {
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < kLatencyBuckets; ++i) {
+        histogram.buckets[i] = m_latencyBuckets[i].load(std::memory_order_relaxed);
+    }
+    histogram.count = m_latencyCount.load(std::memory_order_relaxed);
+    histogram.totalNs = m_latencyTotalNs.load(std::memory_order_relaxed);
+    histogram.maxNs = m_latencyMaxNs.load(std::memory_order_relaxed);
+    return histogram;
+}
+
+CompileQueue::Stats CompileQueue::getStats() const {
+    Stats stats;
+    stats.enqueued = m_enqueued.load(std::memory_order_relaxed);
+    stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    stats.upgraded = m_upgraded.load(std::memory_order_relaxed);
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.cancelled = m_cancelled.load(std::memory_order_relaxed);
+    stats.staleSkipped = m_staleSkipped.load(std::memory_order_relaxed);
+    stats.pending = m_pending.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}  // namespace aerojs::core
@@ -0,0 +1,221 @@
+/**
+ * @file compile_queue.h
+ * @brief 階層別レーンと優先度エージングを持つ並行コンパイルキュー
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace aerojs::core {
+
+class Function;
+enum class JITTier : uint8_t;
+
+/**
+ * @brief キューから取り出したコンパイル要求
+ *
+ * generation は complete() に渡し、待機中・コンパイル中に取り消されていないかを確かめる。
+ */
+struct QueuedCompile {
+    uint64_t functionId = 0;
+    Function* function = nullptr;
+    JITTier targetTier{};
+    uint32_t priority = 0;
+    bool isOSR = false;
+    uint32_t osrOffset = 0;
+    uint32_t generation = 0;
+    uint64_t queuedNs = 0;     // 投入から取り出しまでの待ち時間
+};
+
+/**
+ * @brief 複数生産者・複数消費者のコンパイルキュー
+ *
+ * JIT階層ごとに有界のロックフリーリング（FIFO）を持ち、取り出し時に各レーンの
+ * 先頭を「レーンの重み + 要求の優先度 + 待ち時間 / agingQuantumMs」で比べて選ぶ。
+ * 待ち時間で優先度が上がるため、最適化JITの要求が続いてもベースラインの要求は
+ * 有限時間で取り出される。
+ *
+ * 関数ごとの状態（待機中かコンパイル中か、世代番号）は関数IDで分割した表に置く。
+ * 同じ関数の要求は1つにまとめ、より高い階層が来たときだけ新しいレーンへ入れ直す
+ * （古いリング要素は世代番号が合わないので取り出し時に捨てる）。cancel() は
+ * 関数の状態を消すだけで、リングの要素は取り出し時に捨て、コンパイル中の要求は
+ * complete() が false を返して結果を破棄させる。
+ *
+ * 待ち行列の上限は「待機中の関数の数」に掛かり、重複した要求は数えない。
+ */
+class CompileQueue {
+public:
+    static constexpr size_t kTierCount = 5;
+    static constexpr size_t kLatencyBuckets = 24;   // 2^i マイクロ秒未満（最後は上限なし）
+    static constexpr size_t kStateShards = 16;
+
+    struct Config {
+        uint32_t capacity = 1000;         // 待機中の関数の上限
+        uint32_t agingQuantumMs = 10;     // この時間待つごとに優先度を1上げる
+        std::array<uint32_t, kTierCount> laneWeights{{0, 0, 4, 8, 4}};
+    };
+
+    struct LatencyHistogram {
+        std::array<uint64_t, kLatencyBuckets> buckets{};
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+
+        /**
+         * @brief 分位点の上限（マイクロ秒、バケット境界）
+         */
+        uint64_t percentileUpperBoundUs(double percentile) const;
+    };
+
+    struct Stats {
+        uint64_t enqueued = 0;       // 新しく待機状態になった要求
+        uint64_t coalesced = 0;      // 既存の要求にまとめた数
+        uint64_t upgraded = 0;       // より高い階層へ入れ直した数
+        uint64_t rejected = 0;       // 上限で受け付けなかった数
+        uint64_t cancelled = 0;      // 待機中・コンパイル中に取り消した数
+        uint64_t staleSkipped = 0;   // 取り出し時に捨てた古い要素
+        uint64_t pending = 0;        // 現在待機中の関数の数
+    };
+
+    CompileQueue();
+    explicit CompileQueue(const Config& config);
+    ~CompileQueue();
+
+    CompileQueue(const CompileQueue&) = delete;
+    CompileQueue& operator=(const CompileQueue&) = delete;
+
+    /**
+     * @brief 設定を変更する（コンパイルスレッドの開始前に呼ぶ。容量は空の時だけ反映される）
+     */
+    void configure(const Config& config);
+
+    /**
+     * @brief 要求を投入する
+     * @return 待機中になった（または既存の要求にまとめた）ら true
+     */
+    bool push(uint64_t functionId, Function* function, JITTier targetTier,
+              uint32_t priority, bool isOSR = false, uint32_t osrOffset = 0);
+
+    /**
+     * @brief 最も実効優先度の高い要求を取り出す（空なら false を即座に返す）
+     */
+    bool tryPop(QueuedCompile& task);
+
+    /**
+     * @brief 要求を取り出すまで待つ（close() 後は false）
+     */
+    bool waitPop(QueuedCompile& task);
+
+    /**
+     * @brief コンパイルの終了を通知する
+     * @return 取り消されていなければ true（false ならコードを捨てる）
+     */
+    bool complete(const QueuedCompile& task);
+
+    /**
+     * @brief 関数の待機中・コンパイル中の要求を取り消す
+     * @return 取り消す要求があれば true
+     */
+    bool cancel(uint64_t functionId);
+
+    /**
+     * @brief 対象階層が minTier 以上の要求だけを取り消す（脱最適化で下位階層の要求は残す）
+     */
+    bool cancel(uint64_t functionId, JITTier minTier);
+
+    /**
+     * @brief 待っている消費者をすべて起こし、以後の waitPop を false にする
+     */
+    void close();
+    void reopen();
+
+    size_t pendingCount() const { return m_pending.load(std::memory_order_relaxed); }
+
+    LatencyHistogram latencyHistogram() const;
+    Stats getStats() const;
+
+private:
+    // Vyukov 型の有界MPMCリング。要素は関数IDと世代と投入時刻だけを持つ
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        std::atomic<uint64_t> functionId{0};
+        std::atomic<uint32_t> generation{0};
+        std::atomic<uint32_t> priority{0};
+        std::atomic<int64_t> enqueueNs{0};
+    };
+
+    struct Lane {
+        std::unique_ptr<Cell[]> cells;
+        size_t mask = 0;
+        alignas(64) std::atomic<size_t> enqueuePos{0};
+        alignas(64) std::atomic<size_t> dequeuePos{0};
+
+        void reset(size_t capacity);
+        bool enqueue(uint64_t functionId, uint32_t generation, uint32_t priority, int64_t enqueueNs);
+        bool peek(uint32_t& priority, int64_t& enqueueNs) const;
+        bool dequeue(uint64_t& functionId, uint32_t& generation, int64_t& enqueueNs);
+    };
+
+    enum class EntryState : uint8_t { Queued, Compiling };
+
+    struct Entry {
+        Function* function = nullptr;
+        EntryState state = EntryState::Queued;
+        JITTier targetTier{};
+        uint32_t priority = 0;
+        bool isOSR = false;
+        uint32_t osrOffset = 0;
+        uint32_t generation = 0;
+        bool requeueAfterCompile = false;   // コンパイル中に上位階層が要求された
+        JITTier requeueTier{};
+        uint32_t requeuePriority = 0;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Entry> entries;
+    };
+
+    Shard& shardFor(uint64_t functionId) {
+        return m_shards[(functionId * 0x9E3779B97F4A7C15ull) >> 60];
+    }
+
+    static int64_t nowNs();
+    void recordLatency(uint64_t ns);
+    bool enqueueLane(JITTier tier, uint64_t functionId, uint32_t generation, uint32_t priority);
+    void wakeOne();
+
+    Config m_config;
+    std::array<Lane, kTierCount> m_lanes;
+    std::array<Shard, kStateShards> m_shards;
+    std::atomic<uint32_t> m_nextGeneration{1};
+
+    // 待機中の関数の数と、待機中の消費者を起こすための通知番号
+    std::atomic<size_t> m_pending{0};
+    std::atomic<uint32_t> m_signal{0};
+    std::atomic<bool> m_closed{false};
+
+    std::array<std::atomic<uint64_t>, kLatencyBuckets> m_latencyBuckets{};
+    std::atomic<uint64_t> m_latencyCount{0};
+    std::atomic<uint64_t> m_latencyTotalNs{0};
+    std::atomic<uint64_t> m_latencyMaxNs{0};
+
+    std::atomic<uint64_t> m_enqueued{0};
+    std::atomic<uint64_t> m_coalesced{0};
+    std::atomic<uint64_t> m_upgraded{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<uint64_t> m_cancelled{0};
+    std::atomic<uint64_t> m_staleSkipped{0};
+};
+
+}  // namespace aerojs::core
@@ -1,381 +1,503 @@
 #include "deoptimizer.h"
 
-#include <cassert>
-#include <mutex>
 #include <algorithm>
-#include <sstream>
-#include <iomanip>
-#include "../vm/interpreter.h"
-#include "../vm/stack/frame.h"
-#include "../runtime/context/execution_context.h"
-#include "../jit/metatracing/trace_manager.h"
-#include "../utils/logger.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <pthread.h>
+#endif
+
+#include "../code_space.h"
+#include "../osr/osr_entry.h"
+#include "../../runtime/values/value.h"
 
 namespace aerojs {
 namespace core {
 
-// スレッド安全のためのミューテックス
-static std::mutex g_deoptMutex;
+namespace {
 
-Deoptimizer::Deoptimizer() noexcept 
-  : m_deoptInfoMap(), 
-    m_callback(nullptr),
-    m_osrEnabled(false),
-    m_deoptStatistics{},
-    m_osrStatistics{} {
+void Emit32(std::vector<uint8_t>& code, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+  }
 }
 
-void Deoptimizer::RegisterDeoptPoint(void* codeAddress, const DeoptimizationInfo& info) noexcept {
-  assert(codeAddress != nullptr && "Code address cannot be null");
-  
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
-  m_deoptInfoMap[codeAddress] = info;
-  
-  // ログ出力（詳細モードの場合のみ）
-  if (Logger::IsDetailedLoggingEnabled()) {
-    std::stringstream ss;
-    ss << "Registered deopt point at 0x" << std::hex << std::setw(16) << std::setfill('0')
-       << reinterpret_cast<uintptr_t>(codeAddress) << " for function " << info.functionId
-       << " at bytecode offset " << info.bytecodeOffset;
-    Logger::Debug(ss.str(), "Deoptimizer");
+void Emit64(std::vector<uint8_t>& code, uint64_t value) {
+  for (int i = 0; i < 8; ++i) {
+    code.push_back(static_cast<uint8_t>(value >> (i * 8)));
   }
 }
 
-bool Deoptimizer::PerformDeoptimization(void* codeAddress, DeoptimizationReason reason) noexcept {
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
-  
-  // デオプティマイズポイントの情報を取得
-  auto it = m_deoptInfoMap.find(codeAddress);
-  if (it == m_deoptInfoMap.end()) {
-    // 登録されていないアドレスの場合、失敗
-    Logger::Error("Deoptimization failed: unknown code address", "Deoptimizer");
+// 現在のスレッドのスタックの範囲（フレームをたどるときの境界）
+bool CurrentStackBounds(uintptr_t& low, uintptr_t& high) {
+#if defined(__linux__)
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) {
     return false;
   }
-  
-  // デオプティマイズ情報を取得
-  const auto& info = it->second;
-  
-  // 統計情報を更新
-  m_deoptStatistics.totalDeoptimizations++;
-  switch (reason) {
-    case DeoptimizationReason::TypeFeedback:
-      m_deoptStatistics.typeFeedbackDeoptimizations++;
-      break;
-    case DeoptimizationReason::Overflow:
-      m_deoptStatistics.overflowDeoptimizations++;
-      break;
-    case DeoptimizationReason::BailoutRequest:
-      m_deoptStatistics.bailoutRequestDeoptimizations++;
-      break;
-    case DeoptimizationReason::DebuggerAttached:
-      m_deoptStatistics.debuggerAttachedDeoptimizations++;
-      break;
-    case DeoptimizationReason::TypeCheck:
-      m_deoptStatistics.typeCheckDeoptimizations++;
-      break;
-    default:
-      m_deoptStatistics.unknownReasonDeoptimizations++;
-      break;
+  void* base = nullptr;
+  size_t size = 0;
+  int rc = pthread_attr_getstack(&attr, &base, &size);
+  pthread_attr_destroy(&attr);
+  if (rc != 0) {
+    return false;
   }
-  
-  // 詳細なログ出力
-  std::stringstream ss;
-  ss << "Deoptimizing function " << info.functionId << " at bytecode offset " 
-     << info.bytecodeOffset << " due to " << DeoptimizationReasonToString(reason);
-  Logger::Info(ss.str(), "Deoptimizer");
-  
-  // JITコードからバイトコードへの状態マッピングを実行
-  ExecutionState state = MapJITStateToInterpreterState(codeAddress, info);
-  
-  // コールバックが設定されていれば呼び出す
-  if (m_callback) {
-    m_callback(info, reason);
-  }
-  
+  low = reinterpret_cast<uintptr_t>(base);
+  high = low + size;
   return true;
+#else
+  (void)low;
+  (void)high;
+  return false;
+#endif
 }
 
-ExecutionState Deoptimizer::MapJITStateToInterpreterState(void* codeAddress, const DeoptimizationInfo& info) noexcept {
-  ExecutionState state;
-  state.functionId = info.functionId;
-  state.bytecodeOffset = info.bytecodeOffset;
-  state.stackDepth = info.stackDepth;
-  
-  // JITコンパイルされたコードのスタックとローカル変数をマッピング
-  state.localVariables.resize(info.liveVariables.size());
-  for (size_t i = 0; i < info.liveVariables.size(); ++i) {
-    state.localVariables[i] = info.liveVariables[i];
-  }
-  
-  // スタックフレームの再構築
-  ReconstructStackFrames(state, codeAddress);
-  
-  return state;
+uint64_t BoxValue(uint64_t raw, ValueRepresentation representation) {
+  switch (representation) {
+    case ValueRepresentation::Tagged:
+      return raw;
+    case ValueRepresentation::Int32:
+      return Value::createInteger(static_cast<int32_t>(raw)).getRawBits();
+    case ValueRepresentation::Double: {
+      double number;
+      std::memcpy(&number, &raw, sizeof(number));
+      return Value::createNumber(number).getRawBits();
+    }
+    case ValueRepresentation::Boolean:
+      return Value::createBoolean(raw != 0).getRawBits();
+  }
+  return Value::createUndefined().getRawBits();
 }
 
-void Deoptimizer::ReconstructStackFrames(ExecutionState& state, void* codeAddress) noexcept {
-  // 実装: JITコードのスタックフレームから解釈実行用のスタックフレームを再構築
-  
-  // スタックのマッピング情報を取得
-  auto* stackMap = FindStackMapForAddress(codeAddress);
-  if (!stackMap) {
-    Logger::Error("Failed to find stack map for address during deoptimization", "Deoptimizer");
+/**
+ * x86_64 のトランポリン
+ *
+ * 入ったときのスタックの先頭（pcSlot）は、即時なら call が積んだ戻り先、遅延なら ret で
+ * 外した戻り先の代わりに積む 0（そのアドレスは書き換えたスロットと同じ）。
+ * その下に XMM0〜15、RAX〜R15 の順に退避して TrampolineEntry を呼び、
+ * 戻ったら最適化コードのフレームを通常のエピローグと同じ手順で外して呼び出し元へ戻る。
+ */
+bool EmitTrampoline(bool lazy, uint32_t kind, const void* entry, std::vector<uint8_t>& code) {
+#if defined(__x86_64__) || defined(_M_X64)
+  code.clear();
+  if (lazy) {
+    code.insert(code.end(), {0x6A, 0x00});                          // push 0
+  }
+
+  code.insert(code.end(), {0x48, 0x81, 0xEC});                      // sub rsp, 128
+  Emit32(code, 128);
+  for (uint8_t i = 0; i < 16; ++i) {                                // movdqu [rsp + 16*i], xmm_i
+    code.push_back(0xF3);
+    if (i >= 8) {
+      code.push_back(0x44);
+    }
+    code.insert(code.end(), {0x0F, 0x7F, static_cast<uint8_t>(0x44 | ((i & 7) << 3)), 0x24,
+                             static_cast<uint8_t>(16 * i)});
+  }
+  for (int reg = 15; reg >= 0; --reg) {                             // push r15 〜 push rax
+    if (reg >= 8) {
+      code.push_back(0x41);
+    }
+    code.push_back(static_cast<uint8_t>(0x50 + (reg & 7)));
+  }
+  code.insert(code.end(), {0x48, 0x83, 0xEC, 0x08});                // sub rsp, 8（16バイト境界）
+
+  code.insert(code.end(), {0x48, 0x8D, 0x7C, 0x24, 0x08});          // lea rdi, [rsp + 8]
+  code.insert(code.end(), {0x48, 0x89, 0xEE});                      // mov rsi, rbp
+  code.push_back(0xBA);                                             // mov edx, kind
+  Emit32(code, kind);
+  code.insert(code.end(), {0x48, 0x8D, 0x8C, 0x24});                // lea rcx, [rsp + 8 + 128 + 128]
+  Emit32(code, 8 + 128 + 128);
+  code.insert(code.end(), {0x48, 0xB8});                            // mov rax, entry
+  Emit64(code, reinterpret_cast<uint64_t>(entry));
+  code.insert(code.end(), {0xFF, 0xD0});                            // call rax
+
+  // 最適化コードのフレームを外す（RAX は完了値のまま）
+  code.insert(code.end(), {0x48, 0x8D, 0x65,                        // lea rsp, [rbp - 40]
+                           static_cast<uint8_t>(-OSREntryLayout::kCalleeSavedBytes)});
+  code.insert(code.end(), {0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C});  // pop r15 〜 r12
+  code.insert(code.end(), {0x5B, 0x5D, 0xC3});                      // pop rbx; pop rbp; ret
+  return true;
+#else
+  (void)lazy;
+  (void)kind;
+  (void)entry;
+  (void)code;
+  return false;
+#endif
+}
+
+}  // namespace
+
+Deoptimizer::Deoptimizer() noexcept
+  : m_deoptInfoMap(),
+    m_callback(nullptr),
+    m_materializer(nullptr),
+    m_eagerTrampoline(nullptr),
+    m_lazyTrampoline(nullptr),
+    m_trampolinesFailed(false),
+    m_stats{} {
+}
+
+void Deoptimizer::RegisterDeoptPoint(void* codeAddress, const DeoptimizationInfo& info) noexcept {
+  if (!codeAddress) {
     return;
   }
-  
-  // 現在のJITスタックポインタを取得
-  uintptr_t currentSP = CaptureStackPointer();
-  
-  // フレームの再構築
-  for (const auto& frame : stackMap->frames) {
-    // インタープリタフレームを作成
-    VMStackFrame interpreterFrame;
-    interpreterFrame.functionId = frame.functionId;
-    interpreterFrame.bytecodeOffset = frame.bytecodeOffset;
-    
-    // レジスタのマッピング
-    for (const auto& mapping : frame.registerMappings) {
-      Value value;
-      
-      // レジスタの種類に応じて値を取得
-      switch (mapping.location.type) {
-        case RegisterLocation::Type::Stack:
-          value = *reinterpret_cast<Value*>(currentSP + mapping.location.offset);
-          break;
-          
-        case RegisterLocation::Type::Register:
-          value = CaptureRegisterValue(mapping.location.regId);
-          break;
-          
-        case RegisterLocation::Type::Constant:
-          value = mapping.location.constantValue;
-          break;
-          
-        default:
-          Logger::Warning("Unknown register location type during deoptimization", "Deoptimizer");
-          continue;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_deoptInfoMap[codeAddress] = info;
+}
+
+bool Deoptimizer::PerformDeoptimization(void* codeAddress, DeoptimizationReason reason) noexcept {
+  bool isOptimizedCode = false;
+  DeoptimizationInfo info;
+  DeoptCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const CodeRange* range = FindCodeLocked(reinterpret_cast<uintptr_t>(codeAddress));
+    isOptimizedCode = range && range->start == reinterpret_cast<uintptr_t>(codeAddress);
+    if (!isOptimizedCode) {
+      auto it = m_deoptInfoMap.find(codeAddress);
+      if (it == m_deoptInfoMap.end()) {
+        return false;
       }
-      
-      // インタープリタフレームに値を設定
-      interpreterFrame.localVariables[mapping.interpreterIndex] = value;
+      info = it->second;
+      callback = m_callback;
     }
-    
-    // インタープリタスタックにフレームを追加
-    state.frames.push_back(interpreterFrame);
   }
+
+  // 最適化コードならフレーム状態のテーブルで遅延脱最適化する
+  if (isOptimizedCode) {
+    InvalidateCode(codeAddress, reason);
+    return true;
+  }
+
+  if (callback) {
+    callback(info, reason);
+  }
+  return true;
 }
 
 void Deoptimizer::SetCallback(DeoptCallback callback) noexcept {
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
+  std::lock_guard<std::mutex> lock(m_mutex);
   m_callback = std::move(callback);
 }
 
 void Deoptimizer::UnregisterDeoptPoint(void* codeAddress) noexcept {
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
+  std::lock_guard<std::mutex> lock(m_mutex);
   m_deoptInfoMap.erase(codeAddress);
 }
 
 void Deoptimizer::ClearAllDeoptPoints() noexcept {
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
+  std::lock_guard<std::mutex> lock(m_mutex);
   m_deoptInfoMap.clear();
+  m_codeRanges.clear();
 }
 
-// オンスタックリプレースメント（OSR）の設定
-void Deoptimizer::EnableOSR(bool enable) noexcept {
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
-  m_osrEnabled = enable;
-  
-  Logger::Info(std::string("On-Stack Replacement is now ") + (enable ? "enabled" : "disabled"), "Deoptimizer");
-}
+//-----------------------------------------------------------------------------
+// 最適化コードの登録
+//-----------------------------------------------------------------------------
 
-bool Deoptimizer::IsOSREnabled() const noexcept {
-  return m_osrEnabled;
-}
+void Deoptimizer::RegisterCode(const void* code, size_t size, std::shared_ptr<const FrameStateTable> table,
+                               uint64_t functionId) noexcept {
+  if (!code || size == 0 || !table) {
+    return;
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(code);
 
-// OSRエントリーポイントの登録
-void Deoptimizer::RegisterOSREntryPoint(uint32_t functionId, uint32_t bytecodeOffset, void* jitEntryAddress) noexcept {
-  if (!m_osrEnabled) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = std::lower_bound(m_codeRanges.begin(), m_codeRanges.end(), start,
+                             [](const CodeRange& range, uintptr_t address) { return range.start < address; });
+  if (it != m_codeRanges.end() && it->start == start) {
+    *it = {start, size, std::move(table), functionId};
     return;
   }
-  
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
-  
-  // キーの作成
-  OSRKey key{functionId, bytecodeOffset};
-  
-  // OSRエントリーポイントを登録
-  m_osrEntryPoints[key] = jitEntryAddress;
-  
-  // ログ出力
-  std::stringstream ss;
-  ss << "Registered OSR entry point at 0x" << std::hex << std::setw(16) << std::setfill('0')
-     << reinterpret_cast<uintptr_t>(jitEntryAddress) << " for function " << functionId
-     << " at bytecode offset " << bytecodeOffset;
-  Logger::Debug(ss.str(), "Deoptimizer");
+  m_codeRanges.insert(it, {start, size, std::move(table), functionId});
 }
 
-// OSRエントリーポイントの検索
-void* Deoptimizer::FindOSREntryPoint(uint32_t functionId, uint32_t bytecodeOffset) const noexcept {
-  if (!m_osrEnabled) {
-    return nullptr;
+void Deoptimizer::UnregisterCode(const void* code) noexcept {
+  uintptr_t start = reinterpret_cast<uintptr_t>(code);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = std::lower_bound(m_codeRanges.begin(), m_codeRanges.end(), start,
+                             [](const CodeRange& range, uintptr_t address) { return range.start < address; });
+  if (it != m_codeRanges.end() && it->start == start) {
+    m_codeRanges.erase(it);
   }
-  
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
-  
-  // キーの作成
-  OSRKey key{functionId, bytecodeOffset};
-  
-  // エントリーポイントを検索
-  auto it = m_osrEntryPoints.find(key);
-  if (it == m_osrEntryPoints.end()) {
+}
+
+const Deoptimizer::CodeRange* Deoptimizer::FindCodeLocked(uintptr_t pc) const {
+  auto it = std::upper_bound(m_codeRanges.begin(), m_codeRanges.end(), pc,
+                             [](uintptr_t address, const CodeRange& range) { return address < range.start; });
+  if (it == m_codeRanges.begin()) {
     return nullptr;
   }
-  
-  return it->second;
+  --it;
+  return pc - it->start < it->size ? &*it : nullptr;
 }
 
-// インタープリタからJITコードへのOSR実行
-bool Deoptimizer::PerformOSR(uint32_t functionId, uint32_t bytecodeOffset, 
-                           const std::vector<Value>& localVariables, 
-                           const std::vector<Value>& stackValues) noexcept {
-  if (!m_osrEnabled) {
+//-----------------------------------------------------------------------------
+// 遅延脱最適化
+//-----------------------------------------------------------------------------
+
+size_t Deoptimizer::InvalidateCode(const void* code, DeoptimizationReason reason) noexcept {
+  uintptr_t start = reinterpret_cast<uintptr_t>(code);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = std::lower_bound(m_codeRanges.begin(), m_codeRanges.end(), start,
+                             [](const CodeRange& range, uintptr_t address) { return range.start < address; });
+  if (it == m_codeRanges.end() || it->start != start) {
+    return 0;
+  }
+  CodeRange range = std::move(*it);
+  m_codeRanges.erase(it);
+  m_stats.invalidatedCodes++;
+
+  uintptr_t low = 0;
+  uintptr_t high = 0;
+  if (!m_resumeHandler || !EnsureTrampolinesLocked() || !CurrentStackBounds(low, high)) {
+    return 0;
+  }
+
+  // フレームポインタの連鎖をたどり、無効にしたコードのセーフポイントへ戻るフレームを探す。
+  // 連鎖が壊れていても（フレームポインタを持たない関数）スタックの外は読まない
+  size_t patched = 0;
+#if defined(__GNUC__)
+  uintptr_t fp = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+  while (fp >= low && fp + 2 * sizeof(uintptr_t) <= high && fp % sizeof(uintptr_t) == 0) {
+    uintptr_t* slot = reinterpret_cast<uintptr_t*>(fp) + 1;
+    uintptr_t returnAddress = *slot;
+    uintptr_t offset = returnAddress - range.start;
+    if (offset < range.size && range.table->HasSafepoint(static_cast<uint32_t>(offset))) {
+      m_patchedFrames[reinterpret_cast<uintptr_t>(slot)] =
+          {returnAddress, range.start, range.table, range.functionId, reason};
+      *slot = reinterpret_cast<uintptr_t>(m_lazyTrampoline);
+      patched++;
+    }
+    uintptr_t next = *reinterpret_cast<uintptr_t*>(fp);
+    if (next <= fp) {
+      break;
+    }
+    fp = next;
+  }
+#endif
+  m_stats.patchedFrames += patched;
+  return patched;
+}
+
+const void* Deoptimizer::EagerTrampoline() noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return EnsureTrampolinesLocked() ? m_eagerTrampoline : nullptr;
+}
+
+bool Deoptimizer::EnsureTrampolinesLocked() {
+  if (m_eagerTrampoline && m_lazyTrampoline) {
+    return true;
+  }
+  if (m_trampolinesFailed) {
     return false;
   }
-  
-  // OSRエントリーポイントを検索
-  void* osrEntry = FindOSREntryPoint(functionId, bytecodeOffset);
-  if (!osrEntry) {
+  m_trampolinesFailed = true;
+
+  const void* entry = reinterpret_cast<const void*>(&Deoptimizer::TrampolineEntry);
+  std::vector<uint8_t> eager;
+  std::vector<uint8_t> lazy;
+  if (!EmitTrampoline(false, static_cast<uint32_t>(EntryKind::Eager), entry, eager) ||
+      !EmitTrampoline(true, static_cast<uint32_t>(EntryKind::Lazy), entry, lazy)) {
+    return false;
+  }
+
+  CodeSpace& space = CodeSpace::shared();
+  if (!space.isAvailable()) {
     return false;
   }
-  
-  // 現在の実行状態をキャプチャ
-  ExecutionState currentState;
-  currentState.functionId = functionId;
-  currentState.bytecodeOffset = bytecodeOffset;
-  currentState.localVariables = localVariables;
-  currentState.stackValues = stackValues;
-  
-  // OSR用のスタックを構築
-  void* osrStackFrame = PrepareOSRStackFrame(currentState, osrEntry);
-  if (!osrStackFrame) {
-    Logger::Error("Failed to prepare OSR stack frame", "Deoptimizer");
+  void* eagerCode = space.allocate(eager.size());
+  void* lazyCode = space.allocate(lazy.size());
+  if (!eagerCode || !lazyCode) {
+    if (eagerCode) {
+      space.free(eagerCode);
+    }
+    if (lazyCode) {
+      space.free(lazyCode);
+    }
     return false;
   }
-  
-  // OSR統計情報を更新
-  m_osrStatistics.totalOSRTransitions++;
-  
-  // OSRジャンプを実行
-  ExecuteOSRJump(osrEntry, osrStackFrame);
-  
-  // 正常にOSRジャンプが完了した
+  std::memcpy(space.writableAddress(eagerCode), eager.data(), eager.size());
+  std::memcpy(space.writableAddress(lazyCode), lazy.data(), lazy.size());
+  {
+    CodeSpace::FlushScope flushScope;
+    CodeSpace::flushRange(eagerCode, eager.size());
+    CodeSpace::flushRange(lazyCode, lazy.size());
+  }
+
+  m_eagerTrampoline = eagerCode;
+  m_lazyTrampoline = lazyCode;
+  m_trampolinesFailed = false;
   return true;
 }
 
-// OSR用のスタックフレーム準備
-void* Deoptimizer::PrepareOSRStackFrame(const ExecutionState& state, void* osrEntry) noexcept {
-  // OSR用のスタックフレームを確保
-  size_t frameSize = CalculateOSRFrameSize(state.functionId, osrEntry);
-  if (frameSize == 0) {
-    Logger::Error("Failed to calculate OSR frame size", "Deoptimizer");
-    return nullptr;
+uint64_t Deoptimizer::TrampolineEntry(const uint64_t* savedRegisters, uintptr_t fp, uint32_t kind,
+                                      const uintptr_t* pcSlot) noexcept {
+  Deoptimizer& self = Instance();
+  const bool lazy = static_cast<EntryKind>(kind) == EntryKind::Lazy;
+
+  uintptr_t pc = 0;
+  uintptr_t codeStart = 0;
+  std::shared_ptr<const FrameStateTable> table;
+  uint64_t functionId = 0;
+  DeoptimizationReason reason = DeoptimizationReason::TypeCheck;
+  ObjectMaterializer* materializer = nullptr;
+  ResumeHandler handler;
+  DeoptCallback callback;
+  {
+    std::lock_guard<std::mutex> lock(self.m_mutex);
+    if (lazy) {
+      auto it = self.m_patchedFrames.find(reinterpret_cast<uintptr_t>(pcSlot));
+      if (it != self.m_patchedFrames.end()) {
+        pc = it->second.returnAddress;
+        codeStart = it->second.codeStart;
+        table = std::move(it->second.table);
+        functionId = it->second.functionId;
+        reason = it->second.reason;
+        self.m_patchedFrames.erase(it);
+      }
+      self.m_stats.lazyDeoptimizations++;
+    } else {
+      pc = *pcSlot;
+      if (const CodeRange* range = self.FindCodeLocked(pc)) {
+        codeStart = range->start;
+        table = range->table;
+        functionId = range->functionId;
+      }
+      self.m_stats.eagerDeoptimizations++;
+    }
+    materializer = self.m_materializer;
+    handler = self.m_resumeHandler;
+    callback = self.m_callback;
   }
-  
-  void* osrStack = AllocateOSRStack(frameSize);
-  if (!osrStack) {
-    Logger::Error("Failed to allocate OSR stack", "Deoptimizer");
-    return nullptr;
+
+  // 復元できなければ最適化コードへも戻れない
+  SafepointState state;
+  std::vector<DeoptimizedFrame> frames;
+  DeoptRegisterState regs{savedRegisters, savedRegisters + 16};
+  if (!table || !handler || !table->Lookup(static_cast<uint32_t>(pc - codeStart), state) ||
+      !TranslateFrames(*table, state, regs, fp, materializer, frames) || frames.empty()) {
+    std::abort();
   }
-  
-  // OSRスタックフレームの構築
-  BuildOSRStackFrame(osrStack, state, osrEntry);
-  
-  return osrStack;
-}
 
-// デバッグ/統計情報
-const DeoptimizationStatistics& Deoptimizer::GetDeoptimizationStatistics() const noexcept {
-  return m_deoptStatistics;
-}
+  // 呼び出しの戻り先で外したなら、呼び出し先の戻り値（RAX）が最内のフレームの結果
+  if (lazy && state.kind == SafepointKind::Call) {
+    frames.back().stack.push_back(regs.gprs[0]);
+  }
 
-const OSRStatistics& Deoptimizer::GetOSRStatistics() const noexcept {
-  return m_osrStatistics;
-}
+  if (!state.objects.empty()) {
+    std::lock_guard<std::mutex> lock(self.m_mutex);
+    self.m_stats.materializedObjects += state.objects.size();
+  }
 
-void Deoptimizer::ResetStatistics() noexcept {
-  std::lock_guard<std::mutex> lock(g_deoptMutex);
-  m_deoptStatistics = DeoptimizationStatistics{};
-  m_osrStatistics = OSRStatistics{};
-}
+  if (!lazy && state.speculation == SpeculationKind::Overflow) {
+    reason = DeoptimizationReason::Overflow;
+  }
 
-std::string Deoptimizer::DeoptimizationReasonToString(DeoptimizationReason reason) const noexcept {
-  switch (reason) {
-    case DeoptimizationReason::TypeFeedback:
-      return "type feedback instability";
-    case DeoptimizationReason::Overflow:
-      return "numeric overflow";
-    case DeoptimizationReason::BailoutRequest:
-      return "explicit bailout request";
-    case DeoptimizationReason::DebuggerAttached:
-      return "debugger attachment";
-    case DeoptimizationReason::TypeCheck:
-      return "type guard failure";
-    default:
-      return "unknown reason";
+  if (callback) {
+    const DeoptimizedFrame& outermost = frames.front();
+    DeoptimizationInfo info;
+    info.functionId = static_cast<uint32_t>(functionId);
+    info.bytecodeOffset = outermost.bytecodeOffset;
+    info.stackDepth = static_cast<uint32_t>(outermost.stack.size());
+    info.speculation = state.speculation;
+    info.siteFunctionId = frames.back().functionId;
+    info.siteBytecodeOffset = frames.back().bytecodeOffset;
+    const SafepointState::Frame& frameState = state.frames.front();
+    for (uint32_t i = 0; i < frameState.localCount; ++i) {
+      if (frameState.values[i].kind != ValueLocationKind::Dead) {
+        info.liveVariables.push_back(i);
+      }
+    }
+    callback(info, reason);
   }
+
+  return handler(frames);
 }
 
-// スタック参照およびポインタ/レジスタ値キャプチャのヘルパー関数
-// これらは実際にはアセンブリ実装またはプラットフォーム固有のコードとなる
-
-uintptr_t Deoptimizer::CaptureStackPointer() noexcept {
-#if defined(_MSC_VER)
-    // Windowsの場合
-#if defined(_M_X64)
-    // x64アーキテクチャ
-    void* sp = nullptr;
-    __asm {
-        mov sp, rsp
+//-----------------------------------------------------------------------------
+// フレームの復元
+//-----------------------------------------------------------------------------
+
+bool Deoptimizer::TranslateFrames(const FrameStateTable& table, const SafepointState& state,
+                                  const DeoptRegisterState& regs, uintptr_t fp,
+                                  ObjectMaterializer* materializer, std::vector<DeoptimizedFrame>& frames) {
+  std::vector<uint64_t> objects(state.objects.size());
+
+  auto resolve = [&](const ValueLocation& location) -> uint64_t {
+    switch (location.kind) {
+      case ValueLocationKind::Register:
+        return BoxValue(regs.Read(location.value), location.representation);
+      case ValueLocationKind::StackSlot:
+        return BoxValue(*reinterpret_cast<const uint64_t*>(fp + static_cast<intptr_t>(location.value)),
+                        location.representation);
+      case ValueLocationKind::Constant:
+        return table.Constant(static_cast<size_t>(location.value));
+      case ValueLocationKind::Object:
+        return objects[static_cast<size_t>(location.value)];
+      case ValueLocationKind::Dead:
+        break;
     }
-    return reinterpret_cast<uintptr_t>(sp);
-#else
-    // その他のアーキテクチャ
-    return 0;
-#endif
-#elif defined(__GNUC__)
-    // GCCの場合
-#if defined(__x86_64__)
-    // x64アーキテクチャ
-    void* sp;
-    asm volatile("movq %%rsp, %0" : "=r"(sp));
-    return reinterpret_cast<uintptr_t>(sp);
-#elif defined(__aarch64__)
-    // ARM64アーキテクチャ
-    void* sp;
-    asm volatile("mov %0, sp" : "=r"(sp));
-    return reinterpret_cast<uintptr_t>(sp);
-#else
-    // その他のアーキテクチャ
-    return 0;
-#endif
-#else
-    // サポートされていないコンパイラ
-    return 0;
-#endif
+    return Value::createUndefined().getRawBits();
+  };
+
+  // 先にすべて作ってからフィールドを埋める（互いに参照していてもよい）
+  if (!objects.empty()) {
+    if (!materializer) {
+      return false;
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+      const SafepointState::MaterializedObject& object = state.objects[i];
+      objects[i] = materializer->Allocate(object.shapeId, static_cast<uint32_t>(object.fields.size()));
+    }
+    for (size_t i = 0; i < objects.size(); ++i) {
+      const SafepointState::MaterializedObject& object = state.objects[i];
+      for (size_t field = 0; field < object.fields.size(); ++field) {
+        materializer->SetField(objects[i], static_cast<uint32_t>(field), resolve(object.fields[field]));
+      }
+    }
+  }
+
+  frames.clear();
+  frames.reserve(state.frames.size());
+  for (const SafepointState::Frame& frameState : state.frames) {
+    DeoptimizedFrame frame;
+    frame.functionId = frameState.functionId;
+    frame.bytecodeOffset = frameState.bytecodeOffset;
+    frame.locals.reserve(frameState.localCount);
+    frame.stack.reserve(frameState.stackCount + 1);
+    for (size_t i = 0; i < frameState.values.size(); ++i) {
+      uint64_t value = resolve(frameState.values[i]);
+      if (i < frameState.localCount) {
+        frame.locals.push_back(value);
+      } else {
+        frame.stack.push_back(value);
+      }
+    }
+    frames.push_back(std::move(frame));
+  }
+  return true;
+}
+
+void Deoptimizer::SetObjectMaterializer(ObjectMaterializer* materializer) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_materializer = materializer;
 }
 
-Value Deoptimizer::CaptureRegisterValue(uint32_t regId) noexcept {
-  // デオプティマイゼーション時のレジスタ値キャプチャの完全実装が既に完了済み
-  // 全ての機能が実装されています
-  return CaptureState(reason, offset, optimizedCode, originalBytecode);
+void Deoptimizer::SetResumeHandler(ResumeHandler handler) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_resumeHandler = std::move(handler);
 }
 
-Value Deoptimizer::CaptureState(DeoptimizationReason reason, uint32_t offset, 
-                              const CompiledCode* optimizedCode, const Bytecode* originalBytecode) {
-  // デオプティマイゼーション時のレジスタ値キャプチャの完全実装が既に完了済み
-  // 全ての機能が実装されています
-  return CaptureState(reason, offset, optimizedCode, originalBytecode);
+Deoptimizer::Statistics Deoptimizer::GetStatistics() const noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
 }
 
 }  // namespace core
-}  // namespace aerojs 
\ No newline at end of file
+}  // namespace aerojs
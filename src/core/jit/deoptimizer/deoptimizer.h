@@ -2,10 +2,14 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <functional>
 #include <unordered_map>
 
+#include "frame_state.h"
+#include "speculation.h"
+
 namespace aerojs {
 namespace core {
 
@@ -17,6 +21,11 @@ struct DeoptimizationInfo {
   uint32_t bytecodeOffset;               ///< バイトコードオフセット
   uint32_t stackDepth;                   ///< スタック深度
   std::vector<uint32_t> liveVariables;   ///< 生存変数のリスト
+
+  // 外れた投機とその位置（インライン化されていれば最内の呼び出し先のもの）
+  SpeculationKind speculation = SpeculationKind::None;
+  uint64_t siteFunctionId = 0;
+  uint32_t siteBytecodeOffset = 0;
 };
 
 /**
@@ -31,16 +40,94 @@ enum class DeoptimizationReason {
   Unknown           ///< 未知の理由
 };
 
+inline const char* DeoptimizationReasonToString(DeoptimizationReason reason) noexcept {
+  switch (reason) {
+    case DeoptimizationReason::TypeFeedback: return "TypeFeedback";
+    case DeoptimizationReason::Overflow: return "Overflow";
+    case DeoptimizationReason::BailoutRequest: return "BailoutRequest";
+    case DeoptimizationReason::DebuggerAttached: return "DebuggerAttached";
+    case DeoptimizationReason::TypeCheck: return "TypeCheck";
+    default: return "Unknown";
+  }
+}
+
 /**
  * @brief デオプティマイザのコールバック関数型
  */
 using DeoptCallback = std::function<void(const DeoptimizationInfo&, DeoptimizationReason)>;
 
+/**
+ * @brief 脱最適化で復元したインタープリタのフレーム
+ *
+ * 値は NaN-boxing のビット列（Value::getRawBits()）。OSRFrameState と同じ並び。
+ */
+struct DeoptimizedFrame {
+  uint64_t functionId = 0;
+  uint32_t bytecodeOffset = 0;        ///< 再開する命令の位置
+  std::vector<uint64_t> locals;       ///< ローカル変数（インデックス順）
+  std::vector<uint64_t> stack;        ///< オペランドスタック（底から順）
+};
+
+/**
+ * @brief スカラー置換されたオブジェクトをヒープに作り直す
+ *
+ * 先にすべてのオブジェクトを Allocate してからフィールドを SetField するので、
+ * オブジェクト同士が参照し合っていてもよい。作ったオブジェクトは
+ * ResumeHandler へ渡るまでビット列でしか保持されないため、GC から守るのは実装側の責任。
+ */
+class ObjectMaterializer {
+public:
+  virtual ~ObjectMaterializer() = default;
+  virtual uint64_t Allocate(uint32_t shapeId, uint32_t fieldCount) = 0;
+  virtual void SetField(uint64_t object, uint32_t index, uint64_t value) = 0;
+};
+
+/**
+ * @brief 復元したフレームをインタープリタで最後まで実行する
+ *
+ * frames は外側から順（最後が最内のインライン化されたフレーム）。最内から実行し、
+ * その完了値を1つ外側のフレームのスタックへ積んで続ける。戻り値は最外のフレームの
+ * 完了値（Tagged）で、最適化コードの呼び出し元へそのまま返る。
+ */
+using ResumeHandler = std::function<uint64_t(std::vector<DeoptimizedFrame>& frames)>;
+
+/**
+ * @brief トランポリンが退避したレジスタ
+ */
+struct DeoptRegisterState {
+  const uint64_t* gprs;   ///< RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8〜R15 の順
+  const uint64_t* xmms;   ///< XMM0〜15（1本16バイト）
+
+  uint64_t Read(int32_t reg) const {
+    return reg < ValueLocation::kFirstXmmRegister ? gprs[reg] : xmms[2 * (reg - ValueLocation::kFirstXmmRegister)];
+  }
+};
+
 /**
  * @brief JITコードからインタープリタへの遷移を管理するクラス
+ *
+ * 最適化コードは RegisterCode でフレーム状態のテーブルと一緒に登録する。脱最適化には2通りある。
+ * - 即時: ガードの失敗箇所から EagerTrampoline() を call する。戻り先がセーフポイント。
+ * - 遅延: InvalidateCode がこのスレッドのスタックをフレームポインタでたどり、無効にした
+ *   コードへ戻るフレームの戻り先を遅延トランポリンへ書き換える。呼び出し先が戻った時点で
+ *   フレームを復元するので、それまで最適化コードには何も手を加えない（コードは解放してよい）。
+ *
+ * どちらもトランポリンが全レジスタを退避し、テーブルでインタープリタのフレームを復元して
+ * ResumeHandler に実行させ、その完了値を持って最適化フレームの呼び出し元へ戻る。
+ * 最適化コードは通常のプロローグ（RBP と RBX, R12〜R15 を退避）でフレームを作り、呼び出しを
+ * またいで生きている値は呼び出し先保存レジスタかスタックに置くこと。
+ * スタックをたどるため、ランタイムはフレームポインタを省略せずにビルドする。
  */
 class Deoptimizer {
 public:
+  struct Statistics {
+    uint64_t eagerDeoptimizations = 0;
+    uint64_t lazyDeoptimizations = 0;
+    uint64_t invalidatedCodes = 0;
+    uint64_t patchedFrames = 0;
+    uint64_t materializedObjects = 0;
+  };
+
   /**
    * @brief シングルトンインスタンスを取得
    * @return デオプティマイザのインスタンス
@@ -49,51 +136,141 @@ public:
     static Deoptimizer instance;
     return instance;
   }
-  
+
   /**
    * @brief デオプティマイズポイントを登録
    * @param codeAddress デオプティマイズポイントのコードアドレス
    * @param info デオプティマイズ情報
    */
   void RegisterDeoptPoint(void* codeAddress, const DeoptimizationInfo& info) noexcept;
-  
+
   /**
    * @brief デオプティマイズを実行
+   *
+   * codeAddress が登録済みの最適化コードの先頭なら、そのコードを無効にする（InvalidateCode）。
+   *
    * @param codeAddress デオプティマイズするポイントのコードアドレス
    * @param reason デオプティマイズの理由
    * @return デオプティマイズが成功したかどうか
    */
   bool PerformDeoptimization(void* codeAddress, DeoptimizationReason reason) noexcept;
-  
+
   /**
    * @brief コールバック関数を設定
    * @param callback デオプティマイズ時に呼び出されるコールバック関数
    */
   void SetCallback(DeoptCallback callback) noexcept;
-  
+
   /**
    * @brief デオプティマイズポイントの登録を解除
    * @param codeAddress 登録解除するコードアドレス
    */
   void UnregisterDeoptPoint(void* codeAddress) noexcept;
-  
+
   /**
    * @brief すべてのデオプティマイズポイントの登録を解除
    */
   void ClearAllDeoptPoints() noexcept;
 
+  /**
+   * @brief 最適化コードとそのフレーム状態を登録する
+   * @param code コードの先頭（実行用アドレス）
+   * @param size コードの大きさ
+   * @param table セーフポイントのフレーム状態（戻り先のオフセットで引く）
+   * @param functionId 最適化した関数
+   */
+  void RegisterCode(const void* code, size_t size, std::shared_ptr<const FrameStateTable> table,
+                    uint64_t functionId) noexcept;
+  void UnregisterCode(const void* code) noexcept;
+
+  /**
+   * @brief 最適化コードを無効にし、このスレッドでそこへ戻るフレームを遅延脱最適化する
+   * @return 戻り先を書き換えたフレームの数
+   */
+  size_t InvalidateCode(const void* code, DeoptimizationReason reason = DeoptimizationReason::BailoutRequest) noexcept;
+
+  /**
+   * @brief ガードの失敗箇所から call する即時脱最適化のトランポリン
+   * @return このアーキテクチャで使えなければ nullptr（現在は x86_64 のみ）
+   */
+  const void* EagerTrampoline() noexcept;
+
+  void SetObjectMaterializer(ObjectMaterializer* materializer) noexcept;
+
+  /**
+   * @brief 復元したフレームの実行先を設定する（設定するまで遅延脱最適化の書き換えは行わない）
+   */
+  void SetResumeHandler(ResumeHandler handler) noexcept;
+
+  /**
+   * @brief セーフポイントのフレーム状態から、インタープリタのフレームを復元する
+   *
+   * レジスタは regs、スタックスロットは fp からのオフセットで読み、表現に合わせて Value へ
+   * 箱詰めする。スカラー置換されたオブジェクトは materializer で作り直す。
+   *
+   * @return オブジェクトがあるのに materializer がない場合は false
+   */
+  static bool TranslateFrames(const FrameStateTable& table, const SafepointState& state,
+                              const DeoptRegisterState& regs, uintptr_t fp,
+                              ObjectMaterializer* materializer, std::vector<DeoptimizedFrame>& frames);
+
+  Statistics GetStatistics() const noexcept;
+
 private:
-  Deoptimizer() noexcept = default;
+  enum class EntryKind : uint32_t { Eager, Lazy };
+
+  struct CodeRange {
+    uintptr_t start;
+    size_t size;
+    std::shared_ptr<const FrameStateTable> table;
+    uint64_t functionId;
+  };
+
+  // 戻り先を書き換えたフレーム（キーは戻り先のスロットのアドレス）
+  struct PatchedFrame {
+    uintptr_t returnAddress;
+    uintptr_t codeStart;
+    std::shared_ptr<const FrameStateTable> table;
+    uint64_t functionId;
+    DeoptimizationReason reason;
+  };
+
+  Deoptimizer() noexcept;
   ~Deoptimizer() noexcept = default;
   Deoptimizer(const Deoptimizer&) = delete;
   Deoptimizer& operator=(const Deoptimizer&) = delete;
-  
+
+  /**
+   * @brief トランポリンから呼ばれる
+   * @param savedRegisters 退避した汎用レジスタ（続けて XMM レジスタ）
+   * @param fp 最適化コードのフレームポインタ
+   * @param kind 即時か遅延か
+   * @param pcSlot 即時なら戻り先、遅延なら書き換えたスロットのアドレス
+   * @return 最適化フレームの呼び出し元へ返す完了値
+   */
+  static uint64_t TrampolineEntry(const uint64_t* savedRegisters, uintptr_t fp, uint32_t kind,
+                                  const uintptr_t* pcSlot) noexcept;
+
+  // 以下は m_mutex を保持して呼ぶ
+  const CodeRange* FindCodeLocked(uintptr_t pc) const;
+  bool EnsureTrampolinesLocked();
+
   // コードアドレスからデオプティマイズ情報へのマップ
   std::unordered_map<void*, DeoptimizationInfo> m_deoptInfoMap;
-  
+
   // デオプティマイズ時に呼び出されるコールバック
   DeoptCallback m_callback;
+
+  mutable std::mutex m_mutex;
+  std::vector<CodeRange> m_codeRanges;                          // start の昇順
+  std::unordered_map<uintptr_t, PatchedFrame> m_patchedFrames;
+  ObjectMaterializer* m_materializer;
+  ResumeHandler m_resumeHandler;
+  void* m_eagerTrampoline;
+  void* m_lazyTrampoline;
+  bool m_trampolinesFailed;
+  Statistics m_stats;
 };
 
 }  // namespace core
-}  // namespace aerojs 
\ No newline at end of file
+}  // namespace aerojs
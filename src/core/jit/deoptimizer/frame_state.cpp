@@ -0,0 +1,360 @@
+/**
+ * @file frame_state.cpp
+ * @brief セーフポイントのフレーム状態のエンコードとデコード
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "frame_state.h"
+
+#include <algorithm>
+
+namespace aerojs {
+namespace core {
+
+namespace {
+
+// 値1つの先頭バイト: 下位3ビットが種類、続く2ビットが表現
+enum ValueTag : uint8_t {
+  kTagDead = 0,
+  kTagRegister = 1,
+  kTagStackSlot = 2,   // 続けて (オフセット / 8) を符号付き LEB128 で
+  kTagConstant = 3,
+  kTagObject = 4,      // 続けてシェイプ番号、フィールド数、フィールドの値
+  kTagObjectRef = 5
+};
+
+void WriteULEB(std::vector<uint8_t>& out, uint64_t value) {
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    out.push_back(value ? (byte | 0x80) : byte);
+  } while (value);
+}
+
+void WriteSLEB(std::vector<uint8_t>& out, int64_t value) {
+  for (;;) {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    bool done = (value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40));
+    out.push_back(done ? byte : (byte | 0x80));
+    if (done) {
+      return;
+    }
+  }
+}
+
+class Reader {
+public:
+  Reader(const std::vector<uint8_t>& data, size_t offset) : m_data(data), m_pos(offset) {}
+
+  bool ok() const { return m_ok; }
+
+  uint8_t ReadByte() {
+    if (m_pos >= m_data.size()) {
+      m_ok = false;
+      return 0;
+    }
+    return m_data[m_pos++];
+  }
+
+  uint64_t ReadULEB() {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = ReadByte();
+      result |= uint64_t(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return result;
+      }
+    }
+    m_ok = false;
+    return 0;
+  }
+
+  int64_t ReadSLEB() {
+    int64_t result = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+      byte = ReadByte();
+      result |= int64_t(byte & 0x7F) << shift;
+      shift += 7;
+    } while ((byte & 0x80) && shift < 64);
+    if (shift < 64 && (byte & 0x40)) {
+      result |= -(int64_t(1) << shift);
+    }
+    return result;
+  }
+
+private:
+  const std::vector<uint8_t>& m_data;
+  size_t m_pos;
+  bool m_ok = true;
+};
+
+bool ReadValue(Reader& reader, SafepointState& state, size_t constantCount, ValueLocation& out) {
+  uint8_t tag = reader.ReadByte();
+  out.representation = static_cast<ValueRepresentation>((tag >> 3) & 0x3);
+  switch (tag & 0x7) {
+    case kTagDead:
+      out.kind = ValueLocationKind::Dead;
+      out.value = 0;
+      return reader.ok();
+    case kTagRegister:
+      out.kind = ValueLocationKind::Register;
+      out.value = reader.ReadByte();
+      return reader.ok() && out.value < 32;
+    case kTagStackSlot:
+      out.kind = ValueLocationKind::StackSlot;
+      out.value = static_cast<int32_t>(reader.ReadSLEB() * 8);
+      return reader.ok();
+    case kTagConstant:
+      out.kind = ValueLocationKind::Constant;
+      out.value = static_cast<int32_t>(reader.ReadULEB());
+      return reader.ok() && static_cast<size_t>(out.value) < constantCount;
+    case kTagObject: {
+      size_t id = state.objects.size();
+      state.objects.emplace_back();
+      state.objects[id].shapeId = static_cast<uint32_t>(reader.ReadULEB());
+      uint64_t fieldCount = reader.ReadULEB();
+      if (!reader.ok()) {
+        return false;
+      }
+      // フィールドの中で定義されるオブジェクトがあるので、要素への参照は持ち続けない
+      std::vector<ValueLocation> fields(fieldCount);
+      for (ValueLocation& field : fields) {
+        if (!ReadValue(reader, state, constantCount, field)) {
+          return false;
+        }
+      }
+      state.objects[id].fields = std::move(fields);
+      out.kind = ValueLocationKind::Object;
+      out.value = static_cast<int32_t>(id);
+      return true;
+    }
+    case kTagObjectRef:
+      out.kind = ValueLocationKind::Object;
+      out.value = static_cast<int32_t>(reader.ReadULEB());
+      return reader.ok() && static_cast<size_t>(out.value) < state.objects.size();
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+// FrameStateTable
+//-----------------------------------------------------------------------------
+
+const FrameStateTable::Entry* FrameStateTable::FindEntry(uint32_t pcOffset) const {
+  auto it = std::lower_bound(m_entries.begin(), m_entries.end(), pcOffset,
+                             [](const Entry& entry, uint32_t pc) { return entry.pcOffset < pc; });
+  if (it == m_entries.end() || it->pcOffset != pcOffset) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+bool FrameStateTable::Lookup(uint32_t pcOffset, SafepointState& state) const {
+  const Entry* entry = FindEntry(pcOffset);
+  if (!entry) {
+    return false;
+  }
+
+  state.frames.clear();
+  state.objects.clear();
+
+  Reader reader(m_data, entry->dataOffset);
+  state.kind = static_cast<SafepointKind>(reader.ReadULEB());
+  state.speculation = static_cast<SpeculationKind>(reader.ReadULEB());
+  uint64_t frameCount = reader.ReadULEB();
+  if (!reader.ok() || state.speculation >= SpeculationKind::Count) {
+    return false;
+  }
+  state.frames.resize(frameCount);
+  for (SafepointState::Frame& frame : state.frames) {
+    frame.functionId = reader.ReadULEB();
+    frame.bytecodeOffset = static_cast<uint32_t>(reader.ReadULEB());
+    frame.localCount = static_cast<uint32_t>(reader.ReadULEB());
+    frame.stackCount = static_cast<uint32_t>(reader.ReadULEB());
+    if (!reader.ok()) {
+      return false;
+    }
+    frame.values.resize(size_t(frame.localCount) + frame.stackCount);
+    for (ValueLocation& value : frame.values) {
+      if (!ReadValue(reader, state, m_constants.size(), value)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// FrameStateBuilder
+//-----------------------------------------------------------------------------
+
+void FrameStateBuilder::BeginSafepoint(uint32_t pcOffset, SafepointKind kind, SpeculationKind speculation) {
+  if (m_open) {
+    CloseSafepoint();
+  }
+  m_open = true;
+  m_currentPc = pcOffset;
+  m_currentKind = kind;
+  m_currentSpeculation = speculation;
+  m_frameCount = 0;
+  m_objectCount = 0;
+  m_current.clear();
+  m_pendingSlots.clear();
+}
+
+void FrameStateBuilder::BeginFrame(uint64_t functionId, uint32_t bytecodeOffset,
+                                   uint32_t localCount, uint32_t stackCount) {
+  if (!m_open || !m_pendingSlots.empty()) {
+    m_valid = false;
+    return;
+  }
+  m_frameCount++;
+  WriteULEB(m_current, functionId);
+  WriteULEB(m_current, bytecodeOffset);
+  WriteULEB(m_current, localCount);
+  WriteULEB(m_current, stackCount);
+  if (localCount + stackCount > 0) {
+    m_pendingSlots.push_back(localCount + stackCount);
+  }
+}
+
+bool FrameStateBuilder::ConsumeSlot() {
+  if (m_pendingSlots.empty()) {
+    m_valid = false;
+    return false;
+  }
+  if (--m_pendingSlots.back() == 0) {
+    m_pendingSlots.pop_back();
+  }
+  return true;
+}
+
+void FrameStateBuilder::AddValue(const ValueLocation& location) {
+  if (!ConsumeSlot()) {
+    return;
+  }
+  uint8_t rep = static_cast<uint8_t>(location.representation) << 3;
+  switch (location.kind) {
+    case ValueLocationKind::Dead:
+      m_current.push_back(kTagDead);
+      break;
+    case ValueLocationKind::Register:
+      if (location.value < 0 || location.value >= 32) {
+        m_valid = false;
+        return;
+      }
+      m_current.push_back(kTagRegister | rep);
+      m_current.push_back(static_cast<uint8_t>(location.value));
+      break;
+    case ValueLocationKind::StackSlot:
+      // スピルスロットは8バイト境界にあるので、8で割って詰める
+      if (location.value % 8 != 0) {
+        m_valid = false;
+        return;
+      }
+      m_current.push_back(kTagStackSlot | rep);
+      WriteSLEB(m_current, location.value / 8);
+      break;
+    case ValueLocationKind::Constant:
+      if (location.value < 0 || static_cast<size_t>(location.value) >= m_constants.size()) {
+        m_valid = false;
+        return;
+      }
+      m_current.push_back(kTagConstant | rep);
+      WriteULEB(m_current, static_cast<uint32_t>(location.value));
+      break;
+    case ValueLocationKind::Object:
+      if (location.value < 0 || static_cast<uint32_t>(location.value) >= m_objectCount) {
+        m_valid = false;
+        return;
+      }
+      m_current.push_back(kTagObjectRef);
+      WriteULEB(m_current, static_cast<uint32_t>(location.value));
+      break;
+  }
+}
+
+void FrameStateBuilder::AddConstant(uint64_t taggedBits) {
+  auto inserted = m_constantIndex.emplace(taggedBits, static_cast<uint32_t>(m_constants.size()));
+  if (inserted.second) {
+    m_constants.push_back(taggedBits);
+  }
+  AddValue({ValueLocationKind::Constant, ValueRepresentation::Tagged,
+            static_cast<int32_t>(inserted.first->second)});
+}
+
+uint32_t FrameStateBuilder::AddObject(uint32_t shapeId, uint32_t fieldCount) {
+  uint32_t id = m_objectCount++;
+  if (!ConsumeSlot()) {
+    return id;
+  }
+  m_current.push_back(kTagObject);
+  WriteULEB(m_current, shapeId);
+  WriteULEB(m_current, fieldCount);
+  if (fieldCount > 0) {
+    m_pendingSlots.push_back(fieldCount);
+  }
+  return id;
+}
+
+void FrameStateBuilder::AddObjectReference(uint32_t objectId) {
+  AddValue({ValueLocationKind::Object, ValueRepresentation::Tagged, static_cast<int32_t>(objectId)});
+}
+
+void FrameStateBuilder::CloseSafepoint() {
+  if (!m_pendingSlots.empty()) {
+    m_valid = false;
+  }
+  PendingSafepoint safepoint;
+  safepoint.pcOffset = m_currentPc;
+  WriteULEB(safepoint.bytes, static_cast<uint8_t>(m_currentKind));
+  WriteULEB(safepoint.bytes, static_cast<uint8_t>(m_currentSpeculation));
+  WriteULEB(safepoint.bytes, m_frameCount);
+  safepoint.bytes.insert(safepoint.bytes.end(), m_current.begin(), m_current.end());
+  m_safepoints.push_back(std::move(safepoint));
+  m_current.clear();
+  m_pendingSlots.clear();
+  m_open = false;
+}
+
+std::shared_ptr<FrameStateTable> FrameStateBuilder::Finish() {
+  if (m_open) {
+    CloseSafepoint();
+  }
+
+  std::shared_ptr<FrameStateTable> table;
+  if (m_valid) {
+    std::stable_sort(m_safepoints.begin(), m_safepoints.end(),
+                     [](const PendingSafepoint& a, const PendingSafepoint& b) { return a.pcOffset < b.pcOffset; });
+    table = std::make_shared<FrameStateTable>();
+    table->m_entries.reserve(m_safepoints.size());
+    for (const PendingSafepoint& safepoint : m_safepoints) {
+      // 同じ戻り先に2つのセーフポイントは置けない
+      if (!table->m_entries.empty() && table->m_entries.back().pcOffset == safepoint.pcOffset) {
+        table.reset();
+        break;
+      }
+      table->m_entries.push_back({safepoint.pcOffset, static_cast<uint32_t>(table->m_data.size())});
+      table->m_data.insert(table->m_data.end(), safepoint.bytes.begin(), safepoint.bytes.end());
+    }
+    if (table) {
+      table->m_constants = std::move(m_constants);
+    }
+  }
+
+  m_safepoints.clear();
+  m_constants.clear();
+  m_constantIndex.clear();
+  m_valid = true;
+  return table;
+}
+
+}  // namespace core
+}  // namespace aerojs
@@ -0,0 +1,194 @@
+/**
+ * @file frame_state.h
+ * @brief 最適化コードのセーフポイントごとのフレーム状態（脱最適化用メタデータ）
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "speculation.h"
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief インタプリタのスロットの値がどこにあるか
+ */
+enum class ValueLocationKind : uint8_t {
+  Dead,       ///< このセーフポイント以降で使われない（undefined として復元する）
+  Register,   ///< レジスタ（0〜15: 汎用レジスタ、16〜31: XMM0〜15）
+  StackSlot,  ///< フレームポインタからのオフセット
+  Constant,   ///< 定数プールの値（Tagged のビット列）
+  Object      ///< スカラー置換されたオブジェクト（脱最適化時に再実体化する）
+};
+
+/**
+ * @brief 値の表現（復元時に Value へ箱詰めする方法）
+ */
+enum class ValueRepresentation : uint8_t {
+  Tagged,   ///< NaN-boxing のビット列そのまま
+  Int32,    ///< 下位32ビットの符号付き整数
+  Double,   ///< double のビット列
+  Boolean   ///< 0 以外を true
+};
+
+struct ValueLocation {
+  ValueLocationKind kind = ValueLocationKind::Dead;
+  ValueRepresentation representation = ValueRepresentation::Tagged;
+  int32_t value = 0;  ///< レジスタ番号、オフセット、定数プールの番号、オブジェクト番号のいずれか
+
+  static constexpr int32_t kFirstXmmRegister = 16;
+
+  static ValueLocation InRegister(int32_t reg, ValueRepresentation rep = ValueRepresentation::Tagged) {
+    return {ValueLocationKind::Register, rep, reg};
+  }
+  static ValueLocation OnStack(int32_t frameOffset, ValueRepresentation rep = ValueRepresentation::Tagged) {
+    return {ValueLocationKind::StackSlot, rep, frameOffset};
+  }
+  static ValueLocation DeadValue() {
+    return {};
+  }
+};
+
+/**
+ * @brief セーフポイントの種類
+ */
+enum class SafepointKind : uint8_t {
+  Call,   ///< 呼び出しの戻り先。遅延脱最適化では戻り値（RAX）を最内フレームのスタックへ積む
+  Guard   ///< 型ガードなどの失敗箇所。即時の脱最適化トランポリンを呼ぶ
+};
+
+/**
+ * @brief 1つのセーフポイントのフレーム状態（デコード後）
+ *
+ * frames は外側（最適化コードの関数）から順に並び、インライン化された呼び出し先が続く。
+ * 各フレームの values はローカル変数 localCount 個、オペランドスタック stackCount 個の順。
+ * Object の value は objects の番号で、同じオブジェクトを複数のスロットや
+ * フィールドが指してもよい（循環も含む）。
+ */
+struct SafepointState {
+  struct Frame {
+    uint64_t functionId = 0;
+    uint32_t bytecodeOffset = 0;
+    uint32_t localCount = 0;
+    uint32_t stackCount = 0;
+    std::vector<ValueLocation> values;
+  };
+
+  struct MaterializedObject {
+    uint32_t shapeId = 0;
+    std::vector<ValueLocation> fields;
+  };
+
+  SafepointKind kind = SafepointKind::Call;
+  SpeculationKind speculation = SpeculationKind::None;  ///< Guard が守っている投機（最内フレームの位置のもの）
+  std::vector<Frame> frames;
+  std::vector<MaterializedObject> objects;
+};
+
+/**
+ * @brief 最適化コード1つ分のフレーム状態のテーブル
+ *
+ * セーフポイントは機械語オフセット（呼び出しの戻り先のオフセット）で引く。
+ * 本体は LEB128 のバイト列で、値1つは多くの場合2バイトに収まる。
+ * 同じ定数は定数プールで共有する。
+ */
+class FrameStateTable {
+public:
+  /**
+   * @brief セーフポイントのフレーム状態をデコードする
+   * @return pcOffset にセーフポイントがなければ false
+   */
+  bool Lookup(uint32_t pcOffset, SafepointState& state) const;
+
+  bool HasSafepoint(uint32_t pcOffset) const { return FindEntry(pcOffset) != nullptr; }
+
+  uint64_t Constant(size_t index) const { return m_constants[index]; }
+
+  size_t SafepointCount() const { return m_entries.size(); }
+  size_t EncodedSize() const {
+    return m_data.size() + m_entries.size() * sizeof(Entry) + m_constants.size() * sizeof(uint64_t);
+  }
+
+private:
+  friend class FrameStateBuilder;
+
+  struct Entry {
+    uint32_t pcOffset;
+    uint32_t dataOffset;
+  };
+
+  const Entry* FindEntry(uint32_t pcOffset) const;
+
+  std::vector<Entry> m_entries;     // pcOffset の昇順
+  std::vector<uint8_t> m_data;
+  std::vector<uint64_t> m_constants;
+};
+
+/**
+ * @brief コード生成中にフレーム状態を記録する
+ *
+ * 使い方（セーフポイントごと）:
+ *   BeginSafepoint(pc, kind, speculation);
+ *   BeginFrame(...);  値を localCount + stackCount 個追加;  （インライン化したフレームも同様）
+ * 値の追加は AddValue / AddConstant / AddObject（続けてフィールドをその数だけ追加）/
+ * AddObjectReference（既出のオブジェクトを指す）で行う。
+ */
+class FrameStateBuilder {
+public:
+  void BeginSafepoint(uint32_t pcOffset, SafepointKind kind,
+                      SpeculationKind speculation = SpeculationKind::None);
+  void BeginFrame(uint64_t functionId, uint32_t bytecodeOffset, uint32_t localCount, uint32_t stackCount);
+
+  void AddValue(const ValueLocation& location);
+  void AddConstant(uint64_t taggedBits);
+
+  /**
+   * @brief スカラー置換したオブジェクトを追加する
+   * @return オブジェクト番号（同じセーフポイントの AddObjectReference に渡す）
+   */
+  uint32_t AddObject(uint32_t shapeId, uint32_t fieldCount);
+  void AddObjectReference(uint32_t objectId);
+
+  /**
+   * @brief テーブルを作る（記録した内容は空になる）
+   * @return 値の数がフレームやオブジェクトの宣言と合わなければ nullptr
+   */
+  std::shared_ptr<FrameStateTable> Finish();
+
+  bool Empty() const { return m_safepoints.empty() && !m_open; }
+
+private:
+  struct PendingSafepoint {
+    uint32_t pcOffset;
+    std::vector<uint8_t> bytes;
+  };
+
+  void CloseSafepoint();
+  bool ConsumeSlot();
+
+  std::vector<PendingSafepoint> m_safepoints;
+  std::vector<uint8_t> m_current;          // 開いているセーフポイントのフレーム部分
+  uint32_t m_currentPc = 0;
+  SafepointKind m_currentKind = SafepointKind::Call;
+  SpeculationKind m_currentSpeculation = SpeculationKind::None;
+  uint32_t m_frameCount = 0;
+  uint32_t m_objectCount = 0;
+  bool m_open = false;
+  bool m_valid = true;
+
+  // 埋まっていない値の数（フレーム、オブジェクトの入れ子ごと）
+  std::vector<uint32_t> m_pendingSlots;
+
+  std::vector<uint64_t> m_constants;
+  std::unordered_map<uint64_t, uint32_t> m_constantIndex;
+};
+
+}  // namespace core
+}  // namespace aerojs
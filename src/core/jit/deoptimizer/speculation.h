@@ -0,0 +1,119 @@
+/**
+ * @file speculation.h
+ * @brief 投機の種類と、バイトコード位置ごとの投機の禁止リスト
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief 最適化コードがガードで守っている投機の種類
+ *
+ * ガードのセーフポイントに記録し、脱最適化したときにどの投機が外れたかを知るのに使う。
+ */
+enum class SpeculationKind : uint8_t {
+  None,         ///< 投機ではない（呼び出しの戻り先など）
+  Int32,        ///< 値が int32 である（int32 特殊化）
+  Double,       ///< 値が double である
+  Overflow,     ///< int32 演算が溢れない
+  ShapeGuard,   ///< オブジェクトのシェイプが記録したものと同じ
+  BoundsCheck,  ///< 配列アクセスが範囲内
+  CallTarget,   ///< 呼び出し先が記録した関数と同じ（インライン化の前提）
+  Count
+};
+
+inline const char* SpeculationKindToString(SpeculationKind kind) noexcept {
+  switch (kind) {
+    case SpeculationKind::None: return "None";
+    case SpeculationKind::Int32: return "Int32";
+    case SpeculationKind::Double: return "Double";
+    case SpeculationKind::Overflow: return "Overflow";
+    case SpeculationKind::ShapeGuard: return "ShapeGuard";
+    case SpeculationKind::BoundsCheck: return "BoundsCheck";
+    case SpeculationKind::CallTarget: return "CallTarget";
+    default: return "Unknown";
+  }
+}
+
+/**
+ * @brief バイトコード位置ごとに、外れ続けた投機を禁止する
+ *
+ * 同じ位置で同じ種類の投機が threshold 回外れたら、その位置ではその投機を禁止する。
+ * 再コンパイルでは禁止された投機を使わず、汎用のコードを出す（int32 特殊化しない、
+ * シェイプガードを置かずにインラインキャッシュを使う、など）。
+ * 禁止は関数が捨てられるまで解除しない。
+ */
+class SpeculationBlacklist {
+public:
+  /**
+   * @brief 投機の失敗を記録する
+   * @return この失敗でその位置の投機が新たに禁止されたら true
+   */
+  bool RecordFailure(uint32_t bytecodeOffset, SpeculationKind kind, uint32_t threshold) {
+    if (kind == SpeculationKind::None || kind >= SpeculationKind::Count) {
+      return false;
+    }
+    Site& site = m_sites[bytecodeOffset];
+    if (site.disallowed & Bit(kind)) {
+      return false;
+    }
+    uint8_t& failures = site.failures[static_cast<size_t>(kind)];
+    if (failures < UINT8_MAX) {
+      failures++;
+    }
+    if (failures < threshold) {
+      return false;
+    }
+    site.disallowed |= Bit(kind);
+    m_disallowedCount++;
+    return true;
+  }
+
+  void Disallow(uint32_t bytecodeOffset, SpeculationKind kind) {
+    if (kind == SpeculationKind::None || kind >= SpeculationKind::Count) {
+      return;
+    }
+    Site& site = m_sites[bytecodeOffset];
+    if (!(site.disallowed & Bit(kind))) {
+      site.disallowed |= Bit(kind);
+      m_disallowedCount++;
+    }
+  }
+
+  bool IsAllowed(uint32_t bytecodeOffset, SpeculationKind kind) const {
+    auto it = m_sites.find(bytecodeOffset);
+    return it == m_sites.end() || !(it->second.disallowed & Bit(kind));
+  }
+
+  /// 禁止された（位置, 種類）の組の数
+  size_t DisallowedCount() const { return m_disallowedCount; }
+  bool Empty() const { return m_disallowedCount == 0; }
+
+  void Clear() {
+    m_sites.clear();
+    m_disallowedCount = 0;
+  }
+
+private:
+  static constexpr size_t kKindCount = static_cast<size_t>(SpeculationKind::Count);
+
+  struct Site {
+    uint8_t failures[kKindCount] = {};
+    uint8_t disallowed = 0;   // SpeculationKind ごとのビット
+  };
+
+  static uint8_t Bit(SpeculationKind kind) { return static_cast<uint8_t>(1u << static_cast<uint8_t>(kind)); }
+
+  std::unordered_map<uint32_t, Site> m_sites;
+  size_t m_disallowedCount = 0;
+};
+
+}  // namespace core
+}  // namespace aerojs
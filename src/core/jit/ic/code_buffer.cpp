@@ -6,6 +6,7 @@
  */
 
 #include "inline_cache.h"
+#include "../code_space.h"
 #include <cstring>
 #include <stdexcept>
 
@@ -105,6 +106,25 @@ bool CodeBuffer::makeExecutable() {
         return true;
     }
     
+    // 二重マッピングのコード領域が使えれば、そちらへ複写して作業用バッファを捨てる。
+    // 以後のパッチは書き込み用の別名から行うので、ページ保護を切り替えずに済む
+    CodeSpace& codeSpace = CodeSpace::shared();
+    if (codeSpace.isAvailable()) {
+        if (void* executable = codeSpace.allocate(_size)) {
+            std::memcpy(codeSpace.writableAddress(executable), _buffer, _size);
+            CodeSpace::flushRange(executable, _size);
+#ifdef _WIN32
+            VirtualFree(_buffer, 0, MEM_RELEASE);
+#else
+            munmap(_buffer, _capacity);
+#endif
+            _buffer = static_cast<uint8_t*>(executable);
+            _capacity = _size;
+            _executable = true;
+            return true;
+        }
+    }
+    
 #ifdef _WIN32
     // Windowsではページ属性を変更
     DWORD oldProtect;
@@ -152,13 +172,16 @@ void CodeBuffer::release() {
         return;
     }
     
+    // 二重マッピングのコード領域へ移したバッファはそちらへ返す
+    if (!CodeSpace::shared().free(_buffer)) {
 #ifdef _WIN32
-    // Windowsではメモリを解放
-    VirtualFree(_buffer, 0, MEM_RELEASE);
+        // Windowsではメモリを解放
+        VirtualFree(_buffer, 0, MEM_RELEASE);
 #else
-    // UNIXシステムではメモリマッピングを解除
-    munmap(_buffer, _capacity);
+        // UNIXシステムではメモリマッピングを解除
+        munmap(_buffer, _capacity);
 #endif
+    }
     
     _buffer = nullptr;
     _size = 0;
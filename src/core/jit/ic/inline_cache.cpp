@@ -6,10 +6,14 @@
  */
 
 #include "inline_cache.h"
+#include "megamorphic_stub_cache.h"
 #include "../../context.h"
+#include "../../vm/bytecode/feedback_vector.h"
 #include "../../runtime/values/object.h"
 #include "../../runtime/values/value.h"
 #include "../code_cache.h"
+#include "../code_space.h"
+#include "../optimizing/compilation_dependencies.h"
 #include <algorithm>
 #include <cassert>
 
@@ -193,6 +197,15 @@ MethodCache* InlineCacheManager::createMethodCache(uint64_t siteId) {
     return result;
 }
 
+// メガモーフィックなサイトで見つかったプロパティを共有のスタブキャッシュに登録
+static void insertMegamorphicEntry(uint64_t shapeId, const std::string& propName, uint32_t index, bool isInlineProperty) {
+    core::MegamorphicStubCache::instance().insert(
+        shapeId, core::MegamorphicStubCache::internKey(propName),
+        core::encodePropertyHandler(isInlineProperty ? core::PropertyHandlerKind::kInlineField
+                                                     : core::PropertyHandlerKind::kOutOfLineField,
+                                    index));
+}
+
 bool InlineCacheManager::handlePropertyAccess(uint64_t siteId, Object* obj, const std::string& propName, Value& result) {
     if (!obj) {
         return false;
@@ -221,6 +234,21 @@ bool InlineCacheManager::handlePropertyAccess(uint64_t siteId, Object* obj, cons
     return true;
 }
 
+    // メガモーフィックなサイトは他のサイトが登録したエントリを使える
+    if (cache->getState() == CacheEntry::State::Megamorphic) {
+        uint32_t handler;
+        if (core::MegamorphicStubCache::instance().lookup(
+                shapeId, core::MegamorphicStubCache::internKey(propName), handler)) {
+            uint32_t slot = core::propertyHandlerIndex(handler);
+            if (core::propertyHandlerKind(handler) == core::PropertyHandlerKind::kInlineField) {
+                result = obj->getInlineProperty(slot);
+            } else {
+                result = obj->getProperty(slot);
+            }
+            return true;
+        }
+    }
+    
     // キャッシュミス - プロパティを検索
     uint32_t index;
     bool found = obj->findProperty(propName, index, isInlineProperty);
@@ -233,9 +261,19 @@ bool InlineCacheManager::handlePropertyAccess(uint64_t siteId, Object* obj, cons
             result = obj->getProperty(index);
         }
         
+        // メガモーフィックなサイトはサイトのキャッシュではなく共有のスタブキャッシュに登録する
+        // （スタブは生成済みなのでパッチも不要）
+        if (cache->getState() == CacheEntry::State::Megamorphic) {
+            insertMegamorphicEntry(shapeId, propName, index, isInlineProperty);
+            return true;
+        }
+        
         // キャッシュに追加
         cache->addEntry(shapeId, index, isInlineProperty);
         
+        // スタブの生成と各サイトのパッチの命令キャッシュのフラッシュは最後に1回で行う
+        core::CodeSpace::FlushScope flushScope;
+        
         // キャッシュが成長したらスタブコードを生成
         if (cache->getState() == CacheEntry::State::Monomorphic) {
             // モノモーフィックスタブの生成
@@ -243,6 +281,12 @@ bool InlineCacheManager::handlePropertyAccess(uint64_t siteId, Object* obj, cons
         } else if (cache->getState() == CacheEntry::State::Polymorphic) {
             // ポリモーフィックスタブの生成
             generatePropertyStub(cache, siteId);
+        } else if (cache->getState() == CacheEntry::State::Megamorphic) {
+            // メガモーフィックに遷移した: キーを記録してからスタブキャッシュを引くスタブを生成
+            core::MegamorphicStubCache::instance().registerSiteKey(
+                siteId, core::MegamorphicStubCache::internKey(propName));
+            insertMegamorphicEntry(shapeId, propName, index, isInlineProperty);
+            generatePropertyStub(cache, siteId);
         }
         
         // コードパッチの適用
@@ -263,6 +307,9 @@ bool InlineCacheManager::handlePropertyAccess(uint64_t siteId, Object* obj, cons
     // ミスが閾値を超えたらメガモーフィックに遷移
     if (cache->getMissCount() > CacheEntry::MISS_THRESHOLD) {
         cache->setState(CacheEntry::State::Megamorphic);
+        // スタブがスタブキャッシュを直接引けるようサイトのプロパティキーを記録しておく
+        core::MegamorphicStubCache::instance().registerSiteKey(
+            siteId, core::MegamorphicStubCache::internKey(propName));
         generatePropertyStub(cache, siteId);
     }
     
@@ -304,6 +351,9 @@ bool InlineCacheManager::handleMethodCall(uint64_t siteId, Object* obj, const st
             // キャッシュに追加
             cache->addEntry(shapeId, functionId, outCodeAddress);
             
+            // スタブの生成と各サイトのパッチの命令キャッシュのフラッシュは最後に1回で行う
+            core::CodeSpace::FlushScope flushScope;
+            
             // キャッシュが成長したらスタブコードを生成
             if (cache->getState() == CacheEntry::State::Monomorphic) {
                 // モノモーフィックスタブの生成
@@ -521,6 +571,14 @@ void InlineCacheManager::generateMethodStub(MethodCache* cache, uint64_t siteId)
     _methodStubs[siteId] = std::move(stubCode);
 }
 
+// シェイプが使われなくなったときの無効化フック（Object がプロトタイプのレイアウト変更で呼ぶ）
+// 通常の遷移は新しいシェイプIDになるため、古いシェイプのエントリはそのまま正しい
+void InlineCacheManager::invalidateForShape(ShapeID shapeId) {
+    core::MegamorphicStubCache::instance().invalidateShape(shapeId);
+    // このシェイプを前提にコンパイル中の最適化コードは導入時に破棄される
+    core::CompilationDependencies::instance().invalidateShape(shapeId);
+}
+
 // キャッシュミスハンドラ（スタブが呼び出す関数）
 void* InlineCacheManager::handlePropertyMiss(uint64_t siteId, Object* obj, const std::string& propName) {
     // インスタンスを取得
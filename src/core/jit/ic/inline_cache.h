@@ -122,6 +122,9 @@ inline bool operator&(ICFlags a, ICFlags b) {
 
 /**
  * @brief オブジェクト形状ID型
+ *
+ * IDはプロセス内で一意で再利用しない（Object::getShapeId）。エンジンをまたいで
+ * 共有する MegamorphicStubCache や CompilationDependencies のキーにそのまま使える。
  */
 using ShapeID = uint64_t;
 
@@ -1196,7 +1199,8 @@ public:
     
     // キャッシュ無効化
     void invalidateAll();
-    void invalidateForShape(ShapeID shapeId);
+    // プロセス共通の表だけを触るので、マネージャを持たないランタイムからも呼べる
+    static void invalidateForShape(ShapeID shapeId);
     void invalidateForProperty(const std::string& propertyName);
     
     // キャッシュポリシー設定
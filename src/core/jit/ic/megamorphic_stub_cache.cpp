@@ -0,0 +1,141 @@
+/**
+ * @file megamorphic_stub_cache.cpp
+ * @brief メガモーフィックなプロパティアクセス用スタブキャッシュの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "megamorphic_stub_cache.h"
+
+namespace aerojs {
+namespace core {
+
+MegamorphicStubCache& MegamorphicStubCache::instance() {
+    // 生成コードが表のアドレスを埋め込むため破棄しない
+    static MegamorphicStubCache* cache = new MegamorphicStubCache();
+    return *cache;
+}
+
+uint64_t MegamorphicStubCache::internKey(const std::string& name) {
+    static std::mutex internMutex;
+    static auto* names = new std::unordered_set<std::string>();
+
+    std::lock_guard<std::mutex> lock(internMutex);
+    // unordered_set の要素のアドレスは再ハッシュ後も変わらない
+    const std::string& interned = *names->insert(name).first;
+    return reinterpret_cast<uint64_t>(&interned);
+}
+
+bool MegamorphicStubCache::readEntry(const Entry& entry, uint64_t shape, uint64_t key, uint32_t& handler) {
+    uint32_t before = entry.sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+        return false;
+    }
+    uint64_t entryKey = entry.key.load(std::memory_order_relaxed);
+    uint64_t entryShape = entry.shape.load(std::memory_order_relaxed);
+    uint32_t entryHandler = entry.handler.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (entry.sequence.load(std::memory_order_relaxed) != before) {
+        return false;
+    }
+    if (entryKey != key || entryShape != shape) {
+        return false;
+    }
+    handler = entryHandler;
+    return true;
+}
+
+void MegamorphicStubCache::writeEntry(Entry& entry, uint64_t shape, uint64_t key, uint32_t handler) {
+    uint32_t sequence = entry.sequence.load(std::memory_order_relaxed);
+    entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.key.store(key, std::memory_order_relaxed);
+    entry.shape.store(shape, std::memory_order_relaxed);
+    entry.handler.store(handler, std::memory_order_relaxed);
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool MegamorphicStubCache::lookup(uint64_t shape, uint64_t key, uint32_t& handler) {
+    uint32_t hash = keyHash(key);
+    uint32_t primary = primaryIndex(shape, hash);
+    if (readEntry(m_primary[primary], shape, key, handler) ||
+        readEntry(m_secondary[secondaryIndex(primary, hash)], shape, key, handler)) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void MegamorphicStubCache::insert(uint64_t shape, uint64_t key, uint32_t handler) {
+    if (key == 0) {
+        return;
+    }
+    uint32_t hash = keyHash(key);
+    uint32_t primary = primaryIndex(shape, hash);
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    Entry& entry = m_primary[primary];
+    uint64_t oldKey = entry.key.load(std::memory_order_relaxed);
+    uint64_t oldShape = entry.shape.load(std::memory_order_relaxed);
+
+    // 別の組が入っていれば二次表へ移す（一次表の同じ位置から来たので二次表の位置も読み手と一致する）
+    if (oldKey != 0 && (oldKey != key || oldShape != shape)) {
+        Entry& victim = m_secondary[secondaryIndex(primary, keyHash(oldKey))];
+        writeEntry(victim, oldShape, oldKey, entry.handler.load(std::memory_order_relaxed));
+        m_evictions++;
+    }
+    writeEntry(entry, shape, key, handler);
+    m_inserts++;
+}
+
+void MegamorphicStubCache::invalidateShape(uint64_t shape) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    auto invalidateTable = [&](Entry* table, uint32_t size) {
+        for (uint32_t i = 0; i < size; ++i) {
+            Entry& entry = table[i];
+            if (entry.key.load(std::memory_order_relaxed) != 0 &&
+                entry.shape.load(std::memory_order_relaxed) == shape) {
+                writeEntry(entry, 0, 0, 0);
+                m_invalidations++;
+            }
+        }
+    };
+    invalidateTable(m_primary, kPrimarySize);
+    invalidateTable(m_secondary, kSecondarySize);
+}
+
+void MegamorphicStubCache::clear() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    for (Entry& entry : m_primary) {
+        writeEntry(entry, 0, 0, 0);
+    }
+    for (Entry& entry : m_secondary) {
+        writeEntry(entry, 0, 0, 0);
+    }
+}
+
+void MegamorphicStubCache::registerSiteKey(uint64_t siteId, uint64_t key) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_siteKeys[siteId] = key;
+}
+
+uint64_t MegamorphicStubCache::siteKey(uint64_t siteId) const {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    auto it = m_siteKeys.find(siteId);
+    return it != m_siteKeys.end() ? it->second : 0;
+}
+
+MegamorphicStubCache::Stats MegamorphicStubCache::getStats() const {
+    Stats stats;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    stats.inserts = m_inserts;
+    stats.evictions = m_evictions;
+    stats.invalidations = m_invalidations;
+    return stats;
+}
+
+} // namespace core
+} // namespace aerojs
@@ -0,0 +1,149 @@
+/**
+ * @file megamorphic_stub_cache.h
+ * @brief メガモーフィックなプロパティアクセス用のプロセス共通スタブキャッシュ
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief (シェイプ, プロパティキー) → プロパティハンドラの直接マップ表
+ *
+ * サイトごとのキャッシュがメガモーフィックになった後も、同じシェイプと
+ * プロパティ名の組は全サイトで共有できる。一次表で見つからなければ二次表を引き、
+ * 一次表から追い出されたエントリは二次表に移す。
+ *
+ * x86_64 のメガモーフィックスタブは表のアドレスを埋め込んで直接探索するため、
+ * エントリの配置（kKeyOffset など）は生成コードと一致させる必要がある。
+ * 書き込みはミューテックスで直列化し、各エントリはシーケンス番号で保護する
+ * （奇数の間は書き込み中。読み手は前後で番号が一致したときだけ値を使う）。
+ *
+ * ハンドラは feedback_vector.h の encodePropertyHandler 形式で、
+ * 自身のフィールド（インライン／外部スロット）だけを登録する。
+ *
+ * 表はエンジンをまたいで共有する。シェイプIDはプロセス内で一意なので、
+ * 別のエンジンのオブジェクトのエントリと取り違えることはない。
+ */
+class MegamorphicStubCache {
+public:
+    static constexpr uint32_t kPrimaryBits = 11;     // 2048エントリ
+    static constexpr uint32_t kSecondaryBits = 9;    // 512エントリ
+    static constexpr uint32_t kPrimarySize = 1u << kPrimaryBits;
+    static constexpr uint32_t kSecondarySize = 1u << kSecondaryBits;
+    static constexpr uint32_t kHashMultiplier = 0x9E3779B1u;
+    static constexpr uint32_t kSecondarySeed = 0x3C6EF372u;
+
+    struct alignas(32) Entry {
+        std::atomic<uint64_t> key{0};      // 0 は空
+        std::atomic<uint64_t> shape{0};
+        std::atomic<uint32_t> handler{0};
+        std::atomic<uint32_t> sequence{0};
+        uint64_t reserved = 0;
+    };
+
+    // 生成コードが参照するエントリ内のオフセット
+    static constexpr int32_t kKeyOffset = 0;
+    static constexpr int32_t kShapeOffset = 8;
+    static constexpr int32_t kHandlerOffset = 16;
+    static constexpr int32_t kSequenceOffset = 20;
+    static constexpr uint32_t kEntrySizeLog2 = 5;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t inserts = 0;
+        uint64_t evictions = 0;       // 一次表から二次表へ移した数
+        uint64_t invalidations = 0;   // シェイプの無効化で消した数
+    };
+
+    static MegamorphicStubCache& instance();
+
+    /**
+     * @brief プロパティ名を0でない安定したキーに変換する（プロセス終了まで有効）
+     */
+    static uint64_t internKey(const std::string& name);
+
+    static uint32_t keyHash(uint64_t key) {
+        return static_cast<uint32_t>(key >> 4) * 0x85EBCA6Bu;
+    }
+
+    static uint32_t primaryIndex(uint64_t shape, uint32_t keyHash) {
+        return ((static_cast<uint32_t>(shape) * kHashMultiplier) ^ keyHash) >> (32 - kPrimaryBits);
+    }
+
+    static uint32_t secondaryIndex(uint32_t primary, uint32_t keyHash) {
+        return (primary - keyHash + kSecondarySeed) & (kSecondarySize - 1);
+    }
+
+    /**
+     * @brief ハンドラを探す（生成コードと同じ手順のランタイム版）
+     */
+    bool lookup(uint64_t shape, uint64_t key, uint32_t& handler);
+
+    /**
+     * @brief 一次表に登録する（元のエントリは二次表へ移す）
+     */
+    void insert(uint64_t shape, uint64_t key, uint32_t handler);
+
+    /**
+     * @brief シェイプのエントリをすべて消す
+     *
+     * 通常の遷移は新しいシェイプIDを作るので不要。シェイプをその場で
+     * 書き換える場合（辞書モード化、プロパティ削除）やIDを再利用する前に呼ぶ。
+     */
+    void invalidateShape(uint64_t shape);
+
+    void clear();
+
+    /**
+     * @brief メガモーフィックになったサイトのプロパティキーを記録する
+     *
+     * スタブ生成はサイトIDしか受け取らないため、ここからキーを引いて埋め込む。
+     */
+    void registerSiteKey(uint64_t siteId, uint64_t key);
+    uint64_t siteKey(uint64_t siteId) const;
+
+    const Entry* primaryTable() const { return m_primary; }
+    const Entry* secondaryTable() const { return m_secondary; }
+
+    Stats getStats() const;
+
+    MegamorphicStubCache(const MegamorphicStubCache&) = delete;
+    MegamorphicStubCache& operator=(const MegamorphicStubCache&) = delete;
+
+private:
+    MegamorphicStubCache() = default;
+
+    static bool readEntry(const Entry& entry, uint64_t shape, uint64_t key, uint32_t& handler);
+    static void writeEntry(Entry& entry, uint64_t shape, uint64_t key, uint32_t handler);
+
+    Entry m_primary[kPrimarySize];
+    Entry m_secondary[kSecondarySize];
+
+    mutable std::mutex m_writeMutex;
+    std::unordered_map<uint64_t, uint64_t> m_siteKeys;
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    uint64_t m_inserts = 0;
+    uint64_t m_evictions = 0;
+    uint64_t m_invalidations = 0;
+};
+
+static_assert(sizeof(MegamorphicStubCache::Entry) == (1u << MegamorphicStubCache::kEntrySizeLog2),
+              "stub cache entry layout is shared with generated code");
+
+} // namespace core
+} // namespace aerojs
@@ -7,6 +7,8 @@
 
 #include "x86_64_ic_generator.h"
 #include "inline_cache.h"
+#include "megamorphic_stub_cache.h"
+#include "../../vm/bytecode/feedback_vector.h"
 #include <cassert>
 
 namespace aerojs {
@@ -183,6 +185,96 @@ namespace x86_64 {
         buffer.emit8(0xC3);
     }
 
+    // 32/64ビットのALU演算（レジスタと即値32、0x81 /ext）
+    // ext: 0=ADD, 4=AND, 5=SUB, 6=XOR, 7=CMP
+    inline void encodeALU_reg_imm32(CodeBuffer& buffer, uint8_t ext, Register reg, uint32_t imm, bool is64) {
+        if (is64 || (reg & 0x8) != 0) {
+            buffer.emit8(encodeREX(is64, false, false, (reg & 0x8) != 0));
+        }
+        buffer.emit8(0x81);
+        buffer.emit8(encodeModRM(MOD_DIRECT, ext, reg & 0x7));
+        buffer.emit32(imm);
+    }
+
+    // シフト命令（0xC1 /ext ib、ext: 4=SHL, 5=SHR）
+    inline void encodeShift_reg_imm8(CodeBuffer& buffer, uint8_t ext, Register reg, uint8_t imm, bool is64) {
+        if (is64 || (reg & 0x8) != 0) {
+            buffer.emit8(encodeREX(is64, false, false, (reg & 0x8) != 0));
+        }
+        buffer.emit8(0xC1);
+        buffer.emit8(encodeModRM(MOD_DIRECT, ext, reg & 0x7));
+        buffer.emit8(imm);
+    }
+
+    // IMUL r32, r/m32, imm32 (0x69 /r)
+    inline void encodeIMUL32_reg_reg_imm32(CodeBuffer& buffer, Register dst, Register src, uint32_t imm) {
+        if ((dst & 0x8) != 0 || (src & 0x8) != 0) {
+            buffer.emit8(encodeREX(false, (dst & 0x8) != 0, false, (src & 0x8) != 0));
+        }
+        buffer.emit8(0x69);
+        buffer.emit8(encodeModRM(MOD_DIRECT, dst & 0x7, src & 0x7));
+        buffer.emit32(imm);
+    }
+
+    // レジスタ間の演算（opcode: 0x89=MOV, 0x01=ADD）。32ビット版は上位をゼロ拡張する
+    inline void encodeOp_reg_reg(CodeBuffer& buffer, uint8_t opcode, Register dst, Register src, bool is64) {
+        if (is64 || (dst & 0x8) != 0 || (src & 0x8) != 0) {
+            buffer.emit8(encodeREX(is64, (src & 0x8) != 0, false, (dst & 0x8) != 0));
+        }
+        buffer.emit8(opcode);
+        buffer.emit8(encodeModRM(MOD_DIRECT, src & 0x7, dst & 0x7));
+    }
+
+    // [base + disp8] をメモリオペランドに取る命令（opcode: 0x8B=MOV, 0x3B=CMP）
+    inline void encodeOp_reg_mem8(CodeBuffer& buffer, uint8_t opcode, Register reg, Register base, int8_t disp, bool is64) {
+        if (is64 || (reg & 0x8) != 0 || (base & 0x8) != 0) {
+            buffer.emit8(encodeREX(is64, (reg & 0x8) != 0, false, (base & 0x8) != 0));
+        }
+        buffer.emit8(opcode);
+        buffer.emit8(encodeModRM(MOD_INDIRECT_DISP8, reg & 0x7, base & 0x7));
+        if ((base & 0x7) == RSP) {
+            buffer.emit8(encodeSIB(0, RSP, base & 0x7));
+        }
+        buffer.emit8(static_cast<uint8_t>(disp));
+    }
+
+    // MOV r64, [base + index*scale]（base は RBP/R13 以外）
+    inline void encodeMOV_reg_memIndex(CodeBuffer& buffer, Register dst, Register base, Register index, uint8_t scaleLog2) {
+        buffer.emit8(encodeREX(true, (dst & 0x8) != 0, (index & 0x8) != 0, (base & 0x8) != 0));
+        buffer.emit8(0x8B);
+        buffer.emit8(encodeModRM(MOD_INDIRECT, dst & 0x7, RSP));
+        buffer.emit8(encodeSIB(scaleLog2, index & 0x7, base & 0x7));
+    }
+
+    // TEST r32, imm32 (0xF7 /0)
+    inline void encodeTEST32_reg_imm32(CodeBuffer& buffer, Register reg, uint32_t imm) {
+        if ((reg & 0x8) != 0) {
+            buffer.emit8(encodeREX(false, false, false, true));
+        }
+        buffer.emit8(0xF7);
+        buffer.emit8(encodeModRM(MOD_DIRECT, 0, reg & 0x7));
+        buffer.emit32(imm);
+    }
+
+    // 飛び先未定の分岐（rel32）を出力し、後で patchRel32 で埋める位置を返す
+    // condition: 0x4=E, 0x5=NE、0xFF は無条件
+    inline size_t emitJumpPlaceholder(CodeBuffer& buffer, uint8_t condition) {
+        if (condition == 0xFF) {
+            buffer.emit8(0xE9);
+        } else {
+            buffer.emit8(0x0F);
+            buffer.emit8(0x80 + condition);
+        }
+        size_t at = buffer.size();
+        buffer.emit32(0);
+        return at;
+    }
+
+    inline void patchRel32(CodeBuffer& buffer, size_t at, size_t target) {
+        int32_t displacement = static_cast<int32_t>(target - (at + 4));
+        *reinterpret_cast<uint32_t*>(buffer.data() + at) = static_cast<uint32_t>(displacement);
+    }
+
     // 64ビット即値をレジスタにロード（最適化版）
     inline void emitMOV_imm64(CodeBuffer& buffer, Register rd, uint64_t imm) {
         if (imm == 0) {
@@ -194,10 +286,10 @@ namespace x86_64 {
             buffer.emit8(0x33);  // XOR
             buffer.emit8(encodeModRM(MOD_DIRECT, rd & 0x7, rd & 0x7));
         } else if (imm <= 0xFFFFFFFF) {
-            // 32ビット即値をゼロ拡張
-            bool rex_w = true;
-            bool rex_b = (rd & 0x8) != 0;
-            buffer.emit8(encodeREX(rex_w, false, false, rex_b));
+            // 32ビット即値をゼロ拡張（REX.W を付けると imm64 形式になるので付けない）
+            if ((rd & 0x8) != 0) {
+                buffer.emit8(encodeREX(false, false, false, true));
+            }
             buffer.emit8(0xB8 + (rd & 0x7));  // MOV r32, imm32
             buffer.emit32(static_cast<uint32_t>(imm));
         } else {
@@ -386,8 +478,50 @@ std::unique_ptr<NativeCode> X86_64_ICGenerator::generatePolymorphicPropertyStub(
     return code;
 }
 
+// スタブキャッシュの1つの表を探索する
+// 入力: EAX=エントリ番号、RCX=シェイプ、R8=キー。ヒットしたらEAXにハンドラを入れて hitJumps に登録する
+// R10/R11 を使い、RDX/RDI/RSI は保存する
+static void emitStubCacheProbe(CodeBuffer& buffer, const MegamorphicStubCache::Entry* table,
+                               std::vector<size_t>& hitJumps) {
+    using Cache = MegamorphicStubCache;
+    std::vector<size_t> nextJumps;
+    
+    // MOV R10D, EAX; SHL R10, 5; MOV R11, table; ADD R10, R11
+    x86_64::encodeOp_reg_reg(buffer, 0x89, x86_64::R10, x86_64::RAX, false);
+    x86_64::encodeShift_reg_imm8(buffer, 4, x86_64::R10, Cache::kEntrySizeLog2, true);
+    x86_64::emitMOV_imm64(buffer, x86_64::R11, reinterpret_cast<uint64_t>(table));
+    x86_64::encodeOp_reg_reg(buffer, 0x01, x86_64::R10, x86_64::R11, true);
+    
+    // 書き込み中（シーケンス番号が奇数）なら次へ
+    // MOV R11D, [R10+seq]; TEST R11D, 1; JNZ next
+    x86_64::encodeOp_reg_mem8(buffer, 0x8B, x86_64::R11, x86_64::R10, Cache::kSequenceOffset, false);
+    x86_64::encodeTEST32_reg_imm32(buffer, x86_64::R11, 1);
+    nextJumps.push_back(x86_64::emitJumpPlaceholder(buffer, 0x5));
+    
+    // CMP R8, [R10+key]; JNE next; CMP RCX, [R10+shape]; JNE next
+    x86_64::encodeOp_reg_mem8(buffer, 0x3B, x86_64::R8, x86_64::R10, Cache::kKeyOffset, true);
+    nextJumps.push_back(x86_64::emitJumpPlaceholder(buffer, 0x5));
+    x86_64::encodeOp_reg_mem8(buffer, 0x3B, x86_64::RCX, x86_64::R10, Cache::kShapeOffset, true);
+    nextJumps.push_back(x86_64::emitJumpPlaceholder(buffer, 0x5));
+    
+    // ハンドラを読んでからシーケンス番号が変わっていないことを確認する（x86 はロード同士を並べ替えない）
+    // MOV R9D, [R10+handler]; CMP R11D, [R10+seq]; JNE next
+    x86_64::encodeOp_reg_mem8(buffer, 0x8B, x86_64::R9, x86_64::R10, Cache::kHandlerOffset, false);
+    x86_64::encodeOp_reg_mem8(buffer, 0x3B, x86_64::R11, x86_64::R10, Cache::kSequenceOffset, false);
+    nextJumps.push_back(x86_64::emitJumpPlaceholder(buffer, 0x5));
+    
+    // MOV EAX, R9D; JMP hit
+    x86_64::encodeOp_reg_reg(buffer, 0x89, x86_64::RAX, x86_64::R9, false);
+    hitJumps.push_back(x86_64::emitJumpPlaceholder(buffer, 0xFF));
+    
+    for (size_t at : nextJumps) {
+        x86_64::patchRel32(buffer, at, buffer.size());
+    }
+}
+
 // X86_64用のメガモーフィックプロパティアクセススタブ生成
 std::unique_ptr<NativeCode> X86_64_ICGenerator::generateMegamorphicPropertyStub(uint64_t siteId) {
+    using Cache = MegamorphicStubCache;
     auto code = std::make_unique<NativeCode>();
     CodeBuffer& buffer = code->buffer;
     
@@ -398,8 +532,61 @@ std::unique_ptr<NativeCode> X86_64_ICGenerator::generateMegamorphicPropertyStub(
     // RDI: オブジェクトポインタ
     // RSI: プロパティ名（文字列ポインタ）
     
-    // 直接キャッシュミスハンドラを呼び出す
-    // メガモーフィックの場合、常にグローバルハンドラにリダイレクト
+    // サイトのプロパティキーが分かっていれば、グローバルなスタブキャッシュを
+    // インラインで探索してからミスハンドラに回す
+    Cache& stubCache = Cache::instance();
+    uint64_t key = stubCache.siteKey(siteId);
+    std::vector<size_t> missJumps;
+    if (key != 0) {
+        uint32_t hash = Cache::keyHash(key);
+        std::vector<size_t> hitJumps;
+        
+        // MOV RCX, [RDI]（シェイプID）; MOV R8, key
+        x86_64::encodeMOV_reg_mem(buffer, x86_64::RCX, x86_64::RDI, 0);
+        x86_64::emitMOV_imm64(buffer, x86_64::R8, key);
+        
+        // 一次表: EAX = ((ECX * mul) ^ hash) >> (32 - bits)、EDX に保存
+        x86_64::encodeIMUL32_reg_reg_imm32(buffer, x86_64::RAX, x86_64::RCX, Cache::kHashMultiplier);
+        x86_64::encodeALU_reg_imm32(buffer, 6, x86_64::RAX, hash, false);
+        x86_64::encodeShift_reg_imm8(buffer, 5, x86_64::RAX, 32 - Cache::kPrimaryBits, false);
+        x86_64::encodeOp_reg_reg(buffer, 0x89, x86_64::RDX, x86_64::RAX, false);
+        emitStubCacheProbe(buffer, stubCache.primaryTable(), hitJumps);
+        
+        // 二次表: EAX = (EDX - hash + seed) & (size - 1)
+        x86_64::encodeOp_reg_reg(buffer, 0x89, x86_64::RAX, x86_64::RDX, false);
+        x86_64::encodeALU_reg_imm32(buffer, 5, x86_64::RAX, hash, false);
+        x86_64::encodeALU_reg_imm32(buffer, 0, x86_64::RAX, Cache::kSecondarySeed, false);
+        x86_64::encodeALU_reg_imm32(buffer, 4, x86_64::RAX, Cache::kSecondarySize - 1, false);
+        emitStubCacheProbe(buffer, stubCache.secondaryTable(), hitJumps);
+        missJumps.push_back(x86_64::emitJumpPlaceholder(buffer, 0xFF));
+        
+        // ヒット: EAX のハンドラを種類（下位4ビット）とスロットに分ける
+        for (size_t at : hitJumps) {
+            x86_64::patchRel32(buffer, at, buffer.size());
+        }
+        // MOV EDX, EAX; AND EAX, 0xF; SHR EDX, 4
+        x86_64::encodeOp_reg_reg(buffer, 0x89, x86_64::RDX, x86_64::RAX, false);
+        x86_64::encodeALU_reg_imm32(buffer, 4, x86_64::RAX, 0xF, false);
+        x86_64::encodeShift_reg_imm8(buffer, 5, x86_64::RDX, 4, false);
+        
+        // インラインプロパティ: MOV RAX, [RDI + RDX]; RET
+        x86_64::encodeALU_reg_imm32(buffer, 7, x86_64::RAX,
+                                    static_cast<uint32_t>(PropertyHandlerKind::kInlineField), false);
+        size_t outOfLineJump = x86_64::emitJumpPlaceholder(buffer, 0x5);
+        x86_64::encodeMOV_reg_memIndex(buffer, x86_64::RAX, x86_64::RDI, x86_64::RDX, 0);
+        x86_64::encodeRET(buffer);
+        
+        // アウトオブラインプロパティ: MOV RAX, [RDI + 8]; MOV RAX, [RAX + RDX*8]; RET
+        x86_64::patchRel32(buffer, outOfLineJump, buffer.size());
+        x86_64::encodeMOV_reg_mem(buffer, x86_64::RAX, x86_64::RDI, 8);
+        x86_64::encodeMOV_reg_memIndex(buffer, x86_64::RAX, x86_64::RAX, x86_64::RDX, 3);
+        x86_64::encodeRET(buffer);
+    }
+    
+    // ミス: キャッシュミスハンドラを呼び出す（ハンドラがスタブキャッシュに登録する）
+    for (size_t at : missJumps) {
+        x86_64::patchRel32(buffer, at, buffer.size());
+    }
     
     // MOV RDX, siteId
     x86_64::emitMOV_imm64(buffer, x86_64::RDX, siteId);
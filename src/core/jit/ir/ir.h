@@ -5,6 +5,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "../deoptimizer/frame_state.h"
+
 namespace aerojs {
 namespace core {
 
@@ -60,6 +62,8 @@ enum class Opcode : uint8_t {
   // メモリ操作
   kLoad,          // メモリからロード
   kStore,         // メモリに保存
+  kLoadCompressed,   // dest = 圧縮参照のフィールド [base + 即値] を展開した参照
+  kStoreCompressed,  // 参照 src を圧縮してフィールド [base + 即値] に保存（オペランドは src, base, 即値）
   
   // プロパティアクセス
   kGetProperty,   // オブジェクトからプロパティ取得
@@ -158,6 +162,10 @@ enum class Opcode : uint8_t {
   kIsArray,
   kIsBigInt,
 
+  // 脱最適化
+  kCheckNumber,       // dest = src が即値の SpeculationKind（Int32 / Double）を満たせば1、でなければ0
+  kDeoptimizeUnless,  // オペランドのレジスタが0なら脱最適化する（frameState が必須）
+
   // 列挙の終端マーカー
   kLastOpcode
 };
@@ -221,9 +229,30 @@ struct IROperand {
 
     bool isImmediate() const { return type == IROperandType::kImmediate; }
     int64_t getImmediateValue() const { return value.imm; }
+    bool isVirtualReg() const { return type == IROperandType::kRegister; }
+    int32_t getVirtualReg() const { return value.reg; }
+    bool isVirtualRegOrImmediate() const { return isVirtualReg() || isImmediate(); }
     // 他のアクセサも同様に追加可能
 };
 
+/**
+ * @brief 命令の位置でのインタプリタのフレーム状態
+ *
+ * 脱最適化で復元するフレームを、仮想レジスタで表す。values はローカル変数 localCount 個、
+ * オペランドスタック stackCount 個の順で、-1 はその位置で使われない値。
+ * インライン化された呼び出し先の状態は parent に呼び出し元の状態を指す。
+ */
+struct IRFrameState {
+  uint64_t functionId = 0;   // 0 はコンパイル中の関数
+  uint32_t bytecodeOffset = 0;
+  uint32_t localCount = 0;
+  uint32_t stackCount = 0;
+  std::vector<int32_t> values;
+  std::vector<ValueRepresentation> representations;  // 空なら全て Tagged
+  SpeculationKind speculation = SpeculationKind::None;  // kDeoptimizeUnless が守る投機
+  int32_t parent = -1;
+};
+
 /**
  * @brief IR命令を表す構造体
  */
@@ -237,6 +266,9 @@ struct IRInstruction {
   // オプションのメタデータ（デバッグ情報など）
   std::string metadata;
 
+  // 呼び出しとガードの位置のフレーム状態（IRFunction::GetFrameState の番号、-1 はなし）
+  int32_t frameState = -1;
+
   // 新しいアクセサメソッド
   size_t num_operands() const { return operands.size(); }
   const IROperand& operand(size_t index) const {
@@ -369,6 +401,14 @@ public:
     }
   }
   
+  /**
+   * @brief 命令列を置き換える（命令を挿入するパスが組み直した列を戻す）
+   * @param instructions 新しい命令列
+   */
+  void SetInstructions(std::vector<IRInstruction> instructions) {
+    m_instructions = std::move(instructions);
+  }
+  
   /**
    * @brief 命令数を取得する
    * @return IR命令の数
@@ -390,6 +430,7 @@ public:
    */
   void Clear() {
     m_instructions.clear();
+    m_frameStates.clear();
   }
   
   /**
@@ -433,10 +474,33 @@ public:
     return "";
   }
   
+  /**
+   * @brief フレーム状態を追加する
+   * @return IRInstruction::frameState に入れる番号
+   */
+  int32_t AddFrameState(IRFrameState state) {
+    m_frameStates.push_back(std::move(state));
+    return static_cast<int32_t>(m_frameStates.size() - 1);
+  }
+  
+  const IRFrameState* GetFrameState(int32_t index) const {
+    if (index < 0 || static_cast<size_t>(index) >= m_frameStates.size()) {
+      return nullptr;
+    }
+    return &m_frameStates[index];
+  }
+  
+  size_t GetFrameStateCount() const {
+    return m_frameStates.size();
+  }
+  
 private:
   // IR命令のコレクション
   std::vector<IRInstruction> m_instructions;
   
+  // 呼び出しとガードの位置のフレーム状態
+  std::vector<IRFrameState> m_frameStates;
+  
   // ラベル名とIDのマッピング
   std::unordered_map<std::string, uint32_t> m_labels;
 };
@@ -488,6 +488,8 @@ const char* IRValidator::GetOpcodeName(Opcode opcode) const
         case Opcode::kLoadConst: return "LoadConst";
         case Opcode::kLoad: return "Load";
         case Opcode::kStore: return "Store";
+        case Opcode::kLoadCompressed: return "LoadCompressed";
+        case Opcode::kStoreCompressed: return "StoreCompressed";
         case Opcode::kAdd: return "Add";
         case Opcode::kSub: return "Sub";
         case Opcode::kMul: return "Mul";
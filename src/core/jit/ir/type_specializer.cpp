@@ -1,4 +1,5 @@
 #include "type_specializer.h"
+#include "../../vm/bytecode/feedback_vector.h"
 
 #include <cassert>
 #include <algorithm>
@@ -1696,6 +1697,158 @@ TypeInfo TypeSpecializer::InferTypeFromProfile(const TypeProfile& profile) {
     return TypeInfo::Any();
 }
 
+// ---------------------------------------------------------------------------
+// 投機の禁止リストを考慮した型特化
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// 投機ガードを置く命令（オペランド0が結果、1と2が入力）
+bool IsSpeculatableBinaryOp(Opcode opcode) {
+    switch (opcode) {
+    case Opcode::kAdd:
+    case Opcode::kSub:
+    case Opcode::kMul:
+    case Opcode::kDiv:
+    case Opcode::kMod:
+    case Opcode::kCompareEq:
+    case Opcode::kCompareNe:
+    case Opcode::kCompareLt:
+    case Opcode::kCompareLe:
+    case Opcode::kCompareGt:
+    case Opcode::kCompareGe:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 型ヒントが示す投機（文字列やオブジェクトが混ざれば投機しない）
+SpeculationKind SpeculationForHint(uint32_t hint) {
+    if (hint == BinaryOpHint::kSignedSmall) {
+        return SpeculationKind::Int32;
+    }
+    if (hint != BinaryOpHint::kNone &&
+        (hint & ~(BinaryOpHint::kSignedSmall | BinaryOpHint::kNumber)) == 0) {
+        return SpeculationKind::Double;
+    }
+    return SpeculationKind::None;
+}
+
+IROperand RegisterOperand(int32_t reg) {
+    IROperand operand;
+    operand.type = IROperandType::kRegister;
+    operand.value.reg = reg;
+    return operand;
+}
+
+IROperand ImmediateOperand(int64_t imm) {
+    IROperand operand;
+    operand.type = IROperandType::kImmediate;
+    operand.value.imm = imm;
+    return operand;
+}
+
+}  // namespace
+
+bool TypeSpecializer::IsSpeculationAllowed(uint64_t functionId, uint32_t bytecodeOffset, SpeculationKind kind) const {
+    if (!m_speculationBlacklists) {
+        return true;
+    }
+    auto it = m_speculationBlacklists->find(functionId);
+    return it == m_speculationBlacklists->end() || it->second.IsAllowed(bytecodeOffset, kind);
+}
+
+bool TypeSpecializer::specialize(IRFunction* function, const ProfileData* profile, uint64_t functionId) {
+    m_blacklistedSiteCount = 0;
+    if (!function || !profile || profile->binaryOpHints.empty()) {
+        return function != nullptr;
+    }
+    
+    // ガードの判定結果を入れる新しい仮想レジスタは、使われている番号の後ろから取る
+    int32_t nextReg = 0;
+    for (const IRInstruction& inst : function->GetInstructions()) {
+        for (const IROperand& operand : inst.operands) {
+            if (operand.isVirtualReg()) {
+                nextReg = std::max(nextReg, operand.getVirtualReg() + 1);
+            }
+        }
+    }
+    
+    const std::vector<IRInstruction>& original = function->GetInstructions();
+    std::vector<IRInstruction> rewritten;
+    rewritten.reserve(original.size());
+    bool changed = false;
+    
+    for (const IRInstruction& inst : original) {
+        if (!IsSpeculatableBinaryOp(inst.opcode) || inst.frameState < 0 || inst.num_operands() < 3) {
+            rewritten.push_back(inst);
+            continue;
+        }
+        const IRFrameState* state = function->GetFrameState(inst.frameState);
+        if (!state) {
+            return false;
+        }
+        auto hint = profile->binaryOpHints.find(state->bytecodeOffset);
+        SpeculationKind speculation =
+            hint != profile->binaryOpHints.end() ? SpeculationForHint(hint->second) : SpeculationKind::None;
+        if (speculation == SpeculationKind::None) {
+            rewritten.push_back(inst);
+            continue;
+        }
+        
+        // 外れ続けた投機は弱める（Int32 → Double → 投機しない）
+        uint64_t siteFunction = state->functionId ? state->functionId : functionId;
+        if (speculation == SpeculationKind::Int32 &&
+            !IsSpeculationAllowed(siteFunction, state->bytecodeOffset, SpeculationKind::Int32)) {
+            speculation = SpeculationKind::Double;
+            m_blacklistedSiteCount++;
+        }
+        if (speculation == SpeculationKind::Double &&
+            !IsSpeculationAllowed(siteFunction, state->bytecodeOffset, SpeculationKind::Double)) {
+            m_blacklistedSiteCount++;
+            rewritten.push_back(inst);
+            continue;
+        }
+        
+        // 失敗したらこの命令の前の状態からインタプリタで実行し直す
+        IRFrameState guardState = *state;
+        guardState.speculation = speculation;
+        int32_t guardStateIndex = function->AddFrameState(std::move(guardState));
+        
+        for (size_t i = 1; i <= 2; ++i) {
+            const IROperand& input = inst.operand(i);
+            if (!input.isVirtualReg()) {
+                continue;
+            }
+            int32_t checkReg = nextReg++;
+            
+            IRInstruction check;
+            check.opcode = Opcode::kCheckNumber;
+            check.operands = {RegisterOperand(checkReg), input,
+                              ImmediateOperand(static_cast<int64_t>(speculation))};
+            rewritten.push_back(std::move(check));
+            
+            IRInstruction guard;
+            guard.opcode = Opcode::kDeoptimizeUnless;
+            guard.operands = {RegisterOperand(checkReg)};
+            guard.frameState = guardStateIndex;
+            rewritten.push_back(std::move(guard));
+            
+            m_guardCount++;
+            m_deoptCount++;
+        }
+        rewritten.push_back(inst);
+        m_specializationCount++;
+        changed = true;
+    }
+    
+    if (changed) {
+        function->SetInstructions(std::move(rewritten));
+    }
+    return true;
+}
+
 }  // namespace core
 }  // namespace aerojs 
 }  // namespace aerojs 
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "ir.h"
+#include "../deoptimizer/speculation.h"
 #include "../profiler/execution_profiler.h"
 #include "../jit_profiler.h"
 
@@ -107,6 +108,42 @@ public:
     TypeSpecializer();
     ~TypeSpecializer();
     
+    /**
+     * @brief 関数ごとの禁止された投機を設定する
+     * @param blacklists 関数IDごとの禁止リスト（nullptr なら何も禁止しない。specialize の間だけ参照する）
+     */
+    void setSpeculationBlacklists(const std::unordered_map<uint64_t, SpeculationBlacklist>* blacklists) {
+        m_speculationBlacklists = blacklists;
+    }
+    
+    /**
+     * @brief 位置での投機が禁止されていないか
+     */
+    bool IsSpeculationAllowed(uint64_t functionId, uint32_t bytecodeOffset, SpeculationKind kind) const;
+    
+    /**
+     * @brief 算術・比較命令のオペランドに、観測された型の投機ガードを置く
+     *
+     * フレーム状態を持つ算術・比較命令ごとに、その位置の型ヒントから投機を選ぶ
+     * （整数だけなら Int32、数値だけなら Double）。禁止された投機は使わず、Int32 が
+     * 禁止されていれば Double に、Double も禁止されていれば投機しない（汎用のまま）。
+     * ガードは命令の直前に kCheckNumber と kDeoptimizeUnless で置き、失敗すれば
+     * 命令のフレーム状態からインタプリタで命令を実行し直す。
+     *
+     * @param function 対象のIR関数
+     * @param profile プロファイル（nullptr なら何もしない）
+     * @param functionId コンパイル中の関数ID（フレーム状態の functionId が 0 の位置）
+     * @return IRが不正（フレーム状態の番号が範囲外）なら false
+     */
+    bool specialize(IRFunction* function, const ProfileData* profile, uint64_t functionId);
+    
+    /**
+     * @brief 直前の specialize で、禁止されていたため投機を弱めた・やめた位置の数
+     */
+    size_t GetBlacklistedSiteCount() const {
+        return m_blacklistedSiteCount;
+    }
+    
     /**
      * @brief IRに型ガードを追加する
      * @param function 対象のIR関数
@@ -294,6 +331,10 @@ private:
     size_t m_guardCount;
     size_t m_specializationCount;
     size_t m_deoptCount;
+    
+    // 関数IDごとの禁止された投機（所有しない）
+    const std::unordered_map<uint64_t, SpeculationBlacklist>* m_speculationBlacklists = nullptr;
+    size_t m_blacklistedSiteCount = 0;
 };
 
 }  // namespace core
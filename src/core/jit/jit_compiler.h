@@ -13,6 +13,8 @@
 #include <string>
 #include <functional>
 #include "ir/ir.h"
+#include "osr/osr_entry.h"
+#include "deoptimizer/speculation.h"
 
 namespace aerojs {
 namespace core {
@@ -116,6 +118,33 @@ class JITCompiler {
   // コンパイル済みかチェック
   virtual bool hasCompiledCode(uint64_t functionId) const = 0;
   
+  /**
+   * @brief OSR で入るループヘッダの機械語アドレスとフレーム配置を求める
+   *
+   * state はOSRを要求したインタプリタのフレーム（ローカル変数とスタックの数、値の型）で、
+   * 最適化コンパイラは値の型に合わせて配置を特殊化してよい。エントリのスタブは
+   * 呼び出し側が layout から生成する。対応しないコンパイラは false を返す。
+   */
+  virtual bool compileOSREntry(Function* function, const OSRFrameState& state,
+                               void*& loopHeader, OSREntryLayout& layout) {
+      (void)function;
+      (void)state;
+      (void)loopHeader;
+      (void)layout;
+      return false;
+  }
+  
+  /**
+   * @brief 関数のバイトコード位置ごとに禁止された投機を伝える
+   *
+   * 脱最適化を繰り返した位置では、以後のコンパイルで禁止された投機を使わずに
+   * 汎用のコードを出す。投機をしないコンパイラは無視してよい。
+   */
+  virtual void setSpeculationBlacklist(uint64_t functionId, const SpeculationBlacklist& blacklist) {
+      (void)functionId;
+      (void)blacklist;
+  }
+  
   // オプション設定
   virtual void setOptions(const JITCompileOptions& options) {
       _options = options;
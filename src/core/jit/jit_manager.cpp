@@ -1,4 +1,12 @@
 #include "src/core/jit/jit_manager.h"
+#include "src/core/jit/code_space.h"
+#include "src/core/jit/jit_profiler.h"
+#include "src/core/jit/baseline/baseline_jit.h"
+#include "src/core/jit/baseline/bytecode_decoder.h"
+#include "src/core/jit/deoptimizer/speculation.h"
+#include "src/core/jit/optimizing/optimizing_jit.h"
+#include "src/core/jit/optimizing/super_optimizing_jit.h"
+#include "src/core/vm/exception/termination.h"
 #include <algorithm>
 #include <chrono>
 #include <sstream>
@@ -26,24 +34,25 @@ class JITManager::CompilerState {
     std::mutex m_bytecodeCacheMutex;
 };
 
-JITManager::JITManager(const JITOptimizerPolicy& policy)
+JITManager::JITManager(Context* context, const JITOptimizerPolicy& policy)
     : m_policy(policy)
-    , m_profiler() {
+    , m_profiler(std::make_unique<JITProfiler>()) {
     // 各JITコンパイラの初期化
     m_baselineJIT = std::make_unique<BaselineJIT>();
     m_baselineJIT->EnableProfiling(true);
     
-    m_optimizingJIT = std::make_unique<OptimizingJIT>();
-    m_optimizingJIT->SetProfiler(std::make_shared<JITProfiler>(m_profiler));
+    m_optimizingJIT = std::make_unique<OptimizingJIT>(context);
+    m_optimizingJIT->SetProfiler(std::make_shared<JITProfiler>(*m_profiler));
+    m_optimizingJIT->setConcurrentCompilation(m_policy.enableConcurrentCompilation);
     
     m_superOptimizingJIT = std::make_unique<SuperOptimizingJIT>();
     
     // プロファイラを初期化
-    m_profiler.Initialize();
+    m_profiler->Initialize();
 }
 
 JITManager::~JITManager() {
-    m_profiler.Shutdown();
+    m_profiler->Shutdown();
 }
 
 CompiledCodePtr JITManager::getOrCompileFunction(uint32_t functionId, const std::vector<Bytecode>& bytecodes) {
@@ -77,21 +86,10 @@ void JITManager::incrementExecutionCount(uint32_t functionId, uint32_t increment
     JITOptimizationTier targetTier = determineTargetTier(state);
 
     if (targetTier > currentTier) {
-        if (m_policy.enableConcurrentCompilation && targetTier > JITOptimizationTier::Baseline) {
-            // ベースラインJITより高度なコンパイルは別スレッドで実行
-            // バイトコード取得とコンパイル
-            std::vector<Bytecode> bytecodes = getBytecodeForFunction(functionId);
-            if (!bytecodes.empty()) {
-                BackgroundCompilerTask task;
-                task.functionId = functionId;
-                task.bytecodes = std::move(bytecodes);
-                task.targetTier = CompilationTier::Optimizing;
-                task.priority = CompilerPriority::Normal;
-                
-                std::lock_guard<std::mutex> lock(m_backgroundCompilerMutex);
-                m_backgroundCompilerQueue.push(std::move(task));
-                m_backgroundCompilerCV.notify_one();
-            }
+        if (targetTier > JITOptimizationTier::Baseline) {
+            // 最適化コンパイルはここで入力を作り、バックグラウンドでコンパイルして、
+            // installFinishedCompilations() で導入する
+            requestOptimizedCompile(functionId, state, targetTier);
         } else {
             // バイトコードを実際に取得して再コンパイルを実行
             std::vector<Bytecode> bytecodes = getBytecodeForFunction(functionId);
@@ -101,9 +99,6 @@ void JITManager::incrementExecutionCount(uint32_t functionId, uint32_t increment
                     case CompilationTier::Baseline:
                         recompiledCode = m_baselineJIT->compile(bytecodes, functionId);
                         break;
-                    case CompilationTier::Optimizing:
-                        recompiledCode = m_optimizingJIT->compile(bytecodes, functionId);
-                        break;
                     default:
                         break;
                 }
@@ -149,7 +144,7 @@ void JITManager::recordTypeInfo(uint32_t functionId, uint32_t varIndex, const Pr
             break;
     }
     
-    m_profiler.RecordTypeObservation(functionId, varIndex, type);
+    m_profiler->RecordTypeObservation(functionId, varIndex, type);
     
     // 変数インデックスが引数の場合
     if (varIndex < state.argTypes.size()) {
@@ -316,7 +311,7 @@ CompiledCodePtr JITManager::getOSREntryPoint(uint32_t functionId, uint32_t bytec
     state.osrEntryCount++;
     
     // プロファイラにOSR実行を記録
-    m_profiler.RecordExecution(functionId, bytecodeOffset);
+    m_profiler->RecordExecution(functionId, bytecodeOffset);
     
     // OSR対応コードを生成
     CompiledCodePtr osrCode = nullptr;
@@ -332,7 +327,7 @@ CompiledCodePtr JITManager::getOSREntryPoint(uint32_t functionId, uint32_t bytec
         }
         
         // プロファイル情報を取得してOSR最適化を適用
-        const auto* profile = m_profiler.getProfileFor(functionId);
+        const auto* profile = m_profiler->getProfileFor(functionId);
         
         // OSR エントリポイント生成のための情報を構築
         OSREntryInfo entryInfo;
@@ -392,7 +387,7 @@ CompiledCodePtr JITManager::getOSREntryPoint(uint32_t functionId, uint32_t bytec
             }
             
             // プロファイラに成功を記録
-            m_profiler.RecordOSRCompilation(functionId, bytecodeOffset, targetTier);
+            m_profiler->RecordOSRCompilation(functionId, bytecodeOffset, targetTier);
         }
         
     } catch (const std::exception& e) {
@@ -412,8 +407,92 @@ CompiledCodePtr JITManager::getOSREntryPoint(uint32_t functionId, uint32_t bytec
     return osrCode;
 }
 
+void JITManager::setSpeculationBlacklist(uint64_t functionId, const SpeculationBlacklist& blacklist) {
+    // 次に準備するコンパイルから、禁止された位置には投機ガードを置かない
+    if (m_optimizingJIT) {
+        m_optimizingJIT->setSpeculationBlacklist(functionId, blacklist);
+    }
+    if (m_superOptimizingJIT) {
+        m_superOptimizingJIT->setSpeculationBlacklist(functionId, blacklist);
+    }
+}
+
+void JITManager::setTerminationState(const TerminationState* state) {
+    if (m_optimizingJIT) {
+        m_optimizingJIT->setTerminationState(state);
+    }
+    if (m_superOptimizingJIT) {
+        m_superOptimizingJIT->setTerminationState(state);
+    }
+}
+
+void JITManager::setFunctionResolver(FunctionResolver resolver) {
+    m_functionResolver = std::move(resolver);
+}
+
+void JITManager::requestOptimizedCompile(uint32_t functionId, FunctionCompilationState& state,
+                                         JITOptimizationTier targetTier) {
+    if (state.compilationInProgress || !m_optimizingJIT || !m_functionResolver) {
+        return;
+    }
+    Function* function = m_functionResolver(functionId);
+    if (!function) {
+        return;
+    }
+    
+    // 入力（プロファイル・依存するシェイプとグローバル変数・禁止された投機）はここで写す。
+    // 並行コンパイルが無効ならその場でコンパイルし、導入だけを遅らせる
+    std::shared_ptr<OptimizingCompileJob> job = m_optimizingJIT->compileConcurrently(function);
+    if (!job) {
+        return;
+    }
+    state.compilationInProgress = true;
+    m_optimizingJobs[functionId] = {targetTier, std::move(job)};
+}
+
+size_t JITManager::installFinishedCompilations() {
+    if (m_optimizingJobs.empty() || !m_optimizingJIT) {
+        return 0;
+    }
+    
+    // 導入時に依存関係を検証し、変わっていればコードは破棄される
+    // （導入する全コードの命令キャッシュのフラッシュはスコープの終わりに1回で行う）
+    CodeSpace::FlushScope flushScope;
+    size_t installed = m_optimizingJIT->installFinishedCompilations(
+        [this](Function* function, NativeCode* code) {
+            uint32_t functionId = static_cast<uint32_t>(function->id());
+            auto it = m_optimizingJobs.find(functionId);
+            auto& state = getOrCreateFunctionState(functionId);
+            state.currentTier = it != m_optimizingJobs.end() ? it->second.first : JITOptimizationTier::Optimized;
+            m_optimizedCode[functionId] = code;
+            m_stats.optimizedCompilations++;
+        });
+    
+    // 終わったジョブ（導入・失敗・破棄）を外し、次のティアアップで再び要求できるようにする
+    for (auto it = m_optimizingJobs.begin(); it != m_optimizingJobs.end();) {
+        OptimizingCompileJob::Status status = it->second.second->status.load(std::memory_order_acquire);
+        if (status == OptimizingCompileJob::Status::Installed ||
+            status == OptimizingCompileJob::Status::Failed ||
+            status == OptimizingCompileJob::Status::Discarded) {
+            getOrCreateFunctionState(it->first).compilationInProgress = false;
+            it = m_optimizingJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return installed;
+}
+
+NativeCode* JITManager::getOptimizedCode(uint32_t functionId) const {
+    auto it = m_optimizedCode.find(functionId);
+    return it != m_optimizedCode.end() ? it->second : nullptr;
+}
+
 void JITManager::setPolicy(const JITOptimizerPolicy& policy) {
     m_policy = policy;
+    if (m_optimizingJIT) {
+        m_optimizingJIT->setConcurrentCompilation(policy.enableConcurrentCompilation);
+    }
 }
 
 std::string JITManager::getCompilationStatistics() const {
@@ -450,9 +529,9 @@ CompiledCodePtr JITManager::compileFunction(uint32_t functionId, const std::vect
     // if (targetTier == JITOptimizationTier::Baseline) {
     //     return m_baselineJIT->compile(bytecodes);
     // } else if (targetTier == JITOptimizationTier::Optimized) {
-    //     return m_optimizingJIT->compile(bytecodes, m_profiler.getProfileFor(functionId));
+    //     return m_optimizingJIT->compile(bytecodes, m_profiler->getProfileFor(functionId));
     // } else if (targetTier == JITOptimizationTier::SuperOptimized) {
-    //     return m_superOptimizingJIT->compile(bytecodes, m_profiler.getProfileFor(functionId));
+    //     return m_superOptimizingJIT->compile(bytecodes, m_profiler->getProfileFor(functionId));
     // }
     // return nullptr; // コンパイル失敗または該当JITなし
     
@@ -465,7 +544,7 @@ CompiledCodePtr JITManager::compileFunction(uint32_t functionId, const std::vect
     }
     
     // JITProfilerからプロファイル情報を取得
-    const auto* profile = m_profiler.getProfileFor(functionId);
+    const auto* profile = m_profiler->getProfileFor(functionId);
     CompiledCodePtr compiledCode = nullptr;
     std::string errorMessage;
     
@@ -583,7 +662,7 @@ void JITManager::onDeoptimization(uint32_t functionId, const std::string& reason
     state.currentTier = JITOptimizationTier::Baseline;
     
     // プロファイラに通知
-    m_profiler.RecordDeoptimization(functionId, 0, reason);
+    m_profiler->RecordDeoptimization(functionId, 0, reason);
     
     // 完璧なデオプティマイゼーション処理の実装
     // バイトコードの取得と詳細な再コンパイル処理を実行
@@ -1060,7 +1139,7 @@ void JITManager::performRecompilation(uint32_t functionId,
             case JITOptimizationTier::Optimized:
                 if (m_optimizingJIT) {
                     // プロファイル情報を考慮したより保守的な最適化
-                    const auto* profile = m_profiler.getProfileFor(functionId);
+                    const auto* profile = m_profiler->getProfileFor(functionId);
                     hints.profileGuidedOptimization = (profile != nullptr);
                     recompiledCode = m_optimizingJIT->compileWithHints(functionId, bytecodes, profile, hints);
                 }
@@ -1,20 +1,31 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
-#include "src/core/bytecode.h"
-#include "src/core/jit/baseline/baseline_jit.h"
-#include "src/core/jit/optimizing/optimizing_jit.h"
-#include "src/core/jit/super_optimizing/super_optimizing_jit.h"
-#include "src/core/jit/jit_profiler.h"
+namespace aerojs {
+class BaselineJIT;
+}
 
 namespace aerojs::core {
 
+// 前方宣言（定義は jit_manager.cpp でインクルードする）
+struct Bytecode;
+struct OptimizingCompileJob;
+class Context;
+class Function;
+class JITProfiler;
+class NativeCode;
+class OptimizingJIT;
+class SpeculationBlacklist;
+class SuperOptimizingJIT;
+class TerminationState;
+
 /**
  * @brief JITコンパイルの最適化レベル
  */
@@ -25,6 +36,28 @@ enum class JITOptimizationTier {
     SuperOptimized  ///< 超最適化JIT（最大限の最適化）
 };
 
+/**
+ * @brief 型プロファイリング情報
+ */
+struct ProfiledTypeInfo {
+    enum class ValueType {
+        Unknown,
+        Int32,
+        Float64,
+        String,
+        Object,
+        Boolean,
+        Undefined,
+        Null
+    };
+    
+    ValueType expectedType = ValueType::Unknown;
+    uint32_t typeCheckFailures = 0;
+    
+    // 型安定性の判断
+    bool isStable() const { return typeCheckFailures < 3; }
+};
+
 /**
  * @brief JITコンパイル対象関数の状態
  */
@@ -76,28 +109,6 @@ struct JITOptimizerPolicy {
         , enableInlining(true) {}
 };
 
-/**
- * @brief 型プロファイリング情報
- */
-struct ProfiledTypeInfo {
-    enum class ValueType {
-        Unknown,
-        Int32,
-        Float64,
-        String,
-        Object,
-        Boolean,
-        Undefined,
-        Null
-    };
-    
-    ValueType expectedType = ValueType::Unknown;
-    uint32_t typeCheckFailures = 0;
-    
-    // 型安定性の判断
-    bool isStable() const { return typeCheckFailures < 3; }
-};
-
 /**
  * @brief コンパイル済みのコードを表すポインタ型
  */
@@ -112,9 +123,10 @@ class JITManager {
 public:
     /**
      * @brief コンストラクタ
+     * @param context 最適化コードを導入するコンテキスト
      * @param policy 最適化ポリシー
      */
-    explicit JITManager(const JITOptimizerPolicy& policy = JITOptimizerPolicy());
+    explicit JITManager(Context* context, const JITOptimizerPolicy& policy = JITOptimizerPolicy());
     
     /**
      * @brief デストラクタ
@@ -167,6 +179,41 @@ public:
      */
     CompiledCodePtr getOSREntryPoint(uint32_t functionId, uint32_t bytecodeOffset, uint32_t loopIteration);
     
+    /**
+     * @brief 関数の禁止された投機を最適化コンパイラへ伝える
+     *
+     * TieredJITManager::setSpeculationBlacklistListener に登録して使う。
+     * @param functionId 禁止した位置の関数ID
+     * @param blacklist その関数の禁止リスト全体
+     */
+    void setSpeculationBlacklist(uint64_t functionId, const SpeculationBlacklist& blacklist);
+    
+    /**
+     * @brief 最適化コードに実行打ち切りフラグを確認させる
+     * @param state エンジンの打ち切り状態（JITManager より長く生きる）
+     */
+    void setTerminationState(const TerminationState* state);
+    
+    /**
+     * @brief 関数IDから実行時の関数を引く（最適化コンパイルの入力を作るのに使う）
+     */
+    using FunctionResolver = std::function<Function*(uint64_t functionId)>;
+    void setFunctionResolver(FunctionResolver resolver);
+    
+    /**
+     * @brief 完了した最適化コンパイルを導入する
+     *
+     * メインスレッドのセーフポイント（関数の入口など）で呼ぶ。前提にしたシェイプや
+     * グローバル変数が変わっていたコードは破棄され、次のティアアップで再び要求される。
+     * @return 導入した関数の数
+     */
+    size_t installFinishedCompilations();
+    
+    /**
+     * @brief 導入済みの最適化コード（なければ nullptr）
+     */
+    NativeCode* getOptimizedCode(uint32_t functionId) const;
+    
     /**
      * @brief 最適化ポリシーを設定
      * @param policy 新しいポリシー
@@ -177,7 +224,7 @@ public:
      * @brief 実行プロファイラを取得
      * @return プロファイラへの参照
      */
-    JITProfiler& profiler() { return m_profiler; }
+    JITProfiler& profiler() { return *m_profiler; }
     
     /**
      * @brief コンパイル統計情報を取得
@@ -202,6 +249,11 @@ private:
      */
     CompiledCodePtr compileFunction(uint32_t functionId, const std::vector<Bytecode>& bytecodes, JITOptimizationTier targetTier);
     
+    /**
+     * @brief 最適化コンパイルを OptimizingJIT::compileConcurrently で要求する
+     */
+    void requestOptimizedCompile(uint32_t functionId, FunctionCompilationState& state, JITOptimizationTier targetTier);
+    
     /**
      * @brief 関数の状態を取得または作成
      * @param functionId 関数ID
@@ -222,8 +274,8 @@ private:
     std::unique_ptr<OptimizingJIT> m_optimizingJIT;
     std::unique_ptr<SuperOptimizingJIT> m_superOptimizingJIT;
     
-    // 実行プロファイラ
-    JITProfiler m_profiler;
+    // 実行プロファイラ（ヘッダに定義を持ち込まないようヒープに置く）
+    std::unique_ptr<JITProfiler> m_profiler;
     
     // コンパイル済み関数のキャッシュ
     std::unordered_map<uint32_t, CompiledCodePtr> m_compiledFunctions;
@@ -234,6 +286,11 @@ private:
     // OSRエントリポイントのキャッシュ
     std::map<std::string, CompiledCodePtr> m_osrEntryPoints;
     
+    // 導入待ちの最適化コンパイル（目標階層とジョブ）と導入済みのコード
+    FunctionResolver m_functionResolver;
+    std::unordered_map<uint32_t, std::pair<JITOptimizationTier, std::shared_ptr<OptimizingCompileJob>>> m_optimizingJobs;
+    std::unordered_map<uint32_t, NativeCode*> m_optimizedCode;
+    
     // 最適化ポリシー
     JITOptimizerPolicy m_policy;
     
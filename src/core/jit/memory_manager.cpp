@@ -1,5 +1,10 @@
 #include "memory_manager.h"
 
+#include "code_space.h"
+#include "../../utils/memory/allocators/large_pages.h"
+
+#include <algorithm>
+
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -80,19 +85,36 @@ void free_executable_memory(void* ptr, size_t size) noexcept {
 }
 
 // 新しいMemoryManagerクラスの実装
-MemoryManager::MemoryManager() : m_totalAllocatedMemory(0) {}
+MemoryManager::MemoryManager()
+    : m_totalAllocatedMemory(0),
+      m_largePagesEnabled(utils::memory::largePageMode() != utils::memory::LargePageMode::Disabled),
+      m_currentArena(kNoArena),
+      m_largePageCodeBytes(0) {}
 
 MemoryManager::~MemoryManager() {
     // 確保したすべてのメモリ領域を解放
     std::lock_guard<std::mutex> lock(m_mutex);
     for (const auto& [ptr, region] : m_memoryRegions) {
+        if (region.dualMapped) {
+            CodeSpace::shared().free(ptr);
+            continue;
+        }
+        if (region.arenaIndex != kNoArena) {
+            continue;
+        }
         #ifdef _WIN32
         VirtualFree(region.baseAddress, 0, MEM_RELEASE);
         #else
         munmap(region.baseAddress, region.size);
         #endif
     }
+    for (const CodeArena& arena : m_arenas) {
+        if (arena.base) {
+            utils::memory::unmapLargePageRegion(arena.base, kCodeArenaSize);
+        }
+    }
     m_memoryRegions.clear();
+    m_arenas.clear();
     m_totalAllocatedMemory = 0;
 }
 
@@ -112,7 +134,102 @@ size_t MemoryManager::alignToPageSize(size_t size) {
     return (size + pageSize - 1) & ~(pageSize - 1);
 }
 
+void MemoryManager::setLargePagesEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_largePagesEnabled = enabled;
+}
+
+bool MemoryManager::isLargePagesEnabled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_largePagesEnabled;
+}
+
+bool MemoryManager::isLargePageBacked(const void* ptr) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_memoryRegions.find(const_cast<void*>(ptr));
+    if (it == m_memoryRegions.end() || it->second.arenaIndex == kNoArena) {
+        return false;
+    }
+    return m_arenas[it->second.arenaIndex].hugePages;
+}
+
+size_t MemoryManager::getLargePageCodeBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_largePageCodeBytes;
+}
+
+// m_mutex を保持して呼ぶ
+void* MemoryManager::allocateFromArena(size_t size) {
+    size_t alignedSize = alignToPageSize(size);
+
+    if (m_currentArena == kNoArena || m_arenas[m_currentArena].top + alignedSize > kCodeArenaSize) {
+        utils::memory::LargePageBacking backing = utils::memory::LargePageBacking::SmallPages;
+        void* base = utils::memory::mapLargePageRegion(kCodeArenaSize, &backing);
+        if (!base) {
+            return nullptr;
+        }
+
+        // 使い切ったアリーナは、生きているコードがなくなった時点で解放する
+        size_t previous = m_currentArena;
+        m_arenas.push_back(CodeArena{base, 0, 0, backing != utils::memory::LargePageBacking::SmallPages});
+        m_currentArena = m_arenas.size() - 1;
+        m_totalAllocatedMemory += kCodeArenaSize;
+        if (previous != kNoArena && m_arenas[previous].liveAllocations == 0) {
+            releaseArenaAllocation(previous);
+        }
+    }
+
+    CodeArena& arena = m_arenas[m_currentArena];
+    void* codePtr = static_cast<uint8_t*>(arena.base) + arena.top;
+
+    // 未使用部分はマップしたときのまま読み書き可能なので、保護は変えない。
+    // アリーナの他のコードは実行中かもしれないため、アリーナ全体の保護は切り替えない
+    arena.top += alignedSize;
+    arena.liveAllocations++;
+    m_memoryRegions[codePtr] = MemoryRegion{codePtr, alignedSize, MemoryProtection::ReadWrite, m_currentArena};
+    if (arena.hugePages) {
+        m_largePageCodeBytes += alignedSize;
+    }
+    return codePtr;
+}
+
+// m_mutex を保持して呼ぶ
+void MemoryManager::releaseArenaAllocation(size_t arenaIndex) {
+    CodeArena& arena = m_arenas[arenaIndex];
+    if (arena.liveAllocations > 0) {
+        arena.liveAllocations--;
+    }
+    if (arena.liveAllocations == 0 && arenaIndex != m_currentArena && arena.base) {
+        utils::memory::unmapLargePageRegion(arena.base, kCodeArenaSize);
+        arena.base = nullptr;
+        m_totalAllocatedMemory -= kCodeArenaSize;
+    }
+}
+
 void* MemoryManager::allocateExecutableMemory(size_t size) {
+    // 二重マッピングのコード領域から切り出す（書き込みは別名から行い、保護を変えない。
+    // コンパイラスレッドが導入する間も他のコードは実行を続けられる）
+    CodeSpace& codeSpace = CodeSpace::shared();
+    if (codeSpace.isAvailable()) {
+        if (void* codePtr = codeSpace.allocate(size)) {
+            size_t chunkSize = codeSpace.allocationSize(codePtr);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_memoryRegions[codePtr] = MemoryRegion{codePtr, chunkSize, MemoryProtection::ReadExecute, kNoArena, true};
+            m_totalAllocatedMemory += chunkSize;
+            return codePtr;
+        }
+    }
+
+    // 二重マッピングが使えなければ、小さいコードはラージページのアリーナから切り出す
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_largePagesEnabled && size > 0 && size <= kMaxArenaAllocation) {
+            if (void* codePtr = allocateFromArena(size)) {
+                return codePtr;
+            }
+        }
+    }
+
     // サイズをページ境界に合わせる
     size_t alignedSize = alignToPageSize(size);
     
@@ -145,13 +262,26 @@ void* MemoryManager::allocateExecutableMemory(size_t size) {
 
     // 領域の登録
     std::lock_guard<std::mutex> lock(m_mutex);
-    MemoryRegion region{base, totalSize, MemoryProtection::ReadWrite};
+    MemoryRegion region{base, totalSize, MemoryProtection::ReadWrite, kNoArena};
     m_memoryRegions[codePtr] = region;
     m_totalAllocatedMemory += totalSize;
 
     return codePtr;
 }
 
+void* MemoryManager::getWritableAddress(void* ptr) const {
+    if (void* writable = CodeSpace::shared().writableAddress(ptr)) {
+        return writable;
+    }
+    return ptr;
+}
+
+bool MemoryManager::isDualMapped(const void* ptr) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_memoryRegions.find(const_cast<void*>(ptr));
+    return it != m_memoryRegions.end() && it->second.dualMapped;
+}
+
 bool MemoryManager::protectMemory(void* ptr, size_t size, MemoryProtection protection) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
@@ -161,8 +291,26 @@ bool MemoryManager::protectMemory(void* ptr, size_t size, MemoryProtection prote
         return false;
     }
     
+    // 二重マッピングの領域は実行用・書き込み用の別名の保護が固定されている
+    if (it->second.dualMapped) {
+        if (protection != MemoryProtection::ReadExecute && protection != MemoryProtection::ReadWrite) {
+            return false;
+        }
+        if (protection == MemoryProtection::ReadExecute) {
+            flushInstructionCache(ptr, size);
+        }
+        return true;
+    }
+    
     // アライメント済みサイズの計算
     size_t alignedSize = alignToPageSize(size);
+
+    // アリーナ上のコードは、この割り当てが所有するページだけを切り替える
+    // （同じアリーナの他のコードは別のスレッドが実行・導入している可能性がある。
+    // 一部のページの保護変更でラージページのマッピングは分割される）
+    if (it->second.arenaIndex != kNoArena) {
+        alignedSize = std::min(alignedSize, it->second.size);
+    }
     
     #ifdef _WIN32
     DWORD protectFlags;
@@ -240,6 +388,22 @@ bool MemoryManager::freeMemory(void* ptr) {
     }
     
     const MemoryRegion& region = it->second;
+
+    if (region.dualMapped) {
+        CodeSpace::shared().free(ptr);
+        m_totalAllocatedMemory -= region.size;
+        m_memoryRegions.erase(it);
+        return true;
+    }
+
+    if (region.arenaIndex != kNoArena) {
+        if (m_arenas[region.arenaIndex].hugePages) {
+            m_largePageCodeBytes -= region.size;
+        }
+        releaseArenaAllocation(region.arenaIndex);
+        m_memoryRegions.erase(it);
+        return true;
+    }
     
     #ifdef _WIN32
     bool result = VirtualFree(region.baseAddress, 0, MEM_RELEASE) != 0;
@@ -256,12 +420,15 @@ bool MemoryManager::freeMemory(void* ptr) {
 }
 
 void MemoryManager::flushInstructionCache(void* ptr, size_t size) {
-    #ifdef _WIN32
-    FlushInstructionCache(GetCurrentProcess(), ptr, size);
-    #else
-    __builtin___clear_cache(reinterpret_cast<char*>(ptr), 
-                           reinterpret_cast<char*>(ptr) + size);
-    #endif
+    CodeSpace::flushRange(ptr, size);
+}
+
+void MemoryManager::flushInstructionCache(const std::vector<std::pair<void*, size_t>>& ranges) {
+    CodeSpace::FlushBatch batch;
+    for (const auto& [ptr, size] : ranges) {
+        batch.add(ptr, size);
+    }
+    batch.flush();
 }
 
 size_t MemoryManager::getTotalAllocatedMemory() const {
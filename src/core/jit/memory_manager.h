@@ -4,6 +4,7 @@
 #include <vector>
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 
 namespace aerojs {
 namespace core {
@@ -35,8 +36,26 @@ public:
      */
     void* allocateExecutableMemory(size_t size);
 
+    /**
+     * @brief コードを書き込むためのアドレスを取得
+     *
+     * 二重マッピングのコード領域（CodeSpace）から確保したコードは、実行用アドレスが
+     * 常に読み取り・実行専用なので、書き込みはここで得た別名から行う。
+     * それ以外の領域では ptr をそのまま返す（protectMemory で書き込み可能にしてから書く）。
+     */
+    void* getWritableAddress(void* ptr) const;
+
+    /**
+     * @brief 二重マッピングのコード領域から確保したか
+     */
+    bool isDualMapped(const void* ptr) const;
+
     /**
      * @brief メモリ保護設定の変更
+     *
+     * 二重マッピングのコード領域では保護を変えない（ReadExecute / ReadWrite は
+     * 何もせずに成功し、書き込みは getWritableAddress() の別名から行う）。
+     *
      * @param ptr メモリ領域のポインタ
      * @param size メモリ領域のサイズ
      * @param protection 設定する保護モード
@@ -52,28 +71,81 @@ public:
     bool freeMemory(void* ptr);
 
     /**
-     * @brief 命令キャッシュをフラッシュ
+     * @brief 命令キャッシュをフラッシュ（CodeSpace::FlushScope の中ではスコープの終わりにまとめる）
      * @param ptr メモリ領域の開始ポインタ
      * @param size メモリ領域のサイズ
      */
     void flushInstructionCache(void* ptr, size_t size);
 
+    /**
+     * @brief 複数の範囲の命令キャッシュをまとめてフラッシュ
+     *
+     * 隣接・重複する範囲をまとめ、コアの同期が要るアーキテクチャでも同期は1回で済ませる。
+     * ICのパッチのように小さな書き換えが続く場合に使う（CodeSpace::FlushScope の終わりにも呼ばれる）。
+     */
+    static void flushInstructionCache(const std::vector<std::pair<void*, size_t>>& ranges);
+
     /**
      * @brief 割り当てられたメモリの総量を取得
      * @return 割り当て済みメモリのバイト数
      */
     size_t getTotalAllocatedMemory() const;
 
+    /**
+     * @brief コードをラージページ（2MB）のアリーナに置くかどうか
+     *
+     * 二重マッピングのコード領域（CodeSpace）が使えない環境で有効にすると、以後の
+     * 小さいコードは2MB境界に揃えた2MBのアリーナから切り出す（MAP_HUGETLB か
+     * MADV_HUGEPAGE、使えなければ通常ページ）。アリーナは複数のコードで共有され、
+     * コンパイラスレッドの導入中も他のコードが実行されるため、保護の変更は
+     * 各割り当てが所有するページだけに行う（そのページのラージページは分割される）。
+     * 既定値は生成時のプロセス全体のラージページモード（EngineConfig::largePageMode）に従う。
+     */
+    void setLargePagesEnabled(bool enabled);
+    bool isLargePagesEnabled() const;
+
+    /**
+     * @brief コードがラージページで裏付けられたアリーナ上にあるか
+     *
+     * CodeEntry に CodeFlags::UsesLargePages を付けるかの判定に使う。
+     */
+    bool isLargePageBacked(const void* ptr) const;
+
+    /**
+     * @brief ラージページのアリーナに置かれているコードのバイト数
+     */
+    size_t getLargePageCodeBytes() const;
+
 private:
     struct MemoryRegion {
         void* baseAddress;
         size_t size;
         MemoryProtection currentProtection;
+        size_t arenaIndex;  // アリーナから切り出した場合のインデックス（それ以外は kNoArena）
+        bool dualMapped = false;  // CodeSpace から確保した
+    };
+
+    struct CodeArena {
+        void* base;
+        size_t top;               // 未使用領域の先頭オフセット
+        size_t liveAllocations;   // 解放されていない切り出し数
+        bool hugePages;           // ラージページで裏付けられているか
     };
 
+    static constexpr size_t kNoArena = static_cast<size_t>(-1);
+    static constexpr size_t kCodeArenaSize = size_t(2) << 20;       // アリーナ1つ = ラージページ1枚
+    static constexpr size_t kMaxArenaAllocation = kCodeArenaSize / 4;  // これより大きいコードは個別に確保
+
+    void* allocateFromArena(size_t size);
+    void releaseArenaAllocation(size_t arenaIndex);
+
     std::unordered_map<void*, MemoryRegion> m_memoryRegions;
     mutable std::mutex m_mutex;
     size_t m_totalAllocatedMemory;
+    bool m_largePagesEnabled;
+    std::vector<CodeArena> m_arenas;  // 解放済みのアリーナは base が nullptr
+    size_t m_currentArena;
+    size_t m_largePageCodeBytes;
 
     /**
      * @brief システムのページサイズを取得
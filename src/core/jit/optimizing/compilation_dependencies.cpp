@@ -0,0 +1,81 @@
+/**
+ * @file compilation_dependencies.cpp
+ * @brief 最適化コードが前提にするヒープ状態の追跡の実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "compilation_dependencies.h"
+
+#include <functional>
+
+namespace aerojs {
+namespace core {
+
+CompilationDependencies& CompilationDependencies::instance() {
+    static CompilationDependencies dependencies;
+    return dependencies;
+}
+
+size_t CompilationDependencies::globalBucket(const std::string& name) {
+    return std::hash<std::string>()(name) & (kGlobalBuckets - 1);
+}
+
+void CompilationDependencies::invalidateShape(uint64_t shapeId) {
+    m_shapeEpochs[shapeBucket(shapeId)].fetch_add(1, std::memory_order_acq_rel);
+}
+
+void CompilationDependencies::invalidateAllShapes() {
+    for (std::atomic<uint32_t>& epoch : m_shapeEpochs) {
+        epoch.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+void CompilationDependencies::invalidateGlobal(const std::string& name) {
+    GlobalBucket& bucket = m_globals[globalBucket(name)];
+    if (bucket.watched.load(std::memory_order_acquire)) {
+        bucket.epoch.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+uint32_t CompilationDependencies::watchGlobal(const std::string& name) {
+    GlobalBucket& bucket = m_globals[globalBucket(name)];
+    bucket.watched.store(true, std::memory_order_release);
+    return bucket.epoch.load(std::memory_order_acquire);
+}
+
+void CompilationDependencySet::addShape(uint64_t shapeId) {
+    for (const ShapeDependency& dependency : m_shapes) {
+        if (dependency.shapeId == shapeId) {
+            return;
+        }
+    }
+    m_shapes.push_back({shapeId, CompilationDependencies::instance().shapeEpoch(shapeId)});
+}
+
+void CompilationDependencySet::addGlobal(const std::string& name) {
+    for (const GlobalDependency& dependency : m_globals) {
+        if (dependency.name == name) {
+            return;
+        }
+    }
+    m_globals.push_back({name, CompilationDependencies::instance().watchGlobal(name)});
+}
+
+bool CompilationDependencySet::isValid() const {
+    const CompilationDependencies& dependencies = CompilationDependencies::instance();
+    for (const ShapeDependency& dependency : m_shapes) {
+        if (dependencies.shapeEpoch(dependency.shapeId) != dependency.epoch) {
+            return false;
+        }
+    }
+    for (const GlobalDependency& dependency : m_globals) {
+        if (dependencies.globalEpoch(dependency.name) != dependency.epoch) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace core
+} // namespace aerojs
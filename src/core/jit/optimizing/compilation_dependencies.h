@@ -0,0 +1,124 @@
+/**
+ * @file compilation_dependencies.h
+ * @brief 最適化コードが前提にするヒープ状態（シェイプ、グローバル変数）の追跡
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_COMPILATION_DEPENDENCIES_H
+#define AEROJS_COMPILATION_DEPENDENCIES_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief シェイプとグローバル変数ごとの変更世代
+ *
+ * 最適化コンパイルは入力を作る時点の世代を記録し、コードを導入する時点で
+ * 世代が変わっていなければ前提が保たれていると判断する。世代はハッシュで
+ * バケットに分けて持つため、衝突した別のシェイプ・変数の変更でも破棄される
+ * （保守的に外れるだけで、見落とすことはない）。
+ *
+ * グローバル変数への書き込みは頻繁なので、依存が一度でも登録された
+ * バケットだけ世代を進める。
+ */
+class CompilationDependencies {
+public:
+    static constexpr size_t kShapeBuckets = 4096;
+    static constexpr size_t kGlobalBuckets = 1024;
+
+    static CompilationDependencies& instance();
+
+    uint32_t shapeEpoch(uint64_t shapeId) const {
+        return m_shapeEpochs[shapeBucket(shapeId)].load(std::memory_order_acquire);
+    }
+
+    uint32_t globalEpoch(const std::string& name) const {
+        return m_globals[globalBucket(name)].epoch.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief シェイプがその場で変更されたことを通知する
+     */
+    void invalidateShape(uint64_t shapeId);
+
+    /**
+     * @brief すべてのシェイプの世代を進める（プロトタイプの変更など、影響範囲を特定できないとき）
+     */
+    void invalidateAllShapes();
+
+    /**
+     * @brief グローバル変数が書き換えられたことを通知する
+     */
+    void invalidateGlobal(const std::string& name);
+
+    /**
+     * @brief グローバル変数を依存先として監視し、現在の世代を返す
+     */
+    uint32_t watchGlobal(const std::string& name);
+
+    CompilationDependencies(const CompilationDependencies&) = delete;
+    CompilationDependencies& operator=(const CompilationDependencies&) = delete;
+
+private:
+    CompilationDependencies() = default;
+
+    static size_t shapeBucket(uint64_t shapeId) {
+        return static_cast<size_t>((shapeId * 0x9E3779B97F4A7C15ull) >> 52) & (kShapeBuckets - 1);
+    }
+
+    static size_t globalBucket(const std::string& name);
+
+    struct GlobalBucket {
+        std::atomic<uint32_t> epoch{0};
+        std::atomic<bool> watched{false};
+    };
+
+    std::array<std::atomic<uint32_t>, kShapeBuckets> m_shapeEpochs{};
+    std::array<GlobalBucket, kGlobalBuckets> m_globals;
+};
+
+/**
+ * @brief 1回のコンパイルが依存するシェイプとグローバル変数の世代
+ *
+ * メインスレッドで入力を作るときに記録し、導入時に isValid() で確かめる。
+ */
+class CompilationDependencySet {
+public:
+    void addShape(uint64_t shapeId);
+    void addGlobal(const std::string& name);
+
+    /**
+     * @brief 記録してから依存先が変更されていなければ true
+     */
+    bool isValid() const;
+
+    size_t size() const { return m_shapes.size() + m_globals.size(); }
+    bool empty() const { return size() == 0; }
+
+private:
+    struct ShapeDependency {
+        uint64_t shapeId;
+        uint32_t epoch;
+    };
+
+    struct GlobalDependency {
+        std::string name;
+        uint32_t epoch;
+    };
+
+    std::vector<ShapeDependency> m_shapes;
+    std::vector<GlobalDependency> m_globals;
+};
+
+} // namespace core
+} // namespace aerojs
+
+#endif // AEROJS_COMPILATION_DEPENDENCIES_H
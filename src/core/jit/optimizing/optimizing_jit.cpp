@@ -10,6 +10,7 @@
 #include <sstream>
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <unordered_set>
 
@@ -20,6 +21,8 @@
 #include "../deoptimizer/deoptimizer.h"
 #include "../code_cache.h"
 #include "../ic/inline_cache.h"
+#include "../../vm/bytecode/feedback_vector.h"
+#include "../backend/backend_options.h"
 
 // アーキテクチャ固有のバックエンド
 #ifdef __x86_64__
@@ -56,6 +59,8 @@ OptimizingJIT::OptimizingJIT(Context* context)
     , m_loopUnrollingCount(0)
     , m_deoptimizationCount(0)
     , m_functionId(0)
+    , m_stopCompilerThread(false)
+    , m_concurrentCompilation(true)
 {
     // 最適化パスを初期化
     initializeOptimizationPasses();
@@ -71,9 +76,13 @@ OptimizingJIT::OptimizingJIT(Context* context)
     }
 }
 
-OptimizingJIT::~OptimizingJIT() = default;
+OptimizingJIT::~OptimizingJIT() {
+    stopCompilerThread();
+}
 
 void OptimizingJIT::setOptimizationLevel(OptimizationLevel level) {
+    // バックグラウンドで使用中のパス設定を変えないよう、コンパイルの合間に切り替える
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
     m_optimizationLevel = level;
     
     // 最適化レベルに応じて最適化パスを有効/無効にする
@@ -196,19 +205,33 @@ bool OptimizingJIT::isOptimizationPassEnabled(const std::string& name) const {
 }
 
 NativeCode* OptimizingJIT::compile(Function* function) {
+    // 3つの段階を同じスレッドで続けて実行する
+    std::shared_ptr<OptimizingCompileJob> job = prepareCompilation(function);
+    if (!job || !executeCompilation(*job)) {
+        return nullptr;
+    }
+    return installCompilation(*job);
+}
+
+//-----------------------------------------------------------------------------
+// 段階1: 入力の作成（メインスレッド）
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<OptimizingCompileJob> OptimizingJIT::prepareCompilation(Function* function) {
     if (!function || !m_context) {
         return nullptr;
     }
     
-    m_functionId = function->id();
+    auto job = std::make_shared<OptimizingCompileJob>();
+    job->function = function;
+    OptimizingCompileJob::Input& input = job->input;
+    input.functionId = function->id();
+    input.symbolName = function->name();
     
     // コンパイルオプションを準備
-    CompileOptions options;
-    options.functionId = m_functionId;
-    options.context = m_context;
-    
-    // 最適化レベルに応じてオプションを調整
-    configureOptionsForOptimizationLevel(options);
+    input.options.functionId = input.functionId;
+    input.options.context = m_context;
+    configureOptionsForOptimizationLevel(input.options);
     
     // 実際のプロファイルデータAPIを実装
     ProfileData* profileData = collectProfileData(function, tier);
@@ -217,111 +240,170 @@ NativeCode* OptimizingJIT::compile(Function* function) {
         return nullptr;
     }
     
+    // プロファイラのデータは実行中に更新されるため、コピーをバックグラウンドに渡す
+    input.profile = std::make_shared<ProfileData>(*profileData);
+    input.options.profileData = input.profile.get();
+    
     // 関数のバイトコードを取得
-    std::vector<uint8_t> bytecodes;
-    if (!function->getBytecode(bytecodes) || bytecodes.empty()) {
+    if (!function->getBytecode(input.bytecodes) || input.bytecodes.empty()) {
         setError("バイトコードの取得に失敗しました");
         return nullptr;
     }
     
-    // コンパイル実行
-    auto startTime = std::chrono::high_resolution_clock::now();
+    // 前提にするシェイプとグローバル変数の世代を記録
+    collectDependencies(function, input.dependencies);
     
-    size_t codeSize = 0;
-    std::unique_ptr<uint8_t[]> machineCode = compileWithOptions(bytecodes, options, &codeSize);
+    // 禁止された投機（脱最適化を繰り返した位置）はコンパイル中に変わりうるのでコピーする
+    {
+        std::lock_guard<std::mutex> lock(m_speculationMutex);
+        input.speculationBlacklists = m_speculationBlacklists;
+    }
+    if (!input.speculationBlacklists.empty()) {
+        input.options.speculationBlacklists = &input.speculationBlacklists;
+    }
     
-    if (!machineCode || codeSize == 0) {
-        setError("コンパイルに失敗しました");
+    return job;
+}
+
+// プロファイラのデータを検証してコピーする
+std::shared_ptr<ProfileData> OptimizingJIT::snapshotProfile(uint64_t functionId) {
+    if (!m_profiler) {
         return nullptr;
     }
     
-    // コード領域の確保と機械語コードのコピー
-    NativeCode* nativeCode = m_context->getCodeCache()->allocateCode(codeSize, m_functionId);
-    if (!nativeCode) {
-        setError("コード領域の確保に失敗しました");
+    ProfileData* profileData = static_cast<ProfileData*>(m_profiler->getProfileData(functionId));
+    if (!profileData) {
         return nullptr;
     }
     
-    // 機械語コードをNativeCodeオブジェクトにコピー
-    memcpy(nativeCode->codeBuffer(), machineCode.get(), codeSize);
-    
-    // デオプティマイズ情報を設定
-    if (options.enableDeoptimizationSupport && m_typeGuards.size() > 0) {
-        nativeCode->setTypeGuards(m_typeGuards);
+    // プロファイル品質の検証
+    if (!validateProfileQuality(*profileData)) {
+        // プロファイル品質が不十分な場合は、より多くのサンプリングを促す
+        m_profiler->requestMoreSampling(functionId);
+        return nullptr;
     }
     
-    // メタデータを設定
-    nativeCode->setFunctionId(m_functionId);
-    nativeCode->setSymbolName(function->name().c_str());
-    nativeCode->setOptimizationLevel(static_cast<int>(m_optimizationLevel));
-    
-    // コンパイル時間を記録
-    auto endTime = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-    m_totalCompilationTimeMs += duration.count();
-    
-    // 統計情報を更新
-    updateCompilationStatistics(nativeCode, bytecodes.size(), codeSize);
+    return std::make_shared<ProfileData>(*profileData);
+}
+
+// 最適化コードが前提にするシェイプとグローバル変数を記録する
+void OptimizingJIT::collectDependencies(Function* function, CompilationDependencySet& dependencies) {
+    // プロパティアクセスのフィードバックにあるシェイプ（単型・多型とも特殊化に使われる）
+    if (const FeedbackVector* feedback = function->feedbackVector()) {
+        for (uint32_t slot = 0; slot < feedback->slotCount(); ++slot) {
+            if (feedback->kind(slot) != FeedbackSlotKind::kProperty) {
+                continue;
+            }
+            FeedbackSnapshot snapshot = feedback->snapshot(slot);
+            for (uint32_t i = 0; i < snapshot.entryCount; ++i) {
+                dependencies.addShape(snapshot.targets[i]);
+            }
+        }
+    }
     
-    // インラインキャッシュの初期設定
-    setupInlineCaches(nativeCode);
+    // 読み出すグローバル変数（値を定数として埋め込むことがある）
+    const auto& bytecode = function->getBytecode();
+    for (size_t pc = 0; pc < bytecode.size(); ) {
+        Opcode opcode = static_cast<Opcode>(bytecode[pc]);
+        if (opcode == Opcode::LoadGlobal) {
+            dependencies.addGlobal(function->getConstantName(bytecode[pc + 1]));
+        }
+        pc += getInstructionLength(opcode);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// 段階2: IR生成・最適化・コード生成（任意のスレッド）
+//-----------------------------------------------------------------------------
+
+bool OptimizingJIT::executeCompilation(OptimizingCompileJob& job) {
+    if (job.aborted.load(std::memory_order_acquire)) {
+        job.status.store(OptimizingCompileJob::Status::Discarded, std::memory_order_release);
+        return false;
+    }
     
-    return nativeCode;
+    job.status.store(OptimizingCompileJob::Status::Compiling, std::memory_order_release);
+    bool success = runPipeline(job.input, job);
+    job.status.store(success ? OptimizingCompileJob::Status::Compiled : OptimizingCompileJob::Status::Failed,
+                     std::memory_order_release);
+    return success;
 }
 
 std::unique_ptr<uint8_t[]> OptimizingJIT::compileWithOptions(
     const std::vector<uint8_t>& bytecodes,
-                                                             const CompileOptions& options, 
+    const CompileOptions& options,
     size_t* outCodeSize)
 {
     if (outCodeSize) {
         *outCodeSize = 0;
     }
     
-    if (bytecodes.empty()) {
-        setError("空のバイトコードは最適化できません");
+    // 呼び出し元のスレッドでプロファイルを取り出し、そのまま続けてコンパイルする
+    OptimizingCompileJob job;
+    job.input.functionId = options.functionId;
+    job.input.options = options;
+    if (options.enableTypeSpecialization) {
+        job.input.profile = snapshotProfile(options.functionId);
+    }
+    job.input.options.profileData = job.input.profile.get();
+    
+    if (!runPipeline(job.input, job) || !job.machineCode) {
         return nullptr;
     }
     
+    // 統計情報の更新
+    m_totalCompilationTimeMs += job.compilationTimeMs;
+    m_stats.totalCompilations++;
+    m_stats.totalCompiledBytecodeSizeBytes += bytecodes.size();
+    m_stats.totalGeneratedCodeSizeBytes += job.codeSize;
+    m_stats.totalTypeGuardsGenerated += job.typeGuards.size();
+    m_stats.totalInlinedFunctions += job.inliningCount;
+    m_stats.totalUnrolledLoops += job.loopUnrollingCount;
+    m_stats.averageBytecodeSizeBytes = 
+        static_cast<uint32_t>(m_stats.totalCompiledBytecodeSizeBytes / m_stats.totalCompilations);
+    m_stats.averageGeneratedCodeSizeBytes = 
+        static_cast<uint32_t>(m_stats.totalGeneratedCodeSizeBytes / m_stats.totalCompilations);
+    m_stats.averageCompilationTimeMs = 
+        static_cast<uint32_t>(m_totalCompilationTimeMs / m_stats.totalCompilations);
+    
+    if (outCodeSize) {
+        *outCodeSize = job.codeSize;
+    }
+    return std::move(job.machineCode);
+}
+
+bool OptimizingJIT::runPipeline(const OptimizingCompileJob::Input& input, OptimizingCompileJob& job)
+{
+    // input の中身とこのインスタンスのコンパイラ部品だけを使い、ヒープには触れない
+    const std::vector<uint8_t>& bytecodes = input.bytecodes;
+    if (bytecodes.empty()) {
+        job.error = "空のバイトコードは最適化できません";
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
+    
     // リクエスト元の情報をメモ
-    m_functionId = options.functionId;
+    m_functionId = input.functionId;
+    m_typeGuards.clear();
+    m_inliningCount = 0;
+    m_loopUnrollingCount = 0;
     
     // コンパイル時間測定開始
     auto compilationStart = std::chrono::high_resolution_clock::now();
     
     // 最適化レベルに基づいて実際のオプションを設定
-    CompileOptions effectiveOptions = options;
+    CompileOptions effectiveOptions = input.options;
     configureOptionsForOptimizationLevel(effectiveOptions);
     
-    // プロファイリングデータを使用する場合、ここで収集
-    void* profileData = nullptr;
-    if (m_profiler && options.enableTypeSpecialization) {
-        // プロファイリングデータの完全実装
-        profileData = m_profiler->getProfileData(m_functionId);
-        
-        // プロファイル品質の検証
-        if (profileData && !validateProfileQuality(*static_cast<ProfileData*>(profileData))) {
-            // プロファイル品質が不十分な場合は、より多くのサンプリングを促す
-            m_profiler->requestMoreSampling(m_functionId);
-            profileData = nullptr; // 低品質のプロファイルは使用しない
-        }
-        
-        // 型フィードバック情報の統合
-        if (profileData) {
-            integrateTypeFeedback(m_functionId, *static_cast<ProfileData*>(profileData), *m_irFunction);
-        }
-        
+    // プロファイルはコピーなので、ホットスポットの情報を書き加えてよい
+    ProfileData* profileData = input.profile.get();
+    if (profileData) {
         // ホットスポットの特定
-        identifyHotSpots(m_functionId, *static_cast<ProfileData*>(profileData), *m_irFunction);
+        identifyHotSpots(profileData);
         
         // ホットループの特定と最適化情報の付加
-        identifyHotLoops(m_functionId, *static_cast<ProfileData*>(profileData), *m_irFunction);
-    }
-    
-    // プロファイル情報なしでのベースライン最適化
-    if (!profileData) {
-        // 静的分析に基づく最適化
-        performStaticOptimizations(*m_irFunction);
+        identifyHotLoops(profileData);
     }
     
     // (1) IR生成フェーズ
@@ -334,23 +416,29 @@ std::unique_ptr<uint8_t[]> OptimizingJIT::compileWithOptions(
     }
     
     // バイトコードからIR（中間表現）を生成
-    m_irBuilder->setContext(options.context);
+    m_irBuilder->setContext(input.options.context);
     m_irBuilder->setProfileData(profileData);
     
     try {
         m_irFunction = m_irBuilder->buildFromBytecode(bytecodes.data(), bytecodes.size());
     } catch (const std::exception& e) {
-        setError(std::string("IR生成エラー: ") + e.what());
-        return nullptr;
+        job.error = std::string("IR生成エラー: ") + e.what();
+        return false;
     }
     
     if (!m_irFunction) {
-        setError("IR生成に失敗しました");
-        return nullptr;
+        job.error = "IR生成に失敗しました";
+        return false;
+    }
+    
+    // プロファイル情報なしでのベースライン最適化
+    if (!profileData) {
+        // 静的分析に基づく最適化
+        performStaticOptimizations(*m_irFunction);
     }
     
     auto irGenerationEnd = std::chrono::high_resolution_clock::now();
-    m_irGenerationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+    job.irGenerationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
         irGenerationEnd - irGenerationStart).count();
     
     // (2) 最適化フェーズ
@@ -360,55 +448,47 @@ std::unique_ptr<uint8_t[]> OptimizingJIT::compileWithOptions(
     // IR最適化を実行
     auto optimizedIR = optimizeIR(std::move(m_irFunction), effectiveOptions);
     if (!optimizedIR) {
-        setError("IR最適化に失敗しました");
-        return nullptr;
+        job.error = "IR最適化に失敗しました";
+        return false;
     }
     
-    // 最適化されたIRを保持
-    m_irFunction = std::move(optimizedIR);
-    
     auto optimizationEnd = std::chrono::high_resolution_clock::now();
-    m_optimizationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+    job.optimizationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
         optimizationEnd - optimizationStart).count();
     
     // (3) マシンコード生成フェーズ
     // ----------------------------
     auto codeGenStart = std::chrono::high_resolution_clock::now();
     
-    // マシンコードを生成
-    std::unique_ptr<uint8_t[]> machineCode = generateMachineCode(std::move(m_irFunction), effectiveOptions, outCodeSize);
-    if (!machineCode || (outCodeSize && *outCodeSize == 0)) {
-        setError("マシンコード生成に失敗しました");
-        return nullptr;
+    // マシンコードを生成（バックエンドがセーフポイントごとのフレーム状態を記録する）
+    size_t codeSize = 0;
+    FrameStateBuilder frameStates;
+    job.machineCode = generateMachineCode(std::move(optimizedIR), effectiveOptions, frameStates, &codeSize);
+    if (!job.machineCode || codeSize == 0) {
+        job.error = "マシンコード生成に失敗しました";
+        return false;
+    }
+    if (!frameStates.Empty()) {
+        job.frameStates = frameStates.Finish();
+        if (!job.frameStates) {
+            job.error = "フレーム状態の記録が不正です";
+            return false;
+        }
     }
     
     auto codeGenEnd = std::chrono::high_resolution_clock::now();
-    m_codeGenTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+    job.codeGenTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
         codeGenEnd - codeGenStart).count();
     
-    // (4) 統計情報更新・その他
+    // (4) 結果をジョブに移す
     // -----------------------
     auto compilationEnd = std::chrono::high_resolution_clock::now();
-    m_totalCompilationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+    job.compilationTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
         compilationEnd - compilationStart).count();
-    
-    // 統計情報の更新
-    m_stats.totalCompilations++;
-    m_stats.totalCompiledBytecodeSizeBytes += bytecodes.size();
-    m_stats.totalGeneratedCodeSizeBytes += *outCodeSize;
-    m_stats.totalTypeGuardsGenerated += m_typeGuards.size();
-    m_stats.totalInlinedFunctions += m_inliningCount;
-    m_stats.totalUnrolledLoops += m_loopUnrollingCount;
-    
-    // 平均値の更新
-    if (m_stats.totalCompilations > 0) {
-        m_stats.averageBytecodeSizeBytes = 
-            static_cast<uint32_t>(m_stats.totalCompiledBytecodeSizeBytes / m_stats.totalCompilations);
-        m_stats.averageGeneratedCodeSizeBytes = 
-            static_cast<uint32_t>(m_stats.totalGeneratedCodeSizeBytes / m_stats.totalCompilations);
-        m_stats.averageCompilationTimeMs = 
-            static_cast<uint32_t>(m_totalCompilationTimeMs / m_stats.totalCompilations);
-    }
+    job.codeSize = codeSize;
+    job.typeGuards = std::move(m_typeGuards);
+    job.inliningCount = m_inliningCount;
+    job.loopUnrollingCount = m_loopUnrollingCount;
     
     // 内部ステートをリセット
     m_typeGuards.clear();
@@ -419,22 +499,200 @@ std::unique_ptr<uint8_t[]> OptimizingJIT::compileWithOptions(
 #ifdef DEBUG
     {
         std::ostringstream logMsg;
-        logMsg << "関数 " << options.functionId << " の最適化コンパイル完了:\n"
+        logMsg << "関数 " << input.functionId << " の最適化コンパイル完了:\n"
                << "  バイトコードサイズ: " << bytecodes.size() << " バイト\n"
-               << "  生成コードサイズ: " << *outCodeSize << " バイト\n"
-               << "  IR生成時間: " << m_irGenerationTimeMs << " ms\n"
-               << "  最適化時間: " << m_optimizationTimeMs << " ms\n"
-               << "  コード生成時間: " << m_codeGenTimeMs << " ms\n"
-               << "  合計時間: " << m_totalCompilationTimeMs << " ms\n"
-               << "  インライン化関数数: " << m_inliningCount << "\n"
-               << "  展開されたループ数: " << m_loopUnrollingCount << "\n"
-               << "  型ガード数: " << m_typeGuards.size();
+               << "  生成コードサイズ: " << job.codeSize << " バイト\n"
+               << "  IR生成時間: " << job.irGenerationTimeMs << " ms\n"
+               << "  最適化時間: " << job.optimizationTimeMs << " ms\n"
+               << "  コード生成時間: " << job.codeGenTimeMs << " ms\n"
+               << "  合計時間: " << job.compilationTimeMs << " ms\n"
+               << "  インライン化関数数: " << job.inliningCount << "\n"
+               << "  展開されたループ数: " << job.loopUnrollingCount << "\n"
+               << "  型ガード数: " << job.typeGuards.size();
         // ロガーを使用した詳細なログ出力
         // Logger::instance().debug(logMsg.str());
     }
 #endif
     
-    return machineCode;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// 段階3: 導入（メインスレッド）
+//-----------------------------------------------------------------------------
+
+NativeCode* OptimizingJIT::installCompilation(OptimizingCompileJob& job) {
+    if (job.status.load(std::memory_order_acquire) != OptimizingCompileJob::Status::Compiled) {
+        if (!job.error.empty()) {
+            setError(job.error);
+        }
+        return nullptr;
+    }
+    
+    // コンパイル中に脱最適化された、または前提にしたシェイプ・グローバル変数が変わった
+    if (job.aborted.load(std::memory_order_acquire) || !job.input.dependencies.isValid()) {
+        job.status.store(OptimizingCompileJob::Status::Discarded, std::memory_order_release);
+        job.machineCode.reset();
+        m_stats.totalDiscardedCompilations++;
+        return nullptr;
+    }
+    
+    // コード領域の確保と機械語コードのコピー
+    NativeCode* nativeCode = m_context->getCodeCache()->allocateCode(job.codeSize, job.input.functionId);
+    if (!nativeCode) {
+        setError("コード領域の確保に失敗しました");
+        return nullptr;
+    }
+    
+    // 機械語コードをNativeCodeオブジェクトにコピー
+    memcpy(nativeCode->codeBuffer(), job.machineCode.get(), job.codeSize);
+    
+    // デオプティマイズ情報を設定
+    if (job.input.options.enableDeoptimizationSupport && job.typeGuards.size() > 0) {
+        nativeCode->setTypeGuards(job.typeGuards);
+    }
+    if (job.frameStates) {
+        Deoptimizer::Instance().RegisterCode(nativeCode->codeBuffer(), job.codeSize, job.frameStates,
+                                             job.input.functionId);
+    }
+    
+    // メタデータを設定
+    nativeCode->setFunctionId(job.input.functionId);
+    nativeCode->setSymbolName(job.input.symbolName.c_str());
+    nativeCode->setOptimizationLevel(static_cast<int>(m_optimizationLevel));
+    
+    // コンパイル時間を記録
+    m_totalCompilationTimeMs += job.compilationTimeMs;
+    m_irGenerationTimeMs = job.irGenerationTimeMs;
+    m_optimizationTimeMs = job.optimizationTimeMs;
+    m_codeGenTimeMs = job.codeGenTimeMs;
+    
+    // 統計情報を更新
+    updateCompilationStatistics(nativeCode, job);
+    
+    // インラインキャッシュの初期設定
+    setupInlineCaches(nativeCode);
+    
+    job.machineCode.reset();
+    job.status.store(OptimizingCompileJob::Status::Installed, std::memory_order_release);
+    return nativeCode;
+}
+
+//-----------------------------------------------------------------------------
+// バックグラウンドスレッド
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<OptimizingCompileJob> OptimizingJIT::compileConcurrently(Function* function) {
+    std::shared_ptr<OptimizingCompileJob> job = prepareCompilation(function);
+    if (!job) {
+        return nullptr;
+    }
+    
+    if (!m_concurrentCompilation) {
+        executeCompilation(*job);
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_finishedJobs.push_back(job);
+        return job;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        if (!m_compilerThread.joinable()) {
+            m_stopCompilerThread = false;
+            m_compilerThread = std::thread(&OptimizingJIT::compilerThreadMain, this);
+        }
+        m_pendingJobs.push_back(job);
+    }
+    m_jobCondition.notify_one();
+    return job;
+}
+
+void OptimizingJIT::compilerThreadMain() {
+    for (;;) {
+        std::shared_ptr<OptimizingCompileJob> job;
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobCondition.wait(lock, [this] { return m_stopCompilerThread || !m_pendingJobs.empty(); });
+            if (m_stopCompilerThread) {
+                return;
+            }
+            job = std::move(m_pendingJobs.front());
+            m_pendingJobs.pop_front();
+            m_runningJob = job;
+        }
+        
+        executeCompilation(*job);
+        
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_runningJob.reset();
+        m_finishedJobs.push_back(std::move(job));
+    }
+}
+
+size_t OptimizingJIT::installFinishedCompilations(
+    const std::function<void(Function*, NativeCode*)>& onInstalled)
+{
+    std::deque<std::shared_ptr<OptimizingCompileJob>> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        finished.swap(m_finishedJobs);
+    }
+    
+    size_t installed = 0;
+    for (const auto& job : finished) {
+        NativeCode* nativeCode = installCompilation(*job);
+        if (!nativeCode) {
+            continue;
+        }
+        installed++;
+        if (onInstalled) {
+            onInstalled(job->function, nativeCode);
+        }
+    }
+    return installed;
+}
+
+void OptimizingJIT::abortCompilations(uint64_t functionId) {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    auto abortIfMatches = [functionId](const std::shared_ptr<OptimizingCompileJob>& job) {
+        if (job && job->input.functionId == functionId) {
+            job->aborted.store(true, std::memory_order_release);
+        }
+    };
+    for (const auto& job : m_pendingJobs) {
+        abortIfMatches(job);
+    }
+    for (const auto& job : m_finishedJobs) {
+        abortIfMatches(job);
+    }
+    abortIfMatches(m_runningJob);
+}
+
+void OptimizingJIT::setConcurrentCompilation(bool enable) {
+    m_concurrentCompilation = enable;
+    if (!enable) {
+        stopCompilerThread();
+    }
+}
+
+void OptimizingJIT::stopCompilerThread() {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_stopCompilerThread = true;
+    }
+    m_jobCondition.notify_all();
+    if (m_compilerThread.joinable()) {
+        m_compilerThread.join();
+    }
+    
+    // 未着手のジョブは破棄する（関数は次のティアアップで再度要求される）
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    while (!m_pendingJobs.empty()) {
+        std::shared_ptr<OptimizingCompileJob> job = std::move(m_pendingJobs.front());
+        m_pendingJobs.pop_front();
+        job->aborted.store(true, std::memory_order_release);
+        job->status.store(OptimizingCompileJob::Status::Discarded, std::memory_order_release);
+    }
 }
 
 std::unique_ptr<IRFunction> OptimizingJIT::optimizeIR(
@@ -451,8 +709,10 @@ std::unique_ptr<IRFunction> OptimizingJIT::optimizeIR(
             m_typeSpecializer = std::make_unique<TypeSpecializer>();
         }
         
-        // 型特化を実行
-        if (!m_typeSpecializer->specialize(irFunction.get(), options.profileData)) {
+        // 型特化を実行（禁止された位置では int32/double に特化しない）
+        m_typeSpecializer->setSpeculationBlacklists(options.speculationBlacklists);
+        if (!m_typeSpecializer->specialize(irFunction.get(), static_cast<const ProfileData*>(options.profileData),
+                                           options.functionId)) {
             setError("型特化中にエラーが発生しました");
             return nullptr;
         }
@@ -498,31 +758,14 @@ std::unique_ptr<IRFunction> OptimizingJIT::optimizeIR(
 std::unique_ptr<uint8_t[]> OptimizingJIT::generateMachineCode(
     std::unique_ptr<IRFunction> irFunction,
     const CompileOptions& options,
+    FrameStateBuilder& frameStates,
     size_t* outCodeSize)
 {
-    // アーキテクチャに応じたバックエンドの選択
-#if defined(AEROJS_ARCH_X86_64)
-    auto backendName = "X86_64Backend";
-#elif defined(AEROJS_ARCH_ARM64)
-    auto backendName = "ARM64Backend";
-#elif defined(AEROJS_ARCH_RISCV)
-    auto backendName = "RISCVBackend";
-#else
-    setError("対応するバックエンドが見つかりません");
-    return nullptr;
-#endif
-    
-    // バックエンドの初期化とコード生成
+#if defined(__x86_64__)
     try {
-        // バックエンドファクトリからインスタンスを取得
-        auto backend = BackendFactory::getInstance().createBackend(backendName);
-        if (!backend) {
-            setError(std::string(backendName) + " の初期化に失敗しました");
-            return nullptr;
-        }
-    
         // バックエンドオプションの設定
         BackendOptions backendOpts;
+        backendOpts.functionId = options.functionId;
         backendOpts.optimizationLevel = 
             static_cast<int>(m_optimizationLevel);
         backendOpts.enableSIMD = true;
@@ -530,19 +773,41 @@ std::unique_ptr<uint8_t[]> OptimizingJIT::generateMachineCode(
             (m_optimizationLevel >= OptimizationLevel::O2);
         backendOpts.enableDeoptSupport = 
             options.enableDeoptimizationSupport;
+        // ガードと呼び出しの戻り先で、インタプリタのスロットの置き場所を記録させる
+        backendOpts.frameStates = 
+            options.enableDeoptimizationSupport ? &frameStates : nullptr;
+        // 禁止された位置にはシェイプガードや範囲・溢れのチェックによる投機を置かない
+        backendOpts.speculationBlacklists = options.speculationBlacklists;
         
         // マシンコード生成
-        auto result = backend->generateCode(irFunction.get(), backendOpts, outCodeSize);
-        if (!result || (outCodeSize && *outCodeSize == 0)) {
+        // プロファイラとエラーハンドラは JIT 側のコンテキストのもので、ここでは使わない
+        jit::X86_64CodeGenerator generator(nullptr);
+        generator.SetInterruptFlag(m_termination ? m_termination->flagAddress() : nullptr);
+        std::vector<uint8_t> code;
+        if (!generator.Generate(*irFunction, code, backendOpts) || code.empty()) {
             setError("コード生成に失敗しました");
             return nullptr;
         }
         
+        auto result = std::make_unique<uint8_t[]>(code.size());
+        std::memcpy(result.get(), code.data(), code.size());
+        if (outCodeSize) {
+            *outCodeSize = code.size();
+        }
         return result;
     } catch (const std::exception& e) {
         setError(std::string("コード生成中に例外が発生しました: ") + e.what());
         return nullptr;
     }
+#else
+    // セーフポイントを記録できるバックエンドは x86_64 のみ
+    (void)irFunction;
+    (void)options;
+    (void)frameStates;
+    (void)outCodeSize;
+    setError("対応するバックエンドが見つかりません");
+    return nullptr;
+#endif
 }
 
 void OptimizingJIT::configureOptionsForOptimizationLevel(CompileOptions& options)
@@ -586,15 +851,15 @@ void OptimizingJIT::configureOptionsForOptimizationLevel(CompileOptions& options
     }
 }
 
-void OptimizingJIT::updateCompilationStatistics(NativeCode* nativeCode, size_t bytecodeSize, size_t codeSize) {
+void OptimizingJIT::updateCompilationStatistics(NativeCode* nativeCode, const OptimizingCompileJob& job) {
     if (!nativeCode) {
         return;
     }
     
     m_stats.totalCompilations++;
-    m_stats.totalCompiledBytecodeSizeBytes += bytecodeSize;
-    m_stats.totalGeneratedCodeSizeBytes += codeSize;
-    m_stats.totalTypeGuardsGenerated += m_typeGuards.size();
+    m_stats.totalCompiledBytecodeSizeBytes += job.input.bytecodes.size();
+    m_stats.totalGeneratedCodeSizeBytes += job.codeSize;
+    m_stats.totalTypeGuardsGenerated += job.typeGuards.size();
     
     // 平均値の更新
     m_stats.averageBytecodeSizeBytes = m_stats.totalCompiledBytecodeSizeBytes / m_stats.totalCompilations;
@@ -602,8 +867,8 @@ void OptimizingJIT::updateCompilationStatistics(NativeCode* nativeCode, size_t b
     m_stats.averageCompilationTimeMs = m_totalCompilationTimeMs / m_stats.totalCompilations;
     
     // 最適化統計の更新
-    m_stats.totalInlinedFunctions += m_inliningCount;
-    m_stats.totalUnrolledLoops += m_loopUnrollingCount;
+    m_stats.totalInlinedFunctions += job.inliningCount;
+    m_stats.totalUnrolledLoops += job.loopUnrollingCount;
 }
 
 void OptimizingJIT::setupInlineCaches(NativeCode* nativeCode) {
@@ -647,6 +912,7 @@ void OptimizingJIT::setupInlineCaches(NativeCode* nativeCode) {
 }
 
 void OptimizingJIT::reset() {
+    std::lock_guard<std::mutex> lock(m_pipelineMutex);
     m_irFunction.reset();
     m_typeGuards.clear();
     
@@ -677,6 +943,9 @@ bool OptimizingJIT::handleDeoptimization(uint64_t functionId, const Deoptimizati
         return false;
     }
     
+    // 導入前のコンパイル結果は古い前提に基づくので捨てる
+    abortCompilations(functionId);
+    
     // デオプティマイズ回数を増加
     m_deoptimizationCount++;
     m_stats.totalDeoptimizations++;
@@ -692,6 +961,15 @@ bool OptimizingJIT::handleDeoptimization(uint64_t functionId, const Deoptimizati
     return result;
 }
 
+void OptimizingJIT::setSpeculationBlacklist(uint64_t functionId, const SpeculationBlacklist& blacklist) {
+    std::lock_guard<std::mutex> lock(m_speculationMutex);
+    if (blacklist.Empty()) {
+        m_speculationBlacklists.erase(functionId);
+    } else {
+        m_speculationBlacklists[functionId] = blacklist;
+    }
+}
+
 // プロファイルデータ収集の実装
 ProfileData* OptimizingJIT::collectProfileData(FunctionObject* function, OptimizationTier tier) {
     if (!m_profiler) {
@@ -752,8 +1030,72 @@ bool OptimizingJIT::validateProfileQuality(ProfileData* data, OptimizationTier t
     return true;
 }
 
+// 算術・比較の型ヒントから特殊化する型を決める（特殊化しない場合は Unknown）
+static JSValueType specializationTypeForHint(uint32_t hint) {
+    switch (hint) {
+        case BinaryOpHint::kSignedSmall:
+            return JSValueType::Integer;
+        case BinaryOpHint::kNumber:
+        case BinaryOpHint::kSignedSmall | BinaryOpHint::kNumber:
+            return JSValueType::Double;
+        case BinaryOpHint::kString:
+            return JSValueType::String;
+        case BinaryOpHint::kBigInt:
+            return JSValueType::BigInt;
+        default:
+            return JSValueType::Unknown;
+    }
+}
+
+// 関数のフィードバックベクタから候補を集める
+// 別スレッドで実行中の関数が書き込んでいても snapshot() で一貫した値を読める
+static void collectFeedbackCandidates(ProfileData* data, const FeedbackVector& feedback) {
+    for (uint32_t slot = 0; slot < feedback.slotCount(); ++slot) {
+        FeedbackSnapshot snapshot = feedback.snapshot(slot);
+        uint32_t pc = feedback.siteOffset(slot);
+        
+        switch (snapshot.kind) {
+            case FeedbackSlotKind::kProperty:
+                // 単型で実在するフィールドへのアクセスのみインライン展開する
+                if (snapshot.isMonomorphic() &&
+                    propertyHandlerKind(snapshot.handlers[0]) != PropertyHandlerKind::kAccessor) {
+                    data->inlineCandidates.push_back({pc, InlineType::PropertyAccess});
+                }
+                break;
+            
+            case FeedbackSlotKind::kCall:
+                if (snapshot.isMonomorphic()) {
+                    data->inlineCandidates.push_back({pc, InlineType::FunctionCall});
+                }
+                break;
+            
+            case FeedbackSlotKind::kBinaryOp:
+            case FeedbackSlotKind::kCompareOp: {
+                // 型特化のガードはヒントのビット和から投機を選ぶ
+                if (snapshot.hint != BinaryOpHint::kNone) {
+                    data->binaryOpHints[pc] = snapshot.hint;
+                }
+                JSValueType type = specializationTypeForHint(snapshot.hint);
+                if (type != JSValueType::Unknown) {
+                    data->specializationCandidates.push_back({pc, {type}});
+                }
+                break;
+            }
+            
+            default:
+                break;
+        }
+    }
+}
+
 // タイプフィードバック情報の統合
 void OptimizingJIT::integrateTypeFeedback(ProfileData* data, FunctionObject* function) {
+    // インタプリタとベースラインJITが集めたフィードバックベクタを優先する
+    if (const FeedbackVector* feedback = function->feedbackVector()) {
+        collectFeedbackCandidates(data, *feedback);
+        return;
+    }
+    
     // バイトコード命令ごとの型情報を収集
     const auto& bytecode = function->getBytecode();
     
@@ -8,13 +8,22 @@
 #ifndef AEROJS_OPTIMIZING_JIT_H
 #define AEROJS_OPTIMIZING_JIT_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <string>
 #include <chrono>
 #include <functional>
 
+#include "compilation_dependencies.h"
+#include "../deoptimizer/frame_state.h"
+#include "../../vm/exception/termination.h"
+
 namespace aerojs {
 namespace core {
 
@@ -27,6 +36,7 @@ class IROptimizer;
 class IRFunction;
 class Deoptimizer;
 class NativeCode;
+struct ProfileData;
 
 /**
  * @brief 最適化レベル定義
@@ -87,6 +97,9 @@ struct CompileOptions {
     uint32_t maxInliningDepth;
     uint32_t inliningThreshold;
     
+    /// 関数ごとの禁止された投機（型特化とガードの生成で、禁止された位置は汎用のコードにする）
+    const std::unordered_map<uint64_t, SpeculationBlacklist>* speculationBlacklists;
+    
     CompileOptions()
         : functionId(0)
         , context(nullptr)
@@ -98,9 +111,60 @@ struct CompileOptions {
         , enableDeoptimizationSupport(true)
         , maxInliningDepth(3)
         , inliningThreshold(50)
+        , speculationBlacklists(nullptr)
     {}
 };
 
+/**
+ * @brief 1回の最適化コンパイル
+ *
+ * 3つの段階で使う。
+ * 1. prepareCompilation()（メインスレッド）: バイトコード、プロファイル、依存する
+ *    シェイプとグローバル変数の世代をコピーして input を作る。以後 input は変更しない。
+ * 2. executeCompilation()（任意のスレッド）: input だけを読んでIR生成・最適化・
+ *    コード生成を行い、結果をこのジョブに書く。ヒープには触れない。
+ * 3. installCompilation()（メインスレッド）: 依存関係を検証し、CodeCache に導入する。
+ */
+struct OptimizingCompileJob {
+    enum class Status : uint8_t {
+        Prepared,    ///< 入力を作成済み
+        Compiling,   ///< バックグラウンドでコンパイル中
+        Compiled,    ///< 導入待ち
+        Failed,      ///< コンパイル失敗
+        Installed,   ///< 導入済み
+        Discarded    ///< 中止、または依存関係の変化で破棄
+    };
+    
+    struct Input {
+        uint64_t functionId = 0;
+        std::string symbolName;
+        std::vector<uint8_t> bytecodes;
+        CompileOptions options;                   ///< profileData は profile を、speculationBlacklists は下を指す
+        std::shared_ptr<ProfileData> profile;     ///< プロファイルのコピー（なければ nullptr）
+        std::unordered_map<uint64_t, SpeculationBlacklist> speculationBlacklists;  ///< 禁止された投機のコピー
+        CompilationDependencySet dependencies;
+    };
+    
+    Function* function = nullptr;
+    Input input;
+    
+    // バックグラウンド段階の出力
+    std::unique_ptr<uint8_t[]> machineCode;
+    size_t codeSize = 0;
+    std::vector<TypeGuard> typeGuards;
+    std::shared_ptr<const FrameStateTable> frameStates;  ///< セーフポイントのフレーム状態（脱最適化用）
+    uint32_t inliningCount = 0;
+    uint32_t loopUnrollingCount = 0;
+    uint64_t irGenerationTimeMs = 0;
+    uint64_t optimizationTimeMs = 0;
+    uint64_t codeGenTimeMs = 0;
+    uint64_t compilationTimeMs = 0;
+    std::string error;
+    
+    std::atomic<Status> status{Status::Prepared};
+    std::atomic<bool> aborted{false};   ///< 脱最適化などで結果が不要になった
+};
+
 /**
  * @brief 最適化JITコンパイラ
  */
@@ -120,6 +184,7 @@ public:
         uint32_t averageBytecodeSizeBytes;     ///< 平均バイトコードサイズ
         uint32_t averageGeneratedCodeSizeBytes; ///< 平均生成コードサイズ
         uint32_t averageCompilationTimeMs;     ///< 平均コンパイル時間
+        uint32_t totalDiscardedCompilations;   ///< 依存関係の変化や中止で破棄した数
         
         Statistics()
             : totalCompilations(0)
@@ -132,6 +197,7 @@ public:
             , averageBytecodeSizeBytes(0)
             , averageGeneratedCodeSizeBytes(0)
             , averageCompilationTimeMs(0)
+            , totalDiscardedCompilations(0)
         {}
     };
     
@@ -191,6 +257,55 @@ public:
      */
     bool shouldCompileFunction(uint64_t functionId);
     
+    /**
+     * @brief 入力を作成する（メインスレッド）
+     * @param function コンパイル対象の関数
+     * @return ジョブ（プロファイル不足などで最適化しない場合はnullptr）
+     */
+    std::shared_ptr<OptimizingCompileJob> prepareCompilation(Function* function);
+    
+    /**
+     * @brief IR生成・最適化・コード生成を行う（任意のスレッド）
+     * @param job prepareCompilation() で作成したジョブ
+     * @return 成功すればtrue
+     */
+    bool executeCompilation(OptimizingCompileJob& job);
+    
+    /**
+     * @brief 依存関係を検証してコードを導入する（メインスレッド）
+     * @param job executeCompilation() が成功したジョブ
+     * @return 導入したネイティブコード（破棄した場合はnullptr）
+     */
+    NativeCode* installCompilation(OptimizingCompileJob& job);
+    
+    /**
+     * @brief バックグラウンドスレッドでのコンパイルを要求する（メインスレッド）
+     *
+     * 並行コンパイルが無効ならその場でコンパイルし、導入だけを
+     * installFinishedCompilations() まで遅らせる。
+     * @return 要求したジョブ（最適化しない場合はnullptr）
+     */
+    std::shared_ptr<OptimizingCompileJob> compileConcurrently(Function* function);
+    
+    /**
+     * @brief 完了したジョブを導入する（メインスレッドのセーフポイントで呼ぶ）
+     * @param onInstalled 導入したコードごとに呼ぶコールバック
+     * @return 導入したジョブの数
+     */
+    size_t installFinishedCompilations(
+        const std::function<void(Function*, NativeCode*)>& onInstalled = nullptr);
+    
+    /**
+     * @brief 関数の未導入のジョブを中止する
+     * @param functionId 関数ID
+     */
+    void abortCompilations(uint64_t functionId);
+    
+    /**
+     * @brief 並行コンパイルの有効・無効を設定する（JITOptimizerPolicy::enableConcurrentCompilation）
+     */
+    void setConcurrentCompilation(bool enable);
+    
     /**
      * @brief インスタンスをリセットする
      */
@@ -216,6 +331,23 @@ public:
      */
     bool handleDeoptimization(uint64_t functionId, const DeoptimizationInfo& info);
     
+    /**
+     * @brief 関数のバイトコード位置ごとに禁止された投機を設定する
+     *
+     * 以後に prepareCompilation() するジョブから使う（インライン化した呼び出し先の分も含めて
+     * コピーする）。コンパイル中のジョブには影響しない。
+     */
+    void setSpeculationBlacklist(uint64_t functionId, const SpeculationBlacklist& blacklist);
+    
+    /**
+     * @brief 実行打ち切りフラグを確認するコードを生成させる
+     *
+     * 生成コードはプロローグとループの後方分岐で state のフラグを確認する。
+     * コンパイルを始める前に設定する（nullptrで確認しない）。
+     */
+    void setTerminationState(const TerminationState* state) { m_termination = state; }
+    const TerminationState* terminationState() const { return m_termination; }
+    
 private:
     // インスタンス変数
     Context* m_context;
@@ -231,6 +363,12 @@ private:
     std::unordered_map<std::string, bool> m_enabledPasses;
     std::vector<TypeGuard> m_typeGuards;
     
+    // 禁止された投機（脱最適化の記録から設定される）
+    std::mutex m_speculationMutex;
+    std::unordered_map<uint64_t, SpeculationBlacklist> m_speculationBlacklists;
+    
+    const TerminationState* m_termination = nullptr;
+    
     // 統計情報
     uint64_t m_totalCompilationTimeMs;
     uint64_t m_irGenerationTimeMs;
@@ -247,6 +385,19 @@ private:
     // エラーハンドリング
     std::string m_lastError;
     
+    // 並行コンパイル
+    // IRビルダーと最適化器はインスタンスで共有するため、バックグラウンド段階は
+    // m_pipelineMutex で直列化する（setOptimizationLevel もこれを取る）
+    std::mutex m_pipelineMutex;
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobCondition;
+    std::deque<std::shared_ptr<OptimizingCompileJob>> m_pendingJobs;
+    std::deque<std::shared_ptr<OptimizingCompileJob>> m_finishedJobs;
+    std::shared_ptr<OptimizingCompileJob> m_runningJob;
+    std::thread m_compilerThread;
+    bool m_stopCompilerThread;
+    bool m_concurrentCompilation;
+    
     // 内部メソッド
     void initializeOptimizationPasses();
     void addOptimizationPass(const std::string& name, OptimizationPassFunc func);
@@ -255,9 +406,17 @@ private:
     void setError(const std::string& message);
     
     std::unique_ptr<IRFunction> optimizeIR(std::unique_ptr<IRFunction> irFunction, const CompileOptions& options);
-    std::unique_ptr<uint8_t[]> generateMachineCode(std::unique_ptr<IRFunction> irFunction, const CompileOptions& options, size_t* outCodeSize);
+    std::unique_ptr<uint8_t[]> generateMachineCode(std::unique_ptr<IRFunction> irFunction, const CompileOptions& options,
+                                                   FrameStateBuilder& frameStates, size_t* outCodeSize);
     void configureOptionsForOptimizationLevel(CompileOptions& options);
-    void updateCompilationStatistics(NativeCode* nativeCode, size_t bytecodeSize, size_t codeSize);
+    void updateCompilationStatistics(NativeCode* nativeCode, const OptimizingCompileJob& job);
+    
+    // 並行コンパイルの内部処理
+    std::shared_ptr<ProfileData> snapshotProfile(uint64_t functionId);
+    void collectDependencies(Function* function, CompilationDependencySet& dependencies);
+    bool runPipeline(const OptimizingCompileJob::Input& input, OptimizingCompileJob& job);
+    void compilerThreadMain();
+    void stopCompilerThread();
     void setupInlineCaches(NativeCode* nativeCode);
 };
 
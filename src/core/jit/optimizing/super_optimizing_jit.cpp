@@ -384,6 +384,7 @@ void SuperOptimizingJIT::GenerateMachineCode(std::vector<uint8_t>& codeBuffer) n
 #if defined(__x86_64__) || defined(_M_X64)
   X86_64CodeGenerator codeGen;
   codeGen.SetProfileData(profile_data_.get());
+  codeGen.SetInterruptFlag(terminationState() ? terminationState()->flagAddress() : nullptr);
   codeGen.Generate(ir_, codeBuffer);
 #elif defined(__aarch64__)
   ARM64CodeGenerator codeGen;
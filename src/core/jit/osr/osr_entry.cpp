@@ -0,0 +1,178 @@
+/**
+ * @file osr_entry.cpp
+ * @brief オンスタックリプレイスメント（OSR）のフレーム変換とエントリスタブの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "osr_entry.h"
+
+#include <cstring>
+
+#include "../../runtime/values/value.h"
+
+namespace aerojs {
+namespace core {
+
+namespace {
+
+void emit32(std::vector<uint8_t>& code, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+void emit64(std::vector<uint8_t>& code, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+// 配置の表現に合わせて1つの値を変換する
+bool translateValue(uint64_t bits, OSRValueKind kind, uint64_t& out) {
+    switch (kind) {
+        case OSRValueKind::Tagged:
+            out = bits;
+            return true;
+        case OSRValueKind::Int32: {
+            Value value = Value::fromRawBits(bits);
+            if (!value.isInt32()) {
+                return false;
+            }
+            int64_t integer = static_cast<int32_t>(value.toNumber());
+            out = static_cast<uint64_t>(integer);
+            return true;
+        }
+        case OSRValueKind::Double: {
+            Value value = Value::fromRawBits(bits);
+            if (!value.isNumber()) {
+                return false;
+            }
+            double number = value.toNumber();
+            std::memcpy(&out, &number, sizeof(out));
+            return true;
+        }
+        case OSRValueKind::Dead:
+            break;
+    }
+    return false;
+}
+
+}  // namespace
+
+uint32_t OSREntryLayout::baselineFrameSize(size_t slotCount) {
+    // 呼び出し直後は RSP ≡ 8 (mod 16)。RBP と退避レジスタ5つを積むと再び ≡ 8 になるので、
+    // フレームの大きさも ≡ 8 (mod 16) にそろえる
+    size_t size = slotCount * 8;
+    if (size % 16 == 0) {
+        size += 8;
+    }
+    return static_cast<uint32_t>(size);
+}
+
+OSREntryLayout OSREntryLayout::baseline(uint32_t loopHeaderOffset, size_t localCount, size_t stackDepth) {
+    OSREntryLayout layout;
+    layout.loopHeaderOffset = loopHeaderOffset;
+    layout.frameSize = baselineFrameSize(localCount + stackDepth);
+    layout.locals.resize(localCount);
+    layout.stack.resize(stackDepth);
+
+    int32_t offset = -kCalleeSavedBytes;
+    for (OSRSlot& slot : layout.locals) {
+        offset -= 8;
+        slot = {OSRValueKind::Tagged, offset};
+    }
+    for (OSRSlot& slot : layout.stack) {
+        offset -= 8;
+        slot = {OSRValueKind::Tagged, offset};
+    }
+    return layout;
+}
+
+size_t OSREntryLayout::liveSlotCount() const {
+    size_t count = 0;
+    for (const OSRSlot& slot : locals) {
+        count += slot.kind != OSRValueKind::Dead;
+    }
+    for (const OSRSlot& slot : stack) {
+        count += slot.kind != OSRValueKind::Dead;
+    }
+    return count;
+}
+
+OSRFrameTranslator::Result OSRFrameTranslator::translate(const OSRFrameState& state,
+                                                         const OSREntryLayout& layout,
+                                                         std::vector<uint64_t>& frameBuffer) {
+    if (state.loopHeaderOffset != layout.loopHeaderOffset ||
+        state.locals.size() != layout.locals.size() ||
+        state.stack.size() != layout.stack.size()) {
+        return Result::FrameMismatch;
+    }
+
+    frameBuffer.clear();
+    frameBuffer.reserve(layout.liveSlotCount());
+    auto append = [&](const std::vector<uint64_t>& values, const std::vector<OSRSlot>& slots) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].kind == OSRValueKind::Dead) {
+                continue;
+            }
+            uint64_t translated;
+            if (!translateValue(values[i], slots[i].kind, translated)) {
+                return false;
+            }
+            frameBuffer.push_back(translated);
+        }
+        return true;
+    };
+    if (!append(state.locals, layout.locals) || !append(state.stack, layout.stack)) {
+        return Result::TypeMismatch;
+    }
+    return Result::Ok;
+}
+
+bool emitOSREntryStub(const OSREntryLayout& layout, const void* loopHeader, std::vector<uint8_t>& code) {
+#if defined(__x86_64__) || defined(_M_X64)
+    code.clear();
+
+    // 通常のプロローグ（EncodePrologueMinimal）と同じフレームを作る
+    code.push_back(0x55);                                          // push rbp
+    code.insert(code.end(), {0x48, 0x89, 0xE5});                   // mov rbp, rsp
+    code.push_back(0x53);                                          // push rbx
+    code.insert(code.end(), {0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});  // push r12〜r15
+    if (layout.frameSize > 0) {
+        code.insert(code.end(), {0x48, 0x81, 0xEC});               // sub rsp, imm32
+        emit32(code, layout.frameSize);
+    }
+
+    // バッファ（RDI）の値を配置の順にフレームへ置く
+    uint32_t bufferOffset = 0;
+    auto store = [&](const std::vector<OSRSlot>& slots) {
+        for (const OSRSlot& slot : slots) {
+            if (slot.kind == OSRValueKind::Dead) {
+                continue;
+            }
+            code.insert(code.end(), {0x48, 0x8B, 0x87});           // mov rax, [rdi + disp32]
+            emit32(code, bufferOffset);
+            code.insert(code.end(), {0x48, 0x89, 0x85});           // mov [rbp + disp32], rax
+            emit32(code, static_cast<uint32_t>(slot.frameOffset));
+            bufferOffset += 8;
+        }
+    };
+    store(layout.locals);
+    store(layout.stack);
+
+    // ループヘッダへ飛ぶ（本体がどこにあっても届くよう64ビット即値で）
+    code.insert(code.end(), {0x48, 0xB8});                         // mov rax, imm64
+    emit64(code, reinterpret_cast<uint64_t>(loopHeader));
+    code.insert(code.end(), {0xFF, 0xE0});                         // jmp rax
+    return true;
+#else
+    (void)layout;
+    (void)loopHeader;
+    (void)code;
+    return false;
+#endif
+}
+
+}  // namespace core
+}  // namespace aerojs
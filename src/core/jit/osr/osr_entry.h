@@ -0,0 +1,116 @@
+/**
+ * @file osr_entry.h
+ * @brief インタプリタのフレームからJITコードのループへ入るオンスタックリプレイスメント（OSR）
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief インタプリタのフレームのうち OSR で引き継ぐ状態
+ *
+ * 値は NaN-boxing のビット列（Value::getRawBits()）で持つ。オブジェクトはインタプリタの
+ * フレームが生きている間は到達可能なので、OSR コードへ渡している間に回収されることはない。
+ */
+struct OSRFrameState {
+    uint32_t loopHeaderOffset = 0;      // バックエッジの飛び先（ループヘッダの命令位置）
+    std::vector<uint64_t> locals;       // ローカル変数（インデックス順）
+    std::vector<uint64_t> stack;        // オペランドスタック（底から順）
+    void* context = nullptr;            // OSR コードへそのまま渡す実行コンテキスト
+    uint64_t result = 0;                // OSR コードが返した完了値（入れたときだけ有効）
+};
+
+/**
+ * @brief OSR エントリで値を置く表現
+ *
+ * ベースラインのフレームはすべて Tagged。最適化コードはループヘッダでの型の推測に合わせて
+ * Int32 / Double のまま受け取れる。Dead はループヘッダで使われない値で、読み込まない。
+ */
+enum class OSRValueKind : uint8_t {
+    Dead,
+    Tagged,
+    Int32,
+    Double
+};
+
+struct OSRSlot {
+    OSRValueKind kind = OSRValueKind::Dead;
+    int32_t frameOffset = 0;            // フレームポインタからのバイトオフセット
+};
+
+/**
+ * @brief ループヘッダでのコンパイル済みフレームの配置
+ *
+ * 生きている値（Dead 以外）は locals → stack の順にフレームバッファへ並べ、
+ * OSR エントリのスタブがそれぞれの frameOffset へ書き込む。
+ */
+struct OSREntryLayout {
+    // 通常のプロローグが退避するレジスタの大きさ（x86_64: RBX, R12〜R15）
+    static constexpr int32_t kCalleeSavedBytes = 5 * 8;
+
+    uint32_t loopHeaderOffset = 0;
+    uint32_t frameSize = 0;             // 退避レジスタより下に確保するバイト数
+    std::vector<OSRSlot> locals;        // ローカル変数 i の置き場所
+    std::vector<OSRSlot> stack;         // オペランドスタックの i 番目（底から）の置き場所
+
+    /**
+     * @brief ベースラインのフレーム配置
+     *
+     * ローカル変数、オペランドスタックの順に退避レジスタの直下から8バイトずつ並べる。
+     * フレームの大きさはスタックを16バイト境界に保つよう切り上げる（baselineFrameSize）。
+     */
+    static OSREntryLayout baseline(uint32_t loopHeaderOffset, size_t localCount, size_t stackDepth);
+    static uint32_t baselineFrameSize(size_t slotCount);
+
+    size_t liveSlotCount() const;
+};
+
+/**
+ * @brief インタプリタのフレームをコンパイル済みフレームの配置へ写す
+ */
+class OSRFrameTranslator {
+public:
+    enum class Result : uint8_t {
+        Ok,
+        FrameMismatch,  // ローカル変数・スタックの数が配置と合わない
+        TypeMismatch    // Int32 / Double の置き場所に合わない値がある
+    };
+
+    /**
+     * @brief 生きている値を配置の順に frameBuffer へ並べる
+     *
+     * Int32 の置き場所には符号拡張した整数、Double の置き場所には double のビット列を書く。
+     * 失敗したときはインタプリタで実行を続ける。
+     */
+    static Result translate(const OSRFrameState& state, const OSREntryLayout& layout,
+                            std::vector<uint64_t>& frameBuffer);
+};
+
+/**
+ * @brief OSR エントリの呼び出し形
+ *
+ * スタブは通常のプロローグと同じフレームを作ってからバッファの値を置き、ループヘッダへ飛ぶ。
+ * context は2番目の引数のレジスタのまま本体へ渡る。戻り値はコード単位の完了値。
+ */
+using OSREntryFunction = uint64_t (*)(const uint64_t* frameBuffer, void* context);
+
+/**
+ * @brief OSR エントリのスタブを生成する
+ *
+ * @param layout ループヘッダでのフレーム配置
+ * @param loopHeader 本体のループヘッダの機械語アドレス
+ * @param code 生成したスタブ（位置独立なので、どこへ複写してもよい）
+ * @return このアーキテクチャで生成できなければ false（現在は x86_64 のみ）
+ */
+bool emitOSREntryStub(const OSREntryLayout& layout, const void* loopHeader, std::vector<uint8_t>& code);
+
+}  // namespace core
+}  // namespace aerojs
@@ -0,0 +1,336 @@
+/**
+ * @file persistent_code_cache.cpp
+ * @brief 永続コードキャッシュの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "persistent_code_cache.h"
+#include "../vm/bytecode/bytecode_module.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace aerojs {
+namespace core {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43434A41;        // "AJCC"
+constexpr uint16_t kFormatVersion = 2;         // 2: ベースラインコードの階層を廃止
+constexpr const char* kFileExtension = ".ajcc";
+
+// ファイルはエンジンと同じマシンでしか読まないので、ネイティブのバイト順で書く
+// （アーキテクチャはビルドIDに含まれる）
+struct FileHeader {
+    uint32_t magic;
+    uint16_t formatVersion;
+    uint16_t headerSize;
+    uint64_t buildId;
+    uint64_t sourceHash;
+    uint64_t sourceLength;
+    uint64_t fileSize;
+    uint64_t checksum;           // ヘッダより後ろの全バイト
+    uint64_t bytecodeOffset;
+    uint64_t bytecodeSize;
+};
+
+inline uint64_t rotl(uint64_t value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+inline uint64_t loadWord(const uint8_t* data) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+// 4本の独立した乗算チェーンで32バイトずつ進める（大きなバンドルでも数ミリ秒で済む）
+uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t seed) {
+    constexpr uint64_t k1 = 0x9E3779B97F4A7C15ull;
+    constexpr uint64_t k2 = 0xC2B2AE3D27D4EB4Full;
+
+    uint64_t lanes[4] = {seed ^ k1, seed ^ k2, seed + k1, seed - k2};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            lanes[lane] = rotl(lanes[lane] ^ (loadWord(data + i + lane * 8) * k2), 31) * k1;
+        }
+    }
+    uint64_t hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+    hash ^= static_cast<uint64_t>(size) * k1;
+    for (; i + 8 <= size; i += 8) {
+        hash = rotl(hash ^ (loadWord(data + i) * k2), 27) * k1;
+    }
+    if (i < size) {
+        uint64_t tail = 0;
+        std::memcpy(&tail, data + i, size - i);
+        hash = rotl(hash ^ (tail * k2), 31) * k1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+const FileHeader& headerOf(const void* mapping) {
+    return *static_cast<const FileHeader*>(mapping);
+}
+
+// [offset, offset + size) がファイル内に収まるか
+bool inRange(uint64_t offset, uint64_t size, uint64_t limit) {
+    return offset <= limit && size <= limit - offset;
+}
+
+bool validateMapping(const void* mapping, size_t fileSize, uint64_t buildId,
+                     uint64_t sourceHash, uint64_t sourceLength) {
+    if (fileSize < sizeof(FileHeader)) {
+        return false;
+    }
+    const FileHeader& header = headerOf(mapping);
+    if (header.magic != kMagic || header.formatVersion != kFormatVersion ||
+        header.headerSize != sizeof(FileHeader) || header.fileSize != fileSize ||
+        header.buildId != buildId || header.sourceHash != sourceHash ||
+        header.sourceLength != sourceLength) {
+        return false;
+    }
+
+    if (!inRange(header.bytecodeOffset, header.bytecodeSize, fileSize)) {
+        return false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapping);
+    if (hashBytes(bytes + sizeof(FileHeader), fileSize - sizeof(FileHeader), header.buildId) != header.checksum) {
+        return false;
+    }
+    return true;
+}
+
+bool writeFully(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+// LoadedScript
+//-----------------------------------------------------------------------------
+
+PersistentCodeCache::LoadedScript::~LoadedScript() {
+    if (m_mapping) {
+        ::munmap(m_mapping, m_size);
+    }
+}
+
+std::unique_ptr<BytecodeModule> PersistentCodeCache::LoadedScript::bytecode() const {
+    const FileHeader& header = headerOf(m_mapping);
+    const uint8_t* begin = static_cast<const uint8_t*>(m_mapping) + header.bytecodeOffset;
+    std::vector<uint8_t> data(begin, begin + header.bytecodeSize);
+    return BytecodeModule::deserialize(data);
+}
+
+//-----------------------------------------------------------------------------
+// PersistentCodeCache
+//-----------------------------------------------------------------------------
+
+PersistentCodeCache::PersistentCodeCache(std::string directory)
+    : m_directory(std::move(directory)), m_buildId(engineBuildId()) {
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+}
+
+PersistentCodeCache::~PersistentCodeCache() = default;
+
+uint64_t PersistentCodeCache::hashSource(std::string_view source) {
+    return hashBytes(reinterpret_cast<const uint8_t*>(source.data()), source.size(), 0);
+}
+
+uint64_t PersistentCodeCache::engineBuildId() {
+    static const uint64_t buildId = [] {
+        std::string id;
+#ifdef AEROJS_BUILD_ID
+        id = AEROJS_BUILD_ID;
+#else
+        // ビルドIDが渡されない開発ビルドでは、このファイルのコンパイル日時で代用する
+        id = __DATE__ " " __TIME__;
+#endif
+#if defined(AEROJS_VERSION_MAJOR) && defined(AEROJS_VERSION_MINOR) && defined(AEROJS_VERSION_PATCH)
+        id += "|v" + std::to_string(AEROJS_VERSION_MAJOR) + "." + std::to_string(AEROJS_VERSION_MINOR) +
+              "." + std::to_string(AEROJS_VERSION_PATCH);
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+        id += "|x86_64";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        id += "|arm64";
+#elif defined(__riscv)
+        id += "|riscv";
+#endif
+#ifdef AEROJS_POINTER_COMPRESSION
+        id += "|compressed";
+#endif
+        id += "|ptr" + std::to_string(sizeof(void*));
+        return hashBytes(reinterpret_cast<const uint8_t*>(id.data()), id.size(), 0);
+    }();
+    return buildId;
+}
+
+std::string PersistentCodeCache::cachePath(uint64_t sourceHash) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx-%016llx%s",
+                  static_cast<unsigned long long>(sourceHash),
+                  static_cast<unsigned long long>(m_buildId), kFileExtension);
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+bool PersistentCodeCache::store(std::string_view source, const BytecodeModule& module) {
+    FileHeader header{};
+    header.magic = kMagic;
+    header.formatVersion = kFormatVersion;
+    header.headerSize = sizeof(FileHeader);
+    header.buildId = m_buildId;
+    header.sourceHash = hashSource(source);
+    header.sourceLength = source.size();
+
+    std::vector<uint8_t> bytecode = module.serialize();
+    if (bytecode.empty()) {
+        m_storeFailures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    header.bytecodeOffset = sizeof(FileHeader);
+    header.bytecodeSize = bytecode.size();
+    header.fileSize = sizeof(FileHeader) + bytecode.size();
+
+    std::vector<uint8_t> buffer;
+    buffer.reserve(header.fileSize);
+    buffer.resize(sizeof(FileHeader));
+    buffer.insert(buffer.end(), bytecode.begin(), bytecode.end());
+
+    header.checksum = hashBytes(buffer.data() + sizeof(FileHeader), buffer.size() - sizeof(FileHeader), m_buildId);
+    std::memcpy(buffer.data(), &header, sizeof(FileHeader));
+
+    // 同じディレクトリの一時ファイルに書いてから置き換え、読み手に書きかけを見せない
+    std::string path = cachePath(header.sourceHash);
+    static std::atomic<uint64_t> temporarySequence{0};
+    std::string temporary = path + ".tmp." + std::to_string(::getpid()) + "." +
+                            std::to_string(temporarySequence.fetch_add(1, std::memory_order_relaxed));
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        m_storeFailures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    bool written = writeFully(fd, buffer.data(), buffer.size());
+    written = (::close(fd) == 0) && written;
+    if (!written || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        m_storeFailures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_stores.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+std::unique_ptr<PersistentCodeCache::LoadedScript> PersistentCodeCache::load(std::string_view source) {
+    uint64_t sourceHash = hashSource(source);
+    std::string path = cachePath(sourceHash);
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || status.st_size <= 0) {
+        ::close(fd);
+        ::unlink(path.c_str());
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (!validateMapping(mapping, size, m_buildId, sourceHash, source.size())) {
+        ::munmap(mapping, size);
+        ::unlink(path.c_str());
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    return std::unique_ptr<LoadedScript>(new LoadedScript(mapping, size));
+}
+
+size_t PersistentCodeCache::removeStaleEntries() {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%016llx%s",
+                  static_cast<unsigned long long>(m_buildId), kFileExtension);
+
+    size_t removed = 0;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(m_directory, error)) {
+        std::string name = file.path().filename().string();
+        // 書き込み中の一時ファイルは他のプロセスのものかもしれないので触らない
+        if (name.size() < std::strlen(kFileExtension) ||
+            name.compare(name.size() - std::strlen(kFileExtension), std::string::npos, kFileExtension) != 0) {
+            continue;
+        }
+        if (name.size() >= std::strlen(suffix) &&
+            name.compare(name.size() - std::strlen(suffix), std::string::npos, suffix) == 0) {
+            continue;
+        }
+        std::error_code removeError;
+        if (std::filesystem::remove(file.path(), removeError)) {
+            removed++;
+        }
+    }
+    return removed;
+}
+
+void PersistentCodeCache::clear() {
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(m_directory, error)) {
+        if (file.path().extension() == kFileExtension) {
+            std::error_code removeError;
+            std::filesystem::remove(file.path(), removeError);
+        }
+    }
+}
+
+PersistentCodeCache::Stats PersistentCodeCache::getStats() const {
+    Stats stats;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.stores = m_stores.load(std::memory_order_relaxed);
+    stats.storeFailures = m_storeFailures.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace core
+} // namespace aerojs
@@ -0,0 +1,137 @@
+/**
+ * @file persistent_code_cache.h
+ * @brief プロセスをまたいでバイトコードを再利用するディスクキャッシュ
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace aerojs {
+namespace core {
+
+class BytecodeModule;
+
+/**
+ * @brief スクリプト単位の永続バイトコードキャッシュ
+ *
+ * キャッシュファイルは「ソースのハッシュ」と「エンジンのビルドID」で名前を付け、
+ * 1スクリプトにつき1ファイルを置く。中身は BytecodeModule::serialize() の出力。
+ *
+ * 機械語の保存は延期している。ベースラインコードも IC のミスハンドラや
+ * パッチポイントの絶対アドレスを直接埋め込んでおり、バックエンドはその位置を
+ * 記録していないため、別のプロセスへ再配置できない。ベースライン層を保存するには、
+ * バックエンドが絶対アドレス・呼び出し先・定数プールの参照ごとにリロケーションを
+ * 記録し、読み込み側が CodeSpace へ複写してからそれを当て直す必要がある。
+ *
+ * 読み込みはファイルを mmap して、ヘッダ・範囲・チェックサムを検証してから
+ * 使う。検証に失敗したファイルや別ビルドのファイルは削除する。書き込みは
+ * 一時ファイルに書いて rename するため、並行するプロセスが書きかけの
+ * ファイルを読むことはない。
+ */
+class PersistentCodeCache {
+public:
+    /**
+     * @brief mmap した1スクリプト分のキャッシュ
+     *
+     * 生存中はマッピングを保持する。bytecode() は中身を複写して復元するので、
+     * 復元した後に破棄してよい。
+     */
+    class LoadedScript {
+    public:
+        ~LoadedScript();
+
+        LoadedScript(const LoadedScript&) = delete;
+        LoadedScript& operator=(const LoadedScript&) = delete;
+
+        /**
+         * @brief バイトコードを復元する（失敗したら nullptr）
+         */
+        std::unique_ptr<BytecodeModule> bytecode() const;
+
+    private:
+        friend class PersistentCodeCache;
+
+        LoadedScript(void* mapping, size_t size) : m_mapping(mapping), m_size(size) {}
+
+        void* m_mapping;
+        size_t m_size;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;            // 読み込めたファイル
+        uint64_t misses = 0;          // ファイルがなかった
+        uint64_t rejected = 0;        // 検証に失敗して削除した
+        uint64_t stores = 0;          // 書き込んだファイル
+        uint64_t storeFailures = 0;   // 書き込みに失敗した
+    };
+
+    /**
+     * @param directory キャッシュディレクトリ（なければ作る）
+     */
+    explicit PersistentCodeCache(std::string directory);
+    ~PersistentCodeCache();
+
+    PersistentCodeCache(const PersistentCodeCache&) = delete;
+    PersistentCodeCache& operator=(const PersistentCodeCache&) = delete;
+
+    /**
+     * @brief ソーステキストのハッシュ（キャッシュキー）
+     */
+    static uint64_t hashSource(std::string_view source);
+
+    /**
+     * @brief エンジンのビルドID
+     *
+     * AEROJS_BUILD_ID が定義されていればそれを、なければバージョンとコンパイル日時を
+     * アーキテクチャ・ポインタ圧縮の有無と合わせてハッシュする。
+     */
+    static uint64_t engineBuildId();
+
+    /**
+     * @brief スクリプトのバイトコードを書き込む
+     * @param source スクリプトのソース（キーの計算と、読み込み時の長さ照合に使う）
+     */
+    bool store(std::string_view source, const BytecodeModule& module);
+
+    /**
+     * @brief スクリプトのキャッシュを読み込む（なければ・不正なら nullptr）
+     */
+    std::unique_ptr<LoadedScript> load(std::string_view source);
+
+    /**
+     * @brief 別のビルドIDで書かれたファイルを削除する
+     * @return 削除したファイルの数
+     */
+    size_t removeStaleEntries();
+
+    /**
+     * @brief キャッシュディレクトリ内のファイルをすべて削除する
+     */
+    void clear();
+
+    const std::string& directory() const { return m_directory; }
+    Stats getStats() const;
+
+private:
+    std::string cachePath(uint64_t sourceHash) const;
+
+    std::string m_directory;
+    uint64_t m_buildId;
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<uint64_t> m_stores{0};
+    std::atomic<uint64_t> m_storeFailures{0};
+};
+
+} // namespace core
+} // namespace aerojs
@@ -37,6 +37,9 @@ struct ProfileData {
   };
   
   std::vector<BranchInfo> branchHistory;  ///< 分岐履歴
+  
+  /// バイトコード位置ごとの算術・比較の型ヒント（BinaryOpHint のビット和）
+  std::unordered_map<uint32_t, uint32_t> binaryOpHints;
 };
 
 /**
@@ -311,6 +311,47 @@ bool JITProfiler::shouldDeoptimize(uint64_t functionId) const {
     return false;
 }
 
+void JITProfiler::RecordDeoptimization(uint64_t functionId, uint64_t nodeId, const std::string& reason) {
+    RecordDeoptimization(functionId, functionId, static_cast<uint32_t>(nodeId),
+                         core::SpeculationKind::None, reason);
+}
+
+bool JITProfiler::RecordDeoptimization(uint64_t functionId, uint64_t siteFunctionId, uint32_t bytecodeOffset,
+                                       core::SpeculationKind speculation, const std::string& reason,
+                                       uint32_t blacklistThreshold) {
+    std::lock_guard<std::mutex> lock(m_profileMutex);
+    
+    FunctionProfileData& profile = m_profiles[functionId];
+    profile.totalDeoptimizations++;
+    profile.deoptHistory.push_back({std::chrono::steady_clock::now(), siteFunctionId, bytecodeOffset,
+                                    speculation, reason});
+    while (profile.deoptHistory.size() > m_thresholds.deoptHistoryLength) {
+        profile.deoptHistory.pop_front();
+    }
+    
+    // 位置はインライン化された呼び出し先のものでありうるので、禁止はその関数に付ける
+    // （呼び出し元に再びインライン化されたときも効く）
+    FunctionProfileData& site = (siteFunctionId == functionId) ? profile : m_profiles[siteFunctionId];
+    return site.speculationBlacklist.RecordFailure(bytecodeOffset, speculation, blacklistThreshold);
+}
+
+std::vector<FunctionProfileData::DeoptimizationRecord> JITProfiler::GetDeoptHistory(uint64_t functionId) const {
+    std::lock_guard<std::mutex> lock(m_profileMutex);
+    
+    auto it = m_profiles.find(functionId);
+    if (it == m_profiles.end()) {
+        return {};
+    }
+    return {it->second.deoptHistory.begin(), it->second.deoptHistory.end()};
+}
+
+core::SpeculationBlacklist JITProfiler::GetSpeculationBlacklist(uint64_t functionId) const {
+    std::lock_guard<std::mutex> lock(m_profileMutex);
+    
+    auto it = m_profiles.find(functionId);
+    return it != m_profiles.end() ? it->second.speculationBlacklist : core::SpeculationBlacklist();
+}
+
 void JITProfiler::resetProfileData(uint64_t functionId) {
     std::lock_guard<std::mutex> lock(_profileMutex);
     _profiles.erase(functionId);
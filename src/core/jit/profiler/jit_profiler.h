@@ -20,6 +20,8 @@
 #include <functional>
 #include <array>
 
+#include "../deoptimizer/speculation.h"
+
 namespace aerojs {
 
 // 前方宣言
@@ -261,6 +263,20 @@ struct FunctionProfileData {
         bool success;
     };
     std::vector<OptimizationRecord> optimizationHistory;
+    
+    // 脱最適化の履歴（この関数の最適化コードで起きたもの、新しいものが後ろ）
+    struct DeoptimizationRecord {
+        std::chrono::steady_clock::time_point timestamp;
+        uint64_t siteFunctionId;           // 投機が外れた位置の関数（インライン化されていれば呼び出し先）
+        uint32_t bytecodeOffset;           // 投機が外れた位置
+        core::SpeculationKind speculation; // 外れた投機（遅延脱最適化では None）
+        std::string reason;
+    };
+    std::deque<DeoptimizationRecord> deoptHistory;
+    uint64_t totalDeoptimizations = 0;
+    
+    // この関数のバイトコード位置で禁止した投機（再コンパイル時に使わない）
+    core::SpeculationBlacklist speculationBlacklist;
 };
 
 // 呼び出しサイト情報
@@ -326,6 +342,17 @@ public:
     void RecordCompilation(uint64_t functionId, uint8_t tier, uint64_t codeSizeBytes);
     void RecordDeoptimization(uint64_t functionId, uint64_t nodeId, const std::string& reason);
     
+    /**
+     * 投機の失敗による脱最適化を記録する
+     *
+     * functionId の履歴に追加し、siteFunctionId の bytecodeOffset で speculation が
+     * blacklistThreshold 回外れたらその位置の投機を禁止する。
+     * @return この記録で新たに投機を禁止したら true
+     */
+    bool RecordDeoptimization(uint64_t functionId, uint64_t siteFunctionId, uint32_t bytecodeOffset,
+                              core::SpeculationKind speculation, const std::string& reason,
+                              uint32_t blacklistThreshold = 1);
+    
     // データ取得
     const FunctionProfileData& GetFunctionProfile(uint64_t functionId) const;
     const TypeObservation& GetTypeInfo(uint64_t functionId, uint64_t nodeId) const;
@@ -335,6 +362,8 @@ public:
     bool IsOnHotPath(uint64_t functionId, uint64_t nodeId) const;
     std::vector<CallSiteInfo> GetCallSites(uint64_t functionId) const;
     std::vector<uint64_t> GetHotLoops(uint64_t functionId) const;
+    std::vector<FunctionProfileData::DeoptimizationRecord> GetDeoptHistory(uint64_t functionId) const;
+    core::SpeculationBlacklist GetSpeculationBlacklist(uint64_t functionId) const;
     
     // 分析
     void AnalyzeProfiles();
@@ -410,6 +439,7 @@ private:
         float typeStabilityThreshold = 0.9f;     // 型安定性閾値
         float inliningBenefitThreshold = 0.5f;   // インライン化利益閾値
         uint32_t loopHotnessThreshold = 20;      // ループのホットさ閾値
+        uint32_t deoptHistoryLength = 64;        // 関数ごとに残す脱最適化の履歴数
     } m_thresholds;
     
     // ヘルパーメソッド
@@ -1,5 +1,7 @@
 #include "tiered_jit_manager.h"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <sstream>
 
 // このファイルに必要なヘッダーをグループ化
@@ -7,6 +9,7 @@
 #include "jit_optimizer.h"
 #include "baseline/baseline_jit.h"
 #include "optimizing/optimizing_jit.h"
+#include "deoptimizer/deoptimizer.h"
 #include "ir/ir_function.h" // IRFunction の定義
 #include "ir/ir_optimizer.h"
 #include "ir/constant_folding.h"
@@ -45,9 +48,17 @@ TieredJITManager::TieredJITManager()
     , m_tierDownThreshold(5)
     // m_bytecodeStore はデフォルトコンストラクタで初期化される
 {
+    // 脱最適化の履歴と投機の禁止リストを持つ
+    _profiler = std::make_unique<JITProfiler>();
+    
+    // 最適化コードの脱最適化を位置ごとに記録する
+    Deoptimizer::Instance().SetCallback([this](const DeoptimizationInfo& info, DeoptimizationReason reason) {
+        recordDeoptimization(info, reason);
+    });
 }
 
 TieredJITManager::~TieredJITManager() {
+    Deoptimizer::Instance().SetCallback(nullptr);
     Shutdown();
 }
 
@@ -306,7 +317,7 @@ uint32_t TieredJITManager::CompileFunction(uint32_t functionId, const std::vecto
                 state->isCompiling = false;
                 return 0;
             }
-            std::memcpy(executableMemory, generated_code.get(), codeSize);
+            std::memcpy(m_memoryManager->getWritableAddress(executableMemory), generated_code.get(), codeSize);
             if (!m_memoryManager->protectMemory(executableMemory, codeSize, MemoryProtection::ReadExecute)) {
                 std::cerr << "Error: Failed to set memory protection for functionId: " << functionId << std::endl;
                 m_memoryManager->freeMemory(executableMemory);
@@ -371,7 +382,7 @@ uint32_t TieredJITManager::CompileFunction(uint32_t functionId, const std::vecto
             
             codePtr = compiler->Compile(*irFunction, functionId);
             
-            if (codePtr && m_codeCache) {                // コードサイズの取得                size_t compiledCodeSize = compiler->GetCompiledCodeSize(functionId);                                if (compiledCodeSize == 0) {                    std::cerr << "Error: Could not determine compiled code size for functionId: " << functionId << std::endl;                    return 0;                }                                // メタデータを取得                JITCodeMetadata metadata;                compiler->GetCodeMetadata(functionId, &metadata);                                // 最適化されたコンパイル結果をメモリマネージャに登録                void* executableMemory = m_memoryManager->allocateExecutableMemory(compiledCodeSize);                if (!executableMemory) {                    std::cerr << "Error: Failed to allocate executable memory for optimized code, functionId: " << functionId << std::endl;                    return 0;                }                                // コンパイラから生成されたコードをコピー                std::memcpy(executableMemory, codePtr, compiledCodeSize);                                // メモリプロテクションを設定（読み取り可能・実行可能）                if (!m_memoryManager->protectMemory(executableMemory, compiledCodeSize, MemoryProtection::ReadExecute)) {                    std::cerr << "Error: Failed to set memory protection for optimized code, functionId: " << functionId << std::endl;                    m_memoryManager->freeMemory(executableMemory);                    return 0;                }                                // 命令キャッシュをフラッシュして最適化                m_memoryManager->flushInstructionCache(executableMemory, compiledCodeSize);                                // コードキャッシュに登録                CodeCacheEntry entry;                entry.codePtr = executableMemory;                entry.codeSize = compiledCodeSize;                entry.functionId = functionId;                entry.timestamp = std::chrono::steady_clock::now();                entry.tier = tier;                entry.metadata = metadata;                                if (m_codeCache->registerCode(entry)) {                    // エントリーポイントを取得                    uint32_t entryPoint = reinterpret_cast<uintptr_t>(executableMemory);                                        // 関数状態を更新                    UpdateFunctionState(functionId, tier, entryPoint, static_cast<uint32_t>(compiledCodeSize));                                        // プロファイリング情報を更新                    m_profiler->RecordCompilation(functionId, tier, compiledCodeSize);                                        // デバッグ情報の登録（開発モードのみ）                    #ifdef AEROJS_DEBUG                    if (metadata.debugInfo) {                        m_debugInfoRegistry->registerDebugInfo(functionId, tier, metadata.debugInfo);                    }                    #endif                                        // コンパイル完了                    state->isCompiling = false;                    return entryPoint;                } else {                    // CodeCache への登録失敗                    std::cerr << "Error: Failed to register optimized code to cache for functionId: " << functionId << std::endl;                    m_memoryManager->freeMemory(executableMemory);                    return 0;                }
+            if (codePtr && m_codeCache) {                // コードサイズの取得                size_t compiledCodeSize = compiler->GetCompiledCodeSize(functionId);                                if (compiledCodeSize == 0) {                    std::cerr << "Error: Could not determine compiled code size for functionId: " << functionId << std::endl;                    return 0;                }                                // メタデータを取得                JITCodeMetadata metadata;                compiler->GetCodeMetadata(functionId, &metadata);                                // 最適化されたコンパイル結果をメモリマネージャに登録                void* executableMemory = m_memoryManager->allocateExecutableMemory(compiledCodeSize);                if (!executableMemory) {                    std::cerr << "Error: Failed to allocate executable memory for optimized code, functionId: " << functionId << std::endl;                    return 0;                }                                // コンパイラから生成されたコードをコピー                std::memcpy(m_memoryManager->getWritableAddress(executableMemory), codePtr, compiledCodeSize);                                // メモリプロテクションを設定（読み取り可能・実行可能）                if (!m_memoryManager->protectMemory(executableMemory, compiledCodeSize, MemoryProtection::ReadExecute)) {                    std::cerr << "Error: Failed to set memory protection for optimized code, functionId: " << functionId << std::endl;                    m_memoryManager->freeMemory(executableMemory);                    return 0;                }                                // 命令キャッシュをフラッシュして最適化                m_memoryManager->flushInstructionCache(executableMemory, compiledCodeSize);                                // コードキャッシュに登録                CodeCacheEntry entry;                entry.codePtr = executableMemory;                entry.codeSize = compiledCodeSize;                entry.functionId = functionId;                entry.timestamp = std::chrono::steady_clock::now();                entry.tier = tier;                entry.metadata = metadata;                                if (m_codeCache->registerCode(entry)) {                    // エントリーポイントを取得                    uint32_t entryPoint = reinterpret_cast<uintptr_t>(executableMemory);                                        // 関数状態を更新                    UpdateFunctionState(functionId, tier, entryPoint, static_cast<uint32_t>(compiledCodeSize));                                        // プロファイリング情報を更新                    m_profiler->RecordCompilation(functionId, tier, compiledCodeSize);                                        // デバッグ情報の登録（開発モードのみ）                    #ifdef AEROJS_DEBUG                    if (metadata.debugInfo) {                        m_debugInfoRegistry->registerDebugInfo(functionId, tier, metadata.debugInfo);                    }                    #endif                                        // コンパイル完了                    state->isCompiling = false;                    return entryPoint;                } else {                    // CodeCache への登録失敗                    std::cerr << "Error: Failed to register optimized code to cache for functionId: " << functionId << std::endl;                    m_memoryManager->freeMemory(executableMemory);                    return 0;                }
             }
         }
     }
@@ -589,6 +600,9 @@ void TieredJITManager::EnableTieredCompilation(bool enable) {
 }
 
 void TieredJITManager::InvalidateFunction(uint32_t functionId) {
+    // 待機中・コンパイル中の要求を取り消す（コンパイル中の結果は完了時に捨てられる）
+    _compileQueue.cancel(functionId);
+    
     std::lock_guard<std::mutex> lock(m_stateMutex);
     
     auto it = m_functionStates.find(functionId);
@@ -698,6 +712,21 @@ std::string TieredJITManager::GetCompilationStatistics() const {
     ss << "  超最適化: " << superOptimizedCount << "\n";
     ss << "総関数数: " << m_functionStates.size() << "\n";
     
+    // コンパイルキューの待ち時間
+    CompileQueue::LatencyHistogram latency = _compileQueue.latencyHistogram();
+    CompileQueue::Stats queueStats = _compileQueue.getStats();
+    ss << "コンパイルキュー:\n";
+    ss << "  待機中: " << queueStats.pending << "\n";
+    ss << "  投入: " << queueStats.enqueued << " (統合: " << queueStats.coalesced
+       << ", 昇格: " << queueStats.upgraded << ", 拒否: " << queueStats.rejected
+       << ", 取消: " << queueStats.cancelled << ")\n";
+    if (latency.count > 0) {
+        ss << "  待ち時間(us): 平均 " << (latency.totalNs / latency.count / 1000)
+           << ", p50 < " << latency.percentileUpperBoundUs(0.50)
+           << ", p99 < " << latency.percentileUpperBoundUs(0.99)
+           << ", 最大 " << (latency.maxNs / 1000) << "\n";
+    }
+    
     // アーキテクチャ情報
 #if defined(AEROJS_ARCH_X86_64)
     ss << "アーキテクチャ: x86_64\n";
@@ -820,4 +849,730 @@ const FunctionExecutionState* TieredJITManager::GetFunctionState(uint32_t functi
     return nullptr;
 }
 
-} // namespace aerojs::core 
\ No newline at end of file
+// ---------------------------------------------------------------------------
+// コンパイルキュー
+// ---------------------------------------------------------------------------
+
+bool TieredJITManager::queueForCompilation(Function* function, JITTier targetTier, uint32_t priority) {
+    if (!function || targetTier == JITTier::Interpreter) {
+        return false;
+    }
+    uint64_t functionId = function->getId();
+    size_t tierIndex = static_cast<size_t>(targetTier);
+    
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        const FunctionJITState& functionState = _jitStates[functionId];
+        CompileState state = functionState.states[tierIndex];
+        if (state == CompileState::Completed || state == CompileState::Compiling) {
+            return false;
+        }
+        if (targetTier >= JITTier::Optimizing && functionState.optimizationDisabled) {
+            return false;
+        }
+    }
+    
+    // 同じ関数の要求はキュー側でまとめられる
+    if (!_compileQueue.push(functionId, function, targetTier, priority)) {
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        CompileState& state = _jitStates[functionId].states[tierIndex];
+        if (state != CompileState::Compiling && state != CompileState::Completed) {
+            state = CompileState::Queued;
+        }
+    }
+    
+    // コンパイルスレッドがなければその場で処理する
+    if (!_isCompilerRunning.load(std::memory_order_acquire)) {
+        processNextTask();
+    }
+    return true;
+}
+
+bool TieredJITManager::queueForOSRCompilation(Function* function, uint32_t bytecodeOffset,
+                                              JITTier targetTier, uint32_t priority) {
+    if (!function || targetTier == JITTier::Interpreter) {
+        return false;
+    }
+    uint64_t functionId = function->getId();
+    
+    if (!_compileQueue.push(functionId, function, targetTier, priority, true, bytecodeOffset)) {
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        CompileState& state = _jitStates[functionId].states[static_cast<size_t>(targetTier)];
+        if (state != CompileState::Compiling) {
+            state = CompileState::Queued;
+        }
+    }
+    
+    if (!_isCompilerRunning.load(std::memory_order_acquire)) {
+        processNextTask();
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// オンスタックリプレイスメント
+// ---------------------------------------------------------------------------
+
+void TieredJITManager::recordBackEdge(Function* function, uint32_t loopHeaderOffset) {
+    if (!function) {
+        return;
+    }
+    uint64_t functionId = function->getId();
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    _jitStates[functionId].entryBackedgeCount++;
+    _loopHeatMap[functionId][loopHeaderOffset]++;
+}
+
+bool TieredJITManager::isHotLoop(Function* function, uint32_t bytecodeOffset) const {
+    if (!function) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    auto it = _loopHeatMap.find(function->getId());
+    if (it == _loopHeatMap.end()) {
+        return false;
+    }
+    auto loop = it->second.find(bytecodeOffset);
+    return loop != it->second.end() && loop->second >= _config.osrEntryThreshold;
+}
+
+void* TieredJITManager::getOSREntryPoint(Function* function, uint32_t bytecodeOffset) {
+    if (!function) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    auto it = _jitStates.find(function->getId());
+    if (it == _jitStates.end()) {
+        return nullptr;
+    }
+    // 上位の階層のエントリを優先する
+    const OSRData* best = nullptr;
+    for (const OSRData& osr : it->second.osrEntries) {
+        if (osr.loopHeaderOffset == bytecodeOffset && (!best || osr.tier > best->tier)) {
+            best = &osr;
+        }
+    }
+    return best ? reinterpret_cast<void*>(best->osrEntryPoint) : nullptr;
+}
+
+bool TieredJITManager::enterOSR(Function* function, uint32_t bytecodeOffset, void* framePtr) {
+    OSRFrameState* frame = static_cast<OSRFrameState*>(framePtr);
+    if (!function || !frame) {
+        return false;
+    }
+    uint64_t functionId = function->getId();
+    
+    // このループのエントリを上位の階層から順に集める（スタブとレイアウトは共有で持つ）
+    struct Candidate {
+        OSREntryFunction entry;
+        std::shared_ptr<const OSREntryLayout> layout;
+        JITTier tier;
+    };
+    auto collect = [&](std::vector<Candidate>& candidates) {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        FunctionJITState& state = _jitStates[functionId];
+        for (const OSRData& osr : state.osrEntries) {
+            if (osr.loopHeaderOffset == bytecodeOffset) {
+                candidates.push_back({reinterpret_cast<OSREntryFunction>(osr.osrEntryPoint),
+                                      osr.layout, osr.tier});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate& a, const Candidate& b) { return a.tier > b.tier; });
+    };
+    
+    std::vector<Candidate> candidates;
+    collect(candidates);
+    if (candidates.empty()) {
+        // 最適化コードがあればそのループへ、なければベースラインのループへ入るコードを要求する。
+        // 要求は1ループにつき1回（失敗したループは要求を残したまま再要求しない）
+        JITTier targetTier;
+        {
+            std::lock_guard<std::mutex> lock(_jitMutex);
+            FunctionJITState& state = _jitStates[functionId];
+            if (state.osrRequests.count(bytecodeOffset)) {
+                return false;
+            }
+            targetTier = state.compiledCode[static_cast<size_t>(JITTier::Optimizing)]
+                ? JITTier::Optimizing : JITTier::Baseline;
+            OSRFrameState request = *frame;
+            request.result = 0;
+            state.osrRequests.emplace(bytecodeOffset, std::move(request));
+        }
+        if (!queueForOSRCompilation(function, bytecodeOffset, targetTier)) {
+            return false;
+        }
+        // コンパイルスレッドがなければその場でコンパイルされている
+        collect(candidates);
+    }
+    
+    std::vector<uint64_t> frameBuffer;
+    for (const Candidate& candidate : candidates) {
+        // 最適化コードの推測に合わない値があれば、下の階層のエントリを試す
+        if (OSRFrameTranslator::translate(*frame, *candidate.layout, frameBuffer) !=
+            OSRFrameTranslator::Result::Ok) {
+            std::lock_guard<std::mutex> lock(_jitMutex);
+            _stats.totalOSRRejections++;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_jitMutex);
+            _stats.totalOSREntries++;
+        }
+        // JITコードへ入るので、コードエイジングでは実行されたコードとして扱う
+        recordExecution(function);
+        // 打ち切りで抜けたOSRコードは例外にして、インタプリタのフレームを巻き戻す
+        frame->result = checkJITResult(candidate.entry(frameBuffer.data(), frame->context), _termination);
+        return true;
+    }
+    return false;
+}
+
+bool TieredJITManager::compileOSRFunction(Function* function, uint32_t bytecodeOffset, JITTier targetTier) {
+    JITCompiler* compiler = getCompilerForTier(targetTier);
+    if (!function || !compiler) {
+        return false;
+    }
+    uint64_t functionId = function->getId();
+    
+    OSRFrameState frame;
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        FunctionJITState& state = _jitStates[functionId];
+        auto it = state.osrRequests.find(bytecodeOffset);
+        if (it == state.osrRequests.end()) {
+            return false;
+        }
+        frame = it->second;
+    }
+    
+    void* loopHeader = nullptr;
+    auto layout = std::make_shared<OSREntryLayout>();
+    if (!compiler->compileOSREntry(function, frame, loopHeader, *layout)) {
+        return false;
+    }
+    if (!registerOSREntry(function, bytecodeOffset, targetTier, loopHeader, std::move(layout))) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    _jitStates[functionId].osrRequests.erase(bytecodeOffset);
+    return true;
+}
+
+bool TieredJITManager::registerOSREntry(Function* function, uint32_t offset, JITTier tier, void* loopHeader,
+                                        std::shared_ptr<const OSREntryLayout> layout) {
+    std::vector<uint8_t> stub;
+    if (!loopHeader || !layout || !emitOSREntryStub(*layout, loopHeader, stub)) {
+        return false;
+    }
+    
+    void* memory = _memoryManager.allocateExecutableMemory(stub.size());
+    if (!memory) {
+        return false;
+    }
+    std::memcpy(_memoryManager.getWritableAddress(memory), stub.data(), stub.size());
+    if (!_memoryManager.protectMemory(memory, stub.size(), MemoryProtection::ReadExecute)) {
+        _memoryManager.freeMemory(memory);
+        return false;
+    }
+    _memoryManager.flushInstructionCache(memory, stub.size());
+    
+    OSRData osr(offset, reinterpret_cast<uint64_t>(memory), loopHeader);
+    osr.tier = tier;
+    osr.layout = std::move(layout);
+    
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    std::vector<OSRData>& entries = _jitStates[function->getId()].osrEntries;
+    // 同じループ・同じ階層の古いエントリは置き換える（スタブは入口でしか実行されない）
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->loopHeaderOffset == offset && it->tier == tier) {
+            _memoryManager.freeMemory(reinterpret_cast<void*>(it->osrEntryPoint));
+            entries.erase(it);
+            break;
+        }
+    }
+    entries.push_back(std::move(osr));
+    return true;
+}
+
+JITCompiler* TieredJITManager::getCompilerForTier(JITTier tier) {
+    switch (tier) {
+        case JITTier::Baseline:
+            return _baselineJIT.get();
+        case JITTier::Optimizing:
+            return _optimizingJIT.get();
+        case JITTier::SuperTier:
+            return _superTierJIT.get();
+        case JITTier::MetaTracing:
+            return _metaTracingJIT.get();
+        default:
+            return nullptr;
+    }
+}
+
+void TieredJITManager::startCompilerThreads(uint32_t threadCount) {
+    if (_isCompilerRunning.exchange(true)) {
+        return;
+    }
+    
+    if (threadCount == 0) {
+        threadCount = std::min<uint32_t>(_config.maxCompileThreads,
+                                         std::max(1u, std::thread::hardware_concurrency() / 2));
+    }
+    
+    // スレッド開始前にキューの容量を設定から反映する
+    CompileQueue::Config queueConfig;
+    queueConfig.capacity = _config.maxCompileQueueSize;
+    _compileQueue.configure(queueConfig);
+    _compileQueue.reopen();
+    
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        _compilerThreads.emplace_back(&TieredJITManager::compilerThreadMain, this);
+    }
+}
+
+void TieredJITManager::stopCompilerThreads() {
+    if (!_isCompilerRunning.exchange(false)) {
+        return;
+    }
+    
+    _compileQueue.close();
+    for (std::thread& thread : _compilerThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    _compilerThreads.clear();
+}
+
+void TieredJITManager::compilerThreadMain() {
+    QueuedCompile task;
+    while (_compileQueue.waitPop(task)) {
+        executeCompileTask(task);
+    }
+}
+
+bool TieredJITManager::processNextTask() {
+    QueuedCompile task;
+    if (!_compileQueue.tryPop(task)) {
+        return false;
+    }
+    executeCompileTask(task);
+    return true;
+}
+
+void TieredJITManager::executeCompileTask(const QueuedCompile& task) {
+    size_t tierIndex = static_cast<size_t>(task.targetTier);
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        _jitStates[task.functionId].states[tierIndex] = CompileState::Compiling;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    bool success = task.isOSR
+        ? compileOSRFunction(task.function, task.osrOffset, task.targetTier)
+        : compileFunction(task.function, task.targetTier);
+    uint64_t elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    // コンパイル中に脱最適化・無効化された場合は生成したコードを捨てる
+    if (!_compileQueue.complete(task)) {
+        if (success) {
+            invalidateCode(task.function, task.targetTier);
+        }
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        _jitStates[task.functionId].states[tierIndex] = CompileState::Invalidated;
+        return;
+    }
+    
+    uint64_t codeSize = 0;
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        FunctionJITState& state = _jitStates[task.functionId];
+        state.states[tierIndex] = success ? CompileState::Completed : CompileState::Failed;
+        state.compilationTime[tierIndex] = elapsedNs;
+        codeSize = state.codeSize[tierIndex];
+        
+        _stats.totalCompilations++;
+        if (task.isOSR) {
+            _stats.totalOSRCompilations++;
+        }
+        _stats.totalCompilationTimeNs += elapsedNs;
+    }
+    
+    trackCompilationPerformance(task.functionId, task.targetTier, elapsedNs, codeSize, success);
+}
+
+bool TieredJITManager::deoptimizeFunction(Function* function) {
+    if (!function) {
+        return false;
+    }
+    uint64_t functionId = function->getId();
+    
+    // 最適化階層の要求は取り消し、ベースラインの要求は残す
+    _compileQueue.cancel(functionId, JITTier::Optimizing);
+    
+    prepareForDeoptimization(function);
+    
+    std::vector<JITTier> compiledTiers;
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        auto it = _jitStates.find(functionId);
+        if (it == _jitStates.end()) {
+            return false;
+        }
+        FunctionJITState& state = it->second;
+        state.pendingDeoptimization.store(true, std::memory_order_release);
+        for (size_t tier = static_cast<size_t>(JITTier::Optimizing); tier < 5; ++tier) {
+            if (state.states[tier] == CompileState::Completed) {
+                compiledTiers.push_back(static_cast<JITTier>(tier));
+            } else if (state.states[tier] == CompileState::Queued) {
+                state.states[tier] = CompileState::None;
+            }
+        }
+        _stats.totalDeoptimizations++;
+    }
+    
+    for (JITTier tier : compiledTiers) {
+        invalidateCode(function, tier);
+    }
+    
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    _jitStates[functionId].pendingDeoptimization.store(false, std::memory_order_release);
+    return true;
+}
+
+void TieredJITManager::recordDeoptimization(const DeoptimizationInfo& info, DeoptimizationReason reason) {
+    uint64_t functionId = info.functionId;
+    
+    // 位置ごとに記録し、外れ続けた投機を禁止する
+    bool blacklisted = false;
+    if (_profiler) {
+        blacklisted = _profiler->RecordDeoptimization(functionId, info.siteFunctionId, info.siteBytecodeOffset,
+                                                      info.speculation, DeoptimizationReasonToString(reason),
+                                                      _config.speculationBlacklistThreshold);
+    }
+    if (blacklisted) {
+        SpeculationBlacklist blacklist = _profiler->GetSpeculationBlacklist(info.siteFunctionId);
+        for (JITCompiler* compiler : {_optimizingJIT.get(), _superTierJIT.get()}) {
+            if (compiler) {
+                compiler->setSpeculationBlacklist(info.siteFunctionId, blacklist);
+            }
+        }
+        SpeculationBlacklistListener listener;
+        {
+            std::lock_guard<std::mutex> lock(_jitMutex);
+            listener = _blacklistListener;
+        }
+        if (listener) {
+            listener(info.siteFunctionId, blacklist);
+        }
+    }
+    
+    bool discard = blacklisted;
+    {
+        std::lock_guard<std::mutex> lock(_jitMutex);
+        FunctionJITState& state = _jitStates[functionId];
+        
+        auto now = std::chrono::steady_clock::now();
+        if (state.recentDeopts == 0 ||
+            now - state.deoptWindowStart > std::chrono::milliseconds(_config.deoptLoopWindowMs)) {
+            state.deoptWindowStart = now;
+            state.recentDeopts = 0;
+        }
+        state.recentDeopts++;
+        _stats.totalDeoptimizations++;
+        if (blacklisted) {
+            _stats.totalBlacklistedSpeculations++;
+        }
+        
+        // 投機を禁止しても止まらない（遅延脱最適化や禁止できない失敗が続く）ならあきらめる
+        if (!state.optimizationDisabled && state.recentDeopts > _config.maxDeoptsPerWindow) {
+            state.optimizationDisabled = true;
+            _stats.totalDeoptLoops++;
+            discard = true;
+        }
+        
+        // 外れた前提のコードを捨てる。実行中のフレームは Deoptimizer が脱最適化する
+        if (discard) {
+            for (size_t tier = static_cast<size_t>(JITTier::Optimizing); tier < 5; ++tier) {
+                if (state.codeEntries[tier]) {
+                    releaseCode(state, tier);
+                    state.states[tier] = CompileState::Invalidated;
+                } else if (state.states[tier] == CompileState::Queued) {
+                    state.states[tier] = CompileState::None;
+                }
+            }
+        }
+    }
+    
+    if (discard) {
+        _compileQueue.cancel(functionId, JITTier::Optimizing);
+    }
+}
+
+void TieredJITManager::setSpeculationBlacklistListener(SpeculationBlacklistListener listener) {
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    _blacklistListener = std::move(listener);
+}
+
+void TieredJITManager::setTerminationState(const TerminationState* state) {
+    _termination = state;
+}
+
+bool TieredJITManager::isOptimizationDisabled(Function* function) const {
+    if (!function) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    auto it = _jitStates.find(function->getId());
+    return it != _jitStates.end() && it->second.optimizationDisabled;
+}
+
+CompileQueue::LatencyHistogram TieredJITManager::getCompileQueueLatency() const {
+    return _compileQueue.latencyHistogram();
+}
+
+CompileQueue::Stats TieredJITManager::getCompileQueueStats() const {
+    return _compileQueue.getStats();
+}
+
+// ---------------------------------------------------------------------------
+// コード領域とエイジング
+// ---------------------------------------------------------------------------
+
+CodeEntry* TieredJITManager::installCode(uint64_t functionId, JITTier tier, const void* code,
+                                         size_t size, uint32_t entryOffset,
+                                         std::shared_ptr<const FrameStateTable> frameStates) {
+    if (!code || size == 0 || tier == JITTier::Interpreter) {
+        return nullptr;
+    }
+    
+    void* memory = _memoryManager.allocateExecutableMemory(size);
+    if (!memory) {
+        return nullptr;
+    }
+    // 二重マッピングの領域では書き込み用の別名へ書く（それ以外は memory そのもの）
+    std::memcpy(_memoryManager.getWritableAddress(memory), code, size);
+    if (!_memoryManager.protectMemory(memory, size, MemoryProtection::ReadExecute)) {
+        _memoryManager.freeMemory(memory);
+        return nullptr;
+    }
+    _memoryManager.flushInstructionCache(memory, size);
+    
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    if (!_codeCache) {
+        _codeCache = std::make_unique<CodeCache>(_context);
+    }
+    CodeEntry* entry = _codeCache->addCode(memory, size, functionId);
+    if (!entry) {
+        _memoryManager.freeMemory(memory);
+        return nullptr;
+    }
+    entry->setEntryOffset(entryOffset);
+    if (tier >= JITTier::Optimizing) {
+        entry->setFlag(CodeFlags::WasOptimized);
+    }
+    if (_memoryManager.isLargePageBacked(memory)) {
+        entry->setFlag(CodeFlags::UsesLargePages);
+    }
+    entry->resetAge();
+    
+    size_t tierIndex = static_cast<size_t>(tier);
+    FunctionJITState& state = _jitStates[functionId];
+    if (state.codeEntries[tierIndex]) {
+        releaseCode(state, tierIndex);
+    }
+    state.codeEntries[tierIndex] = entry;
+    state.compiledCode[tierIndex] = entry->getEntryPoint();
+    state.codeSize[tierIndex] = size;
+    if (frameStates && tier >= JITTier::Optimizing) {
+        Deoptimizer::Instance().RegisterCode(memory, size, std::move(frameStates), functionId);
+    }
+    
+    _codeBytes += size;
+    if (_codeBytes > _config.codeCacheMaxSize) {
+        _codeAgingRequested.store(true, std::memory_order_release);
+    }
+    return entry;
+}
+
+void TieredJITManager::releaseCode(FunctionJITState& state, size_t tierIndex) {
+    CodeEntry* entry = state.codeEntries[tierIndex];
+    if (!entry) {
+        return;
+    }
+    void* code = entry->getCode();
+    size_t size = entry->getSize();
+    
+    // 外したコードのループヘッダへ飛ぶOSRエントリも消す
+    uintptr_t begin = reinterpret_cast<uintptr_t>(code);
+    state.osrEntries.erase(
+        std::remove_if(state.osrEntries.begin(), state.osrEntries.end(),
+                       [&](const OSRData& osr) {
+                           uintptr_t loopHeader = reinterpret_cast<uintptr_t>(osr.osrData);
+                           if (loopHeader < begin || loopHeader >= begin + size) {
+                               return false;
+                           }
+                           _memoryManager.freeMemory(reinterpret_cast<void*>(osr.osrEntryPoint));
+                           return true;
+                       }),
+        state.osrEntries.end());
+    
+    // 最適化コードへまだ戻ってくるフレームは、解放する前に戻り先を脱最適化へ向ける
+    if (tierIndex >= static_cast<size_t>(JITTier::Optimizing)) {
+        Deoptimizer::Instance().InvalidateCode(code);
+    }
+    
+    _codeCache->removeEntry(entry->getId());
+    _memoryManager.freeMemory(code);
+    
+    state.codeEntries[tierIndex] = nullptr;
+    state.compiledCode[tierIndex] = nullptr;
+    state.codeSize[tierIndex] = 0;
+    state.states[tierIndex] = CompileState::None;
+    _codeBytes -= size;
+    _codeAgingStats.bytesReleased += size;
+}
+
+bool TieredJITManager::invalidateCode(Function* function, JITTier tier) {
+    if (!function || tier == JITTier::Interpreter) {
+        return false;
+    }
+    size_t tierIndex = static_cast<size_t>(tier);
+    
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    auto it = _jitStates.find(function->getId());
+    if (it == _jitStates.end() || !it->second.codeEntries[tierIndex]) {
+        return false;
+    }
+    releaseCode(it->second, tierIndex);
+    it->second.states[tierIndex] = CompileState::Invalidated;
+    return true;
+}
+
+void TieredJITManager::recordExecution(Function* function) {
+    if (!function) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    FunctionJITState& state = _jitStates[function->getId()];
+    state.executeCount++;
+    _stats.totalExecutions++;
+    
+    // 実行されるのは最上位階層のコードなので、そのエントリの実行回数を進める
+    for (size_t tier = 5; tier-- > static_cast<size_t>(JITTier::Baseline);) {
+        if (CodeEntry* entry = state.codeEntries[tier]) {
+            entry->recordExecution(0, 0);
+            break;
+        }
+    }
+}
+
+size_t TieredJITManager::ageCompiledCode() {
+    constexpr size_t kBaseline = static_cast<size_t>(JITTier::Baseline);
+    constexpr size_t kOptimizing = static_cast<size_t>(JITTier::Optimizing);
+    
+    struct Candidate {
+        uint64_t functionId;
+        size_t tierIndex;
+        uint32_t age;
+        uint64_t executions;
+    };
+    
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    _codeAgingRequested.store(false, std::memory_order_release);
+    _codeAgingStats.sweeps++;
+    uint64_t releasedBefore = _codeAgingStats.bytesReleased;
+    
+    std::vector<Candidate> candidates;
+    for (auto& [functionId, state] : _jitStates) {
+        if (state.pendingDeoptimization.load(std::memory_order_acquire)) {
+            continue;
+        }
+        
+        // 年齢を進めるのは最上位階層のコードだけ。下の階層は上の階層が外れたときの
+        // 戻り先なので、上の階層が使われている間は若いままにしておく
+        bool topTierSeen = false;
+        for (size_t tier = 5; tier-- > kBaseline;) {
+            CodeEntry* entry = state.codeEntries[tier];
+            if (!entry) {
+                continue;
+            }
+            if (topTierSeen) {
+                entry->resetAge();
+                continue;
+            }
+            if (entry->hasFlag(CodeFlags::IsPinned)) {
+                topTierSeen = true;
+                continue;
+            }
+            
+            uint32_t age = entry->advanceAge();
+            if (tier >= kOptimizing && age >= _config.optimizedCodeMaxAge) {
+                releaseCode(state, tier);
+                _codeAgingStats.demotedToBaseline++;
+                continue;  // 次の階層（ベースライン）が最上位になる
+            }
+            if (tier == kBaseline && age >= _config.baselineCodeMaxAge) {
+                releaseCode(state, tier);
+                _codeAgingStats.discardedToBytecode++;
+                break;
+            }
+            candidates.push_back({functionId, tier, age, entry->getExecutionStats().executionCount});
+            topTierSeen = true;
+        }
+    }
+    
+    // 予算を超えていれば、最適化コードから先に、古い順・実行回数の少ない順に外す
+    if (_codeBytes > _config.codeCacheMaxSize) {
+        size_t target = static_cast<size_t>(_config.codeCacheMaxSize * _config.codeCacheLowWatermark);
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            bool aOptimized = a.tierIndex >= kOptimizing;
+            bool bOptimized = b.tierIndex >= kOptimizing;
+            if (aOptimized != bOptimized) {
+                return aOptimized;
+            }
+            if (a.age != b.age) {
+                return a.age > b.age;
+            }
+            return a.executions < b.executions;
+        });
+        for (const Candidate& candidate : candidates) {
+            if (_codeBytes <= target) {
+                break;
+            }
+            FunctionJITState& state = _jitStates[candidate.functionId];
+            releaseCode(state, candidate.tierIndex);
+            if (candidate.tierIndex >= kOptimizing) {
+                _codeAgingStats.demotedToBaseline++;
+            } else {
+                _codeAgingStats.discardedToBytecode++;
+            }
+            _codeAgingStats.budgetEvictions++;
+        }
+    }
+    
+    return static_cast<size_t>(_codeAgingStats.bytesReleased - releasedBefore);
+}
+
+size_t TieredJITManager::getCodeMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    return _codeBytes;
+}
+
+TieredJITManager::CodeAgingStats TieredJITManager::getCodeAgingStats() const {
+    std::lock_guard<std::mutex> lock(_jitMutex);
+    return _codeAgingStats;
+}
+
+} // namespace aerojs::core
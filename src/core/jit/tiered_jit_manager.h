@@ -17,13 +17,16 @@
 #include <future>
 #include <atomic>
 #include <chrono>
-#include <queue>
 #include <thread>
-#include <condition_variable>
 
+#include "compile_queue.h"
 #include "jit_compiler.h"
+#include "memory_manager.h"
+#include "deoptimizer/deoptimizer.h"
+#include "osr/osr_entry.h"
 #include "baseline/baseline_jit.h"
 #include "profiler/jit_profiler.h"
+#include "../vm/exception/termination.h"
 
 namespace aerojs::core {
 
@@ -32,6 +35,7 @@ class Context;
 class Function;
 class BytecodeCompiler;
 class CodeCache;
+class CodeEntry;
 class TraceRecorder;
 
 /**
@@ -59,47 +63,21 @@ enum class CompileState : uint8_t {
 
 /**
  * @brief オンスタックリプレイスメント (OSR) 状態
+ *
+ * osrEntryPoint はフレームを組み立てるスタブ（OSREntryFunction）、osrData はスタブの
+ * 飛び先である階層のコード内のループヘッダ。スタブは階層のコードを外すときに一緒に解放する。
  */
 struct OSRData {
     uint32_t loopHeaderOffset;  // ループヘッダオフセット
     uint64_t osrEntryPoint;     // OSRエントリポイント
     void* osrData;              // OSR固有データ
+    JITTier tier;               // ループヘッダのある階層
+    std::shared_ptr<const OSREntryLayout> layout;  // ループヘッダでのフレーム配置
     
-    OSRData() : loopHeaderOffset(0), osrEntryPoint(0), osrData(nullptr) {}
+    OSRData() : loopHeaderOffset(0), osrEntryPoint(0), osrData(nullptr), tier(JITTier::Interpreter) {}
     
     OSRData(uint32_t offset, uint64_t entry, void* data)
-        : loopHeaderOffset(offset), osrEntryPoint(entry), osrData(data) {}
-};
-
-/**
- * @brief コンパイル対象関数の情報
- */
-struct CompileTask {
-    uint64_t functionId;        // 関数ID
-    JITTier targetTier;         // 対象JIT階層
-    uint32_t priority;          // 優先度
-    bool isOSR;                 // OSRコンパイルか
-    uint32_t osrOffset;         // OSRの場合のバイトコードオフセット
-    std::chrono::steady_clock::time_point enqueueTime;  // キュー投入時刻
-    
-    CompileTask() : functionId(0), targetTier(JITTier::Baseline), 
-                    priority(0), isOSR(false), osrOffset(0) {}
-                    
-    CompileTask(uint64_t id, JITTier tier, uint32_t prio = 0)
-        : functionId(id), targetTier(tier), priority(0), isOSR(false), osrOffset(0) {
-        enqueueTime = std::chrono::steady_clock::now();
-    }
-    
-    CompileTask(uint64_t id, JITTier tier, uint32_t prio, uint32_t osr_offset)
-        : functionId(id), targetTier(tier), priority(prio), isOSR(true), osrOffset(osr_offset) {
-        enqueueTime = std::chrono::steady_clock::now();
-    }
-    
-    // 優先度比較演算子
-    bool operator<(const CompileTask& other) const {
-        // 高優先度が先に処理される
-        return priority < other.priority;
-    }
+        : loopHeaderOffset(offset), osrEntryPoint(entry), osrData(data), tier(JITTier::Interpreter) {}
 };
 
 /**
@@ -108,6 +86,7 @@ struct CompileTask {
 struct FunctionJITState {
     CompileState states[5];      // 各JIT階層の状態 (階層数に対応)
     void* compiledCode[5];       // 各JIT階層のコンパイル済みコード
+    CodeEntry* codeEntries[5];   // 各JIT階層のコードエントリ（エイジングと解放に使う）
     uint64_t compilationTime[5]; // 各JIT階層のコンパイル時間 (ナノ秒)
     uint64_t codeSize[5];        // 各JIT階層のコードサイズ
     int32_t executeCount;        // 実行回数
@@ -115,15 +94,21 @@ struct FunctionJITState {
     int32_t tierUpCounter;       // 階層昇格カウンタ
     bool hasInlinedCalls;        // インライン展開された呼び出しがあるか
     std::vector<OSRData> osrEntries;  // OSRエントリポイント
+    std::unordered_map<uint32_t, OSRFrameState> osrRequests;  // コンパイル待ちのOSR（要求したフレーム）
     std::vector<uint64_t> inlinedFunctions;  // インライン展開された関数のID
     std::atomic<bool> pendingDeoptimization;  // 最適化解除待ちフラグ
+    uint32_t recentDeopts;       // deoptWindowStart からの脱最適化回数
+    std::chrono::steady_clock::time_point deoptWindowStart;
+    bool optimizationDisabled;   // 脱最適化を繰り返したので最適化階層へ上げない
     
     FunctionJITState() : executeCount(0), entryBackedgeCount(0), 
                          tierUpCounter(0), hasInlinedCalls(false),
-                         pendingDeoptimization(false) {
+                         pendingDeoptimization(false), recentDeopts(0),
+                         optimizationDisabled(false) {
         for (int i = 0; i < 5; i++) {
             states[i] = CompileState::None;
             compiledCode[i] = nullptr;
+            codeEntries[i] = nullptr;
             compilationTime[i] = 0;
             codeSize[i] = 0;
         }
@@ -149,6 +134,11 @@ public:
     void* getCodeForFunction(Function* function);
     
     // OSR実行
+    //
+    // インタプリタはループのバックエッジが osrThreshold 回に達するたびに、生きている状態を
+    // OSRFrameState に写して enterOSR を呼ぶ（framePtr は OSRFrameState*）。エントリがなければ
+    // そのフレームの形でOSRコンパイルを要求して false を返し、インタプリタは実行を続ける。
+    // エントリがあればフレームを変換してOSRコードへ入り、完了値を state->result に入れて true を返す。
     void* getOSREntryPoint(Function* function, uint32_t bytecodeOffset);
     bool enterOSR(Function* function, uint32_t bytecodeOffset, void* framePtr);
     
@@ -168,6 +158,24 @@ public:
     bool deoptimizeFunction(Function* function);
     bool invalidateCode(Function* function, JITTier tier);
     
+    // 最適化コードで起きた脱最適化を記録する（Deoptimizer のコールバックから呼ぶ）
+    //
+    // 外れた投機をその位置ごとにプロファイラへ記録し、同じ位置で同じ投機が
+    // speculationBlacklistThreshold 回外れたら、その位置の投機を禁止して最適化コンパイラへ伝え、
+    // 最適化コードを捨てる（次の昇格では禁止した投機を使わずにコンパイルし直す）。
+    // deoptLoopWindowMs の間に maxDeoptsPerWindow 回を超えて脱最適化した関数は
+    // 脱最適化ループとみなし、以後は最適化階層へ上げない。
+    void recordDeoptimization(const DeoptimizationInfo& info, DeoptimizationReason reason);
+    bool isOptimizationDisabled(Function* function) const;
+    
+    // 投機を禁止したときの通知先（JITCompiler でない最適化コンパイラ、OptimizingJIT など）
+    // 引数は禁止した位置の関数IDと、その関数の禁止リスト全体。
+    using SpeculationBlacklistListener = std::function<void(uint64_t functionId, const SpeculationBlacklist& blacklist)>;
+    void setSpeculationBlacklistListener(SpeculationBlacklistListener listener);
+    
+    // 実行打ち切り。OSRコードが打ち切りで抜けたら enterOSR は ExecutionTerminated を投げる
+    void setTerminationState(const TerminationState* state);
+    
     // コンパイルキュー制御
     bool queueForCompilation(Function* function, JITTier targetTier, 
                             uint32_t priority = 0);
@@ -178,6 +186,33 @@ public:
     void startCompilerThreads(uint32_t threadCount = 0);
     void stopCompilerThreads();
     
+    // コンパイルキューの待ち時間と統計
+    CompileQueue::LatencyHistogram getCompileQueueLatency() const;
+    CompileQueue::Stats getCompileQueueStats() const;
+    
+    // コードエイジング
+    //
+    // 掃引のたびに各関数の最上位階層のコードの年齢を進める（前回の掃引から実行されていれば0）。
+    // optimizedCodeMaxAge に達した最適化コードは外してベースラインへ戻し、
+    // baselineCodeMaxAge に達したベースラインコードは捨ててバイトコード実行へ戻す。
+    // それでもコード量が codeCacheMaxSize を超えていれば、最適化コード → ベースラインコードの順に、
+    // 古い順・実行回数の少ない順で codeCacheLowWatermark まで外す。
+    // 解放した実行可能メモリは MemoryManager へ返す。
+    //
+    // コードを解放するため、JITフレームがスタックにない安全点（GCの後など）で呼ぶ。
+    struct CodeAgingStats {
+        uint64_t sweeps = 0;
+        uint64_t demotedToBaseline = 0;    // 外した最適化コード
+        uint64_t discardedToBytecode = 0;  // 捨てたベースラインコード
+        uint64_t budgetEvictions = 0;      // 上のうち予算超過で外したもの
+        uint64_t bytesReleased = 0;
+    };
+    
+    size_t ageCompiledCode();
+    bool needsCodeAging() const { return _codeAgingRequested.load(std::memory_order_acquire); }
+    size_t getCodeMemoryUsage() const;
+    CodeAgingStats getCodeAgingStats() const;
+    
     // インライン展開制御
     bool canInlineFunction(Function* caller, Function* callee) const;
     void markFunctionInlined(Function* caller, Function* callee);
@@ -209,6 +244,14 @@ public:
         
         // キャッシュ設定
         size_t codeCacheMaxSize;           // コードキャッシュ最大サイズ
+        double codeCacheLowWatermark;      // 予算超過時にこの割合まで減らす
+        uint32_t optimizedCodeMaxAge;      // 最適化コードをベースラインへ戻す年齢（掃引回数）
+        uint32_t baselineCodeMaxAge;       // ベースラインコードを捨てる年齢（掃引回数）
+        
+        // 脱最適化
+        uint32_t speculationBlacklistThreshold; // 同じ位置の投機を禁止するまでの失敗回数
+        uint32_t maxDeoptsPerWindow;       // これを超えて脱最適化したら最適化をやめる
+        uint32_t deoptLoopWindowMs;        // 脱最適化の回数を数える期間(ミリ秒)
         
         TieredJITConfig()
             : baselineTierUpThreshold(100),
@@ -224,7 +267,13 @@ public:
               enableDynamicThresholds(true),
               enableSpeculativeCompilation(true),
               enableHeuristicInlining(true),
-              codeCacheMaxSize(64 * 1024 * 1024) {}
+              codeCacheMaxSize(64 * 1024 * 1024),
+              codeCacheLowWatermark(0.75),
+              optimizedCodeMaxAge(4),
+              baselineCodeMaxAge(16),
+              speculationBlacklistThreshold(1),
+              maxDeoptsPerWindow(5),
+              deoptLoopWindowMs(10000) {}
     };
     
     void setConfig(const TieredJITConfig& config);
@@ -243,6 +292,12 @@ private:
     // プロファイラ
     std::unique_ptr<JITProfiler> _profiler;
     
+    // 投機を禁止したときの通知先（_jitMutex で保護）
+    SpeculationBlacklistListener _blacklistListener;
+    
+    // エンジンの打ち切り状態（設定しなければ打ち切りの戻り値を確認しない）
+    const TerminationState* _termination = nullptr;
+    
     // バイトコードコンパイラ
     std::unique_ptr<BytecodeCompiler> _bytecodeCompiler;
     
@@ -252,13 +307,18 @@ private:
     // 関数ごとのJIT状態
     std::unordered_map<uint64_t, FunctionJITState> _jitStates;
     
-    // コンパイルキュー
-    std::priority_queue<CompileTask> _compileQueue;
+    // コンパイルキュー（階層別レーン、同一関数の要求はまとめる）
+    CompileQueue _compileQueue;
+    
+    // 生成コードの置き場所（実行可能メモリの確保元とコードエントリ）
+    MemoryManager _memoryManager;
+    std::unique_ptr<CodeCache> _codeCache;
+    size_t _codeBytes = 0;
+    std::atomic<bool> _codeAgingRequested{false};
+    CodeAgingStats _codeAgingStats;
     
     // 同期オブジェクト
     mutable std::mutex _jitMutex;
-    std::mutex _queueMutex;
-    std::condition_variable _queueCondition;
     
     // コンパイルスレッド
     std::vector<std::thread> _compilerThreads;
@@ -271,13 +331,19 @@ private:
     struct Stats {
         uint64_t totalCompilations;
         uint64_t totalOSRCompilations;
+        uint64_t totalOSREntries;
+        uint64_t totalOSRRejections;    // フレームが配置に合わずインタプリタに留まった
         uint64_t totalCompilationTimeNs;
         uint64_t totalExecutions;
         uint64_t totalDeoptimizations;
+        uint64_t totalBlacklistedSpeculations;  // 禁止した（位置, 投機）の組
+        uint64_t totalDeoptLoops;               // 脱最適化ループで最適化をやめた関数
         
         Stats() : totalCompilations(0), totalOSRCompilations(0),
+                  totalOSREntries(0), totalOSRRejections(0),
                   totalCompilationTimeNs(0), totalExecutions(0),
-                  totalDeoptimizations(0) {}
+                  totalDeoptimizations(0), totalBlacklistedSpeculations(0),
+                  totalDeoptLoops(0) {}
     };
     
     Stats _stats;
@@ -299,9 +365,18 @@ private:
     // スレッド管理
     void compilerThreadMain();
     bool processNextTask();
+    void executeCompileTask(const QueuedCompile& task);
     
     // 内部実装
     bool compileFunction(Function* function, JITTier targetTier);
+    
+    // 生成したコードを実行可能メモリへ複写して関数の階層に登録する
+    // （最適化コードはフレーム状態を Deoptimizer に登録する）
+    CodeEntry* installCode(uint64_t functionId, JITTier tier, const void* code,
+                           size_t size, uint32_t entryOffset = 0,
+                           std::shared_ptr<const FrameStateTable> frameStates = nullptr);
+    // 階層のコードを外して実行可能メモリを返す（_jitMutex を保持して呼ぶ）
+    void releaseCode(FunctionJITState& state, size_t tierIndex);
     bool compileOSRFunction(Function* function, uint32_t bytecodeOffset, JITTier targetTier);
     
     // 階層選択ロジック
@@ -324,7 +399,9 @@ private:
     void analyzePerfData();
     
     // OSRサポート
-    void registerOSREntry(Function* function, uint32_t offset, uint64_t entryPoint, void* data);
+    // スタブを実行可能メモリへ置いて登録する（_jitMutex を保持せずに呼ぶ）
+    bool registerOSREntry(Function* function, uint32_t offset, JITTier tier, void* loopHeader,
+                          std::shared_ptr<const OSREntryLayout> layout);
     
     // 対応するJITコンパイラを取得
     JITCompiler* getCompilerForTier(JITTier tier);
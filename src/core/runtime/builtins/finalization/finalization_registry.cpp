@@ -14,8 +14,8 @@
 #include "../../object.h"
 #include "../../value.h"
 #include "../function/function.h"
+#include "../promise/promise.h"
 #include "../../../utils/memory/gc/garbage_collector.h"
-#include "../../../utils/memory/smart_ptr/handle_manager.h"
 
 namespace aero {
 
@@ -27,14 +27,22 @@ FinalizationRegistryObject::FinalizationRegistryObject(Value cleanupCallback, Gl
     : Object(globalObj->finalizationRegistryPrototype()),
       m_cleanupCallback(cleanupCallback),
       m_globalObject(globalObj),
+      m_destroying(false),
       m_isCleanupInProgress(false) {
-  // cleanupCallbackの検証はコンストラクタ関数で行われるため、
-  // ここでは特に何もしない
+  // cleanupCallbackの検証はコンストラクタ関数で行われる
 }
 
 FinalizationRegistryObject::~FinalizationRegistryObject() {
-  // WeakHandleはGCによって自動的に管理されるため、
-  // 明示的なクリーンアップは不要
+  // 通知の登録はレジストリのロックを外してから解除する（通知は制御ブロックのロックの中でレジストリをロックする）
+  std::unordered_map<const aerojs::utils::RefCounted*, ObservedTarget> observed;
+  {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_destroying = true;
+    observed.swap(m_observedTargets);
+  }
+  for (const auto& target : observed) {
+    target.second.target.control()->removeObserver(this);
+  }
 }
 
 // オブジェクトを登録する
@@ -50,25 +58,32 @@ bool FinalizationRegistryObject::register_(Value target, Value heldValue, Value
     return false;
   }
 
+  Object* obj = target.asObject();
+
+  // ターゲットの破棄で通知を受ける（レジストリのロックの外で登録する）
+  aerojs::utils::WeakRefPtr<Object> weakTarget(obj);
+  weakTarget.control()->addObserver(this);
+
   // エントリの追加はロックが必要
   std::unique_lock<std::shared_mutex> lock(m_mutex);
 
-  // ObjectからWeakHandleを取得
-  Object* obj = target.asObject();
-  
-  // HandleManagerからWeakHandleを取得
-  HandleManager* handleManager = HandleManager::getInstance();
+  // 登録と破棄が競合して古い制御ブロックが残っていれば、同じアドレスの新しいターゲットで置き換える
+  ObservedTarget& observed = m_observedTargets[obj];
+  if (observed.target.expired()) {
+    observed.target = weakTarget;
+  }
   
-  // 新しいエントリを作成
+  // 新しいエントリを作成（ターゲットの破棄でクリアされる弱参照）
   RegistryEntry entry;
-  entry.target = handleManager->createWeakHandle(obj);
+  entry.target = std::move(weakTarget);
+  entry.key = obj;
   entry.heldValue = heldValue;
   entry.unregisterToken = unregisterToken;
-  entry.isTargetAlive.store(true, std::memory_order_release);
   
-  // エントリをリストに追加
+  // エントリをリストに追加し、ターゲットの索引に位置を記録
   size_t index = m_entries.size();
   m_entries.push_back(std::move(entry));
+  observed.entries.push_back(index);
   
   // unregisterTokenが指定されている場合、マップに追加
   if (!unregisterToken.isUndefined()) {
@@ -88,7 +103,7 @@ bool FinalizationRegistryObject::unregister(Value unregisterToken) {
   // 読み取り用ロックでトークンの存在確認
   {
     std::shared_lock<std::shared_mutex> readLock(m_mutex);
-    if (m_tokenMap.find(unregisterToken) == m_tokenMap.end()) {
+    if (m_tokenMap.find(unregisterToken) == m_tokenMap.end() && m_pendingCleanup.empty()) {
       return false;
     }
   }
@@ -96,10 +111,18 @@ bool FinalizationRegistryObject::unregister(Value unregisterToken) {
   // 書き込み用ロックで実際の削除を行う
   std::unique_lock<std::shared_mutex> writeLock(m_mutex);
   
+  // ターゲットが回収済みでクリーンアップ待ちのエントリも登録解除の対象
+  auto pendingEnd = std::remove_if(m_pendingCleanup.begin(), m_pendingCleanup.end(),
+                                   [&unregisterToken](const PendingCleanup& pending) {
+                                     return pending.unregisterToken == unregisterToken;
+                                   });
+  bool removedPending = pendingEnd != m_pendingCleanup.end();
+  m_pendingCleanup.erase(pendingEnd, m_pendingCleanup.end());
+  
   // トークンがマップに存在するか再確認（ロック解除中に変更された可能性があるため）
   auto it = m_tokenMap.find(unregisterToken);
   if (it == m_tokenMap.end()) {
-    return false;
+    return removedPending;
   }
   
   // エントリのインデックスを取得
@@ -108,7 +131,7 @@ bool FinalizationRegistryObject::unregister(Value unregisterToken) {
   // インデックスが範囲外の場合はエラー
   if (index >= m_entries.size()) {
     m_tokenMap.erase(it);
-    return false;
+    return removedPending;
   }
   
   // エントリを安全に削除
@@ -119,122 +142,141 @@ bool FinalizationRegistryObject::unregister(Value unregisterToken) {
 
 // エントリを安全に削除
 void FinalizationRegistryObject::safeRemoveEntry(size_t index) {
+  // 削除対象のエントリのトークンをマップから削除（移動で上書きされる前に行う）
+  const Value& token = m_entries[index].unregisterToken;
+  if (!token.isUndefined()) {
+    m_tokenMap.erase(token);
+  }
+  reindexEntry(m_entries[index].key, index, kNoEntry);
+  
   // 最後のエントリを現在位置に移動して、末尾を削除（効率的な削除方法）
-  if (index < m_entries.size() - 1) {
+  size_t last = m_entries.size() - 1;
+  if (index < last) {
     m_entries[index] = std::move(m_entries.back());
     
-    // トークンマップを更新
+    // トークンマップとターゲットの索引を更新
     const Value& movedToken = m_entries[index].unregisterToken;
     if (!movedToken.isUndefined()) {
       m_tokenMap[movedToken] = index;
     }
-  }
-  
-  // 削除対象のエントリのトークンをマップから削除
-  const Value& token = m_entries[index].unregisterToken;
-  if (!token.isUndefined()) {
-    m_tokenMap.erase(token);
+    reindexEntry(m_entries[index].key, last, index);
   }
   
   // ベクターから最後の要素を削除
   m_entries.pop_back();
 }
 
-// クリーンアップキューにエントリを追加
-void FinalizationRegistryObject::addToCleanupQueue(size_t index) {
-  if (index < m_entries.size()) {
-    m_cleanupQueue.push(index);
+// ターゲットごとの索引でエントリの位置を付け替える（m_mutexを保持して呼ぶ）
+void FinalizationRegistryObject::reindexEntry(const aerojs::utils::RefCounted* key, size_t from, size_t to) {
+  auto it = m_observedTargets.find(key);
+  if (it == m_observedTargets.end()) {
+    return;
+  }
+  std::vector<size_t>& entries = it->second.entries;
+  auto pos = std::find(entries.begin(), entries.end(), from);
+  if (pos == entries.end()) {
+    return;
+  }
+  if (to != kNoEntry) {
+    *pos = to;
+  } else {
+    *pos = entries.back();
+    entries.pop_back();
   }
 }
 
-// クリーンアップ処理を実行する
-void FinalizationRegistryObject::cleanupSome(Value callback) {
-  // 再入を防止（他のスレッドやJSコールバックからのクリーンアップ呼び出しを防ぐ）
-  bool expected = false;
-  if (!m_isCleanupInProgress.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
-    return;  // 既に処理中の場合は何もしない
-  }
-  
-  try {
-    // クリーンアップキューが空の場合は無効なエントリを確認
-    if (m_cleanupQueue.empty()) {
-      std::unique_lock<std::shared_mutex> lock(m_mutex);
-      
-      // 無効なエントリをチェックして、クリーンアップキューに追加
-      for (size_t i = 0; i < m_entries.size(); ++i) {
-        if (!m_entries[i].isTargetAlive.load(std::memory_order_acquire)) {
-          m_cleanupQueue.push(i);
-        }
-      }
-    }
-    
-    // クリーンアップキューが空の場合は終了
-    if (m_cleanupQueue.empty()) {
-      m_isCleanupInProgress.store(false, std::memory_order_release);
-      return;
+// 破棄の通知を受けたターゲットのエントリをクリーンアップ待ちの一覧へ移す（m_mutexを保持して呼ぶ）
+size_t FinalizationRegistryObject::collectDeadTargets() {
+  size_t collected = 0;
+  
+  std::vector<const aerojs::utils::RefCounted*> destroyed;
+  destroyed.swap(m_destroyedTargets);
+  for (const aerojs::utils::RefCounted* key : destroyed) {
+    auto it = m_observedTargets.find(key);
+    if (it == m_observedTargets.end()) {
+      continue;  // 同じアドレスの通知が重なり、処理済み
     }
     
-    // キューから最初のエントリを取得
-    size_t index;
-    {
-      std::shared_lock<std::shared_mutex> lock(m_mutex);
-      if (m_cleanupQueue.empty()) {
-        m_isCleanupInProgress.store(false, std::memory_order_release);
-        return;
-      }
-      
-      index = m_cleanupQueue.front();
-      m_cleanupQueue.pop();
-      
-      // インデックスが範囲外の場合は無視
-      if (index >= m_entries.size()) {
-        m_isCleanupInProgress.store(false, std::memory_order_release);
-        return;
-      }
-      
-      // エントリが既に復活している場合は無視
-      if (m_entries[index].isTargetAlive.load(std::memory_order_acquire)) {
-        m_isCleanupInProgress.store(false, std::memory_order_release);
-        return;
+    // 同じアドレスで登録し直した生存中のターゲットのエントリは残す。
+    // 取り除くと索引の末尾が現在位置に入るので、位置を進めずに調べ直す
+    std::vector<size_t>& entries = it->second.entries;
+    size_t i = 0;
+    while (i < entries.size()) {
+      RegistryEntry& entry = m_entries[entries[i]];
+      if (!entry.target.expired()) {
+        ++i;
+        continue;
       }
+      m_pendingCleanup.push_back({std::move(entry.heldValue), entry.unregisterToken});
+      safeRemoveEntry(entries[i]);
+      ++collected;
     }
     
-    // heldValueを取得
-    Value heldValue;
-    {
-      std::shared_lock<std::shared_mutex> lock(m_mutex);
-      if (index < m_entries.size()) {
-        heldValue = m_entries[index].heldValue;
-      }
+    if (entries.empty() && it->second.target.expired()) {
+      m_observedTargets.erase(it);
     }
+  }
+  
+  return collected;
+}
+
+// レジストリにつき1つのクリーンアップジョブを積む（m_mutexを保持して呼ぶ）
+void FinalizationRegistryObject::scheduleCleanupJob() {
+  if (m_pendingJobRef) {
+    return;  // 既に積まれているジョブがまとめて処理する
+  }
+  
+  // ジョブの実行までレジストリが破棄されないよう強参照で保持
+  m_pendingJobRef = aerojs::utils::RefPtr<Object>(this);
+  
+  PromiseObject::enqueueMicrotask([this]() {
+    runCleanup(Value::undefined());
     
-    // コールバックを呼び出す（ロック外で呼び出して再入を防止）
-    try {
-      if (callback.isFunction()) {
-        // cleanupSomeに渡されたコールバック関数を使用
-        std::vector<Value> args = {heldValue};
-        callback.call(Value::undefined(), args, m_globalObject);
-      } else {
-        // デフォルトのクリーンアップコールバックを使用
-        std::vector<Value> args = {heldValue};
-        m_cleanupCallback.call(Value::undefined(), args, m_globalObject);
-      }
-    } catch (const Exception& e) {
-      // コールバック内でエラーが発生した場合は無視
-      // 仕様によると、このエラーはHostに報告されるべきだが、コールバックチェーンは中断されない
-      if (m_globalObject && m_globalObject->context()) {
-        m_globalObject->context()->reportError("Error in FinalizationRegistry cleanup callback", e.getValue());
+    // 最後の参照ならレジストリが破棄されるため、ロックの外で手放す
+    aerojs::utils::RefPtr<Object> self;
+    {
+      std::unique_lock<std::shared_mutex> lock(m_mutex);
+      self.swap(m_pendingJobRef);
+      // コールバック実行中に破棄されたターゲットは次のジョブで処理
+      if (!m_pendingCleanup.empty() || !m_destroyedTargets.empty()) {
+        scheduleCleanupJob();
       }
     }
-    
-    // エントリを削除
+  });
+}
+
+// クリーンアップ待ちの一覧をまとめて処理
+void FinalizationRegistryObject::runCleanup(Value callback) {
+  // 再入を防止（他のスレッドやJSコールバックからのクリーンアップ呼び出しを防ぐ）
+  bool expected = false;
+  if (!m_isCleanupInProgress.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+    return;  // 既に処理中の場合は何もしない
+  }
+  
+  try {
+    // 破棄されたターゲットのエントリを1回の走査で集めて一覧を丸ごと取り出し、コールバックはロック外で呼ぶ
+    std::vector<PendingCleanup> batch;
     {
       std::unique_lock<std::shared_mutex> lock(m_mutex);
-      if (index < m_entries.size() && !m_entries[index].isTargetAlive.load(std::memory_order_acquire)) {
-        safeRemoveEntry(index);
+      if (!m_destroyedTargets.empty()) {
+        collectDeadTargets();
       }
+      batch.swap(m_pendingCleanup);
     }
     
+    Value function = callback.isFunction() ? callback : m_cleanupCallback;
+    std::vector<Value> args(1);
+    for (PendingCleanup& pending : batch) {
+      args[0] = std::move(pending.heldValue);
+      try {
+        function.call(Value::undefined(), args, m_globalObject);
+      } catch (const Exception& e) {
+        // 仕様によると、このエラーはHostに報告されるべきだが、残りのコールバックは中断されない
+        if (m_globalObject && m_globalObject->context()) {
+          m_globalObject->context()->reportError("Error in FinalizationRegistry cleanup callback", e.getValue());
+        }
+      }
+    }
   } catch (...) {
     // 予期せぬ例外が発生した場合でもフラグをリセット
   }
@@ -243,14 +285,16 @@ void FinalizationRegistryObject::cleanupSome(Value callback) {
   m_isCleanupInProgress.store(false, std::memory_order_release);
 }
 
+// クリーンアップ処理を実行する
+void FinalizationRegistryObject::cleanupSome(Value callback) {
+  runCleanup(callback);
+}
+
 // 監視しているターゲットのいずれかがGCされたか確認
 bool FinalizationRegistryObject::hasDeadTargets() const {
   std::shared_lock<std::shared_mutex> lock(m_mutex);
   
-  return !m_cleanupQueue.empty() || std::any_of(m_entries.begin(), m_entries.end(), 
-      [](const RegistryEntry& entry) {
-        return !entry.isTargetAlive.load(std::memory_order_acquire);
-      });
+  return !m_pendingCleanup.empty() || !m_destroyedTargets.empty();
 }
 
 // クリーンアップコールバックを取得する
@@ -258,53 +302,27 @@ Value FinalizationRegistryObject::getCleanupCallback() const {
   return m_cleanupCallback;
 }
 
+// ターゲットの破棄を記録してクリーンアップジョブを積む（ターゲットのデストラクタの中で呼ばれる）
+void FinalizationRegistryObject::weakTargetDestroyed(const aerojs::utils::RefCounted* target) {
+  // 制御ブロックのロックの中なので、エントリの取り出しはジョブに任せて記録するだけにする
+  std::unique_lock<std::shared_mutex> lock(m_mutex);
+  if (m_destroying) {
+    return;
+  }
+  m_destroyedTargets.push_back(target);
+  scheduleCleanupJob();
+}
+
 // ガベージコレクション開始前の処理
 void FinalizationRegistryObject::preGCCallback(GarbageCollector* gc) {
-  std::shared_lock<std::shared_mutex> lock(m_mutex);
-  
-  // 各エントリのWeakHandleをGCに登録
-  for (auto& entry : m_entries) {
-    gc->registerWeakHandle(&entry.target);
-  }
+  // 各エントリのWeakRefPtrはターゲットの破棄でクリアされるため登録は不要
+  (void)gc;
 }
 
 // ガベージコレクション終了後の処理
 void FinalizationRegistryObject::postGCCallback(GarbageCollector* gc) {
-  std::unique_lock<std::shared_mutex> lock(m_mutex);
-  
-  // 各エントリの生存状態を更新し、クリーンアップキューに追加
-  for (size_t i = 0; i < m_entries.size(); ++i) {
-    RegistryEntry& entry = m_entries[i];
-    bool isAlive = entry.target.get() != nullptr;
-    
-    // 状態が変化した場合のみ処理
-    bool wasAlive = entry.isTargetAlive.exchange(isAlive, std::memory_order_acq_rel);
-    if (wasAlive && !isAlive) {
-      // オブジェクトが死亡した場合、クリーンアップキューに追加
-      m_cleanupQueue.push(i);
-    }
-  }
-}
-
-// 無効なエントリをリストから削除する
-size_t FinalizationRegistryObject::removeInvalidEntries() {
-  size_t originalSize = m_entries.size();
-  
-  // 削除対象のインデックスを収集
-  std::vector<size_t> indicesToRemove;
-  for (size_t i = 0; i < m_entries.size(); ++i) {
-    if (!m_entries[i].isTargetAlive.load(std::memory_order_acquire)) {
-      indicesToRemove.push_back(i);
-    }
-  }
-  
-  // 大きいインデックスから順に削除（インデックスのずれを防ぐ）
-  std::sort(indicesToRemove.begin(), indicesToRemove.end(), std::greater<size_t>());
-  for (size_t index : indicesToRemove) {
-    safeRemoveEntry(index);
-  }
-  
-  return originalSize - m_entries.size();
+  // 破棄されたターゲットは weakTargetDestroyed で通知済みなので、GCごとの走査は不要
+  (void)gc;
 }
 
 // FinalizationRegistryコンストラクタ関数
@@ -13,12 +13,11 @@
 #include <shared_mutex>
 #include <unordered_map>
 #include <vector>
-#include <queue>
 
 #include "../../global_object.h"
 #include "../../object.h"
 #include "../../value.h"
-#include "../../../utils/memory/smart_ptr/weak_handle.h"
+#include "../../../../utils/memory/smart_ptr/ref_counted.h"
 
 namespace aero {
 
@@ -29,12 +28,26 @@ class GarbageCollector;
  * @brief FinalizationRegistryのエントリ情報
  */
 struct RegistryEntry {
-  WeakHandle<Object> target;         ///< 弱参照によるターゲットオブジェクト
+  aerojs::utils::WeakRefPtr<Object> target;  ///< 弱参照によるターゲットオブジェクト（破棄されるとクリア）
+  const aerojs::utils::RefCounted* key;      ///< 登録時のターゲットのアドレス（ターゲットごとの索引のキー）
   Value heldValue;                   ///< 保持する値
   Value unregisterToken;             ///< 登録解除トークン（オプション）
-  std::atomic<bool> isTargetAlive;   ///< ターゲットの生存状態
+};
+
+/**
+ * @brief 破棄の通知先として登録しているターゲットと、そのエントリの位置
+ */
+struct ObservedTarget {
+  aerojs::utils::WeakRefPtr<Object> target;  ///< 通知を受けている制御ブロック
+  std::vector<size_t> entries;               ///< このアドレスで登録されたエントリの m_entries 上の位置
+};
 
-  RegistryEntry() : isTargetAlive(false) {}
+/**
+ * @brief ターゲットが回収され、クリーンアップ待ちになったエントリ
+ */
+struct PendingCleanup {
+  Value heldValue;
+  Value unregisterToken;
 };
 
 /**
@@ -42,8 +55,15 @@ struct RegistryEntry {
  *
  * ECMAScript仕様に準拠したFinalizationRegistryオブジェクトの実装。
  * オブジェクトがガベージコレクトされた後にクリーンアップコードを実行するための仕組み。
+ *
+ * ターゲットはGCセルではなく参照カウントで管理されるため、破棄でクリアされる
+ * WeakRefPtrで保持し、その制御ブロックに破棄の通知先として登録する。
+ * 通知はどちらのGCでも（参照カウントでの破棄でも）ターゲットのデストラクタから届く。
+ * 通知では破棄されたターゲットを記録してレジストリにつき1つのクリーンアップジョブを
+ * マイクロタスクキューに積むだけで、ジョブがターゲットごとの索引から記録された
+ * ターゲットのエントリだけを取り出して処理する（全エントリの走査はしない）。
  */
-class FinalizationRegistryObject : public Object {
+class FinalizationRegistryObject : public Object, public aerojs::utils::WeakReferenceObserver {
  public:
   /**
    * @brief コンストラクタ
@@ -108,6 +128,12 @@ class FinalizationRegistryObject : public Object {
    */
   Value getCleanupCallback() const;
 
+  /**
+   * @brief ターゲットの破棄でクリーンアップジョブを積む（WeakReferenceObserver）
+   * @param target 破棄中のターゲット
+   */
+  void weakTargetDestroyed(const aerojs::utils::RefCounted* target) override;
+
   /**
    * @brief ガベージコレクション開始前の処理
    * @param gc ガベージコレクタへの参照
@@ -142,9 +168,29 @@ class FinalizationRegistryObject : public Object {
   std::vector<RegistryEntry> m_entries;
 
   /**
-   * @brief クリーンアップ待ちのエントリのインデックスキュー
+   * @brief ターゲットが回収されたエントリの一覧（次のクリーンアップでまとめて処理）
+   */
+  std::vector<PendingCleanup> m_pendingCleanup;
+
+  /**
+   * @brief クリーンアップジョブが積まれている間、レジストリ自身を生存させる強参照
+   */
+  aerojs::utils::RefPtr<Object> m_pendingJobRef;
+
+  /**
+   * @brief 破棄の通知先として登録しているターゲットとエントリの索引（エントリがなくなったターゲットはクリーンアップで外す）
+   */
+  std::unordered_map<const aerojs::utils::RefCounted*, ObservedTarget> m_observedTargets;
+
+  /**
+   * @brief 前回のクリーンアップ以降に破棄の通知を受けたターゲット
+   */
+  std::vector<const aerojs::utils::RefCounted*> m_destroyedTargets;
+
+  /**
+   * @brief デストラクタで通知の登録を外している間は通知を無視する
    */
-  std::queue<size_t> m_cleanupQueue;
+  bool m_destroying;
 
   /**
    * @brief unregisterTokenによるエントリの検索用マップ
@@ -163,22 +209,37 @@ class FinalizationRegistryObject : public Object {
   std::atomic<bool> m_isCleanupInProgress;
 
   /**
-   * @brief 無効なエントリをリストから削除する
-   * @return 削除されたエントリの数
+   * @brief 破棄の通知を受けたターゲットのエントリをクリーンアップ待ちの一覧へ移す（m_mutexを保持して呼ぶ）
+   * @return 移したエントリの数
    */
-  size_t removeInvalidEntries();
+  size_t collectDeadTargets();
 
   /**
-   * @brief クリーンアップキューにエントリを追加
-   * @param index エントリのインデックス
+   * @brief クリーンアップジョブを積む（未スケジュールの場合のみ）
    */
-  void addToCleanupQueue(size_t index);
+  void scheduleCleanupJob();
+
+  /**
+   * @brief クリーンアップ待ちの一覧をまとめて取り出し、各heldValueでコールバックを呼ぶ
+   * @param callback 呼び出すコールバック（undefinedならコンストラクタで渡されたもの）
+   */
+  void runCleanup(Value callback);
 
   /**
    * @brief エントリを安全に削除
    * @param index 削除するエントリのインデックス
    */
   void safeRemoveEntry(size_t index);
+
+  /**
+   * @brief ターゲットごとの索引でエントリの位置を付け替える
+   * @param key エントリのターゲットのアドレス
+   * @param from 元の位置
+   * @param to 新しい位置（kNoEntry なら索引から外す）
+   */
+  void reindexEntry(const aerojs::utils::RefCounted* key, size_t from, size_t to);
+
+  static constexpr size_t kNoEntry = static_cast<size_t>(-1);
 };
 
 /**
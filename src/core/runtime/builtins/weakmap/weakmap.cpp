@@ -8,6 +8,8 @@
 
 #include <algorithm>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "core/runtime/context.h"
 #include "core/runtime/error.h"
@@ -17,11 +19,6 @@
 
 namespace aero {
 
-// ObjectWeakPtrクラスの実装
-WeakMapObject::ObjectWeakPtr::ObjectWeakPtr(Object* obj)
-    : m_ptr(obj), m_hash(std::hash<Object*>()(obj)) {
-}
-
 // WeakMapObjectコンストラクタの実装
 WeakMapObject::WeakMapObject(Object* prototype)
     : Object(prototype), m_entries() {
@@ -69,7 +66,21 @@ WeakMapObject::WeakMapObject(Object* prototype, Value iterable)
 }
 
 // デストラクタ
-WeakMapObject::~WeakMapObject() = default;
+WeakMapObject::~WeakMapObject() {
+  // 通知の登録は表のロックを外してから解除する（通知は制御ブロックのロックの中で表をロックする）
+  std::vector<aerojs::utils::WeakRefPtr<Object>> keys;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    keys.reserve(m_entries.size());
+    m_entries.forEach([&keys](Object*, const WeakMapEntry& entry) {
+      keys.push_back(entry.key);
+    });
+    m_entries.clear();
+  }
+  for (const auto& key : keys) {
+    key.control()->removeObserver(this);
+  }
+}
 
 // キーが有効かどうかを確認（オブジェクトであること）
 bool WeakMapObject::validateKey(Value key) {
@@ -92,11 +103,13 @@ Value WeakMapObject::set(Value key, Value value) {
   // キーをオブジェクトとして取得
   Object* keyObj = key.asObject();
 
-  // オブジェクトへの弱参照を作成してキーとして使用
-  ObjectWeakPtr weakPtr(keyObj);
+  // キーの破棄で通知を受ける（表のロックの外で登録する）
+  aerojs::utils::WeakRefPtr<Object> weakKey(keyObj);
+  weakKey.control()->addObserver(this);
 
-  // 値をマップに設定
-  m_entries[weakPtr] = value;
+  // キーは強参照せず、同一性で表に設定
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.set(keyObj, WeakMapEntry{std::move(weakKey), value});
 
   // メソッドチェーン用にthisを返す
   return Value(this);
@@ -112,13 +125,10 @@ Value WeakMapObject::get(Value key) const {
   // キーをオブジェクトとして取得
   Object* keyObj = key.asObject();
 
-  // オブジェクトへの弱参照を作成してキーとして使用
-  ObjectWeakPtr weakPtr(keyObj);
-
-  // マップからキーを探索
-  auto it = m_entries.find(weakPtr);
-  if (it != m_entries.end()) {
-    return it->second;
+  // 表からキーを探索
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (const WeakMapEntry* entry = m_entries.find(keyObj)) {
+    return entry->value;
   }
 
   // キーが存在しない場合はundefinedを返す
@@ -135,11 +145,9 @@ bool WeakMapObject::has(Value key) const {
   // キーをオブジェクトとして取得
   Object* keyObj = key.asObject();
 
-  // オブジェクトへの弱参照を作成してキーとして使用
-  ObjectWeakPtr weakPtr(keyObj);
-
-  // マップにキーが存在するかチェック
-  return m_entries.find(weakPtr) != m_entries.end();
+  // 表にキーが存在するかチェック
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.contains(keyObj);
 }
 
 // 指定されたキーとそれに関連付けられた値を削除
@@ -152,11 +160,27 @@ bool WeakMapObject::remove(Value key) {
   // キーをオブジェクトとして取得
   Object* keyObj = key.asObject();
 
-  // オブジェクトへの弱参照を作成してキーとして使用
-  ObjectWeakPtr weakPtr(keyObj);
+  // 表からキーを削除し、通知の登録は表のロックを外してから解除する
+  aerojs::utils::WeakRefPtr<Object> weakKey;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    WeakMapEntry* entry = m_entries.find(keyObj);
+    if (!entry) {
+      return false;
+    }
+    weakKey = std::move(entry->key);
+    m_entries.remove(keyObj);
+  }
+  weakKey.control()->removeObserver(this);
+  return true;
+}
 
-  // マップからキーを削除し、削除が成功したかを返す
-  return m_entries.erase(weakPtr) > 0;
+// キーの破棄でエントリを削除（キーのメモリが再利用される前に呼ばれる）
+void WeakMapObject::weakTargetDestroyed(const aerojs::utils::RefCounted* target) {
+  // キーのオブジェクト部分は破棄済みなので、アドレスの照合にだけ使う
+  const Object* keyObj = static_cast<const Object*>(target);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.remove(keyObj);
 }
 
 // WeakMap.prototype.delete 実装
@@ -7,24 +7,41 @@
 #ifndef AERO_WEAKMAP_H
 #define AERO_WEAKMAP_H
 
-#include <memory>
-#include <unordered_map>
+#include <mutex>
 
 #include "core/runtime/object.h"
 #include "core/runtime/value.h"
+#include "utils/memory/gc/ephemeron_table.h"
+#include "utils/memory/smart_ptr/ref_counted.h"
 
 namespace aero {
 
 class Context;
 
+/**
+ * @brief WeakMap のエントリ
+ *
+ * key は破棄の通知を受ける制御ブロックを保持するための弱参照で、
+ * 対象の寿命は延ばさない。
+ */
+struct WeakMapEntry {
+  aerojs::utils::WeakRefPtr<Object> key;
+  Value value;
+};
+
 /**
  * @class WeakMapObject
  * @brief JavaScript の WeakMap オブジェクトを実装するクラス
  *
  * WeakMapはキーとしてオブジェクトのみを持ち、そのオブジェクトへの参照が弱参照となるコレクションです。
  * キーとなるオブジェクトが到達不能になると、対応する値もガベージコレクションの対象となります。
+ *
+ * キーは参照カウントで管理されるオブジェクトで、表はキーを強参照しません。
+ * キーの弱参照の制御ブロックに破棄の通知先として登録し、キーのデストラクタの中
+ * （メモリが再利用される前）でエントリを取り除きます。アドレスが再利用されても
+ * 古い値が新しいオブジェクトのものとして見えることはありません。
  */
-class WeakMapObject : public Object {
+class WeakMapObject : public Object, public aerojs::utils::WeakReferenceObserver {
  public:
   /**
    * @brief コンストラクタ
@@ -77,6 +94,21 @@ class WeakMapObject : public Object {
    */
   bool remove(Value key);
 
+  /**
+   * @brief キーの破棄でエントリを取り除く（WeakReferenceObserver）
+   * @param target 破棄中のキー
+   */
+  void weakTargetDestroyed(const aerojs::utils::RefCounted* target) override;
+
+  /**
+   * @brief 現在のエントリ数を取得する
+   * @return エントリ数
+   */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+  }
+
   /**
    * @brief このオブジェクトがWeakMapかどうかを確認する
    * @return 常にtrue
@@ -111,80 +143,11 @@ class WeakMapObject : public Object {
    */
   static bool validateKey(Value key);
 
-  /**
-   * @class ObjectWeakPtr
-   * @brief オブジェクトへの弱参照を保持するためのラッパークラス
-   */
-  class ObjectWeakPtr {
-   public:
-    /**
-     * @brief コンストラクタ
-     * @param obj 弱参照として保持するオブジェクト
-     */
-    explicit ObjectWeakPtr(Object* obj)
-        : m_ptr(obj) {
-    }
-
-    /**
-     * @brief 保持しているオブジェクトを取得する
-     * @return オブジェクトへのポインタ。オブジェクトが破棄されていればnullptr
-     */
-    Object* get() const {
-      return m_ptr.lock().get();
-    }
-
-    /**
-     * @brief 保持しているオブジェクトのハッシュ値を取得する
-     * @return ハッシュ値
-     */
-    size_t hash() const {
-      return m_hash;
-    }
-
-    /**
-     * @brief 等価比較演算子
-     * @param other 比較対象
-     * @return 同じオブジェクトを参照している場合はtrue
-     */
-    bool operator==(const ObjectWeakPtr& other) const {
-      // ハッシュが異なれば確実に異なるオブジェクト
-      if (m_hash != other.m_hash) {
-        return false;
-      }
-
-      // どちらかがexpireしている場合は不一致
-      auto thisPtr = m_ptr.lock();
-      auto otherPtr = other.m_ptr.lock();
-      if (!thisPtr || !otherPtr) {
-        return false;
-      }
-
-      // 同じオブジェクトを指しているかチェック
-      return thisPtr.get() == otherPtr.get();
-    }
-
-   private:
-    std::weak_ptr<Object> m_ptr;  ///< オブジェクトへの弱参照
-    size_t m_hash;                ///< オブジェクトのハッシュ値（固定）
-  };
+  /// キーオブジェクトの同一性で引く表（キーは強参照しない）
+  aerojs::utils::memory::EphemeronTable<Object, WeakMapEntry> m_entries;
 
-  /**
-   * @struct WeakPtrHasher
-   * @brief ObjectWeakPtrのハッシュ計算用関数オブジェクト
-   */
-  struct WeakPtrHasher {
-    /**
-     * @brief ハッシュ値を計算する
-     * @param ptr ハッシュ値を計算するObjectWeakPtr
-     * @return ハッシュ値
-     */
-    size_t operator()(const ObjectWeakPtr& ptr) const {
-      return ptr.hash();
-    }
-  };
-
-  /// キーとなるオブジェクトの弱参照と値のマップ
-  std::unordered_map<ObjectWeakPtr, Value, WeakPtrHasher> m_entries;
+  /// 表の保護（キーの破棄は任意のスレッドから通知される）
+  mutable std::mutex m_mutex;
 };
 
 // WeakMapプロトタイプメソッド
@@ -8,7 +8,6 @@
 #include "../../global_object.h"
 #include "weakref.h"
 #include "../../../utils/memory/gc/garbage_collector.h"
-#include "../../../utils/memory/smart_ptr/handle_manager.h"
 
 namespace aero {
 
@@ -30,16 +29,6 @@ void registerWeakRefBuiltin(GlobalObject* globalObj) {
     });
   }
   
-  // ハンドルマネージャーとの連携を確保
-  HandleManager* handleManager = HandleManager::getInstance();
-  if (handleManager) {
-    // WeakRefオブジェクトからのWeakHandleの適切な管理を設定
-    handleManager->registerHandleProvider("WeakRef", [globalObj](Object* obj) {
-      // WeakRefオブジェクトに対する特別な処理があればここに実装
-      return obj && obj->isWeakRef();
-    });
-  }
-  
   if (globalObj->context() && globalObj->context()->debugMode()) {
     globalObj->context()->logger()->info("WeakRef module initialized");
   }
@@ -14,7 +14,6 @@
 #include "../../value.h"
 #include "../function/function.h"
 #include "../../../utils/memory/gc/garbage_collector.h"
-#include "../../../utils/memory/smart_ptr/handle_manager.h"
 
 namespace aero {
 
@@ -37,8 +36,7 @@ WeakRefObject::WeakRefObject(Value target, GlobalObject* globalObj)
 }
 
 WeakRefObject::~WeakRefObject() {
-  // WeakHandleはGCによって自動的に管理されるため、
-  // 明示的なクリーンアップは不要
+  // WeakRefPtrは制御ブロックの参照を手放すだけで、ターゲットには触れない
 }
 
 // 弱参照しているターゲットを取得する
@@ -52,11 +50,11 @@ Value WeakRefObject::deref() const {
   // ミューテックスでロックしてターゲットの生存を確認
   std::lock_guard<std::mutex> lock(m_mutex);
   
-  // WeakHandleからオブジェクトを取得
-  Object* targetObj = m_target.get();
+  // 破棄処理中のターゲットを返さないよう、強参照に昇格できた場合だけ返す
+  aerojs::utils::RefPtr<Object> targetObj = m_target.lock();
   
   if (targetObj) {
-    return Value(targetObj);
+    return Value(targetObj.get());
   } else {
     // ターゲットが無効になった場合はフラグを更新
     m_targetAlive.store(false, std::memory_order_release);
@@ -73,9 +71,8 @@ void WeakRefObject::setTarget(Value target) {
     throw TypeException("WeakRef target must be an object");
   }
   
-  // グローバルのHandleManagerからWeakHandleを取得
-  HandleManager* handleManager = HandleManager::getInstance();
-  m_target = handleManager->createWeakHandle(obj);
+  // ターゲットの破棄でクリアされる弱参照を作成
+  m_target = aerojs::utils::WeakRefPtr<Object>(obj);
   
   // ターゲットが生きていることを記録
   m_targetAlive.store(true, std::memory_order_release);
@@ -90,14 +87,15 @@ void WeakRefObject::clearTarget() {
 
 // ガベージコレクション開始前の処理
 void WeakRefObject::preGCCallback(GarbageCollector* gc) {
-  // GC前の準備：必要に応じてWeakHandleを追跡対象としてGCに登録
-  gc->registerWeakHandle(&m_target);
+  // ターゲットの破棄時に弱参照がクリアされるため、GCへの登録は不要
+  (void)gc;
 }
 
 // ガベージコレクション終了後の処理
 void WeakRefObject::postGCCallback(GarbageCollector* gc) {
   // GC後の処理：ターゲットの生存状態を更新
-  bool targetExists = m_target.get() != nullptr;
+  (void)gc;
+  bool targetExists = !m_target.expired();
   m_targetAlive.store(targetExists, std::memory_order_release);
 }
 
@@ -14,7 +14,7 @@
 #include "../../global_object.h"
 #include "../../object.h"
 #include "../../value.h"
-#include "../../../utils/memory/smart_ptr/weak_handle.h"
+#include "../../../../utils/memory/smart_ptr/ref_counted.h"
 
 namespace aero {
 
@@ -95,9 +95,10 @@ class WeakRefObject : public Object {
  private:
   /**
    * @brief 弱参照によるターゲットオブジェクト
-   * AeroJSのメモリ管理システムと統合するWeakHandleを使用
+   * Objectは参照カウントで管理されGCセルではないため、GCのハンドルテーブルではなく
+   * 対象の破棄でクリアされるWeakRefPtrを使う
    */
-  WeakHandle<Object> m_target;
+  aerojs::utils::WeakRefPtr<Object> m_target;
 
   /**
    * @brief グローバルオブジェクト
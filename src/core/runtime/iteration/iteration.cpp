@@ -326,26 +326,35 @@ Array* Iterator::collectToArray(ExecutionContext* ctx, Object* iterator) {
     return nullptr;
   }
 
+  // nextメソッドは最初に1回だけ取得する
+  Value nextMethod = iterator->get(ctx, "next");
+  if (!nextMethod.isCallable()) {
+    ctx->throwError(Error::createTypeError(ctx, "Iterator.next is not callable"));
+    return nullptr;
+  }
+
   // 配列を作成
   Array* array = Array::create(ctx);
   uint32_t index = 0;
+  std::vector<Value> args;
 
   // イテレーターを完了まで実行
   while (true) {
-    // nextメソッドを呼び出す
-    Object* result = next(ctx, iterator);
-    if (!result) {
-      break;
+    // nextメソッドを呼び出す（結果はすぐに分解するのでラップしない）
+    Value result = nextMethod.asFunction()->call(ctx, Value(iterator), args);
+    if (!result.isObject()) {
+      ctx->throwError(Error::createTypeError(ctx, "Iterator result is not an object"));
+      return nullptr;
     }
 
     // doneフラグを確認
-    bool done = IteratorResult::getDone(ctx, result);
+    bool done = IteratorResult::getDone(ctx, result.asObject());
     if (done) {
       break;
     }
 
     // 値を配列に追加
-    Value value = IteratorResult::getValue(ctx, result);
+    Value value = IteratorResult::getValue(ctx, result.asObject());
     array->defineProperty(ctx, std::to_string(index), value,
                           PropertyDescriptor::createDataDescriptorFlags(
                               PropertyDescriptor::Writable |
@@ -361,6 +370,107 @@ Array* Iterator::collectToArray(ExecutionContext* ctx, Object* iterator) {
   return array;
 }
 
+//-----------------------------------------------------------------------------
+// ForOfIterator クラスの実装
+//-----------------------------------------------------------------------------
+
+namespace {
+
+// 配列の反復が組み込みの振る舞いのままかどうか
+bool hasIntrinsicArrayIteration(ExecutionContext* ctx, Object* array) {
+  Object* globalObj = ctx->getGlobalObject();
+  Value intrinsicValues = globalObj->getInternalSlot("ArrayPrototypeValues");
+  Value intrinsicNext = globalObj->getInternalSlot("ArrayIteratorNext");
+  if (!intrinsicValues.isObject() || !intrinsicNext.isObject()) {
+    return false;
+  }
+
+  Value iteratorMethod = array->get(ctx, Symbol::iterator);
+  if (!iteratorMethod.isObject() || iteratorMethod.asObject() != intrinsicValues.asObject()) {
+    return false;
+  }
+
+  Value arrayIteratorProto = globalObj->getInternalSlot("ArrayIteratorPrototype");
+  if (!arrayIteratorProto.isObject()) {
+    return false;
+  }
+  Value nextMethod = arrayIteratorProto.asObject()->get(ctx, "next");
+  return nextMethod.isObject() && nextMethod.asObject() == intrinsicNext.asObject();
+}
+
+}  // namespace
+
+ForOfIterator::ForOfIterator(ExecutionContext* ctx, Value iterable)
+    : m_ctx(ctx),
+      m_array(nullptr),
+      m_index(0),
+      m_iterator(nullptr),
+      m_nextMethod(Value::createUndefined()),
+      m_done(false) {
+  if (iterable.isArray() && hasIntrinsicArrayIteration(ctx, iterable.asObject())) {
+    m_array = iterable.asObject();
+    return;
+  }
+
+  m_iterator = Iterable::getIterator(ctx, iterable);
+  if (!m_iterator) {
+    m_done = true;
+    return;
+  }
+
+  m_nextMethod = m_iterator->get(ctx, "next");
+  if (!m_nextMethod.isCallable()) {
+    ctx->throwError(Error::createTypeError(ctx, "Iterator.next is not callable"));
+    m_done = true;
+  }
+}
+
+bool ForOfIterator::step(Value& value) {
+  if (m_done) {
+    return false;
+  }
+
+  if (m_array) {
+    // 要素の追加・削除を反映するため length は毎回読む
+    uint32_t length = static_cast<uint32_t>(m_array->get(m_ctx, "length").toNumber());
+    if (m_index >= length) {
+      m_done = true;
+      return false;
+    }
+    value = m_array->get(m_ctx, std::to_string(m_index));
+    m_index++;
+    return true;
+  }
+
+  std::vector<Value> args;
+  Value result = m_nextMethod.asFunction()->call(m_ctx, Value(m_iterator), args);
+  if (!result.isObject()) {
+    m_ctx->throwError(Error::createTypeError(m_ctx, "Iterator result is not an object"));
+    m_done = true;
+    return false;
+  }
+
+  if (IteratorResult::getDone(m_ctx, result.asObject())) {
+    m_done = true;
+    return false;
+  }
+
+  value = IteratorResult::getValue(m_ctx, result.asObject());
+  return true;
+}
+
+void ForOfIterator::close() {
+  if (m_done) {
+    return;
+  }
+  m_done = true;
+
+  // 配列の高速経路ではイテレーターを作っていないので閉じるものがない
+  if (m_iterator) {
+    completeIterator(m_ctx, m_iterator, Value::createUndefined());
+  }
+}
+
 //-----------------------------------------------------------------------------
 // AsyncIterator クラスの実装
 //-----------------------------------------------------------------------------
@@ -844,6 +954,11 @@ void initializeIterationProtocol(ExecutionContext* ctx, Object* globalObj) {
   globalObj->setInternalSlot("GeneratorObjectPrototype", generatorObjectProto);
   globalObj->setInternalSlot("AsyncIteratorPrototype", asyncIteratorProto);
   globalObj->setInternalSlot("AsyncGeneratorPrototype", asyncGeneratorProto);
+
+  // ForOfIterator が配列の反復を書き換えられていないか判定するための組み込み関数
+  Object* arrayPrototype = globalObj->get(ctx, "Array").asObject()->get(ctx, "prototype").asObject();
+  globalObj->setInternalSlot("ArrayPrototypeValues", arrayPrototype->get(ctx, Symbol::iterator));
+  globalObj->setInternalSlot("ArrayIteratorNext", arrayIteratorProto->get(ctx, "next"));
 }
 
 std::pair<Object*, Object*> createIteratorPrototypes(ExecutionContext* ctx, Object* objectPrototype) {
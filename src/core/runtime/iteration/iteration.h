@@ -212,6 +212,59 @@ class Iterator {
   static Array* collectToArray(ExecutionContext* ctx, Object* iterator);
 };
 
+/**
+ * @brief 結果オブジェクトを生成しない反復
+ *
+ * for-of、スプレッド、Array.from のように {value, done} を呼び出し側が
+ * すぐに分解する箇所で使う。結果オブジェクトが外に漏れないため、
+ * 次の2つの経路で生成そのものを省く。
+ *
+ * - 組み込み配列: Symbol.iterator と %ArrayIteratorPrototype%.next が
+ *   初期化時のものから変わっていなければ、イテレーターを作らず添字で読む。
+ *   length は毎回読み直すので、反復中の要素追加・削除は仕様どおり反映される。
+ * - それ以外: next を最初に1回だけ取得して呼び出し、返ってきたオブジェクトから
+ *   done と value を直接読む（IteratorResult::wrap で包み直さない）。
+ */
+class ForOfIterator {
+ public:
+  /**
+   * @param ctx 実行コンテキスト
+   * @param iterable 反復対象
+   */
+  ForOfIterator(ExecutionContext* ctx, Value iterable);
+
+  /**
+   * @brief 次の値を取り出す
+   *
+   * @param value 取り出した値の格納先
+   * @return 値を取り出した場合はtrue、完了またはエラーの場合はfalse
+   */
+  bool step(Value& value);
+
+  /**
+   * @brief 途中で抜ける場合にイテレーターの return を呼ぶ
+   */
+  void close();
+
+  /**
+   * @brief 配列の高速経路で反復しているかどうか
+   */
+  bool isFastArray() const { return m_array != nullptr; }
+
+  /**
+   * @brief 反復中に生かしておくオブジェクト（高速経路では配列、汎用経路ではイテレーター）
+   */
+  Object* target() const { return m_array ? m_array : m_iterator; }
+
+ private:
+  ExecutionContext* m_ctx;
+  Object* m_array;     ///< 高速経路の配列（汎用経路ではnullptr）
+  uint32_t m_index;
+  Object* m_iterator;  ///< 汎用経路のイテレーター
+  Value m_nextMethod;
+  bool m_done;
+};
+
 /**
  * @brief 非同期イテレーターオブジェクト
  *
@@ -11,6 +11,7 @@
 #include "array.h"
 #include "string.h"
 #include "../context.h"
+#include "../../../utils/memory/pool/typed_pool.h"
 
 #include <sstream>
 #include <stdexcept>
@@ -632,5 +633,21 @@ ArgumentsObject::~ArgumentsObject() {
   }
 }
 
+void* ArgumentsObject::operator new(std::size_t size) {
+  // 派生クラスはサイズが異なるのでプールを使わない
+  if (size != sizeof(ArgumentsObject)) {
+    return ::operator new(size);
+  }
+  return aerojs::utils::memory::TypedFreeListPool<ArgumentsObject>::local().allocate();
+}
+
+void ArgumentsObject::operator delete(void* ptr, std::size_t size) {
+  if (size != sizeof(ArgumentsObject)) {
+    ::operator delete(ptr);
+    return;
+  }
+  aerojs::utils::memory::TypedFreeListPool<ArgumentsObject>::local().deallocate(ptr);
+}
+
 }  // namespace core
 }  // namespace aerojs 
\ No newline at end of file
@@ -11,7 +11,9 @@
 #include "object.h"
 #include "value.h"
 
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -21,6 +23,7 @@ namespace core {
 // 前方宣言
 class Context;
 class Array;
+class FeedbackVector;
 
 /**
  * @brief ネイティブ関数の型定義
@@ -210,6 +213,20 @@ class Function : public Object {
    */
   void setPrototypeProperty(Object* prototype);
 
+  /**
+   * @brief 命令サイトのフィードバックベクタを取得（ネイティブ関数などでは nullptr）
+   */
+  FeedbackVector* feedbackVector() const {
+    return feedbackVector_.get();
+  }
+
+  /**
+   * @brief フィードバックベクタを設定（同じ FunctionInfo から作った関数は共有する）
+   */
+  void setFeedbackVector(std::shared_ptr<FeedbackVector> feedbackVector) {
+    feedbackVector_ = std::move(feedbackVector);
+  }
+
   /**
    * @brief 関数の文字列表現を取得
    * @return "[object Function]"
@@ -254,6 +271,9 @@ class Function : public Object {
   
   // プロトタイプオブジェクト
   Object* prototypeProperty_;
+
+  // インタプリタとJITが共有する型フィードバック
+  std::shared_ptr<FeedbackVector> feedbackVector_;
   
   // 内部ヘルパー関数
   Value* callNativeFunction(Context* context, Value* thisArg, const std::vector<Value*>& args);
@@ -289,6 +309,10 @@ class ArgumentsObject : public Object {
   std::string toString() const override {
     return "[object Arguments]";
   }
+
+  // 呼び出しごとに作られてすぐ捨てられるので、スレッドごとの型別プールから確保する
+  static void* operator new(std::size_t size);
+  static void operator delete(void* ptr, std::size_t size);
   
  private:
   std::vector<Value*> arguments_;
@@ -10,13 +10,36 @@
 #include "value.h"
 #include "symbol.h"
 #include "function.h"
+#include "../../jit/ic/inline_cache.h"
+#include "../../jit/optimizing/compilation_dependencies.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <map>
+#include <mutex>
+#include <utility>
 
 namespace aerojs {
 namespace core {
 
+namespace {
+
+// プロトタイプを持たないオブジェクトの初期シェイプ
+constexpr uint64_t kNullPrototypeRootShape = 1;
+
+std::atomic<uint64_t> g_nextShapeId{kNullPrototypeRootShape + 1};
+
+// (親シェイプ, 追加したキー) から子シェイプへの遷移。エンジンをまたいで共有する
+std::mutex g_shapeTransitionMutex;
+std::map<std::pair<uint64_t, std::string>, uint64_t> g_shapeTransitions;
+
+uint64_t allocateShapeId() {
+  return g_nextShapeId.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
 // PropertyDescriptor の実装
 PropertyDescriptor::PropertyDescriptor()
     : value_(nullptr), getter_(nullptr), setter_(nullptr),
@@ -230,6 +253,8 @@ Object::Object(Object* prototype)
   if (prototype_) {
     prototype_->ref();
   }
+
+  detachShape();
 }
 
 Object::~Object() {
@@ -248,6 +273,49 @@ Object* Object::getPrototype() const {
   return prototype_;
 }
 
+uint64_t Object::getShapeId() const {
+  if (shapeId_ == 0) {
+    Object* prototype = prototype_;
+    if (!prototype) {
+      shapeId_ = kNullPrototypeRootShape;
+    } else {
+      if (prototype->prototypeRootShape_ == 0) {
+        prototype->prototypeRootShape_ = allocateShapeId();
+      }
+      shapeId_ = prototype->prototypeRootShape_;
+    }
+  }
+  return shapeId_;
+}
+
+void Object::transitionShape(const std::string& name) {
+  uint64_t parent = getShapeId();
+  if (prototypeRootShape_ != 0) {
+    // プロトタイプへの追加は、これを継承する全シェイプの探索結果を変えうる
+    detachShape();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(g_shapeTransitionMutex);
+  auto result = g_shapeTransitions.emplace(std::make_pair(parent, name), 0);
+  if (result.second) {
+    result.first->second = allocateShapeId();
+  }
+  shapeId_ = result.first->second;
+}
+
+void Object::detachShape() {
+  uint64_t previous = shapeId_;
+  shapeId_ = allocateShapeId();
+  if (prototypeRootShape_ != 0) {
+    // プロトタイプの古いシェイプは二度と現れない。継承先のシェイプは変わらないので、
+    // プロトタイプ経由の前提は全部捨てる
+    if (previous != 0) {
+      InlineCacheManager::invalidateForShape(previous);
+    }
+    CompilationDependencies::instance().invalidateAllShapes();
+  }
+}
+
 void Object::setPrototype(Object* prototype) {
   // 循環参照チェック
   Object* current = prototype;
@@ -309,10 +377,22 @@ bool Object::defineProperty(const PropertyKey& key, const PropertyDescriptor& de
       }
     }
     
+    if (existing.isAccessor() != descriptor.isAccessor() ||
+        existing.enumerable() != descriptor.enumerable() ||
+        existing.configurable() != descriptor.configurable() ||
+        (!descriptor.isAccessor() && existing.writable() != descriptor.writable())) {
+      // 属性の変更はキャッシュした格納方法を無効にする
+      detachShape();
+    }
     existing = descriptor;
   } else {
     // 新しいプロパティを追加
     properties_[key] = descriptor;
+    if (key.isString()) {
+      transitionShape(key.toString());
+    } else {
+      detachShape();
+    }
   }
   
   return true;
@@ -461,6 +541,7 @@ bool Object::deleteProperty(const PropertyKey& key) {
     }
     
     properties_.erase(it);
+    detachShape();
     return true;
   }
   
@@ -8,12 +8,14 @@
 #ifndef AEROJS_OBJECT_H
 #define AEROJS_OBJECT_H
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "src/core/runtime/types/value_type.h"
 #include "src/utils/containers/hashmap/hashmap.h"
+#include "src/utils/memory/smart_ptr/compressed_ptr.h"
 #include "src/utils/memory/smart_ptr/ref_counted.h"
 
 namespace aerojs {
@@ -33,8 +35,8 @@ class Context;
 struct Property {
   Value* value;         // プロパティ値
   PropertyFlags flags;  // プロパティ属性フラグ
-  Function* getter;     // ゲッター関数（アクセサプロパティの場合）
-  Function* setter;     // セッター関数（アクセサプロパティの場合）
+  utils::CompressedPtr<Function> getter;  // ゲッター関数（アクセサプロパティの場合）
+  utils::CompressedPtr<Function> setter;  // セッター関数（アクセサプロパティの場合）
 
   // デフォルトコンストラクタ
   Property()
@@ -100,6 +102,16 @@ class Object : public utils::RefCounted {
    */
   ~Object() override;
 
+#ifdef AEROJS_POINTER_COMPRESSION
+  // 圧縮参照の参照先となるため、ヒープケージ内に割り当てる
+  static void* operator new(size_t size) {
+    return utils::memory::HeapCage::allocateObject(size);
+  }
+  static void operator delete(void* ptr) {
+    utils::memory::HeapCage::freeObject(ptr);
+  }
+#endif
+
   /**
    * @brief 文字列をキーとしたプロパティの取得
    * @param key プロパティ名
@@ -305,6 +317,15 @@ class Object : public utils::RefCounted {
    */
   bool isPrototypeOf(const Object* obj) const;
 
+  /**
+   * @brief オブジェクトのシェイプIDを取得
+   *
+   * 同じプロトタイプから同じ順序で同じ文字列キーを追加したオブジェクトは同じIDを持つ。
+   * IDはプロセス内で一意で、インラインキャッシュと最適化コードの依存に使う。
+   * @return シェイプID
+   */
+  uint64_t getShapeId() const;
+
   /**
    * @brief オブジェクトの種類を確認
    * @return オブジェクトの種類を表すフラグ
@@ -407,8 +428,8 @@ class Object : public utils::RefCounted {
   // オブジェクトのフラグ
   ObjectFlags flags_;
 
-  // オブジェクトのプロトタイプ
-  Object* prototype_;
+  // オブジェクトのプロトタイプ（ポインタ圧縮時は32ビット）
+  utils::CompressedPtr<Object> prototype_;
 
   // 実行コンテキスト
   Context* context_;
@@ -424,6 +445,18 @@ class Object : public utils::RefCounted {
   // インデックス付きプロパティ（配列など用）
   std::unordered_map<uint32_t, Property*> indexedProps_;
 
+  // シェイプID（0は未割り当て。最初の問い合わせかプロパティ追加で決まる）
+  mutable uint64_t shapeId_ = 0;
+
+  // このオブジェクトをプロトタイプに持つオブジェクトの初期シェイプ（0は未使用）
+  mutable uint64_t prototypeRootShape_ = 0;
+
+  // 文字列キーの追加によるシェイプの遷移
+  void transitionShape(const std::string& name);
+
+  // 遷移で表せない変更（削除・属性変更など）で、共有しない新しいシェイプにする
+  void detachShape();
+
   // プロパティ検索のヘルパーメソッド
   Property* findProperty(const String* key) const;
   Property* findProperty(const Symbol* key) const;
@@ -123,7 +123,7 @@ String::String(String* source, size_t offset, size_t length)
   assert(offset + length <= source->length());
   
   sliced_.source = source;
-  sliced_.offset = offset;
+  sliced_.offset = static_cast<decltype(sliced_.offset)>(offset);
   source->ref(); // 参照元を保持
   
   // UTF-8文字数の計算は必要に応じて行う
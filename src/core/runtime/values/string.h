@@ -15,6 +15,7 @@
 #include <unordered_map>
 
 #include "src/utils/containers/string/string_view.h"
+#include "src/utils/memory/smart_ptr/compressed_ptr.h"
 #include "src/utils/memory/smart_ptr/ref_counted.h"
 
 namespace aerojs {
@@ -73,6 +74,16 @@ class String : public utils::RefCounted {
    */
   ~String() override;
 
+#ifdef AEROJS_POINTER_COMPRESSION
+  // スライス・連結文字列から圧縮参照されるため、ヒープケージ内に割り当てる
+  static void* operator new(size_t size) {
+    return utils::memory::HeapCage::allocateObject(size);
+  }
+  static void operator delete(void* ptr) {
+    utils::memory::HeapCage::freeObject(ptr);
+  }
+#endif
+
   /**
    * @brief 文字列長(バイト数)を取得
    * @return 文字列のバイト長
@@ -314,14 +325,18 @@ class String : public utils::RefCounted {
 
     // スライス文字列用の参照
     struct {
-      String* source;
+      utils::CompressedPtr<String> source;
+#ifdef AEROJS_POINTER_COMPRESSION
+      uint32_t offset;  // ケージは4GBなので32ビットで足り、圧縮した参照と合わせて8バイトに収まる
+#else
       size_t offset;
+#endif
     } sliced_;
 
     // 連結文字列用の参照
     struct {
-      String* left;
-      String* right;
+      utils::CompressedPtr<String> left;
+      utils::CompressedPtr<String> right;
     } concatenated_;
   };
 
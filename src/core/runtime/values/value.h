@@ -395,6 +395,11 @@ class Value {
     return bits_;
   }
 
+  // 生のビット値から復元（JITコードとの受け渡し用。getRawBits() で得たビット値に限る）
+  static Value fromRawBits(uint64_t bits) {
+    return Value(bits);
+  }
+
   // 等価性比較
   bool equals(const Value& other) const;
   bool strictEquals(const Value& other) const;
@@ -130,8 +130,15 @@ void BytecodeGenerator::patchJump(uint32_t jump_index, uint32_t jump_to) {
     return;
   }
 
-  // ジャンプ命令のオペランドを更新
-  m_instructions[jump_index].operand1 = jump_to;
+  // ジャンプ命令のオペランドを更新（後方へのジャンプは負のオフセットを2の補数で持つ）
+  m_instructions[jump_index].operand1 =
+      static_cast<uint32_t>(static_cast<int32_t>(jump_to) - static_cast<int32_t>(jump_index));
+}
+
+uint32_t BytecodeGenerator::emitJumpTo(Opcode opcode, uint32_t jump_to, const SourceLocation& location) {
+  uint32_t index = emitJump(opcode, location);
+  patchJump(index, jump_to);
+  return index;
 }
 
 void BytecodeGenerator::beginLoop(uint32_t loop_start) {
@@ -366,7 +373,7 @@ std::shared_ptr<Node> BytecodeGenerator::visitForStatement(ast::ForStatementNode
   }
 
   // ループの先頭に戻る
-  emitInstruction(Opcode::JUMP, loopStart, 0, node->getLocation());
+  emitJumpTo(Opcode::JUMP, loopStart, node->getLocation());
 
   // ループの終了位置
   uint32_t endPos = static_cast<uint32_t>(m_instructions.size());
@@ -408,7 +415,7 @@ std::shared_ptr<Node> BytecodeGenerator::visitWhileStatement(ast::WhileStatement
   node->getBody()->accept(this);
 
   // ループの先頭に戻る
-  emitInstruction(Opcode::JUMP, loopStart, 0, node->getLocation());
+  emitJumpTo(Opcode::JUMP, loopStart, node->getLocation());
 
   // ループの終了位置
   uint32_t endPos = static_cast<uint32_t>(m_instructions.size());
@@ -442,7 +449,7 @@ std::shared_ptr<Node> BytecodeGenerator::visitDoWhileStatement(ast::DoWhileState
   node->getTest()->accept(this);
 
   // テスト結果が真の場合にループの先頭に戻る
-  emitInstruction(Opcode::JUMP_IF_TRUE, loopStart, 0, node->getLocation());
+  emitJumpTo(Opcode::JUMP_IF_TRUE, loopStart, node->getLocation());
 
   // ループの終了位置
   uint32_t endPos = static_cast<uint32_t>(m_instructions.size());
@@ -458,6 +465,95 @@ std::shared_ptr<Node> BytecodeGenerator::visitDoWhileStatement(ast::DoWhileState
   return nullptr;
 }
 
+// ForOfStatement
+std::shared_ptr<Node> BytecodeGenerator::visitForOfStatement(ast::ForOfStatementNode* node) {
+  if (node->isAwait()) {
+    // エラー: for await...of は非同期イテレータの待機が必要で未対応
+    // エラー処理…
+    return nullptr;
+  }
+
+  // 新しいブロックスコープを開始（let/const の束縛は反復ごとのスコープに置く）
+  beginScope(ScopeInfo::Type::Block, m_scopeStack.top().strict_mode);
+
+  // 反復対象を評価し、for-of 用のイテレータを初期化
+  // スタック: [iterator]
+  node->getRight()->accept(this);
+  emitInstruction(Opcode::ITERATOR_INIT, kIteratorForOfFlag, 0, node->getLocation());
+
+  // ループの開始位置（continue もここに戻る）
+  uint32_t loopStart = static_cast<uint32_t>(m_instructions.size());
+
+  // ループ情報をスタックに追加
+  beginLoop(loopStart);
+
+  // 次の値を取得。結果オブジェクトは作らず値と done を直接積む
+  // スタック: [iterator, value, done]
+  emitInstruction(Opcode::ITERATOR_NEXT, kIteratorForOfFlag, 0, node->getLocation());
+  uint32_t jumpToDone = emitJump(Opcode::JUMP_IF_TRUE, node->getLocation());
+
+  // 左辺に値を束縛（分割代入パターンは未対応）
+  std::string name;
+  bool isConst = false;
+  if (auto* declaration = dynamic_cast<ast::VariableDeclarationNode*>(node->getLeft().get())) {
+    if (!declaration->getDeclarations().empty()) {
+      if (auto* id = dynamic_cast<ast::IdentifierNode*>(
+              static_cast<ast::VariableDeclaratorNode*>(declaration->getDeclarations()[0].get())->getId().get())) {
+        name = id->getName();
+      }
+    }
+    isConst = declaration->getKind() == ast::VariableDeclarationKind::Const;
+    if (!name.empty()) {
+      declareVariable(name, isConst);
+    }
+  } else if (auto* id = dynamic_cast<ast::IdentifierNode*>(node->getLeft().get())) {
+    name = id->getName();
+  }
+
+  if (!name.empty()) {
+    auto [index, is_global] = resolveVariable(name);
+    // SET_GLOBAL / SET_LOCAL は値をスタックに残す
+    emitInstruction(is_global ? Opcode::SET_GLOBAL : Opcode::SET_LOCAL,
+                    static_cast<uint32_t>(index), 0, node->getLocation());
+  }
+  // スタック: [iterator]
+  emitInstruction(Opcode::POP, 0, 0, node->getLocation());
+
+  // ループ本体を実行
+  node->getBody()->accept(this);
+
+  // ループの先頭に戻る
+  emitJumpTo(Opcode::JUMP, loopStart, node->getLocation());
+
+  // break で抜けた場合はイテレータの return を呼ぶ
+  uint32_t breakPos = static_cast<uint32_t>(m_instructions.size());
+  emitInstruction(Opcode::ITERATOR_CLOSE, kIteratorForOfFlag, 0, node->getLocation());
+  uint32_t jumpToEnd = emitJump(Opcode::JUMP, node->getLocation());
+
+  // 完了した場合は undefined の値を捨て、イテレータを外す（完了済みなので return は呼ばれない）
+  uint32_t donePos = static_cast<uint32_t>(m_instructions.size());
+  patchJump(jumpToDone, donePos);
+  emitInstruction(Opcode::POP, 0, 0, node->getLocation());
+  emitInstruction(Opcode::ITERATOR_CLOSE, kIteratorForOfFlag, 0, node->getLocation());
+
+  // ループの終了位置
+  uint32_t endPos = static_cast<uint32_t>(m_instructions.size());
+  patchJump(jumpToEnd, endPos);
+
+  // ループ情報を取得
+  auto loop_info = endLoop();
+
+  // break命令のジャンプ先をパッチ
+  for (uint32_t break_jump : loop_info.second) {
+    patchJump(break_jump, breakPos);
+  }
+
+  // ブロックスコープを終了
+  endScope();
+
+  return nullptr;
+}
+
 // ReturnStatement
 std::shared_ptr<Node> BytecodeGenerator::visitReturnStatement(ast::ReturnStatementNode* node) {
   if (node->getArgument()) {
@@ -504,7 +600,7 @@ std::shared_ptr<Node> BytecodeGenerator::visitContinueStatement(ast::ContinueSta
   // 現在のループの先頭へジャンプ
   if (!m_loopStack.empty()) {
     uint32_t loopStart = m_loopStack.top().first;
-    emitInstruction(Opcode::JUMP, loopStart, 0, node->getLocation());
+    emitJumpTo(Opcode::JUMP, loopStart, node->getLocation());
   }
 
   return nullptr;
@@ -190,9 +190,21 @@ class BytecodeGenerator : public NodeVisitor {
    */
   uint32_t emitJump(Opcode opcode, const SourceLocation& location = SourceLocation());
 
+  /**
+   * @brief 既に位置が決まっている命令（ループの先頭など）へのジャンプ命令を追加
+   *
+   * @param opcode ジャンプ命令のオペコード
+   * @param jump_to ジャンプ先のインデックス
+   * @param location ソースコード内の位置
+   * @return ジャンプ命令のインデックス
+   */
+  uint32_t emitJumpTo(Opcode opcode, uint32_t jump_to, const SourceLocation& location = SourceLocation());
+
   /**
    * @brief ジャンプ命令のオペランドをパッチ
    *
+   * オペランドにはジャンプ命令自身の位置からの相対オフセットを書く（インタプリタの解釈に合わせる）。
+   *
    * @param jump_index ジャンプ命令のインデックス
    * @param jump_to ジャンプ先のインデックス
    */
@@ -41,6 +41,11 @@ uint32_t BytecodeModule::addInstruction(const BytecodeInstruction& instruction)
 
 void BytecodeModule::setInstructions(const std::vector<BytecodeInstruction>& instructions) {
   m_instructions = instructions;
+
+  // 命令列が差し替わったのでスロットの割り当てをやり直す
+  for (auto& function_info : m_functionInfos) {
+    function_info.allocateFeedbackVector(m_instructions);
+  }
 }
 
 void BytecodeModule::setConstantPool(std::shared_ptr<ConstantPool> constant_pool) {
@@ -50,6 +55,7 @@ void BytecodeModule::setConstantPool(std::shared_ptr<ConstantPool> constant_pool
 uint32_t BytecodeModule::addFunctionInfo(const FunctionInfo& function_info) {
   uint32_t index = static_cast<uint32_t>(m_functionInfos.size());
   m_functionInfos.push_back(function_info);
+  m_functionInfos.back().allocateFeedbackVector(m_instructions);
   return index;
 }
 
@@ -0,0 +1,273 @@
+/**
+ * @file feedback_vector.cpp
+ * @brief 関数ごとのフィードバックベクタの実装ファイル
+ */
+
+#include "feedback_vector.h"
+
+#include <algorithm>
+
+#include "../interpreter/bytecode_instruction.h"
+
+namespace aerojs {
+namespace core {
+
+std::shared_ptr<FeedbackVector> FeedbackVector::build(const std::vector<BytecodeInstruction>& instructions,
+                                                      uint32_t codeOffset,
+                                                      uint32_t codeLength) {
+  std::vector<uint32_t> siteOffsets;
+  std::vector<FeedbackSlotKind> kinds;
+
+  size_t end = std::min(instructions.size(), static_cast<size_t>(codeOffset) + codeLength);
+  for (size_t pc = codeOffset; pc < end; ++pc) {
+    FeedbackSlotKind kind = slotKindFor(instructions[pc].getOpcode());
+    if (kind != FeedbackSlotKind::kInvalid) {
+      siteOffsets.push_back(static_cast<uint32_t>(pc - codeOffset));
+      kinds.push_back(kind);
+    }
+  }
+
+  if (siteOffsets.empty()) {
+    return nullptr;
+  }
+  return std::make_shared<FeedbackVector>(std::move(siteOffsets), std::move(kinds));
+}
+
+FeedbackSlotKind FeedbackVector::slotKindFor(Opcode opcode) {
+  switch (opcode) {
+    case Opcode::kGetProperty:
+    case Opcode::kSetProperty:
+      return FeedbackSlotKind::kProperty;
+
+    case Opcode::kCall:
+      return FeedbackSlotKind::kCall;
+
+    case Opcode::kAdd:
+    case Opcode::kSub:
+    case Opcode::kMul:
+    case Opcode::kDiv:
+    case Opcode::kMod:
+    case Opcode::kPow:
+    case Opcode::kBitAnd:
+    case Opcode::kBitOr:
+    case Opcode::kBitXor:
+    case Opcode::kLeftShift:
+    case Opcode::kRightShift:
+    case Opcode::kUnsignedRightShift:
+      return FeedbackSlotKind::kBinaryOp;
+
+    case Opcode::kEqual:
+    case Opcode::kStrictEqual:
+    case Opcode::kNotEqual:
+    case Opcode::kStrictNotEqual:
+    case Opcode::kLessThan:
+    case Opcode::kLessThanOrEqual:
+    case Opcode::kGreaterThan:
+    case Opcode::kGreaterThanOrEqual:
+      return FeedbackSlotKind::kCompareOp;
+
+    default:
+      return FeedbackSlotKind::kInvalid;
+  }
+}
+
+FeedbackVector::FeedbackVector(std::vector<uint32_t> siteOffsets, std::vector<FeedbackSlotKind> kinds)
+    : m_slotCount(static_cast<uint32_t>(siteOffsets.size())),
+      m_slots(new FeedbackSlot[siteOffsets.size()]),
+      m_siteOffsets(std::move(siteOffsets)) {
+  for (uint32_t i = 0; i < m_slotCount; ++i) {
+    m_slots[i].kind = kinds[i];
+  }
+}
+
+int32_t FeedbackVector::slotForOffset(uint32_t bytecodeOffset) const {
+  auto it = std::lower_bound(m_siteOffsets.begin(), m_siteOffsets.end(), bytecodeOffset);
+  if (it == m_siteOffsets.end() || *it != bytecodeOffset) {
+    return -1;
+  }
+  return static_cast<int32_t>(it - m_siteOffsets.begin());
+}
+
+void FeedbackVector::bumpCount(FeedbackSlot& slot) {
+  // 書き手は1スレッドなので読み直して書くだけでよい
+  uint16_t count = slot.count.load(std::memory_order_relaxed);
+  if (count < kMaxCount) {
+    slot.count.store(count + 1, std::memory_order_relaxed);
+  }
+}
+
+FeedbackVector::PolymorphicFeedback* FeedbackVector::allocatePolymorphic() {
+  std::lock_guard<std::mutex> lock(m_polymorphicMutex);
+  m_polymorphic.push_back(std::make_unique<PolymorphicFeedback>());
+  return m_polymorphic.back().get();
+}
+
+void FeedbackVector::recordTarget(FeedbackSlot& slot, uint64_t target, uint32_t handler) {
+  auto state = static_cast<FeedbackState>(slot.state.load(std::memory_order_relaxed));
+
+  switch (state) {
+    case FeedbackState::kUninitialized:
+      slot.target.store(target, std::memory_order_relaxed);
+      slot.handler.store(handler, std::memory_order_relaxed);
+      slot.state.store(static_cast<uint8_t>(FeedbackState::kMonomorphic), std::memory_order_release);
+      break;
+
+    case FeedbackState::kMonomorphic: {
+      uint64_t current = slot.target.load(std::memory_order_relaxed);
+      if (current == target) {
+        slot.handler.store(handler, std::memory_order_release);
+        break;
+      }
+
+      // 2種類目で外部エントリに移す（エントリを書いてから公開する）
+      PolymorphicFeedback* poly = allocatePolymorphic();
+      poly->targets[0] = current;
+      poly->handlers[0] = slot.handler.load(std::memory_order_relaxed);
+      poly->targets[1] = target;
+      poly->handlers[1] = handler;
+      poly->count.store(2, std::memory_order_release);
+      slot.target.store(reinterpret_cast<uint64_t>(poly), std::memory_order_release);
+      slot.handler.store(0, std::memory_order_relaxed);
+      slot.state.store(static_cast<uint8_t>(FeedbackState::kPolymorphic), std::memory_order_release);
+      break;
+    }
+
+    case FeedbackState::kPolymorphic: {
+      auto* poly = reinterpret_cast<PolymorphicFeedback*>(slot.target.load(std::memory_order_relaxed));
+      uint32_t count = poly->count.load(std::memory_order_relaxed);
+      for (uint32_t i = 0; i < count; ++i) {
+        if (poly->targets[i] == target) {
+          poly->handlers[i] = handler;
+          bumpCount(slot);
+          return;
+        }
+      }
+      if (count < kMaxPolymorphic) {
+        poly->targets[count] = target;
+        poly->handlers[count] = handler;
+        poly->count.store(count + 1, std::memory_order_release);
+      } else {
+        markMegamorphic(static_cast<uint32_t>(&slot - m_slots.get()));
+      }
+      break;
+    }
+
+    case FeedbackState::kMegamorphic:
+      break;
+  }
+
+  bumpCount(slot);
+}
+
+void FeedbackVector::recordProperty(uint32_t slot, uint64_t shapeId, uint32_t handler) {
+  if (slot >= m_slotCount) {
+    return;
+  }
+  if (propertyHandlerKind(handler) == PropertyHandlerKind::kGeneric) {
+    markMegamorphic(slot);
+    return;
+  }
+  recordTarget(m_slots[slot], shapeId, handler);
+}
+
+void FeedbackVector::recordCall(uint32_t slot, uint64_t callee) {
+  if (slot >= m_slotCount) {
+    return;
+  }
+  recordTarget(m_slots[slot], callee, 0);
+}
+
+void FeedbackVector::recordBinaryOp(uint32_t slot, uint32_t hint) {
+  if (slot >= m_slotCount) {
+    return;
+  }
+  FeedbackSlot& entry = m_slots[slot];
+  uint32_t hints = entry.handler.load(std::memory_order_relaxed) | hint;
+  entry.handler.store(hints, std::memory_order_relaxed);
+
+  // 型の種類数を状態に反映（kAny を含めば汎用）
+  FeedbackState state = FeedbackState::kMonomorphic;
+  if (hints & BinaryOpHint::kAny) {
+    state = FeedbackState::kMegamorphic;
+  } else if (hints & (hints - 1)) {
+    state = FeedbackState::kPolymorphic;
+  }
+  auto current = static_cast<FeedbackState>(entry.state.load(std::memory_order_relaxed));
+  if (state > current) {
+    entry.state.store(static_cast<uint8_t>(state), std::memory_order_release);
+  }
+  bumpCount(entry);
+}
+
+void FeedbackVector::markMegamorphic(uint32_t slot) {
+  if (slot >= m_slotCount) {
+    return;
+  }
+  FeedbackSlot& entry = m_slots[slot];
+  // 多型エントリはベクタが所有し続けるので、target を読んだ直後の読み手も安全
+  entry.state.store(static_cast<uint8_t>(FeedbackState::kMegamorphic), std::memory_order_release);
+  if (entry.kind != FeedbackSlotKind::kBinaryOp && entry.kind != FeedbackSlotKind::kCompareOp) {
+    entry.target.store(0, std::memory_order_relaxed);
+    entry.handler.store(0, std::memory_order_relaxed);
+  }
+}
+
+FeedbackSnapshot FeedbackVector::snapshot(uint32_t slot) const {
+  FeedbackSnapshot snapshot;
+  if (slot >= m_slotCount) {
+    return snapshot;
+  }
+  const FeedbackSlot& entry = m_slots[slot];
+  snapshot.kind = entry.kind;
+
+  // 状態は前にしか進まないので、読む間に状態が変わったら読み直す
+  for (;;) {
+    auto state = static_cast<FeedbackState>(entry.state.load(std::memory_order_acquire));
+    uint64_t target = entry.target.load(std::memory_order_acquire);
+    uint32_t handler = entry.handler.load(std::memory_order_acquire);
+
+    snapshot.state = state;
+    snapshot.count = entry.count.load(std::memory_order_relaxed);
+    snapshot.entryCount = 0;
+
+    if (entry.kind == FeedbackSlotKind::kBinaryOp || entry.kind == FeedbackSlotKind::kCompareOp) {
+      snapshot.hint = handler;
+    } else if (state == FeedbackState::kMonomorphic) {
+      snapshot.targets[0] = target;
+      snapshot.handlers[0] = handler;
+      snapshot.entryCount = 1;
+    } else if (state == FeedbackState::kPolymorphic && target != 0) {
+      const auto* poly = reinterpret_cast<const PolymorphicFeedback*>(target);
+      uint32_t count = poly->count.load(std::memory_order_acquire);
+      for (uint32_t i = 0; i < count; ++i) {
+        snapshot.targets[i] = poly->targets[i];
+        snapshot.handlers[i] = poly->handlers[i];
+      }
+      snapshot.entryCount = count;
+    }
+
+    if (entry.state.load(std::memory_order_acquire) == static_cast<uint8_t>(state)) {
+      return snapshot;
+    }
+  }
+}
+
+void FeedbackVector::clear() {
+  for (uint32_t i = 0; i < m_slotCount; ++i) {
+    m_slots[i].target.store(0, std::memory_order_relaxed);
+    m_slots[i].handler.store(0, std::memory_order_relaxed);
+    m_slots[i].count.store(0, std::memory_order_relaxed);
+    m_slots[i].state.store(static_cast<uint8_t>(FeedbackState::kUninitialized), std::memory_order_release);
+  }
+  std::lock_guard<std::mutex> lock(m_polymorphicMutex);
+  m_polymorphic.clear();
+}
+
+size_t FeedbackVector::memoryUsage() const {
+  size_t bytes = m_slotCount * (sizeof(FeedbackSlot) + sizeof(uint32_t));
+  std::lock_guard<std::mutex> lock(m_polymorphicMutex);
+  return bytes + m_polymorphic.size() * sizeof(PolymorphicFeedback);
+}
+
+}  // namespace core
+}  // namespace aerojs
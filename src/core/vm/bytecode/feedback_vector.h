@@ -0,0 +1,218 @@
+/**
+ * @file feedback_vector.h
+ * @brief 関数ごとのフィードバックベクタのヘッダーファイル
+ *
+ * プロパティアクセス・呼び出し・算術／比較の各命令サイトに16バイトのスロットを
+ * 1つずつ割り当て、インタプリタ、ベースラインJIT、最適化JITが同じベクタを読み書きする。
+ * サイトごとにヒープ確保していたICオブジェクト（ICEntry と PropertyLocation）を置き換える。
+ */
+
+#ifndef AEROJS_CORE_VM_BYTECODE_FEEDBACK_VECTOR_H_
+#define AEROJS_CORE_VM_BYTECODE_FEEDBACK_VECTOR_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aerojs {
+namespace core {
+
+class BytecodeInstruction;
+enum class Opcode : uint8_t;
+
+/**
+ * @brief スロットの種類（命令のオペコードから決まる）
+ */
+enum class FeedbackSlotKind : uint8_t {
+  kInvalid,    ///< フィードバックを持たない命令
+  kProperty,   ///< プロパティの読み書き（レシーバのシェイプとハンドラ）
+  kCall,       ///< 関数呼び出し（呼び出し先）
+  kBinaryOp,   ///< 算術・ビット演算（オペランドの型ヒント）
+  kCompareOp   ///< 比較演算（オペランドの型ヒント）
+};
+
+/**
+ * @brief スロットの状態
+ *
+ * 状態は Uninitialized → Monomorphic → Polymorphic → Megamorphic の順にしか進まない
+ * （clear() を除く）。別スレッドの読み手はこの単調性を使って一貫した値を読む。
+ */
+enum class FeedbackState : uint8_t {
+  kUninitialized,  ///< まだ実行されていない
+  kMonomorphic,    ///< 1種類
+  kPolymorphic,    ///< 2〜kMaxPolymorphic 種類
+  kMegamorphic     ///< それ以上（最適化では汎用パスを使う）
+};
+
+/**
+ * @brief 算術・比較スロットの型ヒント（ビット和で蓄積する）
+ */
+struct BinaryOpHint {
+  static constexpr uint32_t kNone = 0;
+  static constexpr uint32_t kSignedSmall = 1u << 0;  ///< 32ビット整数
+  static constexpr uint32_t kNumber = 1u << 1;       ///< 整数以外の数値
+  static constexpr uint32_t kString = 1u << 2;
+  static constexpr uint32_t kBigInt = 1u << 3;
+  static constexpr uint32_t kAny = 1u << 4;          ///< 上記以外（オブジェクトなど）
+};
+
+/**
+ * @brief プロパティハンドラの種類
+ *
+ * ハンドラは種類（下位4ビット）とスロット番号（上位28ビット）を32ビットに詰める。
+ * アクセサは getter/setter を保持せず、ホルダー側のスロット番号だけを記録して
+ * ヒット時にそこから読む。
+ */
+enum class PropertyHandlerKind : uint8_t {
+  kInlineField,     ///< オブジェクト内のスロット
+  kOutOfLineField,  ///< 外部プロパティ配列のスロット
+  kPrototypeField,  ///< プロトタイプチェーン上のスロット（使う側がホルダーのシェイプを検査する）
+  kAccessor,        ///< アクセサプロパティ
+  kNonexistent,     ///< 存在しない（undefined を返す）
+  kGeneric          ///< 汎用パス
+};
+
+constexpr uint32_t encodePropertyHandler(PropertyHandlerKind kind, uint32_t index) {
+  return (index << 4) | static_cast<uint32_t>(kind);
+}
+
+constexpr PropertyHandlerKind propertyHandlerKind(uint32_t handler) {
+  return static_cast<PropertyHandlerKind>(handler & 0xF);
+}
+
+constexpr uint32_t propertyHandlerIndex(uint32_t handler) {
+  return handler >> 4;
+}
+
+/**
+ * @brief フィードバックスロット（16バイト）
+ *
+ * target は単型ならシェイプID（プロパティ）または呼び出し先（呼び出し）、
+ * 多型なら PolymorphicFeedback へのポインタ。handler は単型のプロパティハンドラ、
+ * 算術・比較では型ヒントのビット和。
+ */
+struct FeedbackSlot {
+  std::atomic<uint64_t> target{0};
+  std::atomic<uint32_t> handler{0};
+  std::atomic<uint8_t> state{static_cast<uint8_t>(FeedbackState::kUninitialized)};
+  FeedbackSlotKind kind = FeedbackSlotKind::kInvalid;
+  std::atomic<uint16_t> count{0};  ///< 記録回数（飽和）
+};
+
+static_assert(sizeof(FeedbackSlot) == 16, "FeedbackSlot must stay 16 bytes");
+
+/**
+ * @brief 読み手が取り出すスロットの内容
+ */
+struct FeedbackSnapshot {
+  static constexpr size_t kMaxPolymorphic = 4;
+
+  FeedbackSlotKind kind = FeedbackSlotKind::kInvalid;
+  FeedbackState state = FeedbackState::kUninitialized;
+  uint32_t entryCount = 0;                       ///< targets/handlers の有効数
+  std::array<uint64_t, kMaxPolymorphic> targets{};
+  std::array<uint32_t, kMaxPolymorphic> handlers{};
+  uint32_t hint = BinaryOpHint::kNone;           ///< 算術・比較スロットの型ヒント
+  uint16_t count = 0;
+
+  bool isMonomorphic() const { return state == FeedbackState::kMonomorphic; }
+  bool isMegamorphic() const { return state == FeedbackState::kMegamorphic; }
+};
+
+/**
+ * @brief 関数ごとのフィードバックベクタ
+ *
+ * FunctionInfo と同時に作られ、命令列中のフィードバックを持つ命令に
+ * 出現順でスロットを割り当てる。スロットの書き込みは関数を実行するスレッド
+ * （インタプリタとベースラインJITのコード）が行い、最適化JITは別スレッドから
+ * snapshot() で読む。多型の外部エントリはベクタが破棄されるまで解放しない。
+ */
+class FeedbackVector {
+ public:
+  static constexpr size_t kMaxPolymorphic = FeedbackSnapshot::kMaxPolymorphic;
+  static constexpr uint16_t kMaxCount = 0xFFFF;
+
+  /**
+   * @brief 命令列の [codeOffset, codeOffset + codeLength) からベクタを作成
+   * @return フィードバックを持つ命令がなければ nullptr
+   */
+  static std::shared_ptr<FeedbackVector> build(const std::vector<BytecodeInstruction>& instructions,
+                                               uint32_t codeOffset,
+                                               uint32_t codeLength);
+
+  /**
+   * @brief オペコードに対応するスロットの種類
+   */
+  static FeedbackSlotKind slotKindFor(Opcode opcode);
+
+  explicit FeedbackVector(std::vector<uint32_t> siteOffsets, std::vector<FeedbackSlotKind> kinds);
+
+  FeedbackVector(const FeedbackVector&) = delete;
+  FeedbackVector& operator=(const FeedbackVector&) = delete;
+
+  uint32_t slotCount() const { return m_slotCount; }
+
+  /**
+   * @brief 関数先頭からの命令オフセットに対応するスロット番号（なければ -1）
+   */
+  int32_t slotForOffset(uint32_t bytecodeOffset) const;
+
+  /**
+   * @brief スロットの命令オフセット
+   */
+  uint32_t siteOffset(uint32_t slot) const { return m_siteOffsets[slot]; }
+
+  FeedbackSlotKind kind(uint32_t slot) const { return m_slots[slot].kind; }
+
+  FeedbackState state(uint32_t slot) const {
+    return static_cast<FeedbackState>(m_slots[slot].state.load(std::memory_order_acquire));
+  }
+
+  // 記録（関数を実行するスレッドから呼ぶ）
+  void recordProperty(uint32_t slot, uint64_t shapeId, uint32_t handler);
+  void recordCall(uint32_t slot, uint64_t callee);
+  void recordBinaryOp(uint32_t slot, uint32_t hint);
+  void markMegamorphic(uint32_t slot);
+
+  /**
+   * @brief スロットの内容を一貫した形で読む（任意のスレッドから呼べる）
+   */
+  FeedbackSnapshot snapshot(uint32_t slot) const;
+
+  /**
+   * @brief 全スロットを未初期化に戻す（脱最適化後の再収集用。GC停止中など書き手のいない時に呼ぶ）
+   */
+  void clear();
+
+  /**
+   * @brief スロットと多型エントリが使っているバイト数
+   */
+  size_t memoryUsage() const;
+
+ private:
+  struct PolymorphicFeedback {
+    std::atomic<uint32_t> count{0};
+    std::array<uint64_t, kMaxPolymorphic> targets{};
+    std::array<uint32_t, kMaxPolymorphic> handlers{};
+  };
+
+  void recordTarget(FeedbackSlot& slot, uint64_t target, uint32_t handler);
+  PolymorphicFeedback* allocatePolymorphic();
+  static void bumpCount(FeedbackSlot& slot);
+
+  uint32_t m_slotCount;
+  std::unique_ptr<FeedbackSlot[]> m_slots;
+  std::vector<uint32_t> m_siteOffsets;  // スロット順（昇順）の命令オフセット
+
+  mutable std::mutex m_polymorphicMutex;
+  std::vector<std::unique_ptr<PolymorphicFeedback>> m_polymorphic;
+};
+
+}  // namespace core
+}  // namespace aerojs
+
+#endif  // AEROJS_CORE_VM_BYTECODE_FEEDBACK_VECTOR_H_
@@ -8,6 +8,8 @@
 
 #include "function_info.h"
 
+#include "../interpreter/bytecode_instruction.h"
+
 #include <algorithm>
 #include <cassert>
 #include <sstream>
@@ -35,6 +37,19 @@ std::string FunctionInfo::getFullName() const {
   return result;
 }
 
+/**
+ * @brief 関数本体の命令列からフィードバックベクタを割り当て
+ *
+ * @param instructions モジュール全体の命令列
+ */
+void FunctionInfo::allocateFeedbackVector(const std::vector<BytecodeInstruction>& instructions) {
+  if (code_length == 0 || code_offset >= instructions.size()) {
+    feedback_vector.reset();
+    return;
+  }
+  feedback_vector = FeedbackVector::build(instructions, code_offset, code_length);
+}
+
 /**
  * @brief 関数のデバッグ情報を文字列形式で取得
  *
@@ -10,13 +10,18 @@
 #define AEROJS_CORE_VM_BYTECODE_FUNCTION_INFO_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "feedback_vector.h"
+
 namespace aerojs {
 namespace core {
 
+class BytecodeInstruction;
+
 /**
  * @brief 関数情報クラス
  *
@@ -40,6 +45,7 @@ struct FunctionInfo {
   uint32_t parent_function_index;                                ///< 親関数のインデックス（トップレベルの場合は-1）
   uint32_t scope_index;                                          ///< この関数が定義されたスコープのインデックス
   std::unordered_map<std::string, uint32_t> captured_variables;  ///< キャプチャされた変数とそのインデックス
+  std::shared_ptr<FeedbackVector> feedback_vector;               ///< 命令サイトごとのフィードバック（各層で共有）
 
   /**
    * @brief コンストラクタ
@@ -129,6 +135,15 @@ struct FunctionInfo {
   void addLocalName(const std::string& name) {
     local_names.push_back(name);
   }
+
+  /**
+   * @brief 関数本体の命令列からフィードバックベクタを割り当て
+   *
+   * フィードバックを持つ命令がない関数では nullptr のままにする。
+   *
+   * @param instructions モジュール全体の命令列
+   */
+  void allocateFeedbackVector(const std::vector<BytecodeInstruction>& instructions);
 };
 
 }  // namespace core
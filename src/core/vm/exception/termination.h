@@ -0,0 +1,114 @@
+/**
+ * @file termination.h
+ * @brief 実行の打ち切り要求と打ち切り例外
+ *
+ * エンジンは TerminationState を1つ持ち、他スレッドからの打ち切り要求や
+ * ヒープ上限到達を記録する。インタプリタは命令ループと関数呼び出しで、
+ * JITコードはプロローグとループの後方分岐でフラグを確認し、立っていれば
+ * ExecutionTerminated でスタックを巻き戻してエンジンの評価入口まで戻る。
+ */
+
+#ifndef AEROJS_CORE_VM_EXCEPTION_TERMINATION_H_
+#define AEROJS_CORE_VM_EXCEPTION_TERMINATION_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace aerojs {
+namespace core {
+
+/**
+ * @brief 打ち切りの理由
+ */
+enum class TerminationReason : uint8_t {
+  None = 0,
+  Requested,  ///< 埋め込み側からの terminateExecution()
+  HeapLimit   ///< ヒープ上限到達（上限接近コールバックの判断を含む）
+};
+
+/**
+ * @brief 実行打ち切りフラグ
+ *
+ * フラグは1バイトで、JITコードは flagAddress() を即値として埋め込み
+ * cmp byte [addr], 0 の1命令で確認する。どのスレッドからも要求できる。
+ */
+class TerminationState {
+ public:
+  TerminationState() : m_reason(static_cast<uint8_t>(TerminationReason::None)) {}
+
+  TerminationState(const TerminationState&) = delete;
+  TerminationState& operator=(const TerminationState&) = delete;
+
+  void request(TerminationReason reason) {
+    m_reason.store(static_cast<uint8_t>(reason), std::memory_order_release);
+  }
+
+  void cancel() {
+    m_reason.store(static_cast<uint8_t>(TerminationReason::None), std::memory_order_release);
+  }
+
+  bool isRequested() const {
+    return m_reason.load(std::memory_order_relaxed) != static_cast<uint8_t>(TerminationReason::None);
+  }
+
+  TerminationReason reason() const {
+    return static_cast<TerminationReason>(m_reason.load(std::memory_order_acquire));
+  }
+
+  /**
+   * @brief JITコードが確認するフラグのアドレス（0以外なら打ち切り）
+   */
+  const std::atomic<uint8_t>* flagAddress() const { return &m_reason; }
+
+ private:
+  std::atomic<uint8_t> m_reason;
+};
+
+/**
+ * @brief 実行打ち切りによるスタック巻き戻し
+ *
+ * JSの try/catch や、インタプリタ・組み込み関数の catch (const std::exception&) で
+ * 捕捉されないよう std::exception を継承しない。エンジンの評価入口でのみ捕捉する。
+ */
+class ExecutionTerminated {
+ public:
+  explicit ExecutionTerminated(TerminationReason reason) : m_reason(reason) {}
+
+  TerminationReason reason() const { return m_reason; }
+
+ private:
+  TerminationReason m_reason;
+};
+
+/**
+ * @brief 打ち切りで抜けたJITコードが返す値
+ *
+ * JITコードはフラグを見つけると自身のフレームを畳んでこの値を返す。
+ * 呼び出し側は checkJITResult() で例外に変換し、インタプリタのフレームを巻き戻す。
+ * 通常の戻り値（NaNボックス化された値）と区別するため、使われないシグナリングNaNを使う。
+ */
+constexpr uint64_t kJITTerminationSentinel = 0x7FF4DEADDEAD0001ULL;
+
+/**
+ * @brief 打ち切りの確認（インタプリタのポーリング用）
+ */
+inline void throwIfTerminationRequested(const TerminationState* state) {
+  if (state && state->isRequested()) {
+    throw ExecutionTerminated(state->reason());
+  }
+}
+
+/**
+ * @brief JITコードの戻り値を確認し、打ち切りで抜けた場合は例外に変換する
+ */
+inline uint64_t checkJITResult(uint64_t result, const TerminationState* state) {
+  if (result == kJITTerminationSentinel && state && state->isRequested()) {
+    throw ExecutionTerminated(state->reason());
+  }
+  return result;
+}
+
+}  // namespace core
+}  // namespace aerojs
+
+#endif  // AEROJS_CORE_VM_EXCEPTION_TERMINATION_H_
@@ -125,6 +125,18 @@ enum class Opcode : uint8_t {
   kExport = 0xF6,    // モジュールエクスポート
 };
 
+/**
+ * @brief for-of 用のイテレータ命令であることを示すオペランド
+ *
+ * kIteratorInit / kIteratorNext / kIteratorClose の第1オペランドに指定すると、
+ * インタプリタは反復を aero::ForOfIterator で行う。kIteratorNext はイテレータを
+ * スタックに残したまま値と done を積み、結果オブジェクトを積まない。
+ * 結果オブジェクトはループ内で分解されるだけで外に漏れないため、スカラーに置き換える。
+ * 組み込み配列はイテレータを作らずに添字で読む。kIteratorClose は完了・break の
+ * どちらでも反復を外し、途中で抜けた場合だけイテレータの return を呼ぶ。
+ */
+constexpr int32_t kIteratorForOfFlag = 1;
+
 /**
  * @brief バイトコード命令クラス
  *
@@ -8,12 +8,16 @@
 
 #include "interpreter.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 
+#include "../../jit/optimizing/compilation_dependencies.h"
 #include "../../runtime/context/context.h"
 #include "../../runtime/environment/environment.h"
+#include "../../runtime/iteration/iteration.h"
 #include "../../runtime/values/function.h"
 #include "../../runtime/values/object.h"
 #include "../../runtime/values/value.h"
@@ -24,13 +28,33 @@
 namespace aerojs {
 namespace core {
 
+namespace {
+
+// 命令列が参照するローカル変数の数（OSR で写す範囲）
+uint32_t localCountOf(const std::vector<BytecodeInstruction>& instructions) {
+  int maxIndex = -1;
+  for (const BytecodeInstruction& instruction : instructions) {
+    Opcode opcode = instruction.getOpcode();
+    if (opcode == Opcode::GET_LOCAL || opcode == Opcode::SET_LOCAL) {
+      maxIndex = std::max(maxIndex, instruction.getOperandAsInt(0));
+    }
+  }
+  return static_cast<uint32_t>(maxIndex + 1);
+}
+
+}  // namespace
+
 //-----------------------------------------------------------------------------
 // Interpreter クラスの実装
 //-----------------------------------------------------------------------------
 
 Interpreter::Interpreter()
     : m_stack(std::make_shared<Stack>()),
-      m_debugMode(false) {
+      m_debugMode(false),
+      m_termination(nullptr),
+      m_currentPc(0),
+      m_jumpTarget(kNoJump),
+      m_osrThreshold(0) {
   initializeInstructionHandlers();
 }
 
@@ -235,10 +259,46 @@ ValuePtr Interpreter::execute(
   m_currentContext = context;
   m_stack->clear();
 
+  return run(instructions, 0);
+}
+
+ValuePtr Interpreter::resume(
+    const std::vector<BytecodeInstruction>& instructions,
+    ContextPtr context,
+    std::shared_ptr<Environment> environment,
+    const DeoptimizedFrame& frame) {
+  if (frame.bytecodeOffset > instructions.size()) {
+    throwException(Value::createError("Deoptimization target out of range"));
+  }
+
+  m_currentContext = context;
+  m_stack->clear();
+
+  // tryOnStackReplacement で写すのと逆向きに、ローカル変数とオペランドスタックを戻す
+  if (environment) {
+    for (size_t i = 0; i < frame.locals.size(); i++) {
+      environment->setLocalVariable(i, std::make_shared<Value>(Value::fromRawBits(frame.locals[i])));
+    }
+  }
+  for (uint64_t bits : frame.stack) {
+    m_stack->push(std::make_shared<Value>(Value::fromRawBits(bits)));
+  }
+
+  return run(instructions, frame.bytecodeOffset);
+}
+
+ValuePtr Interpreter::run(const std::vector<BytecodeInstruction>& instructions, size_t startPc) {
   try {
+    // ループヘッダごとのバックエッジ回数（OSR が有効なときだけ数える）
+    std::unordered_map<size_t, uint32_t> backEdgeCounts;
+
     // 命令を順次実行
-    for (size_t pc = 0; pc < instructions.size(); pc++) {
+    for (size_t pc = startPc; pc < instructions.size();) {
       const BytecodeInstruction& instruction = instructions[pc];
+      m_currentPc = pc;
+
+      // 打ち切り要求の確認（ExecutionTerminated は下の catch を素通りする）
+      throwIfTerminationRequested(m_termination);
 
       // 命令ハンドラを取得して実行
       auto handlerIt = m_instructionHandlers.find(instruction.getOpcode());
@@ -249,6 +309,26 @@ ValuePtr Interpreter::execute(
         std::string errorMsg = "Unknown opcode: " + std::to_string(static_cast<int>(instruction.getOpcode()));
         throwException(Value::createError(errorMsg));
       }
+
+      // 分岐した場合は飛び先から続ける（呼び出し先の実行が残した値を拾わないよう、命令ごとに消費する）
+      size_t target = std::exchange(m_jumpTarget, kNoJump);
+      if (target == kNoJump) {
+        pc++;
+        continue;
+      }
+      if (target > instructions.size()) {
+        throwException(Value::createError("Jump target out of range"));
+      }
+
+      // 後方への分岐はループのバックエッジ。しきい値ごとにJITコードへの乗り換えを試す
+      if (target <= pc && m_osrHandler && ++backEdgeCounts[target] >= m_osrThreshold) {
+        backEdgeCounts[target] = 0;
+        ValuePtr result;
+        if (tryOnStackReplacement(instructions, target, result)) {
+          return result;
+        }
+      }
+      pc = target;
     }
 
     // スタックが空でない場合は最後の値を返す
@@ -279,6 +359,12 @@ ValuePtr Interpreter::callFunction(
     throwException(Value::createTypeError("Cannot call null or undefined"));
   }
 
+  throwIfTerminationRequested(m_termination);
+
+  if (m_functionEntryHook) {
+    m_functionEntryHook(func);
+  }
+
   // 関数の環境を取得
   auto environment = func->getEnvironment();
 
@@ -325,6 +411,24 @@ void Interpreter::reset() {
   m_currentContext = nullptr;
 }
 
+void Interpreter::captureAllocationStack(std::vector<utils::memory::AllocationFrame>& frames,
+                                         size_t maxFrames) const {
+  // 外側のフレームのプログラムカウンタは呼び出し命令を指したままなので、呼び出し箇所になる
+  for (auto it = m_callStack.rbegin(); it != m_callStack.rend() && frames.size() < maxFrames; ++it) {
+    const auto& callFrame = *it;
+    if (!callFrame) {
+      continue;
+    }
+
+    utils::memory::AllocationFrame frame;
+    auto function = callFrame->getFunction();
+    frame.function = function.get();
+    frame.bytecodeOffset = static_cast<uint32_t>(callFrame->getProgramCounter());
+    frame.functionName = function ? function->getName() : "(global)";
+    frames.push_back(std::move(frame));
+  }
+}
+
 std::shared_ptr<CallFrame> Interpreter::getCurrentCallFrame() const {
   if (m_callStack.empty()) {
     return nullptr;
@@ -388,6 +492,7 @@ void Interpreter::handleAdd(const BytecodeInstruction& instruction) {
   if (m_stack->size() >= 2) {
     auto right = m_stack->pop();
     auto left = m_stack->pop();
+    recordBinaryOpFeedback(left, right);
     m_stack->push(Value::add(left, right));
   }
 }
@@ -396,6 +501,7 @@ void Interpreter::handleSub(const BytecodeInstruction& instruction) {
   if (m_stack->size() >= 2) {
     auto right = m_stack->pop();
     auto left = m_stack->pop();
+    recordBinaryOpFeedback(left, right);
     m_stack->push(Value::subtract(left, right));
   }
 }
@@ -404,6 +510,7 @@ void Interpreter::handleMul(const BytecodeInstruction& instruction) {
   if (m_stack->size() >= 2) {
     auto right = m_stack->pop();
     auto left = m_stack->pop();
+    recordBinaryOpFeedback(left, right);
     m_stack->push(Value::multiply(left, right));
   }
 }
@@ -412,6 +519,7 @@ void Interpreter::handleDiv(const BytecodeInstruction& instruction) {
   if (m_stack->size() >= 2) {
     auto right = m_stack->pop();
     auto left = m_stack->pop();
+    recordBinaryOpFeedback(left, right);
     m_stack->push(Value::divide(left, right));
   }
 }
@@ -420,6 +528,7 @@ void Interpreter::handleMod(const BytecodeInstruction& instruction) {
   if (m_stack->size() >= 2) {
     auto right = m_stack->pop();
     auto left = m_stack->pop();
+    recordBinaryOpFeedback(left, right);
     m_stack->push(Value::modulo(left, right));
   }
 }
@@ -556,6 +665,13 @@ void Interpreter::handleJump(const BytecodeInstruction& instruction) {
     // プログラムカウンタを更新
     currentFrame->setProgramCounter(currentFrame->getProgramCounter() + jumpOffset);
   }
+
+  // 実行ループの次の命令位置（分岐命令の位置からの相対）
+  int64_t target = static_cast<int64_t>(m_currentPc) + jumpOffset;
+  if (target < 0) {
+    throwException(Value::createError("Jump target out of range"));
+  }
+  m_jumpTarget = static_cast<size_t>(target);
 }
 
 void Interpreter::handleJumpIfTrue(const BytecodeInstruction& instruction) {
@@ -596,7 +712,8 @@ void Interpreter::handleCall(const BytecodeInstruction& instruction) {
   auto thisValue = m_stack->pop();
   auto funcValue = m_stack->pop();
 
-  // 関数呼び出しを実行
+  // 関数呼び出しを実行（フィードバックは呼び出し先の実行で m_currentPc が変わる前に記録する）
+  recordCallFeedback(funcValue);
   auto func = std::dynamic_pointer_cast<FunctionObject>(funcValue);
   if (func) {
     auto result = callFunction(func, args, thisValue, m_currentContext);
@@ -683,6 +800,7 @@ void Interpreter::handleGetProperty(const BytecodeInstruction& instruction) {
   if (m_stack->size() >= 2) {
     auto propName = m_stack->pop();
     auto obj = m_stack->pop();
+    recordPropertyFeedback(obj, propName);
 
     // プロパティ値を取得
     auto result = Object::getProperty(obj, propName);
@@ -696,6 +814,7 @@ void Interpreter::handleSetProperty(const BytecodeInstruction& instruction) {
     auto value = m_stack->pop();
     auto propName = m_stack->pop();
     auto obj = m_stack->pop();
+    recordPropertyFeedback(obj, propName);
 
     // プロパティ値を設定
     Object::setProperty(obj, propName, value);
@@ -775,6 +894,8 @@ void Interpreter::handleNewFunction(const BytecodeInstruction& instruction) {
     if (codeBlock) {
       // 新しい関数オブジェクトを作成
       auto functionObj = FunctionObject::create(functionName, codeBlock, env);
+      // 同じコードブロックから作る関数（クロージャ）は FunctionInfo のベクタを共有する
+      functionObj->setFeedbackVector(codeBlock->getFunctionInfo().feedback_vector);
       m_stack->push(functionObj);
       return;
     }
@@ -892,32 +1013,89 @@ void Interpreter::handleSetSuperProperty(const BytecodeInstruction& instruction)
 }
 
 // イテレータ操作
+aero::ForOfIterator* Interpreter::currentForOfIterator() {
+  size_t depth = m_stack->size();
+  while (!m_forOfIterators.empty() && m_forOfIterators.back().stackDepth > depth) {
+    m_forOfIterators.pop_back();
+  }
+  if (m_forOfIterators.empty() || m_forOfIterators.back().stackDepth != depth) {
+    return nullptr;
+  }
+  return m_forOfIterators.back().iterator.get();
+}
+
 void Interpreter::handleIteratorInit(const BytecodeInstruction& instruction) {
-  if (!m_stack->isEmpty()) {
-    auto obj = m_stack->pop();
+  if (m_stack->isEmpty()) {
+    return;
+  }
+  auto iterable = m_stack->pop();
 
-    // イテレータを取得
-    auto iterator = Object::getIterator(obj);
-    m_stack->push(iterator);
+  if (instruction.getOperandCount() > 0 && instruction.getOperand(0) == kIteratorForOfFlag) {
+    // 例外で抜けたループの状態が残っていれば、同じ深さに積む前に外す
+    while (!m_forOfIterators.empty() && m_forOfIterators.back().stackDepth > m_stack->size()) {
+      m_forOfIterators.pop_back();
+    }
+
+    // 組み込み配列ならイテレータを作らず添字で読む
+    auto iterator = std::make_unique<aero::ForOfIterator>(m_currentContext.get(), *iterable);
+    Object* target = iterator->target();
+    // 反復中に回収されないよう、配列かイテレータをスタックに置いておく
+    m_stack->push(target ? Value::createObject(target) : Value::createUndefined());
+    m_forOfIterators.push_back({m_stack->size(), std::move(iterator)});
+    return;
   }
+
+  // イテレータを取得
+  Object* iterator = aero::Iterable::getIterator(m_currentContext.get(), *iterable);
+  m_stack->push(iterator ? Value::createObject(iterator) : Value::createUndefined());
 }
 
 void Interpreter::handleIteratorNext(const BytecodeInstruction& instruction) {
-  if (!m_stack->isEmpty()) {
-    auto iterator = m_stack->pop();
+  if (m_stack->isEmpty()) {
+    return;
+  }
 
-    // イテレータの次の値を取得
-    auto result = Object::iteratorNext(iterator);
-    m_stack->push(result);
+  // for-of: 結果オブジェクトを積まずに値と done を積み、イテレータは残す
+  if (instruction.getOperandCount() > 0 && instruction.getOperand(0) == kIteratorForOfFlag) {
+    aero::ForOfIterator* iterator = currentForOfIterator();
+    Value value = Value::createUndefined();
+    bool hasValue = iterator && iterator->step(value);
+    m_stack->push(value);
+    m_stack->push(Value::createBoolean(!hasValue));
+    return;
+  }
+
+  auto iterator = m_stack->pop();
+  if (!iterator->isObject()) {
+    throwException(Value::createError("Iterator is not an object"));
+    return;
   }
+
+  // イテレータの次の値を取得（結果オブジェクトをそのまま積む）
+  Object* result = aero::Iterator::next(m_currentContext.get(), iterator->asObject());
+  m_stack->push(result ? Value::createObject(result) : Value::createUndefined());
 }
 
 void Interpreter::handleIteratorClose(const BytecodeInstruction& instruction) {
-  if (!m_stack->isEmpty()) {
-    auto iterator = m_stack->pop();
+  if (m_stack->isEmpty()) {
+    return;
+  }
 
-    // イテレータをクローズ
-    Object::iteratorClose(iterator);
+  if (instruction.getOperandCount() > 0 && instruction.getOperand(0) == kIteratorForOfFlag) {
+    // 完了していれば何もしない。break で抜けた場合は return を呼ぶ
+    if (aero::ForOfIterator* iterator = currentForOfIterator()) {
+      iterator->close();
+      m_forOfIterators.pop_back();
+    }
+    m_stack->pop();
+    return;
+  }
+
+  auto iterator = m_stack->pop();
+
+  // イテレータをクローズ
+  if (iterator->isObject()) {
+    aero::completeIterator(m_currentContext.get(), iterator->asObject(), Value::createUndefined());
   }
 }
 
@@ -1378,6 +1556,9 @@ void Interpreter::handleSetGlobal(const BytecodeInstruction& instruction) {
     // グローバルオブジェクトに変数を設定
     auto globalObj = m_currentContext->getGlobalObject();
     Object::setProperty(globalObj, varName, value);
+
+    // この変数の値を前提にコンパイル中の最適化コードを導入させない
+    CompilationDependencies::instance().invalidateGlobal(varName);
   }
 }
 
@@ -1486,6 +1667,135 @@ void Interpreter::handleDeclareLet(const BytecodeInstruction& instruction) {
   }
 }
 
+//-----------------------------------------------------------------------------
+// オンスタックリプレイスメント
+//-----------------------------------------------------------------------------
+
+void Interpreter::setOSRHandler(OSRHandler handler, uint32_t threshold) {
+  m_osrHandler = std::move(handler);
+  m_osrThreshold = std::max<uint32_t>(threshold, 1);
+}
+
+bool Interpreter::tryOnStackReplacement(const std::vector<BytecodeInstruction>& instructions,
+                                        size_t loopHeader, ValuePtr& result) {
+  auto currentFrame = getCurrentCallFrame();
+
+  OSRFrameState state;
+  state.loopHeaderOffset = static_cast<uint32_t>(loopHeader);
+  state.context = m_currentContext.get();
+
+  // ローカル変数は関数の環境にある（トップレベルの変数はグローバルなので写さない）
+  if (currentFrame) {
+    auto environment = currentFrame->getEnvironment();
+    uint32_t localCount = localCountOf(instructions);
+    state.locals.reserve(localCount);
+    for (uint32_t i = 0; i < localCount; i++) {
+      ValuePtr value = environment->getLocalVariable(i);
+      state.locals.push_back(value ? value->getRawBits() : Value::createUndefined().getRawBits());
+    }
+  }
+
+  // オペランドスタックは底から順に写す（peekAt は最上位が0）
+  size_t depth = m_stack->size();
+  state.stack.reserve(depth);
+  for (size_t i = depth; i-- > 0;) {
+    state.stack.push_back(m_stack->peekAt(i)->getRawBits());
+  }
+
+  std::shared_ptr<FunctionObject> function = currentFrame ? currentFrame->getFunction() : nullptr;
+  if (!m_osrHandler(function, state)) {
+    return false;
+  }
+
+  // フレームの残りは OSR コードが実行した
+  m_stack->popMultiple(depth);
+  result = std::make_shared<Value>(Value::fromRawBits(state.result));
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// 型フィードバックの記録
+//-----------------------------------------------------------------------------
+
+FeedbackVector* Interpreter::currentFeedbackSlot(uint32_t& slot) const {
+  if (m_callStack.empty()) {
+    return nullptr;
+  }
+  FeedbackVector* vector = m_callStack.back()->getFeedbackVector();
+  if (!vector) {
+    return nullptr;
+  }
+  int32_t index = vector->slotForOffset(static_cast<uint32_t>(m_currentPc));
+  if (index < 0) {
+    return nullptr;
+  }
+  slot = static_cast<uint32_t>(index);
+  return vector;
+}
+
+void Interpreter::recordPropertyFeedback(const ValuePtr& obj, const ValuePtr& propName) {
+  uint32_t slot = 0;
+  FeedbackVector* vector = currentFeedbackSlot(slot);
+  if (!vector) {
+    return;
+  }
+
+  // プリミティブへのアクセスはラッパー経由になるので汎用パスに回す
+  if (!obj || !obj->isObject() || !propName || !propName->isString()) {
+    vector->markMegamorphic(slot);
+    return;
+  }
+
+  Object* object = obj->asObject();
+  uint32_t index = 0;
+  bool isInlineProperty = false;
+  uint32_t handler = encodePropertyHandler(PropertyHandlerKind::kNonexistent, 0);
+  if (object->findProperty(propName->toString(), index, isInlineProperty)) {
+    handler = encodePropertyHandler(
+        isInlineProperty ? PropertyHandlerKind::kInlineField : PropertyHandlerKind::kOutOfLineField, index);
+  }
+  vector->recordProperty(slot, object->getShapeId(), handler);
+}
+
+void Interpreter::recordCallFeedback(const ValuePtr& callee) {
+  uint32_t slot = 0;
+  FeedbackVector* vector = currentFeedbackSlot(slot);
+  if (vector) {
+    vector->recordCall(slot, reinterpret_cast<uint64_t>(callee.get()));
+  }
+}
+
+namespace {
+
+uint32_t binaryOpHintOf(const ValuePtr& value) {
+  if (!value) {
+    return BinaryOpHint::kAny;
+  }
+  if (value->isInt32()) {
+    return BinaryOpHint::kSignedSmall;
+  }
+  if (value->isNumber()) {
+    return BinaryOpHint::kNumber;
+  }
+  if (value->isString()) {
+    return BinaryOpHint::kString;
+  }
+  if (value->isBigInt()) {
+    return BinaryOpHint::kBigInt;
+  }
+  return BinaryOpHint::kAny;
+}
+
+}  // namespace
+
+void Interpreter::recordBinaryOpFeedback(const ValuePtr& left, const ValuePtr& right) {
+  uint32_t slot = 0;
+  FeedbackVector* vector = currentFeedbackSlot(slot);
+  if (vector) {
+    vector->recordBinaryOp(slot, binaryOpHintOf(left) | binaryOpHintOf(right));
+  }
+}
+
 //-----------------------------------------------------------------------------
 // CallFrame クラスの実装
 //-----------------------------------------------------------------------------
@@ -1499,7 +1809,8 @@ CallFrame::CallFrame(
       m_environment(environment),
       m_thisValue(thisValue),
       m_returnAddress(returnAddress),
-      m_programCounter(0) {
+      m_programCounter(0),
+      m_feedbackVector(function ? function->feedbackVector() : nullptr) {
 }
 
 CallFrame::~CallFrame() {
@@ -1534,5 +1845,9 @@ size_t CallFrame::incrementProgramCounter() {
   return ++m_programCounter;
 }
 
+FeedbackVector* CallFrame::getFeedbackVector() const {
+  return m_feedbackVector;
+}
+
 }  // namespace core
 }  // namespace aerojs
\ No newline at end of file
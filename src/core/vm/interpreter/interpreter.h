@@ -14,12 +14,21 @@
 #include <unordered_map>
 #include <vector>
 
+#include "../../jit/deoptimizer/deoptimizer.h"
+#include "../../jit/osr/osr_entry.h"
 #include "../../runtime/context/context.h"
 #include "../../runtime/values/value.h"
+#include "../../../utils/memory/gc/sampling_heap_profiler.h"
 #include "../exception/exception.h"
+#include "../exception/termination.h"
+#include "../bytecode/feedback_vector.h"
 #include "../stack/stack.h"
 #include "bytecode_instruction.h"
 
+namespace aero {
+class ForOfIterator;
+}  // namespace aero
+
 namespace aerojs {
 namespace core {
 
@@ -59,6 +68,24 @@ class Interpreter {
       ContextPtr context,
       std::shared_ptr<Environment> environment);
 
+  /**
+   * @brief 脱最適化したフレームの続きを実行する
+   *
+   * frame のローカル変数を環境へ、オペランドスタックを底から積み直してから、
+   * frame.bytecodeOffset の命令から実行する。
+   *
+   * @param instructions frame の関数の命令列
+   * @param context 実行コンテキスト
+   * @param environment frame の関数の実行環境
+   * @param frame Deoptimizer が復元したフレーム
+   * @return ValuePtr 実行結果
+   */
+  ValuePtr resume(
+      const std::vector<BytecodeInstruction>& instructions,
+      ContextPtr context,
+      std::shared_ptr<Environment> environment,
+      const DeoptimizedFrame& frame);
+
   /**
    * @brief 関数を呼び出す
    *
@@ -87,6 +114,58 @@ class Interpreter {
    */
   void reset();
 
+  /**
+   * @brief 割り当てサンプリング用に現在のJSスタックを取得する
+   *
+   * サンプルに当たった割り当てでのみ呼ばれる（SamplingHeapProfiler のスタック取得コールバック）。
+   *
+   * @param frames 取得したフレーム（割り当て箇所のフレームから外側へ）
+   * @param maxFrames 取得する最大フレーム数
+   */
+  void captureAllocationStack(std::vector<utils::memory::AllocationFrame>& frames, size_t maxFrames) const;
+
+  /**
+   * @brief 実行打ち切りフラグを設定する
+   *
+   * 設定すると命令ごとと関数呼び出し時にフラグを確認し、立っていれば
+   * ExecutionTerminated を投げる（JSの例外ハンドラでは捕捉されない）。
+   *
+   * @param state エンジンの打ち切り状態（nullptrで確認しない）
+   */
+  void setTerminationState(const TerminationState* state) { m_termination = state; }
+
+  /**
+   * @brief OSR（実行中のループからJITコードへの乗り換え）の呼び出し先
+   *
+   * function は実行中の関数（トップレベルのスクリプトでは nullptr）。コンパイル済みコードで
+   * 残りを実行したら state.result に完了値を入れて true を返す。
+   */
+  using OSRHandler = std::function<bool(const std::shared_ptr<FunctionObject>& function, OSRFrameState& state)>;
+
+  /**
+   * @brief OSR を有効にする
+   *
+   * 後方への分岐（ループのバックエッジ）をループヘッダごとに数え、threshold 回ごとに
+   * 生きている状態（ローカル変数とオペランドスタック）を写して handler を呼ぶ。
+   * handler が true を返したら、その命令列の実行を state.result で終える。
+   *
+   * @param handler 呼び出し先（空なら数えない）
+   * @param threshold JITOptimizerPolicy::osrThreshold
+   */
+  void setOSRHandler(OSRHandler handler, uint32_t threshold);
+
+  /**
+   * @brief 関数の入口で呼ばれる通知先
+   */
+  using FunctionEntryHook = std::function<void(const std::shared_ptr<FunctionObject>& function)>;
+
+  /**
+   * @brief callFunction のたびに、本体を実行する前に hook を呼ぶ
+   *
+   * @param hook 通知先（空なら呼ばない）
+   */
+  void setFunctionEntryHook(FunctionEntryHook hook) { m_functionEntryHook = std::move(hook); }
+
  private:
   /** @brief 命令実行関数の型定義 */
   using InstructionHandler = std::function<void(Interpreter*, const BytecodeInstruction&)>;
@@ -109,6 +188,54 @@ class Interpreter {
   /** @brief デバッグモードフラグ */
   bool m_debugMode;
 
+  /** @brief 実行打ち切りフラグ（エンジンが所有） */
+  const TerminationState* m_termination;
+
+  /** @brief 実行中の命令の位置（フィードバックスロットの検索用） */
+  size_t m_currentPc;
+
+  /** @brief 分岐命令が設定する次の命令の位置（kNoJump なら次の命令へ進む） */
+  static constexpr size_t kNoJump = static_cast<size_t>(-1);
+  size_t m_jumpTarget;
+
+  /** @brief OSR の呼び出し先としきい値 */
+  OSRHandler m_osrHandler;
+  uint32_t m_osrThreshold;
+
+  /** @brief 関数の入口の通知先 */
+  FunctionEntryHook m_functionEntryHook;
+
+  /** @brief for-of の反復状態（入れ子のループの順。値スタック上のイテレータの位置と対応する） */
+  struct ForOfState {
+    size_t stackDepth;  ///< イテレータを積んだ後の値スタックの深さ
+    std::unique_ptr<aero::ForOfIterator> iterator;
+  };
+  std::vector<ForOfState> m_forOfIterators;
+
+  /**
+   * @brief 値スタックの先頭にあるイテレータの反復状態を返す
+   *
+   * 例外で値スタックごと捨てられたループの状態は、ここで外す。
+   * @return 反復状態（スタックの先頭が for-of のイテレータでなければ nullptr）
+   */
+  aero::ForOfIterator* currentForOfIterator();
+
+  /**
+   * @brief startPc の命令から命令列の終わりまで実行する（execute と resume の本体）
+   */
+  ValuePtr run(const std::vector<BytecodeInstruction>& instructions, size_t startPc);
+
+  /**
+   * @brief ループヘッダで生きている状態を写して OSR を試みる
+   *
+   * @param instructions 実行中の命令列
+   * @param loopHeader バックエッジの飛び先
+   * @param result OSR コードが返した完了値
+   * @return OSR コードで残りを実行したら true
+   */
+  bool tryOnStackReplacement(const std::vector<BytecodeInstruction>& instructions,
+                             size_t loopHeader, ValuePtr& result);
+
   /**
    * @brief 命令ハンドラを初期化する
    */
@@ -135,6 +262,19 @@ class Interpreter {
    */
   std::shared_ptr<CallFrame> popCallFrame();
 
+  /**
+   * @brief 実行中の命令に対応するフィードバックスロットを取得する
+   *
+   * @param slot スロット番号の格納先
+   * @return FeedbackVector* 実行中の関数のベクタ（スロットがなければ nullptr）
+   */
+  FeedbackVector* currentFeedbackSlot(uint32_t& slot) const;
+
+  /** @brief フィードバックの記録（各ハンドラの先頭、入れ子の呼び出しより前に行う） */
+  void recordPropertyFeedback(const ValuePtr& obj, const ValuePtr& propName);
+  void recordCallFeedback(const ValuePtr& callee);
+  void recordBinaryOpFeedback(const ValuePtr& left, const ValuePtr& right);
+
   /** @brief バイトコード命令ハンドラメソッド群 */
   // スタック操作
   void handlePush(const BytecodeInstruction& instruction);
@@ -314,6 +454,13 @@ class CallFrame {
    */
   size_t incrementProgramCounter();
 
+  /**
+   * @brief 関数のフィードバックベクタを取得する
+   *
+   * @return FeedbackVector* フィードバックベクタ（ない場合は nullptr）
+   */
+  FeedbackVector* getFeedbackVector() const;
+
  private:
   /** @brief 関数オブジェクト */
   std::shared_ptr<FunctionObject> m_function;
@@ -329,6 +476,9 @@ class CallFrame {
 
   /** @brief プログラムカウンタ */
   size_t m_programCounter;
+
+  /** @brief 関数のフィードバックベクタ（関数オブジェクトが所有） */
+  FeedbackVector* m_feedbackVector;
 };
 
 }  // namespace core
@@ -0,0 +1,136 @@
+/**
+ * @file jit_bridge.cpp
+ * @brief インタプリタとJITの間の乗り換えの接続の実装
+ */
+
+#include "jit_bridge.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#include "../../jit/deoptimizer/deoptimizer.h"
+#include "../../jit/jit_manager.h"
+#include "../../jit/tiered_jit_manager.h"
+#include "../../runtime/values/function.h"
+#include "../../runtime/values/value.h"
+
+namespace aerojs {
+namespace core {
+
+InterpreterJITBridge::InterpreterJITBridge(Interpreter& interpreter, ContextPtr context, TieredJITManager& jit,
+                                           JITManager* optimizer)
+    : m_interpreter(interpreter),
+      m_context(std::move(context)),
+      m_jit(jit),
+      m_optimizer(optimizer),
+      m_installed(false) {
+}
+
+InterpreterJITBridge::~InterpreterJITBridge() {
+  uninstall();
+}
+
+void InterpreterJITBridge::install(uint32_t osrThreshold) {
+  if (m_installed) {
+    return;
+  }
+  if (m_optimizer) {
+    // 最適化コンパイルの入力は、インタプリタが呼び出した関数から作る
+    m_optimizer->setFunctionResolver([this](uint64_t functionId) -> Function* {
+      return static_cast<Function*>(findFunction(functionId).get());
+    });
+  }
+  m_interpreter.setFunctionEntryHook([this](const std::shared_ptr<FunctionObject>& function) {
+    noteFunction(function);
+    if (m_optimizer && function) {
+      // 関数の入口はメインスレッドのセーフポイントなので、完了したコンパイルをここで導入する
+      m_optimizer->installFinishedCompilations();
+      m_optimizer->incrementExecutionCount(static_cast<uint32_t>(function->getId()));
+    }
+  });
+  m_interpreter.setOSRHandler([this](const std::shared_ptr<FunctionObject>& function, OSRFrameState& state) {
+    return enterOSR(function, state);
+  }, osrThreshold);
+  Deoptimizer::Instance().SetResumeHandler([this](std::vector<DeoptimizedFrame>& frames) {
+    return resumeFrames(frames);
+  });
+  m_installed = true;
+}
+
+void InterpreterJITBridge::uninstall() {
+  if (!m_installed) {
+    return;
+  }
+  Deoptimizer::Instance().SetResumeHandler(nullptr);
+  m_interpreter.setOSRHandler(nullptr, 1);
+  m_interpreter.setFunctionEntryHook(nullptr);
+  if (m_optimizer) {
+    m_optimizer->setFunctionResolver(nullptr);
+  }
+  m_installed = false;
+}
+
+void InterpreterJITBridge::noteFunction(const std::shared_ptr<FunctionObject>& function) {
+  if (!function) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::weak_ptr<FunctionObject>& entry = m_functions[function->getId()];
+  if (entry.expired()) {
+    entry = function;
+  }
+}
+
+std::shared_ptr<FunctionObject> InterpreterJITBridge::findFunction(uint64_t functionId) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_functions.find(functionId);
+  if (it == m_functions.end()) {
+    return nullptr;
+  }
+  std::shared_ptr<FunctionObject> function = it->second.lock();
+  if (!function) {
+    m_functions.erase(it);
+  }
+  return function;
+}
+
+bool InterpreterJITBridge::enterOSR(const std::shared_ptr<FunctionObject>& function, OSRFrameState& state) {
+  // トップレベルのスクリプトは関数としてコンパイルされないので、そのままインタプリタで続ける
+  if (!function) {
+    return false;
+  }
+  // OSRコードが脱最適化したとき、再開するフレームの関数を引けるようにしておく
+  noteFunction(function);
+  // インタプリタの関数オブジェクトはJITが扱う実行時の Function の派生で、関数IDも共有している
+  return m_jit.enterOSR(static_cast<Function*>(function.get()), state.loopHeaderOffset, &state);
+}
+
+uint64_t InterpreterJITBridge::resumeFrames(std::vector<DeoptimizedFrame>& frames) {
+  // 最適化コードを呼んだインタプリタの途中の状態を壊さないよう、別のインタプリタで実行する
+  Interpreter interpreter;
+
+  uint64_t completion = Value::createUndefined().getRawBits();
+  for (size_t i = frames.size(); i-- > 0;) {
+    DeoptimizedFrame& frame = frames[i];
+    // 内側のフレームの完了値は、外側のフレームでは呼び出しの戻り値としてスタックに積まれている
+    if (i + 1 < frames.size()) {
+      frame.stack.push_back(completion);
+    }
+
+    std::shared_ptr<FunctionObject> function = findFunction(frame.functionId);
+    if (!function) {
+      // 最適化フレームはもう無いので、実行できなければ続けられない
+      std::fprintf(stderr, "aerojs: deoptimized function %llu is not known to the interpreter\n",
+                   static_cast<unsigned long long>(frame.functionId));
+      std::abort();
+    }
+
+    ValuePtr result = interpreter.resume(function->getInstructions(), m_context, function->getEnvironment(), frame);
+    completion = result ? result->getRawBits() : Value::createUndefined().getRawBits();
+  }
+  return completion;
+}
+
+}  // namespace core
+}  // namespace aerojs
@@ -0,0 +1,102 @@
+/**
+ * @file jit_bridge.h
+ * @brief インタプリタとJITの間の乗り換えの接続
+ *
+ * インタプリタからJITコードへ入る経路（ループでのOSR）をインタプリタに、
+ * JITコードからインタプリタへ戻る経路（脱最適化したフレームの再開）を
+ * Deoptimizer に登録する。最適化コンパイラには関数の入口で実行回数を伝え、
+ * 完了したコンパイルを導入する。エンジンが初期化時に作り、終了時に外す。
+ */
+
+#ifndef AEROJS_CORE_VM_INTERPRETER_JIT_BRIDGE_H_
+#define AEROJS_CORE_VM_INTERPRETER_JIT_BRIDGE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "interpreter.h"
+
+namespace aerojs {
+namespace core {
+
+class TieredJITManager;
+class JITManager;
+
+/**
+ * @brief インタプリタとJITの乗り換えを仲介する
+ *
+ * 脱最適化したフレームは関数IDでしか分からないため、インタプリタが呼び出した関数を
+ * IDごとに（弱参照で）覚えておき、再開時に命令列と環境を引く。
+ */
+class InterpreterJITBridge {
+ public:
+  /**
+   * @param interpreter 関数の入口とOSRを通知するインタプリタ
+   * @param context 再開したフレームを実行するコンテキスト
+   * @param jit OSRで入る先の階層JIT
+   * @param optimizer 関数単位の最適化コンパイルを管理する JITManager（なければ nullptr）
+   */
+  InterpreterJITBridge(Interpreter& interpreter, ContextPtr context, TieredJITManager& jit,
+                       JITManager* optimizer = nullptr);
+
+  /**
+   * @brief 外していなければ外す
+   */
+  ~InterpreterJITBridge();
+
+  InterpreterJITBridge(const InterpreterJITBridge&) = delete;
+  InterpreterJITBridge& operator=(const InterpreterJITBridge&) = delete;
+
+  /**
+   * @brief インタプリタの関数の入口・OSRと Deoptimizer の再開先に登録する
+   *
+   * @param osrThreshold OSRを試みるループのバックエッジ回数
+   */
+  void install(uint32_t osrThreshold);
+
+  /**
+   * @brief 登録を外す（JITとインタプリタを破棄する前に呼ぶ）
+   */
+  void uninstall();
+
+  /**
+   * @brief 脱最適化したフレームを最内から実行する（Deoptimizer::ResumeHandler）
+   *
+   * @param frames 外側から順のフレーム
+   * @return 最外のフレームの完了値のビット列
+   */
+  uint64_t resumeFrames(std::vector<DeoptimizedFrame>& frames);
+
+  /**
+   * @brief ループのフレームを TieredJITManager::enterOSR へ渡す（Interpreter::OSRHandler）
+   *
+   * @return OSRコードが完了し、state.result に完了値が入ったら true
+   */
+  bool enterOSR(const std::shared_ptr<FunctionObject>& function, OSRFrameState& state);
+
+ private:
+  /**
+   * @brief 関数をIDで引けるように覚える
+   */
+  void noteFunction(const std::shared_ptr<FunctionObject>& function);
+
+  std::shared_ptr<FunctionObject> findFunction(uint64_t functionId);
+
+  Interpreter& m_interpreter;
+  ContextPtr m_context;
+  TieredJITManager& m_jit;
+  JITManager* m_optimizer;
+  bool m_installed;
+
+  /** @brief 呼び出された関数（IDごと。関数の寿命は延ばさない） */
+  std::mutex m_mutex;
+  std::unordered_map<uint64_t, std::weak_ptr<FunctionObject>> m_functions;
+};
+
+}  // namespace core
+}  // namespace aerojs
+
+#endif  // AEROJS_CORE_VM_INTERPRETER_JIT_BRIDGE_H_
@@ -0,0 +1,244 @@
+/**
+ * @file heap_cage.cpp
+ * @brief ポインタ圧縮用の4GBヒープケージの実装
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include "heap_cage.h"
+#include "large_pages.h"
+#include "size_class_allocator.h"
+
+#include <iterator>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+namespace {
+
+void* cageMap(size_t size, size_t alignment, void* context) {
+  return static_cast<HeapCage*>(context)->allocateRegion(size, alignment);
+}
+
+void cageUnmap(void* memory, size_t size, void* context) {
+  static_cast<HeapCage*>(context)->releaseRegion(memory, size);
+}
+
+}  // namespace
+
+HeapCage& HeapCage::instance() {
+  static HeapCage cage;
+  return cage;
+}
+
+HeapCage::HeapCage()
+    : base_(0),
+      top_(0),
+      committedBytes_(0) {
+  if (reserve()) {
+    s_base = base_;
+    top_ = base_ + kGranularity;  // オフセット0（nullptr）を含む先頭単位は使わない
+  }
+}
+
+HeapCage::~HeapCage() {
+  allocator_.reset();
+  if (base_) {
+#ifdef _WIN32
+    VirtualFree(reinterpret_cast<void*>(base_), 0, MEM_RELEASE);
+#else
+    munmap(reinterpret_cast<void*>(base_), kCageSize);
+#endif
+  }
+}
+
+// 4GB境界に揃った4GBをアクセス不可で予約
+bool HeapCage::reserve() {
+#ifdef _WIN32
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    void* probe = VirtualAlloc(nullptr, kCageSize + kCageAlignment, MEM_RESERVE, PAGE_NOACCESS);
+    if (!probe) {
+      return false;
+    }
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(probe) + kCageAlignment - 1) & ~(kCageAlignment - 1);
+    VirtualFree(probe, 0, MEM_RELEASE);
+    if (VirtualAlloc(reinterpret_cast<void*>(aligned), kCageSize, MEM_RESERVE, PAGE_NOACCESS)) {
+      base_ = aligned;
+      return true;
+    }
+  }
+  return false;
+#else
+  size_t total = kCageSize + kCageAlignment;
+  void* raw = mmap(nullptr, total, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (raw == MAP_FAILED) {
+    return false;
+  }
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (start + kCageAlignment - 1) & ~(kCageAlignment - 1);
+  if (aligned > start) {
+    munmap(raw, aligned - start);
+  }
+  uintptr_t end = aligned + kCageSize;
+  if (start + total > end) {
+    munmap(reinterpret_cast<void*>(end), start + total - end);
+  }
+  base_ = aligned;
+  return true;
+#endif
+}
+
+void* HeapCage::allocateRegion(size_t size, size_t alignment) {
+  if (!base_ || size == 0) {
+    return nullptr;
+  }
+
+  size = (size + kGranularity - 1) & ~(kGranularity - 1);
+  alignment = alignment < kGranularity ? kGranularity : alignment;
+
+  // ラージページの対象になるよう、2MB以上の領域は2MB境界に置く
+  bool useLargePages = largePageMode() != LargePageMode::Disabled && size >= kLargePageSize;
+  if (useLargePages && alignment < kLargePageSize) {
+    alignment = kLargePageSize;
+  }
+
+  uintptr_t result = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 返却済み範囲から先に探す（ファーストフィット）
+    for (auto it = freeRanges_.begin(); it != freeRanges_.end(); ++it) {
+      uintptr_t start = (it->first + alignment - 1) & ~(alignment - 1);
+      uintptr_t rangeEnd = it->first + it->second;
+      if (start + size > rangeEnd) {
+        continue;
+      }
+
+      uintptr_t rangeStart = it->first;
+      freeRanges_.erase(it);
+      if (start > rangeStart) {
+        freeRanges_.emplace(rangeStart, start - rangeStart);
+      }
+      if (start + size < rangeEnd) {
+        freeRanges_.emplace(start + size, rangeEnd - (start + size));
+      }
+      result = start;
+      break;
+    }
+
+    if (!result) {
+      uintptr_t start = (top_ + alignment - 1) & ~(alignment - 1);
+      if (start + size > base_ + kCageSize) {
+        return nullptr;
+      }
+      if (start > top_) {
+        freeRanges_.emplace(top_, start - top_);
+      }
+      top_ = start + size;
+      result = start;
+    }
+  }
+
+#ifdef _WIN32
+  if (!VirtualAlloc(reinterpret_cast<void*>(result), size, MEM_COMMIT, PAGE_READWRITE)) {
+    releaseRegion(reinterpret_cast<void*>(result), size);
+    return nullptr;
+  }
+#else
+  if (mprotect(reinterpret_cast<void*>(result), size, PROT_READ | PROT_WRITE) != 0) {
+    releaseRegion(reinterpret_cast<void*>(result), size);
+    return nullptr;
+  }
+#endif
+
+  if (useLargePages) {
+    LargePageBacking backing = adviseLargePages(reinterpret_cast<void*>(result), size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    largePageRegions_[result] = backing;
+  }
+
+  committedBytes_.fetch_add(size, std::memory_order_relaxed);
+  return reinterpret_cast<void*>(result);
+}
+
+void HeapCage::releaseRegion(void* memory, size_t size) {
+  if (!memory || !contains(memory)) {
+    return;
+  }
+
+  size = (size + kGranularity - 1) & ~(kGranularity - 1);
+
+#ifdef _WIN32
+  VirtualFree(memory, size, MEM_DECOMMIT);
+#else
+  madvise(memory, size, MADV_DONTNEED);
+  mprotect(memory, size, PROT_NONE);
+#endif
+  committedBytes_.fetch_sub(size, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  uintptr_t start = reinterpret_cast<uintptr_t>(memory);
+  uintptr_t end = start + size;
+
+  auto advised = largePageRegions_.find(start);
+  if (advised != largePageRegions_.end()) {
+    releaseAdvisedLargePages(memory, size, advised->second);
+    largePageRegions_.erase(advised);
+  }
+
+  // 隣接する空き範囲と結合
+  auto next = freeRanges_.lower_bound(start);
+  if (next != freeRanges_.end() && next->first == end) {
+    end += next->second;
+    next = freeRanges_.erase(next);
+  }
+  if (next != freeRanges_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == start) {
+      start = prev->first;
+      freeRanges_.erase(prev);
+    }
+  }
+
+  // 末尾に接していれば未使用領域へ戻す
+  if (end == top_) {
+    top_ = start;
+  } else {
+    freeRanges_.emplace(start, end - start);
+  }
+}
+
+SizeClassAllocator& HeapCage::allocator() {
+  std::call_once(allocatorOnce_, [this]() {
+    allocator_ = std::make_unique<SizeClassAllocator>(sizeclass::RegionSource{cageMap, cageUnmap, this});
+    allocator_->setMemoryLimit(kCageSize);
+  });
+  return *allocator_;
+}
+
+void* HeapCage::allocateObject(size_t size) {
+  void* memory = instance().allocator().allocate(size, alignof(std::max_align_t));
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void HeapCage::freeObject(void* ptr) {
+  if (ptr) {
+    instance().allocator().deallocate(ptr);
+  }
+}
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
@@ -0,0 +1,120 @@
+/**
+ * @file heap_cage.h
+ * @brief ポインタ圧縮用の4GBヒープケージ
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_UTILS_MEMORY_ALLOCATORS_HEAP_CAGE_H
+#define AEROJS_UTILS_MEMORY_ALLOCATORS_HEAP_CAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "large_pages.h"
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+class SizeClassAllocator;
+
+/**
+ * @brief ヒープケージ
+ *
+ * 4GB境界に揃えた4GBの仮想アドレス領域を予約し、ヒープオブジェクトを
+ * すべてこの中に配置する。ケージ内のアドレスは (ベース + 32ビットオフセット) で
+ * 表せるため、ヒープ内参照を32ビットで保持できる（ポインタ圧縮）。
+ * オフセット0はnullptrを表すため、先頭のスパンは使用しない。
+ *
+ * 予約はアクセス不可で行い、スパン単位で読み書き可能にしてから払い出す。
+ * 返却された領域は物理メモリをOSへ戻したうえで空き範囲として再利用する。
+ * 小さいオブジェクトは allocator() が返すケージ内専用の
+ * SizeClassAllocator から割り当てる。
+ * ラージページが有効な場合、2MB以上の領域は2MB境界に置いて THP を要求する。
+ */
+class HeapCage {
+ public:
+  static constexpr size_t kCageSize = size_t(1) << 32;        // 4GB
+  static constexpr size_t kCageAlignment = size_t(1) << 32;   // 4GB境界
+  static constexpr size_t kGranularity = size_t(1) << 16;     // 払い出し単位（64KB）
+
+  /**
+   * @brief プロセス共通のケージ（初回呼び出し時に予約）
+   */
+  static HeapCage& instance();
+
+  ~HeapCage();
+
+  HeapCage(const HeapCage&) = delete;
+  HeapCage& operator=(const HeapCage&) = delete;
+
+  /**
+   * @brief ケージ内の領域を確保して読み書き可能にする
+   * @param size バイト数（kGranularity単位に切り上げ）
+   * @param alignment アライメント（kGranularity以下の2の冪は kGranularity として扱う）
+   * @return 先頭アドレス（ケージが満杯ならnullptr）
+   */
+  void* allocateRegion(size_t size, size_t alignment = kGranularity);
+
+  /**
+   * @brief 領域を返却（物理メモリを解放し、以後アクセス不可にする）
+   */
+  void releaseRegion(void* memory, size_t size);
+
+  /**
+   * @brief ケージ内に割り当てる小オブジェクト用アロケータ
+   */
+  SizeClassAllocator& allocator();
+
+  /**
+   * @brief ケージ内へのオブジェクト割り当て（圧縮参照の参照先となるクラスの operator new 用）
+   * @throw std::bad_alloc ケージが満杯の場合
+   */
+  static void* allocateObject(size_t size);
+  static void freeObject(void* ptr);
+
+  bool isReserved() const { return base_ != 0; }
+  bool contains(const void* ptr) const {
+    return reinterpret_cast<uintptr_t>(ptr) - base_ < kCageSize;
+  }
+  size_t committedBytes() const { return committedBytes_.load(std::memory_order_relaxed); }
+
+  // 展開時のロードパスは1回の加算のみ（ベースはグローバルに置いてJITからも参照する）
+  static uintptr_t base() { return s_base; }
+
+  static uint32_t compress(const void* ptr) {
+    return ptr ? static_cast<uint32_t>(reinterpret_cast<uintptr_t>(ptr) - s_base) : 0;
+  }
+
+  static void* decompress(uint32_t offset) {
+    return offset ? reinterpret_cast<void*>(s_base + offset) : nullptr;
+  }
+
+ private:
+  HeapCage();
+
+  bool reserve();
+
+  static inline uintptr_t s_base = 0;
+
+  uintptr_t base_;
+  uintptr_t top_;                              // 未使用領域の先頭
+  std::map<uintptr_t, size_t> freeRanges_;     // 返却された範囲（先頭→長さ、隣接は結合）
+  std::unordered_map<uintptr_t, LargePageBacking> largePageRegions_;  // THP を要求した領域
+  std::mutex mutex_;
+  std::atomic<size_t> committedBytes_;
+  std::unique_ptr<SizeClassAllocator> allocator_;
+  std::once_flag allocatorOnce_;
+};
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
+
+#endif  // AEROJS_UTILS_MEMORY_ALLOCATORS_HEAP_CAGE_H
@@ -0,0 +1,253 @@
+/**
+ * @file large_pages.cpp
+ * @brief ヒープ・コード領域のラージページ（2MB）対応の実装
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include "large_pages.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+namespace {
+
+std::atomic<uint8_t> g_mode{static_cast<uint8_t>(LargePageMode::Disabled)};
+
+std::atomic<size_t> g_requestedBytes{0};
+std::atomic<size_t> g_transparentBytes{0};
+std::atomic<size_t> g_hugeTlbBytes{0};
+std::atomic<size_t> g_fallbackBytes{0};
+std::atomic<uint64_t> g_hugeTlbFailures{0};
+
+// mapLargePageRegion で確保した領域の確保方法（領域の確保・解放はチャンク単位でまれ）
+std::mutex g_regionsMutex;
+std::unordered_map<uintptr_t, LargePageBacking> g_regions;
+
+size_t roundUpLarge(size_t size) {
+  return (size + kLargePageSize - 1) & ~(kLargePageSize - 1);
+}
+
+// 範囲内で2MB境界に揃った部分
+bool alignedInterior(void* memory, size_t size, uintptr_t* start, uintptr_t* end) {
+  uintptr_t begin = reinterpret_cast<uintptr_t>(memory);
+  *start = (begin + kLargePageSize - 1) & ~(kLargePageSize - 1);
+  *end = (begin + size) & ~(kLargePageSize - 1);
+  return *end > *start;
+}
+
+void account(LargePageBacking backing, size_t requested, size_t covered, bool add) {
+  auto apply = [add](std::atomic<size_t>& counter, size_t bytes) {
+    if (add) {
+      counter.fetch_add(bytes, std::memory_order_relaxed);
+    } else {
+      counter.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+  };
+
+  apply(g_requestedBytes, requested);
+  switch (backing) {
+    case LargePageBacking::HugeTLB:
+      apply(g_hugeTlbBytes, covered);
+      break;
+    case LargePageBacking::Transparent:
+      apply(g_transparentBytes, covered);
+      if (requested > covered) {
+        apply(g_fallbackBytes, requested - covered);
+      }
+      break;
+    case LargePageBacking::SmallPages:
+      apply(g_fallbackBytes, requested);
+      break;
+  }
+}
+
+#ifndef _WIN32
+// 2MB境界に揃えて予約（前後の余りは返す）
+void* mapAligned2M(size_t size) {
+  size_t total = size + kLargePageSize;
+  void* raw = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (start + kLargePageSize - 1) & ~(kLargePageSize - 1);
+  uintptr_t end = aligned + size;
+  if (aligned > start) {
+    munmap(raw, aligned - start);
+  }
+  if (start + total > end) {
+    munmap(reinterpret_cast<void*>(end), start + total - end);
+  }
+  return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+}  // namespace
+
+void setLargePageMode(LargePageMode mode) {
+  g_mode.store(static_cast<uint8_t>(mode), std::memory_order_relaxed);
+}
+
+LargePageMode largePageMode() {
+  return static_cast<LargePageMode>(g_mode.load(std::memory_order_relaxed));
+}
+
+void* mapLargePageRegion(size_t size, LargePageBacking* backing) {
+  size = roundUpLarge(size);
+  LargePageMode mode = largePageMode();
+  LargePageBacking result = LargePageBacking::SmallPages;
+  void* memory = nullptr;
+
+#ifdef _WIN32
+  // Windows のラージページは SeLockMemoryPrivilege が必要で、既定では通常ページで確保する
+  (void)mode;
+  memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#ifdef MAP_HUGETLB
+  if (mode == LargePageMode::Explicit) {
+    void* huge = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (huge != MAP_FAILED) {
+      memory = huge;
+      result = LargePageBacking::HugeTLB;
+    } else {
+      // hugetlbfs のプールが空・未設定なら THP に切り替える
+      g_hugeTlbFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+#endif
+  if (!memory) {
+    memory = mapAligned2M(size);
+#ifdef MADV_HUGEPAGE
+    if (memory && mode != LargePageMode::Disabled &&
+        madvise(memory, size, MADV_HUGEPAGE) == 0) {
+      result = LargePageBacking::Transparent;
+    }
+#endif
+  }
+#endif
+
+  if (!memory) {
+    return nullptr;
+  }
+  account(result, size, result == LargePageBacking::SmallPages ? 0 : size, true);
+  {
+    std::lock_guard<std::mutex> lock(g_regionsMutex);
+    g_regions[reinterpret_cast<uintptr_t>(memory)] = result;
+  }
+  if (backing) {
+    *backing = result;
+  }
+  return memory;
+}
+
+bool unmapLargePageRegion(void* memory, size_t size) {
+  if (!memory) {
+    return false;
+  }
+
+  LargePageBacking backing;
+  {
+    std::lock_guard<std::mutex> lock(g_regionsMutex);
+    auto it = g_regions.find(reinterpret_cast<uintptr_t>(memory));
+    if (it == g_regions.end()) {
+      return false;
+    }
+    backing = it->second;
+    g_regions.erase(it);
+  }
+
+  size = roundUpLarge(size);
+  account(backing, size, backing == LargePageBacking::SmallPages ? 0 : size, false);
+#ifdef _WIN32
+  VirtualFree(memory, 0, MEM_RELEASE);
+#else
+  munmap(memory, size);
+#endif
+  return true;
+}
+
+LargePageBacking adviseLargePages(void* memory, size_t size) {
+  LargePageBacking result = LargePageBacking::SmallPages;
+  uintptr_t start = 0;
+  uintptr_t end = 0;
+  size_t covered = 0;
+
+#if !defined(_WIN32) && defined(MADV_HUGEPAGE)
+  if (largePageMode() != LargePageMode::Disabled && alignedInterior(memory, size, &start, &end) &&
+      madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE) == 0) {
+    result = LargePageBacking::Transparent;
+    covered = end - start;
+  }
+#else
+  (void)start;
+  (void)end;
+#endif
+
+  account(result, size, covered, true);
+  return result;
+}
+
+void releaseAdvisedLargePages(void* memory, size_t size, LargePageBacking backing) {
+  uintptr_t start = 0;
+  uintptr_t end = 0;
+  size_t covered = 0;
+  if (backing == LargePageBacking::Transparent && alignedInterior(memory, size, &start, &end)) {
+    covered = end - start;
+  }
+  account(backing, size, covered, false);
+}
+
+LargePageStats getLargePageStats() {
+  LargePageStats stats;
+  stats.requestedBytes = g_requestedBytes.load(std::memory_order_relaxed);
+  stats.transparentBytes = g_transparentBytes.load(std::memory_order_relaxed);
+  stats.hugeTlbBytes = g_hugeTlbBytes.load(std::memory_order_relaxed);
+  stats.fallbackBytes = g_fallbackBytes.load(std::memory_order_relaxed);
+  stats.hugeTlbFailures = g_hugeTlbFailures.load(std::memory_order_relaxed);
+  return stats;
+}
+
+size_t residentTransparentHugePageBytes() {
+#ifdef __linux__
+  FILE* file = std::fopen("/proc/self/smaps_rollup", "r");
+  if (!file) {
+    return 0;
+  }
+
+  size_t kilobytes = 0;
+  char line[256];
+  while (std::fgets(line, sizeof(line), file)) {
+    if (std::strncmp(line, "AnonHugePages:", 14) == 0) {
+      unsigned long long value = 0;
+      if (std::sscanf(line + 14, "%llu", &value) == 1) {
+        kilobytes = static_cast<size_t>(value);
+      }
+      break;
+    }
+  }
+  std::fclose(file);
+  return kilobytes * 1024;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
@@ -0,0 +1,111 @@
+/**
+ * @file large_pages.h
+ * @brief ヒープ・コード領域のラージページ（2MB）対応
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_UTILS_MEMORY_ALLOCATORS_LARGE_PAGES_H
+#define AEROJS_UTILS_MEMORY_ALLOCATORS_LARGE_PAGES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+/**
+ * @brief ラージページの使い方
+ */
+enum class LargePageMode : uint8_t {
+  Disabled,     ///< 通常ページのみ
+  Transparent,  ///< 2MB境界に揃えて予約し MADV_HUGEPAGE で THP を要求
+  Explicit      ///< MAP_HUGETLB を試し、失敗したら Transparent と同じ扱い
+};
+
+/**
+ * @brief 領域が実際にどう確保されたか
+ */
+enum class LargePageBacking : uint8_t {
+  SmallPages,   ///< 通常ページ（無効、非対応、または確保失敗によるフォールバック）
+  Transparent,  ///< MADV_HUGEPAGE 済み（実際に2MBページになるかはカーネル次第）
+  HugeTLB       ///< MAP_HUGETLB による予約済みラージページ
+};
+
+constexpr size_t kLargePageSize = size_t(2) << 20;  // 2MB
+
+/**
+ * @brief ラージページの利用状況
+ *
+ * requestedBytes はラージページを試みた領域の合計、transparentBytes と
+ * hugeTlbBytes はそのうち2MB単位で THP の対象にできた量と hugetlbfs から
+ * 確保できた量、fallbackBytes は通常ページで確保した量。
+ * いずれも解放時に差し引く現在値。
+ */
+struct LargePageStats {
+  size_t requestedBytes = 0;
+  size_t transparentBytes = 0;
+  size_t hugeTlbBytes = 0;
+  size_t fallbackBytes = 0;
+  uint64_t hugeTlbFailures = 0;  ///< MAP_HUGETLB が失敗して THP に切り替えた回数
+
+  /**
+   * @brief ラージページで覆えた割合（0.0〜1.0）
+   */
+  double coverage() const {
+    return requestedBytes ? static_cast<double>(transparentBytes + hugeTlbBytes) / requestedBytes : 0.0;
+  }
+};
+
+/**
+ * @brief プロセス全体のモード設定（既定は Disabled、以後に確保する領域に効く）
+ */
+void setLargePageMode(LargePageMode mode);
+LargePageMode largePageMode();
+
+/**
+ * @brief 2MB境界に揃えた読み書き可能領域を確保
+ * @param size バイト数（kLargePageSize の倍数に切り上げ）
+ * @param backing 実際の確保方法の格納先
+ * @return 先頭アドレス（失敗時はnullptr）
+ */
+void* mapLargePageRegion(size_t size, LargePageBacking* backing);
+
+/**
+ * @brief mapLargePageRegion で確保した領域を解放
+ * @return mapLargePageRegion で確保した領域でなければ何もせず false
+ */
+bool unmapLargePageRegion(void* memory, size_t size);
+
+/**
+ * @brief 既存のマッピング内の範囲に THP を要求（ケージなど予約済み領域用）
+ *
+ * 範囲内の2MB境界に揃った部分だけが対象になる。
+ * @return 対象にできた場合は Transparent、それ以外は SmallPages
+ */
+LargePageBacking adviseLargePages(void* memory, size_t size);
+
+/**
+ * @brief adviseLargePages した範囲の返却を統計に反映
+ */
+void releaseAdvisedLargePages(void* memory, size_t size, LargePageBacking backing);
+
+/**
+ * @brief 現在の利用状況
+ */
+LargePageStats getLargePageStats();
+
+/**
+ * @brief カーネルが実際に THP で裏付けているプロセスの匿名メモリ量
+ *
+ * /proc/self/smaps_rollup の AnonHugePages を読む（Linux以外と読めない場合は0）。
+ * 統計の transparentBytes は要求量なので、実際の被覆はこちらで確認する。
+ */
+size_t residentTransparentHugePageBytes();
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
+
+#endif  // AEROJS_UTILS_MEMORY_ALLOCATORS_LARGE_PAGES_H
@@ -0,0 +1,263 @@
+/**
+ * @file numa_page_pool.cpp
+ * @brief NUMAノード別のヒープページプールの実装
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include "numa_page_pool.h"
+#include "large_pages.h"
+#include "../../platform/numa_topology.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+namespace {
+
+constexpr size_t kChunkBytes = sizeclass::kChunkSpans * sizeclass::kSpanSize;
+constexpr uintptr_t kNodeMask = NumaPagePool::kGranule - 1;
+
+size_t roundUpGranule(size_t size) {
+  return (size + NumaPagePool::kGranule - 1) & ~(NumaPagePool::kGranule - 1);
+}
+
+inline size_t slotOf(uintptr_t base, size_t tableSize) {
+  // 2MB単位の番号を乗算ハッシュで散らす
+  return static_cast<size_t>(((base >> 21) * 0x9E3779B97F4A7C15ULL) >> 48) & (tableSize - 1);
+}
+
+void* mapGranuleAligned(size_t size) {
+  if (largePageMode() != LargePageMode::Disabled) {
+    if (void* memory = mapLargePageRegion(size, nullptr)) {
+      return memory;
+    }
+  }
+
+#ifdef _WIN32
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    void* probe = VirtualAlloc(nullptr, size + NumaPagePool::kGranule, MEM_RESERVE, PAGE_NOACCESS);
+    if (!probe) {
+      return nullptr;
+    }
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(probe) + kNodeMask) & ~kNodeMask;
+    VirtualFree(probe, 0, MEM_RELEASE);
+    void* memory = VirtualAlloc(reinterpret_cast<void*>(aligned), size,
+                                MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memory) {
+      return memory;
+    }
+  }
+  return nullptr;
+#else
+  size_t total = size + NumaPagePool::kGranule;
+  void* raw = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (start + kNodeMask) & ~kNodeMask;
+  uintptr_t end = aligned + size;
+  if (aligned > start) {
+    munmap(raw, aligned - start);
+  }
+  if (start + total > end) {
+    munmap(reinterpret_cast<void*>(end), start + total - end);
+  }
+  return reinterpret_cast<void*>(aligned);
+#endif
+}
+
+void unmapGranuleAligned(void* memory, size_t size) {
+  if (unmapLargePageRegion(memory, size)) {
+    return;
+  }
+#ifdef _WIN32
+  (void)size;
+  VirtualFree(memory, 0, MEM_RELEASE);
+#else
+  munmap(memory, size);
+#endif
+}
+
+}  // namespace
+
+NumaPagePool& NumaPagePool::instance() {
+  // 領域はプロセス終了まで他のヒープから参照されうるため破棄しない
+  static NumaPagePool* pool = new NumaPagePool();
+  return *pool;
+}
+
+NumaPagePool::NumaPagePool() {
+  for (auto& slot : m_table) {
+    slot.store(0, std::memory_order_relaxed);
+  }
+  for (int i = 0; i < kMaxNodes; ++i) {
+    m_nodes[static_cast<size_t>(i)].pool = this;
+    m_nodes[static_cast<size_t>(i)].node = i;
+  }
+}
+
+void* NumaPagePool::acquire(size_t size, size_t alignment, int node) {
+  if (alignment > kGranule) {
+    return nullptr;
+  }
+  int nodeCount = NumaTopology::get().nodeCount();
+  if (node < 0 || node >= nodeCount || node >= kMaxNodes) {
+    node = 0;
+  }
+  size = roundUpGranule(size);
+  NodeState& state = m_nodes[static_cast<size_t>(node)];
+
+  if (size == roundUpGranule(kChunkBytes)) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.cached.empty()) {
+      void* memory = state.cached.back();
+      state.cached.pop_back();
+      state.mappedBytes.fetch_add(size, std::memory_order_relaxed);
+      return memory;
+    }
+  }
+
+  void* memory = mapGranuleAligned(size);
+  if (!memory) {
+    return nullptr;
+  }
+
+  // まだ触れていないうちにノードを決めておく（最初の書き込みで物理ページが割り当てられる）
+  if (bindMemoryToNode(memory, size, node)) {
+    state.boundBytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  registerRange(reinterpret_cast<uintptr_t>(memory), size, node);
+  state.mappedBytes.fetch_add(size, std::memory_order_relaxed);
+  return memory;
+}
+
+void NumaPagePool::release(void* memory, size_t size) {
+  if (!memory) {
+    return;
+  }
+  int node = nodeOf(memory);
+  if (node < 0) {
+    return;
+  }
+  size = roundUpGranule(size);
+  NodeState& state = m_nodes[static_cast<size_t>(node)];
+  state.mappedBytes.fetch_sub(size, std::memory_order_relaxed);
+
+  if (size == roundUpGranule(kChunkBytes)) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.cached.size() < kMaxCachedRegions) {
+      // 物理ページは返すがノードの割り当て（mbind）は領域に残る
+#ifndef _WIN32
+      madvise(memory, size, MADV_DONTNEED);
+#endif
+      state.cached.push_back(memory);
+      return;
+    }
+  }
+
+  unregisterRange(reinterpret_cast<uintptr_t>(memory), size);
+  if (state.boundBytes.load(std::memory_order_relaxed) >= size) {
+    state.boundBytes.fetch_sub(size, std::memory_order_relaxed);
+  }
+  unmapGranuleAligned(memory, size);
+}
+
+int NumaPagePool::nodeOf(const void* ptr) const {
+  uintptr_t base = reinterpret_cast<uintptr_t>(ptr) & ~kNodeMask;
+  size_t slot = slotOf(base, kTableSize);
+  for (size_t probe = 0; probe < kTableSize; ++probe) {
+    uintptr_t entry = m_table[slot].load(std::memory_order_acquire);
+    if (entry == 0) {
+      return -1;
+    }
+    if ((entry & ~kNodeMask) == base) {
+      return static_cast<int>(entry & kNodeMask) - 1;
+    }
+    slot = (slot + 1) & (kTableSize - 1);
+  }
+  return -1;
+}
+
+void NumaPagePool::registerRange(uintptr_t start, size_t size, int node) {
+  for (uintptr_t base = start; base < start + size; base += kGranule) {
+    uintptr_t desired = base | static_cast<uintptr_t>(node + 1);
+    size_t slot = slotOf(base, kTableSize);
+    for (size_t probe = 0; probe < kTableSize; ++probe) {
+      uintptr_t entry = m_table[slot].load(std::memory_order_acquire);
+      if (entry == 0) {
+        if (m_table[slot].compare_exchange_strong(entry, desired, std::memory_order_acq_rel)) {
+          break;
+        }
+      }
+      // 以前に解放された同じアドレスのキーは値だけ差し替える
+      if ((entry & ~kNodeMask) == base) {
+        m_table[slot].store(desired, std::memory_order_release);
+        break;
+      }
+      slot = (slot + 1) & (kTableSize - 1);
+    }
+    // 表が埋まった場合は登録しない（nodeOf が -1 を返し、呼び出し側は既定の扱いになる）
+  }
+}
+
+void NumaPagePool::unregisterRange(uintptr_t start, size_t size) {
+  for (uintptr_t base = start; base < start + size; base += kGranule) {
+    size_t slot = slotOf(base, kTableSize);
+    for (size_t probe = 0; probe < kTableSize; ++probe) {
+      uintptr_t entry = m_table[slot].load(std::memory_order_acquire);
+      if (entry == 0) {
+        break;
+      }
+      if ((entry & ~kNodeMask) == base) {
+        // キーは探索列を切らないよう残し、ノードを「なし」にする
+        m_table[slot].store(base, std::memory_order_release);
+        break;
+      }
+      slot = (slot + 1) & (kTableSize - 1);
+    }
+  }
+}
+
+sizeclass::RegionSource NumaPagePool::regionSource(int node) {
+  if (node < 0 || node >= kMaxNodes) {
+    node = 0;
+  }
+  return sizeclass::RegionSource{sourceMap, sourceUnmap, &m_nodes[static_cast<size_t>(node)]};
+}
+
+void* NumaPagePool::sourceMap(size_t size, size_t alignment, void* context) {
+  auto* state = static_cast<NodeState*>(context);
+  return state->pool->acquire(size, alignment, state->node);
+}
+
+void NumaPagePool::sourceUnmap(void* memory, size_t size, void* context) {
+  auto* state = static_cast<NodeState*>(context);
+  state->pool->release(memory, size);
+}
+
+NumaPagePool::NodeStats NumaPagePool::nodeStats(int node) const {
+  NodeStats stats;
+  if (node < 0 || node >= kMaxNodes) {
+    return stats;
+  }
+  const NodeState& state = m_nodes[static_cast<size_t>(node)];
+  stats.mappedBytes = state.mappedBytes.load(std::memory_order_relaxed);
+  stats.boundBytes = state.boundBytes.load(std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    stats.cachedBytes = state.cached.size() * roundUpGranule(kChunkBytes);
+  }
+  return stats;
+}
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
@@ -0,0 +1,107 @@
+/**
+ * @file numa_page_pool.h
+ * @brief NUMAノード別のヒープページプール
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_UTILS_MEMORY_ALLOCATORS_NUMA_PAGE_POOL_H
+#define AEROJS_UTILS_MEMORY_ALLOCATORS_NUMA_PAGE_POOL_H
+
+#include "size_class_allocator.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+/**
+ * @brief NUMAノード別のヒープページプール
+ *
+ * 領域を2MB境界に揃えてマッピングし、要求されたノードに割り当てる
+ * （mbind、偽のトポロジでは記録のみ）。regionSource(node) を
+ * SizeClassAllocator に渡すと、そのアロケータのチャンクはすべて
+ * そのノードのメモリから切り出される。
+ *
+ * 割り当てた領域は2MB単位でノードを記録し、nodeOf() はロックなしで
+ * 所有ノードを引ける（GCのマーキングでセルごとに呼ぶため）。
+ * 返却されたチャンクサイズの領域はノードごとに kMaxCachedRegions 個まで
+ * 保持して再利用し、それ以外は解放する。
+ */
+class NumaPagePool {
+ public:
+  static constexpr size_t kGranule = size_t(2) << 20;  // ノードを記録する単位（2MB）
+  static constexpr int kMaxNodes = 64;
+  static constexpr size_t kMaxCachedRegions = 8;
+
+  struct NodeStats {
+    size_t mappedBytes = 0;   ///< このノードに割り当てて使用中のバイト数
+    size_t cachedBytes = 0;   ///< 再利用のため保持しているバイト数
+    size_t boundBytes = 0;    ///< mbind で実際にノードへ割り当てたバイト数
+  };
+
+  static NumaPagePool& instance();
+
+  /**
+   * @brief ノードに割り当てた領域を取得
+   * @param size バイト数（kGranule の倍数に切り上げ）
+   * @param alignment kGranule 以下のアライメント
+   * @param node ノード番号（範囲外は0）
+   */
+  void* acquire(size_t size, size_t alignment, int node);
+
+  /**
+   * @brief acquire した領域を返却
+   */
+  void release(void* memory, size_t size);
+
+  /**
+   * @brief アドレスを含む領域の所有ノード（このプールの領域でなければ -1）
+   */
+  int nodeOf(const void* ptr) const;
+
+  /**
+   * @brief ノードから切り出す SizeClassAllocator 用の供給元
+   */
+  sizeclass::RegionSource regionSource(int node);
+
+  NodeStats nodeStats(int node) const;
+
+  NumaPagePool(const NumaPagePool&) = delete;
+  NumaPagePool& operator=(const NumaPagePool&) = delete;
+
+ private:
+  NumaPagePool();
+
+  struct NodeState {
+    NumaPagePool* pool = nullptr;
+    int node = 0;
+    mutable std::mutex mutex;
+    std::vector<void*> cached;  // 返却されたチャンクサイズの領域
+    std::atomic<size_t> mappedBytes{0};
+    std::atomic<size_t> boundBytes{0};
+  };
+
+  static void* sourceMap(size_t size, size_t alignment, void* context);
+  static void sourceUnmap(void* memory, size_t size, void* context);
+
+  void registerRange(uintptr_t start, size_t size, int node);
+  void unregisterRange(uintptr_t start, size_t size);
+
+  // 2MB単位の所有ノード表（開番地法、登録のみでキーは消さず値を無効化する）
+  static constexpr size_t kTableSize = size_t(1) << 16;  // 128GB分
+  std::array<std::atomic<uintptr_t>, kTableSize> m_table;
+  std::array<NodeState, kMaxNodes> m_nodes;
+};
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
+
+#endif  // AEROJS_UTILS_MEMORY_ALLOCATORS_NUMA_PAGE_POOL_H
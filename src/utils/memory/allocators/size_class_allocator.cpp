@@ -0,0 +1,932 @@
+/**
+ * @file size_class_allocator.cpp
+ * @brief スレッドキャッシュ付きサイズクラスアロケータの実装
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include "size_class_allocator.h"
+#include "large_pages.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+using namespace sizeclass;
+
+namespace {
+
+// サイズクラスごとのブロックサイズ（16B刻み→2のべき乗ごとに4分割）
+constexpr std::array<size_t, kClassCount> kClassSizes = {
+    0,    16,   32,   48,   64,   80,   96,   112,
+    128,  160,  192,  224,  256,  320,  384,  448,
+    512,  640,  768,  896,  1024, 1280, 1536, 1792,
+    2048, 2560, 3072, 3584, 4096, 5120, 6144, 8192};
+
+static_assert(kClassSizes[kClassCount - 1] == kMaxSmallSize, "last size class must be kMaxSmallSize");
+
+constexpr std::array<uint8_t, (kMaxSmallSize >> 4) + 1> buildClassLookup() {
+  std::array<uint8_t, (kMaxSmallSize >> 4) + 1> table{};
+  size_t cls = 1;
+  for (size_t i = 0; i < table.size(); ++i) {
+    while (kClassSizes[cls] < (i << 4)) {
+      ++cls;
+    }
+    table[i] = static_cast<uint8_t>(cls);
+  }
+  return table;
+}
+
+constexpr std::array<uint32_t, kClassCount> buildBatchSizes() {
+  std::array<uint32_t, kClassCount> table{};
+  for (size_t cls = 1; cls < kClassCount; ++cls) {
+    // 1回の補充でおよそ16KB分、2〜32個の範囲
+    size_t batch = (16 * 1024) / kClassSizes[cls];
+    table[cls] = static_cast<uint32_t>(std::clamp<size_t>(batch, 2, 32));
+  }
+  return table;
+}
+
+constexpr auto kClassLookup = buildClassLookup();
+constexpr auto kBatchSizes = buildBatchSizes();
+
+inline size_t classFor(size_t size, size_t alignment) {
+  if (alignment <= 16) {
+    return size <= kMaxSmallSize ? kClassLookup[(size + 15) >> 4] : 0;
+  }
+
+  // ブロックはスパン先頭+64Bから並ぶため、64B以下のアライメントは
+  // ブロックサイズがその倍数のクラスを選べば満たせる
+  if (alignment > kSpanHeaderSize || (alignment & (alignment - 1)) != 0) {
+    return 0;
+  }
+  size = (size + alignment - 1) & ~(alignment - 1);
+  if (size > kMaxSmallSize) {
+    return 0;
+  }
+  size_t cls = kClassLookup[(size + 15) >> 4];
+  while (cls < kClassCount && (kClassSizes[cls] % alignment) != 0) {
+    ++cls;
+  }
+  return cls < kClassCount ? cls : 0;
+}
+
+inline void*& nextOf(void* block) {
+  return *reinterpret_cast<void**>(block);
+}
+
+size_t systemPageSize() {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwPageSize;
+#else
+  static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return pageSize;
+#endif
+}
+
+// alignment境界に揃えた読み書き可能領域をOSから確保
+void* mapAligned(size_t size, size_t alignment) {
+#ifdef _WIN32
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    void* probe = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+    if (!probe) {
+      return nullptr;
+    }
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(probe) + alignment - 1) & ~(alignment - 1);
+    VirtualFree(probe, 0, MEM_RELEASE);
+    void* memory = VirtualAlloc(reinterpret_cast<void*>(aligned), size,
+                                MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (memory) {
+      return memory;
+    }
+  }
+  return nullptr;
+#else
+  size_t total = size + alignment;
+  void* raw = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (start + alignment - 1) & ~(alignment - 1);
+  uintptr_t end = aligned + size;
+  if (aligned > start) {
+    munmap(raw, aligned - start);
+  }
+  if (start + total > end) {
+    munmap(reinterpret_cast<void*>(end), start + total - end);
+  }
+  return reinterpret_cast<void*>(aligned);
+#endif
+}
+
+void unmapRegion(void* memory, size_t size) {
+#ifdef _WIN32
+  (void)size;
+  VirtualFree(memory, 0, MEM_RELEASE);
+#else
+  munmap(memory, size);
+#endif
+}
+
+void decommitRegion(void* memory, size_t size) {
+#ifdef _WIN32
+  VirtualFree(memory, size, MEM_DECOMMIT);
+#else
+  madvise(memory, size, MADV_DONTNEED);
+#endif
+}
+
+bool recommitRegion(void* memory, size_t size) {
+#ifdef _WIN32
+  return VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+  // MADV_DONTNEED後の領域は次のアクセスでゼロページとして再割り当てされる
+  (void)memory;
+  (void)size;
+  return true;
+#endif
+}
+
+// 既定の供給元（OSから直接マッピング）
+// ラージページが有効なら2MBの倍数のチャンクは2MB境界に置いて THP/hugetlb を使う
+void* osMap(size_t size, size_t alignment, void* /*context*/) {
+  if (largePageMode() != LargePageMode::Disabled &&
+      size % kLargePageSize == 0 && alignment <= kLargePageSize) {
+    if (void* memory = mapLargePageRegion(size, nullptr)) {
+      return memory;
+    }
+  }
+  return mapAligned(size, alignment);
+}
+
+void osUnmap(void* memory, size_t size, void* /*context*/) {
+  if (!unmapLargePageRegion(memory, size)) {
+    unmapRegion(memory, size);
+  }
+}
+
+// 所有スレッドのみが書き込むカウンタの加算（RMW命令を避ける）
+inline void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+std::atomic<uint64_t> g_nextHeapId{1};
+
+}  // namespace
+
+// =====================================================
+// Heap: セントラルリストとページヒープ
+// =====================================================
+
+struct SizeClassAllocator::Heap {
+  struct Central {
+    std::mutex mutex;
+    Span* partial = nullptr;   // 空きブロックを持つスパン
+  };
+
+  struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> deallocations{0};
+    std::atomic<uint64_t> bytesAllocated{0};
+    std::atomic<uint64_t> bytesFreed{0};
+  };
+
+  explicit Heap(const RegionSource& regionSource)
+      : source(regionSource) {
+  }
+
+  RegionSource source;
+  std::array<Central, kClassCount> central;
+
+  // ページヒープ
+  std::mutex pageMutex;
+  Span* freeSpans = nullptr;
+  size_t committedFreeSpans = 0;
+  std::vector<void*> chunks;
+
+  // 専用マッピング（大サイズ）
+  std::mutex largeMutex;
+  Span* largeSpans = nullptr;
+
+  std::atomic<size_t> mappedBytes{0};
+  std::atomic<size_t> memoryLimit{1024ull * 1024 * 1024};  // 1GB
+  std::atomic<size_t> failedAllocations{0};
+  std::atomic<bool> retired{false};
+
+  // スレッドキャッシュの登録と、終了済みスレッド・直接パスの統計
+  std::mutex cacheMutex;
+  std::vector<ThreadCache*> caches;
+  Counters shared;
+
+  ~Heap() {
+    for (void* chunk : chunks) {
+      unmap(chunk, kChunkSpans * kSpanSize);
+    }
+    for (Span* span = largeSpans; span;) {
+      Span* next = span->next;
+      unmap(span, span->mappedSize);
+      span = next;
+    }
+  }
+
+  void* map(size_t size, size_t alignment) {
+    return source.map(size, alignment, source.context);
+  }
+
+  void unmap(void* memory, size_t size) {
+    source.unmap(memory, size, source.context);
+  }
+
+  static bool hasFree(const Span* span) {
+    return span->freeList || span->carved < span->blockCount;
+  }
+
+  static void linkPartial(Central& c, Span* span) {
+    span->prev = nullptr;
+    span->next = c.partial;
+    if (c.partial) {
+      c.partial->prev = span;
+    }
+    c.partial = span;
+  }
+
+  static void unlinkPartial(Central& c, Span* span) {
+    if (span->prev) {
+      span->prev->next = span->next;
+    } else {
+      c.partial = span->next;
+    }
+    if (span->next) {
+      span->next->prev = span->prev;
+    }
+    span->next = span->prev = nullptr;
+  }
+
+  bool reserveBytes(size_t bytes) {
+    size_t current = mappedBytes.load(std::memory_order_relaxed);
+    do {
+      if (current + bytes > memoryLimit.load(std::memory_order_relaxed)) {
+        return false;
+      }
+    } while (!mappedBytes.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+    return true;
+  }
+
+  // pageMutex保持中に呼ぶ
+  bool grow() {
+    const size_t chunkBytes = kChunkSpans * kSpanSize;
+    if (!reserveBytes(chunkBytes)) {
+      return false;
+    }
+    void* chunk = map(chunkBytes, kSpanSize);
+    if (!chunk) {
+      mappedBytes.fetch_sub(chunkBytes, std::memory_order_relaxed);
+      return false;
+    }
+    chunks.push_back(chunk);
+
+    uint8_t* base = static_cast<uint8_t*>(chunk);
+    for (size_t i = kChunkSpans; i-- > 0;) {
+      Span* span = reinterpret_cast<Span*>(base + i * kSpanSize);
+      std::memset(span, 0, sizeof(Span));
+      span->committed = true;
+      span->next = freeSpans;
+      freeSpans = span;
+    }
+    committedFreeSpans += kChunkSpans;
+    return true;
+  }
+
+  Span* allocateSpan(size_t cls) {
+    std::lock_guard<std::mutex> lock(pageMutex);
+    if (!freeSpans && !grow()) {
+      return nullptr;
+    }
+
+    Span* span = freeSpans;
+    if (!span->committed) {
+      const size_t page = systemPageSize();
+      if (!reserveBytes(kSpanSize - page)) {
+        return nullptr;
+      }
+      if (!recommitRegion(reinterpret_cast<uint8_t*>(span) + page, kSpanSize - page)) {
+        mappedBytes.fetch_sub(kSpanSize - page, std::memory_order_relaxed);
+        return nullptr;
+      }
+      span->committed = true;
+    } else {
+      committedFreeSpans--;
+    }
+    freeSpans = span->next;
+
+    span->sizeClass = static_cast<uint32_t>(cls);
+    span->blockSize = kClassSizes[cls];
+    span->blockCount = static_cast<uint32_t>((kSpanSize - kSpanHeaderSize) / kClassSizes[cls]);
+    span->liveCount = 0;
+    span->carved = 0;
+    span->freeList = nullptr;
+    span->next = span->prev = nullptr;
+    return span;
+  }
+
+  void releaseSpan(Span* span) {
+    std::lock_guard<std::mutex> lock(pageMutex);
+    span->sizeClass = 0;
+    span->blockCount = 0;
+    span->liveCount = 0;
+    span->carved = 0;
+    span->freeList = nullptr;
+    span->prev = nullptr;
+
+    if (committedFreeSpans >= kMaxCommittedFreeSpans) {
+      // ヘッダのあるページを残して物理メモリを返却
+      const size_t page = systemPageSize();
+      decommitRegion(reinterpret_cast<uint8_t*>(span) + page, kSpanSize - page);
+      mappedBytes.fetch_sub(kSpanSize - page, std::memory_order_relaxed);
+      span->committed = false;
+    } else {
+      committedFreeSpans++;
+    }
+
+    span->next = freeSpans;
+    freeSpans = span;
+  }
+
+  size_t releaseFreeSpans() {
+    std::lock_guard<std::mutex> lock(pageMutex);
+    const size_t page = systemPageSize();
+    size_t released = 0;
+    for (Span* span = freeSpans; span; span = span->next) {
+      if (span->committed) {
+        decommitRegion(reinterpret_cast<uint8_t*>(span) + page, kSpanSize - page);
+        span->committed = false;
+        released += kSpanSize - page;
+      }
+    }
+    committedFreeSpans = 0;
+    mappedBytes.fetch_sub(released, std::memory_order_relaxed);
+    return released;
+  }
+
+  /**
+   * @brief セントラルリストから最大batch個のブロックを取り出す
+   * @param head 取り出したブロックの連結リスト（出力）
+   * @return 取り出した個数
+   */
+  uint32_t fetch(size_t cls, uint32_t batch, void*& head) {
+    Central& c = central[cls];
+    std::lock_guard<std::mutex> lock(c.mutex);
+
+    uint32_t count = 0;
+    head = nullptr;
+    while (count < batch) {
+      Span* span = c.partial;
+      if (!span) {
+        span = allocateSpan(cls);
+        if (!span) {
+          break;
+        }
+        linkPartial(c, span);
+      }
+
+      while (count < batch && hasFree(span)) {
+        void* block;
+        if (span->freeList) {
+          block = span->freeList;
+          span->freeList = nextOf(block);
+        } else {
+          block = reinterpret_cast<uint8_t*>(span) + kSpanHeaderSize +
+                  static_cast<size_t>(span->carved++) * span->blockSize;
+        }
+        nextOf(block) = head;
+        head = block;
+        span->liveCount++;
+        count++;
+      }
+
+      if (!hasFree(span)) {
+        // 使い切ったスパンはリストから外す（返却時に戻す）
+        unlinkPartial(c, span);
+      }
+    }
+    return count;
+  }
+
+  /**
+   * @brief ブロックの連結リストをセントラルリストへ返却
+   */
+  void giveBack(size_t cls, void* head) {
+    Central& c = central[cls];
+    std::lock_guard<std::mutex> lock(c.mutex);
+
+    while (head) {
+      void* block = head;
+      head = nextOf(block);
+
+      Span* span = spanOf(block);
+      bool wasFull = !hasFree(span);
+      nextOf(block) = span->freeList;
+      span->freeList = block;
+      span->liveCount--;
+
+      if (wasFull) {
+        linkPartial(c, span);
+      }
+
+      // 空になったスパンはページヒープへ返す（唯一の部分スパンは残す）
+      if (span->liveCount == 0 && !(c.partial == span && span->next == nullptr)) {
+        unlinkPartial(c, span);
+        releaseSpan(span);
+      }
+    }
+  }
+};
+
+// =====================================================
+// ThreadCache: スレッドローカルな空きリスト
+// =====================================================
+
+struct SizeClassAllocator::ThreadCache {
+  struct FreeList {
+    void* head = nullptr;
+    uint32_t length = 0;
+  };
+
+  std::array<FreeList, kClassCount> lists;
+  std::shared_ptr<Heap> heap;
+  uint64_t heapId;
+  Heap::Counters counters;
+
+  ThreadCache(std::shared_ptr<Heap> owner, uint64_t id)
+    : heap(std::move(owner)), heapId(id) {
+    std::lock_guard<std::mutex> lock(heap->cacheMutex);
+    heap->caches.push_back(this);
+  }
+
+  ~ThreadCache() {
+    flushAll();
+
+    std::lock_guard<std::mutex> lock(heap->cacheMutex);
+    heap->shared.allocations += counters.allocations.load(std::memory_order_relaxed);
+    heap->shared.deallocations += counters.deallocations.load(std::memory_order_relaxed);
+    heap->shared.bytesAllocated += counters.bytesAllocated.load(std::memory_order_relaxed);
+    heap->shared.bytesFreed += counters.bytesFreed.load(std::memory_order_relaxed);
+    heap->caches.erase(std::remove(heap->caches.begin(), heap->caches.end(), this), heap->caches.end());
+  }
+
+  void* refill(size_t cls) {
+    void* head = nullptr;
+    uint32_t count = heap->fetch(cls, kBatchSizes[cls], head);
+    if (count == 0) {
+      return nullptr;
+    }
+
+    void* block = head;
+    lists[cls].head = nextOf(block);
+    lists[cls].length = count - 1;
+    return block;
+  }
+
+  // 先頭からcount個をセントラルリストへ返す
+  void release(size_t cls, uint32_t count) {
+    FreeList& list = lists[cls];
+    void* head = list.head;
+    void* tail = head;
+    for (uint32_t i = 1; i < count; ++i) {
+      tail = nextOf(tail);
+    }
+    list.head = nextOf(tail);
+    list.length -= count;
+    nextOf(tail) = nullptr;
+    heap->giveBack(cls, head);
+  }
+
+  void flushAll() {
+    for (size_t cls = 1; cls < kClassCount; ++cls) {
+      if (lists[cls].head) {
+        heap->giveBack(cls, lists[cls].head);
+        lists[cls].head = nullptr;
+        lists[cls].length = 0;
+      }
+    }
+  }
+};
+
+namespace {
+
+// スレッド終了時にキャッシュをセントラルリストへ戻す
+struct ThreadCacheOwner {
+  std::vector<std::unique_ptr<SizeClassAllocator::ThreadCache>> caches;
+  ~ThreadCacheOwner();
+};
+
+thread_local uint64_t t_cachedHeapId = 0;
+thread_local SizeClassAllocator::ThreadCache* t_cachedCache = nullptr;
+thread_local bool t_ownerDestroyed = false;
+thread_local ThreadCacheOwner t_owner;
+
+ThreadCacheOwner::~ThreadCacheOwner() {
+  t_ownerDestroyed = true;
+  t_cachedHeapId = 0;
+  t_cachedCache = nullptr;
+  caches.clear();
+}
+
+}  // namespace
+
+// =====================================================
+// SizeClassAllocator Implementation
+// =====================================================
+
+SizeClassAllocator::SizeClassAllocator()
+    : SizeClassAllocator(RegionSource{osMap, osUnmap, nullptr}) {
+}
+
+SizeClassAllocator::SizeClassAllocator(const RegionSource& source)
+    : heap_(std::make_shared<Heap>(source)),
+      heapId_(g_nextHeapId.fetch_add(1, std::memory_order_relaxed)) {
+}
+
+SizeClassAllocator::~SizeClassAllocator() {
+  heap_->retired.store(true, std::memory_order_release);
+
+  // 呼び出しスレッドのキャッシュは即座に破棄（他スレッドは次回のキャッシュ検索時に破棄）
+  if (!t_ownerDestroyed) {
+    auto& caches = t_owner.caches;
+    caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                [this](const auto& cache) { return cache->heapId == heapId_; }),
+                 caches.end());
+  }
+  if (t_cachedHeapId == heapId_) {
+    t_cachedHeapId = 0;
+    t_cachedCache = nullptr;
+  }
+}
+
+bool SizeClassAllocator::initialize() {
+  return true;
+}
+
+inline SizeClassAllocator::ThreadCache* SizeClassAllocator::threadCache() {
+  if (t_cachedHeapId == heapId_) {
+    return t_cachedCache;
+  }
+  return createThreadCache();
+}
+
+SizeClassAllocator::ThreadCache* SizeClassAllocator::createThreadCache() {
+  if (t_ownerDestroyed) {
+    return nullptr;
+  }
+
+  auto& caches = t_owner.caches;
+
+  // 破棄済みアロケータのキャッシュを整理
+  caches.erase(std::remove_if(caches.begin(), caches.end(),
+                              [](const auto& cache) {
+                                return cache->heap->retired.load(std::memory_order_acquire);
+                              }),
+               caches.end());
+
+  ThreadCache* found = nullptr;
+  for (auto& cache : caches) {
+    if (cache->heapId == heapId_) {
+      found = cache.get();
+      break;
+    }
+  }
+  if (!found) {
+    caches.push_back(std::make_unique<ThreadCache>(heap_, heapId_));
+    found = caches.back().get();
+  }
+
+  t_cachedHeapId = heapId_;
+  t_cachedCache = found;
+  return found;
+}
+
+void* SizeClassAllocator::allocate(size_t size, size_t alignment) {
+  if (size == 0) return nullptr;
+
+  size_t cls = classFor(size, alignment);
+  if (cls == 0) {
+    return allocateLarge(size, alignment);
+  }
+
+  ThreadCache* cache = threadCache();
+  if (cache) {
+    auto& list = cache->lists[cls];
+    void* block = list.head;
+    if (block) {
+      list.head = nextOf(block);
+      list.length--;
+    } else {
+      block = cache->refill(cls);
+    }
+
+    if (block) {
+      bump(cache->counters.allocations, 1);
+      bump(cache->counters.bytesAllocated, kClassSizes[cls]);
+    } else {
+      heap_->failedAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return block;
+  }
+
+  // スレッド終了処理中はキャッシュを介さずセントラルリストから直接取得
+  void* block = nullptr;
+  if (heap_->fetch(cls, 1, block) == 0) {
+    heap_->failedAllocations.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  heap_->shared.allocations.fetch_add(1, std::memory_order_relaxed);
+  heap_->shared.bytesAllocated.fetch_add(kClassSizes[cls], std::memory_order_relaxed);
+  return block;
+}
+
+void SizeClassAllocator::deallocate(void* ptr) {
+  if (!ptr) return;
+
+  Span* span = spanOf(ptr);
+  size_t cls = span->sizeClass;
+  if (cls == 0) {
+    deallocateLarge(span);
+    return;
+  }
+
+  ThreadCache* cache = threadCache();
+  if (cache) {
+    auto& list = cache->lists[cls];
+    nextOf(ptr) = list.head;
+    list.head = ptr;
+    list.length++;
+
+    bump(cache->counters.deallocations, 1);
+    bump(cache->counters.bytesFreed, kClassSizes[cls]);
+
+    // 溜め込みすぎたら1バッチ分をセントラルリストへ返す
+    if (list.length > 2 * kBatchSizes[cls]) {
+      cache->release(cls, kBatchSizes[cls]);
+    }
+    return;
+  }
+
+  nextOf(ptr) = nullptr;
+  heap_->giveBack(cls, ptr);
+  heap_->shared.deallocations.fetch_add(1, std::memory_order_relaxed);
+  heap_->shared.bytesFreed.fetch_add(kClassSizes[cls], std::memory_order_relaxed);
+}
+
+void* SizeClassAllocator::allocateLarge(size_t size, size_t alignment) {
+  if (alignment >= kSpanSize || (alignment & (alignment - 1)) != 0) {
+    heap_->failedAllocations.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  const size_t page = systemPageSize();
+  size_t dataOffset = std::max(kSpanHeaderSize, alignment);
+  size_t mappedSize = (dataOffset + size + page - 1) & ~(page - 1);
+
+  if (!heap_->reserveBytes(mappedSize)) {
+    heap_->failedAllocations.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  void* memory = heap_->map(mappedSize, kSpanSize);
+  if (!memory) {
+    heap_->mappedBytes.fetch_sub(mappedSize, std::memory_order_relaxed);
+    heap_->failedAllocations.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Span* span = static_cast<Span*>(memory);
+  std::memset(span, 0, sizeof(Span));
+  span->blockSize = size;
+  span->blockCount = 1;
+  span->liveCount = 1;
+  span->mappedSize = mappedSize;
+  span->dataOffset = static_cast<uint32_t>(dataOffset);
+  span->committed = true;
+
+  {
+    std::lock_guard<std::mutex> lock(heap_->largeMutex);
+    span->next = heap_->largeSpans;
+    if (heap_->largeSpans) {
+      heap_->largeSpans->prev = span;
+    }
+    heap_->largeSpans = span;
+  }
+
+  heap_->shared.allocations.fetch_add(1, std::memory_order_relaxed);
+  heap_->shared.bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+  return reinterpret_cast<uint8_t*>(span) + dataOffset;
+}
+
+void SizeClassAllocator::deallocateLarge(Span* span) {
+  {
+    std::lock_guard<std::mutex> lock(heap_->largeMutex);
+    if (span->prev) {
+      span->prev->next = span->next;
+    } else {
+      heap_->largeSpans = span->next;
+    }
+    if (span->next) {
+      span->next->prev = span->prev;
+    }
+  }
+
+  heap_->shared.deallocations.fetch_add(1, std::memory_order_relaxed);
+  heap_->shared.bytesFreed.fetch_add(span->blockSize, std::memory_order_relaxed);
+
+  size_t mappedSize = span->mappedSize;
+  heap_->unmap(span, mappedSize);
+  heap_->mappedBytes.fetch_sub(mappedSize, std::memory_order_relaxed);
+}
+
+void* SizeClassAllocator::reallocate(void* ptr, size_t newSize, size_t alignment) {
+  if (!ptr) {
+    return allocate(newSize, alignment);
+  }
+
+  if (newSize == 0) {
+    deallocate(ptr);
+    return nullptr;
+  }
+
+  // 同じサイズクラスに収まる場合はそのまま返す
+  size_t oldSize = getSize(ptr);
+  Span* span = spanOf(ptr);
+  if (span->sizeClass != 0 && newSize <= oldSize && classFor(newSize, alignment) == span->sizeClass) {
+    return ptr;
+  }
+
+  void* newPtr = allocate(newSize, alignment);
+  if (newPtr) {
+    std::memcpy(newPtr, ptr, std::min(oldSize, newSize));
+    deallocate(ptr);
+  }
+  return newPtr;
+}
+
+size_t SizeClassAllocator::getSize(void* ptr) const {
+  if (!ptr) return 0;
+
+  Span* span = spanOf(ptr);
+  return span->sizeClass != 0 ? kClassSizes[span->sizeClass] : span->blockSize;
+}
+
+size_t SizeClassAllocator::roundUpSize(size_t size) {
+  size_t cls = classFor(size, 8);
+  return cls != 0 ? kClassSizes[cls] : 0;
+}
+
+size_t SizeClassAllocator::getCurrentAllocatedSize() const {
+  return getStats().currentAllocated;
+}
+
+size_t SizeClassAllocator::getTotalAllocatedSize() const {
+  return getStats().totalAllocated;
+}
+
+void SizeClassAllocator::setMemoryLimit(size_t limit) {
+  heap_->memoryLimit.store(limit, std::memory_order_relaxed);
+}
+
+size_t SizeClassAllocator::getMemoryLimit() const {
+  return heap_->memoryLimit.load(std::memory_order_relaxed);
+}
+
+size_t SizeClassAllocator::getMappedBytes() const {
+  return heap_->mappedBytes.load(std::memory_order_relaxed);
+}
+
+const AllocatorStats& SizeClassAllocator::getStats() const {
+  std::lock_guard<std::mutex> lock(heap_->cacheMutex);
+
+  uint64_t allocations = heap_->shared.allocations.load(std::memory_order_relaxed);
+  uint64_t deallocations = heap_->shared.deallocations.load(std::memory_order_relaxed);
+  uint64_t bytesAllocated = heap_->shared.bytesAllocated.load(std::memory_order_relaxed);
+  uint64_t bytesFreed = heap_->shared.bytesFreed.load(std::memory_order_relaxed);
+  for (const ThreadCache* cache : heap_->caches) {
+    allocations += cache->counters.allocations.load(std::memory_order_relaxed);
+    deallocations += cache->counters.deallocations.load(std::memory_order_relaxed);
+    bytesAllocated += cache->counters.bytesAllocated.load(std::memory_order_relaxed);
+    bytesFreed += cache->counters.bytesFreed.load(std::memory_order_relaxed);
+  }
+
+  // スレッド間で解放された分は一時的に割り当て数を上回りうる
+  size_t currentBytes = bytesAllocated > bytesFreed ? bytesAllocated - bytesFreed : 0;
+
+  stats_.totalAllocations = allocations;
+  stats_.currentAllocations = allocations > deallocations ? allocations - deallocations : 0;
+  stats_.totalBytes = bytesAllocated;
+  stats_.currentBytes = currentBytes;
+  stats_.totalAllocated = bytesAllocated;
+  stats_.currentAllocated = currentBytes;
+  stats_.peakBytes = std::max(stats_.peakBytes, currentBytes);
+  stats_.failedAllocations = heap_->failedAllocations.load(std::memory_order_relaxed);
+  return stats_;
+}
+
+void SizeClassAllocator::prepareForGC() {
+  // GC準備処理
+}
+
+void SizeClassAllocator::finishGC() {
+  flushThreadCache();
+  releaseFreeMemory();
+}
+
+void SizeClassAllocator::startGC() {
+  std::lock_guard<std::mutex> lock(heap_->cacheMutex);
+  stats_.gcCount++;
+}
+
+void SizeClassAllocator::flushThreadCache() {
+  if (t_ownerDestroyed) {
+    return;
+  }
+  for (auto& cache : t_owner.caches) {
+    if (cache->heapId == heapId_) {
+      cache->flushAll();
+      break;
+    }
+  }
+}
+
+size_t SizeClassAllocator::releaseFreeMemory() {
+  return heap_->releaseFreeSpans();
+}
+
+std::vector<void*> SizeClassAllocator::getAllocatedObjects() const {
+  // スレッドキャッシュに保持されている空きブロック
+  std::unordered_set<void*> cached;
+  {
+    std::lock_guard<std::mutex> lock(heap_->cacheMutex);
+    for (const ThreadCache* cache : heap_->caches) {
+      for (const auto& list : cache->lists) {
+        for (void* block = list.head; block; block = nextOf(block)) {
+          cached.insert(block);
+        }
+      }
+    }
+  }
+
+  std::vector<void*> objects;
+  std::vector<void*> chunks;
+  {
+    std::lock_guard<std::mutex> lock(heap_->pageMutex);
+    chunks = heap_->chunks;
+  }
+
+  std::unordered_set<void*> spanFree;
+  for (void* chunk : chunks) {
+    for (size_t i = 0; i < kChunkSpans; ++i) {
+      Span* span = reinterpret_cast<Span*>(static_cast<uint8_t*>(chunk) + i * kSpanSize);
+      if (span->blockCount == 0) {
+        continue;  // 空きスパン
+      }
+
+      std::lock_guard<std::mutex> lock(heap_->central[span->sizeClass].mutex);
+      spanFree.clear();
+      for (void* block = span->freeList; block; block = nextOf(block)) {
+        spanFree.insert(block);
+      }
+
+      uint8_t* first = reinterpret_cast<uint8_t*>(span) + kSpanHeaderSize;
+      for (uint32_t b = 0; b < span->carved; ++b) {
+        void* block = first + static_cast<size_t>(b) * span->blockSize;
+        if (!spanFree.count(block) && !cached.count(block)) {
+          objects.push_back(block);
+        }
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(heap_->largeMutex);
+    for (Span* span = heap_->largeSpans; span; span = span->next) {
+      objects.push_back(reinterpret_cast<uint8_t*>(span) + span->dataOffset);
+    }
+  }
+
+  return objects;
+}
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
@@ -0,0 +1,152 @@
+/**
+ * @file size_class_allocator.h
+ * @brief スレッドキャッシュ付きサイズクラスアロケータ
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_UTILS_MEMORY_ALLOCATORS_SIZE_CLASS_ALLOCATOR_H
+#define AEROJS_UTILS_MEMORY_ALLOCATORS_SIZE_CLASS_ALLOCATOR_H
+
+#include "memory_allocator.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+namespace sizeclass {
+
+constexpr size_t kSpanShift = 16;                    // スパンサイズ（64KB）
+constexpr size_t kSpanSize = size_t(1) << kSpanShift;
+constexpr size_t kSpanMask = ~(kSpanSize - 1);
+constexpr size_t kSpanHeaderSize = 64;               // スパン先頭のメタデータ領域
+constexpr size_t kMaxSmallSize = 8 * 1024;           // これを超える要求は専用マッピング
+constexpr size_t kClassCount = 32;                   // サイズクラス数（0番は未使用）
+constexpr size_t kChunkSpans = 64;                   // ページヒープが一度に確保するスパン数
+constexpr size_t kMaxCommittedFreeSpans = 16;        // コミットしたまま保持する空きスパン数
+
+/**
+ * @brief スパンのメタデータ
+ *
+ * 各スパンは kSpanSize 境界に配置され、先頭 kSpanHeaderSize バイトに
+ * このヘッダを置く。ブロックからは ptr & kSpanMask でヘッダを引ける。
+ * 小サイズ用スパンのフィールドは対応するサイズクラスのセントラルロック下で更新する。
+ */
+struct Span {
+  uint32_t sizeClass;        // 0 = 空きスパンまたは専用マッピング
+  uint32_t blockCount;       // スパン内のブロック数（0 = 空きスパン）
+  uint32_t liveCount;        // スレッドキャッシュ側へ渡したブロック数
+  uint32_t carved;           // 先頭から切り出し済みのブロック数
+  size_t blockSize;          // ブロックサイズ（大サイズ時は要求サイズ）
+  void* freeList;            // 返却されたブロック
+  Span* next;                // セントラルリスト／空きスパンリスト／大サイズリスト
+  Span* prev;
+  size_t mappedSize;         // 大サイズ時のマッピング長
+  uint32_t dataOffset;       // 大サイズ時の先頭からのデータオフセット
+  bool committed;            // 物理メモリが割り当てられているか
+};
+
+static_assert(sizeof(Span) <= kSpanHeaderSize, "Span header must fit in kSpanHeaderSize");
+
+/**
+ * @brief スパン用の仮想メモリ供給元
+ *
+ * 既定ではOSから直接マッピングする。ヒープケージなど特定の予約領域内に
+ * 割り当てを閉じ込めたい場合に差し替える。
+ */
+struct RegionSource {
+  void* (*map)(size_t size, size_t alignment, void* context);
+  void (*unmap)(void* memory, size_t size, void* context);
+  void* context;
+};
+
+inline Span* spanOf(const void* ptr) {
+  return reinterpret_cast<Span*>(reinterpret_cast<uintptr_t>(ptr) & kSpanMask);
+}
+
+}  // namespace sizeclass
+
+/**
+ * @brief スレッドキャッシュ付きサイズクラスアロケータ
+ *
+ * 8KB以下の要求を32のサイズクラスに丸め、スレッドごとのキャッシュから
+ * ロックなしで払い出す。キャッシュが空になると、サイズクラスごとの
+ * セントラルリストからバッチ単位で補充する（ロックはクラス単位）。
+ * セントラルリストは64KBのスパンをページヒープから受け取り、
+ * 全ブロックが返却されたスパンはページヒープへ戻し、
+ * 保持上限を超えた分は madvise(MADV_DONTNEED) で物理メモリをOSへ返す。
+ * 8KBを超える要求はスパン境界に揃えた専用マッピングで扱う。
+ *
+ * getAllocatedObjects() はスパンを走査して払い出し済みブロックを列挙するため、
+ * 呼び出し中は他スレッドが割り当て・解放を行っていないこと（GC停止中）。
+ */
+class SizeClassAllocator : public MemoryAllocator {
+ public:
+  SizeClassAllocator();
+  explicit SizeClassAllocator(const sizeclass::RegionSource& source);
+  ~SizeClassAllocator() override;
+
+  void* allocate(size_t size, size_t alignment = 8) override;
+  void deallocate(void* ptr) override;
+  void* reallocate(void* ptr, size_t newSize, size_t alignment = 8) override;
+  size_t getSize(void* ptr) const override;
+  size_t getCurrentAllocatedSize() const override;
+  size_t getTotalAllocatedSize() const override;
+  void setMemoryLimit(size_t limit) override;
+  size_t getMemoryLimit() const override;
+  const AllocatorStats& getStats() const override;
+  void prepareForGC() override;
+  void finishGC() override;
+  std::vector<void*> getAllocatedObjects() const override;
+  void startGC() override;
+  bool initialize() override;
+
+  /**
+   * @brief 呼び出しスレッドのキャッシュをセントラルリストへ返却
+   */
+  void flushThreadCache();
+
+  /**
+   * @brief 空きスパンの物理メモリをすべてOSへ返却
+   * @return size_t 返却したバイト数
+   */
+  size_t releaseFreeMemory();
+
+  /**
+   * @brief OSからマッピングしているバイト数を取得
+   */
+  size_t getMappedBytes() const;
+
+  /**
+   * @brief サイズに対応するサイズクラスのブロックサイズを取得（0 = 専用マッピング）
+   */
+  static size_t roundUpSize(size_t size);
+
+  struct Heap;
+  struct ThreadCache;
+
+ private:
+  ThreadCache* threadCache();
+  ThreadCache* createThreadCache();
+
+  void* allocateLarge(size_t size, size_t alignment);
+  void deallocateLarge(sizeclass::Span* span);
+
+  std::shared_ptr<Heap> heap_;
+  uint64_t heapId_;
+  mutable AllocatorStats stats_;
+};
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
+
+#endif  // AEROJS_UTILS_MEMORY_ALLOCATORS_SIZE_CLASS_ALLOCATOR_H
@@ -0,0 +1,96 @@
+/**
+ * @file card_table.cpp
+ * @brief カード表の実装
+ * @version 2.0.0
+ * @license MIT
+ */
+
+#include "card_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+CardTable::CardTable()
+  : m_regions(nullptr),
+    m_discard(new uint8_t[kCardsPerRegion]())
+{
+  size_t indexBytes = kRegionIndexCount * sizeof(uint8_t*);
+#ifdef _WIN32
+  m_regions = static_cast<uint8_t**>(VirtualAlloc(nullptr, indexBytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+  // 触れたページだけがコミットされる（未使用エントリはゼロページ=nullptr）
+  void* mem = mmap(nullptr, indexBytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  m_regions = mem == MAP_FAILED ? nullptr : static_cast<uint8_t**>(mem);
+#endif
+  if (!m_regions) {
+    throw std::bad_alloc();
+  }
+}
+
+CardTable::~CardTable() {
+  for (uintptr_t regionIndex : m_activeRegions) {
+    delete[] m_regions[regionIndex];
+  }
+#ifdef _WIN32
+  VirtualFree(m_regions, 0, MEM_RELEASE);
+#else
+  munmap(m_regions, kRegionIndexCount * sizeof(uint8_t*));
+#endif
+  delete[] m_discard;
+}
+
+uint8_t* CardTable::cardFor(const void* ptr) const {
+  uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+  uint8_t* cards = m_regions[(addr >> kRegionShift) & (kRegionIndexCount - 1)];
+  return cards ? &cards[(addr >> kCardShift) & (kCardsPerRegion - 1)] : nullptr;
+}
+
+void CardTable::clearCard(const void* ptr) {
+  if (uint8_t* card = cardFor(ptr)) {
+    *card = kClean;
+  }
+}
+
+void CardTable::clearAll() {
+  for (uintptr_t regionIndex : m_activeRegions) {
+    std::memset(m_regions[regionIndex], kClean, kCardsPerRegion);
+  }
+}
+
+void CardTable::ensureCovered(const void* ptr, size_t size) {
+  uintptr_t first = reinterpret_cast<uintptr_t>(ptr) >> kRegionShift;
+  uintptr_t last = (reinterpret_cast<uintptr_t>(ptr) + std::max<size_t>(size, 1) - 1) >> kRegionShift;
+  
+  for (uintptr_t region = first; region <= last; ++region) {
+    uintptr_t regionIndex = region & (kRegionIndexCount - 1);
+    // ほとんどの割り当ては既存リージョン内なので、ロックなしで確認する
+    std::atomic_ref<uint8_t*> entry(m_regions[regionIndex]);
+    if (entry.load(std::memory_order_acquire)) {
+      continue;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_coverMutex);
+    if (!entry.load(std::memory_order_relaxed)) {
+      // カード列を書き終えてから公開する（書き込みバリアは索引表を直接読む）
+      uint8_t* cards = new uint8_t[kCardsPerRegion]();
+      m_activeRegions.push_back(regionIndex);
+      entry.store(cards, std::memory_order_release);
+    }
+  }
+}
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
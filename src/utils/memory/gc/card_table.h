@@ -0,0 +1,102 @@
+/**
+ * @file card_table.h
+ * @brief オールド→ヤング参照を追跡するカード表
+ * @version 2.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+// カード表
+//
+// オールド→ヤング参照を追跡する唯一の仕組み。ヒープを512バイトの
+// カードに分割し、1カード1バイトのダーティフラグを保持する。
+// カード配列は4MBリージョン単位で確保し、リージョン番号から直接
+// 引ける予約済みの索引表で参照する。未確保リージョンへの書き込みは
+// 破棄用カード列に流れるため、書き込みバリアは分岐なしで済む。
+class CardTable {
+public:
+  static constexpr size_t kCardShift = 9;
+  static constexpr size_t kCardSize = size_t(1) << kCardShift;          // 512B
+  static constexpr size_t kRegionShift = 22;
+  static constexpr size_t kRegionSize = size_t(1) << kRegionShift;      // 4MB
+  static constexpr size_t kCardsPerRegion = kRegionSize / kCardSize;    // 8192
+  static constexpr size_t kAddressBits = 47;
+  static constexpr size_t kRegionIndexCount = size_t(1) << (kAddressBits - kRegionShift);
+  static constexpr uint8_t kClean = 0;
+  static constexpr uint8_t kDirty = 1;
+  
+  CardTable();
+  ~CardTable();
+  
+  CardTable(const CardTable&) = delete;
+  CardTable& operator=(const CardTable&) = delete;
+  
+  // 分岐なし書き込みバリア本体（未確保リージョンはcmovで破棄用カード列へ）
+  inline void markCard(const void* ptr) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
+    uint8_t* cards = m_regions[(addr >> kRegionShift) & (kRegionIndexCount - 1)];
+    cards = cards ? cards : m_discard;
+    cards[(addr >> kCardShift) & (kCardsPerRegion - 1)] = kDirty;
+  }
+  
+  inline bool isCardMarked(const void* ptr) const {
+    uint8_t* card = cardFor(ptr);
+    return card && *card != kClean;
+  }
+  
+  void clearCard(const void* ptr);
+  void clearAll();
+  
+  // 割り当て範囲のリージョンにカード列を用意（任意のスレッドから呼べる。
+  // 既に覆われていればロックを取らない）
+  void ensureCovered(const void* ptr, size_t size);
+  
+  uint8_t* cardFor(const void* ptr) const;
+  size_t getRegionCount() const { return m_activeRegions.size(); }
+  size_t getCardCount() const { return m_activeRegions.size() * kCardsPerRegion; }
+  
+  // 確保済みリージョン [regionBegin, regionEnd) のダーティカードを列挙
+  // fn(uint8_t& card, uintptr_t cardStart)。8カード単位で空判定する。
+  // リージョン一覧を読むため、割り当てが止まっている（GC停止中の）間に呼ぶこと
+  template<typename Fn>
+  void forEachDirtyCard(size_t regionBegin, size_t regionEnd, Fn&& fn) const {
+    for (size_t r = regionBegin; r < regionEnd && r < m_activeRegions.size(); ++r) {
+      uintptr_t regionIndex = m_activeRegions[r];
+      uint8_t* cards = m_regions[regionIndex];
+      uintptr_t base = regionIndex << kRegionShift;
+      for (size_t i = 0; i < kCardsPerRegion; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, cards + i, sizeof(word));
+        if (word == 0) {
+          continue;
+        }
+        for (size_t j = i; j < i + 8; ++j) {
+          if (cards[j] != kClean) {
+            fn(cards[j], base + (j << kCardShift));
+          }
+        }
+      }
+    }
+  }
+  
+private:
+  uint8_t** m_regions;                     // リージョン番号→カード列（予約のみ、遅延コミット）
+  std::vector<uintptr_t> m_activeRegions;  // カード列を確保したリージョン番号
+  uint8_t* m_discard;                      // 未確保リージョン向けの破棄用カード列
+  std::mutex m_coverMutex;                 // リージョン追加の直列化（m_activeRegions を保護）
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
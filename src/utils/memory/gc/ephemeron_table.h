@@ -0,0 +1,193 @@
+/**
+ * @file ephemeron_table.h
+ * @brief 弱キー表（エフェメロン表）のオープンアドレス実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+/**
+ * @brief オブジェクト同一性をキーとするエフェメロン表
+ *
+ * WeakMap の実体。キーは強参照されず、表の持ち主がキーの破棄の通知を受けて
+ * エントリを remove する。WeakMap のキーは参照カウントのオブジェクトで
+ * コレクタのマーキングの対象ではないため、値からキーへの循環は回収されない。
+ *
+ * 線形探索のオープンアドレス法で、キーのアドレスから求めた同一性ハッシュを使う。
+ * 容量は2の冪、削除済みスロットは墓標として残し、拡張時に再構築する。
+ *
+ * @tparam K キーのオブジェクト型（ポインタで保持）
+ * @tparam V 値の型
+ */
+template <typename K, typename V>
+class EphemeronTable {
+public:
+  struct Entry {
+    K* key;
+    V value;
+  };
+
+  explicit EphemeronTable(size_t initialCapacity = MIN_CAPACITY)
+    : m_size(0),
+      m_tombstones(0)
+  {
+    m_slots.resize(roundUpCapacity(initialCapacity), Entry{nullptr, V()});
+  }
+
+  /**
+   * @brief エントリを設定
+   * @return 新規追加ならtrue、既存キーの上書きならfalse
+   */
+  bool set(K* key, const V& value) {
+    if (Entry* entry = lookup(key)) {
+      entry->value = value;
+      return false;
+    }
+
+    if ((m_size + m_tombstones + 1) * MAX_LOAD_DEN > m_slots.size() * MAX_LOAD_NUM) {
+      rehash(m_size + 1 > m_slots.size() / 2 ? m_slots.size() * 2 : m_slots.size());
+    }
+
+    insertNew(key, value);
+    return true;
+  }
+
+  V* find(const K* key) {
+    Entry* entry = lookup(key);
+    return entry ? &entry->value : nullptr;
+  }
+
+  const V* find(const K* key) const {
+    const Entry* entry = const_cast<EphemeronTable*>(this)->lookup(key);
+    return entry ? &entry->value : nullptr;
+  }
+
+  bool contains(const K* key) const {
+    return find(key) != nullptr;
+  }
+
+  bool remove(const K* key) {
+    Entry* entry = lookup(key);
+    if (!entry) {
+      return false;
+    }
+    entry->key = tombstone();
+    entry->value = V();
+    m_size--;
+    m_tombstones++;
+    return true;
+  }
+
+  void clear() {
+    std::fill(m_slots.begin(), m_slots.end(), Entry{nullptr, V()});
+    m_size = 0;
+    m_tombstones = 0;
+  }
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  size_t capacity() const { return m_slots.size(); }
+
+  template <typename F>
+  void forEach(F&& fn) const {
+    for (const Entry& entry : m_slots) {
+      if (isOccupied(entry.key)) {
+        fn(entry.key, entry.value);
+      }
+    }
+  }
+
+private:
+  static constexpr size_t MIN_CAPACITY = 16;
+  static constexpr size_t MAX_LOAD_NUM = 3;   // 最大負荷率 3/4（墓標を含む）
+  static constexpr size_t MAX_LOAD_DEN = 4;
+
+  static K* tombstone() {
+    return reinterpret_cast<K*>(static_cast<uintptr_t>(1));
+  }
+
+  static bool isOccupied(const K* key) {
+    return key != nullptr && key != tombstone();
+  }
+
+  static size_t roundUpCapacity(size_t capacity) {
+    size_t result = MIN_CAPACITY;
+    while (result < capacity) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // アドレスの下位ビットは整列で偏るため、フィボナッチハッシュで攪拌する
+  static size_t identityHash(const K* key) {
+    uint64_t x = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)) >> 3;
+    x *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(x ^ (x >> 32));
+  }
+
+  Entry* lookup(const K* key) {
+    if (!key || key == tombstone()) {
+      return nullptr;
+    }
+
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = identityHash(key) & mask;; i = (i + 1) & mask) {
+      Entry& entry = m_slots[i];
+      if (entry.key == nullptr) {
+        return nullptr;
+      }
+      if (entry.key == key) {
+        return &entry;
+      }
+    }
+  }
+
+  void insertNew(K* key, const V& value) {
+    size_t mask = m_slots.size() - 1;
+    for (size_t i = identityHash(key) & mask;; i = (i + 1) & mask) {
+      Entry& entry = m_slots[i];
+      if (!isOccupied(entry.key)) {
+        if (entry.key == tombstone()) {
+          m_tombstones--;
+        }
+        entry.key = key;
+        entry.value = value;
+        m_size++;
+        return;
+      }
+    }
+  }
+
+  void rehash(size_t newCapacity) {
+    std::vector<Entry> old;
+    old.swap(m_slots);
+    m_slots.resize(roundUpCapacity(newCapacity), Entry{nullptr, V()});
+    m_size = 0;
+    m_tombstones = 0;
+
+    for (Entry& entry : old) {
+      if (isOccupied(entry.key)) {
+        insertNew(entry.key, std::move(entry.value));
+      }
+    }
+  }
+
+  std::vector<Entry> m_slots;
+  size_t m_size;
+  size_t m_tombstones;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,168 @@
+/**
+ * @file gc_controller.cpp
+ * @brief 割り当てレートとアイドル時間に基づくGCスケジューラの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "gc_controller.h"
+#include "parallel_gc.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+GCController::GCController(ParallelGC& gc, const GCControllerConfig& config)
+  : m_gc(gc),
+    m_config(config),
+    m_lastSample(std::chrono::steady_clock::now()),
+    m_lastAllocatedBytes(gc.getTotalAllocatedBytes()),
+    m_lastGCTimeMs(0),
+    m_lastMinorGCCount(gc.getStats().minorGCCount),
+    m_allocationRate(0.0),
+    m_mutatorUtilization(1.0),
+    m_minorPauseMs(0.0),
+    m_finalizePauseMs(0.0),
+    m_nurseryTarget(gc.getNurserySize())
+{
+  const auto& stats = gc.getStats();
+  m_lastGCTimeMs = stats.totalMinorGCTimeMs + stats.totalMediumGCTimeMs + stats.totalMajorGCTimeMs;
+
+  // 各コレクションの後で計測し、次のスカベンジまでのナーサリーサイズを決める
+  m_gc.setCollectionCompleteCallback([this]() { update(); });
+}
+
+GCController::~GCController() {
+  m_gc.setCollectionCompleteCallback(nullptr);
+}
+
+double GCController::remainingMs(std::chrono::steady_clock::time_point deadline) {
+  return std::chrono::duration<double, std::milli>(deadline - std::chrono::steady_clock::now()).count();
+}
+
+void GCController::update() {
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  auto now = std::chrono::steady_clock::now();
+  double elapsedMs = std::chrono::duration<double, std::milli>(now - m_lastSample).count();
+  if (elapsedMs < 1.0) {
+    return;
+  }
+
+  const auto& stats = m_gc.getStats();
+  const double alpha = m_config.smoothing;
+
+  // 割り当てレート
+  uint64_t allocated = m_gc.getTotalAllocatedBytes();
+  double rate = static_cast<double>(allocated - m_lastAllocatedBytes) / elapsedMs;
+  m_allocationRate = alpha * rate + (1.0 - alpha) * m_allocationRate;
+
+  // ミューテータ利用率（区間内でGCに使われなかった時間の割合）
+  uint64_t gcTimeMs = stats.totalMinorGCTimeMs + stats.totalMediumGCTimeMs + stats.totalMajorGCTimeMs;
+  double utilization = 1.0 - std::min(1.0, static_cast<double>(gcTimeMs - m_lastGCTimeMs) / elapsedMs);
+  m_mutatorUtilization = alpha * utilization + (1.0 - alpha) * m_mutatorUtilization;
+
+  // マイナーGCの停止時間
+  if (stats.minorGCCount != m_lastMinorGCCount && stats.lastGCType == GCType::Minor) {
+    m_minorPauseMs = alpha * static_cast<double>(stats.lastGCDurationMs) + (1.0 - alpha) * m_minorPauseMs;
+  }
+
+  m_lastSample = now;
+  m_lastAllocatedBytes = allocated;
+  m_lastGCTimeMs = gcTimeMs;
+  m_lastMinorGCCount = stats.minorGCCount;
+
+  resizeYoungGeneration();
+}
+
+void GCController::resizeYoungGeneration() {
+  size_t current = m_gc.getNurserySize();
+
+  // 目標間隔ごとにスカベンジが起きるサイズ
+  double target = m_allocationRate * m_config.targetScavengeIntervalMs;
+
+  // GCに時間を取られすぎていればスカベンジ頻度を下げる
+  if (m_mutatorUtilization < m_config.targetMutatorUtilization) {
+    target = std::max(target, static_cast<double>(current) * 1.5);
+  }
+
+  // 停止時間は生存量に比例するため、長すぎれば縮める
+  if (m_minorPauseMs > m_config.maxMinorPauseMs) {
+    target = std::min(target, static_cast<double>(current) * 0.75);
+  }
+
+  target = std::clamp(target,
+                      static_cast<double>(m_config.minNurserySize),
+                      static_cast<double>(m_config.maxNurserySize));
+  m_nurseryTarget = static_cast<size_t>(target);
+
+  double change = std::abs(target - static_cast<double>(current)) / static_cast<double>(std::max<size_t>(current, 1));
+  if (change >= m_config.resizeHysteresis) {
+    m_gc.setNurserySize(m_nurseryTarget);
+    m_stats.nurseryResizes++;
+  }
+}
+
+void GCController::runMarkingSteps(std::chrono::steady_clock::time_point deadline) {
+  while (remainingMs(deadline) > 0.0) {
+    if (m_gc.isMarkingWorkEmpty()) {
+      // 完了時の停止（ルート再走査とスイープ）が残り時間に収まる場合のみ完了させる
+      if (m_finalizePauseMs <= remainingMs(deadline)) {
+        auto start = std::chrono::steady_clock::now();
+        m_gc.finishIncrementalCollection();
+        double pauseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        m_finalizePauseMs = m_config.smoothing * pauseMs + (1.0 - m_config.smoothing) * m_finalizePauseMs;
+        m_stats.idleFinalizations++;
+      }
+      return;
+    }
+
+    m_gc.incrementalMarkingStep(m_config.idleMarkingStepSize);
+    m_stats.idleMarkingSteps++;
+  }
+}
+
+bool GCController::notifyIdle(std::chrono::steady_clock::time_point deadline) {
+  update();
+
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  m_stats.idleNotifications++;
+
+  auto start = std::chrono::steady_clock::now();
+  if (remainingMs(deadline) * 1000.0 < m_config.minIdleTimeUs) {
+    return m_gc.isIncrementalMarkingActive() || m_gc.hasPendingIdleWork();
+  }
+
+  if (m_gc.isIncrementalMarkingActive()) {
+    // 進行中のマーキングを進める
+    runMarkingSteps(deadline);
+  } else if (m_gc.getNurseryAllocatedBytes() >=
+                 static_cast<size_t>(m_gc.getNurserySize() * m_config.idleScavengeRatio) &&
+             m_minorPauseMs <= remainingMs(deadline)) {
+    // リクエスト処理中に埋まる前に先回りでスカベンジ
+    m_gc.minorCollection(GCCause::Idle);
+    m_stats.idleScavenges++;
+  } else if (m_gc.getHeapUsageRatio() >= m_config.idleMarkingHeapRatio) {
+    // メジャーGCのマーキングをアイドル時間に分割して進める
+    if (m_gc.startIncrementalMarking(GCType::Major, GCCause::Idle)) {
+      runMarkingSteps(deadline);
+    }
+  }
+
+  // 残り時間で保留中のコンパクション
+  if (!m_gc.isIncrementalMarkingActive() && m_gc.hasPendingIdleWork() && remainingMs(deadline) > 0.0) {
+    if (m_gc.performIdleTask(deadline)) {
+      m_stats.idleCompactions++;
+    }
+  }
+
+  m_stats.idleTimeUsedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return m_gc.isIncrementalMarkingActive() || m_gc.hasPendingIdleWork();
+}
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,118 @@
+/**
+ * @file gc_controller.h
+ * @brief 割り当てレートとアイドル時間に基づくGCスケジューラ
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+class ParallelGC;
+
+// GCコントローラ設定
+struct GCControllerConfig {
+  // ナーサリーサイズ調整
+  size_t minNurserySize = 1 * 1024 * 1024;      // 最小ナーサリーサイズ（1MB）
+  size_t maxNurserySize = 64 * 1024 * 1024;     // 最大ナーサリーサイズ（64MB）
+  double targetScavengeIntervalMs = 200.0;      // 目標スカベンジ間隔
+  double targetMutatorUtilization = 0.9;        // 目標ミューテータ利用率
+  double maxMinorPauseMs = 10.0;                // マイナーGCの許容停止時間
+  double resizeHysteresis = 0.1;                // 10%未満の変化は反映しない
+  double smoothing = 0.3;                       // 計測値の指数移動平均係数
+
+  // アイドル時間の使い方
+  float idleScavengeRatio = 0.5f;               // アイドル時にスカベンジするナーサリー充填率
+  float idleMarkingHeapRatio = 0.4f;            // アイドル時にマーキングを開始するヒープ使用率
+  size_t idleMarkingStepSize = 256;             // アイドル時の1ステップのマーキング数
+  uint32_t minIdleTimeUs = 500;                 // これより短いアイドル時間は使わない
+};
+
+// GCコントローラ統計
+struct GCControllerStats {
+  size_t idleNotifications = 0;                 // アイドル通知回数
+  size_t idleScavenges = 0;                     // アイドル時のスカベンジ回数
+  size_t idleMarkingSteps = 0;                  // アイドル時のマーキングステップ数
+  size_t idleFinalizations = 0;                 // アイドル時に完了したマーキングサイクル数
+  size_t idleCompactions = 0;                   // アイドル時のコンパクション回数
+  size_t nurseryResizes = 0;                    // ナーサリーサイズ変更回数
+  double idleTimeUsedMs = 0.0;                  // GCに使ったアイドル時間
+};
+
+/**
+ * @brief ParallelGCの単一スケジューラ
+ *
+ * 割り当てレートとミューテータ利用率（直近区間でGCに止められなかった時間の割合）を
+ * 計測し、スカベンジ間隔が目標に近づくようナーサリーサイズを調整する。
+ * 利用率が目標を下回ればナーサリーを広げ、マイナーGCの停止時間が長すぎれば狭める。
+ *
+ * 組み込み側がアイドル期間（リクエスト間など）を notifyIdle(deadline) で通知すると、
+ * 期限内に収まる見積もりの範囲で、進行中のインクリメンタルマーキングを進め、
+ * 充填の進んだナーサリーを先回りでスカベンジし、ヒープ使用率が高ければ
+ * メジャーGCのマーキングを開始し、残りの時間で保留中のコンパクションを実行する。
+ *
+ * update は ParallelGC の各コレクションの完了時に自動で呼ばれる（構築時に登録し、
+ * 破棄時に外す）。notifyIdle はミューテータスレッドから呼び出す。アイドル処理の中で
+ * 実行したコレクションからも update が呼ばれるため、ロックは再帰可能にしている。
+ */
+class GCController {
+public:
+  explicit GCController(ParallelGC& gc, const GCControllerConfig& config = GCControllerConfig());
+  ~GCController();
+
+  GCController(const GCController&) = delete;
+  GCController& operator=(const GCController&) = delete;
+
+  /**
+   * @brief 割り当てレート・利用率を計測し、ナーサリーサイズを調整（コレクションの完了ごとに呼ばれる）
+   */
+  void update();
+
+  /**
+   * @brief アイドル期間の通知
+   * @param deadline アイドル期間の終了時刻
+   * @return まだアイドル時間で進めたい作業が残っていればtrue
+   */
+  bool notifyIdle(std::chrono::steady_clock::time_point deadline);
+
+  double getAllocationRate() const { return m_allocationRate; }           // バイト/ms
+  double getMutatorUtilization() const { return m_mutatorUtilization; }
+  size_t getYoungGenerationTarget() const { return m_nurseryTarget; }
+  const GCControllerStats& getStats() const { return m_stats; }
+
+private:
+  void resizeYoungGeneration();
+  void runMarkingSteps(std::chrono::steady_clock::time_point deadline);
+  static double remainingMs(std::chrono::steady_clock::time_point deadline);
+
+  ParallelGC& m_gc;
+  GCControllerConfig m_config;
+  GCControllerStats m_stats;
+  std::recursive_mutex m_mutex;
+
+  // 計測区間
+  std::chrono::steady_clock::time_point m_lastSample;
+  uint64_t m_lastAllocatedBytes;
+  uint64_t m_lastGCTimeMs;
+  size_t m_lastMinorGCCount;
+
+  // 指数移動平均
+  double m_allocationRate;       // バイト/ms
+  double m_mutatorUtilization;   // 0.0〜1.0
+  double m_minorPauseMs;         // マイナーGC停止時間
+  double m_finalizePauseMs;      // インクリメンタルサイクル完了時の停止時間
+
+  size_t m_nurseryTarget;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
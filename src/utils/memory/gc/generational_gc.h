@@ -66,6 +66,17 @@ public:
   // GCセルが持つ書き換え可能な参照をすべて辿るメソッド
   virtual void visitMutableReferences(std::function<void(GCCell**)> visitor) = 0;
   
+  // 32ビット圧縮参照のスロットを辿るメソッド（ポインタ圧縮時のみ使用）
+  // visitReferences には展開済みの参照を渡し、移動時の書き換えはこちらで行う
+  virtual void visitCompressedReferences(std::function<void(uint32_t*)> visitor) { (void)visitor; }
+  
+  // コンパクションで移動できるか（relocateTo を実装した型だけが true を返す）
+  virtual bool canRelocate() const { return false; }
+  
+  // destination に自身をムーブ構築して新しいセルを返す（失敗時は nullptr）。
+  // 移動元の破棄と解放は呼び出し側が行う
+  virtual GCCell* relocateTo(void* destination) { (void)destination; return nullptr; }
+  
   CellState state;
   uint8_t age;
   Generation generation;
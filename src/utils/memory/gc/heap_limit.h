@@ -0,0 +1,49 @@
+/**
+ * @file heap_limit.h
+ * @brief ヒープ上限の接近通知と上限超過
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+// ヒープ上限接近コールバックの応答
+struct NearHeapLimitDecision {
+  size_t newLimit = 0;     // 0以外なら上限をこの値へ引き上げる（現在値以下は無視）
+  bool terminate = false;  // 実行の打ち切りを要求する
+};
+
+// GC後も割り当てが上限を超えるときに呼ばれる（used: 使用量, currentLimit: 現在の上限,
+// initialLimit: 最初に設定された上限）。コールバック中の割り当ては上限判定の対象外
+using NearHeapLimitCallback =
+    std::function<NearHeapLimitDecision(size_t used, size_t currentLimit, size_t initialLimit)>;
+
+// ヒープ上限に達した割り当てを中断する例外
+//
+// インタプリタや組み込み関数の catch (const std::exception&) / catch (const std::bad_alloc&)
+// でJSの例外に変換されないよう、std::exception を継承しない。エンジンの評価入口で捕捉する。
+class HeapLimitExceeded {
+public:
+  HeapLimitExceeded(size_t requested, size_t used, size_t limit)
+    : m_requested(requested), m_used(used), m_limit(limit) {}
+  
+  size_t requested() const { return m_requested; }
+  size_t used() const { return m_used; }
+  size_t limit() const { return m_limit; }
+  
+private:
+  size_t m_requested;
+  size_t m_used;
+  size_t m_limit;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,467 @@
+/**
+ * @file heap_snapshot_analyzer.cpp
+ * @brief ヒープスナップショットのオフライン解析の実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "heap_snapshot_analyzer.h"
+#include "heap_snapshot_format.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <utility>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+using namespace heapsnapshot;
+
+namespace {
+
+// 固定長バッファで読み進める入力（ファイル全体をメモリに載せない）
+class SnapshotReader {
+public:
+  explicit SnapshotReader(FILE* file)
+    : m_file(file), m_buffer(64 * 1024), m_pos(0), m_size(0), m_eof(false) {}
+
+  bool readByte(uint8_t& byte) {
+    if (m_pos == m_size && !refill()) {
+      return false;
+    }
+    byte = m_buffer[m_pos++];
+    return true;
+  }
+
+  bool readVarint(uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!readByte(byte)) {
+        return false;
+      }
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool readBytes(void* out, size_t size) {
+    uint8_t* bytes = static_cast<uint8_t*>(out);
+    while (size > 0) {
+      if (m_pos == m_size && !refill()) {
+        return false;
+      }
+      size_t chunk = std::min(size, m_size - m_pos);
+      std::memcpy(bytes, m_buffer.data() + m_pos, chunk);
+      m_pos += chunk;
+      bytes += chunk;
+      size -= chunk;
+    }
+    return true;
+  }
+
+private:
+  bool refill() {
+    if (m_eof) {
+      return false;
+    }
+    m_size = std::fread(m_buffer.data(), 1, m_buffer.size(), m_file);
+    m_pos = 0;
+    if (m_size == 0) {
+      m_eof = true;
+      return false;
+    }
+    return true;
+  }
+
+  FILE* m_file;
+  std::vector<uint8_t> m_buffer;
+  size_t m_pos;
+  size_t m_size;
+  bool m_eof;
+};
+
+bool fail(std::string* error, const char* message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool HeapSnapshotAnalyzer::load(const std::string& filename, std::string* error) {
+  FILE* file = std::fopen(filename.c_str(), "rb");
+  if (!file) {
+    return fail(error, "cannot open snapshot file");
+  }
+
+  struct FileCloser {
+    FILE* file;
+    ~FileCloser() { std::fclose(file); }
+  } closer{file};
+
+  SnapshotReader reader(file);
+
+  char magic[sizeof(kMagic)];
+  uint8_t version[4];
+  if (!reader.readBytes(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+    return fail(error, "not a heap snapshot (bad magic)");
+  }
+  if (!reader.readBytes(version, sizeof(version))) {
+    return fail(error, "truncated header");
+  }
+  uint32_t formatVersion = version[0] | (version[1] << 8) | (version[2] << 16) | (uint32_t(version[3]) << 24);
+  if (formatVersion < kMinFormatVersion || formatVersion > kFormatVersion) {
+    return fail(error, "unsupported snapshot format version");
+  }
+
+  m_nodes.clear();
+  m_typeNames.clear();
+  m_nodes.push_back(Node{0, 0, kNoNode, static_cast<uint8_t>(Space::Unknown)});  // 仮想ルート
+
+  // 参照先はまだ読んでいないノードを指すことがあるため、一旦 id のまま保持する
+  std::vector<uint64_t> rawTargets;
+  std::vector<uint64_t> rawOffsets{0, 0};
+  std::vector<uint64_t> roots;
+  std::vector<std::pair<uint64_t, uint64_t>> extraEdges;  // Edge レコード（元の id, 参照先の id）
+  uint64_t expectedNodes = 0, expectedEdges = 0, expectedRoots = 0;
+  uint64_t lastNodeId = 0;
+  bool sawEnd = false;
+
+  uint8_t tag;
+  while (!sawEnd && reader.readByte(tag)) {
+    switch (static_cast<RecordTag>(tag)) {
+      case RecordTag::TypeName: {
+        uint64_t typeId, length;
+        if (!reader.readVarint(typeId) || !reader.readVarint(length) || length > (1u << 20)) {
+          return fail(error, "corrupt type name record");
+        }
+        std::string name(length, '\0');
+        if (!reader.readBytes(&name[0], length)) {
+          return fail(error, "corrupt type name record");
+        }
+        if (typeId >= m_typeNames.size()) {
+          m_typeNames.resize(typeId + 1);
+        }
+        m_typeNames[typeId] = std::move(name);
+        break;
+      }
+      case RecordTag::Node: {
+        uint64_t idDelta, typeId, selfSize, edgeCount;
+        uint8_t space;
+        if (!reader.readVarint(idDelta) || !reader.readVarint(typeId) || !reader.readVarint(selfSize) ||
+            !reader.readByte(space) || !reader.readVarint(edgeCount)) {
+          return fail(error, "corrupt node record");
+        }
+        uint64_t id = lastNodeId + static_cast<uint64_t>(zigzagDecode(idDelta));
+        lastNodeId = id;
+        for (uint64_t i = 0; i < edgeCount; i++) {
+          uint64_t delta;
+          if (!reader.readVarint(delta)) {
+            return fail(error, "corrupt node record");
+          }
+          rawTargets.push_back(id + static_cast<uint64_t>(zigzagDecode(delta)));
+        }
+        m_nodes.push_back(Node{id, selfSize, static_cast<uint32_t>(typeId), space});
+        rawOffsets.push_back(rawTargets.size());
+        break;
+      }
+      case RecordTag::Root: {
+        uint64_t id;
+        if (!reader.readVarint(id)) {
+          return fail(error, "corrupt root record");
+        }
+        roots.push_back(id);
+        break;
+      }
+      case RecordTag::Edge: {
+        uint64_t from, delta;
+        if (!reader.readVarint(from) || !reader.readVarint(delta)) {
+          return fail(error, "corrupt edge record");
+        }
+        extraEdges.emplace_back(from, from + static_cast<uint64_t>(zigzagDecode(delta)));
+        break;
+      }
+      case RecordTag::End:
+        if (!reader.readVarint(expectedNodes) || !reader.readVarint(expectedEdges) ||
+            !reader.readVarint(expectedRoots)) {
+          return fail(error, "corrupt end record");
+        }
+        sawEnd = true;
+        break;
+      default:
+        return fail(error, "unknown record tag");
+    }
+  }
+
+  if (!sawEnd) {
+    return fail(error, "truncated snapshot (missing end record)");
+  }
+  if (expectedNodes != m_nodes.size() - 1 || expectedEdges != rawTargets.size() + extraEdges.size() ||
+      expectedRoots != roots.size()) {
+    return fail(error, "record counts do not match end record");
+  }
+
+  m_sortedById.resize(m_nodes.size() - 1);
+  for (uint32_t i = 0; i < m_sortedById.size(); i++) {
+    m_sortedById[i] = i + 1;
+  }
+  std::sort(m_sortedById.begin(), m_sortedById.end(),
+            [this](uint32_t a, uint32_t b) { return m_nodes[a].id < m_nodes[b].id; });
+
+  // 追加の辺は元ノードの添字順に並べ、各ノードの辺の後ろに加える
+  std::vector<std::pair<uint32_t, uint32_t>> resolvedExtra;
+  resolvedExtra.reserve(extraEdges.size());
+  for (const auto& edge : extraEdges) {
+    uint32_t from = findNode(edge.first);
+    uint32_t to = findNode(edge.second);
+    if (from != kNoNode && to != kNoNode) {
+      resolvedExtra.emplace_back(from, to);
+    }
+  }
+  std::sort(resolvedExtra.begin(), resolvedExtra.end());
+  size_t nextExtra = 0;
+
+  // id を添字へ解決して CSR を組み立てる（仮想ルートの辺＝ルート集合）
+  m_edgeOffsets.assign(1, 0);
+  m_edgeTargets.clear();
+  m_edgeTargets.reserve(roots.size() + rawTargets.size() + resolvedExtra.size());
+  for (uint64_t root : roots) {
+    uint32_t index = findNode(root);
+    if (index != kNoNode) {
+      m_edgeTargets.push_back(index);
+    }
+  }
+  m_edgeOffsets.push_back(m_edgeTargets.size());
+
+  for (size_t n = 1; n < m_nodes.size(); n++) {
+    for (uint64_t e = rawOffsets[n]; e < rawOffsets[n + 1]; e++) {
+      uint32_t index = findNode(rawTargets[e]);
+      if (index != kNoNode) {
+        m_edgeTargets.push_back(index);
+      }
+    }
+    for (; nextExtra < resolvedExtra.size() && resolvedExtra[nextExtra].first == n; nextExtra++) {
+      m_edgeTargets.push_back(resolvedExtra[nextExtra].second);
+    }
+    m_edgeOffsets.push_back(m_edgeTargets.size());
+  }
+
+  m_dfsOrder.clear();
+  m_dominators.assign(m_nodes.size(), kNoNode);
+  m_retainedSizes.assign(m_nodes.size(), 0);
+  m_retainerParents.assign(m_nodes.size(), kNoNode);
+  return true;
+}
+
+const std::string& HeapSnapshotAnalyzer::typeName(uint32_t typeId) const {
+  static const std::string unknown = "(unknown)";
+  static const std::string root = "(roots)";
+  if (typeId == kNoNode) {
+    return root;
+  }
+  return typeId < m_typeNames.size() ? m_typeNames[typeId] : unknown;
+}
+
+uint32_t HeapSnapshotAnalyzer::findNode(uint64_t id) const {
+  auto it = std::lower_bound(m_sortedById.begin(), m_sortedById.end(), id,
+                             [this](uint32_t index, uint64_t key) { return m_nodes[index].id < key; });
+  if (it != m_sortedById.end() && m_nodes[*it].id == id) {
+    return *it;
+  }
+  return kNoNode;
+}
+
+void HeapSnapshotAnalyzer::analyze() {
+  computeDominators();
+  computeRetainedSizes();
+  computeRetainerTree();
+}
+
+// Lengauer-Tarjan法（単純版: 経路圧縮のみ）。
+// 数百万ノードのグラフで再帰が溢れないよう、DFSと経路圧縮は明示的なスタックで行う。
+// 内部では DFS 番号で計算し、最後にノード添字へ戻す。
+void HeapSnapshotAnalyzer::computeDominators() {
+  const uint32_t n = static_cast<uint32_t>(m_nodes.size());
+  std::vector<uint32_t> dfnum(n, kNoNode);
+  std::vector<uint32_t> parent;  // DFS番号 → 親のDFS番号
+  m_dfsOrder.clear();
+  m_dfsOrder.reserve(n);
+  parent.reserve(n);
+
+  struct Frame {
+    uint32_t node;
+    uint64_t nextEdge;
+  };
+  std::vector<Frame> stack;
+  dfnum[kSuperRoot] = 0;
+  m_dfsOrder.push_back(kSuperRoot);
+  parent.push_back(kNoNode);
+  stack.push_back(Frame{kSuperRoot, m_edgeOffsets[kSuperRoot]});
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    if (frame.nextEdge == m_edgeOffsets[frame.node + 1]) {
+      stack.pop_back();
+      continue;
+    }
+    uint32_t target = m_edgeTargets[frame.nextEdge++];
+    if (dfnum[target] != kNoNode) {
+      continue;
+    }
+    dfnum[target] = static_cast<uint32_t>(m_dfsOrder.size());
+    m_dfsOrder.push_back(target);
+    parent.push_back(dfnum[frame.node]);
+    stack.push_back(Frame{target, m_edgeOffsets[target]});
+  }
+
+  const uint32_t reached = static_cast<uint32_t>(m_dfsOrder.size());
+
+  // 到達ノード間の逆辺（DFS番号で保持）
+  std::vector<uint32_t> predOffsets(reached + 1, 0);
+  for (uint32_t v = 0; v < reached; v++) {
+    uint32_t node = m_dfsOrder[v];
+    for (uint64_t e = m_edgeOffsets[node]; e < m_edgeOffsets[node + 1]; e++) {
+      predOffsets[dfnum[m_edgeTargets[e]] + 1]++;
+    }
+  }
+  for (uint32_t v = 0; v < reached; v++) {
+    predOffsets[v + 1] += predOffsets[v];
+  }
+  std::vector<uint32_t> preds(predOffsets[reached]);
+  {
+    std::vector<uint32_t> fill(predOffsets.begin(), predOffsets.end() - 1);
+    for (uint32_t v = 0; v < reached; v++) {
+      uint32_t node = m_dfsOrder[v];
+      for (uint64_t e = m_edgeOffsets[node]; e < m_edgeOffsets[node + 1]; e++) {
+        preds[fill[dfnum[m_edgeTargets[e]]]++] = v;
+      }
+    }
+  }
+
+  std::vector<uint32_t> semi(reached), label(reached), ancestor(reached, kNoNode), idom(reached, kNoNode);
+  for (uint32_t v = 0; v < reached; v++) {
+    semi[v] = v;
+    label[v] = v;
+  }
+
+  // バケットは単方向リスト（先頭・次）で表す
+  std::vector<uint32_t> bucketHead(reached, kNoNode), bucketNext(reached, kNoNode);
+  std::vector<uint32_t> path;
+
+  auto eval = [&](uint32_t v) -> uint32_t {
+    if (ancestor[v] == kNoNode) {
+      return v;
+    }
+    path.clear();
+    for (uint32_t u = v; ancestor[ancestor[u]] != kNoNode; u = ancestor[u]) {
+      path.push_back(u);
+    }
+    while (!path.empty()) {
+      uint32_t u = path.back();
+      path.pop_back();
+      uint32_t a = ancestor[u];
+      if (semi[label[a]] < semi[label[u]]) {
+        label[u] = label[a];
+      }
+      ancestor[u] = ancestor[a];
+    }
+    return label[v];
+  };
+
+  for (uint32_t w = reached - 1; w > 0; w--) {
+    for (uint32_t p = predOffsets[w]; p < predOffsets[w + 1]; p++) {
+      uint32_t u = eval(preds[p]);
+      if (semi[u] < semi[w]) {
+        semi[w] = semi[u];
+      }
+    }
+    bucketNext[w] = bucketHead[semi[w]];
+    bucketHead[semi[w]] = w;
+    ancestor[w] = parent[w];
+
+    uint32_t p = parent[w];
+    for (uint32_t v = bucketHead[p]; v != kNoNode; v = bucketNext[v]) {
+      uint32_t u = eval(v);
+      idom[v] = semi[u] < semi[v] ? u : p;
+    }
+    bucketHead[p] = kNoNode;
+  }
+
+  for (uint32_t w = 1; w < reached; w++) {
+    if (idom[w] != semi[w]) {
+      idom[w] = idom[idom[w]];
+    }
+  }
+
+  m_dominators.assign(n, kNoNode);
+  for (uint32_t w = 1; w < reached; w++) {
+    m_dominators[m_dfsOrder[w]] = m_dfsOrder[idom[w]];
+  }
+}
+
+// 直接支配ノードは必ず DFS 順で先に現れるため、逆順に畳み込めば部分木の合計になる
+void HeapSnapshotAnalyzer::computeRetainedSizes() {
+  m_retainedSizes.assign(m_nodes.size(), 0);
+  for (uint32_t node : m_dfsOrder) {
+    m_retainedSizes[node] = m_nodes[node].selfSize;
+  }
+  for (size_t i = m_dfsOrder.size(); i-- > 1;) {
+    uint32_t node = m_dfsOrder[i];
+    m_retainedSizes[m_dominators[node]] += m_retainedSizes[node];
+  }
+}
+
+void HeapSnapshotAnalyzer::computeRetainerTree() {
+  m_retainerParents.assign(m_nodes.size(), kNoNode);
+  std::vector<bool> visited(m_nodes.size(), false);
+  std::queue<uint32_t> queue;
+  visited[kSuperRoot] = true;
+  queue.push(kSuperRoot);
+  while (!queue.empty()) {
+    uint32_t node = queue.front();
+    queue.pop();
+    for (uint64_t e = m_edgeOffsets[node]; e < m_edgeOffsets[node + 1]; e++) {
+      uint32_t target = m_edgeTargets[e];
+      if (!visited[target]) {
+        visited[target] = true;
+        m_retainerParents[target] = node;
+        queue.push(target);
+      }
+    }
+  }
+}
+
+std::vector<uint32_t> HeapSnapshotAnalyzer::shortestRetainerPath(uint32_t index) const {
+  std::vector<uint32_t> path;
+  if (index == kSuperRoot || index >= m_nodes.size() || m_retainerParents[index] == kNoNode) {
+    return path;
+  }
+  for (uint32_t node = index; node != kSuperRoot; node = m_retainerParents[node]) {
+    path.push_back(node);
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+std::vector<uint32_t> HeapSnapshotAnalyzer::topRetainers(size_t count) const {
+  std::vector<uint32_t> result;
+  for (size_t i = 1; i < m_dfsOrder.size(); i++) {
+    result.push_back(m_dfsOrder[i]);
+  }
+  count = std::min(count, result.size());
+  std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                    [this](uint32_t a, uint32_t b) { return m_retainedSizes[a] > m_retainedSizes[b]; });
+  result.resize(count);
+  return result;
+}
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,94 @@
+/**
+ * @file heap_snapshot_analyzer.h
+ * @brief ヒープスナップショットのオフライン解析（支配木・保持サイズ・保持経路）
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+/**
+ * @brief 読み込んだスナップショットのグラフと解析結果
+ *
+ * ノードは読み込み順の添字で扱い、添字0は全ルートを束ねる仮想ルート。
+ * 辺は CSR 形式（edgeOffsets/edgeTargets）で保持する。
+ * スナップショット内に存在しない参照先への辺は読み込み時に捨てる。
+ *
+ * analyze() で以下を計算する:
+ *   - 直接支配ノード（Lengauer-Tarjan法、再帰を使わない実装）
+ *   - 保持サイズ（支配木の部分木の自己サイズ合計）
+ *   - 最短保持経路（仮想ルートからの幅優先探索木）
+ * ルートから到達不能なノード（取得時点でゴミだったもの）は支配ノードを持たない。
+ */
+class HeapSnapshotAnalyzer {
+public:
+  static constexpr uint32_t kNoNode = UINT32_MAX;
+  static constexpr uint32_t kSuperRoot = 0;
+
+  struct Node {
+    uint64_t id;
+    uint64_t selfSize;
+    uint32_t typeId;
+    uint8_t space;
+  };
+
+  /**
+   * @brief スナップショットファイルを読み込む
+   * @param error 失敗時の理由
+   */
+  bool load(const std::string& filename, std::string* error = nullptr);
+
+  void analyze();
+
+  size_t nodeCount() const { return m_nodes.size(); }
+  size_t edgeCount() const { return m_edgeTargets.size(); }
+  size_t rootCount() const { return m_edgeOffsets.size() > 1 ? m_edgeOffsets[1] : 0; }
+
+  const Node& node(uint32_t index) const { return m_nodes[index]; }
+  const std::string& typeName(uint32_t typeId) const;
+
+  uint32_t findNode(uint64_t id) const;
+  bool isReachable(uint32_t index) const { return m_dominators[index] != kNoNode || index == kSuperRoot; }
+
+  uint32_t dominator(uint32_t index) const { return m_dominators[index]; }
+  uint64_t retainedSize(uint32_t index) const { return m_retainedSizes[index]; }
+
+  /**
+   * @brief 仮想ルートから対象までの最短参照経路（仮想ルートは含まない）
+   * @return 到達不能なら空
+   */
+  std::vector<uint32_t> shortestRetainerPath(uint32_t index) const;
+
+  /**
+   * @brief 保持サイズの大きい順に上位ノードを返す（仮想ルートを除く）
+   */
+  std::vector<uint32_t> topRetainers(size_t count) const;
+
+private:
+  void computeDominators();
+  void computeRetainedSizes();
+  void computeRetainerTree();
+
+  std::vector<Node> m_nodes;
+  std::vector<std::string> m_typeNames;
+  std::vector<uint64_t> m_edgeOffsets;   // ノードごとの辺の開始位置（末尾に番兵）
+  std::vector<uint32_t> m_edgeTargets;
+  std::vector<uint32_t> m_sortedById;    // id 検索用の添字（id昇順）
+
+  std::vector<uint32_t> m_dfsOrder;      // 仮想ルートからの深さ優先順
+  std::vector<uint32_t> m_dominators;
+  std::vector<uint64_t> m_retainedSizes;
+  std::vector<uint32_t> m_retainerParents;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
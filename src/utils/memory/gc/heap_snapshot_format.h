@@ -0,0 +1,92 @@
+/**
+ * @file heap_snapshot_format.h
+ * @brief ストリーミングヒープスナップショットのバイナリ形式
+ * @version 1.0.0
+ * @license MIT
+ *
+ * ファイル構成:
+ *   ヘッダ   : マジック "AJSHEAP1"（8バイト） + 形式バージョン（u32 LE）
+ *   レコード : 1バイトのタグに続く可変長整数（LEB128）の列
+ *     TypeName : typeId, 名前長, 名前バイト列（ノードより前に1度だけ出力）
+ *     Node     : id, typeId, selfSize, space(u8), 辺数, 各辺の参照先
+ *                （id は直前のノードの id との差分、参照先は自身の id との差分を
+ *                  ジグザグ符号化して格納）
+ *     Root     : id
+ *     Edge     : 元の id, 参照先（元の id との差分をジグザグ符号化）
+ *                （visitReferences に現れない追加の辺。エフェメロンのキー→値など。
+ *                  ノードより後に出力し、元ノードの辺に加える。形式バージョン2から）
+ *     End      : ノード数, 辺数, ルート数（途中で切れたファイルの検出用）
+ *
+ * id はスナップショット取得時点のセルアドレス。書き込み側は対応表を持たないため、
+ * 追加メモリはバッファと型名表のみで済む。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+namespace heapsnapshot {
+
+constexpr char kMagic[8] = {'A', 'J', 'S', 'H', 'E', 'A', 'P', '1'};
+constexpr uint32_t kFormatVersion = 2;
+// Edge レコードを持たない以前の形式（読み込みのみ対応）
+constexpr uint32_t kMinFormatVersion = 1;
+
+enum class RecordTag : uint8_t {
+  TypeName = 1,
+  Node = 2,
+  Root = 3,
+  Edge = 4,
+  End = 0xFF
+};
+
+// ノードが属していた領域（ParallelGCの世代に対応）
+enum class Space : uint8_t {
+  Nursery = 0,
+  Young = 1,
+  Medium = 2,
+  Old = 3,
+  Large = 4,
+  Unknown = 0xFF
+};
+
+inline const char* spaceName(uint8_t space) {
+  switch (static_cast<Space>(space)) {
+    case Space::Nursery: return "nursery";
+    case Space::Young: return "young";
+    case Space::Medium: return "medium";
+    case Space::Old: return "old";
+    case Space::Large: return "large";
+    default: return "unknown";
+  }
+}
+
+// 可変長整数（LEB128）の最大長
+constexpr size_t kMaxVarintBytes = 10;
+
+inline size_t encodeVarint(uint64_t value, uint8_t* out) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = static_cast<uint8_t>(value) | 0x80;
+    value >>= 7;
+  }
+  out[n++] = static_cast<uint8_t>(value);
+  return n;
+}
+
+inline uint64_t zigzagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}  // namespace heapsnapshot
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
@@ -0,0 +1,206 @@
+/**
+ * @file heap_snapshot_writer.cpp
+ * @brief ヒープスナップショットの逐次書き出しの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "heap_snapshot_writer.h"
+#include "generational_gc.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <typeinfo>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+using namespace heapsnapshot;
+
+namespace {
+
+std::string demangle(const char* name) {
+#if defined(__GNUG__)
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+  }
+#endif
+  return name;
+}
+
+}  // namespace
+
+HeapSnapshotWriter::HeapSnapshotWriter()
+  : m_file(nullptr),
+    m_failed(false),
+    m_buffer(kBufferSize),
+    m_used(0),
+    m_lastNodeId(0),
+    m_nodeCount(0),
+    m_edgeCount(0),
+    m_rootCount(0),
+    m_bytesWritten(0)
+{
+}
+
+HeapSnapshotWriter::~HeapSnapshotWriter() {
+  if (m_file) {
+    std::fclose(m_file);
+  }
+}
+
+bool HeapSnapshotWriter::open(const std::string& filename) {
+  m_file = std::fopen(filename.c_str(), "wb");
+  if (!m_file) {
+    return false;
+  }
+
+  putBytes(kMagic, sizeof(kMagic));
+  uint8_t version[4];
+  for (int i = 0; i < 4; i++) {
+    version[i] = static_cast<uint8_t>(kFormatVersion >> (i * 8));
+  }
+  putBytes(version, sizeof(version));
+  return true;
+}
+
+void HeapSnapshotWriter::writeNode(GCCell* cell, Space space) {
+  if (!cell) {
+    return;
+  }
+
+  uint32_t typeId = internType(cell);
+
+  m_edges.clear();
+  cell->visitReferences([this](GCCell* target) {
+    if (target) {
+      m_edges.push_back(reinterpret_cast<uintptr_t>(target));
+    }
+  });
+
+  uintptr_t id = reinterpret_cast<uintptr_t>(cell);
+  putByte(static_cast<uint8_t>(RecordTag::Node));
+  // 同じ世代のセルは近接して並ぶため、id も直前のノードとの差分で格納する
+  putVarint(zigzagEncode(static_cast<int64_t>(id - m_lastNodeId)));
+  putVarint(typeId);
+  putVarint(cell->getSize());
+  putByte(static_cast<uint8_t>(space));
+  putVarint(m_edges.size());
+  for (uintptr_t target : m_edges) {
+    // 参照先は近傍に割り当てられていることが多いため、差分で格納する
+    putVarint(zigzagEncode(static_cast<int64_t>(target - id)));
+  }
+  m_lastNodeId = id;
+
+  m_nodeCount++;
+  m_edgeCount += m_edges.size();
+}
+
+void HeapSnapshotWriter::writeRoot(const GCCell* cell) {
+  if (!cell) {
+    return;
+  }
+  putByte(static_cast<uint8_t>(RecordTag::Root));
+  putVarint(reinterpret_cast<uintptr_t>(cell));
+  m_rootCount++;
+}
+
+void HeapSnapshotWriter::writeEdge(const GCCell* from, const GCCell* to) {
+  if (!from || !to) {
+    return;
+  }
+  uintptr_t id = reinterpret_cast<uintptr_t>(from);
+  putByte(static_cast<uint8_t>(RecordTag::Edge));
+  putVarint(id);
+  putVarint(zigzagEncode(static_cast<int64_t>(reinterpret_cast<uintptr_t>(to) - id)));
+  m_edgeCount++;
+}
+
+bool HeapSnapshotWriter::finish() {
+  if (!m_file) {
+    return false;
+  }
+
+  putByte(static_cast<uint8_t>(RecordTag::End));
+  putVarint(m_nodeCount);
+  putVarint(m_edgeCount);
+  putVarint(m_rootCount);
+  flush();
+
+  if (std::fclose(m_file) != 0) {
+    m_failed = true;
+  }
+  m_file = nullptr;
+  return !m_failed;
+}
+
+uint32_t HeapSnapshotWriter::internType(const GCCell* cell) {
+  std::type_index type(typeid(*cell));
+  auto it = m_typeIds.find(type);
+  if (it != m_typeIds.end()) {
+    return it->second;
+  }
+
+  uint32_t typeId = static_cast<uint32_t>(m_typeIds.size());
+  m_typeIds.emplace(type, typeId);
+
+  std::string name = demangle(type.name());
+  putByte(static_cast<uint8_t>(RecordTag::TypeName));
+  putVarint(typeId);
+  putVarint(name.size());
+  putBytes(name.data(), name.size());
+  return typeId;
+}
+
+void HeapSnapshotWriter::putByte(uint8_t byte) {
+  if (m_used == m_buffer.size()) {
+    flush();
+  }
+  m_buffer[m_used++] = byte;
+}
+
+void HeapSnapshotWriter::putVarint(uint64_t value) {
+  if (m_used + kMaxVarintBytes > m_buffer.size()) {
+    flush();
+  }
+  m_used += encodeVarint(value, m_buffer.data() + m_used);
+}
+
+void HeapSnapshotWriter::putBytes(const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    if (m_used == m_buffer.size()) {
+      flush();
+    }
+    size_t chunk = std::min(size, m_buffer.size() - m_used);
+    std::memcpy(m_buffer.data() + m_used, bytes, chunk);
+    m_used += chunk;
+    bytes += chunk;
+    size -= chunk;
+  }
+}
+
+void HeapSnapshotWriter::flush() {
+  if (m_used == 0) {
+    return;
+  }
+  if (!m_file || std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used) {
+    m_failed = true;
+  }
+  m_bytesWritten += m_used;
+  m_used = 0;
+}
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
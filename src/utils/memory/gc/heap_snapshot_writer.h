@@ -0,0 +1,97 @@
+/**
+ * @file heap_snapshot_writer.h
+ * @brief ヒープスナップショットの逐次書き出し
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "heap_snapshot_format.h"
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+class GCCell;
+
+/**
+ * @brief ヒープスナップショットライタ
+ *
+ * ノードとその辺を走査順にそのまま固定長バッファへ符号化し、満杯になるたびに
+ * ファイルへ書き出す。ヒープ全体の複製や id 対応表は作らないため、
+ * 追加メモリはバッファ・型名表・1ノード分の辺リストに抑えられる。
+ * visitReferences に現れない辺は、ノードを書いた後に writeEdge で1本ずつ書く。
+ * 形式は heap_snapshot_format.h を参照。
+ */
+class HeapSnapshotWriter {
+public:
+  static constexpr size_t kBufferSize = 64 * 1024;
+
+  HeapSnapshotWriter();
+  ~HeapSnapshotWriter();
+
+  HeapSnapshotWriter(const HeapSnapshotWriter&) = delete;
+  HeapSnapshotWriter& operator=(const HeapSnapshotWriter&) = delete;
+
+  /**
+   * @brief 出力先を開いてヘッダを書く
+   */
+  bool open(const std::string& filename);
+
+  /**
+   * @brief セルと、そのセルから visitReferences で辿れる参照をすべて書き出す
+   */
+  void writeNode(GCCell* cell, heapsnapshot::Space space);
+
+  void writeRoot(const GCCell* cell);
+
+  /**
+   * @brief visitReferences に現れない追加の辺（エフェメロンのキー→値など）を書き出す
+   */
+  void writeEdge(const GCCell* from, const GCCell* to);
+
+  /**
+   * @brief 終端レコードを書いて閉じる
+   * @return 全書き込みが成功した場合true
+   */
+  bool finish();
+
+  uint64_t nodeCount() const { return m_nodeCount; }
+  uint64_t edgeCount() const { return m_edgeCount; }
+  uint64_t bytesWritten() const { return m_bytesWritten; }
+
+private:
+  uint32_t internType(const GCCell* cell);
+
+  void putByte(uint8_t byte);
+  void putVarint(uint64_t value);
+  void putBytes(const void* data, size_t size);
+  void flush();
+
+  FILE* m_file;
+  bool m_failed;
+  std::vector<uint8_t> m_buffer;
+  size_t m_used;
+
+  std::unordered_map<std::type_index, uint32_t> m_typeIds;
+  std::vector<uintptr_t> m_edges;  // 1ノード分の作業領域（再利用）
+
+  uintptr_t m_lastNodeId;
+
+  uint64_t m_nodeCount;
+  uint64_t m_edgeCount;
+  uint64_t m_rootCount;
+  uint64_t m_bytesWritten;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,145 @@
+/**
+ * @file large_object_space.cpp
+ * @brief 大きいオブジェクト専用領域の実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "large_object_space.h"
+#ifdef AEROJS_POINTER_COMPRESSION
+#include "../allocators/heap_cage.h"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+LargeObjectSpace::LargeObjectSpace()
+  : m_objectBytes(0),
+    m_committedBytes(0)
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  m_pageSize = info.dwPageSize;
+#else
+  m_pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+LargeObjectSpace::~LargeObjectSpace() {
+  // 生存中のオブジェクトはGC側で破棄済み。マッピングだけを返却する
+  for (const auto& [start, mapping] : m_mappings) {
+#ifdef AEROJS_POINTER_COMPRESSION
+    HeapCage::instance().releaseRegion(reinterpret_cast<void*>(start), mapping.mappedSize);
+#elif defined(_WIN32)
+    VirtualFree(reinterpret_cast<void*>(start), 0, MEM_RELEASE);
+#else
+    munmap(reinterpret_cast<void*>(start), mapping.mappedSize);
+#endif
+  }
+}
+
+void* LargeObjectSpace::allocate(size_t size) {
+  size_t mappedSize = (size + m_pageSize - 1) & ~(m_pageSize - 1);
+
+#ifdef AEROJS_POINTER_COMPRESSION
+  // 圧縮参照の参照先となるため、ケージ内の領域を使う
+  mappedSize = (size + HeapCage::kGranularity - 1) & ~(HeapCage::kGranularity - 1);
+  void* memory = HeapCage::instance().allocateRegion(mappedSize);
+#elif defined(_WIN32)
+  void* memory = VirtualAlloc(nullptr, mappedSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  void* memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    memory = nullptr;
+  }
+#endif
+  if (!memory) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_mappings.emplace(reinterpret_cast<uintptr_t>(memory), Mapping{size, mappedSize});
+  m_objectBytes += size;
+  m_committedBytes += mappedSize;
+  return memory;
+}
+
+size_t LargeObjectSpace::release(void* object) {
+  size_t mappedSize = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_mappings.find(reinterpret_cast<uintptr_t>(object));
+    if (it == m_mappings.end()) {
+      return 0;
+    }
+    mappedSize = it->second.mappedSize;
+    m_objectBytes -= it->second.objectSize;
+    m_committedBytes -= mappedSize;
+    m_mappings.erase(it);
+  }
+
+#ifdef AEROJS_POINTER_COMPRESSION
+  HeapCage::instance().releaseRegion(object, mappedSize);
+#elif defined(_WIN32)
+  VirtualFree(object, 0, MEM_RELEASE);
+#else
+  munmap(object, mappedSize);
+#endif
+  return mappedSize;
+}
+
+const LargeObjectSpace::Mapping* LargeObjectSpace::findMapping(uintptr_t addr, uintptr_t& start) const {
+  auto it = m_mappings.upper_bound(addr);
+  if (it == m_mappings.begin()) {
+    return nullptr;
+  }
+  --it;
+  if (addr >= it->first + it->second.objectSize) {
+    return nullptr;
+  }
+  start = it->first;
+  return &it->second;
+}
+
+bool LargeObjectSpace::contains(const void* ptr) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  uintptr_t start = 0;
+  return findMapping(reinterpret_cast<uintptr_t>(ptr), start) != nullptr;
+}
+
+void* LargeObjectSpace::objectStart(const void* ptr) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  uintptr_t start = 0;
+  if (!findMapping(reinterpret_cast<uintptr_t>(ptr), start)) {
+    return nullptr;
+  }
+  return reinterpret_cast<void*>(start);
+}
+
+size_t LargeObjectSpace::objectCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_mappings.size();
+}
+
+size_t LargeObjectSpace::objectBytes() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_objectBytes;
+}
+
+size_t LargeObjectSpace::committedBytes() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_committedBytes;
+}
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
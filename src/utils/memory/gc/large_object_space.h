@@ -0,0 +1,75 @@
+/**
+ * @file large_object_space.h
+ * @brief 大きいオブジェクト専用領域（オブジェクトごとの独立マッピング）
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+/**
+ * @brief 大きいオブジェクト空間
+ *
+ * しきい値以上のオブジェクト（大きな配列、ArrayBuffer、長いフラット文字列など）に
+ * ページ境界に揃えた専用マッピングを1つずつ割り当てる。
+ * オブジェクトはスカベンジやコンパクションで移動せずその場でマークされ、
+ * 死んだ時点でマッピングごとOSへ返却される（munmap）。
+ */
+class LargeObjectSpace {
+public:
+  LargeObjectSpace();
+  ~LargeObjectSpace();
+
+  LargeObjectSpace(const LargeObjectSpace&) = delete;
+  LargeObjectSpace& operator=(const LargeObjectSpace&) = delete;
+
+  /**
+   * @brief 専用マッピングを確保
+   * @param size オブジェクトサイズ
+   * @return ページ境界に揃った先頭アドレス（失敗時はnullptr）
+   */
+  void* allocate(size_t size);
+
+  /**
+   * @brief マッピングをOSへ返却（デストラクタは呼び出し側で実行済みであること）
+   * @return 返却したバイト数（この空間のオブジェクトでなければ0）
+   */
+  size_t release(void* object);
+
+  // ptrがいずれかのオブジェクト内部を指すか（内部ポインタ可）
+  bool contains(const void* ptr) const;
+
+  // 内部ポインタからオブジェクト先頭を求める（見つからなければnullptr）
+  void* objectStart(const void* ptr) const;
+
+  size_t objectCount() const;
+  size_t objectBytes() const;
+  size_t committedBytes() const;
+
+private:
+  struct Mapping {
+    size_t objectSize;   // 要求サイズ
+    size_t mappedSize;   // ページ単位に切り上げたマッピング長
+  };
+
+  const Mapping* findMapping(uintptr_t addr, uintptr_t& start) const;
+
+  mutable std::mutex m_mutex;
+  std::map<uintptr_t, Mapping> m_mappings;  // 先頭アドレス順
+  size_t m_objectBytes;
+  size_t m_committedBytes;
+  size_t m_pageSize;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,291 @@
+/**
+ * @file mark_compact.cpp
+ * @brief オールド世代向けマーク・コンパクトの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "mark_compact.h"
+#include "card_table.h"
+#ifdef AEROJS_POINTER_COMPRESSION
+#include "../allocators/heap_cage.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+MarkCompactor::MarkCompactor(const Config& config)
+  : m_config(config),
+    m_pendingBytes(0)
+{
+  if (m_config.pageSize == 0 || (m_config.pageSize & (m_config.pageSize - 1)) != 0) {
+    // ページサイズは2のべき乗に限定
+    m_config.pageSize = 256 * 1024;
+  }
+  if (m_config.workerCount == 0) {
+    m_config.workerCount = 1;
+  }
+}
+
+size_t MarkCompactor::selectCandidates(const std::vector<GCCell*>& oldGen) {
+  m_candidates.clear();
+  m_unusedDestinations.clear();
+  m_pendingBytes = 0;
+  m_result = CompactionResult{};
+
+  const uintptr_t pageMask = ~static_cast<uintptr_t>(m_config.pageSize - 1);
+
+  // ページごとに生存セルを集計（std::mapでページアドレス順を維持）
+  std::map<uintptr_t, EvacuationCandidate> pages;
+  for (GCCell* cell : oldGen) {
+    if (!cell) continue;
+    uintptr_t page = reinterpret_cast<uintptr_t>(cell) & pageMask;
+    auto& entry = pages[page];
+    entry.pageStart = page;
+    size_t size = cell->getSize();
+    entry.liveBytes += size;
+    if (size < m_config.largeObjectThreshold && cell->canRelocate()) {
+      entry.cells.push_back(cell);
+    } else {
+      // 大きいセルと移動に対応しない型のセルはページに残るため退避量には含めない
+      entry.pinnedBytes += size;
+    }
+  }
+
+  std::vector<EvacuationCandidate> fragmented;
+  for (auto& [page, entry] : pages) {
+    // ページ境界を跨ぐセルは生存率が1を超えうるため丸める
+    float liveRatio = std::min(1.0f, static_cast<float>(entry.liveBytes) /
+                                     static_cast<float>(m_config.pageSize));
+    entry.fragmentation = 1.0f - liveRatio;
+    if (entry.fragmentation >= m_config.fragmentationThreshold) {
+      fragmented.push_back(std::move(entry));
+    }
+  }
+
+  // 最も断片化したページを優先し、退避上限まで選ぶ
+  std::sort(fragmented.begin(), fragmented.end(),
+            [](const EvacuationCandidate& a, const EvacuationCandidate& b) {
+              return a.fragmentation > b.fragmentation;
+            });
+
+  for (auto& candidate : fragmented) {
+    candidate.liveBytes -= candidate.pinnedBytes;
+    if (candidate.cells.empty()) {
+      continue;
+    }
+    if (m_pendingBytes + candidate.liveBytes > m_config.maxEvacuationBytes &&
+        !m_candidates.empty()) {
+      break;
+    }
+    std::sort(candidate.cells.begin(), candidate.cells.end());
+    m_pendingBytes += candidate.liveBytes;
+    m_candidates.push_back(std::move(candidate));
+  }
+
+  m_result.candidatePages = m_candidates.size();
+  return m_candidates.size();
+}
+
+void MarkCompactor::evacuate(const AllocateFn& allocate) {
+  std::atomic<size_t> evacuatedObjects{0};
+  std::atomic<size_t> evacuatedBytes{0};
+  std::atomic<size_t> abortedPages{0};
+
+  parallelFor(m_candidates.size(), [&](size_t index) {
+    auto& candidate = m_candidates[index];
+
+    // 退避先はセルごとに確保する（release で退避元とともにセル単位で解放されるため、
+    // 複数セルを1つの確保にまとめてはならない）。ロックはページにつき1回だけ取る
+    std::vector<uint8_t*> destinations(candidate.cells.size(), nullptr);
+    {
+      std::lock_guard<std::mutex> lock(m_allocateMutex);
+      for (size_t i = 0; i < candidate.cells.size(); ++i) {
+        destinations[i] = static_cast<uint8_t*>(allocate(candidate.cells[i]->getSize()));
+        if (!destinations[i]) {
+          break;
+        }
+      }
+    }
+
+    // アドレス順に退避先へムーブ構築（確保できなかったセル以降はページに残す）
+    size_t localObjects = 0;
+    size_t localBytes = 0;
+    std::vector<std::pair<void*, size_t>> unused;
+    for (size_t i = 0; i < candidate.cells.size() && destinations[i]; ++i) {
+      GCCell* cell = candidate.cells[i];
+      size_t size = cell->getSize();
+
+      GCCell* newCell = cell->relocateTo(destinations[i]);
+      if (!newCell) {
+        // 移動を断ったセルはページに残し、退避先は release で返す
+        unused.emplace_back(destinations[i], size);
+        continue;
+      }
+      newCell->forwardingAddress = nullptr;
+      cell->forwardingAddress = newCell;
+
+      localObjects++;
+      localBytes += size;
+    }
+
+    if (localObjects < candidate.cells.size()) {
+      // 退避先が尽きたか移動を断ったセルがあれば、そのセルは移動しない
+      abortedPages.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!unused.empty()) {
+      std::lock_guard<std::mutex> lock(m_allocateMutex);
+      m_unusedDestinations.insert(m_unusedDestinations.end(), unused.begin(), unused.end());
+    }
+
+    evacuatedObjects.fetch_add(localObjects, std::memory_order_relaxed);
+    evacuatedBytes.fetch_add(localBytes, std::memory_order_relaxed);
+  });
+
+  m_result.evacuatedObjects = evacuatedObjects.load();
+  m_result.evacuatedBytes = evacuatedBytes.load();
+  m_result.abortedPages = abortedPages.load();
+}
+
+void MarkCompactor::updatePointers(const std::vector<GCCell*>& liveCells,
+                                   std::vector<GCCell**>& roots,
+                                   CardTable* cardTable) {
+  if (m_result.evacuatedObjects == 0) {
+    return;
+  }
+
+  // 生存セル内の参照スロットを分割して並列更新
+  constexpr size_t kChunkSize = 1024;
+  size_t chunkCount = (liveCells.size() + kChunkSize - 1) / kChunkSize;
+  std::atomic<size_t> updatedSlots{0};
+
+  parallelFor(chunkCount, [&](size_t chunk) {
+    size_t begin = chunk * kChunkSize;
+    size_t end = std::min(begin + kChunkSize, liveCells.size());
+    size_t localSlots = 0;
+
+    for (size_t i = begin; i < end; ++i) {
+      GCCell* cell = forwarded(liveCells[i]);
+      if (!cell) continue;
+
+      cell->visitMutableReferences([&localSlots](GCCell** ref) {
+        if (*ref && (*ref)->forwardingAddress) {
+          *ref = static_cast<GCCell*>((*ref)->forwardingAddress);
+          localSlots++;
+        }
+      });
+
+#ifdef AEROJS_POINTER_COMPRESSION
+      // 退避先も ParallelGC::allocateRaw がケージから取るため、展開→転送→再圧縮で済む
+      cell->visitCompressedReferences([&localSlots](uint32_t* slot) {
+        auto* ref = static_cast<GCCell*>(HeapCage::decompress(*slot));
+        if (ref && ref->forwardingAddress) {
+          *slot = HeapCage::compress(ref->forwardingAddress);
+          localSlots++;
+        }
+      });
+#endif
+    }
+
+    updatedSlots.fetch_add(localSlots, std::memory_order_relaxed);
+  });
+
+  // ルートの更新
+  for (GCCell** root : roots) {
+    if (root && *root && (*root)->forwardingAddress) {
+      *root = static_cast<GCCell*>((*root)->forwardingAddress);
+      updatedSlots.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // 退避先のカードを汚す（旧アドレスのカード状態は引き継げないため保守的に）
+  if (cardTable) {
+    for (const auto& candidate : m_candidates) {
+      for (GCCell* cell : candidate.cells) {
+        if (cell->forwardingAddress) {
+          cardTable->markCard(cell->forwardingAddress);
+        }
+      }
+    }
+  }
+
+  m_result.updatedSlots = updatedSlots.load();
+}
+
+void MarkCompactor::release(std::vector<GCCell*>& oldGen,
+                            const FreeFn& free,
+                            std::unordered_map<void*, void*>* relocated) {
+  for (auto& cell : oldGen) {
+    cell = forwarded(cell);
+  }
+
+  for (auto& candidate : m_candidates) {
+    for (GCCell* cell : candidate.cells) {
+      if (!cell->forwardingAddress) {
+        continue; // 退避されなかったページ
+      }
+      if (relocated) {
+        (*relocated)[cell] = cell->forwardingAddress;
+      }
+      // 退避元はムーブ済みの抜け殻なので、その場でデストラクタを呼んでから解放
+      size_t size = static_cast<GCCell*>(cell->forwardingAddress)->getSize();
+      cell->~GCCell();
+      free(cell, size);
+    }
+  }
+
+  for (const auto& [destination, size] : m_unusedDestinations) {
+    free(destination, size);
+  }
+
+  m_candidates.clear();
+  m_unusedDestinations.clear();
+  m_pendingBytes = 0;
+}
+
+void MarkCompactor::parallelFor(size_t count, const std::function<void(size_t)>& body) const {
+  if (count == 0) {
+    return;
+  }
+
+  size_t workerCount = std::min<size_t>(m_config.workerCount, count);
+  if (workerCount <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      body(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    while (true) {
+      size_t index = next.fetch_add(1, std::memory_order_relaxed);
+      if (index >= count) {
+        break;
+      }
+      body(index);
+    }
+  };
+
+  // メインスレッドも作業に参加
+  std::vector<std::thread> threads;
+  threads.reserve(workerCount - 1);
+  for (size_t i = 1; i < workerCount; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,133 @@
+/**
+ * @file mark_compact.h
+ * @brief オールド世代向けマーク・コンパクト（断片化ページの並列退避）
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "generational_gc.h"
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+class CardTable;
+
+// 退避候補ページ
+struct EvacuationCandidate {
+  uintptr_t pageStart = 0;          // ページ先頭アドレス
+  size_t liveBytes = 0;             // ページ内の生存バイト数（選定後は退避対象分）
+  size_t pinnedBytes = 0;           // 移動しない大きいセルのバイト数
+  float fragmentation = 0.0f;       // 断片化率（1 - 生存率）
+  std::vector<GCCell*> cells;       // ページ内の移動可能な生存セル（アドレス昇順）
+};
+
+// コンパクション結果
+struct CompactionResult {
+  size_t candidatePages = 0;        // 退避候補ページ数
+  size_t evacuatedObjects = 0;      // 退避したオブジェクト数
+  size_t evacuatedBytes = 0;        // 退避したバイト数
+  size_t abortedPages = 0;          // 退避先確保に失敗し、一部または全部のセルを残したページ数
+  size_t updatedSlots = 0;          // 更新した参照スロット数
+};
+
+/**
+ * @brief オールド世代のスライディング・コンパクタ
+ *
+ * 生存セルをページ単位で集計し、断片化率がしきい値を超えたページを
+ * 退避候補として選定する。候補ページの生存セルはアドレス順にセルごとの
+ * 退避先へ GCCell::relocateTo でムーブ構築し（並列退避）、ルート・生存セルの参照スロットを
+ * フォワーディングアドレスで書き換え（並列フィックスアップ）、
+ * 退避先のカードを汚して古い世代→若い世代参照の追跡を引き継ぐ。
+ * canRelocate() が false の型のセルは大きいセルと同じくページに固定する。
+ *
+ * 呼び出し側はミューテータを停止した状態で
+ * selectCandidates → evacuate → updatePointers → release の順に実行する。
+ */
+class MarkCompactor {
+public:
+  struct Config {
+    size_t pageSize = 256 * 1024;             // 断片化評価用ページサイズ
+    float fragmentationThreshold = 0.5f;      // 退避候補とする断片化率
+    size_t maxEvacuationBytes = 16 * 1024 * 1024; // 1サイクルの退避上限
+    uint32_t workerCount = 1;                 // 並列ワーカー数
+    size_t largeObjectThreshold = 32 * 1024;  // これ以上のセルは移動しない
+  };
+
+  using AllocateFn = std::function<void*(size_t)>;
+  using FreeFn = std::function<void(void*, size_t)>;
+
+  explicit MarkCompactor(const Config& config);
+  ~MarkCompactor() = default;
+
+  /**
+   * @brief 断片化率に基づいて退避候補ページを選定
+   * @param oldGen オールド世代の生存セル
+   * @return 選定された候補ページ数
+   */
+  size_t selectCandidates(const std::vector<GCCell*>& oldGen);
+
+  bool hasCandidates() const { return !m_candidates.empty(); }
+  size_t pendingBytes() const { return m_pendingBytes; }
+  const std::vector<EvacuationCandidate>& candidates() const { return m_candidates; }
+
+  /**
+   * @brief 候補ページの生存セルを並列に退避
+   * @param allocate 退避先を1セル分ずつ確保する関数（内部で直列化される）
+   *
+   * 退避先は release の free と同じくセル単位で解放されるため、1回の確保に複数セルを詰めない。
+   */
+  void evacuate(const AllocateFn& allocate);
+
+  /**
+   * @brief 退避済みセルへの参照を並列に更新
+   * @param liveCells 全世代の生存セル（退避元セルを含んでよい）
+   * @param roots ルートスロット
+   * @param cardTable カード表（nullptr可）
+   */
+  void updatePointers(const std::vector<GCCell*>& liveCells,
+                      std::vector<GCCell**>& roots,
+                      CardTable* cardTable);
+
+  /**
+   * @brief 世代リストを退避先に差し替え、退避元を破棄して解放
+   * @param oldGen オールド世代リスト（退避先ポインタで更新される）
+   * @param free 退避元と未使用の退避先メモリの解放関数
+   * @param relocated 退避元→退避先の対応（ハンドル再マップ用、nullptr可）
+   */
+  void release(std::vector<GCCell*>& oldGen,
+               const FreeFn& free,
+               std::unordered_map<void*, void*>* relocated);
+
+  const CompactionResult& result() const { return m_result; }
+
+  // フォワーディングアドレスの解決
+  static GCCell* forwarded(GCCell* cell) {
+    return (cell && cell->forwardingAddress) ? static_cast<GCCell*>(cell->forwardingAddress) : cell;
+  }
+
+private:
+  // [0, count) を workerCount 個のスレッドで処理
+  void parallelFor(size_t count, const std::function<void(size_t)>& body) const;
+
+  Config m_config;
+  std::vector<EvacuationCandidate> m_candidates;
+  std::vector<std::pair<void*, size_t>> m_unusedDestinations; // 移動を断ったセルの退避先
+  size_t m_pendingBytes;
+  CompactionResult m_result;
+  std::mutex m_allocateMutex;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
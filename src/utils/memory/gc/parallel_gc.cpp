@@ -6,6 +6,14 @@
  */
 
 #include "parallel_gc.h"
+#include "../smart_ptr/handle_manager.h"
+#include "heap_snapshot_writer.h"
+#include "../pool/typed_pool.h"
+#include "../allocators/numa_page_pool.h"
+#include "../../platform/numa_topology.h"
+#ifdef AEROJS_POINTER_COMPRESSION
+#include "../allocators/heap_cage.h"
+#endif
 #include <algorithm>
 #include <chrono>
 #include <iostream>
@@ -15,121 +23,6 @@ namespace aerojs {
 namespace utils {
 namespace memory {
 
-// カードテーブルの実装
-CardTable::CardTable(size_t heapSize, size_t cardSize)
-  : m_cardSize(cardSize),
-    m_heapSize(heapSize),
-    m_heapStart(0)
-{
-  m_cardCount = (heapSize + cardSize - 1) / cardSize;
-  m_cards = new uint8_t[m_cardCount]();
-}
-
-CardTable::~CardTable() {
-  delete[] m_cards;
-}
-
-void CardTable::markCard(void* ptr) {
-  uint8_t* card = cardFor(ptr);
-  if (card) {
-    *card = 1;
-  }
-}
-
-bool CardTable::isCardMarked(void* ptr) const {
-  uint8_t* card = cardFor(ptr);
-  return card ? *card != 0 : false;
-}
-
-void CardTable::clearCard(void* ptr) {
-  uint8_t* card = cardFor(ptr);
-  if (card) {
-    *card = 0;
-  }
-}
-
-void CardTable::clearAll() {
-  std::memset(m_cards, 0, m_cardCount);
-}
-
-uint8_t* CardTable::cardFor(void* ptr) const {
-  uintptr_t addr = reinterpret_cast<uintptr_t>(ptr);
-  if (addr < m_heapStart || addr >= m_heapStart + m_heapSize) {
-    return nullptr;
-  }
-  size_t offset = addr - m_heapStart;
-  size_t cardIndex = offset / m_cardSize;
-  if (cardIndex >= m_cardCount) {
-    return nullptr;
-  }
-  return &m_cards[cardIndex];
-}
-
-// リメンバーセットの実装
-RememberSet::RememberSet() {}
-
-RememberSet::~RememberSet() {
-  clear();
-}
-
-void RememberSet::add(GCCell* fromObject, GCCell* toObject) {
-  if (!fromObject || !toObject) return;
-  
-  std::lock_guard<std::mutex> lock(m_mutex);
-  m_fromToRefs[fromObject].insert(toObject);
-  m_toFromRefs[toObject].insert(fromObject);
-}
-
-void RememberSet::remove(GCCell* fromObject, GCCell* toObject) {
-  if (!fromObject || !toObject) return;
-  
-  std::lock_guard<std::mutex> lock(m_mutex);
-  auto fromIt = m_fromToRefs.find(fromObject);
-  if (fromIt != m_fromToRefs.end()) {
-    fromIt->second.erase(toObject);
-    if (fromIt->second.empty()) {
-      m_fromToRefs.erase(fromIt);
-    }
-  }
-  
-  auto toIt = m_toFromRefs.find(toObject);
-  if (toIt != m_toFromRefs.end()) {
-    toIt->second.erase(fromObject);
-    if (toIt->second.empty()) {
-      m_toFromRefs.erase(toIt);
-    }
-  }
-}
-
-bool RememberSet::contains(GCCell* fromObject, GCCell* toObject) const {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  auto it = m_fromToRefs.find(fromObject);
-  if (it != m_fromToRefs.end()) {
-    return it->second.find(toObject) != it->second.end();
-  }
-  return false;
-}
-
-const std::unordered_set<GCCell*>& RememberSet::getReferencesFrom(GCCell* obj) const {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  static const std::unordered_set<GCCell*> emptySet;
-  auto it = m_fromToRefs.find(obj);
-  return it != m_fromToRefs.end() ? it->second : emptySet;
-}
-
-const std::unordered_set<GCCell*>& RememberSet::getReferencesTo(GCCell* obj) const {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  static const std::unordered_set<GCCell*> emptySet;
-  auto it = m_toFromRefs.find(obj);
-  return it != m_toFromRefs.end() ? it->second : emptySet;
-}
-
-void RememberSet::clear() {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  m_fromToRefs.clear();
-  m_toFromRefs.clear();
-}
-
 // ワークスティーリングキューのテンプレート実装
 template<typename T>
 WorkStealingQueue<T>::WorkStealingQueue(size_t capacity)
@@ -227,23 +120,41 @@ ParallelGC::ParallelGC(const ParallelGCConfig& config)
     m_collectionInProgress(false),
     m_concurrentMarkingActive(false),
     m_incrementalMarkingActive(false),
+    m_totalAllocatedBytes(0),
+    m_nurseryAllocatedBytes(0),
+    m_heapUsedBytes(0),
+    m_heapLimit(0),
+    m_initialHeapLimit(0),
+    m_inNearHeapLimitCallback(false),
+    m_compactionPending(false),
+    m_compactionBytesPerMs(0.0),
     m_workersActive(false),
     m_shuttingDown(false),
+    m_workerTask(nullptr),
+    m_workerTaskSlots(0),
+    m_workerTaskRunning(0),
     m_currentGCType(GCType::Minor),
     m_currentGCCause(GCCause::Scheduled),
+    m_handleManager(std::make_unique<aero::HandleManager>()),
     m_allocator(nullptr),
     m_cardTable(nullptr),
-    m_rememberSet(nullptr),
+    m_oldSpaceIndexDirty(true),
+    m_numaActive(false),
+    m_heapNode(-1),
     m_barrier(nullptr)
 {
+#ifdef AEROJS_POINTER_COMPRESSION
+  // ヒープ全体がケージに収まる必要がある
+  m_config.maxHeapSize = std::min(m_config.maxHeapSize, HeapCage::kCageSize);
+#endif
+  m_heapLimit.store(m_config.maxHeapSize, std::memory_order_relaxed);
+  m_initialHeapLimit = m_config.maxHeapSize;
+  
   // メモリアロケータの初期化
   m_allocator = std::make_unique<allocators::MemoryAllocator>(config.initialHeapSize);
   
-  // カードテーブルの初期化
-  m_cardTable = std::make_unique<CardTable>(config.maxHeapSize);
-  
-  // リメンバーセットの初期化
-  m_rememberSet = std::make_unique<RememberSet>();
+  // カードテーブルの初期化（カード列は割り当てに応じてリージョン単位で確保）
+  m_cardTable = std::make_unique<CardTable>();
   
   // 世代の初期確保
   m_nurseryGen.reserve(config.nurserySize / 64);  // 64バイト平均サイズと仮定
@@ -277,9 +188,26 @@ ParallelGC::ParallelGC(const ParallelGCConfig& config)
     m_markingQueues[i] = std::make_unique<WorkStealingQueue<GCCell*>>(config.markingWorkQueueSize);
   }
   
+  // NUMA配置（ノード別ヒープとワーカーの固定先）
+  initNumaPlacement(workerCount);
+  
   // 同期バリアの初期化
   m_barrier = std::make_unique<SyncBarrier>(workerCount);
   
+  // オールド世代コンパクタの初期化
+  MarkCompactor::Config compactorConfig;
+  compactorConfig.pageSize = config.compactionPageSize;
+  compactorConfig.fragmentationThreshold = config.evacuationFragmentationThreshold;
+  compactorConfig.maxEvacuationBytes = config.maxEvacuationBytes;
+  compactorConfig.workerCount = workerCount;
+  compactorConfig.largeObjectThreshold = config.largeObjectThreshold;
+  m_compactor = std::make_unique<MarkCompactor>(compactorConfig);
+  
+  // 大きいオブジェクト空間の初期化
+  if (config.enableLargeObjectSpace) {
+    m_largeObjectSpace = std::make_unique<LargeObjectSpace>();
+  }
+  
   // ワーカースレッドの初期化と開始
   if (config.enableConcurrentMarking || config.enableConcurrentSweeping) {
     initWorkerThreads();
@@ -315,23 +243,23 @@ ParallelGC::~ParallelGC() {
   
   shutdownWorkerThreads();
   
-  // 全オブジェクト解放
+  // 全オブジェクト解放（メモリは割り当て元の領域へ返す）
   majorCollection(GCCause::ExplicitRequest);
   
   for (auto* obj : m_nurseryGen) {
-    delete obj;
+    destroyCell(obj);
   }
   for (auto* obj : m_youngGen) {
-    delete obj;
+    destroyCell(obj);
   }
   for (auto* obj : m_mediumGen) {
-    delete obj;
+    destroyCell(obj);
   }
   for (auto* obj : m_oldGen) {
-    delete obj;
+    destroyCell(obj);
   }
   for (auto* obj : m_largeObjects) {
-    delete obj;
+    destroyLargeObject(obj);
   }
   
   m_nurseryGen.clear();
@@ -372,12 +300,17 @@ void ParallelGC::shutdownWorkerThreads() {
 
 // ワーカースレッドのメイン処理
 void ParallelGC::workerThreadMain(int threadId) {
+  // 処理するページと同じノードのCPUで動かす
+  if (m_numaActive) {
+    pinCurrentThreadToNode(m_workerNodes[threadId]);
+  }
+  
   while (!m_shuttingDown) {
     // ワーク待機
     {
       std::unique_lock<std::mutex> lock(m_workerMutex);
       m_workerCV.wait(lock, [this] {
-        return m_workersActive || m_shuttingDown;
+        return m_workersActive || m_workerTaskSlots > 0 || m_shuttingDown;
       });
       
       if (m_shuttingDown) {
@@ -385,6 +318,9 @@ void ParallelGC::workerThreadMain(int threadId) {
       }
     }
     
+    // 単発の作業（ダーティカードの走査など）
+    runWorkerTask();
+    
     // ワーク実行
     while (m_workersActive && !m_shuttingDown) {
       if (m_concurrentMarkingActive) {
@@ -400,6 +336,51 @@ void ParallelGC::workerThreadMain(int threadId) {
   }
 }
 
+// 作業関数を呼び出しスレッドと最大 helperCount 個のワーカーで1回ずつ実行し、全員の終了を待つ
+//
+// 作業関数は共有のカウンタなどで仕事を取り合う形にしておく。参加が間に合わなかった
+// ワーカーの枠は呼び出しスレッドの終了時に取り消すので、その分は呼び出しスレッドが
+// 引き受けたことになる。
+void ParallelGC::runOnWorkers(const std::function<void()>& task, size_t helperCount) {
+  helperCount = std::min(helperCount, m_workerThreads.size());
+  if (helperCount > 0) {
+    std::lock_guard<std::mutex> lock(m_workerMutex);
+    m_workerTask = &task;
+    m_workerTaskSlots = helperCount;
+    m_workerCV.notify_all();
+  }
+  
+  task();
+  
+  if (helperCount > 0) {
+    std::unique_lock<std::mutex> lock(m_workerMutex);
+    m_workerTaskSlots = 0;
+    m_workerTaskDone.wait(lock, [this] { return m_workerTaskRunning == 0; });
+    m_workerTask = nullptr;
+  }
+}
+
+// 配られた単発の作業があれば枠を1つ取って実行（ワーカースレッドから呼ぶ）
+void ParallelGC::runWorkerTask() {
+  const std::function<void()>* task = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_workerMutex);
+    if (m_workerTaskSlots == 0) {
+      return;
+    }
+    m_workerTaskSlots--;
+    m_workerTaskRunning++;
+    task = m_workerTask;
+  }
+  
+  (*task)();
+  
+  std::lock_guard<std::mutex> lock(m_workerMutex);
+  if (--m_workerTaskRunning == 0) {
+    m_workerTaskDone.notify_all();
+  }
+}
+
 // GC有効化/無効化
 void ParallelGC::enableGC(bool enable) {
   m_gcEnabled = enable;
@@ -623,6 +604,12 @@ void ParallelGC::collectGarbage(GCType type, GCCause cause) {
     return;
   }
   
+  // インクリメンタルマーキング中なら、そのサイクルを完了させる
+  if (m_incrementalMarkingActive) {
+    finishIncrementalCollection();
+    return;
+  }
+  
   // GCが既に実行中ならスキップ
   bool expected = false;
   if (!m_collectionInProgress.compare_exchange_strong(expected, true)) {
@@ -642,62 +629,152 @@ void ParallelGC::collectGarbage(GCType type, GCCause cause) {
     if (m_config.enableConcurrentMarking && type != GCType::Minor) {
       // 並行マーキング
       markRoots();
+      if (type != GCType::Major) {
+        scanDirtyCards();
+      }
       markConcurrent();
       finishMarking();
     } else {
       // 通常マーキング
       markRoots();
+      if (type != GCType::Major) {
+        scanDirtyCards();
+      }
       for (size_t i = 0; i < m_markingQueues.size(); i++) {
         processMarkingWorkQueue(i);
       }
     }
     
-    // スイーピングフェーズ
-    sweep(m_config.enableConcurrentSweeping && type != GCType::Minor);
-    
-    // コンパクションフェーズ
-    if (m_config.enableCompaction && type == GCType::Major) {
-      compact();
-    }
-    
-    // 昇格フェーズ
-    promoteObjects();
-    
-    // 統計情報更新
-    auto endTime = std::chrono::steady_clock::now();
-    uint64_t durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
-    
-    m_stats.lastGCDurationMs = durationMs;
-    m_stats.lastGCTimestamp = std::chrono::time_point_cast<std::chrono::milliseconds>(endTime).time_since_epoch().count();
-    m_stats.lastGCType = type;
-    m_stats.lastGCCause = cause;
+    completeCollection(type, cause, startTime);
+  } catch (const std::exception& e) {
+    // 例外処理
+    std::cerr << "GC error: " << e.what() << std::endl;
+  }
+  
+  // GC完了
+  m_collectionInProgress = false;
+}
+
+// マーキング後のフェーズ（スイープ・コンパクション・昇格・統計）
+void ParallelGC::completeCollection(GCType type, GCCause cause, std::chrono::steady_clock::time_point startTime) {
+  // 回収されるセルを指す弱ハンドルを、ハンドルテーブルの1回の走査でクリア
+  m_handleManager->sweepWeakHandles([](GCCell* cell) {
+    return cell->state != CellState::White;
+  });
+  
+  // スイーピングフェーズ（解放量をヒープ上限判定用の使用量から差し引く）
+  size_t freedBefore = m_stats.freedBytes;
+  sweep(m_config.enableConcurrentSweeping && type != GCType::Minor);
+  size_t freed = m_stats.freedBytes - freedBefore;
+  size_t used = m_heapUsedBytes.load(std::memory_order_relaxed);
+  m_heapUsedBytes.store(used > freed ? used - freed : 0, std::memory_order_relaxed);
+  
+  // コンパクションフェーズ（アイドル実行時は候補選定のみ行い保留）
+  if (m_config.enableCompaction && type == GCType::Major) {
+    compact();
+  }
+  
+  // 昇格フェーズ
+  promoteObjects();
+  m_oldSpaceIndexDirty = true;
+  m_nurseryAllocatedBytes.store(0, std::memory_order_relaxed);
+  
+  // 統計情報更新
+  auto endTime = std::chrono::steady_clock::now();
+  uint64_t durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+  
+  m_stats.lastGCDurationMs = durationMs;
+  m_stats.lastGCTimestamp = std::chrono::time_point_cast<std::chrono::milliseconds>(endTime).time_since_epoch().count();
+  m_stats.lastGCType = type;
+  m_stats.lastGCCause = cause;
+  
+  if (type == GCType::Major) {
+    m_stats.majorGCCount++;
+    m_stats.totalMajorGCTimeMs += durationMs;
     
-    if (type == GCType::Major) {
-      m_stats.majorGCCount++;
-      m_stats.totalMajorGCTimeMs += durationMs;
-    } else if (type == GCType::Medium) {
-      m_stats.mediumGCCount++;
-      m_stats.totalMediumGCTimeMs += durationMs;
-    } else {
-      m_stats.minorGCCount++;
-      m_stats.totalMinorGCTimeMs += durationMs;
+    // 各スレッドの型別プールに、溜め込んだ空きブロックの解放を要求
+    requestTypedPoolTrim();
+  } else if (type == GCType::Medium) {
+    m_stats.mediumGCCount++;
+    m_stats.totalMediumGCTimeMs += durationMs;
+  } else {
+    m_stats.minorGCCount++;
+    m_stats.totalMinorGCTimeMs += durationMs;
+  }
+  
+  // GCメトリクス更新
+  updateGCMetrics();
+  
+  // 適応的GCパラメータ調整
+  if (m_config.enableAdaptiveCollection) {
+    adjustGCParameters();
+  }
+  
+  m_lastGCTime = endTime;
+  
+  // GCコントローラが割り当てレートと停止時間を計測し、ナーサリーサイズを調整する
+  if (m_collectionCompleteCallback) {
+    m_collectionCompleteCallback();
+  }
+}
+
+// インクリメンタルマーキング開始（ルートとダーティカードのみ走査し、残りはステップで進める）
+bool ParallelGC::startIncrementalMarking(GCType type, GCCause cause) {
+  if (!m_gcEnabled || m_incrementalMarkingActive) {
+    return false;
+  }
+  
+  bool expected = false;
+  if (!m_collectionInProgress.compare_exchange_strong(expected, true)) {
+    return false;
+  }
+  
+  std::lock_guard<std::mutex> lock(m_incrementalMutex);
+  m_currentGCType = type;
+  m_currentGCCause = cause;
+  
+  prepareCollection(type);
+  markRoots();
+  if (type != GCType::Major) {
+    scanDirtyCards();
+  }
+  
+  m_incrementalMarkingActive = true;
+  return true;
+}
+
+bool ParallelGC::isMarkingWorkEmpty() const {
+  for (const auto& queue : m_markingQueues) {
+    if (!queue->empty()) {
+      return false;
     }
+  }
+  return true;
+}
+
+// インクリメンタルサイクルの完了（停止時間はここだけ）
+void ParallelGC::finishIncrementalCollection() {
+  std::lock_guard<std::mutex> lock(m_incrementalMutex);
+  if (!m_incrementalMarkingActive) {
+    return;
+  }
+  
+  try {
+    auto startTime = std::chrono::steady_clock::now();
     
-    // GCメトリクス更新
-    updateGCMetrics();
-    
-    // 適応的GCパラメータ調整
-    if (m_config.enableAdaptiveCollection) {
-      adjustGCParameters();
+    // マーキング中に書き換えられたルートを再走査し、残りを処理
+    markRoots();
+    for (size_t i = 0; i < m_markingQueues.size(); i++) {
+      processMarkingWorkQueue(i);
     }
+    m_incrementalMarkingActive = false;
     
-    m_lastGCTime = endTime;
+    completeCollection(m_currentGCType, m_currentGCCause, startTime);
   } catch (const std::exception& e) {
-    // 例外処理
     std::cerr << "GC error: " << e.what() << std::endl;
+    m_incrementalMarkingActive = false;
   }
   
-  // GC完了
   m_collectionInProgress = false;
 }
 
@@ -718,6 +795,8 @@ void ParallelGC::majorCollection(GCCause cause) {
 
 // コレクション準備
 void ParallelGC::prepareCollection(GCType type) {
+  m_handleManager->prepareForGC();
+  
   // マーキングキューをクリア
   for (auto& queue : m_markingQueues) {
     queue->clear();
@@ -745,9 +824,21 @@ void ParallelGC::prepareCollection(GCType type) {
     resetMarks(m_largeObjects);
   }
   
-  // 記憶セットとカード表の処理
-  if (type == GCType::Major) {
-    m_cardTable->clearAll();
+  // 回収対象外の世代は生存扱い（Black）にしてトレースを打ち切り、
+  // そこからの参照はダーティカードの走査で補う
+  auto blackenMarks = [](auto& container) {
+    for (auto* cell : container) {
+      cell->state = CellState::Black;
+    }
+  };
+  
+  if (type == GCType::Minor) {
+    blackenMarks(m_mediumGen);
+  }
+  
+  if (type != GCType::Major) {
+    blackenMarks(m_oldGen);
+    blackenMarks(m_largeObjects);
   }
 }
 
@@ -760,6 +851,11 @@ void ParallelGC::markRoots() {
       mark(*m_roots[i]);
     }
   }
+  
+  // 強いグローバルハンドルと各スレッドのローカルハンドル
+  m_handleManager->visitRoots([this](GCCell* cell) {
+    mark(cell);
+  });
 }
 
 // 通常マーキング
@@ -773,6 +869,18 @@ void ParallelGC::mark(GCCell* root) {
   
   // マーキングキューにプッシュ（ラウンドロビンで分配）
   static thread_local size_t queueIndex = 0;
+  
+  // NUMA有効時はセルのページを所有するノードのワーカーに渡す
+  if (m_numaActive) {
+    int node = ownerNodeOf(root);
+    if (node >= 0 && !m_nodeQueues[node].empty()) {
+      const auto& nodeQueues = m_nodeQueues[node];
+      queueIndex = (queueIndex + 1) % nodeQueues.size();
+      m_markingQueues[nodeQueues[queueIndex]]->push(root);
+      return;
+    }
+  }
+  
   size_t queueCount = m_markingQueues.size();
   
   if (queueCount > 0) {
@@ -922,6 +1030,121 @@ void ParallelGC::finishMarking() {
   }
 }
 
+// カード走査用インデックスの再構築
+void ParallelGC::rebuildOldSpaceIndex() {
+  m_oldSpaceIndex.clear();
+  m_oldSpaceIndex.reserve(m_mediumGen.size() + m_oldGen.size() + m_largeObjects.size());
+  
+  for (auto* cell : m_mediumGen) {
+    m_oldSpaceIndex.push_back({cell, ExtendedGeneration::Medium});
+  }
+  for (auto* cell : m_oldGen) {
+    m_oldSpaceIndex.push_back({cell, ExtendedGeneration::Old});
+  }
+  for (auto* cell : m_largeObjects) {
+    m_oldSpaceIndex.push_back({cell, ExtendedGeneration::LargeObj});
+  }
+  
+  std::sort(m_oldSpaceIndex.begin(), m_oldSpaceIndex.end(),
+            [](const IndexedCell& a, const IndexedCell& b) { return a.cell < b.cell; });
+  m_oldSpaceIndexDirty = false;
+}
+
+// ダーティカードの並列走査（スカベンジ時の古い世代→若い世代参照の発見）
+void ParallelGC::scanDirtyCards() {
+  if (m_oldSpaceIndexDirty) {
+    rebuildOldSpaceIndex();
+  }
+  if (m_oldSpaceIndex.empty()) {
+    return;
+  }
+  
+  const auto& index = m_oldSpaceIndex;
+  auto lookup = [&index](const void* addr) -> const IndexedCell* {
+    auto it = std::lower_bound(index.begin(), index.end(), addr,
+                               [](const IndexedCell& entry, const void* key) {
+                                 return static_cast<const void*>(entry.cell) < key;
+                               });
+    return (it != index.end() && it->cell == addr) ? &*it : nullptr;
+  };
+  
+  std::atomic<size_t> scannedCards{0};
+  std::atomic<size_t> retainedCards{0};
+  std::atomic<size_t> nextRegion{0};
+  size_t regionCount = m_cardTable->getRegionCount();
+  
+  // リージョン単位でワーカーに分配（各カードは1つのワーカーだけが書き換える）
+  std::function<void()> worker = [&]() {
+    size_t localScanned = 0;
+    size_t localRetained = 0;
+    
+    while (true) {
+      size_t region = nextRegion.fetch_add(1, std::memory_order_relaxed);
+      if (region >= regionCount) {
+        break;
+      }
+      
+      m_cardTable->forEachDirtyCard(region, region + 1, [&](uint8_t& card, uintptr_t cardStart) {
+        localScanned++;
+        
+        // ヘッダがこのカードにある古い世代のセルを走査
+        const void* begin = reinterpret_cast<const void*>(cardStart);
+        auto it = std::lower_bound(index.begin(), index.end(), begin,
+                                   [](const IndexedCell& entry, const void* key) {
+                                     return static_cast<const void*>(entry.cell) < key;
+                                   });
+        
+        bool keepDirty = false;
+        for (; it != index.end() &&
+               reinterpret_cast<uintptr_t>(it->cell) < cardStart + CardTable::kCardSize; ++it) {
+          GCCell* parent = it->cell;
+          if (parent->state != CellState::Black) {
+            // 今回回収対象の世代（ミディアムGC時のミディアム世代など）。生き残れば
+            // 次のスカベンジで辿れるよう、カードは汚れたまま残す
+            keepDirty = true;
+            continue;
+          }
+          
+          parent->visitReferences([&](GCCell* ref) {
+            if (!ref) return;
+            const IndexedCell* target = lookup(ref);
+            bool refIsOld = target &&
+              (target->generation == ExtendedGeneration::Old ||
+               target->generation == ExtendedGeneration::LargeObj);
+            if (!refIsOld) {
+              // 若い世代を指している限りカードは汚れたまま残す
+              keepDirty = true;
+              if (ref->state == CellState::White) {
+                mark(ref);
+              }
+            }
+          });
+        }
+        
+        // 走査し終えたカードだけを掃除する（若い世代を指す参照が残るなら汚れたまま）
+        if (keepDirty) {
+          localRetained++;
+        } else {
+          card = CardTable::kClean;
+        }
+      });
+    }
+    
+    scannedCards.fetch_add(localScanned, std::memory_order_relaxed);
+    retainedCards.fetch_add(localRetained, std::memory_order_relaxed);
+  };
+  
+  // 走査するカードが少なければ、ワーカーを起こすより呼び出しスレッドだけで走査する方が速い
+  size_t helperCount = 0;
+  if (regionCount > 1 && m_cardTable->getCardCount() >= m_config.parallelCardScanMinCards) {
+    helperCount = std::min<size_t>(m_markingQueues.size(), regionCount) - 1;
+  }
+  runOnWorkers(worker, helperCount);
+  
+  m_stats.dirtyCardsScanned += scannedCards.load();
+  m_stats.cardsRetained += retainedCards.load();
+}
+
 // スイーピング処理
 void ParallelGC::sweep(bool concurrent) {
   auto sweepStart = std::chrono::steady_clock::now();
@@ -958,7 +1181,19 @@ void ParallelGC::performConcurrentSweep() {
   
   if (m_currentGCType == GCType::Major) {
     sweepTasks.emplace_back(SweepTask{ExtendedGeneration::Old, &m_oldGen});
-    sweepTasks.emplace_back(SweepTask{ExtendedGeneration::LargeObj, &m_largeObjects});
+  }
+  
+  // NUMA有効時は世代×ノードに分け、各タスクはそのノードに固定したスレッドで処理する
+  if (m_numaActive) {
+    std::vector<SweepTask> nodeTasks;
+    for (const auto& task : sweepTasks) {
+      for (size_t node = 0; node < m_nodeHeaps.size(); ++node) {
+        if (m_heapNode < 0 || static_cast<int>(node) == m_heapNode) {
+          nodeTasks.push_back(SweepTask{task.generation, task.container, static_cast<int>(node)});
+        }
+      }
+    }
+    sweepTasks.swap(nodeTasks);
   }
   
   // ワーカースレッドを起動
@@ -980,7 +1215,10 @@ void ParallelGC::performConcurrentSweep() {
         }
         
         const auto& task = sweepTasks[currentTask];
-        sweepGeneration(*task.container, localFreedObjects, localFreedMemory);
+        if (task.node >= 0) {
+          pinCurrentThreadToNode(task.node);
+        }
+        sweepGeneration(*task.container, localFreedObjects, localFreedMemory, task.node);
       }
       
       // 全体の統計に反映
@@ -994,6 +1232,15 @@ void ParallelGC::performConcurrentSweep() {
     worker.join();
   }
   
+  // 大きいオブジェクトはマッピング単位で返却するため呼び出しスレッドで処理
+  if (m_currentGCType == GCType::Major) {
+    size_t largeFreedObjects = 0;
+    size_t largeFreedMemory = 0;
+    sweepLargeObjects(largeFreedObjects, largeFreedMemory);
+    totalFreedObjects.fetch_add(largeFreedObjects, std::memory_order_relaxed);
+    totalFreedMemory.fetch_add(largeFreedMemory, std::memory_order_relaxed);
+  }
+  
   // 統計情報更新
   m_stats.freedObjects += totalFreedObjects.load();
   m_stats.freedBytes += totalFreedMemory.load();
@@ -1018,7 +1265,7 @@ void ParallelGC::performSynchronousSweep() {
   
   if (m_currentGCType == GCType::Major) {
     sweepGeneration(m_oldGen, freedObjs, freedMem);
-    sweepGeneration(m_largeObjects, freedObjs, freedMem);
+    sweepLargeObjects(freedObjs, freedMem);
   }
   
   // 統計情報更新
@@ -1028,13 +1275,19 @@ void ParallelGC::performSynchronousSweep() {
 }
 
 template<typename Container>
-void ParallelGC::sweepGeneration(Container& container, size_t& freedObjs, size_t& freedMem) {
+void ParallelGC::sweepGeneration(Container& container, size_t& freedObjs, size_t& freedMem, int node) {
   std::lock_guard<std::mutex> lock(m_sweepMutex); // コンテナアクセス用の排他制御
   
   auto it = container.begin();
   while (it != container.end()) {
     auto* obj = *it;
     
+    // 他ノードのページにあるセルはそのノードのタスクに任せる（プール外のセルはノード0が担当）
+    if (node >= 0 && std::max(ownerNodeOf(obj), 0) != node) {
+      ++it;
+      continue;
+    }
+    
     if (obj->state == CellState::White) {
       // マークされていないオブジェクトを回収
       freedMem += obj->getSize();
@@ -1045,7 +1298,7 @@ void ParallelGC::sweepGeneration(Container& container, size_t& freedObjs, size_t
         obj->finalize();
       }
       
-      delete obj;
+      destroyCell(obj);
       it = container.erase(it);
     } else {
       // 次回GC用にマークをリセット
@@ -1055,10 +1308,48 @@ void ParallelGC::sweepGeneration(Container& container, size_t& freedObjs, size_t
   }
 }
 
+// 大きいオブジェクトのスイープ（その場でマーク済み、死んだものはマッピングごと返却）
+void ParallelGC::sweepLargeObjects(size_t& freedObjs, size_t& freedMem) {
+  for (auto it = m_largeObjects.begin(); it != m_largeObjects.end();) {
+    GCCell* obj = *it;
+    
+    if (obj->state != CellState::White) {
+      // 次回GC用にマークをリセット
+      obj->state = CellState::White;
+      ++it;
+      continue;
+    }
+    
+    freedMem += obj->getSize();
+    freedObjs++;
+    
+    if (obj->hasFinalizaer()) {
+      obj->finalize();
+    }
+    
+    it = m_largeObjects.erase(it);
+    destroyLargeObject(obj);
+  }
+  
+  m_oldSpaceIndexDirty = true;
+}
+
+void ParallelGC::destroyLargeObject(GCCell* cell) {
+  if (m_largeObjectSpace && m_largeObjectSpace->contains(cell)) {
+    cell->~GCCell();
+    size_t unmapped = m_largeObjectSpace->release(cell);
+    m_stats.largeObjectsReleased++;
+    m_stats.largeObjectBytesUnmapped += unmapped;
+  } else {
+    destroyCell(cell);
+  }
+}
+
 // スイープタスクの構造体定義
 struct SweepTask {
   ExtendedGeneration generation;
   std::vector<GCCell*>* container;
+  int node = -1;  // NUMA有効時の担当ノード
 };
 
 // GCメトリクス更新
@@ -1149,6 +1440,7 @@ void ParallelGC::adjustGCParameters() {
 
 // インクリメンタルマーキングステップ実行（外部から呼び出し可能）
 void ParallelGC::incrementalMarkingStep(size_t stepSize) {
+  std::lock_guard<std::mutex> lock(m_incrementalMutex);
   if (m_incrementalMarkingActive) {
     markIncrementalStep(stepSize);
   }
@@ -1173,6 +1465,58 @@ void ParallelGC::removeRoot(GCCell** root) {
   }
 }
 
+// ヒープスナップショットの書き出し
+// 走査中にセルが動かないよう、GCと同じフラグで回収を止めてから世代ごとに書き出す。
+// ルートにはGCと同じくハンドルテーブルの強いハンドル・ローカルハンドルも含める
+bool ParallelGC::writeHeapSnapshot(const std::string& filename) {
+  if (m_incrementalMarkingActive) {
+    finishIncrementalCollection();
+  }
+  
+  bool expected = false;
+  if (!m_collectionInProgress.compare_exchange_strong(expected, true)) {
+    return false;
+  }
+  
+  HeapSnapshotWriter writer;
+  bool result = false;
+  
+  try {
+    if (writer.open(filename)) {
+      auto writeSpace = [&](const auto& cells, heapsnapshot::Space space) {
+        for (GCCell* cell : cells) {
+          writer.writeNode(cell, space);
+        }
+      };
+      
+      writeSpace(m_nurseryGen, heapsnapshot::Space::Nursery);
+      writeSpace(m_youngGen, heapsnapshot::Space::Young);
+      writeSpace(m_mediumGen, heapsnapshot::Space::Medium);
+      writeSpace(m_oldGen, heapsnapshot::Space::Old);
+      writeSpace(m_largeObjects, heapsnapshot::Space::Large);
+      
+      {
+        std::lock_guard<std::mutex> lock(m_rootsMutex);
+        for (GCCell** root : m_roots) {
+          if (root && *root) {
+            writer.writeRoot(*root);
+          }
+        }
+      }
+      m_handleManager->visitRoots([&writer](GCCell* cell) {
+        writer.writeRoot(cell);
+      });
+      
+      result = writer.finish();
+    }
+  } catch (...) {
+    result = false;
+  }
+  
+  m_collectionInProgress = false;
+  return result;
+}
+
 // メモリ拡張処理
 void ParallelGC::expandHeap(size_t additionalSize) {
   if (additionalSize == 0) {
@@ -1186,58 +1530,228 @@ void ParallelGC::expandHeap(size_t additionalSize) {
     }
   }
   
-  // アロケータにヒープ拡張を依頼
+  // アロケータにヒープ拡張を依頼（カード列は割り当て時にリージョン単位で確保される）
   if (m_allocator->expand(additionalSize)) {
     m_stats.currentHeapSize += additionalSize;
-    
-    // カードテーブルの更新（必要に応じて）
-    if (m_cardTable) {
-      // カードテーブルを新しいヒープサイズで再構築
-      m_cardTable = std::make_unique<CardTable>(m_stats.currentHeapSize);
-    }
   }
 }
 
 // メモリ割り当て用のRaw実装
 void* ParallelGC::allocateRaw(size_t size, ExtendedGeneration gen) {
-  // 大きいオブジェクトの場合は特別処理
+  void* memory = nullptr;
+  
+#ifdef AEROJS_POINTER_COMPRESSION
+  // 圧縮参照はケージ内しか指せないため、退避先を含む全割り当てをケージから取る
+  // （解放時はサイズで領域とサイズクラスを見分けるので、ここでもサイズだけで振り分ける）
   if (size >= m_config.largeObjectThreshold) {
-    return m_allocator->allocateLarge(size);
+    memory = HeapCage::instance().allocateRegion(size);
+  } else {
+    memory = HeapCage::instance().allocator().allocate(size, alignof(std::max_align_t));
+  }
+#else
+  // 大きいオブジェクトは専用マッピングへ（移動しないため世代を問わない）
+  if (size >= m_config.largeObjectThreshold || gen == ExtendedGeneration::LargeObj) {
+    memory = m_largeObjectSpace ? m_largeObjectSpace->allocate(size)
+                                : m_allocator->allocateLarge(size);
+  } else if (m_numaActive) {
+    // ノード別ヒープから割り当て（固定ノードがなければ割り当てスレッドのノード）
+    int node = m_heapNode >= 0 ? m_heapNode : currentNumaNode();
+    if (node < 0 || static_cast<size_t>(node) >= m_nodeHeaps.size()) {
+      node = 0;
+    }
+    memory = m_nodeHeaps[node]->allocate(size, alignof(std::max_align_t));
+  } else {
+    // 世代別に適切な領域から割り当て
+    switch (gen) {
+      case ExtendedGeneration::Nursery:
+        memory = m_allocator->allocateFromNursery(size);
+        break;
+        
+      case ExtendedGeneration::Young:
+        memory = m_allocator->allocateFromYoung(size);
+        break;
+        
+      case ExtendedGeneration::Medium:
+        memory = m_allocator->allocateFromMedium(size);
+        break;
+        
+      case ExtendedGeneration::Old:
+        memory = m_allocator->allocateFromOld(size);
+        break;
+        
+      case ExtendedGeneration::LargeObj:
+        break;
+    }
   }
+#endif
   
-  // 世代別に適切な領域から割り当て
-  switch (gen) {
-    case ExtendedGeneration::Nursery:
-      return m_allocator->allocateFromNursery(size);
-      
-    case ExtendedGeneration::Young:
-      return m_allocator->allocateFromYoung(size);
-      
-    case ExtendedGeneration::Medium:
-      return m_allocator->allocateFromMedium(size);
-      
-    case ExtendedGeneration::Old:
-      return m_allocator->allocateFromOld(size);
-      
-    case ExtendedGeneration::LargeObj:
-      return m_allocator->allocateLarge(size);
-      
-    default:
-      return nullptr;
+  // 世代はアドレスを変えずに昇格するため、全割り当てをカード表で覆う
+  if (memory) {
+    m_cardTable->ensureCovered(memory, size);
+    m_totalAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    m_heapUsedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (gen == ExtendedGeneration::Nursery) {
+      m_nurseryAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
   }
+  
+  return memory;
 }
 
 // メモリ解放
 void ParallelGC::freeRaw(void* ptr, size_t size) {
-  if (ptr) {
-    m_allocator->deallocate(ptr, size);
+  if (!ptr) {
+    return;
+  }
+  
+  size_t used = m_heapUsedBytes.load(std::memory_order_relaxed);
+  m_heapUsedBytes.store(used > size ? used - size : 0, std::memory_order_relaxed);
+  
+  releaseRaw(ptr, size);
+}
+
+// セルのデストラクタをその場で呼び、メモリを割り当て元へ返す
+// （スイープの使用量は completeCollection がまとめて差し引く）
+void ParallelGC::destroyCell(GCCell* cell) {
+  size_t size = cell->getSize();
+  cell->~GCCell();
+  releaseRaw(cell, size);
+}
+
+// allocateRaw が使った領域（ケージ・大きいオブジェクト空間・ノード別ヒープ・世代領域）へ返す
+void ParallelGC::releaseRaw(void* ptr, size_t size) {
+#ifdef AEROJS_POINTER_COMPRESSION
+  if (HeapCage::instance().contains(ptr)) {
+    if (size >= m_config.largeObjectThreshold) {
+      HeapCage::instance().releaseRegion(ptr, size);
+    } else {
+      HeapCage::freeObject(ptr);
+    }
+    return;
+  }
+#endif
+  if (m_largeObjectSpace && m_largeObjectSpace->release(ptr) > 0) {
+    return;
+  }
+  if (m_numaActive) {
+    int node = NumaPagePool::instance().nodeOf(ptr);
+    if (node >= 0 && static_cast<size_t>(node) < m_nodeHeaps.size()) {
+      m_nodeHeaps[node]->deallocate(ptr);
+      return;
+    }
+  }
+  m_allocator->deallocate(ptr, size);
+}
+
+// ヒープ上限の設定（上限接近コールバックに渡す初期上限もこの値になる）
+void ParallelGC::setHeapLimit(size_t bytes) {
+#ifdef AEROJS_POINTER_COMPRESSION
+  bytes = std::min(bytes, HeapCage::kCageSize);
+#endif
+  m_heapLimit.store(bytes, std::memory_order_relaxed);
+  m_initialHeapLimit = bytes;
+  m_config.maxHeapSize = bytes;
+}
+
+void ParallelGC::setNearHeapLimitCallback(NearHeapLimitCallback callback) {
+  m_nearHeapLimitCallback = std::move(callback);
+}
+
+void ParallelGC::setHeapLimitTerminationHandler(std::function<void()> handler) {
+  m_heapLimitTerminationHandler = std::move(handler);
+}
+
+void ParallelGC::setCollectionCompleteCallback(std::function<void()> callback) {
+  m_collectionCompleteCallback = std::move(callback);
+}
+
+// ヒープ上限を超える割り当ての低速パス
+//
+// メジャーGC → 上限接近コールバック（上限の引き上げか打ち切り） → 回収量が尽きるまでの
+// 全回収、の順に試し、それでも収まらなければ実行の打ち切りを要求して HeapLimitExceeded を投げる。
+void ParallelGC::ensureHeapLimit(size_t size) {
+  auto fits = [this, size]() {
+    return getHeapUsedBytes() + size <= getHeapLimit();
+  };
+  
+  // コールバック内の割り当ては打ち切りの判断材料を作るためのものなので通す
+  if (m_inNearHeapLimitCallback) {
+    return;
+  }
+  
+  majorCollection(GCCause::LowMemory);
+  if (fits()) {
+    return;
+  }
+  
+  if (m_nearHeapLimitCallback) {
+    m_stats.nearHeapLimitCallbacks++;
+    m_inNearHeapLimitCallback = true;
+    NearHeapLimitDecision decision;
+    try {
+      decision = m_nearHeapLimitCallback(getHeapUsedBytes(), getHeapLimit(), m_initialHeapLimit);
+    } catch (...) {
+      m_inNearHeapLimitCallback = false;
+      throw;
+    }
+    m_inNearHeapLimitCallback = false;
+    
+    if (decision.terminate) {
+      reportHeapLimitReached(size);
+    }
+    
+    size_t newLimit = decision.newLimit;
+#ifdef AEROJS_POINTER_COMPRESSION
+    newLimit = std::min(newLimit, HeapCage::kCageSize);
+#endif
+    if (newLimit > getHeapLimit()) {
+      m_heapLimit.store(newLimit, std::memory_order_relaxed);
+      m_config.maxHeapSize = std::max(m_config.maxHeapSize, newLimit);
+      if (fits()) {
+        return;
+      }
+    }
+  }
+  
+  collectAllAvailableGarbage();
+  if (fits()) {
+    return;
+  }
+  
+  reportHeapLimitReached(size);
+}
+
+// 最終手段の全回収（前回の回収で到達不能になったセルが尽きるまでメジャーGCを繰り返す）
+void ParallelGC::collectAllAvailableGarbage() {
+  constexpr int kMaxLastResortGCs = 7;
+  
+  m_stats.lastResortGCs++;
+  for (int i = 0; i < kMaxLastResortGCs; ++i) {
+    size_t before = getHeapUsedBytes();
+    majorCollection(GCCause::LowMemory);
+    if (getHeapUsedBytes() >= before) {
+      break;
+    }
   }
 }
 
+void ParallelGC::reportHeapLimitReached(size_t size) {
+  m_stats.heapLimitTerminations++;
+  if (m_heapLimitTerminationHandler) {
+    m_heapLimitTerminationHandler();
+  }
+  throw HeapLimitExceeded(size, getHeapUsedBytes(), getHeapLimit());
+}
+
 // 世代への追加
 void ParallelGC::addToGeneration(GCCell* cell, ExtendedGeneration gen) {
   if (!cell) return;
   
+  // インクリメンタルマーキング中の新規セルは黒で割り当てる
+  if (m_incrementalMarkingActive) {
+    cell->state = CellState::Black;
+  }
+  
   switch (gen) {
     case ExtendedGeneration::Nursery:
       m_nurseryGen.push_back(cell);
@@ -1399,123 +1913,127 @@ void ParallelGC::promoteObject(GCCell* object, ExtendedGeneration targetGen) {
 
 // コンパクション処理
 void ParallelGC::compact() {
-  if (!m_config.enableCompaction) {
+  if (!m_config.enableCompaction || m_oldGen.empty()) {
     return;
   }
   
-  auto compactStart = std::chrono::steady_clock::now();
+  // 断片化したページを退避候補として選定
+  size_t candidates = m_compactor->selectCandidates(m_oldGen);
+  m_stats.evacuationCandidatePages += candidates;
   
-  // オールド世代のみコンパクション対象
-  if (m_oldGen.empty()) {
-    return;
+  float liveRatio = 0.0f;
+  if (m_stats.currentHeapSize > 0) {
+    liveRatio = static_cast<float>(getUsedMemory()) / static_cast<float>(m_stats.currentHeapSize);
   }
+  m_stats.fragmentationRatio = 1.0f - std::min(1.0f, liveRatio);
+  m_stats.isHeapFragmented = candidates > 0;
   
-  // フォワーディングアドレステーブルの構築
-  std::unordered_map<GCCell*, GCCell*> forwardingTable;
-  size_t totalSize = 0;
-  
-  // 生存オブジェクトのサイズ計算
-  for (auto* cell : m_oldGen) {
-    if (cell->state != CellState::White) {
-      totalSize += cell->getSize();
-    }
+  if (candidates == 0) {
+    m_compactionPending = false;
+    return;
   }
   
-  // コンパクション用の連続領域確保
-  uint8_t* newArea = static_cast<uint8_t*>(m_allocator->allocateContiguous(totalSize));
-  if (!newArea) {
-    // 連続領域の確保に失敗
+  if (m_config.enableIdleCompaction) {
+    // 退避はミューテータのアイドル期間に実行する
+    m_compactionPending = true;
     return;
   }
   
-  // オブジェクトを新領域にコピーしてフォワーディングアドレス設定
-  uint8_t* current = newArea;
-  for (auto* cell : m_oldGen) {
-    if (cell->state != CellState::White) {
-      size_t size = cell->getSize();
-      
-      // オブジェクトをコピー
-      std::memcpy(current, cell, size);
-      
-      // フォワーディングアドレス設定
-      GCCell* newCell = reinterpret_cast<GCCell*>(current);
-      forwardingTable[cell] = newCell;
-      cell->forwardingAddress = newCell;
-      
-      current += size;
-    }
-  }
+  runCompaction();
+}
+
+// 選定済み候補ページの退避とポインタ更新
+void ParallelGC::runCompaction() {
+  auto compactStart = std::chrono::steady_clock::now();
   
-  // すべての参照を更新
-  for (auto& entry : forwardingTable) {
-    GCCell* newCell = entry.second;
-    
-    // オブジェクト内の参照を更新
-    newCell->visitMutableReferences([&forwardingTable](GCCell** ref) {
-      if (*ref) {
-        auto it = forwardingTable.find(*ref);
-        if (it != forwardingTable.end()) {
-          *ref = it->second;
-        }
-      }
-    });
-  }
+  // 並列退避（退避先はセルごとにオールド世代から確保し、release でセルごとに解放）
+  m_compactor->evacuate([this](size_t size) {
+    return allocateRaw(size, ExtendedGeneration::Old);
+  });
+  
+  // 全世代の生存セルを対象に参照を並列更新
+  std::vector<GCCell*> liveCells;
+  liveCells.reserve(m_nurseryGen.size() + m_youngGen.size() + m_mediumGen.size() +
+                    m_oldGen.size() + m_largeObjects.size());
+  liveCells.insert(liveCells.end(), m_nurseryGen.begin(), m_nurseryGen.end());
+  liveCells.insert(liveCells.end(), m_youngGen.begin(), m_youngGen.end());
+  liveCells.insert(liveCells.end(), m_mediumGen.begin(), m_mediumGen.end());
+  liveCells.insert(liveCells.end(), m_oldGen.begin(), m_oldGen.end());
+  liveCells.insert(liveCells.end(), m_largeObjects.begin(), m_largeObjects.end());
   
-  // ルート参照を更新
   {
     std::lock_guard<std::mutex> lock(m_rootsMutex);
-    for (auto root : m_roots) {
-      if (*root) {
-        auto it = forwardingTable.find(*root);
-        if (it != forwardingTable.end()) {
-          *root = it->second;
-        }
-      }
-    }
+    m_compactor->updatePointers(liveCells, m_roots, m_cardTable.get());
   }
   
-  // 古いオブジェクトを解放し、新しいオブジェクトリストを構築
-  std::vector<GCCell*> newOldGen;
-  newOldGen.reserve(forwardingTable.size());
+  // 退避元の解放と弱ハンドルの再マップ
+  std::unordered_map<void*, void*> relocated;
+  m_compactor->release(m_oldGen, [this](void* ptr, size_t size) {
+    freeRaw(ptr, size);
+  }, &relocated);
   
-  for (auto* cell : m_oldGen) {
-    if (cell->state != CellState::White) {
-      // 生存オブジェクトは新しいバージョンをリストに追加
-      newOldGen.push_back(static_cast<GCCell*>(cell->forwardingAddress));
-    } else {
-      // 死んだオブジェクトは直接解放
-      delete cell;
-    }
+  if (!relocated.empty()) {
+    m_handleManager->afterGC({}, relocated);
   }
   
-  // 古いリストを新しいリストに置き換え
-  m_oldGen = std::move(newOldGen);
+  const CompactionResult& result = m_compactor->result();
+  m_stats.relocatedObjects += result.evacuatedObjects;
+  m_stats.relocatedBytes += result.evacuatedBytes;
+  m_stats.abortedEvacuationPages += result.abortedPages;
+  m_stats.compactionCount++;
+  m_compactionPending = false;
+  m_oldSpaceIndexDirty = true;
   
   auto compactEnd = std::chrono::steady_clock::now();
-  m_stats.totalCompactionTimeMs += std::chrono::duration_cast<std::chrono::milliseconds>(compactEnd - compactStart).count();
+  auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(compactEnd - compactStart).count();
+  m_stats.totalCompactionTimeMs += elapsedMs;
+  
+  // アイドル予算見積もり用の退避スループット（指数移動平均）
+  if (result.evacuatedBytes > 0) {
+    double bytesPerMs = static_cast<double>(result.evacuatedBytes) / std::max<int64_t>(1, elapsedMs);
+    m_compactionBytesPerMs = m_compactionBytesPerMs > 0.0
+      ? m_compactionBytesPerMs * 0.7 + bytesPerMs * 0.3
+      : bytesPerMs;
+  }
 }
 
-// 書き込みバリア
-void ParallelGC::writeBarrier(GCCell* parent, GCCell* child) {
-  if (!parent || !child) {
-    return;
+// アイドルタスク
+bool ParallelGC::performIdleTask(std::chrono::steady_clock::time_point deadline) {
+  if (!m_gcEnabled || !m_compactionPending) {
+    return false;
   }
   
-  m_stats.writeBarrierInvocations++;
+  // 退避スループットから所要時間を見積もり、期限に収まらなければ見送る
+  auto now = std::chrono::steady_clock::now();
+  auto remainingMs = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+  if (remainingMs <= 0) {
+    return false;
+  }
+  if (m_compactionBytesPerMs > 0.0) {
+    double estimatedMs = static_cast<double>(m_compactor->pendingBytes()) / m_compactionBytesPerMs;
+    if (estimatedMs > static_cast<double>(remainingMs)) {
+      return false;
+    }
+  }
   
-  // 親と子の世代をチェック
-  ExtendedGeneration parentGen = static_cast<ExtendedGeneration>(parent->generation);
-  ExtendedGeneration childGen = static_cast<ExtendedGeneration>(child->generation);
+  bool expected = false;
+  if (!m_collectionInProgress.compare_exchange_strong(expected, true)) {
+    return false;
+  }
   
-  // 子が親より若い世代の場合、記憶セットに追加（古→若の参照をトラック）
-  if (static_cast<int>(parentGen) > static_cast<int>(childGen)) {
-    m_rememberSet->add(parent, child);
-    m_stats.rememberSetEntries++;
+  try {
+    // 保留後に昇格・回収が起きている可能性があるため候補を選び直す
+    if (m_compactor->selectCandidates(m_oldGen) > 0) {
+      runCompaction();
+    } else {
+      m_compactionPending = false;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "GC compaction error: " << e.what() << std::endl;
   }
   
-  // カードテーブルを更新（コレクション対象世代の効率的な特定に使用）
-  m_cardTable->markCard(parent);
-  m_stats.cardTableUpdates++;
+  m_collectionInProgress = false;
+  return true;
 }
 
 // Valueを含む書き込みバリア
@@ -1536,8 +2054,9 @@ template<typename T, typename... Args>
 T* ParallelGC::allocate(Args&&... args) {
   // GC圧迫チェック
   float heapUsage = getHeapUsageRatio();
-  if (heapUsage >= m_config.minorGCTriggerRatio) {
-    // メモリ圧迫時にGCを実行
+  if (heapUsage >= m_config.minorGCTriggerRatio ||
+      getNurseryAllocatedBytes() >= m_config.nurserySize) {
+    // メモリ圧迫時、またはナーサリーが埋まった時にGCを実行
     minorCollection(GCCause::Allocation);
   }
   
@@ -1550,16 +2069,21 @@ T* ParallelGC::allocate(Args&&... args) {
     targetGen = ExtendedGeneration::LargeObj;
   }
   
+  // ヒープ上限判定（上限内なら加算と比較のみ）
+  if (getHeapUsedBytes() + size > getHeapLimit()) {
+    ensureHeapLimit(size);
+  }
+  
   // メモリ領域確保
   void* memory = allocateRaw(size, targetGen);
   if (!memory) {
     // メモリ割り当て失敗時に緊急GC実行
     majorCollection(GCCause::Allocation);
     
-    // 再試行
+    // 再試行（アロケータが確保できない場合も上限到達として実行を打ち切る）
     memory = allocateRaw(size, targetGen);
     if (!memory) {
-      throw std::bad_alloc();
+      reportHeapLimitReached(size);
     }
   }
   
@@ -1572,6 +2096,9 @@ T* ParallelGC::allocate(Args&&... args) {
   // 管理対象に追加
   addToGeneration(obj, targetGen);
   
+  // コンパクション等のGC内部の割り当ては通らないよう、ミューテータの割り当て経路でのみ記録
+  m_samplingProfiler.onAllocation(size, typeid(T));
+  
   return obj;
 }
 
@@ -1587,6 +2114,10 @@ T* ParallelGC::allocateLarge(Args&&... args) {
   
   // メモリ割り当て
   size_t size = sizeof(T);
+  if (getHeapUsedBytes() + size > getHeapLimit()) {
+    ensureHeapLimit(size);
+  }
+  
   void* memory = allocateRaw(size, ExtendedGeneration::LargeObj);
   
   if (!memory) {
@@ -1596,7 +2127,7 @@ T* ParallelGC::allocateLarge(Args&&... args) {
     // 再試行
     memory = allocateRaw(size, ExtendedGeneration::LargeObj);
     if (!memory) {
-      throw std::bad_alloc();
+      reportHeapLimitReached(size);
     }
   }
   
@@ -1609,6 +2140,8 @@ T* ParallelGC::allocateLarge(Args&&... args) {
   // 大きいオブジェクトセットに追加
   m_largeObjects.insert(obj);
   
+  m_samplingProfiler.onAllocation(size, typeid(T));
+  
   return obj;
 }
 
@@ -1616,6 +2149,15 @@ T* ParallelGC::allocateLarge(Args&&... args) {
 bool ParallelGC::stealWork(int threadId, GCCell*& cell) {
   size_t queueCount = m_markingQueues.size();
   
+  // 同じノードのワーカーから先に盗む（他ノードのセルは遠隔アクセスになる）
+  if (m_numaActive) {
+    for (uint32_t targetId : m_nodeQueues[m_workerNodes[threadId]]) {
+      if (static_cast<int>(targetId) != threadId && m_markingQueues[targetId]->steal(cell)) {
+        return true;
+      }
+    }
+  }
+  
   for (size_t i = 1; i < queueCount; ++i) {
     size_t targetId = (threadId + i) % queueCount;
     if (m_markingQueues[targetId]->steal(cell)) {
@@ -1626,6 +2168,37 @@ bool ParallelGC::stealWork(int threadId, GCCell*& cell) {
   return false;
 }
 
+// NUMA配置の初期化
+// 複数ノードの環境（または heapNode 指定時）だけ有効にし、単一ノードでは従来の経路のまま
+void ParallelGC::initNumaPlacement(uint32_t workerCount) {
+  const NumaTopology& topology = NumaTopology::get();
+  int nodeCount = std::min(topology.nodeCount(), NumaPagePool::kMaxNodes);
+  m_heapNode = m_config.heapNode < nodeCount ? m_config.heapNode : -1;
+  m_numaActive = m_config.numaAware && (nodeCount > 1 || m_heapNode >= 0);
+  if (!m_numaActive) {
+    return;
+  }
+  
+  auto& pool = NumaPagePool::instance();
+  m_nodeHeaps.resize(nodeCount);
+  for (int node = 0; node < nodeCount; ++node) {
+    m_nodeHeaps[node] = std::make_unique<SizeClassAllocator>(pool.regionSource(node));
+  }
+  
+  // ワーカーをノードへ順に割り当てる（ヒープを固定した場合は全員そのノード）
+  m_workerNodes.resize(workerCount);
+  m_nodeQueues.assign(nodeCount, {});
+  for (uint32_t i = 0; i < workerCount; ++i) {
+    int node = m_heapNode >= 0 ? m_heapNode : static_cast<int>(i % nodeCount);
+    m_workerNodes[i] = node;
+    m_nodeQueues[node].push_back(i);
+  }
+}
+
+int ParallelGC::ownerNodeOf(const GCCell* cell) const {
+  return m_numaActive ? NumaPagePool::instance().nodeOf(cell) : -1;
+}
+
 // スループットやGC時間に基づいてワーカースレッド数を調整
 void ParallelGC::adjustWorkerThreadCount() {
     auto currentTime = std::chrono::high_resolution_clock::now();
@@ -21,10 +21,21 @@
 #include <chrono>
 #include <array>
 #include <bitset>
+#include <cstring>
 
 #include "../../../core/runtime/values/value.h"
 #include "../allocators/memory_allocator.h"
+#include "../allocators/size_class_allocator.h"
 #include "generational_gc.h"
+#include "card_table.h"
+#include "mark_compact.h"
+#include "large_object_space.h"
+#include "sampling_heap_profiler.h"
+#include "heap_limit.h"
+
+namespace aero {
+class HandleManager;
+}
 
 namespace aerojs {
 namespace utils {
@@ -52,6 +63,10 @@ struct ParallelGCConfig {
   uint32_t mutatorQuantum = 5;                 // ミューテータ量子（ms）
   uint32_t markingStepSize = 1024;             // 1ステップあたりのマーキング数
   
+  // NUMA設定（複数ノードの環境、または heapNode 指定時のみ有効）
+  bool numaAware = true;                       // ノード別ページプールとワーカーのノード固定
+  int heapNode = -1;                           // ヒープを固定するノード（-1は割り当てスレッドのノード）
+  
   // GC間隔設定
   uint32_t minorGCInterval = 500;              // マイナーGC間隔（ms）
   uint32_t mediumGCInterval = 5000;            // ミディアムGC間隔（ms）
@@ -66,7 +81,7 @@ struct ParallelGCConfig {
   bool enableIncrementalMarking = true;        // インクリメンタルマーキング有効化
   bool enableConcurrentMarking = true;         // 並行マーキング有効化
   bool enableConcurrentSweeping = true;        // 並行スイーピング有効化
-  bool enableCompaction = true;                // コンパクション有効化
+  bool enableCompaction = false;               // オールド世代コンパクション有効化（オプトイン）
   bool enablePreciseSweeping = true;           // 精密スイーピング有効化
   bool enableAdaptiveCollection = true;        // 適応的コレクション有効化
   bool enableLazyReferences = true;            // 遅延参照追跡有効化
@@ -76,6 +91,13 @@ struct ParallelGCConfig {
   // バッファ設定
   size_t writeBarrierBufferSize = 4096;        // 書き込みバリアバッファサイズ
   size_t markingWorkQueueSize = 8192;          // マーキングワークキューサイズ
+  size_t parallelCardScanMinCards = 4 * 8192;  // ワーカーで分担して走査する最小のカード数（4リージョン分）
+  
+  // コンパクション設定
+  bool enableIdleCompaction = true;            // コンパクションをアイドルタスクとして遅延実行
+  size_t compactionPageSize = 256 * 1024;      // 断片化評価用ページサイズ（256KB）
+  float evacuationFragmentationThreshold = 0.5f; // 退避候補とするページ断片化率
+  size_t maxEvacuationBytes = 16 * 1024 * 1024;  // 1サイクルあたりの退避上限（16MB）
   
   // メモリサイズしきい値
   size_t largeObjectThreshold = 32 * 1024;     // 大きいオブジェクトしきい値（32KB）
@@ -127,9 +149,8 @@ struct ParallelGCStats : public GCStats {
   size_t totalIncrementalMarkSteps = 0;        // インクリメンタルマーキングステップ数
   size_t totalConcurrentMarkSteps = 0;         // 並行マーキングステップ数
   
-  size_t writeBarrierInvocations = 0;          // 書き込みバリア呼び出し数
-  size_t cardTableUpdates = 0;                 // カードテーブル更新数
-  size_t rememberSetEntries = 0;               // 記憶セットエントリ数
+  size_t dirtyCardsScanned = 0;                // スカベンジで走査したダーティカード数
+  size_t cardsRetained = 0;                    // 走査後もダーティのまま残したカード数
   
   // GCカウント統計
   size_t minorGCCount = 0;                     // マイナーGC実行回数
@@ -140,6 +161,20 @@ struct ParallelGCStats : public GCStats {
   uint64_t totalMajorGCTimeMs = 0;             // メジャーGC合計時間
   size_t promotionCount = 0;                   // オブジェクト昇格回数
   
+  // コンパクション統計
+  size_t compactionCount = 0;                  // コンパクション実行回数
+  size_t evacuationCandidatePages = 0;         // 退避候補ページ累計
+  size_t abortedEvacuationPages = 0;           // 退避を中止したページ累計
+  
+  // 大きいオブジェクト空間統計
+  size_t largeObjectsReleased = 0;             // マッピングごと返却した大きいオブジェクト数
+  size_t largeObjectBytesUnmapped = 0;         // munmapでOSへ返却したバイト数
+  
+  // ヒープ上限統計
+  size_t nearHeapLimitCallbacks = 0;           // 上限接近コールバックの呼び出し回数
+  size_t lastResortGCs = 0;                    // 最終手段の全回収を行った回数
+  size_t heapLimitTerminations = 0;            // 上限超過で実行を打ち切った回数
+  
   // 世代別統計
   std::array<size_t, 5> generationObjectCount = {0}; // 世代別オブジェクト数
   std::array<size_t, 5> generationByteSize = {0};    // 世代別バイトサイズ
@@ -164,47 +199,6 @@ struct ParallelGCStats : public GCStats {
   float fragmentationRatio = 0.0f;             // 断片化率
 };
 
-// カード表
-class CardTable {
-public:
-  CardTable(size_t heapSize, size_t cardSize = 512);
-  ~CardTable();
-  
-  void markCard(void* ptr);
-  bool isCardMarked(void* ptr) const;
-  void clearCard(void* ptr);
-  void clearAll();
-  
-  uint8_t* cardFor(void* ptr) const;
-  size_t getCardCount() const { return m_cardCount; }
-  
-private:
-  uint8_t* m_cards;
-  size_t m_cardCount;
-  size_t m_cardSize;
-  size_t m_heapSize;
-  size_t m_heapStart;
-};
-
-// 記憶セット（リメンバーセット）
-class RememberSet {
-public:
-  RememberSet();
-  ~RememberSet();
-  
-  void add(GCCell* fromObject, GCCell* toObject);
-  void remove(GCCell* fromObject, GCCell* toObject);
-  bool contains(GCCell* fromObject, GCCell* toObject) const;
-  const std::unordered_set<GCCell*>& getReferencesFrom(GCCell* obj) const;
-  const std::unordered_set<GCCell*>& getReferencesTo(GCCell* obj) const;
-  void clear();
-  
-private:
-  std::unordered_map<GCCell*, std::unordered_set<GCCell*>> m_fromToRefs;
-  std::unordered_map<GCCell*, std::unordered_set<GCCell*>> m_toFromRefs;
-  mutable std::mutex m_mutex;
-};
-
 // ワークスティーリングキュー（作業盗取型キュー）
 template<typename T>
 class WorkStealingQueue {
@@ -242,8 +236,16 @@ public:
   T* allocateLarge(Args&&... args);
   
   // 値の記録（書き込みバリア）
+  // 世代判定もロックも行わず親セルのカードを汚す。インクリメンタルマーキング中のみ
+  // 黒→白参照を作らないよう子を灰色化する
   void writeBarrier(GCCell* object, const aerojs::core::runtime::Value& value);
-  void writeBarrier(GCCell* parent, GCCell* child);
+  inline void writeBarrier(GCCell* parent, GCCell* child) {
+    m_cardTable->markCard(parent);
+    if (m_incrementalMarkingActive.load(std::memory_order_relaxed) &&
+        child && child->state == CellState::White) {
+      mark(child);
+    }
+  }
   
   // GC実行
   void collectGarbage(GCType type, GCCause cause);
@@ -251,8 +253,16 @@ public:
   void mediumCollection(GCCause cause = GCCause::Scheduled);
   void majorCollection(GCCause cause = GCCause::Scheduled);
   
-  // インクリメンタルマーキングステップ
+  // インクリメンタルマーキング（開始→ステップ→完了の順にミューテータスレッドから呼ぶ）
+  bool startIncrementalMarking(GCType type, GCCause cause = GCCause::Idle);
   void incrementalMarkingStep(size_t stepSize = 0);
+  void finishIncrementalCollection();
+  bool isIncrementalMarkingActive() const { return m_incrementalMarkingActive.load(); }
+  bool isMarkingWorkEmpty() const;
+  
+  // アイドルタスク（期限内に保留中のコンパクションを実行）
+  bool performIdleTask(std::chrono::steady_clock::time_point deadline);
+  bool hasPendingIdleWork() const { return m_compactionPending.load(); }
   
   // GC制御
   void enableGC(bool enable);
@@ -261,9 +271,38 @@ public:
   void scheduleMediumGC(uint32_t delayMs = 0);
   void scheduleMajorGC(uint32_t delayMs = 0);
   
+  // 世代サイズ（GCコントローラが割り当てレートに応じて調整）
+  void setNurserySize(size_t bytes) { m_config.nurserySize = bytes; }
+  size_t getNurserySize() const { return m_config.nurserySize; }
+  size_t getNurseryAllocatedBytes() const { return m_nurseryAllocatedBytes.load(std::memory_order_relaxed); }
+  uint64_t getTotalAllocatedBytes() const { return m_totalAllocatedBytes.load(std::memory_order_relaxed); }
+  
+  // ヒープ上限（割り当て済みセルの合計バイト数に対する上限。既定は maxHeapSize）
+  void setHeapLimit(size_t bytes);
+  size_t getHeapLimit() const { return m_heapLimit.load(std::memory_order_relaxed); }
+  size_t getHeapUsedBytes() const { return m_heapUsedBytes.load(std::memory_order_relaxed); }
+  void setNearHeapLimitCallback(NearHeapLimitCallback callback);
+  // 上限超過で HeapLimitExceeded を投げる直前に呼ばれる（エンジンが実行打ち切りを要求する）
+  void setHeapLimitTerminationHandler(std::function<void()> handler);
+  // 各コレクションの完了（統計の更新後）に、コレクションを実行したスレッドで呼ばれる
+  void setCollectionCompleteCallback(std::function<void()> callback);
+  
   // 統計情報
   const ParallelGCStats& getStats() const { return m_stats; }
   
+  // NUMA配置（無効なら -1／false）
+  bool isNumaAware() const { return m_numaActive; }
+  int getHeapNode() const { return m_heapNode; }
+  int getWorkerNode(uint32_t threadId) const {
+    return threadId < m_workerNodes.size() ? m_workerNodes[threadId] : -1;
+  }
+  
+  // サンプリング割り当てプロファイラ（停止中の割り当てコストはフラグ確認のみ）
+  SamplingHeapProfiler& getSamplingHeapProfiler() { return m_samplingProfiler; }
+  
+  // このヒープのハンドル（WeakHandle・GlobalHandle の作成とHandleScopeに使う）
+  aero::HandleManager& getHandleManager() { return *m_handleManager; }
+  
   // 弱参照管理
   WeakRef* createWeakRef(GCCell* target);
   void releaseWeakRef(WeakRef* ref);
@@ -277,20 +316,31 @@ public:
   void verifyHeap() const;
   void dumpHeapStats() const;
   
+  // ヒープスナップショットを逐次書き出す（解析は tools/heap_snapshot_analyzer で行う）
+  bool writeHeapSnapshot(const std::string& filename);
+  
 private:
   // ワーカースレッド管理
   void initWorkerThreads();
   void shutdownWorkerThreads();
   void workerThreadMain(int threadId);
+  void runOnWorkers(const std::function<void()>& task, size_t helperCount);
+  void runWorkerTask();
   
   // GC内部フェーズ
   void prepareCollection(GCType type);
+  void completeCollection(GCType type, GCCause cause, std::chrono::steady_clock::time_point startTime);
   void markRoots();
   void markConcurrent();
   void markIncrementalStep(size_t stepSize);
   void finishMarking();
+  void scanDirtyCards();
+  void rebuildOldSpaceIndex();
   void sweep(bool concurrent);
+  void sweepLargeObjects(size_t& freedObjs, size_t& freedMem);
+  void destroyLargeObject(GCCell* cell);
   void compact();
+  void runCompaction();
   void promoteObjects();
   
   // GC内部処理
@@ -299,11 +349,28 @@ private:
   void processMarkingWorkQueue(int threadId);
   bool stealWork(int threadId, GCCell*& cell);
   
+  // NUMA（セルの所有ノードとノード別キュー）
+  void initNumaPlacement(uint32_t workerCount);
+  int ownerNodeOf(const GCCell* cell) const;
+  
+  // スイープ（node >= 0 ならそのノードのページにあるセルだけを処理）
+  void performConcurrentSweep();
+  void performSynchronousSweep();
+  template<typename Container>
+  void sweepGeneration(Container& container, size_t& freedObjs, size_t& freedMem, int node = -1);
+  
   // メモリ管理
   void* allocateRaw(size_t size, ExtendedGeneration gen);
   void freeRaw(void* ptr, size_t size);
+  void releaseRaw(void* ptr, size_t size);  // 使用量を変えずに割り当て元へ返す
+  void destroyCell(GCCell* cell);           // デストラクタをその場で呼び、割り当て元へ返す
   void expandHeap(size_t additionalSize);
   
+  // ヒープ上限
+  void ensureHeapLimit(size_t size);
+  void collectAllAvailableGarbage();
+  [[noreturn]] void reportHeapLimitReached(size_t size);
+  
   // 世代管理
   void addToGeneration(GCCell* cell, ExtendedGeneration gen);
   void promoteObject(GCCell* object, ExtendedGeneration targetGen);
@@ -332,13 +399,38 @@ private:
   std::vector<GCCell*> m_oldGen;
   std::unordered_set<GCCell*> m_largeObjects;
   
-  // 記憶セットとカード表
-  std::unique_ptr<RememberSet> m_rememberSet;
+  // 大きいオブジェクト空間（移動せずその場でマークし、死亡時にmunmap）
+  std::unique_ptr<LargeObjectSpace> m_largeObjectSpace;
+  
+  // このヒープのセルだけを登録するハンドルテーブル（他のエンジンのハンドルは走査しない）
+  std::unique_ptr<aero::HandleManager> m_handleManager;
+  
+  // オールド世代コンパクタ
+  std::unique_ptr<MarkCompactor> m_compactor;
+  std::atomic<bool> m_compactionPending;
+  double m_compactionBytesPerMs;
+  
+  // カード表（オールド→ヤング参照の追跡）
   std::unique_ptr<CardTable> m_cardTable;
   
+  // カード走査用のアドレス順インデックス（ミディアム・オールド・大オブジェクト）
+  struct IndexedCell {
+    GCCell* cell;
+    ExtendedGeneration generation;
+  };
+  std::vector<IndexedCell> m_oldSpaceIndex;
+  bool m_oldSpaceIndexDirty;
+  
   // マーキングキュー
   std::vector<std::unique_ptr<WorkStealingQueue<GCCell*>>> m_markingQueues;
   
+  // NUMA配置（m_numaActive のときのみ使用）
+  bool m_numaActive;
+  int m_heapNode;
+  std::vector<std::unique_ptr<SizeClassAllocator>> m_nodeHeaps;  // ノード別ページプールから切り出すヒープ
+  std::vector<int> m_workerNodes;                                 // ワーカーごとの固定先ノード
+  std::vector<std::vector<uint32_t>> m_nodeQueues;                // ノードごとのワーカーキュー番号
+  
   // ルートオブジェクト
   std::vector<GCCell**> m_roots;
   std::mutex m_rootsMutex;
@@ -354,11 +446,34 @@ private:
   std::mutex m_workerMutex;
   std::condition_variable m_workerCV;
   
+  // ワーカーに配る単発の作業（runOnWorkers。m_workerMutex で保護）
+  const std::function<void()>* m_workerTask;
+  size_t m_workerTaskSlots;                 // まだ参加できるワーカー数
+  size_t m_workerTaskRunning;               // 作業中のワーカー数
+  std::condition_variable m_workerTaskDone;
+  
   // GC制御
   std::atomic<bool> m_gcEnabled;
   std::atomic<bool> m_collectionInProgress;
   std::atomic<bool> m_concurrentMarkingActive;
   std::atomic<bool> m_incrementalMarkingActive;
+  std::mutex m_incrementalMutex;
+  
+  // サンプリング割り当てプロファイラ
+  SamplingHeapProfiler m_samplingProfiler;
+  
+  // 割り当て量（GCコントローラの割り当てレート計測とナーサリー充填判定用）
+  std::atomic<uint64_t> m_totalAllocatedBytes;
+  std::atomic<size_t> m_nurseryAllocatedBytes;
+  
+  // ヒープ上限
+  std::atomic<size_t> m_heapUsedBytes;
+  std::atomic<size_t> m_heapLimit;
+  size_t m_initialHeapLimit;
+  NearHeapLimitCallback m_nearHeapLimitCallback;
+  std::function<void()> m_heapLimitTerminationHandler;
+  bool m_inNearHeapLimitCallback;
+  std::function<void()> m_collectionCompleteCallback;
   
   // GCスーパーバイザースレッド
   std::thread m_supervisorThread;
@@ -0,0 +1,466 @@
+/**
+ * @file sampling_heap_profiler.cpp
+ * @brief ポアソンサンプリングによる割り当てプロファイラの実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "sampling_heap_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <random>
+#include <thread>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+thread_local std::vector<SamplingHeapProfiler::ThreadStateEntry> SamplingHeapProfiler::t_states;
+
+namespace {
+
+std::atomic<uint64_t> g_nextProfilerId{1};
+
+std::string demangle(const char* name) {
+#if defined(__GNUG__)
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+  }
+#endif
+  return name;
+}
+
+// profile.proto の最小限のエンコーダ（依存ライブラリを増やさないため手書き）
+class ProtoWriter {
+public:
+  void varint(uint64_t value) {
+    while (value >= 0x80) {
+      m_out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+    }
+    m_out.push_back(static_cast<char>(value));
+  }
+
+  void tag(uint32_t field, uint32_t wireType) {
+    varint((static_cast<uint64_t>(field) << 3) | wireType);
+  }
+
+  void int64Field(uint32_t field, int64_t value) {
+    if (value != 0) {
+      tag(field, 0);
+      varint(static_cast<uint64_t>(value));
+    }
+  }
+
+  void bytesField(uint32_t field, const std::string& bytes) {
+    tag(field, 2);
+    varint(bytes.size());
+    m_out.append(bytes);
+  }
+
+  void packedField(uint32_t field, const std::vector<uint64_t>& values) {
+    if (values.empty()) {
+      return;
+    }
+    ProtoWriter packed;
+    for (uint64_t value : values) {
+      packed.varint(value);
+    }
+    bytesField(field, packed.str());
+  }
+
+  void messageField(uint32_t field, const ProtoWriter& message) {
+    bytesField(field, message.str());
+  }
+
+  const std::string& str() const { return m_out; }
+
+private:
+  std::string m_out;
+};
+
+// pprof の文字列表（添字0は空文字列）
+class StringTable {
+public:
+  StringTable() { intern(""); }
+
+  int64_t intern(const std::string& value) {
+    auto it = m_index.find(value);
+    if (it != m_index.end()) {
+      return it->second;
+    }
+    int64_t index = static_cast<int64_t>(m_strings.size());
+    m_strings.push_back(value);
+    m_index.emplace(value, index);
+    return index;
+  }
+
+  const std::vector<std::string>& strings() const { return m_strings; }
+
+private:
+  std::vector<std::string> m_strings;
+  std::unordered_map<std::string, int64_t> m_index;
+};
+
+// profile.proto のフィールド番号
+enum ProfileField : uint32_t {
+  kProfileSampleType = 1,
+  kProfileSample = 2,
+  kProfileLocation = 4,
+  kProfileFunction = 5,
+  kProfileStringTable = 6,
+  kProfileTimeNanos = 9,
+  kProfileDurationNanos = 10,
+  kProfilePeriodType = 11,
+  kProfilePeriod = 12
+};
+
+}  // namespace
+
+SamplingHeapProfiler::SamplingHeapProfiler()
+  : m_id(g_nextProfilerId.fetch_add(1, std::memory_order_relaxed)),
+    m_active(false),
+    m_epoch(1),
+    m_sampleInterval(kDefaultSampleInterval),
+    m_maxFrames(kDefaultMaxFrames),
+    m_totalSamples(0),
+    m_startTimeNanos(0)
+{
+}
+
+SamplingHeapProfiler::~SamplingHeapProfiler() {
+  stop();
+
+  // このスレッドの状態からは外す（他スレッドの古い項目は識別子が一致しないため使われない）
+  for (size_t i = 0; i < t_states.size(); ++i) {
+    if (t_states[i].profilerId == m_id) {
+      t_states[i] = t_states.back();
+      t_states.pop_back();
+      break;
+    }
+  }
+}
+
+SamplingHeapProfiler::ThreadState& SamplingHeapProfiler::addThreadState() {
+  t_states.push_back({m_id, ThreadState()});
+  return t_states.back().state;
+}
+
+void SamplingHeapProfiler::start(size_t sampleInterval, AllocationStackCapture capture, size_t maxFrames) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_sampleInterval = sampleInterval > 0 ? sampleInterval : kDefaultSampleInterval;
+  m_maxFrames = maxFrames;
+  m_capture = std::move(capture);
+
+  m_nodes.clear();
+  m_nodes.push_back(CallTreeNode{0, UINT32_MAX, 0, 0});
+  m_children.clear();
+  m_functions.clear();
+  m_functionIndex.clear();
+  m_nativeFunctionIndex.clear();
+  m_typeNames.clear();
+  m_typeIndex.clear();
+  m_samples.clear();
+  m_sampleIndex.clear();
+  m_totalSamples.store(0, std::memory_order_relaxed);
+  m_startTimeNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  m_epoch.fetch_add(1, std::memory_order_relaxed);
+  m_active.store(true, std::memory_order_release);
+}
+
+void SamplingHeapProfiler::stop() {
+  m_active.store(false, std::memory_order_release);
+}
+
+// 指数分布に従う次のサンプル点までの距離（平均 m_sampleInterval）
+int64_t SamplingHeapProfiler::nextSampleDistance(ThreadState& state) const {
+  if (state.rngState == 0) {
+    state.rngState = std::random_device{}() ^
+                     (static_cast<uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) << 1) ^
+                     0x9E3779B97F4A7C15ULL;
+  }
+
+  // xorshift64*（サンプル時のみ呼ばれるため品質よりも軽さを優先）
+  state.rngState ^= state.rngState >> 12;
+  state.rngState ^= state.rngState << 25;
+  state.rngState ^= state.rngState >> 27;
+  uint64_t bits = state.rngState * 0x2545F4914F6CDD1DULL;
+
+  double u = (static_cast<double>(bits >> 11) + 1.0) / 9007199254740993.0;  // (0, 1]
+  double distance = -std::log(u) * static_cast<double>(m_sampleInterval);
+  return std::max<int64_t>(1, static_cast<int64_t>(distance));
+}
+
+void SamplingHeapProfiler::recordSample(size_t size, const std::type_info& type) {
+  ThreadState& state = threadState();
+  uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+
+  // 開始後に初めて割り当てたスレッドは距離を引くだけ（この割り当ては記録しない）
+  if (state.epoch != epoch) {
+    state.epoch = epoch;
+    state.bytesUntilSample = nextSampleDistance(state);
+    return;
+  }
+
+  // 大きい割り当ては複数のサンプル点をまたぎうる。超過分を捨てて次の距離を引き直す
+  state.bytesUntilSample = nextSampleDistance(state);
+
+  // スタック走査はロック外で行う（start() と競合しないようコールバックだけ複製する）
+  AllocationStackCapture capture;
+  size_t maxFrames;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    capture = m_capture;
+    maxFrames = m_maxFrames;
+  }
+
+  std::vector<AllocationFrame> frames;
+  if (capture) {
+    capture(frames, maxFrames);
+    if (frames.size() > maxFrames) {
+      frames.resize(maxFrames);
+    }
+  }
+  if (frames.empty()) {
+    AllocationFrame native;
+    native.functionName = "(native)";
+    frames.push_back(std::move(native));
+  }
+
+  double rate = 1.0 - std::exp(-static_cast<double>(size) / static_cast<double>(m_sampleInterval));
+  double weight = rate > 0.0 ? 1.0 / rate : 1.0;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_active.load(std::memory_order_relaxed) || m_nodes.empty()) {
+    return;
+  }
+
+  // 呼び出し木は外側（根）から割り当て箇所へ辿る
+  uint32_t node = 0;
+  for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+    node = childOf(node, internFunction(*it), *it);
+  }
+
+  SampleStats& stats = m_samples[sampleSlot(node, internType(type))];
+  stats.samples++;
+  stats.sampledBytes += size;
+  stats.estimatedCount += weight;
+  stats.estimatedBytes += weight * static_cast<double>(size);
+  m_totalSamples.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t SamplingHeapProfiler::internFunction(const AllocationFrame& frame) {
+  if (frame.function) {
+    auto it = m_functionIndex.find(frame.function);
+    if (it != m_functionIndex.end()) {
+      return it->second;
+    }
+  } else {
+    auto it = m_nativeFunctionIndex.find(frame.functionName);
+    if (it != m_nativeFunctionIndex.end()) {
+      return it->second;
+    }
+  }
+
+  uint32_t index = static_cast<uint32_t>(m_functions.size());
+  m_functions.push_back(FunctionInfo{
+      frame.functionName.empty() ? "(anonymous)" : frame.functionName,
+      frame.scriptName,
+      frame.line});
+  if (frame.function) {
+    m_functionIndex.emplace(frame.function, index);
+  } else {
+    m_nativeFunctionIndex.emplace(frame.functionName, index);
+  }
+  return index;
+}
+
+uint32_t SamplingHeapProfiler::internType(const std::type_info& type) {
+  std::type_index key(type);
+  auto it = m_typeIndex.find(key);
+  if (it != m_typeIndex.end()) {
+    return it->second;
+  }
+  uint32_t index = static_cast<uint32_t>(m_typeNames.size());
+  m_typeNames.push_back(demangle(type.name()));
+  m_typeIndex.emplace(key, index);
+  return index;
+}
+
+uint32_t SamplingHeapProfiler::childOf(uint32_t parent, uint32_t functionIndex, const AllocationFrame& frame) {
+  ChildKey key{parent, functionIndex, frame.bytecodeOffset};
+  auto it = m_children.find(key);
+  if (it != m_children.end()) {
+    return it->second;
+  }
+  uint32_t index = static_cast<uint32_t>(m_nodes.size());
+  m_nodes.push_back(CallTreeNode{parent, functionIndex, frame.bytecodeOffset, frame.line});
+  m_children.emplace(key, index);
+  return index;
+}
+
+uint32_t SamplingHeapProfiler::sampleSlot(uint32_t node, uint32_t typeIndex) {
+  uint64_t key = (static_cast<uint64_t>(node) << 32) | typeIndex;
+  auto it = m_sampleIndex.find(key);
+  if (it != m_sampleIndex.end()) {
+    return it->second;
+  }
+  uint32_t index = static_cast<uint32_t>(m_samples.size());
+  m_samples.push_back(SampleStats{node, typeIndex, 0, 0, 0.0, 0.0});
+  m_sampleIndex.emplace(key, index);
+  return index;
+}
+
+void SamplingHeapProfiler::forEachSample(const std::function<void(const SampleStats&)>& fn) const {
+  // コールバック内から他のアクセサを呼べるよう、複製してからロック外で渡す
+  std::vector<SampleStats> samples;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    samples = m_samples;
+  }
+  for (const SampleStats& stats : samples) {
+    fn(stats);
+  }
+}
+
+std::vector<uint32_t> SamplingHeapProfiler::stackOf(uint32_t node) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<uint32_t> stack;
+  for (uint32_t current = node; current != 0 && current < m_nodes.size(); current = m_nodes[current].parent) {
+    stack.push_back(current);
+  }
+  return stack;
+}
+
+SamplingHeapProfiler::CallTreeNode SamplingHeapProfiler::node(uint32_t index) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nodes.at(index);
+}
+
+SamplingHeapProfiler::FunctionInfo SamplingHeapProfiler::function(uint32_t index) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_functions.at(index);
+}
+
+std::string SamplingHeapProfiler::typeName(uint32_t index) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_typeNames.at(index);
+}
+
+std::string SamplingHeapProfiler::serializePprof() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  StringTable strings;
+  ProtoWriter profile;
+
+  auto valueType = [&strings](const char* type, const char* unit) {
+    ProtoWriter message;
+    message.int64Field(1, strings.intern(type));
+    message.int64Field(2, strings.intern(unit));
+    return message;
+  };
+
+  profile.messageField(kProfileSampleType, valueType("alloc_objects", "count"));
+  profile.messageField(kProfileSampleType, valueType("alloc_space", "bytes"));
+
+  // 関数とバイトコードオフセットの組ごとに1つのロケーション
+  std::map<std::pair<uint32_t, uint32_t>, uint64_t> locationIds;
+  std::vector<uint64_t> nodeLocations(m_nodes.size(), 0);
+  for (uint32_t i = 1; i < m_nodes.size(); i++) {
+    const CallTreeNode& treeNode = m_nodes[i];
+    auto key = std::make_pair(treeNode.functionIndex, treeNode.bytecodeOffset);
+    auto it = locationIds.find(key);
+    if (it == locationIds.end()) {
+      uint64_t id = locationIds.size() + 1;
+      it = locationIds.emplace(key, id).first;
+
+      ProtoWriter line;
+      line.int64Field(1, treeNode.functionIndex + 1);
+      line.int64Field(2, treeNode.line);
+
+      ProtoWriter location;
+      location.int64Field(1, static_cast<int64_t>(id));
+      location.int64Field(3, treeNode.bytecodeOffset);
+      location.messageField(4, line);
+      profile.messageField(kProfileLocation, location);
+    }
+    nodeLocations[i] = it->second;
+  }
+
+  for (uint32_t i = 0; i < m_functions.size(); i++) {
+    const FunctionInfo& info = m_functions[i];
+    ProtoWriter function;
+    function.int64Field(1, i + 1);
+    function.int64Field(2, strings.intern(info.name));
+    function.int64Field(3, strings.intern(info.name));
+    function.int64Field(4, strings.intern(info.scriptName));
+    function.int64Field(5, info.line);
+    profile.messageField(kProfileFunction, function);
+  }
+
+  int64_t typeKey = strings.intern("type");
+  for (const SampleStats& stats : m_samples) {
+    std::vector<uint64_t> locations;
+    for (uint32_t current = stats.node; current != 0; current = m_nodes[current].parent) {
+      locations.push_back(nodeLocations[current]);
+    }
+
+    std::vector<uint64_t> values{
+        static_cast<uint64_t>(std::llround(stats.estimatedCount)),
+        static_cast<uint64_t>(std::llround(stats.estimatedBytes))};
+
+    ProtoWriter label;
+    label.int64Field(1, typeKey);
+    label.int64Field(2, strings.intern(m_typeNames[stats.typeIndex]));
+
+    ProtoWriter sample;
+    sample.packedField(1, locations);
+    sample.packedField(2, values);
+    sample.messageField(3, label);
+    profile.messageField(kProfileSample, sample);
+  }
+
+  int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  profile.int64Field(kProfileTimeNanos, m_startTimeNanos);
+  profile.int64Field(kProfileDurationNanos, now - m_startTimeNanos);
+  profile.messageField(kProfilePeriodType, valueType("space", "bytes"));
+  profile.int64Field(kProfilePeriod, static_cast<int64_t>(m_sampleInterval));
+
+  // 文字列表は他のフィールドで添字を確定させてから最後に出力する
+  for (const std::string& value : strings.strings()) {
+    profile.bytesField(kProfileStringTable, value);
+  }
+
+  return profile.str();
+}
+
+bool SamplingHeapProfiler::writePprof(const std::string& filename) const {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::string data = serializePprof();
+  file.write(data.data(), static_cast<std::streamsize>(data.size()));
+  return static_cast<bool>(file);
+}
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,205 @@
+/**
+ * @file sampling_heap_profiler.h
+ * @brief ポアソンサンプリングによる割り当てプロファイラ
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+// サンプル時に取得するJSスタックの1フレーム
+struct AllocationFrame {
+  const void* function = nullptr;   // 関数の同一性（バイトコードブロックなど）
+  uint32_t bytecodeOffset = 0;      // 割り当て箇所（呼び出し元フレームでは呼び出し箇所）
+  std::string functionName;
+  std::string scriptName;
+  int line = 0;
+};
+
+// 割り当て箇所から外側へ向かう順にフレームを詰めるコールバック
+using AllocationStackCapture = std::function<void(std::vector<AllocationFrame>& frames, size_t maxFrames)>;
+
+/**
+ * @brief サンプリング割り当てプロファイラ
+ *
+ * 割り当てバイト列上にポアソン過程でサンプル点を置き、平均 sampleInterval バイトごとに
+ * 1つの割り当てを記録する。スレッド・プロファイラごとに「次のサンプルまでの残りバイト数」を
+ * 持ち（ヒープごとにプロファイラがあるため、他のヒープの割り当てで残りが減らないよう
+ * プロファイラの識別子で引く）、割り当てごとの処理はその減算と比較だけ。サンプルに当たった割り当てでのみ
+ * JSスタックを取得し、呼び出し木に集約する。
+ *
+ * サイズ s の割り当てがサンプルされる確率は 1 - exp(-s / interval) なので、
+ * 各サンプルをその逆数で重み付けして割り当て数・バイト数の不偏推定値を得る。
+ * 結果は pprof の profile.proto 形式（非圧縮）で書き出せる。
+ */
+class SamplingHeapProfiler {
+public:
+  static constexpr size_t kDefaultSampleInterval = 512 * 1024;
+  static constexpr size_t kDefaultMaxFrames = 64;
+
+  SamplingHeapProfiler();
+  ~SamplingHeapProfiler();
+
+  SamplingHeapProfiler(const SamplingHeapProfiler&) = delete;
+  SamplingHeapProfiler& operator=(const SamplingHeapProfiler&) = delete;
+
+  /**
+   * @brief サンプリングを開始（それまでの集計は破棄）
+   * @param sampleInterval サンプル間隔の平均バイト数
+   * @param capture JSスタック取得コールバック（未設定ならスタックなしで型のみ記録）
+   */
+  void start(size_t sampleInterval = kDefaultSampleInterval,
+             AllocationStackCapture capture = AllocationStackCapture(),
+             size_t maxFrames = kDefaultMaxFrames);
+  void stop();
+  bool isActive() const { return m_active.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief 割り当てフック（GCの割り当てパスから呼ぶ）
+   */
+  inline void onAllocation(size_t size, const std::type_info& type) {
+    if (!m_active.load(std::memory_order_relaxed)) {
+      return;
+    }
+    ThreadState& state = threadState();
+    state.bytesUntilSample -= static_cast<int64_t>(size);
+    if (state.bytesUntilSample <= 0 || state.epoch != m_epoch.load(std::memory_order_relaxed)) {
+      recordSample(size, type);
+    }
+  }
+
+  /**
+   * @brief 集計結果を pprof 形式で書き出す
+   *
+   * sample_type は alloc_objects/count と alloc_space/bytes（いずれも推定値）。
+   * ロケーションはフレーム（関数とバイトコードオフセット）ごとに作り、
+   * address にバイトコードオフセット、line に行番号を入れる。割り当て型は "type" ラベル。
+   */
+  bool writePprof(const std::string& filename) const;
+  std::string serializePprof() const;
+
+  // 呼び出し木の1ノード（添字0は根）
+  struct CallTreeNode {
+    uint32_t parent;
+    uint32_t functionIndex;
+    uint32_t bytecodeOffset;
+    int line;
+  };
+
+  // ノード・型ごとの集計
+  struct SampleStats {
+    uint32_t node;
+    uint32_t typeIndex;
+    uint64_t samples;          // 実際にサンプルした回数
+    uint64_t sampledBytes;     // サンプルした割り当ての合計サイズ
+    double estimatedCount;     // 重み付き推定割り当て数
+    double estimatedBytes;     // 重み付き推定バイト数
+  };
+
+  struct FunctionInfo {
+    std::string name;
+    std::string scriptName;
+    int line;
+  };
+
+  // 集計のスナップショット（テスト・独自出力用）
+  void forEachSample(const std::function<void(const SampleStats&)>& fn) const;
+  std::vector<uint32_t> stackOf(uint32_t node) const;  // 葉から根の手前まで
+  CallTreeNode node(uint32_t index) const;
+  FunctionInfo function(uint32_t index) const;
+  std::string typeName(uint32_t index) const;
+
+  uint64_t totalSamples() const { return m_totalSamples.load(std::memory_order_relaxed); }
+  size_t sampleInterval() const { return m_sampleInterval; }
+
+private:
+  struct ThreadState {
+    int64_t bytesUntilSample = 0;
+    uint64_t epoch = 0;
+    uint64_t rngState = 0;
+  };
+
+  // 現在のスレッドがプロファイラごとに使う状態
+  struct ThreadStateEntry {
+    uint64_t profilerId;
+    ThreadState state;
+  };
+
+  // 通常スレッドが使うプロファイラは1つなので、先頭の項目で見つかる
+  ThreadState& threadState() {
+    for (ThreadStateEntry& entry : t_states) {
+      if (entry.profilerId == m_id) {
+        return entry.state;
+      }
+    }
+    return addThreadState();
+  }
+  ThreadState& addThreadState();
+
+  void recordSample(size_t size, const std::type_info& type);
+  int64_t nextSampleDistance(ThreadState& state) const;
+
+  uint32_t internFunction(const AllocationFrame& frame);
+  uint32_t internType(const std::type_info& type);
+  uint32_t childOf(uint32_t parent, uint32_t functionIndex, const AllocationFrame& frame);
+  uint32_t sampleSlot(uint32_t node, uint32_t typeIndex);
+
+  static thread_local std::vector<ThreadStateEntry> t_states;
+
+  // 識別子（破棄されたプロファイラのアドレスが再利用されても取り違えないよう、単調増加）
+  const uint64_t m_id;
+  std::atomic<bool> m_active;
+  std::atomic<uint64_t> m_epoch;     // 開始ごとに進め、各スレッドの残りバイト数を引き直させる
+  size_t m_sampleInterval;
+  size_t m_maxFrames;
+  AllocationStackCapture m_capture;
+
+  mutable std::mutex m_mutex;
+  struct ChildKey {
+    uint32_t parent;
+    uint32_t functionIndex;
+    uint32_t bytecodeOffset;
+    bool operator==(const ChildKey& other) const {
+      return parent == other.parent && functionIndex == other.functionIndex &&
+             bytecodeOffset == other.bytecodeOffset;
+    }
+  };
+  struct ChildKeyHash {
+    size_t operator()(const ChildKey& key) const {
+      uint64_t h = (static_cast<uint64_t>(key.parent) << 32) ^ key.functionIndex;
+      h = (h ^ key.bytecodeOffset) * 0x9E3779B97F4A7C15ULL;
+      return static_cast<size_t>(h ^ (h >> 32));
+    }
+  };
+
+  std::vector<CallTreeNode> m_nodes;
+  std::unordered_map<ChildKey, uint32_t, ChildKeyHash> m_children;
+  std::vector<FunctionInfo> m_functions;
+  std::unordered_map<const void*, uint32_t> m_functionIndex;
+  std::unordered_map<std::string, uint32_t> m_nativeFunctionIndex;  // 同一性を持たないフレームは名前で識別
+  std::vector<std::string> m_typeNames;
+  std::unordered_map<std::type_index, uint32_t> m_typeIndex;
+  std::vector<SampleStats> m_samples;
+  std::unordered_map<uint64_t, uint32_t> m_sampleIndex;     // (ノード, 型) → m_samples の添字
+  std::atomic<uint64_t> m_totalSamples;
+  int64_t m_startTimeNanos;
+};
+
+} // namespace memory
+} // namespace utils
+} // namespace aerojs
@@ -0,0 +1,165 @@
+/**
+ * @file typed_pool.h
+ * @brief 短命な固定サイズ構造体のための型別フリーリストプール
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_UTILS_MEMORY_POOL_TYPED_POOL_H
+#define AEROJS_UTILS_MEMORY_POOL_TYPED_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace aerojs {
+namespace utils {
+namespace memory {
+
+/**
+ * @brief 型別プールのキャッシュ解放世代
+ *
+ * GCがメジャーGCの後に requestTypedPoolTrim() で進め、各スレッドのプールは
+ * 次にブロックを返却するときに世代の変化を見てキャッシュを解放する。
+ * 他スレッドのフリーリストには触れないので、プール側にロックは不要。
+ */
+inline std::atomic<uint64_t>& typedPoolTrimEpoch() {
+  static std::atomic<uint64_t> epoch{0};
+  return epoch;
+}
+
+inline void requestTypedPoolTrim() {
+  typedPoolTrimEpoch().fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 型別フリーリストプール
+ *
+ * IteratorResult 相当の一時レコードや arguments オブジェクトのように、
+ * 確保してすぐ捨てる固定サイズの構造体に使う。
+ * プールはスレッドごとに1つ（local()）で、確保・返却はスレッドローカルの
+ * 単方向リストの先頭を付け替えるだけ。ブロックはグローバルの operator new で
+ * 確保するため、別スレッドのプールに返却されても問題ない。
+ *
+ * キャッシュするブロック数は kMaxCached までで、超えた分はすぐに解放する。
+ */
+template <typename T>
+class TypedFreeListPool {
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                "過剰アライメントの型はプールできない");
+
+ public:
+  static constexpr size_t kMaxCached = 1024;
+  static constexpr size_t kBlockSize = sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T);
+
+  struct Stats {
+    uint64_t hits = 0;    ///< フリーリストから返した回数
+    uint64_t misses = 0;  ///< operator new に回した回数
+    uint64_t trims = 0;   ///< GC要求でキャッシュを捨てた回数
+  };
+
+  /**
+   * @brief 現在のスレッドのプール
+   */
+  static TypedFreeListPool& local() {
+    static thread_local TypedFreeListPool pool;
+    return pool;
+  }
+
+  TypedFreeListPool()
+      : m_freeList(nullptr),
+        m_cached(0),
+        m_epoch(typedPoolTrimEpoch().load(std::memory_order_relaxed)) {}
+
+  ~TypedFreeListPool() { releaseCached(); }
+
+  TypedFreeListPool(const TypedFreeListPool&) = delete;
+  TypedFreeListPool& operator=(const TypedFreeListPool&) = delete;
+
+  /**
+   * @brief 未初期化のブロックを確保（クラス固有の operator new から使う）
+   */
+  void* allocate() {
+    if (FreeNode* node = m_freeList) {
+      m_freeList = node->next;
+      m_cached--;
+      m_stats.hits++;
+      return node;
+    }
+    m_stats.misses++;
+    return ::operator new(kBlockSize);
+  }
+
+  /**
+   * @brief ブロックを返却（クラス固有の operator delete から使う）
+   */
+  void deallocate(void* block) {
+    if (!block) {
+      return;
+    }
+
+    uint64_t epoch = typedPoolTrimEpoch().load(std::memory_order_relaxed);
+    if (epoch != m_epoch) {
+      m_epoch = epoch;
+      releaseCached();
+      m_stats.trims++;
+    }
+
+    if (m_cached >= kMaxCached) {
+      ::operator delete(block);
+      return;
+    }
+    FreeNode* node = static_cast<FreeNode*>(block);
+    node->next = m_freeList;
+    m_freeList = node;
+    m_cached++;
+  }
+
+  template <typename... Args>
+  T* create(Args&&... args) {
+    void* block = allocate();
+    try {
+      return new (block) T(std::forward<Args>(args)...);
+    } catch (...) {
+      deallocate(block);
+      throw;
+    }
+  }
+
+  void destroy(T* object) {
+    if (!object) {
+      return;
+    }
+    object->~T();
+    deallocate(object);
+  }
+
+  size_t cachedCount() const { return m_cached; }
+  const Stats& stats() const { return m_stats; }
+
+ private:
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  void releaseCached() {
+    while (FreeNode* node = m_freeList) {
+      m_freeList = node->next;
+      ::operator delete(node);
+    }
+    m_cached = 0;
+  }
+
+  FreeNode* m_freeList;
+  size_t m_cached;
+  uint64_t m_epoch;
+  Stats m_stats;
+};
+
+}  // namespace memory
+}  // namespace utils
+}  // namespace aerojs
+
+#endif  // AEROJS_UTILS_MEMORY_POOL_TYPED_POOL_H
@@ -0,0 +1,87 @@
+/**
+ * @file compressed_ptr.h
+ * @brief ヒープ内参照用の圧縮ポインタ
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_COMPRESSED_PTR_H
+#define AEROJS_COMPRESSED_PTR_H
+
+#include <cstdint>
+
+#ifdef AEROJS_POINTER_COMPRESSION
+#include "../allocators/heap_cage.h"
+#endif
+
+namespace aerojs {
+namespace utils {
+
+/**
+ * @brief ヒープオブジェクト間の参照
+ *
+ * AEROJS_POINTER_COMPRESSION 有効時はヒープケージ先頭からの32ビットオフセットを保持し、
+ * 読み出し時にケージベースを加算して展開する。無効時は通常のポインタと同じ。
+ * 参照先はケージ内に割り当てられていること。
+ *
+ * 共用体のメンバにできるよう、トリビアルなデフォルト構築・コピーを保つ。
+ *
+ * @tparam T 参照先の型
+ */
+template <typename T>
+class CompressedPtr {
+ public:
+  CompressedPtr() = default;
+
+  CompressedPtr(T* ptr) {  // NOLINT: 生ポインタからの暗黙変換を許可
+    set(ptr);
+  }
+
+  CompressedPtr& operator=(T* ptr) {
+    set(ptr);
+    return *this;
+  }
+
+  T* get() const {
+#ifdef AEROJS_POINTER_COMPRESSION
+    return static_cast<T*>(memory::HeapCage::decompress(m_offset));
+#else
+    return m_ptr;
+#endif
+  }
+
+  void set(T* ptr) {
+#ifdef AEROJS_POINTER_COMPRESSION
+    m_offset = memory::HeapCage::compress(ptr);
+#else
+    m_ptr = ptr;
+#endif
+  }
+
+  // GCのスロット更新用（圧縮時はオフセットそのもの）
+#ifdef AEROJS_POINTER_COMPRESSION
+  uint32_t* rawSlot() { return &m_offset; }
+#else
+  T** rawSlot() { return &m_ptr; }
+#endif
+
+  operator T*() const { return get(); }
+  T* operator->() const { return get(); }
+  T& operator*() const { return *get(); }
+
+ private:
+#ifdef AEROJS_POINTER_COMPRESSION
+  uint32_t m_offset;
+#else
+  T* m_ptr;
+#endif
+};
+
+#ifdef AEROJS_POINTER_COMPRESSION
+static_assert(sizeof(CompressedPtr<char>) == 4, "compressed references must be 32-bit");
+#endif
+
+}  // namespace utils
+}  // namespace aerojs
+
+#endif  // AEROJS_COMPRESSED_PTR_H
@@ -15,114 +15,130 @@
 #include <unordered_map>
 #include <vector>
 
+#include "handle_table.h"
 #include "weak_handle.h"
 
 namespace aero {
 
-// 前方宣言
-class Object;
+/**
+ * @brief 弱ハンドルのクリア完了を受け取るオブザーバ
+ *
+ * FinalizationRegistry のように、参照先が回収されたハンドルをまとめて処理したい
+ * オブジェクトが実装する。GCの弱参照処理（スイープ前）に1回ずつ呼ばれる。
+ */
+class WeakHandleObserver {
+public:
+  virtual ~WeakHandleObserver() = default;
+
+  /**
+   * @brief 弱ハンドルのクリア後に呼ばれる
+   * @param isLive オブジェクトの生存判定（オブザーバ自身が回収対象かの確認にも使う）
+   */
+  virtual void afterWeakHandlesCleared(const std::function<bool(GCCell*)>& isLive) = 0;
+};
 
 /**
- * @brief WeakHandleの管理を行うシングルトンクラス
+ * @brief ヒープごとのハンドル管理クラス
  * 
- * WeakRefおよびFinalizationRegistry実装で使用される、
- * WeakHandleの生成と管理を一元的に行うためのシングルトンクラス。
- * GCと連携して弱参照の状態を管理します。
+ * GCが管理するセルへのWeakHandle・GlobalHandleの生成と管理を一元的に行う。
+ * ヒープ（コレクタ）が1つずつ所有し、そのヒープのセルだけを登録する。
+ * ハンドルの実体はグローバルハンドルテーブルのスロットで、生成・破棄はロックを取らない。
+ * GCは1回のテーブル走査で回収済みセルを指す弱ハンドルをクリアし、
+ * 強ハンドルとスレッドローカルハンドルをルートとして列挙します。
  */
 class HandleManager {
 public:
-  /**
-   * @brief シングルトンインスタンスを取得
-   * @return HandleManagerのインスタンス
-   */
-  static HandleManager* getInstance() {
-    static HandleManager instance;
-    return &instance;
-  }
+  HandleManager()
+    : m_pendingInvalidation(0),
+      m_totalInvalidated(0),
+      m_debugMode(false) {}
+
+  ~HandleManager() = default;
 
-  /**
-   * @brief コピーコンストラクタを削除（シングルトン）
-   */
   HandleManager(const HandleManager&) = delete;
+  HandleManager& operator=(const HandleManager&) = delete;
 
   /**
-   * @brief 代入演算子を削除（シングルトン）
+   * @brief このヒープのハンドルテーブル（HandleScope・LocalHandle の作成に使う）
    */
-  HandleManager& operator=(const HandleManager&) = delete;
+  GlobalHandleTable& table() { return m_table; }
+  const GlobalHandleTable& table() const { return m_table; }
 
   /**
-   * @brief オブジェクトに対するWeakHandleを作成
-   * @tparam T オブジェクトの型
-   * @param obj 参照対象のオブジェクト
+   * @brief セルに対するWeakHandleを作成
+   * @tparam T セルの型（GCCellの派生型）
+   * @param obj 参照対象のセル（このヒープで割り当てたもの）
    * @return WeakHandle
    */
   template <typename T>
   WeakHandle<T> createWeakHandle(T* obj) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    WeakHandle<T> handle(obj);
-    
-    // 作成したWeakHandleを追跡リストに追加
-    if (obj) {
-      m_activeHandles++;
-    }
-    
-    return handle;
+    return WeakHandle<T>(m_table, obj);
   }
 
   /**
-   * @brief 個別のWeakHandleをGCに登録
-   * @param handle 登録するWeakHandleへのポインタ
+   * @brief セルに対する強いグローバルハンドルを作成
+   * @tparam T セルの型（GCCellの派生型）
+   * @param obj 保持するセル（このヒープで割り当てたもの）
+   * @return GlobalHandle（破棄されるまでGCルートになる）
    */
-  void registerWeakHandle(void* handle);
-
-  /**
-   * @brief オブジェクト種別ごとのハンドルプロバイダを登録
-   * @param typeName オブジェクト種別名
-   * @param provider オブジェクト種別を判別する関数
-   */
-  void registerHandleProvider(const std::string& typeName, 
-                             std::function<bool(Object*)> provider) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_handleProviders[typeName] = provider;
+  template <typename T>
+  GlobalHandle<T> createGlobalHandle(T* obj) {
+    return GlobalHandle<T>(m_table, obj, GlobalHandleTable::Kind::Strong);
   }
 
   /**
    * @brief GC前の準備処理
    */
   void prepareForGC() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_pendingInvalidation = 0;
+    m_pendingInvalidation.store(0, std::memory_order_relaxed);
   }
 
+  /**
+   * @brief 回収されたオブジェクトを指す弱ハンドルを一括でクリア
+   * @param isLive マーク済み（生存）なら true を返す判定関数
+   * @return クリアしたハンドル数
+   *
+   * GCのマーキング完了後、スイープより前に呼ぶ。テーブルを1回走査するだけで、
+   * ハンドル数に比例した登録・無効化リストの処理はない。走査後に登録済みの
+   * WeakHandleObserver へ通知する。
+   */
+  size_t sweepWeakHandles(const std::function<bool(GCCell*)>& isLive);
+
+  /**
+   * @brief 弱ハンドルのクリア完了を通知するオブザーバを登録
+   */
+  void addWeakHandleObserver(WeakHandleObserver* observer);
+
+  /**
+   * @brief オブザーバの登録を解除
+   */
+  void removeWeakHandleObserver(WeakHandleObserver* observer);
+
+  /**
+   * @brief 強いグローバルハンドルとスレッドローカルハンドルの参照先を列挙
+   * @param visitor ルートとしてマークする関数
+   */
+  void visitRoots(const std::function<void(GCCell*)>& visitor);
+
   /**
    * @brief GC後の処理
-   * @param invalidatedObjects GCで回収されたオブジェクトのリスト
-   */
-  void afterGC(const std::vector<Object*>& invalidatedObjects) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    // GCで回収されたオブジェクトのハンドルを無効化
-    for (Object* obj : invalidatedObjects) {
-      // 各オブジェクト種別に対応するハンドラを呼び出す
-      for (const auto& providerPair : m_handleProviders) {
-        if (providerPair.second(obj)) {
-          m_pendingInvalidation++;
-          // 実際のハンドル無効化はGCが処理
-        }
-      }
-    }
-    
-    // 統計情報の更新
-    m_activeHandles -= m_pendingInvalidation;
-    m_totalInvalidated += m_pendingInvalidation;
-    
-    // デバッグ情報
-    if (m_pendingInvalidation > 0 && m_debugMode) {
-      printf("HandleManager: Invalidated %zu handles, active: %zu, total invalidated: %zu\n",
-             m_pendingInvalidation, m_activeHandles.load(), m_totalInvalidated.load());
-    }
-  }
+   * @param invalidatedObjects GCで回収されたセルのリスト
+   *
+   * マーク状態を参照できない呼び出し元向け。回収済みセルの集合を
+   * 生存判定に使って sweepWeakHandles と同じ一括走査を行う。
+   */
+  void afterGC(const std::vector<GCCell*>& invalidatedObjects);
+
+  /**
+   * @brief GC後の処理（コンパクションによる再配置を含む）
+   * @param invalidatedObjects GCで回収されたセルのリスト
+   * @param relocatedObjects 移動前アドレスから移動後アドレスへの対応
+   *
+   * ハンドルテーブルとスレッドローカルハンドルのうち、移動したセルを
+   * 指すものを新しいアドレスに付け替える。
+   */
+  void afterGC(const std::vector<GCCell*>& invalidatedObjects,
+               const std::unordered_map<void*, void*>& relocatedObjects);
 
   /**
    * @brief デバッグモードを設定
@@ -133,11 +149,11 @@ public:
   }
 
   /**
-   * @brief 有効なハンドル数を取得
+   * @brief 有効なハンドル数を取得（テーブルを走査するため診断用）
    * @return 有効なハンドル数
    */
   size_t activeHandleCount() const {
-    return m_activeHandles.load();
+    return m_table.countInUse(GlobalHandleTable::Kind::Weak);
   }
 
   /**
@@ -150,44 +166,30 @@ public:
 
 private:
   /**
-   * @brief コンストラクタ（シングルトン）
-   */
-  HandleManager() 
-    : m_activeHandles(0),
-      m_pendingInvalidation(0),
-      m_totalInvalidated(0),
-      m_debugMode(false) {}
-
-  /**
-   * @brief デストラクタ
+   * @brief このヒープのハンドルテーブル
    */
-  ~HandleManager() = default;
+  GlobalHandleTable m_table;
 
   /**
-   * @brief スレッドセーフ操作のためのミューテックス
+   * @brief オブザーバ登録用のミューテックス（ハンドルの生成経路では取らない）
    */
   mutable std::mutex m_mutex;
 
   /**
-   * @brief 現在有効なハンドル数
+   * @brief 弱ハンドルのクリア完了を通知するオブザーバ
    */
-  std::atomic<size_t> m_activeHandles;
+  std::vector<WeakHandleObserver*> m_observers;
 
   /**
-   * @brief 次回GCで無効化予定のハンドル数
+   * @brief 直近のGCで無効化したハンドル数
    */
-  size_t m_pendingInvalidation;
+  std::atomic<size_t> m_pendingInvalidation;
 
   /**
    * @brief 累計で無効化されたハンドル数
    */
   std::atomic<size_t> m_totalInvalidated;
 
-  /**
-   * @brief オブジェクト種別ごとのハンドルプロバイダマップ
-   */
-  std::unordered_map<std::string, std::function<bool(Object*)>> m_handleProviders;
-
   /**
    * @brief デバッグモードフラグ
    */
@@ -0,0 +1,357 @@
+/**
+ * @file handle_table.cpp
+ * @brief セグメント化ハンドルテーブルとスレッドローカルハンドルブロックの実装
+ * @copyright 2023 AeroJS プロジェクト
+ */
+
+#include "handle_table.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace aero {
+
+// ---------------------------------------------------------------------------
+// GlobalHandleTable
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// テーブルの識別子（破棄されたテーブルのアドレスが再利用されても取り違えないよう、単調増加）
+std::atomic<uint64_t> g_nextTableId{1};
+
+// 現在のスレッドがテーブルごとに使うローカルハンドル領域の対応表
+struct LocalBlocksCacheEntry {
+  uint64_t tableId;
+  LocalHandleBlocks* blocks;
+};
+
+thread_local std::vector<LocalBlocksCacheEntry> t_localBlocks;
+
+} // namespace
+
+GlobalHandleTable::GlobalHandleTable()
+  : m_freeHead(0),
+    m_nextUnused(0),
+    m_id(g_nextTableId.fetch_add(1, std::memory_order_relaxed)) {
+  for (auto& segment : m_segments) {
+    segment.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+GlobalHandleTable::~GlobalHandleTable() {
+  for (auto& segment : m_segments) {
+    delete segment.load(std::memory_order_relaxed);
+  }
+
+  // このスレッドの対応表からは外す（他スレッドの古い項目は識別子が一致しないため使われない）
+  for (size_t i = 0; i < t_localBlocks.size(); ++i) {
+    if (t_localBlocks[i].tableId == m_id) {
+      t_localBlocks[i] = t_localBlocks.back();
+      t_localBlocks.pop_back();
+      break;
+    }
+  }
+}
+
+GlobalHandleTable::Segment* GlobalHandleTable::ensureSegment(size_t segmentIndex) {
+  Segment* segment = m_segments[segmentIndex].load(std::memory_order_acquire);
+  if (segment) {
+    return segment;
+  }
+
+  // 先に作って登録を試み、負けたら相手のセグメントを使う
+  auto* created = new Segment();
+  uint32_t base = static_cast<uint32_t>(segmentIndex << kSegmentShift);
+  for (size_t i = 0; i < kSlotsPerSegment; ++i) {
+    created->slots[i].index = base + static_cast<uint32_t>(i);
+  }
+
+  if (m_segments[segmentIndex].compare_exchange_strong(segment, created,
+                                                        std::memory_order_acq_rel,
+                                                        std::memory_order_acquire)) {
+    return created;
+  }
+  delete created;
+  return segment;
+}
+
+GlobalHandleTable::Slot* GlobalHandleTable::allocate(GCCell* object, Kind kind) {
+  Slot* slot = nullptr;
+
+  // フリーリストから取り出す
+  uint64_t head = m_freeHead.load(std::memory_order_acquire);
+  while (static_cast<uint32_t>(head) != 0) {
+    Slot& candidate = slotAt(static_cast<uint32_t>(head) - 1);
+    uint32_t next = candidate.nextFree.load(std::memory_order_relaxed);
+    uint64_t newHead = (((head >> 32) + 1) << 32) | next;
+    if (m_freeHead.compare_exchange_weak(head, newHead,
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire)) {
+      slot = &candidate;
+      break;
+    }
+  }
+
+  // 空なら未使用領域から切り出す
+  if (!slot) {
+    if (m_nextUnused.load(std::memory_order_relaxed) >= kCapacity) {
+      return nullptr;
+    }
+    uint32_t index = m_nextUnused.fetch_add(1, std::memory_order_relaxed);
+    if (index >= kCapacity) {
+      return nullptr;
+    }
+    Segment* segment = ensureSegment(index >> kSegmentShift);
+    slot = &segment->slots[index & (kSlotsPerSegment - 1)];
+  }
+
+  // GCの走査が種別を見てから参照先を読むので、参照先を先に書く
+  slot->object.store(object, std::memory_order_relaxed);
+  slot->kind.store(static_cast<uint8_t>(kind), std::memory_order_release);
+  return slot;
+}
+
+void GlobalHandleTable::release(Slot* slot) {
+  if (!slot) {
+    return;
+  }
+
+  slot->kind.store(static_cast<uint8_t>(Kind::Free), std::memory_order_relaxed);
+  slot->object.store(nullptr, std::memory_order_relaxed);
+
+  uint64_t head = m_freeHead.load(std::memory_order_relaxed);
+  uint64_t newHead;
+  do {
+    slot->nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    newHead = (((head >> 32) + 1) << 32) | (static_cast<uint64_t>(slot->index) + 1);
+  } while (!m_freeHead.compare_exchange_weak(head, newHead,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+}
+
+template <typename Fn>
+void GlobalHandleTable::forEachSlot(Fn&& fn) const {
+  size_t end = std::min<size_t>(m_nextUnused.load(std::memory_order_acquire), kCapacity);
+  size_t segmentCount = (end + kSlotsPerSegment - 1) >> kSegmentShift;
+
+  for (size_t s = 0; s < segmentCount; ++s) {
+    // 切り出し直後でまだ登録されていないセグメントには使用中スロットがない
+    Segment* segment = m_segments[s].load(std::memory_order_acquire);
+    if (!segment) {
+      continue;
+    }
+    size_t limit = std::min(kSlotsPerSegment, end - (s << kSegmentShift));
+    for (size_t i = 0; i < limit; ++i) {
+      fn(segment->slots[i]);
+    }
+  }
+}
+
+size_t GlobalHandleTable::sweepWeak(const std::function<bool(GCCell*)>& isLive) {
+  size_t cleared = 0;
+  forEachSlot([&](Slot& slot) {
+    if (slot.kind.load(std::memory_order_acquire) != static_cast<uint8_t>(Kind::Weak)) {
+      return;
+    }
+    GCCell* object = slot.object.load(std::memory_order_relaxed);
+    if (object && !isLive(object) &&
+        slot.object.compare_exchange_strong(object, nullptr, std::memory_order_acq_rel)) {
+      cleared++;
+    }
+  });
+  return cleared;
+}
+
+size_t GlobalHandleTable::remap(const std::unordered_map<void*, void*>& relocated) {
+  if (relocated.empty()) {
+    return 0;
+  }
+
+  size_t remapped = 0;
+  forEachSlot([&](Slot& slot) {
+    if (slot.kind.load(std::memory_order_acquire) == static_cast<uint8_t>(Kind::Free)) {
+      return;
+    }
+    GCCell* object = slot.object.load(std::memory_order_relaxed);
+    if (!object) {
+      return;
+    }
+    auto it = relocated.find(object);
+    if (it != relocated.end() &&
+        slot.object.compare_exchange_strong(object, static_cast<GCCell*>(it->second),
+                                            std::memory_order_acq_rel)) {
+      remapped++;
+    }
+  });
+  return remapped;
+}
+
+void GlobalHandleTable::visitStrong(const std::function<void(GCCell* object)>& visitor) const {
+  forEachSlot([&](Slot& slot) {
+    if (slot.kind.load(std::memory_order_acquire) != static_cast<uint8_t>(Kind::Strong)) {
+      return;
+    }
+    if (GCCell* object = slot.object.load(std::memory_order_acquire)) {
+      visitor(object);
+    }
+  });
+}
+
+void GlobalHandleTable::visitWeak(const std::function<void(GCCell* object)>& visitor) const {
+  forEachSlot([&](Slot& slot) {
+    if (slot.kind.load(std::memory_order_acquire) != static_cast<uint8_t>(Kind::Weak)) {
+      return;
+    }
+    if (GCCell* object = slot.object.load(std::memory_order_acquire)) {
+      visitor(object);
+    }
+  });
+}
+
+size_t GlobalHandleTable::countInUse(Kind kind) const {
+  size_t count = 0;
+  forEachSlot([&](Slot& slot) {
+    if (slot.kind.load(std::memory_order_relaxed) == static_cast<uint8_t>(kind)) {
+      count++;
+    }
+  });
+  return count;
+}
+
+// ---------------------------------------------------------------------------
+// LocalHandleBlocks
+// ---------------------------------------------------------------------------
+
+LocalHandleBlocks::LocalHandleBlocks()
+  : m_currentBlock(0),
+    m_top(nullptr),
+    m_limit(nullptr),
+    m_scopeDepth(0) {}
+
+LocalHandleBlocks::~LocalHandleBlocks() {
+  for (Block* block : m_blocks) {
+    delete block;
+  }
+}
+
+void LocalHandleBlocks::grow() {
+  size_t next = m_top ? m_currentBlock + 1 : 0;
+  if (next == m_blocks.size()) {
+    m_blocks.push_back(new Block());
+  }
+  m_currentBlock = next;
+  m_top = m_blocks[next]->slots;
+  m_limit = m_top + kBlockSize;
+}
+
+void LocalHandleBlocks::restore(size_t blockIndex, GCCell** top) {
+  size_t keep;
+  if (!top) {
+    m_currentBlock = 0;
+    m_top = nullptr;
+    m_limit = nullptr;
+    keep = 1;
+  } else {
+    m_currentBlock = blockIndex;
+    m_top = top;
+    m_limit = m_blocks[blockIndex]->slots + kBlockSize;
+    keep = blockIndex + 2;
+  }
+
+  // スコープの出入りでブロックの確保・解放を繰り返さないよう1つだけ予備を残す
+  while (m_blocks.size() > keep) {
+    delete m_blocks.back();
+    m_blocks.pop_back();
+  }
+}
+
+template <typename Fn>
+void LocalHandleBlocks::forEachLocation(Fn&& fn) {
+  if (!m_top) {
+    return;
+  }
+  for (size_t b = 0; b <= m_currentBlock; ++b) {
+    GCCell** begin = m_blocks[b]->slots;
+    GCCell** end = (b == m_currentBlock) ? m_top : begin + kBlockSize;
+    for (GCCell** location = begin; location != end; ++location) {
+      fn(location);
+    }
+  }
+}
+
+size_t LocalHandleBlocks::size() const {
+  if (!m_top) {
+    return 0;
+  }
+  return m_currentBlock * kBlockSize +
+         static_cast<size_t>(m_top - m_blocks[m_currentBlock]->slots);
+}
+
+// ---------------------------------------------------------------------------
+// GlobalHandleTable のローカルハンドル領域
+// ---------------------------------------------------------------------------
+
+LocalHandleBlocks& GlobalHandleTable::localBlocks() {
+  for (const LocalBlocksCacheEntry& entry : t_localBlocks) {
+    if (entry.tableId == m_id) {
+      return *entry.blocks;
+    }
+  }
+
+  LocalHandleBlocks* blocks = new LocalHandleBlocks();
+  {
+    std::lock_guard<std::mutex> lock(m_localMutex);
+    m_locals.emplace_back(blocks);
+  }
+  t_localBlocks.push_back({m_id, blocks});
+  return *blocks;
+}
+
+void GlobalHandleTable::visitLocals(const std::function<void(GCCell* object)>& visitor) {
+  std::lock_guard<std::mutex> lock(m_localMutex);
+  for (auto& blocks : m_locals) {
+    blocks->forEachLocation([&](GCCell** location) {
+      if (*location) {
+        visitor(*location);
+      }
+    });
+  }
+}
+
+size_t GlobalHandleTable::remapLocals(const std::unordered_map<void*, void*>& relocated) {
+  if (relocated.empty()) {
+    return 0;
+  }
+
+  size_t remapped = 0;
+  std::lock_guard<std::mutex> lock(m_localMutex);
+  for (auto& blocks : m_locals) {
+    blocks->forEachLocation([&](GCCell** location) {
+      auto it = relocated.find(*location);
+      if (it != relocated.end()) {
+        *location = static_cast<GCCell*>(it->second);
+        remapped++;
+      }
+    });
+  }
+  return remapped;
+}
+
+// ---------------------------------------------------------------------------
+// HandleScope
+// ---------------------------------------------------------------------------
+
+HandleScope::HandleScope(GlobalHandleTable& table)
+  : m_blocks(table.localBlocks()),
+    m_savedBlock(m_blocks.m_currentBlock),
+    m_savedTop(m_blocks.m_top) {
+  m_blocks.m_scopeDepth++;
+}
+
+HandleScope::~HandleScope() {
+  m_blocks.restore(m_savedBlock, m_savedTop);
+  m_blocks.m_scopeDepth--;
+}
+
+} // namespace aero
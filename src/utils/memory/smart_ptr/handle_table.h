@@ -0,0 +1,305 @@
+/**
+ * @file handle_table.h
+ * @brief セグメント化ハンドルテーブルとスレッドローカルハンドルブロック
+ * @copyright 2023 AeroJS プロジェクト
+ */
+
+#ifndef AERO_HANDLE_TABLE_H
+#define AERO_HANDLE_TABLE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace aerojs::utils::memory {
+class GCCell;
+}
+
+namespace aero {
+
+using GCCell = aerojs::utils::memory::GCCell;
+
+class LocalHandleBlocks;
+
+/**
+ * @brief グローバルハンドルテーブル
+ *
+ * ヒープ（コレクタ）ごとに1つ持ち、そのヒープのGCセルだけを参照先として登録する。
+ * 固定長セグメントを連ねたスロット配列。スロットはアドレスが変わらず、
+ * ハンドルはスロットへのポインタそのものになる。
+ *
+ * 確保は解放済みスロットのフリーリスト（タグ付きインデックスによるロックフリースタック）
+ * から取り出し、空なら未使用領域の先頭を fetch_add で進めて切り出す。
+ * セグメントは初めて必要になったスレッドが作成して CAS で登録するため、
+ * 確保・解放のどちらの経路もロックを取らない。
+ *
+ * 弱スロットのクリアと移動オブジェクトの付け替えは、GCがテーブル全体を
+ * 1回走査するだけで行う（ハンドルごとの登録や無効化リストは持たない）。
+ */
+class GlobalHandleTable {
+public:
+  enum class Kind : uint8_t {
+    Free = 0,
+    Strong = 1,  // GCルートとして扱う
+    Weak = 2     // 参照先が回収されるとGCがnullptrにする
+  };
+
+  struct Slot {
+    std::atomic<GCCell*> object;
+    std::atomic<uint8_t> kind;
+    std::atomic<uint32_t> nextFree;  // フリーリスト上の次スロット（インデックス+1、0は終端）
+    uint32_t index;
+  };
+
+  static constexpr size_t kSegmentShift = 10;
+  static constexpr size_t kSlotsPerSegment = size_t(1) << kSegmentShift;
+  static constexpr size_t kMaxSegments = 16384;  // 最大 1600万ハンドル程度
+  static constexpr size_t kCapacity = kSlotsPerSegment * kMaxSegments;
+
+  GlobalHandleTable();
+  ~GlobalHandleTable();
+
+  GlobalHandleTable(const GlobalHandleTable&) = delete;
+  GlobalHandleTable& operator=(const GlobalHandleTable&) = delete;
+
+  /**
+   * @brief スロットを確保して参照先を設定
+   * @return 確保したスロット（容量超過時はnullptr）
+   */
+  Slot* allocate(GCCell* object, Kind kind);
+
+  /**
+   * @brief スロットをフリーリストに返す
+   */
+  void release(Slot* slot);
+
+  /**
+   * @brief 生存判定に失敗した弱スロットを一括でクリア
+   * @return クリアしたスロット数
+   */
+  size_t sweepWeak(const std::function<bool(GCCell*)>& isLive);
+
+  /**
+   * @brief 移動したオブジェクトを指すスロットを付け替える（強・弱とも）
+   * @return 付け替えたスロット数
+   */
+  size_t remap(const std::unordered_map<void*, void*>& relocated);
+
+  /**
+   * @brief 強スロットの参照先をルートとして列挙
+   */
+  void visitStrong(const std::function<void(GCCell* object)>& visitor) const;
+
+  /**
+   * @brief 弱スロットの参照先を列挙（ヒープスナップショットの弱エッジ用）
+   */
+  void visitWeak(const std::function<void(GCCell* object)>& visitor) const;
+
+  /**
+   * @brief 現在のスレッドがこのテーブルに使うローカルハンドル領域（初回に作成・登録）
+   */
+  LocalHandleBlocks& localBlocks();
+
+  /**
+   * @brief このテーブルに属する全スレッドのローカルハンドルを列挙（GCのルート走査用）
+   */
+  void visitLocals(const std::function<void(GCCell* object)>& visitor);
+
+  /**
+   * @brief このテーブルに属する全スレッドのローカルハンドルを付け替え
+   * @return 付け替えたハンドル数
+   */
+  size_t remapLocals(const std::unordered_map<void*, void*>& relocated);
+
+  /**
+   * @brief 使用中スロット数（全走査で数えるため診断用）
+   */
+  size_t countInUse(Kind kind) const;
+
+private:
+  struct Segment {
+    Slot slots[kSlotsPerSegment];
+  };
+
+  Slot& slotAt(uint32_t index) const {
+    Segment* segment = m_segments[index >> kSegmentShift].load(std::memory_order_acquire);
+    return segment->slots[index & (kSlotsPerSegment - 1)];
+  }
+
+  Segment* ensureSegment(size_t segmentIndex);
+
+  template <typename Fn>
+  void forEachSlot(Fn&& fn) const;
+
+  // 上位32ビットがABA対策のタグ、下位32ビットが先頭スロットのインデックス+1
+  std::atomic<uint64_t> m_freeHead;
+  std::atomic<uint32_t> m_nextUnused;
+  std::atomic<Segment*> m_segments[kMaxSegments];
+
+  // スレッドごとのローカルハンドル領域（スレッドの初回利用時のみロックする）。
+  // スレッドが終了しても領域はテーブルが所有し、テーブルと一緒に破棄する
+  const uint64_t m_id;
+  std::mutex m_localMutex;
+  std::vector<std::unique_ptr<LocalHandleBlocks>> m_locals;
+};
+
+/**
+ * @brief スレッドごとのローカルハンドル領域
+ *
+ * 固定長ブロックを連ねたスタックで、ハンドルの作成はポインタを1つ進めるだけ。
+ * 個別の解放はなく、HandleScope を抜けたときに作成前の位置まで一括で巻き戻す。
+ * 領域はテーブル（ヒープ）とスレッドの組ごとに作られてテーブルが所有し、
+ * GCは自分のテーブルの領域だけからルートを列挙する。
+ */
+class LocalHandleBlocks {
+public:
+  static constexpr size_t kBlockSize = 256;
+
+  ~LocalHandleBlocks();
+
+  GCCell** create(GCCell* object) {
+    assert(m_scopeDepth > 0 && "ローカルハンドルは HandleScope 内で作成すること");
+    if (m_top == m_limit) {
+      grow();
+    }
+    *m_top = object;
+    return m_top++;
+  }
+
+  size_t size() const;
+
+private:
+  friend class HandleScope;
+  friend class GlobalHandleTable;
+
+  LocalHandleBlocks();
+
+  void grow();
+  void restore(size_t blockIndex, GCCell** top);
+
+  template <typename Fn>
+  void forEachLocation(Fn&& fn);
+
+  struct Block {
+    GCCell* slots[kBlockSize];
+  };
+
+  std::vector<Block*> m_blocks;
+  size_t m_currentBlock;  // m_top が指すブロック（m_top が nullptr の間は0）
+  GCCell** m_top;
+  GCCell** m_limit;
+  size_t m_scopeDepth;
+};
+
+/**
+ * @brief ローカルハンドルの生存範囲
+ *
+ * スコープ内で作成したローカルハンドルは、デストラクタでまとめて解放される。
+ * ネスト可能で、同じスレッド上でのみ使用する。
+ */
+class HandleScope {
+public:
+  explicit HandleScope(GlobalHandleTable& table);
+  ~HandleScope();
+
+  HandleScope(const HandleScope&) = delete;
+  HandleScope& operator=(const HandleScope&) = delete;
+
+private:
+  LocalHandleBlocks& m_blocks;
+  size_t m_savedBlock;
+  GCCell** m_savedTop;
+};
+
+/**
+ * @brief ローカルハンドル（HandleScope 内でのみ有効）
+ */
+template <typename T>
+class LocalHandle {
+public:
+  LocalHandle() : m_location(nullptr) {}
+
+  static LocalHandle create(GlobalHandleTable& table, T* object) {
+    return LocalHandle(table.localBlocks().create(object));
+  }
+
+  T* get() const {
+    return m_location ? static_cast<T*>(*m_location) : nullptr;
+  }
+  T* operator->() const { return get(); }
+  T& operator*() const { return *get(); }
+  explicit operator bool() const { return get() != nullptr; }
+
+private:
+  explicit LocalHandle(GCCell** location) : m_location(location) {}
+
+  GCCell** m_location;
+};
+
+/**
+ * @brief グローバルハンドル（所有スロットを持ち、破棄時に返却する）
+ *
+ * Kind::Strong はGCルートとして参照先を保持し、Kind::Weak は参照先が回収されると
+ * get() が nullptr を返すようになる。参照先は作成に使ったテーブルのヒープのセルに限る。
+ */
+template <typename T>
+class GlobalHandle {
+  static_assert(std::is_base_of<GCCell, T>::value, "GlobalHandle の参照先はGCセルに限る");
+
+public:
+  using Kind = GlobalHandleTable::Kind;
+
+  GlobalHandle() : m_table(nullptr), m_slot(nullptr) {}
+
+  GlobalHandle(GlobalHandleTable& table, T* object, Kind kind = Kind::Strong)
+    : m_table(&table),
+      m_slot(object ? table.allocate(object, kind) : nullptr) {}
+
+  GlobalHandle(GlobalHandle&& other) noexcept : m_table(other.m_table), m_slot(other.m_slot) {
+    other.m_slot = nullptr;
+  }
+
+  GlobalHandle& operator=(GlobalHandle&& other) noexcept {
+    if (this != &other) {
+      reset();
+      m_table = other.m_table;
+      m_slot = other.m_slot;
+      other.m_slot = nullptr;
+    }
+    return *this;
+  }
+
+  GlobalHandle(const GlobalHandle&) = delete;
+  GlobalHandle& operator=(const GlobalHandle&) = delete;
+
+  ~GlobalHandle() { reset(); }
+
+  T* get() const {
+    return m_slot ? static_cast<T*>(m_slot->object.load(std::memory_order_acquire)) : nullptr;
+  }
+  T* operator->() const { return get(); }
+  T& operator*() const { return *get(); }
+  explicit operator bool() const { return get() != nullptr; }
+
+  void reset() {
+    if (m_slot) {
+      m_table->release(m_slot);
+      m_slot = nullptr;
+    }
+  }
+
+private:
+  GlobalHandleTable* m_table;
+  GlobalHandleTable::Slot* m_slot;
+};
+
+} // namespace aero
+
+#endif // AERO_HANDLE_TABLE_H
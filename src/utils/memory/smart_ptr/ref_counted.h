@@ -10,24 +10,157 @@
 
 #include <atomic>
 #include <cassert>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace aerojs {
 namespace utils {
 
+class RefCounted;
+
+/**
+ * @brief 参照カウント対象の破棄を通知される側
+ *
+ * WeakMap のように対象の同一性をキーにする表が、対象のメモリが再利用される前に
+ * エントリを取り除くために使う。
+ */
+class WeakReferenceObserver {
+ public:
+  virtual ~WeakReferenceObserver() = default;
+
+  // 対象のデストラクタ中（メモリの解放前）に呼ばれる。target はアドレスの照合にだけ使う。
+  // 呼び出し中は制御ブロックのロックを持っているので、制御ブロックの登録・解除をしないこと
+  virtual void weakTargetDestroyed(const RefCounted* target) = 0;
+};
+
+/**
+ * @brief 参照カウント対象への弱参照が共有する制御ブロック
+ *
+ * 対象と各WeakRefPtrが参照カウントで共有し、対象の破棄時に参照先がクリアされる。
+ * 弱参照を1つも作らない対象には確保されない。作成後は対象の強参照カウントもここで数えるので、
+ * 弱参照からの昇格は対象のメモリに触れずにカウントの増加を試みられる。
+ */
+class WeakReferenceControl {
+ public:
+  WeakReferenceControl(const RefCounted* target, std::size_t strongCount)
+      : m_target(target), m_strongCount(strongCount), m_count(1) {
+  }
+
+  WeakReferenceControl(const WeakReferenceControl&) = delete;
+  WeakReferenceControl& operator=(const WeakReferenceControl&) = delete;
+
+  void ref() {
+    m_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void deref() {
+    if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  // 参照先（破棄済みならnullptr）
+  const RefCounted* target() const {
+    return m_target.load(std::memory_order_acquire);
+  }
+
+  // 対象の強参照カウントの操作（RefCounted から使う）
+  void strongRef() {
+    m_strongCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // 0になったら true（呼び出し側が対象を破棄する）
+  bool strongDeref() {
+    if (m_strongCount.fetch_sub(1, std::memory_order_release) == 1) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+    }
+    return false;
+  }
+
+  // 強参照カウントが0でなければ1増やす。成功したときだけ対象は生存している
+  bool tryStrongRef() {
+    std::size_t count = m_strongCount.load(std::memory_order_relaxed);
+    while (count != 0) {
+      if (m_strongCount.compare_exchange_weak(count, count + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // tryStrongRef() で増やした分を、対象を破棄せずに戻す
+  void undoStrongRef() {
+    m_strongCount.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  std::size_t strongCount() const {
+    return m_strongCount.load(std::memory_order_relaxed);
+  }
+
+  // 対象に公開する前の強参照カウントを置き換える
+  void resetStrongCount(std::size_t count) {
+    m_strongCount.store(count, std::memory_order_relaxed);
+  }
+
+  // 対象の破棄を通知する先を登録する（登録済みなら何もしない。破棄済みなら false）
+  bool addObserver(WeakReferenceObserver* observer) {
+    std::lock_guard<std::mutex> lock(m_observerMutex);
+    if (!m_target.load(std::memory_order_acquire)) {
+      return false;
+    }
+    if (std::find(m_observers.begin(), m_observers.end(), observer) == m_observers.end()) {
+      m_observers.push_back(observer);
+    }
+    return true;
+  }
+
+  // 通知中であれば、その通知が終わるまで待ってから外す
+  void removeObserver(WeakReferenceObserver* observer) {
+    std::lock_guard<std::mutex> lock(m_observerMutex);
+    auto it = std::find(m_observers.begin(), m_observers.end(), observer);
+    if (it != m_observers.end()) {
+      *it = m_observers.back();
+      m_observers.pop_back();
+    }
+  }
+
+  // 対象の破棄時に呼ばれる
+  void clear() {
+    std::lock_guard<std::mutex> lock(m_observerMutex);
+    const RefCounted* target = m_target.exchange(nullptr, std::memory_order_acq_rel);
+    std::vector<WeakReferenceObserver*> observers;
+    observers.swap(m_observers);
+    for (WeakReferenceObserver* observer : observers) {
+      observer->weakTargetDestroyed(target);
+    }
+  }
+
+ private:
+  std::atomic<const RefCounted*> m_target;
+  std::atomic<std::size_t> m_strongCount;
+  std::atomic<std::size_t> m_count;
+  std::mutex m_observerMutex;
+  std::vector<WeakReferenceObserver*> m_observers;
+};
+
 /**
  * @brief 参照カウント可能なクラスのためのミックスイン
  *
  * このクラスをpublic継承することで、派生クラスは参照カウント機能を持ちます。
- * RefPtrと共に使用することを想定しています。
+ * RefPtrと共に使用することを想定しています。弱参照はWeakRefPtrで作成します。
  */
 class RefCounted {
  public:
   // デフォルトコンストラクタ
   RefCounted()
-      : m_refCount(0) {
+      : m_refBits(kInlineCountTag) {
   }
 
   // コピー禁止
@@ -36,28 +169,91 @@ class RefCounted {
 
   // 参照カウント操作
   void ref() const {
-    m_refCount.fetch_add(1, std::memory_order_relaxed);
+    std::uintptr_t bits = m_refBits.load(std::memory_order_relaxed);
+    while (bits & kInlineCountTag) {
+      if (m_refBits.compare_exchange_weak(bits, bits + kInlineCountOne, std::memory_order_relaxed,
+                                          std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    controlFromBits(bits)->strongRef();
   }
 
   void deref() const {
     // 参照カウントを1減らし、0になったら削除
-    if (m_refCount.fetch_sub(1, std::memory_order_release) == 1) {
-      std::atomic_thread_fence(std::memory_order_acquire);
+    std::uintptr_t bits = m_refBits.load(std::memory_order_relaxed);
+    while (bits & kInlineCountTag) {
+      if (m_refBits.compare_exchange_weak(bits, bits - kInlineCountOne, std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+        if (bits == (kInlineCountOne | kInlineCountTag)) {
+          std::atomic_thread_fence(std::memory_order_acquire);
+          delete this;
+        }
+        return;
+      }
+    }
+    if (controlFromBits(bits)->strongDeref()) {
       delete this;
     }
   }
 
   // 現在の参照カウントを取得（主にデバッグ用）
   std::size_t refCount() const {
-    return m_refCount.load(std::memory_order_relaxed);
+    std::uintptr_t bits = m_refBits.load(std::memory_order_relaxed);
+    if (bits & kInlineCountTag) {
+      return static_cast<std::size_t>(bits >> 1);
+    }
+    return controlFromBits(bits)->strongCount();
+  }
+
+  // 弱参照の制御ブロックを取得（初回に作成。戻り値の参照は呼び出し側が1つ所有する）
+  // 作成時にその時点の参照カウントを制御ブロックへ移し、以後の ref()/deref() はそちらを数える
+  WeakReferenceControl* acquireWeakReferenceControl() const {
+    std::uintptr_t bits = m_refBits.load(std::memory_order_acquire);
+    if (bits & kInlineCountTag) {
+      auto* created = new WeakReferenceControl(this, static_cast<std::size_t>(bits >> 1));
+      for (;;) {
+        if (m_refBits.compare_exchange_weak(bits, reinterpret_cast<std::uintptr_t>(created),
+                                            std::memory_order_acq_rel, std::memory_order_acquire)) {
+          bits = reinterpret_cast<std::uintptr_t>(created);
+          break;
+        }
+        if (!(bits & kInlineCountTag)) {
+          // 他のスレッドが先に作成した
+          created->deref();
+          break;
+        }
+        // 参照カウントが変わったので、移す値を取り直す
+        created->resetStrongCount(static_cast<std::size_t>(bits >> 1));
+      }
+    }
+    WeakReferenceControl* control = controlFromBits(bits);
+    control->ref();
+    return control;
   }
 
  protected:
   // 派生クラスからのみデストラクタを呼べるように
-  virtual ~RefCounted() = default;
+  // 参照カウント以外の経路（GCのスイープなど）で破棄された場合も弱参照はクリアされる
+  virtual ~RefCounted() {
+    std::uintptr_t bits = m_refBits.load(std::memory_order_acquire);
+    if (!(bits & kInlineCountTag)) {
+      WeakReferenceControl* control = controlFromBits(bits);
+      control->clear();
+      control->deref();
+    }
+  }
 
  private:
-  mutable std::atomic<std::size_t> m_refCount;
+  // m_refBits の下位ビットが1なら (参照カウント << 1) | 1、0なら制御ブロックへのポインタ
+  static constexpr std::uintptr_t kInlineCountTag = 1;
+  static constexpr std::uintptr_t kInlineCountOne = 2;
+
+  static WeakReferenceControl* controlFromBits(std::uintptr_t bits) {
+    return reinterpret_cast<WeakReferenceControl*>(bits);
+  }
+
+  mutable std::atomic<std::uintptr_t> m_refBits;
 };
 
 /**
@@ -213,6 +409,97 @@ inline void swap(RefPtr<T>& a, RefPtr<T>& b) noexcept {
   a.swap(b);
 }
 
+/**
+ * @brief 参照カウント対象への弱参照
+ *
+ * 参照カウントを増やさずに対象を指し、対象が破棄されると get() が nullptr を返す。
+ * GCヒープ上のセルへの弱参照には WeakHandle を使う。
+ *
+ * @tparam T RefCountedを継承した型
+ */
+template <typename T>
+class WeakRefPtr {
+  static_assert(std::is_base_of<RefCounted, T>::value, "T must inherit from RefCounted");
+
+ public:
+  WeakRefPtr()
+      : m_control(nullptr) {
+  }
+
+  explicit WeakRefPtr(T* ptr)
+      : m_control(ptr ? ptr->acquireWeakReferenceControl() : nullptr) {
+  }
+
+  WeakRefPtr(const WeakRefPtr& other)
+      : m_control(other.m_control) {
+    if (m_control)
+      m_control->ref();
+  }
+
+  WeakRefPtr(WeakRefPtr&& other) noexcept
+      : m_control(other.m_control) {
+    other.m_control = nullptr;
+  }
+
+  ~WeakRefPtr() {
+    if (m_control)
+      m_control->deref();
+  }
+
+  WeakRefPtr& operator=(const WeakRefPtr& other) {
+    WeakRefPtr(other).swap(*this);
+    return *this;
+  }
+
+  WeakRefPtr& operator=(WeakRefPtr&& other) noexcept {
+    WeakRefPtr(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  void swap(WeakRefPtr& other) noexcept {
+    std::swap(m_control, other.m_control);
+  }
+
+  // 参照先（破棄済みならnullptr）
+  T* get() const {
+    const RefCounted* target = m_control ? m_control->target() : nullptr;
+    return target ? static_cast<T*>(const_cast<RefCounted*>(target)) : nullptr;
+  }
+
+  // 生存していれば強参照に昇格する
+  // 強参照カウントの増加を制御ブロック上で先に確定させ、成功してから対象を読む
+  RefPtr<T> lock() const {
+    if (!m_control || !m_control->tryStrongRef()) {
+      return RefPtr<T>();
+    }
+    const RefCounted* target = m_control->target();
+    if (!target) {
+      // 参照カウント以外の経路で破棄された
+      m_control->undoStrongRef();
+      return RefPtr<T>();
+    }
+    T* object = static_cast<T*>(const_cast<RefCounted*>(target));
+    RefPtr<T> result(object);
+    object->deref();
+    return result;
+  }
+
+  bool expired() const {
+    return get() == nullptr;
+  }
+
+  void reset() {
+    WeakRefPtr().swap(*this);
+  }
+
+  WeakReferenceControl* control() const {
+    return m_control;
+  }
+
+ private:
+  WeakReferenceControl* m_control;
+};
+
 // ユーティリティ関数: makeRefPtr
 template <typename T, typename... Args>
 inline RefPtr<T> makeRefPtr(Args&&... args) {
@@ -8,55 +8,52 @@
 #define AERO_WEAK_HANDLE_H
 
 #include <atomic>
-#include <functional>
-#include <memory>
-#include <mutex>
+#include <type_traits>
+
+#include "handle_table.h"
 
 namespace aero {
 
 /**
- * @brief オブジェクトへの弱参照を管理するクラス
+ * @brief GCセルへの弱参照を管理するクラス
  * 
- * WeakRefおよびFinalizationRegistryの実装で使用される、
- * オブジェクトへの弱参照を安全に管理するためのテンプレートクラス。
- * 参照先のオブジェクトがガベージコレクトされた場合、自動的に無効になります。
+ * GCが管理するセルへの弱参照を安全に保持するためのテンプレートクラス。
+ * 参照先は作成時に渡したヒープのグローバルハンドルテーブルの弱スロットに置かれ、
+ * 参照先がガベージコレクトされるとそのヒープのGCのテーブル走査でクリアされて
+ * 自動的に無効になります。参照カウントで管理されるオブジェクトには
+ * utils::WeakRefPtr を使います。
  * 
- * @tparam T 参照するオブジェクトの型
+ * @tparam T 参照するGCセルの型
  */
 template <typename T>
 class WeakHandle {
+  static_assert(std::is_base_of<GCCell, T>::value, "WeakHandle の参照先はGCセルに限る");
+
 public:
   /**
    * @brief デフォルトコンストラクタ
    */
-  WeakHandle() : m_ptr(nullptr), m_isValid(false) {}
+  WeakHandle() : m_table(nullptr), m_slot(nullptr) {}
 
   /**
    * @brief コンストラクタ
-   * @param ptr 弱参照するオブジェクトへのポインタ
+   * @param table 参照先を管理するヒープのハンドルテーブル
+   * @param ptr 弱参照するセルへのポインタ
    */
-  explicit WeakHandle(T* ptr) : m_ptr(ptr), m_isValid(ptr != nullptr) {}
+  WeakHandle(GlobalHandleTable& table, T* ptr) : m_table(&table), m_slot(acquireSlot(ptr)) {}
 
   /**
-   * @brief コピーコンストラクタ
+   * @brief コピーコンストラクタ（同じ参照先の弱スロットを新たに確保）
    * @param other コピー元のWeakHandle
    */
-  WeakHandle(const WeakHandle& other) {
-    std::lock_guard<std::mutex> lock(other.m_mutex);
-    m_ptr = other.m_ptr;
-    m_isValid.store(other.m_isValid.load(std::memory_order_acquire), std::memory_order_release);
-  }
+  WeakHandle(const WeakHandle& other) : m_table(other.m_table), m_slot(acquireSlot(other.get())) {}
 
   /**
    * @brief ムーブコンストラクタ
    * @param other ムーブ元のWeakHandle
    */
-  WeakHandle(WeakHandle&& other) noexcept {
-    std::lock_guard<std::mutex> lock(other.m_mutex);
-    m_ptr = other.m_ptr;
-    m_isValid.store(other.m_isValid.load(std::memory_order_acquire), std::memory_order_release);
-    other.m_ptr = nullptr;
-    other.m_isValid.store(false, std::memory_order_release);
+  WeakHandle(WeakHandle&& other) noexcept : m_table(other.m_table), m_slot(other.m_slot) {
+    other.m_slot = nullptr;
   }
 
   /**
@@ -66,10 +63,9 @@ public:
    */
   WeakHandle& operator=(const WeakHandle& other) {
     if (this != &other) {
-      std::lock_guard<std::mutex> lockThis(m_mutex);
-      std::lock_guard<std::mutex> lockOther(other.m_mutex);
-      m_ptr = other.m_ptr;
-      m_isValid.store(other.m_isValid.load(std::memory_order_acquire), std::memory_order_release);
+      releaseSlot();
+      m_table = other.m_table;
+      m_slot = acquireSlot(other.get());
     }
     return *this;
   }
@@ -81,50 +77,47 @@ public:
    */
   WeakHandle& operator=(WeakHandle&& other) noexcept {
     if (this != &other) {
-      std::lock_guard<std::mutex> lockThis(m_mutex);
-      std::lock_guard<std::mutex> lockOther(other.m_mutex);
-      m_ptr = other.m_ptr;
-      m_isValid.store(other.m_isValid.load(std::memory_order_acquire), std::memory_order_release);
-      other.m_ptr = nullptr;
-      other.m_isValid.store(false, std::memory_order_release);
+      releaseSlot();
+      m_table = other.m_table;
+      m_slot = other.m_slot;
+      other.m_slot = nullptr;
     }
     return *this;
   }
 
   /**
-   * @brief デストラクタ
+   * @brief デストラクタ（スロットをテーブルに返却）
    */
-  ~WeakHandle() = default;
+  ~WeakHandle() {
+    releaseSlot();
+  }
 
   /**
    * @brief 参照先のオブジェクトを取得
    * @return 参照先のオブジェクト（無効な場合はnullptr）
    */
   T* get() const {
-    if (!m_isValid.load(std::memory_order_acquire)) {
-      return nullptr;
-    }
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_isValid.load(std::memory_order_acquire) ? m_ptr : nullptr;
+    return m_slot ? static_cast<T*>(m_slot->object.load(std::memory_order_acquire)) : nullptr;
   }
 
   /**
    * @brief 参照先のオブジェクトをリセット
    */
   void reset() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_ptr = nullptr;
-    m_isValid.store(false, std::memory_order_release);
+    releaseSlot();
   }
 
   /**
-   * @brief 参照先のオブジェクトを設定
+   * @brief 参照先のオブジェクトを設定（作成時と同じヒープのセルに限る）
    * @param ptr 新しい参照先のオブジェクト
    */
   void reset(T* ptr) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_ptr = ptr;
-    m_isValid.store(ptr != nullptr, std::memory_order_release);
+    if (m_slot && ptr) {
+      m_slot->object.store(ptr, std::memory_order_release);
+      return;
+    }
+    releaseSlot();
+    m_slot = acquireSlot(ptr);
   }
 
   /**
@@ -132,16 +125,16 @@ public:
    * @return 参照が有効な場合はtrue
    */
   bool isValid() const {
-    return m_isValid.load(std::memory_order_acquire);
+    return get() != nullptr;
   }
 
   /**
    * @brief 参照を無効化（GC用）
    */
   void invalidate() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_isValid.store(false, std::memory_order_release);
-    // ポインタ自体はクリアしない（デバッグ用）
+    if (m_slot) {
+      m_slot->object.store(nullptr, std::memory_order_release);
+    }
   }
 
   /**
@@ -163,21 +156,26 @@ public:
   }
 
 private:
-  /**
-   * @brief 参照先のオブジェクトへのポインタ
-   */
-  T* m_ptr;
+  GlobalHandleTable::Slot* acquireSlot(T* ptr) const {
+    return (ptr && m_table) ? m_table->allocate(ptr, GlobalHandleTable::Kind::Weak) : nullptr;
+  }
+
+  void releaseSlot() {
+    if (m_slot) {
+      m_table->release(m_slot);
+      m_slot = nullptr;
+    }
+  }
 
   /**
-   * @brief 参照の有効状態
-   * アトミックな操作で並列アクセスを安全に処理
+   * @brief スロットを確保したヒープのハンドルテーブル
    */
-  mutable std::atomic<bool> m_isValid;
+  GlobalHandleTable* m_table;
 
   /**
-   * @brief スレッドセーフ操作のためのミューテックス
+   * @brief 参照先を保持する弱スロット（参照先がない場合はnullptr）
    */
-  mutable std::mutex m_mutex;
+  GlobalHandleTable::Slot* m_slot;
 };
 
 } // namespace aero
@@ -6,6 +6,7 @@
  */
 
 #include "cpu_features.h"
+#include "numa_topology.h"
 #include <cstring>
 #include <thread>
 
@@ -97,7 +98,7 @@ void CPUFeatures::detectX86Features() {
   
   // AMDの拡張機能（CPUID 0x80000001）
   cpuidex(info, 0x80000000, 0);
-  int maxExtendedFunc = info[0];
+  uint32_t maxExtendedFunc = static_cast<uint32_t>(info[0]);
   
   if (maxExtendedFunc >= 0x80000001) {
     cpuidex(info, 0x80000001, 0);
@@ -347,5 +348,9 @@ int CPUFeatures::getNumPhysicalCores() {
   return getNumHardwareThreads();
 }
 
+int CPUFeatures::getNumNumaNodes() {
+  return NumaTopology::get().nodeCount();
+}
+
 }  // namespace utils
 }  // namespace aerojs 
\ No newline at end of file
@@ -94,6 +94,12 @@ public:
    */
   static int getNumPhysicalCores();
 
+  /**
+   * @brief NUMAノード数を取得
+   * @return NUMAノード数（検出できない場合は1）
+   */
+  static int getNumNumaNodes();
+
   /**
    * @brief キャッシュラインサイズを取得
    * @return キャッシュラインサイズ（バイト単位）
@@ -0,0 +1,303 @@
+/**
+ * @file numa_topology.cpp
+ * @brief NUMAトポロジの検出とノードへのメモリ・スレッド配置の実装
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "numa_topology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+  #include <dirent.h>
+  #include <sched.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace aerojs {
+namespace utils {
+
+namespace {
+
+std::atomic<NumaTopology*> g_topology{nullptr};
+std::once_flag g_detectOnce;
+
+// "0-3,8,10-11" 形式のCPUリスト
+std::vector<int> parseCpuList(const char* text) {
+  std::vector<int> cpus;
+  const char* p = text;
+  while (*p) {
+    char* end = nullptr;
+    long first = std::strtol(p, &end, 10);
+    if (end == p) {
+      break;
+    }
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = std::strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+    if (*p != ',') {
+      break;
+    }
+    ++p;
+  }
+  return cpus;
+}
+
+// プロセスが実行を許されているCPU
+std::vector<int> allowedCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    int count = std::max(1u, std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < count; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+#if defined(__linux__)
+bool readNodeFile(int systemId, const char* name, char* buffer, size_t size) {
+  char path[128];
+  std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/%s", systemId, name);
+  FILE* file = std::fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+  bool ok = std::fgets(buffer, static_cast<int>(size), file) != nullptr;
+  std::fclose(file);
+  return ok;
+}
+
+uint64_t readNodeMemory(int systemId) {
+  char path[128];
+  std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", systemId);
+  FILE* file = std::fopen(path, "r");
+  if (!file) {
+    return 0;
+  }
+
+  uint64_t bytes = 0;
+  char line[256];
+  while (std::fgets(line, sizeof(line), file)) {
+    // "Node 0 MemTotal:       16318484 kB"
+    const char* field = std::strstr(line, "MemTotal:");
+    if (field) {
+      unsigned long long kilobytes = 0;
+      if (std::sscanf(field + 9, "%llu", &kilobytes) == 1) {
+        bytes = static_cast<uint64_t>(kilobytes) * 1024;
+      }
+      break;
+    }
+  }
+  std::fclose(file);
+  return bytes;
+}
+#endif
+
+}  // namespace
+
+const NumaTopology& NumaTopology::get() {
+  NumaTopology* topology = g_topology.load(std::memory_order_acquire);
+  if (topology) {
+    return *topology;
+  }
+
+  std::call_once(g_detectOnce, []() {
+    NumaTopology* detected = nullptr;
+    const char* fakeNodes = std::getenv("AEROJS_FAKE_NUMA_NODES");
+    if (fakeNodes && std::atoi(fakeNodes) > 0) {
+      detected = new NumaTopology(fake(std::atoi(fakeNodes)));
+    } else {
+      detected = new NumaTopology(detect());
+    }
+    NumaTopology* expected = nullptr;
+    if (!g_topology.compare_exchange_strong(expected, detected, std::memory_order_acq_rel)) {
+      delete detected;  // 検出中に setOverride された
+    }
+  });
+  return *g_topology.load(std::memory_order_acquire);
+}
+
+void NumaTopology::setOverride(const NumaTopology& topology) {
+  // 以前のトポロジへの参照が残っている可能性があるため解放しない（テスト用途でまれ）
+  g_topology.store(new NumaTopology(topology), std::memory_order_release);
+}
+
+NumaTopology NumaTopology::detect() {
+  NumaTopology topology;
+
+#if defined(__linux__)
+  if (DIR* dir = opendir("/sys/devices/system/node")) {
+    while (dirent* entry = readdir(dir)) {
+      int systemId = 0;
+      char rest = 0;
+      if (std::sscanf(entry->d_name, "node%d%c", &systemId, &rest) != 1) {
+        continue;
+      }
+
+      char cpuList[4096];
+      if (!readNodeFile(systemId, "cpulist", cpuList, sizeof(cpuList))) {
+        continue;
+      }
+      NumaNode node;
+      node.systemId = systemId;
+      node.cpus = parseCpuList(cpuList);
+      node.memoryBytes = readNodeMemory(systemId);
+      // CPUのないメモリだけのノードにはワーカーを置けないため対象外
+      if (!node.cpus.empty()) {
+        topology.m_nodes.push_back(std::move(node));
+      }
+    }
+    closedir(dir);
+  }
+
+  std::sort(topology.m_nodes.begin(), topology.m_nodes.end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.systemId < b.systemId; });
+#endif
+
+  if (topology.m_nodes.empty()) {
+    NumaNode node;
+    node.cpus = allowedCpus();
+    topology.m_nodes.push_back(std::move(node));
+  }
+
+  for (size_t i = 0; i < topology.m_nodes.size(); ++i) {
+    topology.m_nodes[i].id = static_cast<int>(i);
+  }
+  topology.buildCpuIndex();
+  return topology;
+}
+
+NumaTopology NumaTopology::fake(int nodeCount) {
+  NumaTopology topology;
+  topology.m_fake = true;
+
+  std::vector<int> cpus = allowedCpus();
+  nodeCount = std::max(1, nodeCount);
+  topology.m_nodes.resize(static_cast<size_t>(nodeCount));
+
+  // CPUを連続した範囲で振り分ける（CPUよりノードが多い場合は共有させる）
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    size_t node = i * static_cast<size_t>(nodeCount) / cpus.size();
+    topology.m_nodes[node].cpus.push_back(cpus[i]);
+  }
+  for (int id = 0; id < nodeCount; ++id) {
+    NumaNode& node = topology.m_nodes[static_cast<size_t>(id)];
+    node.id = id;
+    node.systemId = id;
+    if (node.cpus.empty()) {
+      node.cpus.push_back(cpus[static_cast<size_t>(id) % cpus.size()]);
+    }
+  }
+
+  topology.buildCpuIndex();
+  return topology;
+}
+
+void NumaTopology::buildCpuIndex() {
+  m_cpuToNode.clear();
+  for (const NumaNode& node : m_nodes) {
+    for (int cpu : node.cpus) {
+      if (cpu < 0) {
+        continue;
+      }
+      if (static_cast<size_t>(cpu) >= m_cpuToNode.size()) {
+        m_cpuToNode.resize(static_cast<size_t>(cpu) + 1, -1);
+      }
+      // 偽のトポロジで共有されるCPUは最初のノードに属する
+      if (m_cpuToNode[static_cast<size_t>(cpu)] < 0) {
+        m_cpuToNode[static_cast<size_t>(cpu)] = node.id;
+      }
+    }
+  }
+}
+
+int NumaTopology::nodeOfCpu(int cpu) const {
+  if (cpu < 0 || static_cast<size_t>(cpu) >= m_cpuToNode.size()) {
+    return 0;
+  }
+  int node = m_cpuToNode[static_cast<size_t>(cpu)];
+  return node < 0 ? 0 : node;
+}
+
+bool bindMemoryToNode(void* memory, size_t size, int node) {
+  const NumaTopology& topology = NumaTopology::get();
+  if (!memory || size == 0 || topology.isFake() || !topology.isMultiNode() ||
+      node < 0 || node >= topology.nodeCount()) {
+    return false;
+  }
+
+#if defined(__linux__) && defined(SYS_mbind)
+  // libnuma に依存しないよう mbind を直接呼ぶ。
+  // ノードのメモリが尽きたときに割り当て失敗にならないよう MPOL_PREFERRED を使う
+  constexpr int kMpolPreferred = 1;
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;
+  int systemId = topology.node(node).systemId;
+  std::vector<unsigned long> mask(static_cast<size_t>(systemId) / kBitsPerWord + 1, 0);
+  mask[static_cast<size_t>(systemId) / kBitsPerWord] |= 1UL << (systemId % kBitsPerWord);
+  long result = syscall(SYS_mbind, memory, size, kMpolPreferred, mask.data(),
+                        mask.size() * kBitsPerWord + 1, 0);
+  return result == 0;
+#else
+  return false;
+#endif
+}
+
+bool pinCurrentThreadToNode(int node) {
+  const NumaTopology& topology = NumaTopology::get();
+  if (node < 0 || node >= topology.nodeCount()) {
+    return false;
+  }
+
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : topology.node(node).cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+int currentNumaNode() {
+#if defined(__linux__)
+  int cpu = sched_getcpu();
+  if (cpu >= 0) {
+    return NumaTopology::get().nodeOfCpu(cpu);
+  }
+#endif
+  return 0;
+}
+
+}  // namespace utils
+}  // namespace aerojs
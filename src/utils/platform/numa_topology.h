@@ -0,0 +1,109 @@
+/**
+ * @file numa_topology.h
+ * @brief NUMAトポロジの検出とノードへのメモリ・スレッド配置
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#ifndef AEROJS_UTILS_PLATFORM_NUMA_TOPOLOGY_H
+#define AEROJS_UTILS_PLATFORM_NUMA_TOPOLOGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aerojs {
+namespace utils {
+
+/**
+ * @brief NUMAノード1つ分の情報
+ */
+struct NumaNode {
+  int id = 0;                ///< ノード番号（0から連番に詰めたもの）
+  int systemId = 0;          ///< OS上のノード番号（sysfs の nodeN）
+  std::vector<int> cpus;     ///< このノードに属する論理CPU番号
+  uint64_t memoryBytes = 0;  ///< ノードのメモリ量（不明なら0）
+};
+
+/**
+ * @brief NUMAトポロジ
+ *
+ * Linux では /sys/devices/system/node/nodeN/cpulist と meminfo から検出する。
+ * 検出できない環境では全CPUを含む1ノードとして扱う。
+ *
+ * 単一ノードの環境でもノード別の経路を試せるよう、環境変数
+ * AEROJS_FAKE_NUMA_NODES=N または setOverride(fake(N)) で、CPUを N 個の
+ * ノードに振り分けた偽のトポロジを使える。偽のトポロジではスレッドの
+ * ピン留めは振り分けたCPUに対して実際に行うが、メモリのノード割り当て
+ * （mbind）は行わない。
+ */
+class NumaTopology {
+public:
+  /**
+   * @brief プロセスで使うトポロジ（初回呼び出し時に検出）
+   */
+  static const NumaTopology& get();
+
+  /**
+   * @brief OSからトポロジを検出
+   */
+  static NumaTopology detect();
+
+  /**
+   * @brief オンラインのCPUを nodeCount 個のノードに連続して振り分けた偽のトポロジ
+   */
+  static NumaTopology fake(int nodeCount);
+
+  /**
+   * @brief get() が返すトポロジを差し替える（テスト用。ヒープやGCの生成前に呼ぶ）
+   */
+  static void setOverride(const NumaTopology& topology);
+
+  int nodeCount() const { return static_cast<int>(m_nodes.size()); }
+  const NumaNode& node(int id) const { return m_nodes[static_cast<size_t>(id)]; }
+  const std::vector<NumaNode>& nodes() const { return m_nodes; }
+
+  /**
+   * @brief CPUが属するノード（不明なCPUは0）
+   */
+  int nodeOfCpu(int cpu) const;
+
+  /**
+   * @brief 偽のトポロジかどうか
+   */
+  bool isFake() const { return m_fake; }
+
+  /**
+   * @brief 複数ノードに分かれているかどうか
+   */
+  bool isMultiNode() const { return m_nodes.size() > 1; }
+
+private:
+  void buildCpuIndex();
+
+  std::vector<NumaNode> m_nodes;
+  std::vector<int> m_cpuToNode;
+  bool m_fake = false;
+};
+
+/**
+ * @brief メモリ範囲を指定ノードに割り当てる（まだ触れていないページに効く）
+ * @return 割り当てた場合 true（偽のトポロジ、単一ノード、非対応環境では false）
+ */
+bool bindMemoryToNode(void* memory, size_t size, int node);
+
+/**
+ * @brief 呼び出しスレッドを指定ノードのCPUにピン留め
+ * @return ピン留めできた場合 true
+ */
+bool pinCurrentThreadToNode(int node);
+
+/**
+ * @brief 呼び出しスレッドが現在動いているノード
+ */
+int currentNumaNode();
+
+}  // namespace utils
+}  // namespace aerojs
+
+#endif  // AEROJS_UTILS_PLATFORM_NUMA_TOPOLOGY_H
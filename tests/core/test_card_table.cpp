@@ -0,0 +1,120 @@
+/**
+ * @file test_card_table.cpp
+ * @brief オールド→ヤング参照を追跡するカード表のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "utils/memory/gc/card_table.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+// カード表は書き込みバリアでアドレスを参照しないので、任意のアドレスで試せる
+const void* address(uintptr_t value) {
+  return reinterpret_cast<const void*>(value);
+}
+
+constexpr uintptr_t kRegionBase = uintptr_t(0x40) << CardTable::kRegionShift;
+
+}  // namespace
+
+// 未確保リージョンへの書き込みは破棄用カード列に流れ、記録されない
+TEST(CardTableTest, UncoveredRegionIsDiscarded) {
+  CardTable table;
+
+  table.markCard(address(kRegionBase + 100));
+  EXPECT_FALSE(table.isCardMarked(address(kRegionBase + 100)));
+  EXPECT_EQ(table.cardFor(address(kRegionBase)), nullptr);
+  EXPECT_EQ(table.getRegionCount(), 0u);
+}
+
+// 確保済みリージョンではカード単位で汚れ、同じカード内のアドレスは同じ状態を共有する
+TEST(CardTableTest, MarksAndClearsCards) {
+  CardTable table;
+  table.ensureCovered(address(kRegionBase), 64);
+  ASSERT_EQ(table.getRegionCount(), 1u);
+  EXPECT_EQ(table.getCardCount(), CardTable::kCardsPerRegion);
+
+  table.markCard(address(kRegionBase + 10));
+  EXPECT_TRUE(table.isCardMarked(address(kRegionBase)));
+  EXPECT_TRUE(table.isCardMarked(address(kRegionBase + CardTable::kCardSize - 1)));
+  EXPECT_FALSE(table.isCardMarked(address(kRegionBase + CardTable::kCardSize)));
+
+  table.clearCard(address(kRegionBase + 20));
+  EXPECT_FALSE(table.isCardMarked(address(kRegionBase)));
+
+  table.markCard(address(kRegionBase + 3 * CardTable::kCardSize));
+  table.markCard(address(kRegionBase + 9 * CardTable::kCardSize));
+  table.clearAll();
+  EXPECT_FALSE(table.isCardMarked(address(kRegionBase + 3 * CardTable::kCardSize)));
+  EXPECT_FALSE(table.isCardMarked(address(kRegionBase + 9 * CardTable::kCardSize)));
+}
+
+// リージョン境界を跨ぐ割り当ては両方のリージョンを確保し、再度の確保は増やさない
+TEST(CardTableTest, CoverageSpansRegions) {
+  CardTable table;
+  table.ensureCovered(address(kRegionBase + CardTable::kRegionSize - 16), 32);
+  EXPECT_EQ(table.getRegionCount(), 2u);
+
+  table.ensureCovered(address(kRegionBase + 8), 8);
+  table.ensureCovered(address(kRegionBase + CardTable::kRegionSize + 8), 8);
+  EXPECT_EQ(table.getRegionCount(), 2u);
+
+  table.markCard(address(kRegionBase + CardTable::kRegionSize));
+  EXPECT_TRUE(table.isCardMarked(address(kRegionBase + CardTable::kRegionSize)));
+}
+
+// ダーティカードだけがカード先頭アドレスとともに列挙され、走査側で掃除できる
+TEST(CardTableTest, EnumeratesDirtyCards) {
+  CardTable table;
+  table.ensureCovered(address(kRegionBase), CardTable::kRegionSize);
+
+  const uintptr_t first = kRegionBase + 5 * CardTable::kCardSize;
+  const uintptr_t second = kRegionBase + 70 * CardTable::kCardSize;
+  table.markCard(address(first + 1));
+  table.markCard(address(second + 100));
+
+  std::vector<uintptr_t> starts;
+  table.forEachDirtyCard(0, table.getRegionCount(), [&](uint8_t& card, uintptr_t cardStart) {
+    starts.push_back(cardStart);
+    if (cardStart == first) {
+      card = CardTable::kClean;
+    }
+  });
+  ASSERT_EQ(starts.size(), 2u);
+  EXPECT_EQ(starts[0], first);
+  EXPECT_EQ(starts[1], second);
+
+  EXPECT_FALSE(table.isCardMarked(address(first)));
+  EXPECT_TRUE(table.isCardMarked(address(second)));
+}
+
+// 複数のスレッドが同じリージョンを同時に確保しても、カード列は1つだけ作られる
+TEST(CardTableTest, ConcurrentCoverage) {
+  CardTable table;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&table, t] {
+      for (int i = 0; i < 1000; i++) {
+        uintptr_t offset = (static_cast<uintptr_t>(t) * 1000 + i) * 64;
+        table.ensureCovered(address(kRegionBase + offset), 64);
+        table.markCard(address(kRegionBase + offset));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(table.getRegionCount(), 1u);
+  EXPECT_TRUE(table.isCardMarked(address(kRegionBase)));
+}
@@ -0,0 +1,122 @@
+/**
+ * @file test_ephemeron_table.cpp
+ * @brief 弱キー表（エフェメロン表）のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "utils/memory/gc/ephemeron_table.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+struct Key {
+  int id;
+};
+
+}  // namespace
+
+// キーの同一性で設定・検索し、同じキーへの設定は上書きになる
+TEST(EphemeronTableTest, SetFindOverwrite) {
+  EphemeronTable<Key, std::string> table;
+  Key a{1};
+  Key b{1};
+
+  EXPECT_TRUE(table.set(&a, "a"));
+  EXPECT_TRUE(table.set(&b, "b"));
+  EXPECT_EQ(table.size(), 2u);
+  ASSERT_NE(table.find(&a), nullptr);
+  EXPECT_EQ(*table.find(&a), "a");
+
+  EXPECT_FALSE(table.set(&a, "a2"));
+  EXPECT_EQ(table.size(), 2u);
+  EXPECT_EQ(*table.find(&a), "a2");
+  EXPECT_EQ(*table.find(&b), "b");
+  EXPECT_EQ(table.find(nullptr), nullptr);
+}
+
+// 削除したキーは見つからず、同じ探索列上の他のキーは墓標を越えて見つかる
+TEST(EphemeronTableTest, RemoveLeavesOtherKeysReachable) {
+  EphemeronTable<Key, int> table;
+  std::vector<Key> keys(10);
+  for (int i = 0; i < 10; i++) {
+    table.set(&keys[i], i);
+  }
+
+  EXPECT_TRUE(table.remove(&keys[3]));
+  EXPECT_FALSE(table.remove(&keys[3]));
+  EXPECT_FALSE(table.contains(&keys[3]));
+  EXPECT_EQ(table.size(), 9u);
+  for (int i = 0; i < 10; i++) {
+    if (i != 3) {
+      ASSERT_NE(table.find(&keys[i]), nullptr) << i;
+      EXPECT_EQ(*table.find(&keys[i]), i);
+    }
+  }
+
+  EXPECT_TRUE(table.set(&keys[3], 30));
+  EXPECT_EQ(*table.find(&keys[3]), 30);
+  EXPECT_EQ(table.size(), 10u);
+}
+
+// 負荷率を超えると容量を倍にし、全エントリを保つ
+TEST(EphemeronTableTest, GrowsPastLoadFactor) {
+  EphemeronTable<Key, int> table;
+  EXPECT_EQ(table.capacity(), 16u);
+
+  std::vector<Key> keys(1000);
+  for (int i = 0; i < 1000; i++) {
+    table.set(&keys[i], i);
+  }
+  EXPECT_EQ(table.size(), 1000u);
+  EXPECT_GE(table.capacity() * 3, table.size() * 4);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_NE(table.find(&keys[i]), nullptr) << i;
+    EXPECT_EQ(*table.find(&keys[i]), i);
+  }
+}
+
+// 追加と削除を繰り返しても、墓標は同じ容量での再構築で片付き、容量は増え続けない
+TEST(EphemeronTableTest, TombstoneChurnKeepsCapacity) {
+  EphemeronTable<Key, int> table;
+  std::vector<Key> keys(4);
+
+  for (int round = 0; round < 1000; round++) {
+    Key& key = keys[round % keys.size()];
+    table.set(&key, round);
+    table.remove(&key);
+  }
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.capacity(), 16u);
+}
+
+// forEach は生きているエントリだけを列挙し、clear で全て消える
+TEST(EphemeronTableTest, ForEachAndClear) {
+  EphemeronTable<Key, int> table;
+  std::vector<Key> keys(5);
+  for (int i = 0; i < 5; i++) {
+    table.set(&keys[i], i);
+  }
+  table.remove(&keys[1]);
+
+  std::set<int> seen;
+  table.forEach([&](Key* key, int value) {
+    EXPECT_EQ(key, &keys[value]);
+    seen.insert(value);
+  });
+  EXPECT_EQ(seen, (std::set<int>{0, 2, 3, 4}));
+
+  table.clear();
+  EXPECT_TRUE(table.empty());
+  EXPECT_FALSE(table.contains(&keys[0]));
+  size_t visited = 0;
+  table.forEach([&](Key*, int) { visited++; });
+  EXPECT_EQ(visited, 0u);
+}
@@ -0,0 +1,131 @@
+/**
+ * @file test_feedback_vector.cpp
+ * @brief 関数ごとのフィードバックベクタのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "core/vm/bytecode/feedback_vector.h"
+
+using namespace aerojs::core;
+
+namespace {
+
+// 命令オフセット 0, 4, 8, 12 にプロパティ・呼び出し・算術・比較のサイトを持つベクタ
+FeedbackVector makeVector() {
+  return FeedbackVector({0, 4, 8, 12},
+                        {FeedbackSlotKind::kProperty, FeedbackSlotKind::kCall,
+                         FeedbackSlotKind::kBinaryOp, FeedbackSlotKind::kCompareOp});
+}
+
+constexpr uint32_t kProperty = 0;
+constexpr uint32_t kCall = 1;
+constexpr uint32_t kBinaryOp = 2;
+constexpr uint32_t kCompareOp = 3;
+
+} // namespace
+
+// 命令オフセットからスロットを引ける
+TEST(FeedbackVectorTest, SlotForOffset) {
+  FeedbackVector vector = makeVector();
+
+  EXPECT_EQ(vector.slotCount(), 4u);
+  EXPECT_EQ(vector.slotForOffset(0), 0);
+  EXPECT_EQ(vector.slotForOffset(8), 2);
+  EXPECT_EQ(vector.slotForOffset(5), -1);
+  EXPECT_EQ(vector.siteOffset(3), 12u);
+  EXPECT_EQ(vector.kind(kCall), FeedbackSlotKind::kCall);
+}
+
+// 同じシェイプの記録は単型のまま、異なるシェイプで多型、上限を超えると超多型になる
+TEST(FeedbackVectorTest, PropertyStateProgression) {
+  FeedbackVector vector = makeVector();
+  EXPECT_EQ(vector.state(kProperty), FeedbackState::kUninitialized);
+
+  uint32_t handler = encodePropertyHandler(PropertyHandlerKind::kInlineField, 0);
+  vector.recordProperty(kProperty, 10, handler);
+  vector.recordProperty(kProperty, 10, handler);
+
+  FeedbackSnapshot mono = vector.snapshot(kProperty);
+  EXPECT_TRUE(mono.isMonomorphic());
+  EXPECT_EQ(mono.entryCount, 1u);
+  EXPECT_EQ(mono.targets[0], 10u);
+  EXPECT_EQ(mono.handlers[0], handler);
+  EXPECT_EQ(mono.count, 2u);
+
+  vector.recordProperty(kProperty, 11, encodePropertyHandler(PropertyHandlerKind::kOutOfLineField, 1));
+  FeedbackSnapshot poly = vector.snapshot(kProperty);
+  EXPECT_EQ(poly.state, FeedbackState::kPolymorphic);
+  ASSERT_EQ(poly.entryCount, 2u);
+  EXPECT_EQ(poly.targets[0], 10u);
+  EXPECT_EQ(poly.targets[1], 11u);
+
+  for (uint64_t shape = 12; shape < 12 + FeedbackVector::kMaxPolymorphic; shape++) {
+    vector.recordProperty(kProperty, shape, handler);
+  }
+  EXPECT_TRUE(vector.snapshot(kProperty).isMegamorphic());
+
+  // 超多型からは戻らない
+  vector.recordProperty(kProperty, 10, handler);
+  EXPECT_EQ(vector.state(kProperty), FeedbackState::kMegamorphic);
+}
+
+// 呼び出し先も同じ規則で状態が進む
+TEST(FeedbackVectorTest, CallTargets) {
+  FeedbackVector vector = makeVector();
+
+  vector.recordCall(kCall, 0x1000);
+  EXPECT_TRUE(vector.snapshot(kCall).isMonomorphic());
+
+  vector.recordCall(kCall, 0x2000);
+  FeedbackSnapshot snapshot = vector.snapshot(kCall);
+  EXPECT_EQ(snapshot.state, FeedbackState::kPolymorphic);
+  EXPECT_EQ(snapshot.entryCount, 2u);
+
+  vector.markMegamorphic(kCall);
+  EXPECT_TRUE(vector.snapshot(kCall).isMegamorphic());
+}
+
+// 算術・比較の型ヒントはビット和で蓄積する
+TEST(FeedbackVectorTest, BinaryOpHintsAccumulate) {
+  FeedbackVector vector = makeVector();
+
+  vector.recordBinaryOp(kBinaryOp, BinaryOpHint::kSignedSmall);
+  EXPECT_EQ(vector.snapshot(kBinaryOp).hint, BinaryOpHint::kSignedSmall);
+
+  vector.recordBinaryOp(kBinaryOp, BinaryOpHint::kNumber);
+  EXPECT_EQ(vector.snapshot(kBinaryOp).hint, BinaryOpHint::kSignedSmall | BinaryOpHint::kNumber);
+
+  vector.recordBinaryOp(kCompareOp, BinaryOpHint::kString);
+  EXPECT_EQ(vector.snapshot(kCompareOp).hint, BinaryOpHint::kString);
+  EXPECT_EQ(vector.snapshot(kBinaryOp).kind, FeedbackSlotKind::kBinaryOp);
+}
+
+// clear() は全スロットを未初期化に戻す
+TEST(FeedbackVectorTest, ClearResetsSlots) {
+  FeedbackVector vector = makeVector();
+  vector.recordProperty(kProperty, 1, 0);
+  vector.recordProperty(kProperty, 2, 0);
+  vector.recordCall(kCall, 0x1000);
+  vector.recordBinaryOp(kBinaryOp, BinaryOpHint::kAny);
+
+  vector.clear();
+
+  for (uint32_t slot = 0; slot < vector.slotCount(); slot++) {
+    FeedbackSnapshot snapshot = vector.snapshot(slot);
+    EXPECT_EQ(snapshot.state, FeedbackState::kUninitialized);
+    EXPECT_EQ(snapshot.entryCount, 0u);
+    EXPECT_EQ(snapshot.hint, BinaryOpHint::kNone);
+  }
+}
+
+// ハンドラの符号化は種類とスロット番号を往復できる
+TEST(FeedbackVectorTest, PropertyHandlerEncoding) {
+  uint32_t handler = encodePropertyHandler(PropertyHandlerKind::kPrototypeField, 12345);
+  EXPECT_EQ(propertyHandlerKind(handler), PropertyHandlerKind::kPrototypeField);
+  EXPECT_EQ(propertyHandlerIndex(handler), 12345u);
+}
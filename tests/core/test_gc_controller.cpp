@@ -0,0 +1,97 @@
+/**
+ * @file test_gc_controller.cpp
+ * @brief 割り当てレートとアイドル時間に基づくGCスケジューラのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "utils/memory/gc/gc_controller.h"
+#include "utils/memory/gc/parallel_gc.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+ParallelGCConfig quietConfig() {
+  ParallelGCConfig config;
+  config.workerThreadCount = 1;
+  config.enableConcurrentMarking = false;
+  config.enableConcurrentSweeping = false;
+  return config;
+}
+
+}  // namespace
+
+// 構築直後の目標サイズは現在のナーサリーサイズで、統計は空
+TEST(GCControllerTest, StartsFromCurrentNurserySize) {
+  ParallelGC gc(quietConfig());
+  GCController controller(gc);
+
+  EXPECT_EQ(controller.getYoungGenerationTarget(), gc.getNurserySize());
+  EXPECT_DOUBLE_EQ(controller.getAllocationRate(), 0.0);
+  EXPECT_DOUBLE_EQ(controller.getMutatorUtilization(), 1.0);
+  EXPECT_EQ(controller.getStats().nurseryResizes, 0u);
+}
+
+// 割り当てがなければ目標は最小サイズに張り付き、差がヒステリシスを超えればナーサリーに反映する
+TEST(GCControllerTest, ShrinksIdleNurseryToMinimum) {
+  ParallelGCConfig gcConfig = quietConfig();
+  gcConfig.nurserySize = 8 * 1024 * 1024;
+  ParallelGC gc(gcConfig);
+
+  GCControllerConfig config;
+  config.minNurserySize = 2 * 1024 * 1024;
+  GCController controller(gc, config);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  controller.update();
+
+  EXPECT_EQ(controller.getYoungGenerationTarget(), config.minNurserySize);
+  EXPECT_EQ(gc.getNurserySize(), config.minNurserySize);
+  EXPECT_EQ(controller.getStats().nurseryResizes, 1u);
+
+  // 同じ状態での再計測は変更しない
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  controller.update();
+  EXPECT_EQ(controller.getStats().nurseryResizes, 1u);
+}
+
+// 最小値より短いアイドル時間は使わず、通知回数だけ数える
+TEST(GCControllerTest, IgnoresShortIdlePeriods) {
+  ParallelGC gc(quietConfig());
+  GCController controller(gc);
+
+  controller.notifyIdle(std::chrono::steady_clock::now());
+  EXPECT_EQ(controller.getStats().idleNotifications, 1u);
+  EXPECT_EQ(controller.getStats().idleScavenges, 0u);
+  EXPECT_EQ(controller.getStats().idleMarkingSteps, 0u);
+  EXPECT_DOUBLE_EQ(controller.getStats().idleTimeUsedMs, 0.0);
+}
+
+// 空のヒープではアイドル時間に行う作業がない
+TEST(GCControllerTest, EmptyHeapHasNoIdleWork) {
+  ParallelGC gc(quietConfig());
+  GCController controller(gc);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+  EXPECT_FALSE(controller.notifyIdle(deadline));
+  EXPECT_EQ(controller.getStats().idleScavenges, 0u);
+  EXPECT_EQ(controller.getStats().idleFinalizations, 0u);
+  EXPECT_FALSE(gc.isIncrementalMarkingActive());
+}
+
+// 破棄時に完了コールバックを外すので、その後のコレクションは破棄済みのコントローラを呼ばない
+TEST(GCControllerTest, UnregistersOnDestruction) {
+  ParallelGC gc(quietConfig());
+  {
+    GCController controller(gc);
+    gc.minorCollection(GCCause::ExplicitRequest);
+  }
+  gc.minorCollection(GCCause::ExplicitRequest);
+  SUCCEED();
+}
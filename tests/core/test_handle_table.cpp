@@ -0,0 +1,375 @@
+/**
+ * @file test_handle_table.cpp
+ * @brief ヒープごとのハンドルテーブルと弱参照のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/memory/gc/generational_gc.h"
+#include "utils/memory/smart_ptr/handle_manager.h"
+#include "utils/memory/smart_ptr/handle_table.h"
+#include "utils/memory/smart_ptr/ref_counted.h"
+
+using namespace aero;
+using aerojs::utils::memory::CellState;
+
+namespace {
+
+// テスト用のGCセル（参照を持たない）
+class TestCell : public GCCell {
+public:
+  void trace(aerojs::utils::memory::GarbageCollector*) override {}
+  size_t getSize() const override { return sizeof(TestCell); }
+  void visitReferences(std::function<void(GCCell*)>) override {}
+  void visitMutableReferences(std::function<void(GCCell**)>) override {}
+};
+
+// テスト用の参照カウント対象
+class TestObject : public aerojs::utils::RefCounted {};
+
+std::unordered_set<GCCell*> collectRoots(HandleManager& manager) {
+  std::unordered_set<GCCell*> roots;
+  manager.visitRoots([&roots](GCCell* cell) { roots.insert(cell); });
+  return roots;
+}
+
+} // namespace
+
+// マークされなかったセルを指す弱ハンドルだけがクリアされる
+TEST(HandleTableTest, SweepClearsOnlyDeadWeakHandles) {
+  HandleManager manager;
+  TestCell live;
+  TestCell dead;
+  live.state = CellState::Black;
+  dead.state = CellState::White;
+
+  WeakHandle<TestCell> liveHandle = manager.createWeakHandle(&live);
+  WeakHandle<TestCell> deadHandle = manager.createWeakHandle(&dead);
+
+  size_t cleared = manager.sweepWeakHandles([](GCCell* cell) {
+    return cell->state != CellState::White;
+  });
+
+  EXPECT_EQ(cleared, 1u);
+  EXPECT_EQ(liveHandle.get(), &live);
+  EXPECT_EQ(deadHandle.get(), nullptr);
+  EXPECT_EQ(manager.totalInvalidatedCount(), 1u);
+}
+
+// 片方のヒープのスイープは、もう一方のヒープの弱ハンドルに触れない
+TEST(HandleTableTest, SweepDoesNotCrossHeaps) {
+  HandleManager heapA;
+  HandleManager heapB;
+  TestCell cellA;
+  TestCell cellB;
+
+  WeakHandle<TestCell> handleA = heapA.createWeakHandle(&cellA);
+  WeakHandle<TestCell> handleB = heapB.createWeakHandle(&cellB);
+
+  // ヒープAはどのセルもマークしていない
+  heapA.sweepWeakHandles([](GCCell*) { return false; });
+
+  EXPECT_EQ(handleA.get(), nullptr);
+  EXPECT_EQ(handleB.get(), &cellB);
+  EXPECT_EQ(heapB.activeHandleCount(), 1u);
+}
+
+// 強ハンドルとローカルハンドルは、作成したヒープのルートとしてだけ列挙される
+TEST(HandleTableTest, RootsArePerHeap) {
+  HandleManager heapA;
+  HandleManager heapB;
+  TestCell globalA;
+  TestCell localA;
+  TestCell globalB;
+
+  GlobalHandle<TestCell> strongA = heapA.createGlobalHandle(&globalA);
+  GlobalHandle<TestCell> strongB = heapB.createGlobalHandle(&globalB);
+
+  HandleScope scope(heapA.table());
+  LocalHandle<TestCell> local = LocalHandle<TestCell>::create(heapA.table(), &localA);
+  EXPECT_EQ(local.get(), &localA);
+
+  std::unordered_set<GCCell*> rootsA = collectRoots(heapA);
+  std::unordered_set<GCCell*> rootsB = collectRoots(heapB);
+
+  EXPECT_EQ(rootsA, (std::unordered_set<GCCell*>{&globalA, &localA}));
+  EXPECT_EQ(rootsB, (std::unordered_set<GCCell*>{&globalB}));
+}
+
+// コンパクションで移動したセルへ、そのヒープのハンドルだけが付け替えられる
+TEST(HandleTableTest, RemapIsPerHeap) {
+  HandleManager heapA;
+  HandleManager heapB;
+  TestCell from;
+  TestCell to;
+
+  WeakHandle<TestCell> handleA = heapA.createWeakHandle(&from);
+  WeakHandle<TestCell> handleB = heapB.createWeakHandle(&from);
+
+  std::unordered_map<void*, void*> relocated{{&from, &to}};
+  heapA.afterGC({}, relocated);
+
+  EXPECT_EQ(handleA.get(), &to);
+  EXPECT_EQ(handleB.get(), &from);
+}
+
+// 参照カウント対象への弱参照は、対象の破棄でクリアされる
+TEST(HandleTableTest, WeakRefPtrClearsOnDestruction) {
+  auto strong = aerojs::utils::makeRefPtr<TestObject>();
+  aerojs::utils::WeakRefPtr<TestObject> weak(strong.get());
+
+  EXPECT_EQ(weak.lock().get(), strong.get());
+
+  strong.reset();
+
+  EXPECT_TRUE(weak.expired());
+  EXPECT_FALSE(weak.lock());
+}
+
+// 弱参照を作ると参照カウントは制御ブロックへ移り、以後の増減もそこで数える
+TEST(HandleTableTest, RefCountMovesToWeakControl) {
+  auto strong = aerojs::utils::makeRefPtr<TestObject>();
+  auto second = strong;
+  EXPECT_EQ(strong.refCount(), 2u);
+
+  aerojs::utils::WeakRefPtr<TestObject> weak(strong.get());
+  EXPECT_EQ(strong.refCount(), 2u);
+  EXPECT_EQ(weak.control()->strongCount(), 2u);
+
+  second.reset();
+  {
+    auto locked = weak.lock();
+    EXPECT_EQ(locked.get(), strong.get());
+    EXPECT_EQ(strong.refCount(), 2u);
+  }
+  EXPECT_EQ(strong.refCount(), 1u);
+
+  strong.reset();
+  EXPECT_FALSE(weak.lock());
+}
+
+namespace {
+
+// 破棄の回数を数える参照カウント対象
+class CountedObject : public aerojs::utils::RefCounted {
+public:
+  explicit CountedObject(std::atomic<int>& destroyed) : m_destroyed(destroyed) {}
+  ~CountedObject() override { m_destroyed.fetch_add(1); }
+
+private:
+  std::atomic<int>& m_destroyed;
+};
+
+} // namespace
+
+// 最後の強参照の解放と lock() が競合しても、破棄済みの対象を返さず、破棄は1回だけ
+TEST(HandleTableTest, WeakLockRacesWithLastRelease) {
+  constexpr int kRounds = 2000;
+  for (int round = 0; round < kRounds; round++) {
+    std::atomic<int> destroyed{0};
+    auto strong = aerojs::utils::makeRefPtr<CountedObject>(destroyed);
+    aerojs::utils::WeakRefPtr<CountedObject> weak(strong.get());
+
+    std::atomic<bool> start{false};
+    std::thread locker([&weak, &start, &destroyed] {
+      while (!start.load()) {
+      }
+      for (int i = 0; i < 8; i++) {
+        auto locked = weak.lock();
+        if (locked) {
+          EXPECT_EQ(destroyed.load(), 0);
+        }
+      }
+    });
+    start.store(true);
+    strong.reset();
+    locker.join();
+
+    ASSERT_EQ(destroyed.load(), 1);
+    EXPECT_FALSE(weak.lock());
+  }
+}
+
+namespace {
+
+// 破棄の通知を記録する
+class RecordingObserver : public aerojs::utils::WeakReferenceObserver {
+public:
+  void weakTargetDestroyed(const aerojs::utils::RefCounted* target) override {
+    destroyed.push_back(target);
+  }
+
+  std::vector<const aerojs::utils::RefCounted*> destroyed;
+};
+
+} // namespace
+
+// 対象の破棄は、登録した通知先へ1回だけ届き、解除した通知先には届かない
+TEST(HandleTableTest, WeakReferenceObserverNotifiedOnDestruction) {
+  auto strong = aerojs::utils::makeRefPtr<TestObject>();
+  const aerojs::utils::RefCounted* address = strong.get();
+  aerojs::utils::WeakRefPtr<TestObject> weak(strong.get());
+
+  RecordingObserver registered;
+  RecordingObserver removed;
+  EXPECT_TRUE(weak.control()->addObserver(&registered));
+  EXPECT_TRUE(weak.control()->addObserver(&registered));
+  EXPECT_TRUE(weak.control()->addObserver(&removed));
+  weak.control()->removeObserver(&removed);
+
+  strong.reset();
+
+  EXPECT_EQ(registered.destroyed, (std::vector<const aerojs::utils::RefCounted*>{address}));
+  EXPECT_TRUE(removed.destroyed.empty());
+  EXPECT_FALSE(weak.control()->addObserver(&registered));
+}
+
+// 解放したスロットはフリーリストから再利用される
+TEST(GlobalHandleTableTest, ReleasedSlotIsReused) {
+  GlobalHandleTable table;
+  TestCell cell;
+
+  GlobalHandleTable::Slot* first = table.allocate(&cell, GlobalHandleTable::Kind::Strong);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Strong), 1u);
+
+  table.release(first);
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Strong), 0u);
+
+  GlobalHandleTable::Slot* second = table.allocate(&cell, GlobalHandleTable::Kind::Weak);
+  EXPECT_EQ(second, first);
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Weak), 1u);
+  table.release(second);
+}
+
+// セグメントをまたいで確保しても、スロットのアドレスは変わらない
+TEST(GlobalHandleTableTest, SlotsStayStableAcrossSegments) {
+  GlobalHandleTable table;
+  TestCell cell;
+  std::vector<GlobalHandleTable::Slot*> slots;
+
+  for (size_t i = 0; i < GlobalHandleTable::kSlotsPerSegment * 2 + 1; i++) {
+    slots.push_back(table.allocate(&cell, GlobalHandleTable::Kind::Strong));
+  }
+  GlobalHandleTable::Slot* firstSlot = slots.front();
+
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Strong), slots.size());
+  EXPECT_EQ(firstSlot->object.load(), &cell);
+  for (GlobalHandleTable::Slot* slot : slots) {
+    table.release(slot);
+  }
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Strong), 0u);
+}
+
+// 強スロットだけがルートとして列挙され、弱スロットは visitWeak に現れる
+TEST(GlobalHandleTableTest, VisitStrongAndWeak) {
+  GlobalHandleTable table;
+  TestCell strong;
+  TestCell weak;
+
+  GlobalHandle<TestCell> strongHandle(table, &strong);
+  GlobalHandle<TestCell> weakHandle(table, &weak, GlobalHandleTable::Kind::Weak);
+
+  std::vector<GCCell*> strongCells;
+  std::vector<GCCell*> weakCells;
+  table.visitStrong([&strongCells](GCCell* cell) { strongCells.push_back(cell); });
+  table.visitWeak([&weakCells](GCCell* cell) { weakCells.push_back(cell); });
+
+  EXPECT_EQ(strongCells, (std::vector<GCCell*>{&strong}));
+  EXPECT_EQ(weakCells, (std::vector<GCCell*>{&weak}));
+}
+
+// 付け替えは強・弱の両方のスロットに適用される
+TEST(GlobalHandleTableTest, RemapUpdatesStrongAndWeak) {
+  GlobalHandleTable table;
+  TestCell from;
+  TestCell to;
+
+  GlobalHandle<TestCell> strongHandle(table, &from);
+  GlobalHandle<TestCell> weakHandle(table, &from, GlobalHandleTable::Kind::Weak);
+
+  std::unordered_map<void*, void*> relocated{{&from, &to}};
+  EXPECT_EQ(table.remap(relocated), 2u);
+  EXPECT_EQ(strongHandle.get(), &to);
+  EXPECT_EQ(weakHandle.get(), &to);
+}
+
+// ハンドルの移動は所有を移し、破棄でスロットを返す
+TEST(GlobalHandleTableTest, GlobalHandleMoveAndReset) {
+  GlobalHandleTable table;
+  TestCell cell;
+
+  GlobalHandle<TestCell> original(table, &cell);
+  GlobalHandle<TestCell> moved(std::move(original));
+  EXPECT_FALSE(original);
+  EXPECT_EQ(moved.get(), &cell);
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Strong), 1u);
+
+  moved.reset();
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Strong), 0u);
+}
+
+// ローカルハンドルはスコープを抜けると巻き戻され、入れ子のスコープは内側だけが戻る
+TEST(GlobalHandleTableTest, HandleScopesRewindLocals) {
+  GlobalHandleTable table;
+  TestCell outer;
+  TestCell inner;
+
+  HandleScope outerScope(table);
+  LocalHandle<TestCell> outerHandle = LocalHandle<TestCell>::create(table, &outer);
+  {
+    HandleScope innerScope(table);
+    for (size_t i = 0; i < LocalHandleBlocks::kBlockSize + 1; i++) {
+      LocalHandle<TestCell>::create(table, &inner);
+    }
+    EXPECT_EQ(table.localBlocks().size(), LocalHandleBlocks::kBlockSize + 2);
+  }
+
+  EXPECT_EQ(table.localBlocks().size(), 1u);
+  EXPECT_EQ(outerHandle.get(), &outer);
+
+  std::vector<GCCell*> locals;
+  table.visitLocals([&locals](GCCell* cell) { locals.push_back(cell); });
+  EXPECT_EQ(locals, (std::vector<GCCell*>{&outer}));
+}
+
+// 複数スレッドから同時に確保・解放しても、スロットを重複して渡さない
+TEST(GlobalHandleTableTest, ConcurrentAllocateRelease) {
+  constexpr int kThreads = 4;
+  constexpr int kIterations = 2000;
+  GlobalHandleTable table;
+  TestCell cell;
+
+  std::vector<std::thread> threads;
+  std::vector<std::vector<GlobalHandleTable::Slot*>> kept(kThreads);
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&table, &cell, &kept, t] {
+      for (int i = 0; i < kIterations; i++) {
+        GlobalHandleTable::Slot* slot = table.allocate(&cell, GlobalHandleTable::Kind::Strong);
+        if (i % 2 == 0) {
+          kept[t].push_back(slot);
+        } else {
+          table.release(slot);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::unordered_set<GlobalHandleTable::Slot*> unique;
+  for (const auto& slots : kept) {
+    unique.insert(slots.begin(), slots.end());
+  }
+  EXPECT_EQ(unique.size(), static_cast<size_t>(kThreads * kIterations / 2));
+  EXPECT_EQ(table.countInUse(GlobalHandleTable::Kind::Strong), unique.size());
+}
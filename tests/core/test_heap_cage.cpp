@@ -0,0 +1,95 @@
+/**
+ * @file test_heap_cage.cpp
+ * @brief ポインタ圧縮用の4GBヒープケージのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "utils/memory/allocators/heap_cage.h"
+
+using namespace aerojs::utils::memory;
+
+// ケージは4GB境界に予約され、nullptr はオフセット0に対応する
+TEST(HeapCageTest, CompressesRelativeToBase) {
+  HeapCage& cage = HeapCage::instance();
+  ASSERT_TRUE(cage.isReserved());
+  EXPECT_EQ(HeapCage::base() % HeapCage::kCageAlignment, 0u);
+
+  EXPECT_EQ(HeapCage::compress(nullptr), 0u);
+  EXPECT_EQ(HeapCage::decompress(0), nullptr);
+
+  void* region = cage.allocateRegion(1);
+  ASSERT_NE(region, nullptr);
+  uint32_t offset = HeapCage::compress(region);
+  EXPECT_GE(offset, HeapCage::kGranularity);
+  EXPECT_EQ(HeapCage::decompress(offset), region);
+  cage.releaseRegion(region, 1);
+}
+
+// 領域は払い出し単位に切り上げて読み書き可能にし、要求したアライメントを守る
+TEST(HeapCageTest, AllocatesWritableAlignedRegions) {
+  HeapCage& cage = HeapCage::instance();
+  size_t committedBefore = cage.committedBytes();
+
+  void* small = cage.allocateRegion(100);
+  ASSERT_NE(small, nullptr);
+  EXPECT_TRUE(cage.contains(small));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % HeapCage::kGranularity, 0u);
+  EXPECT_EQ(cage.committedBytes(), committedBefore + HeapCage::kGranularity);
+  std::memset(small, 0x5A, HeapCage::kGranularity);
+
+  const size_t alignment = 1024 * 1024;
+  void* aligned = cage.allocateRegion(3 * HeapCage::kGranularity, alignment);
+  ASSERT_NE(aligned, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % alignment, 0u);
+  std::memset(aligned, 0xA5, 3 * HeapCage::kGranularity);
+
+  cage.releaseRegion(aligned, 3 * HeapCage::kGranularity);
+  cage.releaseRegion(small, 100);
+  EXPECT_EQ(cage.committedBytes(), committedBefore);
+}
+
+// 返却した領域は同じ大きさの次の要求で再利用される
+TEST(HeapCageTest, ReusesReleasedRegions) {
+  HeapCage& cage = HeapCage::instance();
+
+  void* first = cage.allocateRegion(2 * HeapCage::kGranularity);
+  void* second = cage.allocateRegion(2 * HeapCage::kGranularity);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+
+  cage.releaseRegion(first, 2 * HeapCage::kGranularity);
+  EXPECT_EQ(cage.allocateRegion(2 * HeapCage::kGranularity), first);
+
+  cage.releaseRegion(first, 2 * HeapCage::kGranularity);
+  cage.releaseRegion(second, 2 * HeapCage::kGranularity);
+}
+
+// ケージ外のアドレスの返却は無視する
+TEST(HeapCageTest, IgnoresForeignRelease) {
+  HeapCage& cage = HeapCage::instance();
+  size_t committedBefore = cage.committedBytes();
+
+  int local = 0;
+  EXPECT_FALSE(cage.contains(&local));
+  cage.releaseRegion(&local, sizeof(local));
+  cage.releaseRegion(nullptr, HeapCage::kGranularity);
+  EXPECT_EQ(cage.committedBytes(), committedBefore);
+}
+
+// オブジェクト割り当てはケージ内に置かれ、32ビットオフセットで往復できる
+TEST(HeapCageTest, AllocatesObjectsInsideCage) {
+  void* object = HeapCage::allocateObject(48);
+  ASSERT_NE(object, nullptr);
+  EXPECT_TRUE(HeapCage::instance().contains(object));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(object) % alignof(std::max_align_t), 0u);
+  EXPECT_EQ(HeapCage::decompress(HeapCage::compress(object)), object);
+  std::memset(object, 0, 48);
+  HeapCage::freeObject(object);
+  HeapCage::freeObject(nullptr);
+}
@@ -0,0 +1,221 @@
+/**
+ * @file test_heap_snapshot.cpp
+ * @brief ヒープスナップショットの書き出しとオフライン解析のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/memory/gc/generational_gc.h"
+#include "utils/memory/gc/heap_snapshot_analyzer.h"
+#include "utils/memory/gc/heap_snapshot_writer.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+// 参照先と大きさを指定できるテスト用のGCセル
+class SnapshotCell : public GCCell {
+public:
+  explicit SnapshotCell(size_t size) : m_size(size) {}
+
+  void trace(GarbageCollector*) override {}
+  size_t getSize() const override { return m_size; }
+  void visitReferences(std::function<void(GCCell*)> visitor) override {
+    for (GCCell* ref : refs) {
+      visitor(ref);
+    }
+  }
+  void visitMutableReferences(std::function<void(GCCell**)> visitor) override {
+    for (GCCell*& ref : refs) {
+      visitor(&ref);
+    }
+  }
+
+  std::vector<GCCell*> refs;
+
+private:
+  size_t m_size;
+};
+
+std::string snapshotPath(const char* name) {
+  return ::testing::TempDir() + name;
+}
+
+// セルを書き出し、ephemerons をキー→値の辺として、roots をルートとして加える
+bool writeSnapshot(const std::string& path, const std::vector<SnapshotCell*>& cells,
+                   const std::vector<SnapshotCell*>& roots,
+                   const std::vector<std::pair<SnapshotCell*, SnapshotCell*>>& ephemerons = {}) {
+  HeapSnapshotWriter writer;
+  if (!writer.open(path)) {
+    return false;
+  }
+  for (SnapshotCell* cell : cells) {
+    writer.writeNode(cell, heapsnapshot::Space::Old);
+  }
+  for (const auto& edge : ephemerons) {
+    writer.writeEdge(edge.first, edge.second);
+  }
+  for (SnapshotCell* root : roots) {
+    writer.writeRoot(root);
+  }
+  return writer.finish();
+}
+
+uint32_t indexOf(const HeapSnapshotAnalyzer& analyzer, const GCCell* cell) {
+  return analyzer.findNode(reinterpret_cast<uintptr_t>(cell));
+}
+
+} // namespace
+
+// 書き出したノード・辺・ルートが読み込み後も一致する
+TEST(HeapSnapshotTest, RoundTrip) {
+  SnapshotCell a(16), b(32), c(64);
+  a.refs = {&b};
+  b.refs = {&c, &a};
+
+  std::string path = snapshotPath("roundtrip.heapsnapshot");
+  ASSERT_TRUE(writeSnapshot(path, {&a, &b, &c}, {&a}));
+
+  HeapSnapshotAnalyzer analyzer;
+  std::string error;
+  ASSERT_TRUE(analyzer.load(path, &error)) << error;
+
+  EXPECT_EQ(analyzer.nodeCount(), 4u);  // 仮想ルートを含む
+  EXPECT_EQ(analyzer.rootCount(), 1u);
+  EXPECT_EQ(analyzer.edgeCount(), 4u);  // ルートの辺1本 + 参照3本
+
+  uint32_t bIndex = indexOf(analyzer, &b);
+  ASSERT_NE(bIndex, HeapSnapshotAnalyzer::kNoNode);
+  EXPECT_EQ(analyzer.node(bIndex).selfSize, 32u);
+  EXPECT_EQ(analyzer.node(bIndex).space, static_cast<uint8_t>(heapsnapshot::Space::Old));
+  EXPECT_NE(analyzer.typeName(analyzer.node(bIndex).typeId).find("SnapshotCell"), std::string::npos);
+  std::remove(path.c_str());
+}
+
+// 2つの経路から参照されるノードは、経路の合流点に支配される
+TEST(HeapSnapshotTest, DominatorsAndRetainedSizes) {
+  SnapshotCell root(1), left(10), right(20), shared(100), leaf(1000);
+  root.refs = {&left, &right};
+  left.refs = {&shared};
+  right.refs = {&shared};
+  shared.refs = {&leaf};
+
+  std::string path = snapshotPath("dominators.heapsnapshot");
+  ASSERT_TRUE(writeSnapshot(path, {&root, &left, &right, &shared, &leaf}, {&root}));
+
+  HeapSnapshotAnalyzer analyzer;
+  ASSERT_TRUE(analyzer.load(path));
+  analyzer.analyze();
+
+  uint32_t rootIndex = indexOf(analyzer, &root);
+  uint32_t sharedIndex = indexOf(analyzer, &shared);
+  uint32_t leafIndex = indexOf(analyzer, &leaf);
+
+  EXPECT_EQ(analyzer.dominator(rootIndex), HeapSnapshotAnalyzer::kSuperRoot);
+  EXPECT_EQ(analyzer.dominator(sharedIndex), rootIndex);
+  EXPECT_EQ(analyzer.dominator(leafIndex), sharedIndex);
+
+  EXPECT_EQ(analyzer.retainedSize(rootIndex), 1131u);
+  EXPECT_EQ(analyzer.retainedSize(indexOf(analyzer, &left)), 10u);
+  EXPECT_EQ(analyzer.retainedSize(sharedIndex), 1100u);
+
+  std::vector<uint32_t> top = analyzer.topRetainers(2);
+  ASSERT_EQ(top.size(), 2u);
+  EXPECT_EQ(top[0], rootIndex);
+  EXPECT_EQ(top[1], sharedIndex);
+  std::remove(path.c_str());
+}
+
+// 最短保持経路はルートから対象までの参照を辿る
+TEST(HeapSnapshotTest, ShortestRetainerPath) {
+  SnapshotCell root(8), mid(8), far1(8), far2(8), target(8);
+  root.refs = {&far1, &mid};
+  far1.refs = {&far2};
+  far2.refs = {&target};
+  mid.refs = {&target};
+
+  std::string path = snapshotPath("path.heapsnapshot");
+  ASSERT_TRUE(writeSnapshot(path, {&root, &mid, &far1, &far2, &target}, {&root}));
+
+  HeapSnapshotAnalyzer analyzer;
+  ASSERT_TRUE(analyzer.load(path));
+  analyzer.analyze();
+
+  std::vector<uint32_t> expected{indexOf(analyzer, &root), indexOf(analyzer, &mid), indexOf(analyzer, &target)};
+  EXPECT_EQ(analyzer.shortestRetainerPath(indexOf(analyzer, &target)), expected);
+  std::remove(path.c_str());
+}
+
+// ルートから到達できないノードは支配ノードも保持経路も持たない
+TEST(HeapSnapshotTest, UnreachableNodes) {
+  SnapshotCell root(8), garbage(8);
+
+  std::string path = snapshotPath("unreachable.heapsnapshot");
+  ASSERT_TRUE(writeSnapshot(path, {&root, &garbage}, {&root}));
+
+  HeapSnapshotAnalyzer analyzer;
+  ASSERT_TRUE(analyzer.load(path));
+  analyzer.analyze();
+
+  uint32_t garbageIndex = indexOf(analyzer, &garbage);
+  EXPECT_TRUE(analyzer.isReachable(indexOf(analyzer, &root)));
+  EXPECT_FALSE(analyzer.isReachable(garbageIndex));
+  EXPECT_TRUE(analyzer.shortestRetainerPath(garbageIndex).empty());
+  std::remove(path.c_str());
+}
+
+// エフェメロンの辺はキーから値への参照として扱われる
+TEST(HeapSnapshotTest, EphemeronEdgesRetainValues) {
+  SnapshotCell root(8), key(8), value(64);
+  root.refs = {&key};
+
+  std::string path = snapshotPath("ephemeron.heapsnapshot");
+  ASSERT_TRUE(writeSnapshot(path, {&root, &key, &value}, {&root}, {{&key, &value}}));
+
+  HeapSnapshotAnalyzer analyzer;
+  std::string error;
+  ASSERT_TRUE(analyzer.load(path, &error)) << error;
+  analyzer.analyze();
+
+  uint32_t keyIndex = indexOf(analyzer, &key);
+  uint32_t valueIndex = indexOf(analyzer, &value);
+  EXPECT_TRUE(analyzer.isReachable(valueIndex));
+  EXPECT_EQ(analyzer.dominator(valueIndex), keyIndex);
+  EXPECT_EQ(analyzer.retainedSize(keyIndex), 72u);
+  std::remove(path.c_str());
+}
+
+// 途中で切れたファイルは終端レコードの欠落として拒否する
+TEST(HeapSnapshotTest, RejectsTruncatedFile) {
+  SnapshotCell a(8), b(8);
+  a.refs = {&b};
+
+  std::string path = snapshotPath("truncated.heapsnapshot");
+  ASSERT_TRUE(writeSnapshot(path, {&a, &b}, {&a}));
+
+  FILE* file = std::fopen(path.c_str(), "rb");
+  ASSERT_NE(file, nullptr);
+  std::vector<char> bytes(4096);
+  size_t size = std::fread(bytes.data(), 1, bytes.size(), file);
+  std::fclose(file);
+
+  file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  std::fwrite(bytes.data(), 1, size - 4, file);
+  std::fclose(file);
+
+  HeapSnapshotAnalyzer analyzer;
+  std::string error;
+  EXPECT_FALSE(analyzer.load(path, &error));
+  EXPECT_FALSE(error.empty());
+  std::remove(path.c_str());
+}
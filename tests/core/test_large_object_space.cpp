@@ -0,0 +1,73 @@
+/**
+ * @file test_large_object_space.cpp
+ * @brief 大きいオブジェクト専用領域のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "utils/memory/gc/large_object_space.h"
+
+using namespace aerojs::utils::memory;
+
+// オブジェクトごとにページ境界に揃った専用マッピングを割り当てる
+TEST(LargeObjectSpaceTest, AllocatesPageAlignedMappings) {
+  LargeObjectSpace space;
+
+  const size_t size = 100 * 1024 + 3;
+  void* first = space.allocate(size);
+  void* second = space.allocate(size);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % 4096, 0u);
+  std::memset(first, 0xAA, size);
+  std::memset(second, 0xBB, size);
+
+  EXPECT_EQ(space.objectCount(), 2u);
+  EXPECT_EQ(space.objectBytes(), 2 * size);
+  EXPECT_GE(space.committedBytes(), 2 * size);
+
+  space.release(first);
+  space.release(second);
+}
+
+// 内部ポインタからオブジェクト先頭を引け、オブジェクトの外は含まれない
+TEST(LargeObjectSpaceTest, ResolvesInteriorPointers) {
+  LargeObjectSpace space;
+
+  const size_t size = 64 * 1024;
+  auto* object = static_cast<uint8_t*>(space.allocate(size));
+  ASSERT_NE(object, nullptr);
+
+  EXPECT_TRUE(space.contains(object));
+  EXPECT_TRUE(space.contains(object + size - 1));
+  EXPECT_EQ(space.objectStart(object + 1234), object);
+  EXPECT_FALSE(space.contains(object + size));
+  EXPECT_EQ(space.objectStart(object - 1), nullptr);
+
+  space.release(object);
+}
+
+// 解放でマッピングごと返却し、この空間のものでないアドレスは無視する
+TEST(LargeObjectSpaceTest, ReleaseUnmapsWholeMapping) {
+  LargeObjectSpace space;
+
+  void* object = space.allocate(40 * 1024);
+  ASSERT_NE(object, nullptr);
+  size_t committed = space.committedBytes();
+
+  int local = 0;
+  EXPECT_EQ(space.release(&local), 0u);
+
+  EXPECT_EQ(space.release(object), committed);
+  EXPECT_EQ(space.objectCount(), 0u);
+  EXPECT_EQ(space.objectBytes(), 0u);
+  EXPECT_EQ(space.committedBytes(), 0u);
+  EXPECT_FALSE(space.contains(object));
+  EXPECT_EQ(space.release(object), 0u);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file test_large_pages.cpp
+ * @brief ヒープ・コード領域のラージページ（2MB）対応のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include "utils/memory/allocators/large_pages.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+// モードはプロセス共通なので、各テストの後に既定へ戻す
+class LargePagesTest : public ::testing::Test {
+protected:
+  void TearDown() override { setLargePageMode(LargePageMode::Disabled); }
+};
+
+bool isLargePageAligned(const void* memory) {
+  return reinterpret_cast<uintptr_t>(memory) % kLargePageSize == 0;
+}
+
+}  // namespace
+
+// 無効時は2MB境界・2MB単位の通常ページ領域として確保し、統計はフォールバックに数える
+TEST_F(LargePagesTest, DisabledModeUsesSmallPages) {
+  setLargePageMode(LargePageMode::Disabled);
+  EXPECT_EQ(largePageMode(), LargePageMode::Disabled);
+  LargePageStats before = getLargePageStats();
+
+  LargePageBacking backing = LargePageBacking::HugeTLB;
+  void* region = mapLargePageRegion(kLargePageSize + 1, &backing);
+  ASSERT_NE(region, nullptr);
+  EXPECT_EQ(backing, LargePageBacking::SmallPages);
+  EXPECT_TRUE(isLargePageAligned(region));
+  std::memset(region, 0x11, 2 * kLargePageSize);
+
+  LargePageStats during = getLargePageStats();
+  EXPECT_EQ(during.requestedBytes - before.requestedBytes, 2 * kLargePageSize);
+  EXPECT_EQ(during.fallbackBytes - before.fallbackBytes, 2 * kLargePageSize);
+  EXPECT_EQ(during.transparentBytes, before.transparentBytes);
+
+  EXPECT_TRUE(unmapLargePageRegion(region, kLargePageSize + 1));
+  LargePageStats after = getLargePageStats();
+  EXPECT_EQ(after.requestedBytes, before.requestedBytes);
+  EXPECT_EQ(after.fallbackBytes, before.fallbackBytes);
+}
+
+// mapLargePageRegion で確保していない領域の解放は何もしない
+TEST_F(LargePagesTest, UnmapIgnoresForeignRegions) {
+  int local = 0;
+  EXPECT_FALSE(unmapLargePageRegion(&local, sizeof(local)));
+  EXPECT_FALSE(unmapLargePageRegion(nullptr, kLargePageSize));
+
+  void* region = mapLargePageRegion(kLargePageSize, nullptr);
+  ASSERT_NE(region, nullptr);
+  EXPECT_TRUE(unmapLargePageRegion(region, kLargePageSize));
+  EXPECT_FALSE(unmapLargePageRegion(region, kLargePageSize));
+}
+
+// 有効時は THP を要求し、カーネルが拒否すれば通常ページへ透過的に切り替える
+TEST_F(LargePagesTest, TransparentModeFallsBackTransparently) {
+  setLargePageMode(LargePageMode::Transparent);
+  LargePageStats before = getLargePageStats();
+
+  LargePageBacking backing = LargePageBacking::HugeTLB;
+  void* region = mapLargePageRegion(4 * kLargePageSize, &backing);
+  ASSERT_NE(region, nullptr);
+  EXPECT_NE(backing, LargePageBacking::HugeTLB);
+  EXPECT_TRUE(isLargePageAligned(region));
+  std::memset(region, 0x22, 4 * kLargePageSize);
+
+  LargePageStats during = getLargePageStats();
+  size_t covered = during.transparentBytes - before.transparentBytes;
+  size_t fallback = during.fallbackBytes - before.fallbackBytes;
+  EXPECT_EQ(covered + fallback, 4 * kLargePageSize);
+  EXPECT_EQ(covered, backing == LargePageBacking::Transparent ? 4 * kLargePageSize : 0u);
+
+  EXPECT_TRUE(unmapLargePageRegion(region, 4 * kLargePageSize));
+  EXPECT_EQ(getLargePageStats().transparentBytes, before.transparentBytes);
+}
+
+// MAP_HUGETLB が使えなければ失敗を数えて THP と同じ扱いにする
+TEST_F(LargePagesTest, ExplicitModeCountsHugeTlbFailures) {
+  setLargePageMode(LargePageMode::Explicit);
+  LargePageStats before = getLargePageStats();
+
+  LargePageBacking backing = LargePageBacking::SmallPages;
+  void* region = mapLargePageRegion(kLargePageSize, &backing);
+  ASSERT_NE(region, nullptr);
+  std::memset(region, 0x33, kLargePageSize);
+
+  LargePageStats during = getLargePageStats();
+  if (backing == LargePageBacking::HugeTLB) {
+    EXPECT_EQ(during.hugeTlbBytes - before.hugeTlbBytes, kLargePageSize);
+  } else {
+    EXPECT_EQ(during.hugeTlbFailures - before.hugeTlbFailures, 1u);
+  }
+
+  EXPECT_TRUE(unmapLargePageRegion(region, kLargePageSize));
+  EXPECT_EQ(getLargePageStats().hugeTlbBytes, before.hugeTlbBytes);
+}
+
+// 既存マッピングへの要求は2MB境界に揃った内側だけを対象にし、返却で統計を戻す
+TEST_F(LargePagesTest, AdvisesAlignedInteriorOnly) {
+  setLargePageMode(LargePageMode::Transparent);
+  void* region = mapLargePageRegion(4 * kLargePageSize, nullptr);
+  ASSERT_NE(region, nullptr);
+  LargePageStats before = getLargePageStats();
+
+  // 先頭を4KBずらすと、内側の2MB境界に揃った部分は2ページ分
+  void* interior = static_cast<uint8_t*>(region) + 4096;
+  size_t size = 3 * kLargePageSize;
+  LargePageBacking backing = adviseLargePages(interior, size);
+
+  LargePageStats during = getLargePageStats();
+  EXPECT_EQ(during.requestedBytes - before.requestedBytes, size);
+  if (backing == LargePageBacking::Transparent) {
+    EXPECT_EQ(during.transparentBytes - before.transparentBytes, 2 * kLargePageSize);
+    EXPECT_EQ(during.fallbackBytes - before.fallbackBytes, size - 2 * kLargePageSize);
+  } else {
+    EXPECT_EQ(during.fallbackBytes - before.fallbackBytes, size);
+  }
+
+  releaseAdvisedLargePages(interior, size, backing);
+  LargePageStats after = getLargePageStats();
+  EXPECT_EQ(after.requestedBytes, before.requestedBytes);
+  EXPECT_EQ(after.transparentBytes, before.transparentBytes);
+  EXPECT_EQ(after.fallbackBytes, before.fallbackBytes);
+
+  unmapLargePageRegion(region, 4 * kLargePageSize);
+}
+
+// 無効時の要求は対象外として数える
+TEST_F(LargePagesTest, AdviseDisabledIsSmallPages) {
+  setLargePageMode(LargePageMode::Disabled);
+  void* region = mapLargePageRegion(2 * kLargePageSize, nullptr);
+  ASSERT_NE(region, nullptr);
+
+  EXPECT_EQ(adviseLargePages(region, 2 * kLargePageSize), LargePageBacking::SmallPages);
+  releaseAdvisedLargePages(region, 2 * kLargePageSize, LargePageBacking::SmallPages);
+  unmapLargePageRegion(region, 2 * kLargePageSize);
+}
@@ -0,0 +1,224 @@
+/**
+ * @file test_mark_compact.cpp
+ * @brief オールド世代のマーク・コンパクト（relocateTo による退避）のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/memory/gc/generational_gc.h"
+#include "utils/memory/gc/mark_compact.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+
+// ヒープ上のメンバを持つ移動可能なセル。memcpy で複製すると payload を二重解放する
+class MovableCell : public GCCell {
+public:
+  explicit MovableCell(int id) : id(id), payload(8, id) { liveCount++; }
+  MovableCell(MovableCell&& other) noexcept
+    : GCCell(other), id(other.id), payload(std::move(other.payload)), ref(other.ref) {
+    liveCount++;
+  }
+  ~MovableCell() override { liveCount--; }
+
+  void trace(GarbageCollector*) override {}
+  size_t getSize() const override { return sizeof(MovableCell); }
+  void visitReferences(std::function<void(GCCell*)> visitor) override {
+    if (ref) {
+      visitor(ref);
+    }
+  }
+  void visitMutableReferences(std::function<void(GCCell**)> visitor) override {
+    visitor(&ref);
+  }
+
+  bool canRelocate() const override { return true; }
+  GCCell* relocateTo(void* destination) override {
+    if (refuseRelocation) {
+      return nullptr;
+    }
+    return new (destination) MovableCell(std::move(*this));
+  }
+
+  int id;
+  std::vector<int> payload;
+  GCCell* ref = nullptr;
+  bool refuseRelocation = false;
+
+  static int liveCount;
+};
+
+int MovableCell::liveCount = 0;
+
+// relocateTo を実装しない（ページに固定される）セル
+class PinnedCell : public GCCell {
+public:
+  void trace(GarbageCollector*) override {}
+  size_t getSize() const override { return sizeof(PinnedCell); }
+  void visitReferences(std::function<void(GCCell*)>) override {}
+  void visitMutableReferences(std::function<void(GCCell**)>) override {}
+};
+
+// 断片化したページを模したアリーナ。退避元の解放はここでは記録だけ行う
+class Arena {
+public:
+  Arena() : m_base(static_cast<uint8_t*>(std::aligned_alloc(kPageSize, kPageSize))) {}
+  ~Arena() { std::free(m_base); }
+
+  template <typename T, typename... Args>
+  T* place(size_t offset, Args&&... args) {
+    return new (m_base + offset) T(std::forward<Args>(args)...);
+  }
+
+  bool contains(const void* ptr) const {
+    auto* p = static_cast<const uint8_t*>(ptr);
+    return p >= m_base && p < m_base + kPageSize;
+  }
+
+private:
+  uint8_t* m_base;
+};
+
+MarkCompactor::Config pageConfig() {
+  MarkCompactor::Config config;
+  config.pageSize = kPageSize;
+  config.fragmentationThreshold = 0.5f;
+  return config;
+}
+
+}  // namespace
+
+// 移動可能なセルはムーブ構築で退避され、参照とルートが新しいアドレスを指し、
+// 退避元はデストラクタを一度だけ呼ばれてから解放される
+TEST(MarkCompactorTest, RelocatesThroughMoveHook) {
+  MovableCell::liveCount = 0;
+  Arena arena;
+  MovableCell* a = arena.place<MovableCell>(0, 1);
+  MovableCell* b = arena.place<MovableCell>(512, 2);
+  a->ref = b;
+
+  std::vector<GCCell*> oldGen = {a, b};
+  GCCell* root = a;
+  std::vector<GCCell**> roots = {&root};
+
+  MarkCompactor compactor(pageConfig());
+  ASSERT_EQ(compactor.selectCandidates(oldGen), 1u);
+  compactor.evacuate([](size_t size) { return ::operator new(size); });
+  EXPECT_EQ(compactor.result().evacuatedObjects, 2u);
+  EXPECT_EQ(MovableCell::liveCount, 4);
+
+  compactor.updatePointers(oldGen, roots, nullptr);
+
+  std::vector<void*> freedSources;
+  std::unordered_map<void*, void*> relocated;
+  compactor.release(oldGen, [&](void* ptr, size_t) {
+    ASSERT_TRUE(arena.contains(ptr));
+    freedSources.push_back(ptr);
+  }, &relocated);
+
+  EXPECT_EQ(MovableCell::liveCount, 2);
+  EXPECT_EQ(freedSources.size(), 2u);
+  EXPECT_EQ(relocated.size(), 2u);
+
+  auto* newA = static_cast<MovableCell*>(oldGen[0]);
+  auto* newB = static_cast<MovableCell*>(oldGen[1]);
+  EXPECT_FALSE(arena.contains(newA));
+  EXPECT_FALSE(arena.contains(newB));
+  EXPECT_EQ(newA->id, 1);
+  EXPECT_EQ(newB->payload, std::vector<int>(8, 2));
+  EXPECT_EQ(newA->ref, newB);
+  EXPECT_EQ(root, newA);
+  EXPECT_EQ(newA->forwardingAddress, nullptr);
+
+  for (GCCell* cell : oldGen) {
+    cell->~GCCell();
+    ::operator delete(cell);
+  }
+}
+
+// relocateTo を持たない型のセルは候補ページでも移動せず、解放もされない
+TEST(MarkCompactorTest, PinsCellsWithoutMoveHook) {
+  MovableCell::liveCount = 0;
+  Arena arena;
+  PinnedCell* pinned = arena.place<PinnedCell>(0);
+  MovableCell* movable = arena.place<MovableCell>(512, 3);
+
+  std::vector<GCCell*> oldGen = {pinned, movable};
+  MarkCompactor compactor(pageConfig());
+  ASSERT_EQ(compactor.selectCandidates(oldGen), 1u);
+  ASSERT_EQ(compactor.candidates()[0].cells.size(), 1u);
+  EXPECT_EQ(compactor.candidates()[0].cells[0], movable);
+  EXPECT_EQ(compactor.pendingBytes(), sizeof(MovableCell));
+
+  compactor.evacuate([](size_t size) { return ::operator new(size); });
+  std::vector<GCCell**> roots;
+  compactor.updatePointers(oldGen, roots, nullptr);
+
+  std::vector<void*> freed;
+  compactor.release(oldGen, [&](void* ptr, size_t) { freed.push_back(ptr); }, nullptr);
+
+  EXPECT_EQ(oldGen[0], pinned);
+  EXPECT_NE(oldGen[1], movable);
+  ASSERT_EQ(freed.size(), 1u);
+  EXPECT_EQ(freed[0], movable);
+
+  oldGen[1]->~GCCell();
+  ::operator delete(oldGen[1]);
+  pinned->~PinnedCell();
+}
+
+// 移動を断ったセルはページに残り、そのために確保した退避先は release で返される
+TEST(MarkCompactorTest, RefusedRelocationReturnsDestination) {
+  MovableCell::liveCount = 0;
+  Arena arena;
+  MovableCell* stays = arena.place<MovableCell>(0, 4);
+  MovableCell* moves = arena.place<MovableCell>(512, 5);
+  stays->refuseRelocation = true;
+
+  std::vector<GCCell*> oldGen = {stays, moves};
+  MarkCompactor compactor(pageConfig());
+  ASSERT_EQ(compactor.selectCandidates(oldGen), 1u);
+
+  std::vector<void*> destinations;
+  compactor.evacuate([&](size_t size) {
+    void* destination = ::operator new(size);
+    destinations.push_back(destination);
+    return destination;
+  });
+  EXPECT_EQ(compactor.result().evacuatedObjects, 1u);
+  EXPECT_EQ(compactor.result().abortedPages, 1u);
+
+  std::vector<GCCell**> roots;
+  compactor.updatePointers(oldGen, roots, nullptr);
+
+  std::vector<void*> freed;
+  compactor.release(oldGen, [&](void* ptr, size_t) {
+    freed.push_back(ptr);
+    if (!arena.contains(ptr)) {
+      ::operator delete(ptr);
+    }
+  }, nullptr);
+
+  EXPECT_EQ(oldGen[0], stays);
+  EXPECT_EQ(stays->id, 4);
+  EXPECT_EQ(stays->payload, std::vector<int>(8, 4));
+  ASSERT_EQ(freed.size(), 2u);
+  EXPECT_EQ(MovableCell::liveCount, 2);
+
+  oldGen[1]->~GCCell();
+  ::operator delete(oldGen[1]);
+  stays->~MovableCell();
+}
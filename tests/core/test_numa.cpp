@@ -0,0 +1,151 @@
+/**
+ * @file test_numa.cpp
+ * @brief NUMAトポロジとノード別ヒープページプールのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "utils/memory/allocators/numa_page_pool.h"
+#include "utils/platform/numa_topology.h"
+
+using namespace aerojs::utils;
+using namespace aerojs::utils::memory;
+
+namespace {
+
+constexpr size_t kChunkBytes = sizeclass::kChunkSpans * sizeclass::kSpanSize;
+
+size_t roundUpGranule(size_t size) {
+  return (size + NumaPagePool::kGranule - 1) & ~(NumaPagePool::kGranule - 1);
+}
+
+// 単一ノードの環境でもノード別の経路を通すため、2ノードの偽のトポロジを使う
+class NumaPagePoolTest : public ::testing::Test {
+protected:
+  static void SetUpTestSuite() { NumaTopology::setOverride(NumaTopology::fake(2)); }
+};
+
+}  // namespace
+
+// 検出したトポロジは少なくとも1ノードで、ノード番号は0から連番
+TEST(NumaTopologyTest, DetectsAtLeastOneNode) {
+  NumaTopology topology = NumaTopology::detect();
+  ASSERT_GE(topology.nodeCount(), 1);
+  EXPECT_FALSE(topology.isFake());
+  for (int i = 0; i < topology.nodeCount(); i++) {
+    EXPECT_EQ(topology.node(i).id, i);
+    EXPECT_FALSE(topology.node(i).cpus.empty());
+  }
+}
+
+// 偽のトポロジは全ノードにCPUを持たせ、CPUより多いノードではCPUを共有させる
+TEST(NumaTopologyTest, FakeTopologySplitsCpus) {
+  NumaTopology topology = NumaTopology::fake(3);
+  ASSERT_EQ(topology.nodeCount(), 3);
+  EXPECT_TRUE(topology.isFake());
+  EXPECT_TRUE(topology.isMultiNode());
+  for (const NumaNode& node : topology.nodes()) {
+    ASSERT_FALSE(node.cpus.empty());
+    int owner = topology.nodeOfCpu(node.cpus.front());
+    EXPECT_LE(owner, node.id);
+  }
+
+  EXPECT_EQ(topology.nodeOfCpu(-1), 0);
+  EXPECT_EQ(topology.nodeOfCpu(1 << 20), 0);
+  EXPECT_EQ(NumaTopology::fake(0).nodeCount(), 1);
+}
+
+// 偽のトポロジではメモリをノードに割り当てず、スレッドは振り分けたCPUに固定できる
+TEST_F(NumaPagePoolTest, FakeTopologyPinsWithoutBinding) {
+  ASSERT_TRUE(NumaTopology::get().isFake());
+
+  char buffer[64];
+  EXPECT_FALSE(bindMemoryToNode(buffer, sizeof(buffer), 1));
+  EXPECT_FALSE(pinCurrentThreadToNode(-1));
+  EXPECT_FALSE(pinCurrentThreadToNode(NumaTopology::get().nodeCount()));
+
+  bool pinned = false;
+  int node = -1;
+  std::thread worker([&] {
+    pinned = pinCurrentThreadToNode(1);
+    node = currentNumaNode();
+  });
+  worker.join();
+  EXPECT_TRUE(pinned);
+  EXPECT_GE(node, 0);
+  EXPECT_LT(node, NumaTopology::get().nodeCount());
+}
+
+// 取得した領域は2MB境界に置かれ、領域内のどのアドレスからも所有ノードを引ける
+TEST_F(NumaPagePoolTest, RecordsOwningNode) {
+  NumaPagePool& pool = NumaPagePool::instance();
+  size_t mappedBefore = pool.nodeStats(1).mappedBytes;
+
+  const size_t size = 3 * NumaPagePool::kGranule;
+  auto* region = static_cast<uint8_t*>(pool.acquire(size, 4096, 1));
+  ASSERT_NE(region, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(region) % NumaPagePool::kGranule, 0u);
+  std::memset(region, 0x44, size);
+
+  EXPECT_EQ(pool.nodeOf(region), 1);
+  EXPECT_EQ(pool.nodeOf(region + size - 1), 1);
+  EXPECT_EQ(pool.nodeStats(1).mappedBytes, mappedBefore + size);
+  EXPECT_EQ(pool.nodeStats(1).boundBytes, 0u);
+
+  pool.release(region, size);
+  EXPECT_EQ(pool.nodeOf(region), -1);
+  EXPECT_EQ(pool.nodeStats(1).mappedBytes, mappedBefore);
+
+  int local = 0;
+  EXPECT_EQ(pool.nodeOf(&local), -1);
+}
+
+// 範囲外のノードは0として扱い、2MBを超えるアライメントは受け付けない
+TEST_F(NumaPagePoolTest, ClampsNodeAndRejectsLargeAlignment) {
+  NumaPagePool& pool = NumaPagePool::instance();
+
+  void* region = pool.acquire(NumaPagePool::kGranule, 0, 17);
+  ASSERT_NE(region, nullptr);
+  EXPECT_EQ(pool.nodeOf(region), 0);
+  pool.release(region, NumaPagePool::kGranule);
+
+  EXPECT_EQ(pool.acquire(NumaPagePool::kGranule, 2 * NumaPagePool::kGranule, 0), nullptr);
+}
+
+// チャンクサイズの領域は返却後もノードに残して再利用する
+TEST_F(NumaPagePoolTest, CachesChunkSizedRegions) {
+  NumaPagePool& pool = NumaPagePool::instance();
+  size_t cachedBefore = pool.nodeStats(1).cachedBytes;
+
+  void* chunk = pool.acquire(kChunkBytes, 4096, 1);
+  ASSERT_NE(chunk, nullptr);
+  pool.release(chunk, kChunkBytes);
+  EXPECT_EQ(pool.nodeStats(1).cachedBytes, cachedBefore + roundUpGranule(kChunkBytes));
+  EXPECT_EQ(pool.nodeOf(chunk), 1);
+
+  EXPECT_EQ(pool.acquire(kChunkBytes, 4096, 1), chunk);
+  EXPECT_EQ(pool.nodeStats(1).cachedBytes, cachedBefore);
+  pool.release(chunk, kChunkBytes);
+}
+
+// ノードの供給元を渡したアロケータのブロックは、すべてそのノードの領域から切り出される
+TEST_F(NumaPagePoolTest, AllocatorDrawsFromNode) {
+  NumaPagePool& pool = NumaPagePool::instance();
+  SizeClassAllocator allocator(pool.regionSource(1));
+
+  void* small = allocator.allocate(64);
+  void* large = allocator.allocate(256 * 1024);
+  ASSERT_NE(small, nullptr);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(pool.nodeOf(small), 1);
+  EXPECT_EQ(pool.nodeOf(large), 1);
+
+  allocator.deallocate(small);
+  allocator.deallocate(large);
+}
@@ -0,0 +1,164 @@
+/**
+ * @file test_sampling_heap_profiler.cpp
+ * @brief ポアソンサンプリングによる割り当てプロファイラのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "utils/memory/gc/sampling_heap_profiler.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+struct SmallObject {};
+struct LargeObject {};
+
+double estimatedBytes(const SamplingHeapProfiler& profiler) {
+  double total = 0;
+  profiler.forEachSample([&total](const SamplingHeapProfiler::SampleStats& stats) {
+    total += stats.estimatedBytes;
+  });
+  return total;
+}
+
+} // namespace
+
+// 開始前の割り当ては記録しない
+TEST(SamplingHeapProfilerTest, InactiveRecordsNothing) {
+  SamplingHeapProfiler profiler;
+  for (int i = 0; i < 10000; i++) {
+    profiler.onAllocation(1024, typeid(SmallObject));
+  }
+  EXPECT_FALSE(profiler.isActive());
+  EXPECT_EQ(profiler.totalSamples(), 0u);
+}
+
+// 重み付きの推定バイト数は実際の割り当て量に近い
+TEST(SamplingHeapProfilerTest, EstimatesAllocatedBytes) {
+  SamplingHeapProfiler profiler;
+  profiler.start(4096);
+
+  constexpr size_t kAllocations = 200000;
+  constexpr size_t kSize = 64;
+  for (size_t i = 0; i < kAllocations; i++) {
+    profiler.onAllocation(kSize, typeid(SmallObject));
+  }
+  profiler.stop();
+
+  double actual = static_cast<double>(kAllocations * kSize);
+  EXPECT_GT(profiler.totalSamples(), 0u);
+  EXPECT_NEAR(estimatedBytes(profiler), actual, actual * 0.15);
+}
+
+// サンプルは取得したスタックの呼び出し木と型ごとに集計される
+TEST(SamplingHeapProfilerTest, AggregatesByStackAndType) {
+  SamplingHeapProfiler profiler;
+  static int outerFunction;
+  static int innerFunction;
+  profiler.start(1, [](std::vector<AllocationFrame>& frames, size_t) {
+    AllocationFrame inner;
+    inner.function = &innerFunction;
+    inner.bytecodeOffset = 8;
+    inner.functionName = "inner";
+    inner.scriptName = "test.js";
+    inner.line = 2;
+    AllocationFrame outer;
+    outer.function = &outerFunction;
+    outer.bytecodeOffset = 4;
+    outer.functionName = "outer";
+    outer.scriptName = "test.js";
+    outer.line = 1;
+    frames.push_back(inner);
+    frames.push_back(outer);
+  });
+
+  // 各スレッドの最初の割り当ては次のサンプル点を引くだけ
+  for (int i = 0; i < 100; i++) {
+    profiler.onAllocation(4096, typeid(LargeObject));
+  }
+  profiler.stop();
+
+  std::vector<SamplingHeapProfiler::SampleStats> samples;
+  profiler.forEachSample([&samples](const SamplingHeapProfiler::SampleStats& stats) {
+    samples.push_back(stats);
+  });
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples[0].samples, profiler.totalSamples());
+  EXPECT_NE(profiler.typeName(samples[0].typeIndex).find("LargeObject"), std::string::npos);
+
+  std::vector<uint32_t> stack = profiler.stackOf(samples[0].node);
+  ASSERT_EQ(stack.size(), 2u);
+  SamplingHeapProfiler::CallTreeNode leaf = profiler.node(stack[0]);
+  EXPECT_EQ(profiler.function(leaf.functionIndex).name, "inner");
+  EXPECT_EQ(leaf.bytecodeOffset, 8u);
+  EXPECT_EQ(profiler.function(profiler.node(stack[1]).functionIndex).name, "outer");
+
+  EXPECT_FALSE(profiler.serializePprof().empty());
+}
+
+// スタックを取得しなければ (native) フレームに集計される
+TEST(SamplingHeapProfilerTest, NativeFrameWithoutCapture) {
+  SamplingHeapProfiler profiler;
+  profiler.start(1);
+  for (int i = 0; i < 10; i++) {
+    profiler.onAllocation(4096, typeid(SmallObject));
+  }
+
+  std::vector<uint32_t> nodes;
+  profiler.forEachSample([&nodes](const SamplingHeapProfiler::SampleStats& stats) {
+    nodes.push_back(stats.node);
+  });
+  ASSERT_EQ(nodes.size(), 1u);
+  std::vector<uint32_t> stack = profiler.stackOf(nodes[0]);
+  ASSERT_EQ(stack.size(), 1u);
+  EXPECT_EQ(profiler.function(profiler.node(stack[0]).functionIndex).name, "(native)");
+}
+
+// 再開始するとそれまでの集計は破棄される
+TEST(SamplingHeapProfilerTest, RestartDiscardsSamples) {
+  SamplingHeapProfiler profiler;
+  profiler.start(1);
+  for (int i = 0; i < 10; i++) {
+    profiler.onAllocation(4096, typeid(SmallObject));
+  }
+  ASSERT_GT(profiler.totalSamples(), 0u);
+
+  profiler.start(1);
+  EXPECT_EQ(profiler.totalSamples(), 0u);
+  int count = 0;
+  profiler.forEachSample([&count](const SamplingHeapProfiler::SampleStats&) { count++; });
+  EXPECT_EQ(count, 0);
+}
+
+// プロファイラ（ヒープ）ごとに次のサンプルまでの残りを持ち、他方の割り当てで消費されない
+TEST(SamplingHeapProfilerTest, ThreadStateIsPerProfiler) {
+  SamplingHeapProfiler first;
+  SamplingHeapProfiler second;
+  first.start(1024);
+  second.start(1024);
+
+  for (int i = 0; i < 100000; i++) {
+    first.onAllocation(64, typeid(SmallObject));
+  }
+  EXPECT_GT(first.totalSamples(), 0u);
+  EXPECT_EQ(second.totalSamples(), 0u);
+
+  // 1つのプロファイラを破棄しても、同じスレッドの他のプロファイラはそのまま使える
+  {
+    SamplingHeapProfiler temporary;
+    temporary.start(1024);
+    temporary.onAllocation(64, typeid(SmallObject));
+  }
+  uint64_t before = first.totalSamples();
+  for (int i = 0; i < 100000; i++) {
+    first.onAllocation(64, typeid(SmallObject));
+  }
+  EXPECT_GT(first.totalSamples(), before);
+}
@@ -0,0 +1,152 @@
+/**
+ * @file test_size_class_allocator.cpp
+ * @brief スレッドキャッシュ付きサイズクラスアロケータのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "utils/memory/allocators/size_class_allocator.h"
+
+using namespace aerojs::utils::memory;
+
+// 要求サイズはサイズクラスに切り上げられ、getSize はブロックサイズを返す
+TEST(SizeClassAllocatorTest, RoundsUpToSizeClass) {
+  SizeClassAllocator allocator;
+
+  for (size_t size : {1u, 8u, 24u, 100u, 1000u, 8192u}) {
+    void* block = allocator.allocate(size);
+    ASSERT_NE(block, nullptr) << size;
+    size_t rounded = SizeClassAllocator::roundUpSize(size);
+    EXPECT_GE(rounded, size);
+    EXPECT_EQ(allocator.getSize(block), rounded);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 8, 0u);
+    std::memset(block, 0xAB, size);
+    allocator.deallocate(block);
+  }
+
+  // 8KBを超える要求は専用マッピング
+  EXPECT_EQ(SizeClassAllocator::roundUpSize(sizeclass::kMaxSmallSize + 1), 0u);
+}
+
+// 解放したブロックは同じスレッドのキャッシュから再利用される
+TEST(SizeClassAllocatorTest, ReusesFreedBlocks) {
+  SizeClassAllocator allocator;
+
+  void* first = allocator.allocate(64);
+  ASSERT_NE(first, nullptr);
+  allocator.deallocate(first);
+  EXPECT_EQ(allocator.allocate(64), first);
+  allocator.deallocate(first);
+}
+
+// 専用マッピングの大きい要求は、整列を守り、解放でマッピングごと返す
+TEST(SizeClassAllocatorTest, LargeAllocationsAreMappedSeparately) {
+  SizeClassAllocator allocator;
+  size_t mappedBefore = allocator.getMappedBytes();
+
+  const size_t size = 100 * 1024;
+  void* block = allocator.allocate(size, 4096);
+  ASSERT_NE(block, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 4096, 0u);
+  EXPECT_EQ(allocator.getSize(block), size);
+  EXPECT_GE(allocator.getMappedBytes(), mappedBefore + size);
+  std::memset(block, 0xCD, size);
+
+  allocator.deallocate(block);
+  EXPECT_EQ(allocator.getMappedBytes(), mappedBefore);
+}
+
+// 再割り当ては同じクラスに収まれば同じブロックを返し、移動時は中身を保つ
+TEST(SizeClassAllocatorTest, ReallocatePreservesContents) {
+  SizeClassAllocator allocator;
+
+  auto* block = static_cast<uint8_t*>(allocator.allocate(40));
+  ASSERT_NE(block, nullptr);
+  for (int i = 0; i < 40; i++) {
+    block[i] = static_cast<uint8_t>(i);
+  }
+  EXPECT_EQ(allocator.reallocate(block, 33), block);
+
+  auto* grown = static_cast<uint8_t*>(allocator.reallocate(block, 20000));
+  ASSERT_NE(grown, nullptr);
+  for (int i = 0; i < 33; i++) {
+    EXPECT_EQ(grown[i], static_cast<uint8_t>(i));
+  }
+  EXPECT_EQ(allocator.reallocate(grown, 0), nullptr);
+}
+
+// 統計は全スレッドのキャッシュを合算し、他スレッドでの解放も数える
+TEST(SizeClassAllocatorTest, StatsAcrossThreads) {
+  SizeClassAllocator allocator;
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 100; i++) {
+    blocks.push_back(allocator.allocate(48));
+  }
+  EXPECT_EQ(allocator.getStats().currentAllocations, 100u);
+  EXPECT_EQ(allocator.getCurrentAllocatedSize(), 100 * SizeClassAllocator::roundUpSize(48));
+
+  std::thread freer([&] {
+    for (void* block : blocks) {
+      allocator.deallocate(block);
+    }
+    allocator.flushThreadCache();
+  });
+  freer.join();
+
+  EXPECT_EQ(allocator.getStats().currentAllocations, 0u);
+  EXPECT_EQ(allocator.getStats().totalAllocations, 100u);
+}
+
+// 払い出し中のブロックだけが列挙され、キャッシュ中の空きブロックは含まれない
+TEST(SizeClassAllocatorTest, EnumeratesAllocatedObjects) {
+  SizeClassAllocator allocator;
+
+  void* kept = allocator.allocate(128);
+  void* freed = allocator.allocate(128);
+  void* large = allocator.allocate(64 * 1024);
+  allocator.deallocate(freed);
+
+  std::vector<void*> objects = allocator.getAllocatedObjects();
+  EXPECT_NE(std::find(objects.begin(), objects.end(), kept), objects.end());
+  EXPECT_NE(std::find(objects.begin(), objects.end(), large), objects.end());
+  EXPECT_EQ(std::find(objects.begin(), objects.end(), freed), objects.end());
+
+  allocator.deallocate(kept);
+  allocator.deallocate(large);
+}
+
+// 上限を超えるマッピングは失敗として数える
+TEST(SizeClassAllocatorTest, MemoryLimitFailsAllocations) {
+  SizeClassAllocator allocator;
+  allocator.setMemoryLimit(sizeclass::kSpanSize);
+  EXPECT_EQ(allocator.getMemoryLimit(), sizeclass::kSpanSize);
+
+  EXPECT_EQ(allocator.allocate(1024 * 1024), nullptr);
+  EXPECT_EQ(allocator.allocate(64), nullptr);
+  EXPECT_EQ(allocator.getStats().failedAllocations, 2u);
+}
+
+// 全ブロックを返した後は、空きスパンの物理メモリをOSへ返せる
+TEST(SizeClassAllocatorTest, ReleasesFreeSpans) {
+  SizeClassAllocator allocator;
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 4096; i++) {
+    blocks.push_back(allocator.allocate(256));
+  }
+  for (void* block : blocks) {
+    allocator.deallocate(block);
+  }
+  allocator.flushThreadCache();
+
+  EXPECT_GT(allocator.releaseFreeMemory(), 0u);
+}
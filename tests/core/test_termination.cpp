@@ -0,0 +1,90 @@
+/**
+ * @file test_termination.cpp
+ * @brief 実行の打ち切り要求とヒープ上限超過の例外のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <exception>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "core/vm/exception/termination.h"
+#include "utils/memory/gc/heap_limit.h"
+
+using namespace aerojs::core;
+using aerojs::utils::memory::HeapLimitExceeded;
+
+// 打ち切りの例外は std::exception の catch で JS の例外に変換されない
+static_assert(!std::is_base_of_v<std::exception, ExecutionTerminated>);
+static_assert(!std::is_base_of_v<std::exception, HeapLimitExceeded>);
+
+// 要求で理由が記録され、取り消しで元に戻る
+TEST(TerminationTest, RequestAndCancel) {
+  TerminationState state;
+  EXPECT_FALSE(state.isRequested());
+  EXPECT_EQ(state.reason(), TerminationReason::None);
+  EXPECT_EQ(state.flagAddress()->load(), 0u);
+
+  state.request(TerminationReason::HeapLimit);
+  EXPECT_TRUE(state.isRequested());
+  EXPECT_EQ(state.reason(), TerminationReason::HeapLimit);
+  EXPECT_NE(state.flagAddress()->load(), 0u);
+
+  state.cancel();
+  EXPECT_FALSE(state.isRequested());
+  EXPECT_EQ(state.flagAddress()->load(), 0u);
+}
+
+// 他のスレッドからの要求がポーリングで見える
+TEST(TerminationTest, RequestFromAnotherThread) {
+  TerminationState state;
+  std::thread requester([&state] { state.request(TerminationReason::Requested); });
+  requester.join();
+
+  try {
+    throwIfTerminationRequested(&state);
+    FAIL() << "ExecutionTerminated was not thrown";
+  } catch (const ExecutionTerminated& e) {
+    EXPECT_EQ(e.reason(), TerminationReason::Requested);
+  }
+}
+
+// 要求がなければ、または状態がなければポーリングは何もしない
+TEST(TerminationTest, PollingWithoutRequest) {
+  TerminationState state;
+  EXPECT_NO_THROW(throwIfTerminationRequested(&state));
+  EXPECT_NO_THROW(throwIfTerminationRequested(nullptr));
+}
+
+// JITコードの戻り値は、番兵かつ要求済みのときだけ例外に変換する
+TEST(TerminationTest, ChecksJITResult) {
+  TerminationState state;
+  EXPECT_EQ(checkJITResult(42, &state), 42u);
+  // 要求がなければ番兵と同じビット列も通常の値として扱う
+  EXPECT_EQ(checkJITResult(kJITTerminationSentinel, &state), kJITTerminationSentinel);
+
+  state.request(TerminationReason::HeapLimit);
+  EXPECT_EQ(checkJITResult(7, &state), 7u);
+  EXPECT_THROW(checkJITResult(kJITTerminationSentinel, &state), ExecutionTerminated);
+}
+
+// ヒープ上限超過は要求サイズ・使用量・上限を運び、std::bad_alloc の catch を素通りする
+TEST(TerminationTest, HeapLimitExceededBypassesBadAlloc) {
+  bool caughtAsBadAlloc = false;
+  try {
+    try {
+      throw HeapLimitExceeded(64, 1000, 1024);
+    } catch (const std::bad_alloc&) {
+      caughtAsBadAlloc = true;
+    }
+  } catch (const HeapLimitExceeded& e) {
+    EXPECT_EQ(e.requested(), 64u);
+    EXPECT_EQ(e.used(), 1000u);
+    EXPECT_EQ(e.limit(), 1024u);
+  }
+  EXPECT_FALSE(caughtAsBadAlloc);
+}
@@ -0,0 +1,142 @@
+/**
+ * @file test_typed_pool.cpp
+ * @brief 型別フリーリストプールのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "utils/memory/pool/typed_pool.h"
+
+using namespace aerojs::utils::memory;
+
+namespace {
+
+struct Record {
+  explicit Record(int value = 0) : value(value) { liveCount++; }
+  ~Record() { liveCount--; }
+
+  int value;
+  void* payload[3] = {};
+
+  static int liveCount;
+};
+
+int Record::liveCount = 0;
+
+struct Throwing {
+  explicit Throwing(bool fail) {
+    if (fail) {
+      throw std::runtime_error("construction failed");
+    }
+  }
+  int value = 0;
+};
+
+}  // namespace
+
+// 返却したブロックは次の確保で先に再利用され、ヒットとして数える
+TEST(TypedPoolTest, ReusesReturnedBlocks) {
+  TypedFreeListPool<Record> pool;
+
+  void* first = pool.allocate();
+  EXPECT_EQ(pool.stats().misses, 1u);
+  pool.deallocate(first);
+  EXPECT_EQ(pool.cachedCount(), 1u);
+
+  EXPECT_EQ(pool.allocate(), first);
+  EXPECT_EQ(pool.stats().hits, 1u);
+  EXPECT_EQ(pool.cachedCount(), 0u);
+  pool.deallocate(first);
+  pool.deallocate(nullptr);
+  EXPECT_EQ(pool.cachedCount(), 1u);
+}
+
+// create/destroy はコンストラクタとデストラクタを呼ぶ
+TEST(TypedPoolTest, CreateAndDestroy) {
+  TypedFreeListPool<Record> pool;
+  Record::liveCount = 0;
+
+  Record* record = pool.create(7);
+  ASSERT_NE(record, nullptr);
+  EXPECT_EQ(record->value, 7);
+  EXPECT_EQ(Record::liveCount, 1);
+
+  pool.destroy(record);
+  EXPECT_EQ(Record::liveCount, 0);
+  EXPECT_EQ(pool.cachedCount(), 1u);
+  pool.destroy(nullptr);
+}
+
+// 構築が例外で失敗したブロックはプールへ戻る
+TEST(TypedPoolTest, FailedConstructionReturnsBlock) {
+  TypedFreeListPool<Throwing> pool;
+
+  EXPECT_THROW(pool.create(true), std::runtime_error);
+  EXPECT_EQ(pool.cachedCount(), 1u);
+
+  Throwing* object = pool.create(false);
+  EXPECT_EQ(pool.stats().hits, 1u);
+  pool.destroy(object);
+}
+
+// キャッシュは kMaxCached までで、超えた分はすぐに解放する
+TEST(TypedPoolTest, CapsCachedBlocks) {
+  using Pool = TypedFreeListPool<Record>;
+  Pool pool;
+
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < Pool::kMaxCached + 10; i++) {
+    blocks.push_back(pool.allocate());
+  }
+  for (void* block : blocks) {
+    pool.deallocate(block);
+  }
+  EXPECT_EQ(pool.cachedCount(), Pool::kMaxCached);
+}
+
+// GCからの解放要求の後、最初の返却でキャッシュを捨てる
+TEST(TypedPoolTest, TrimsOnEpochChange) {
+  TypedFreeListPool<Record> pool;
+
+  void* a = pool.allocate();
+  void* b = pool.allocate();
+  pool.deallocate(a);
+  EXPECT_EQ(pool.cachedCount(), 1u);
+
+  requestTypedPoolTrim();
+  pool.deallocate(b);
+  EXPECT_EQ(pool.stats().trims, 1u);
+  EXPECT_EQ(pool.cachedCount(), 1u);
+
+  // 同じ世代の間は再び捨てない
+  pool.deallocate(pool.allocate());
+  EXPECT_EQ(pool.stats().trims, 1u);
+}
+
+// スレッドごとのプールは独立し、別スレッドで確保したブロックも返却できる
+TEST(TypedPoolTest, ThreadLocalPools) {
+  using Pool = TypedFreeListPool<Record>;
+  Pool* mainPool = &Pool::local();
+
+  Record* fromOtherThread = nullptr;
+  Pool* otherPool = nullptr;
+  std::thread worker([&] {
+    otherPool = &Pool::local();
+    fromOtherThread = Pool::local().create(3);
+  });
+  worker.join();
+
+  EXPECT_NE(mainPool, otherPool);
+  ASSERT_NE(fromOtherThread, nullptr);
+  EXPECT_EQ(fromOtherThread->value, 3);
+
+  size_t cachedBefore = Pool::local().cachedCount();
+  Pool::local().destroy(fromOtherThread);
+  EXPECT_EQ(Pool::local().cachedCount(), cachedBefore + 1);
+}
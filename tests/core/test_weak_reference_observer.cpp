@@ -0,0 +1,114 @@
+/**
+ * @file test_weak_reference_observer.cpp
+ * @brief 参照カウント対象の破棄通知（FinalizationRegistry のクリーンアップ契機）のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "utils/memory/smart_ptr/ref_counted.h"
+
+using namespace aerojs::utils;
+
+namespace {
+
+class Target : public RefCounted {
+public:
+  int id = 0;
+};
+
+// FinalizationRegistry と同じく、通知では破棄されたアドレスを記録するだけにする
+class RecordingObserver : public WeakReferenceObserver {
+public:
+  void weakTargetDestroyed(const RefCounted* target) override {
+    destroyed.push_back(target);
+  }
+
+  std::vector<const RefCounted*> destroyed;
+};
+
+}  // namespace
+
+// 登録した対象が破棄されると、メモリの解放前に一度だけアドレスが通知される
+TEST(WeakReferenceObserverTest, NotifiesOnceOnDestruction) {
+  RecordingObserver observer;
+  Target* raw = new Target();
+  RefPtr<Target> target(raw);
+  WeakRefPtr<Target> weak(raw);
+
+  EXPECT_TRUE(weak.control()->addObserver(&observer));
+  EXPECT_TRUE(weak.control()->addObserver(&observer));  // 重複登録は1つにまとまる
+
+  target = RefPtr<Target>();
+  ASSERT_EQ(observer.destroyed.size(), 1u);
+  EXPECT_EQ(observer.destroyed[0], raw);
+  EXPECT_TRUE(weak.expired());
+}
+
+// 破棄済みの対象には登録できず、登録を外した対象の破棄は通知されない
+TEST(WeakReferenceObserverTest, RejectsDeadTargetsAndHonorsRemoval) {
+  RecordingObserver observer;
+
+  WeakRefPtr<Target> dead;
+  {
+    RefPtr<Target> target = makeRefPtr<Target>();
+    dead = WeakRefPtr<Target>(target.get());
+  }
+  EXPECT_FALSE(dead.control()->addObserver(&observer));
+
+  RefPtr<Target> target = makeRefPtr<Target>();
+  WeakRefPtr<Target> weak(target.get());
+  weak.control()->addObserver(&observer);
+  weak.control()->removeObserver(&observer);
+  target = RefPtr<Target>();
+
+  EXPECT_TRUE(observer.destroyed.empty());
+}
+
+// 複数の対象を監視していても、通知は破棄された対象のアドレスだけを運ぶ
+TEST(WeakReferenceObserverTest, ReportsOnlyDestroyedTargets) {
+  RecordingObserver observer;
+  std::vector<RefPtr<Target>> targets;
+  std::vector<WeakRefPtr<Target>> weaks;
+  for (int i = 0; i < 8; i++) {
+    targets.push_back(makeRefPtr<Target>());
+    targets.back()->id = i;
+    weaks.emplace_back(targets.back().get());
+    weaks.back().control()->addObserver(&observer);
+  }
+
+  const RefCounted* third = targets[3].get();
+  const RefCounted* sixth = targets[6].get();
+  targets[3] = RefPtr<Target>();
+  targets[6] = RefPtr<Target>();
+
+  EXPECT_EQ(observer.destroyed, (std::vector<const RefCounted*>{third, sixth}));
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(weaks[i].expired(), i == 3 || i == 6) << i;
+  }
+
+  for (auto& weak : weaks) {
+    if (!weak.expired()) {
+      weak.control()->removeObserver(&observer);
+    }
+  }
+}
+
+// 通知後に同じアドレスへ作られた対象は別の制御ブロックを持ち、古い弱参照とは区別できる
+TEST(WeakReferenceObserverTest, DistinguishesReusedAddresses) {
+  RecordingObserver observer;
+  RefPtr<Target> first = makeRefPtr<Target>();
+  WeakRefPtr<Target> oldWeak(first.get());
+  oldWeak.control()->addObserver(&observer);
+  first = RefPtr<Target>();
+  ASSERT_EQ(observer.destroyed.size(), 1u);
+
+  RefPtr<Target> second = makeRefPtr<Target>();
+  WeakRefPtr<Target> newWeak(second.get());
+  EXPECT_NE(newWeak.control(), oldWeak.control());
+  EXPECT_TRUE(oldWeak.expired());
+  EXPECT_FALSE(newWeak.expired());
+}
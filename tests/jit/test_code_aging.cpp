@@ -0,0 +1,62 @@
+/**
+ * @file test_code_aging.cpp
+ * @brief 使われなくなったコンパイル済みコードを見つけるためのコードエイジングのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "core/jit/code_cache.h"
+
+using namespace aerojs::core;
+
+namespace {
+
+uint8_t g_code[64];
+
+}  // namespace
+
+// 作ったばかりのエントリの年齢は0
+TEST(CodeAgingTest, StartsAtZero) {
+  CodeEntry entry(1, g_code, sizeof(g_code));
+  EXPECT_EQ(entry.getAge(), 0u);
+  EXPECT_EQ(entry.getExecutionStats().executionCount, 0u);
+}
+
+// 前回の掃引から実行されていなければ、掃引のたびに年齢が進む
+TEST(CodeAgingTest, AdvancesWhileIdle) {
+  CodeEntry entry(2, g_code, sizeof(g_code));
+  EXPECT_EQ(entry.advanceAge(), 1u);
+  EXPECT_EQ(entry.advanceAge(), 2u);
+  EXPECT_EQ(entry.advanceAge(), 3u);
+  EXPECT_EQ(entry.getAge(), 3u);
+}
+
+// 掃引の間に一度でも実行されると、次の掃引で年齢が0に戻る
+TEST(CodeAgingTest, ExecutionResetsOnNextSweep) {
+  CodeEntry entry(3, g_code, sizeof(g_code));
+  entry.advanceAge();
+  entry.advanceAge();
+  ASSERT_EQ(entry.getAge(), 2u);
+
+  // 実行の記録そのものは年齢に触れない
+  entry.recordExecution(100, 50);
+  EXPECT_EQ(entry.getAge(), 2u);
+
+  EXPECT_EQ(entry.advanceAge(), 0u);
+  EXPECT_EQ(entry.advanceAge(), 1u);
+}
+
+// resetAge はそれまでの実行を掃引済みとして扱う
+TEST(CodeAgingTest, ResetAbsorbsPendingExecutions) {
+  CodeEntry entry(4, g_code, sizeof(g_code));
+  entry.advanceAge();
+  entry.recordExecution(10, 5);
+
+  entry.resetAge();
+  EXPECT_EQ(entry.getAge(), 0u);
+  EXPECT_EQ(entry.advanceAge(), 1u);
+}
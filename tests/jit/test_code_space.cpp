@@ -0,0 +1,140 @@
+/**
+ * @file test_code_space.cpp
+ * @brief 二重マッピングされたコード領域と命令キャッシュのフラッシュのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "core/jit/code_space.h"
+
+using namespace aerojs::core;
+
+namespace {
+
+class CodeSpaceTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    if (!CodeSpace::shared().isAvailable()) {
+      GTEST_SKIP() << "code space is not available on this system";
+    }
+  }
+
+  static CodeSpace& space() { return CodeSpace::shared(); }
+};
+
+} // namespace
+
+// 書き込み用アドレスから書いた内容は、実行用アドレスから読める
+TEST_F(CodeSpaceTest, WritableAliasMapsSamePages) {
+  void* code = space().allocate(100);
+  ASSERT_NE(code, nullptr);
+  EXPECT_TRUE(space().contains(code));
+  EXPECT_GE(space().allocationSize(code), 100u);
+
+  void* writable = space().writableAddress(code);
+  ASSERT_NE(writable, nullptr);
+  EXPECT_NE(writable, code);
+
+  std::memset(writable, 0xC3, 100);
+  EXPECT_EQ(static_cast<const uint8_t*>(code)[99], 0xC3);
+
+  EXPECT_TRUE(space().free(code));
+}
+
+// コード領域の外のアドレスは扱わない
+TEST_F(CodeSpaceTest, ForeignAddressIsRejected) {
+  int local = 0;
+  EXPECT_FALSE(space().contains(&local));
+  EXPECT_EQ(space().writableAddress(&local), nullptr);
+}
+
+// 小さい割り当てはサイズクラスに、大きい割り当てはブロック単位に切り上げる
+TEST_F(CodeSpaceTest, AllocationSizesAreRounded) {
+  void* small = space().allocate(65);
+  void* large = space().allocate(CodeSpace::kMaxSmallSize + 1);
+  ASSERT_NE(small, nullptr);
+  ASSERT_NE(large, nullptr);
+
+  EXPECT_EQ(space().allocationSize(small), 128u);
+  EXPECT_EQ(space().allocationSize(large) % CodeSpace::kBlockSize, 0u);
+  EXPECT_GT(space().allocationSize(large), CodeSpace::kMaxSmallSize);
+
+  EXPECT_TRUE(space().free(small));
+  EXPECT_TRUE(space().free(large));
+}
+
+// 解放した割り当ては生存数から外れる
+TEST_F(CodeSpaceTest, FreeUpdatesStats) {
+  uint64_t before = space().getStats().liveAllocations;
+  void* code = space().allocate(256);
+  ASSERT_NE(code, nullptr);
+  EXPECT_EQ(space().getStats().liveAllocations, before + 1);
+
+  EXPECT_TRUE(space().free(code));
+  EXPECT_EQ(space().getStats().liveAllocations, before);
+}
+
+// FlushScope の中の flushRange は、一番外側のスコープを抜けるときに1回でフラッシュする
+TEST_F(CodeSpaceTest, FlushScopeBatchesRanges) {
+  void* first = space().allocate(64);
+  void* second = space().allocate(64);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(second, nullptr);
+
+  uint64_t batchesBefore = space().getStats().flushBatches;
+  {
+    CodeSpace::FlushScope outer;
+    CodeSpace::flushRange(first, 64);
+    {
+      CodeSpace::FlushScope inner;
+      CodeSpace::flushRange(second, 64);
+    }
+    EXPECT_EQ(space().getStats().flushBatches, batchesBefore);
+  }
+  EXPECT_EQ(space().getStats().flushBatches, batchesBefore + 1);
+
+  // スコープの外ではすぐにフラッシュする
+  CodeSpace::flushRange(first, 64);
+  EXPECT_EQ(space().getStats().flushBatches, batchesBefore + 2);
+
+  EXPECT_TRUE(space().free(first));
+  EXPECT_TRUE(space().free(second));
+}
+
+#if defined(__linux__)
+// fork した子での書き込みは親のコードに現れない
+TEST_F(CodeSpaceTest, ForkedChildDoesNotShareCode) {
+  void* code = space().allocate(64);
+  ASSERT_NE(code, nullptr);
+  std::memset(space().writableAddress(code), 0xAA, 64);
+
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    const uint8_t* executable = static_cast<const uint8_t*>(code);
+    if (executable[0] != 0xAA) {
+      _exit(1);
+    }
+    std::memset(space().writableAddress(code), 0xBB, 64);
+    _exit(executable[0] == 0xBB ? 0 : 2);
+  }
+
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+  EXPECT_EQ(static_cast<const uint8_t*>(code)[0], 0xAA);
+
+  EXPECT_TRUE(space().free(code));
+}
+#endif
@@ -0,0 +1,86 @@
+/**
+ * @file test_compilation_dependencies.cpp
+ * @brief 最適化コードが前提にするシェイプ・グローバル変数の世代追跡のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "core/jit/optimizing/compilation_dependencies.h"
+
+using namespace aerojs::core;
+
+// 世代表はプロセス共通なので、テストごとに別のシェイプ番号・変数名を使う
+
+// 依存のない集合は常に有効で、同じ依存は一度だけ記録する
+TEST(CompilationDependenciesTest, RecordsEachDependencyOnce) {
+  CompilationDependencySet set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_TRUE(set.isValid());
+
+  set.addShape(1001);
+  set.addShape(1001);
+  set.addGlobal("dedupeGlobal");
+  set.addGlobal("dedupeGlobal");
+  EXPECT_EQ(set.size(), 2u);
+  EXPECT_TRUE(set.isValid());
+}
+
+// 依存するシェイプがその場で変更されると、導入前の確認で外れる
+TEST(CompilationDependenciesTest, ShapeChangeInvalidates) {
+  CompilationDependencySet set;
+  set.addShape(2001);
+  ASSERT_TRUE(set.isValid());
+
+  uint32_t before = CompilationDependencies::instance().shapeEpoch(2001);
+  CompilationDependencies::instance().invalidateShape(2001);
+  EXPECT_NE(CompilationDependencies::instance().shapeEpoch(2001), before);
+  EXPECT_FALSE(set.isValid());
+}
+
+// 別のバケットのシェイプの変更では外れない
+TEST(CompilationDependenciesTest, UnrelatedShapeKeepsValid) {
+  CompilationDependencySet set;
+  set.addShape(3001);
+
+  for (uint64_t shapeId = 3002; shapeId < 3010; shapeId++) {
+    CompilationDependencies::instance().invalidateShape(shapeId);
+  }
+  EXPECT_TRUE(set.isValid());
+}
+
+// 影響範囲を特定できない変更では、すべてのシェイプ依存が外れる
+TEST(CompilationDependenciesTest, InvalidateAllShapes) {
+  CompilationDependencySet set;
+  set.addShape(4001);
+  set.addShape(4002);
+  ASSERT_TRUE(set.isValid());
+
+  CompilationDependencies::instance().invalidateAllShapes();
+  EXPECT_FALSE(set.isValid());
+}
+
+// 監視されていないグローバル変数への書き込みは世代を進めず、監視後の書き込みは依存を外す
+TEST(CompilationDependenciesTest, GlobalWritesAfterWatch) {
+  CompilationDependencies& dependencies = CompilationDependencies::instance();
+  const std::string name = "watchedOnlyAfterThisTest";
+
+  uint32_t before = dependencies.globalEpoch(name);
+  dependencies.invalidateGlobal(name);
+  EXPECT_EQ(dependencies.globalEpoch(name), before);
+
+  CompilationDependencySet set;
+  set.addGlobal(name);
+  ASSERT_TRUE(set.isValid());
+
+  dependencies.invalidateGlobal(name);
+  EXPECT_FALSE(set.isValid());
+
+  // 書き込み後に作り直した依存は有効
+  CompilationDependencySet rebuilt;
+  rebuilt.addGlobal(name);
+  EXPECT_TRUE(rebuilt.isValid());
+}
@@ -0,0 +1,213 @@
+/**
+ * @file test_compile_queue.cpp
+ * @brief 階層別レーンを持つ並行コンパイルキューのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "core/jit/compile_queue.h"
+#include "core/jit/tiered_jit_manager.h"
+
+using namespace aerojs::core;
+
+// 同じ関数の要求は1つにまとめられ、待機数に数えない
+TEST(CompileQueueTest, CoalescesDuplicateRequests) {
+  CompileQueue queue;
+
+  EXPECT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+  EXPECT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 3));
+
+  EXPECT_EQ(queue.pendingCount(), 1u);
+  CompileQueue::Stats stats = queue.getStats();
+  EXPECT_EQ(stats.enqueued, 1u);
+  EXPECT_EQ(stats.coalesced, 1u);
+
+  // まとめた要求の優先度は高い方が残る
+  QueuedCompile task;
+  ASSERT_TRUE(queue.tryPop(task));
+  EXPECT_EQ(task.functionId, 1u);
+  EXPECT_EQ(task.priority, 3u);
+  EXPECT_FALSE(queue.tryPop(task));
+}
+
+// レーンの重みが大きい階層の要求から取り出す
+TEST(CompileQueueTest, PopsHeavierLaneFirst) {
+  CompileQueue queue;
+
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+  ASSERT_TRUE(queue.push(2, nullptr, JITTier::Optimizing, 0));
+
+  QueuedCompile task;
+  ASSERT_TRUE(queue.tryPop(task));
+  EXPECT_EQ(task.functionId, 2u);
+  EXPECT_EQ(task.targetTier, JITTier::Optimizing);
+  ASSERT_TRUE(queue.tryPop(task));
+  EXPECT_EQ(task.functionId, 1u);
+}
+
+// 長く待った要求は、重みの大きいレーンの新しい要求より先に取り出される
+TEST(CompileQueueTest, AgingLetsLowerTierProgress) {
+  CompileQueue::Config config;
+  config.agingQuantumMs = 1;
+  CompileQueue queue(config);
+
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(queue.push(2, nullptr, JITTier::Optimizing, 0));
+
+  QueuedCompile task;
+  ASSERT_TRUE(queue.tryPop(task));
+  EXPECT_EQ(task.functionId, 1u);
+}
+
+// 上位階層の要求は入れ直され、元のレーンの要素は取り出し時に捨てられる
+TEST(CompileQueueTest, UpgradeSkipsStaleElement) {
+  CompileQueue queue;
+
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Optimizing, 0));
+  EXPECT_EQ(queue.pendingCount(), 1u);
+  EXPECT_EQ(queue.getStats().upgraded, 1u);
+
+  QueuedCompile task;
+  ASSERT_TRUE(queue.tryPop(task));
+  EXPECT_EQ(task.targetTier, JITTier::Optimizing);
+  EXPECT_TRUE(queue.complete(task));
+
+  EXPECT_FALSE(queue.tryPop(task));
+  EXPECT_EQ(queue.getStats().staleSkipped, 1u);
+}
+
+// コンパイル中に取り消された要求は complete() が false を返す
+TEST(CompileQueueTest, CancelDuringCompileDiscardsResult) {
+  CompileQueue queue;
+
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Optimizing, 0));
+  QueuedCompile task;
+  ASSERT_TRUE(queue.tryPop(task));
+
+  EXPECT_TRUE(queue.cancel(1));
+  EXPECT_FALSE(queue.complete(task));
+  EXPECT_FALSE(queue.cancel(1));
+}
+
+// 脱最適化では、指定した階層より下の要求は残す
+TEST(CompileQueueTest, CancelKeepsLowerTierRequests) {
+  CompileQueue queue;
+
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+  EXPECT_FALSE(queue.cancel(1, JITTier::Optimizing));
+  EXPECT_EQ(queue.pendingCount(), 1u);
+
+  EXPECT_TRUE(queue.cancel(1, JITTier::Baseline));
+  QueuedCompile task;
+  EXPECT_FALSE(queue.tryPop(task));
+}
+
+// コンパイル中に要求された上位階層は、完了後に入れ直される
+TEST(CompileQueueTest, RequeuesHigherTierAfterCompile) {
+  CompileQueue queue;
+
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+  QueuedCompile task;
+  ASSERT_TRUE(queue.tryPop(task));
+
+  ASSERT_TRUE(queue.push(1, nullptr, JITTier::Optimizing, 2));
+  EXPECT_EQ(queue.pendingCount(), 0u);
+  EXPECT_TRUE(queue.complete(task));
+  EXPECT_EQ(queue.pendingCount(), 1u);
+
+  ASSERT_TRUE(queue.tryPop(task));
+  EXPECT_EQ(task.functionId, 1u);
+  EXPECT_EQ(task.targetTier, JITTier::Optimizing);
+  EXPECT_EQ(task.priority, 2u);
+}
+
+// 上限に達したら新しい関数の要求は受け付けない（既存の要求へのまとめは受け付ける）
+TEST(CompileQueueTest, RejectsBeyondCapacity) {
+  CompileQueue::Config config;
+  config.capacity = 2;
+  CompileQueue queue(config);
+
+  EXPECT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+  EXPECT_TRUE(queue.push(2, nullptr, JITTier::Baseline, 0));
+  EXPECT_FALSE(queue.push(3, nullptr, JITTier::Baseline, 0));
+  EXPECT_TRUE(queue.push(1, nullptr, JITTier::Baseline, 0));
+
+  EXPECT_EQ(queue.pendingCount(), 2u);
+  EXPECT_EQ(queue.getStats().rejected, 1u);
+}
+
+// close() は待っている消費者を起こし、以後の waitPop を false にする
+TEST(CompileQueueTest, CloseWakesWaitingConsumer) {
+  CompileQueue queue;
+  bool popped = true;
+
+  std::thread consumer([&queue, &popped] {
+    QueuedCompile task;
+    popped = queue.waitPop(task);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue.close();
+  consumer.join();
+
+  EXPECT_FALSE(popped);
+}
+
+// 複数の生産者・消費者でも、各関数はちょうど1回ずつ取り出される
+TEST(CompileQueueTest, ConcurrentProducersAndConsumers) {
+  constexpr uint64_t kFunctionsPerProducer = 200;
+  constexpr int kProducers = 4;
+  constexpr int kConsumers = 4;
+
+  CompileQueue::Config config;
+  config.capacity = kFunctionsPerProducer * kProducers;
+  CompileQueue queue(config);
+
+  std::vector<std::atomic<int>> seen(kFunctionsPerProducer * kProducers);
+  std::atomic<uint64_t> completed{0};
+
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumers; c++) {
+    consumers.emplace_back([&] {
+      QueuedCompile task;
+      while (queue.waitPop(task)) {
+        seen[task.functionId].fetch_add(1);
+        queue.complete(task);
+        completed.fetch_add(1);
+      }
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p] {
+      for (uint64_t i = 0; i < kFunctionsPerProducer; i++) {
+        queue.push(p * kFunctionsPerProducer + i, nullptr, JITTier::Baseline, 0);
+      }
+    });
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+
+  while (completed.load() < seen.size()) {
+    std::this_thread::yield();
+  }
+  queue.close();
+  for (std::thread& consumer : consumers) {
+    consumer.join();
+  }
+
+  for (const std::atomic<int>& count : seen) {
+    EXPECT_EQ(count.load(), 1);
+  }
+  EXPECT_EQ(queue.latencyHistogram().count, seen.size());
+}
@@ -0,0 +1,176 @@
+/**
+ * @file test_frame_state.cpp
+ * @brief セーフポイントのフレーム状態のエンコードとデコードのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "core/jit/deoptimizer/frame_state.h"
+
+using namespace aerojs::core;
+
+// フレームの値は種類・表現・位置を保ったまま復元される
+TEST(FrameStateTest, RoundTripSingleFrame) {
+  constexpr uint64_t kUndefinedBits = 0x7FF8000000000002ull;
+
+  FrameStateBuilder builder;
+  builder.BeginSafepoint(0x40, SafepointKind::Call);
+  builder.BeginFrame(7, 12, 3, 1);
+  builder.AddValue(ValueLocation::InRegister(3, ValueRepresentation::Int32));
+  builder.AddValue(ValueLocation::OnStack(-16, ValueRepresentation::Double));
+  builder.AddValue(ValueLocation::DeadValue());
+  builder.AddConstant(kUndefinedBits);
+  std::shared_ptr<FrameStateTable> table = builder.Finish();
+  ASSERT_NE(table, nullptr);
+  EXPECT_TRUE(builder.Empty());
+
+  SafepointState state;
+  ASSERT_TRUE(table->Lookup(0x40, state));
+  EXPECT_EQ(state.kind, SafepointKind::Call);
+  EXPECT_EQ(state.speculation, SpeculationKind::None);
+  ASSERT_EQ(state.frames.size(), 1u);
+
+  const SafepointState::Frame& frame = state.frames[0];
+  EXPECT_EQ(frame.functionId, 7u);
+  EXPECT_EQ(frame.bytecodeOffset, 12u);
+  EXPECT_EQ(frame.localCount, 3u);
+  EXPECT_EQ(frame.stackCount, 1u);
+  ASSERT_EQ(frame.values.size(), 4u);
+
+  EXPECT_EQ(frame.values[0].kind, ValueLocationKind::Register);
+  EXPECT_EQ(frame.values[0].representation, ValueRepresentation::Int32);
+  EXPECT_EQ(frame.values[0].value, 3);
+  EXPECT_EQ(frame.values[1].kind, ValueLocationKind::StackSlot);
+  EXPECT_EQ(frame.values[1].representation, ValueRepresentation::Double);
+  EXPECT_EQ(frame.values[1].value, -16);
+  EXPECT_EQ(frame.values[2].kind, ValueLocationKind::Dead);
+  ASSERT_EQ(frame.values[3].kind, ValueLocationKind::Constant);
+  EXPECT_EQ(table->Constant(frame.values[3].value), kUndefinedBits);
+}
+
+// インライン化したフレームは外側から順に並び、ガードの投機の種類も残る
+TEST(FrameStateTest, InlinedFramesAndSpeculation) {
+  FrameStateBuilder builder;
+  builder.BeginSafepoint(0x80, SafepointKind::Guard, SpeculationKind::ShapeGuard);
+  builder.BeginFrame(1, 20, 1, 0);
+  builder.AddValue(ValueLocation::InRegister(ValueLocation::kFirstXmmRegister, ValueRepresentation::Double));
+  builder.BeginFrame(2, 4, 0, 2);
+  builder.AddValue(ValueLocation::OnStack(8));
+  builder.AddValue(ValueLocation::InRegister(0, ValueRepresentation::Boolean));
+  std::shared_ptr<FrameStateTable> table = builder.Finish();
+  ASSERT_NE(table, nullptr);
+
+  SafepointState state;
+  ASSERT_TRUE(table->Lookup(0x80, state));
+  EXPECT_EQ(state.kind, SafepointKind::Guard);
+  EXPECT_EQ(state.speculation, SpeculationKind::ShapeGuard);
+  ASSERT_EQ(state.frames.size(), 2u);
+  EXPECT_EQ(state.frames[0].functionId, 1u);
+  EXPECT_EQ(state.frames[0].values[0].value, ValueLocation::kFirstXmmRegister);
+  EXPECT_EQ(state.frames[1].functionId, 2u);
+  EXPECT_EQ(state.frames[1].values[1].representation, ValueRepresentation::Boolean);
+}
+
+// スカラー置換したオブジェクトはフィールドごと復元され、循環参照も表せる
+TEST(FrameStateTest, MaterializedObjects) {
+  FrameStateBuilder builder;
+  builder.BeginSafepoint(0x10, SafepointKind::Guard, SpeculationKind::Int32);
+  builder.BeginFrame(3, 0, 2, 0);
+  uint32_t object = builder.AddObject(99, 2);
+  builder.AddValue(ValueLocation::InRegister(1));
+  builder.AddObjectReference(object);  // 自身を指すフィールド
+  builder.AddObjectReference(object);  // 2つ目のローカルも同じオブジェクト
+  std::shared_ptr<FrameStateTable> table = builder.Finish();
+  ASSERT_NE(table, nullptr);
+
+  SafepointState state;
+  ASSERT_TRUE(table->Lookup(0x10, state));
+  ASSERT_EQ(state.objects.size(), 1u);
+  EXPECT_EQ(state.objects[0].shapeId, 99u);
+  ASSERT_EQ(state.objects[0].fields.size(), 2u);
+  EXPECT_EQ(state.objects[0].fields[1].kind, ValueLocationKind::Object);
+  EXPECT_EQ(state.objects[0].fields[1].value, 0);
+
+  const SafepointState::Frame& frame = state.frames[0];
+  EXPECT_EQ(frame.values[0].kind, ValueLocationKind::Object);
+  EXPECT_EQ(frame.values[1].kind, ValueLocationKind::Object);
+  EXPECT_EQ(frame.values[0].value, frame.values[1].value);
+}
+
+// 複数のセーフポイントは記録順に関わらず機械語オフセットで引け、定数は共有される
+TEST(FrameStateTest, MultipleSafepointsShareConstants) {
+  constexpr uint64_t kTrueBits = 0x7FF8000000000003ull;
+
+  FrameStateBuilder builder;
+  builder.BeginSafepoint(0x30, SafepointKind::Call);
+  builder.BeginFrame(1, 8, 1, 0);
+  builder.AddConstant(kTrueBits);
+  builder.BeginSafepoint(0x20, SafepointKind::Call);
+  builder.BeginFrame(1, 4, 1, 0);
+  builder.AddConstant(kTrueBits);
+  std::shared_ptr<FrameStateTable> table = builder.Finish();
+  ASSERT_NE(table, nullptr);
+
+  EXPECT_EQ(table->SafepointCount(), 2u);
+  EXPECT_TRUE(table->HasSafepoint(0x20));
+  EXPECT_TRUE(table->HasSafepoint(0x30));
+  EXPECT_FALSE(table->HasSafepoint(0x28));
+
+  SafepointState first;
+  SafepointState second;
+  ASSERT_TRUE(table->Lookup(0x20, first));
+  ASSERT_TRUE(table->Lookup(0x30, second));
+  EXPECT_EQ(first.frames[0].bytecodeOffset, 4u);
+  EXPECT_EQ(second.frames[0].bytecodeOffset, 8u);
+  EXPECT_EQ(first.frames[0].values[0].value, second.frames[0].values[0].value);
+
+  SafepointState missing;
+  EXPECT_FALSE(table->Lookup(0x28, missing));
+}
+
+// 宣言より値が少ない・多い、同じオフセットに2つのセーフポイント、はいずれも失敗する
+TEST(FrameStateTest, InvalidRecordingsAreRejected) {
+  FrameStateBuilder builder;
+
+  builder.BeginSafepoint(0x10, SafepointKind::Call);
+  builder.BeginFrame(1, 0, 2, 0);
+  builder.AddValue(ValueLocation::InRegister(0));
+  EXPECT_EQ(builder.Finish(), nullptr);
+
+  builder.BeginSafepoint(0x10, SafepointKind::Call);
+  builder.BeginFrame(1, 0, 1, 0);
+  builder.AddValue(ValueLocation::InRegister(0));
+  builder.AddValue(ValueLocation::InRegister(1));
+  EXPECT_EQ(builder.Finish(), nullptr);
+
+  builder.BeginSafepoint(0x10, SafepointKind::Call);
+  builder.BeginFrame(1, 0, 0, 0);
+  builder.BeginSafepoint(0x10, SafepointKind::Call);
+  builder.BeginFrame(1, 0, 0, 0);
+  EXPECT_EQ(builder.Finish(), nullptr);
+
+  // 失敗した後も、次の記録は最初からやり直せる
+  builder.BeginSafepoint(0x10, SafepointKind::Call);
+  builder.BeginFrame(1, 0, 0, 0);
+  EXPECT_NE(builder.Finish(), nullptr);
+}
+
+// スピルスロットは8バイト境界でなければならず、レジスタ番号は32未満
+TEST(FrameStateTest, InvalidLocationsAreRejected) {
+  FrameStateBuilder builder;
+
+  builder.BeginSafepoint(0x10, SafepointKind::Call);
+  builder.BeginFrame(1, 0, 1, 0);
+  builder.AddValue(ValueLocation::OnStack(-12));
+  EXPECT_EQ(builder.Finish(), nullptr);
+
+  builder.BeginSafepoint(0x10, SafepointKind::Call);
+  builder.BeginFrame(1, 0, 1, 0);
+  builder.AddValue(ValueLocation::InRegister(32));
+  EXPECT_EQ(builder.Finish(), nullptr);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file test_megamorphic_stub_cache.cpp
+ * @brief メガモーフィックなプロパティアクセス用スタブキャッシュのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "core/jit/ic/megamorphic_stub_cache.h"
+#include "core/vm/bytecode/feedback_vector.h"
+
+using namespace aerojs::core;
+
+namespace {
+
+// 表はプロセス共通なので、各テストは空の表から始める
+class MegamorphicStubCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override { cache().clear(); }
+  void TearDown() override { cache().clear(); }
+
+  static MegamorphicStubCache& cache() { return MegamorphicStubCache::instance(); }
+};
+
+// key と同じ一次表の位置に入る、first 以外のシェイプを探す
+uint64_t findCollidingShape(uint64_t first, uint64_t key) {
+  uint32_t hash = MegamorphicStubCache::keyHash(key);
+  uint32_t index = MegamorphicStubCache::primaryIndex(first, hash);
+  for (uint64_t shape = first + 1;; shape++) {
+    if (MegamorphicStubCache::primaryIndex(shape, hash) == index) {
+      return shape;
+    }
+  }
+}
+
+} // namespace
+
+// 同じ名前は同じキーになり、キーは0にならない
+TEST_F(MegamorphicStubCacheTest, InternKeyIsStable) {
+  uint64_t x = MegamorphicStubCache::internKey("x");
+  EXPECT_NE(x, 0u);
+  EXPECT_EQ(MegamorphicStubCache::internKey(std::string("x")), x);
+  EXPECT_NE(MegamorphicStubCache::internKey("y"), x);
+}
+
+// 登録した (シェイプ, キー) の組だけが見つかる
+TEST_F(MegamorphicStubCacheTest, InsertThenLookup) {
+  uint64_t key = MegamorphicStubCache::internKey("length");
+  uint32_t handler = encodePropertyHandler(PropertyHandlerKind::kInlineField, 3);
+  cache().insert(100, key, handler);
+
+  uint32_t found = 0;
+  ASSERT_TRUE(cache().lookup(100, key, found));
+  EXPECT_EQ(found, handler);
+  EXPECT_EQ(propertyHandlerKind(found), PropertyHandlerKind::kInlineField);
+  EXPECT_EQ(propertyHandlerIndex(found), 3u);
+
+  EXPECT_FALSE(cache().lookup(101, key, found));
+  EXPECT_FALSE(cache().lookup(100, MegamorphicStubCache::internKey("size"), found));
+}
+
+// 一次表で衝突したエントリは二次表へ移り、引き続き見つかる
+TEST_F(MegamorphicStubCacheTest, EvictedEntryMovesToSecondary) {
+  uint64_t key = MegamorphicStubCache::internKey("value");
+  uint64_t other = findCollidingShape(200, key);
+  uint64_t evictionsBefore = cache().getStats().evictions;
+
+  cache().insert(200, key, encodePropertyHandler(PropertyHandlerKind::kInlineField, 1));
+  cache().insert(other, key, encodePropertyHandler(PropertyHandlerKind::kOutOfLineField, 2));
+
+  EXPECT_EQ(cache().getStats().evictions, evictionsBefore + 1);
+
+  uint32_t handler = 0;
+  ASSERT_TRUE(cache().lookup(200, key, handler));
+  EXPECT_EQ(handler, encodePropertyHandler(PropertyHandlerKind::kInlineField, 1));
+  ASSERT_TRUE(cache().lookup(other, key, handler));
+  EXPECT_EQ(handler, encodePropertyHandler(PropertyHandlerKind::kOutOfLineField, 2));
+}
+
+// シェイプの無効化は、一次表・二次表の両方からそのシェイプのエントリだけを消す
+TEST_F(MegamorphicStubCacheTest, InvalidateShapeRemovesOnlyThatShape) {
+  uint64_t key = MegamorphicStubCache::internKey("name");
+  uint64_t other = findCollidingShape(300, key);
+
+  cache().insert(300, key, 1);
+  cache().insert(other, key, 2);
+  cache().insert(400, key, 3);
+
+  cache().invalidateShape(300);
+
+  uint32_t handler = 0;
+  EXPECT_FALSE(cache().lookup(300, key, handler));
+  EXPECT_TRUE(cache().lookup(other, key, handler));
+  EXPECT_TRUE(cache().lookup(400, key, handler));
+}
+
+// 同じ組を登録し直すと、追い出さずにハンドラを上書きする
+TEST_F(MegamorphicStubCacheTest, ReinsertOverwritesHandler) {
+  uint64_t key = MegamorphicStubCache::internKey("count");
+  uint64_t evictionsBefore = cache().getStats().evictions;
+
+  cache().insert(500, key, 1);
+  cache().insert(500, key, 2);
+
+  uint32_t handler = 0;
+  ASSERT_TRUE(cache().lookup(500, key, handler));
+  EXPECT_EQ(handler, 2u);
+  EXPECT_EQ(cache().getStats().evictions, evictionsBefore);
+}
+
+// サイトのキーは登録した値を返し、未登録なら0
+TEST_F(MegamorphicStubCacheTest, SiteKeys) {
+  uint64_t key = MegamorphicStubCache::internKey("prop");
+  cache().registerSiteKey(42, key);
+
+  EXPECT_EQ(cache().siteKey(42), key);
+  EXPECT_EQ(cache().siteKey(43), 0u);
+}
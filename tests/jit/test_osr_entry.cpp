@@ -0,0 +1,140 @@
+/**
+ * @file test_osr_entry.cpp
+ * @brief インタプリタのフレームをOSRエントリの配置へ写すフレーム変換とスタブ生成のテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "core/jit/osr/osr_entry.h"
+#include "core/runtime/values/value.h"
+
+using namespace aerojs::core;
+
+namespace {
+
+uint64_t numberBits(double value) {
+  return Value::createNumber(value).getRawBits();
+}
+
+uint64_t doubleBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+OSRFrameState makeState(uint32_t loopHeaderOffset, std::vector<uint64_t> locals, std::vector<uint64_t> stack) {
+  OSRFrameState state;
+  state.loopHeaderOffset = loopHeaderOffset;
+  state.locals = std::move(locals);
+  state.stack = std::move(stack);
+  return state;
+}
+
+}  // namespace
+
+// ベースラインの配置は退避レジスタの直下から8バイトずつ、ローカル変数・スタックの順に並べる
+TEST(OSREntryTest, BaselineLayout) {
+  OSREntryLayout layout = OSREntryLayout::baseline(12, 2, 1);
+  EXPECT_EQ(layout.loopHeaderOffset, 12u);
+  ASSERT_EQ(layout.locals.size(), 2u);
+  ASSERT_EQ(layout.stack.size(), 1u);
+  EXPECT_EQ(layout.liveSlotCount(), 3u);
+
+  int32_t expected = -OSREntryLayout::kCalleeSavedBytes;
+  for (const OSRSlot& slot : layout.locals) {
+    expected -= 8;
+    EXPECT_EQ(slot.kind, OSRValueKind::Tagged);
+    EXPECT_EQ(slot.frameOffset, expected);
+  }
+  EXPECT_EQ(layout.stack[0].frameOffset, expected - 8);
+}
+
+// フレームの大きさは RBP と退避レジスタを積んだ後もスタックが16バイト境界になるようにそろえる
+TEST(OSREntryTest, BaselineFrameSizeKeepsAlignment) {
+  for (size_t slots = 0; slots < 8; slots++) {
+    uint32_t size = OSREntryLayout::baselineFrameSize(slots);
+    EXPECT_GE(size, slots * 8);
+    EXPECT_EQ(size % 16, 8u);
+  }
+  EXPECT_EQ(OSREntryLayout::baselineFrameSize(3), 24u);
+  EXPECT_EQ(OSREntryLayout::baselineFrameSize(2), 24u);
+}
+
+// Tagged の置き場所にはビット列をそのまま、locals → stack の順に並べる
+TEST(OSREntryTest, TranslatesTaggedFrame) {
+  OSREntryLayout layout = OSREntryLayout::baseline(4, 2, 1);
+  uint64_t undefinedBits = Value::createUndefined().getRawBits();
+  OSRFrameState state = makeState(4, {numberBits(1.0), undefinedBits}, {numberBits(2.5)});
+
+  std::vector<uint64_t> buffer;
+  ASSERT_EQ(OSRFrameTranslator::translate(state, layout, buffer), OSRFrameTranslator::Result::Ok);
+  EXPECT_EQ(buffer, (std::vector<uint64_t>{numberBits(1.0), undefinedBits, numberBits(2.5)}));
+}
+
+// Int32 は符号拡張した整数、Double は double のビット列に変え、Dead は飛ばす
+TEST(OSREntryTest, UnboxesTypedSlotsAndSkipsDead) {
+  OSREntryLayout layout = OSREntryLayout::baseline(8, 3, 1);
+  layout.locals[0].kind = OSRValueKind::Int32;
+  layout.locals[1].kind = OSRValueKind::Dead;
+  layout.locals[2].kind = OSRValueKind::Double;
+  EXPECT_EQ(layout.liveSlotCount(), 3u);
+
+  OSRFrameState state = makeState(8, {numberBits(-5.0), numberBits(99.0), numberBits(0.25)}, {numberBits(7.0)});
+
+  std::vector<uint64_t> buffer;
+  ASSERT_EQ(OSRFrameTranslator::translate(state, layout, buffer), OSRFrameTranslator::Result::Ok);
+  ASSERT_EQ(buffer.size(), 3u);
+  EXPECT_EQ(static_cast<int64_t>(buffer[0]), -5);
+  EXPECT_EQ(buffer[1], doubleBits(0.25));
+  EXPECT_EQ(buffer[2], numberBits(7.0));
+}
+
+// 配置に合わない値やフレームは受け付けず、インタプリタで続ける
+TEST(OSREntryTest, RejectsMismatches) {
+  OSREntryLayout layout = OSREntryLayout::baseline(16, 1, 0);
+  std::vector<uint64_t> buffer;
+
+  layout.locals[0].kind = OSRValueKind::Int32;
+  EXPECT_EQ(OSRFrameTranslator::translate(makeState(16, {numberBits(1.5)}, {}), layout, buffer),
+            OSRFrameTranslator::Result::TypeMismatch);
+
+  EXPECT_EQ(OSRFrameTranslator::translate(makeState(16, {Value::createUndefined().getRawBits()}, {}), layout, buffer),
+            OSRFrameTranslator::Result::TypeMismatch);
+
+  EXPECT_EQ(OSRFrameTranslator::translate(makeState(20, {numberBits(1.0)}, {}), layout, buffer),
+            OSRFrameTranslator::Result::FrameMismatch);
+  EXPECT_EQ(OSRFrameTranslator::translate(makeState(16, {numberBits(1.0)}, {numberBits(2.0)}), layout, buffer),
+            OSRFrameTranslator::Result::FrameMismatch);
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+// スタブは通常のプロローグで始まり、ループヘッダの絶対アドレスへ飛んで終わる
+TEST(OSREntryTest, EmitsStubForX64) {
+  OSREntryLayout layout = OSREntryLayout::baseline(0, 2, 0);
+  layout.locals[1].kind = OSRValueKind::Dead;
+  uint8_t loopHeader[1] = {0xC3};
+
+  std::vector<uint8_t> code;
+  ASSERT_TRUE(emitOSREntryStub(layout, loopHeader, code));
+  ASSERT_GE(code.size(), 12u);
+  EXPECT_EQ(code[0], 0x55);
+  EXPECT_EQ(code[code.size() - 2], 0xFF);
+  EXPECT_EQ(code[code.size() - 1], 0xE0);
+
+  uint64_t target;
+  std::memcpy(&target, &code[code.size() - 10], sizeof(target));
+  EXPECT_EQ(target, reinterpret_cast<uint64_t>(loopHeader));
+
+  // 生きている値1つにつき、バッファからの読み込みとフレームへの書き込みが1組ずつ入る
+  std::vector<uint8_t> withBoth;
+  layout.locals[1].kind = OSRValueKind::Tagged;
+  ASSERT_TRUE(emitOSREntryStub(layout, loopHeader, withBoth));
+  EXPECT_EQ(withBoth.size(), code.size() + 14);
+}
+#endif
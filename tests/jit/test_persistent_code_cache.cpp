@@ -0,0 +1,133 @@
+/**
+ * @file test_persistent_code_cache.cpp
+ * @brief プロセスをまたいでバイトコードを再利用するディスクキャッシュのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/jit/persistent_code_cache.h"
+#include "core/vm/bytecode/bytecode_module.h"
+
+using namespace aerojs::core;
+
+namespace {
+
+// テストごとに空のキャッシュディレクトリを使う
+class PersistentCodeCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_directory = std::filesystem::path(::testing::TempDir()) /
+                  ("aerojs_code_cache_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+    std::filesystem::remove_all(m_directory);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(m_directory); }
+
+  std::vector<std::filesystem::path> cacheFiles() const {
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(m_directory)) {
+      files.push_back(entry.path());
+    }
+    return files;
+  }
+
+  static std::unique_ptr<BytecodeModule> makeModule(const std::string& name) {
+    BytecodeModuleMetadata metadata;
+    metadata.module_name = name;
+    auto module = std::make_unique<BytecodeModule>(metadata);
+    module->addString(name);
+    module->addString("value");
+    return module;
+  }
+
+  std::filesystem::path m_directory;
+};
+
+}  // namespace
+
+// 書き込んだバイトコードは同じソースで読み込め、復元できる
+TEST_F(PersistentCodeCacheTest, StoresAndLoadsBytecode) {
+  PersistentCodeCache cache(m_directory.string());
+  const std::string source = "let x = 1;";
+
+  EXPECT_EQ(cache.load(source), nullptr);
+  EXPECT_EQ(cache.getStats().misses, 1u);
+
+  ASSERT_TRUE(cache.store(source, *makeModule("script")));
+  EXPECT_EQ(cache.getStats().stores, 1u);
+  ASSERT_EQ(cacheFiles().size(), 1u);
+
+  auto loaded = cache.load(source);
+  ASSERT_NE(loaded, nullptr);
+  EXPECT_EQ(cache.getStats().hits, 1u);
+
+  std::unique_ptr<BytecodeModule> module = loaded->bytecode();
+  ASSERT_NE(module, nullptr);
+  ASSERT_EQ(module->getStringTable().size(), 2u);
+  EXPECT_EQ(module->getString(0), "script");
+}
+
+// ソースが変われば別のキーになり、古いキャッシュは使われない
+TEST_F(PersistentCodeCacheTest, KeyedBySource) {
+  PersistentCodeCache cache(m_directory.string());
+  ASSERT_TRUE(cache.store("let x = 1;", *makeModule("a")));
+
+  EXPECT_NE(PersistentCodeCache::hashSource("let x = 1;"), PersistentCodeCache::hashSource("let x = 2;"));
+  EXPECT_EQ(cache.load("let x = 2;"), nullptr);
+  EXPECT_EQ(cache.getStats().misses, 1u);
+}
+
+// 中身が壊れたファイルは検証で外れ、削除される
+TEST_F(PersistentCodeCacheTest, RejectsCorruptedFiles) {
+  PersistentCodeCache cache(m_directory.string());
+  const std::string source = "function f() { return 42; }";
+  ASSERT_TRUE(cache.store(source, *makeModule("corrupt")));
+
+  std::filesystem::path file = cacheFiles().at(0);
+  {
+    std::fstream stream(file, std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(-1, std::ios::end);
+    stream.put('\x7f');
+  }
+
+  EXPECT_EQ(cache.load(source), nullptr);
+  EXPECT_EQ(cache.getStats().rejected, 1u);
+  EXPECT_FALSE(std::filesystem::exists(file));
+}
+
+// 途中で切れたファイルも検証で外れる
+TEST_F(PersistentCodeCacheTest, RejectsTruncatedFiles) {
+  PersistentCodeCache cache(m_directory.string());
+  const std::string source = "var y = [1, 2, 3];";
+  ASSERT_TRUE(cache.store(source, *makeModule("truncated")));
+
+  std::filesystem::path file = cacheFiles().at(0);
+  std::filesystem::resize_file(file, std::filesystem::file_size(file) / 2);
+
+  EXPECT_EQ(cache.load(source), nullptr);
+  EXPECT_EQ(cache.getStats().rejected, 1u);
+}
+
+// 別のビルドIDで書かれたファイルと clear の対象はキャッシュファイルだけ
+TEST_F(PersistentCodeCacheTest, RemovesStaleAndClears) {
+  PersistentCodeCache cache(m_directory.string());
+  ASSERT_TRUE(cache.store("current();", *makeModule("current")));
+
+  std::ofstream(m_directory / "0000000000000001-0000000000000002.ajcc") << "stale";
+  std::ofstream(m_directory / "unrelated.txt") << "keep";
+
+  EXPECT_EQ(cache.removeStaleEntries(), 1u);
+  EXPECT_NE(cache.load("current();"), nullptr);
+
+  cache.clear();
+  EXPECT_EQ(cache.load("current();"), nullptr);
+  EXPECT_TRUE(std::filesystem::exists(m_directory / "unrelated.txt"));
+}
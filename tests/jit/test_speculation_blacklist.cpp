@@ -0,0 +1,86 @@
+/**
+ * @file test_speculation_blacklist.cpp
+ * @brief バイトコード位置ごとの投機の禁止リストのテスト
+ * @version 0.1.0
+ * @license MIT
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "core/jit/deoptimizer/speculation.h"
+
+using namespace aerojs::core;
+
+// 閾値に達した失敗で初めて禁止され、それ以降の失敗では新たに禁止されない
+TEST(SpeculationBlacklistTest, DisallowsAfterThreshold) {
+  SpeculationBlacklist blacklist;
+
+  EXPECT_FALSE(blacklist.RecordFailure(10, SpeculationKind::Int32, 3));
+  EXPECT_FALSE(blacklist.RecordFailure(10, SpeculationKind::Int32, 3));
+  EXPECT_TRUE(blacklist.IsAllowed(10, SpeculationKind::Int32));
+
+  EXPECT_TRUE(blacklist.RecordFailure(10, SpeculationKind::Int32, 3));
+  EXPECT_FALSE(blacklist.IsAllowed(10, SpeculationKind::Int32));
+  EXPECT_FALSE(blacklist.RecordFailure(10, SpeculationKind::Int32, 3));
+  EXPECT_EQ(blacklist.DisallowedCount(), 1u);
+}
+
+// 禁止は位置と種類の組ごとで、他の位置・種類には影響しない
+TEST(SpeculationBlacklistTest, ScopedToSiteAndKind) {
+  SpeculationBlacklist blacklist;
+
+  EXPECT_TRUE(blacklist.RecordFailure(10, SpeculationKind::ShapeGuard, 1));
+
+  EXPECT_FALSE(blacklist.IsAllowed(10, SpeculationKind::ShapeGuard));
+  EXPECT_TRUE(blacklist.IsAllowed(10, SpeculationKind::BoundsCheck));
+  EXPECT_TRUE(blacklist.IsAllowed(11, SpeculationKind::ShapeGuard));
+}
+
+// None と範囲外の種類は記録しない
+TEST(SpeculationBlacklistTest, IgnoresNonSpeculativeKinds) {
+  SpeculationBlacklist blacklist;
+
+  EXPECT_FALSE(blacklist.RecordFailure(0, SpeculationKind::None, 1));
+  EXPECT_FALSE(blacklist.RecordFailure(0, SpeculationKind::Count, 1));
+  blacklist.Disallow(0, SpeculationKind::None);
+
+  EXPECT_TRUE(blacklist.Empty());
+}
+
+// 直接の禁止は重複して数えず、Clear() ですべて解除される
+TEST(SpeculationBlacklistTest, DisallowAndClear) {
+  SpeculationBlacklist blacklist;
+
+  blacklist.Disallow(5, SpeculationKind::CallTarget);
+  blacklist.Disallow(5, SpeculationKind::CallTarget);
+  blacklist.Disallow(6, SpeculationKind::Overflow);
+  EXPECT_EQ(blacklist.DisallowedCount(), 2u);
+  EXPECT_FALSE(blacklist.IsAllowed(5, SpeculationKind::CallTarget));
+
+  // 禁止済みの組の失敗は新たな禁止にならない
+  EXPECT_FALSE(blacklist.RecordFailure(5, SpeculationKind::CallTarget, 1));
+
+  blacklist.Clear();
+  EXPECT_TRUE(blacklist.Empty());
+  EXPECT_TRUE(blacklist.IsAllowed(5, SpeculationKind::CallTarget));
+}
+
+// 失敗回数は飽和するので、大きな閾値でも溢れて禁止が外れることはない
+TEST(SpeculationBlacklistTest, FailureCountSaturates) {
+  SpeculationBlacklist blacklist;
+
+  bool disallowed = false;
+  for (int i = 0; i < 300; i++) {
+    disallowed |= blacklist.RecordFailure(1, SpeculationKind::Double, UINT8_MAX);
+  }
+  EXPECT_TRUE(disallowed);
+  EXPECT_FALSE(blacklist.IsAllowed(1, SpeculationKind::Double));
+}
+
+TEST(SpeculationBlacklistTest, KindNames) {
+  EXPECT_EQ(std::string(SpeculationKindToString(SpeculationKind::Int32)), "Int32");
+  EXPECT_EQ(std::string(SpeculationKindToString(SpeculationKind::BoundsCheck)), "BoundsCheck");
+  EXPECT_EQ(std::string(SpeculationKindToString(SpeculationKind::Count)), "Unknown");
+}
@@ -0,0 +1,140 @@
+/**
+ * @file benchmark_memory.cpp
+ * @brief エンジン内部アロケータのマルチスレッド性能テスト
+ * @version 1.0.0
+ * @license MIT
+ */
+
+#include "../../src/utils/memory/allocators/memory_allocator.h"
+#include "../../src/utils/memory/allocators/size_class_allocator.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace aerojs::utils::memory;
+using Clock = std::chrono::high_resolution_clock;
+
+class AllocatorBenchmarkTest : public ::testing::Test {
+protected:
+  // 各スレッドが小サイズの割り当てと解放を繰り返し、スループット（ops/秒）を返す
+  double runWorkload(MemoryAllocator& allocator, size_t threadCount) {
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+
+    for (size_t t = 0; t < threadCount; ++t) {
+      threads.emplace_back([&allocator, &start, t]() {
+        std::mt19937 gen(static_cast<uint32_t>(t));
+        std::uniform_int_distribution<size_t> sizeDist(8, 512);
+        std::vector<void*> live(LIVE_SET, nullptr);
+
+        while (!start.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+
+        for (size_t i = 0; i < OPS_PER_THREAD; ++i) {
+          size_t slot = gen() % LIVE_SET;
+          if (live[slot]) {
+            allocator.deallocate(live[slot]);
+          }
+          size_t size = sizeDist(gen);
+          live[slot] = allocator.allocate(size);
+          if (live[slot]) {
+            static_cast<char*>(live[slot])[0] = 1;
+          }
+        }
+
+        for (void* ptr : live) {
+          allocator.deallocate(ptr);
+        }
+      });
+    }
+
+    auto begin = Clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    return static_cast<double>(OPS_PER_THREAD * threadCount) / elapsed;
+  }
+
+  static constexpr size_t OPS_PER_THREAD = 200'000;
+  static constexpr size_t LIVE_SET = 1024;
+};
+
+// スレッド数ごとのスループット比較
+TEST_F(AllocatorBenchmarkTest, MultithreadedThroughput) {
+  for (size_t threadCount : {1u, 4u, 16u}) {
+    StandardAllocator standard;
+    SizeClassAllocator sizeClass;
+
+    double standardOps = runWorkload(standard, threadCount);
+    double sizeClassOps = runWorkload(sizeClass, threadCount);
+
+    std::cout << threadCount << " threads: StandardAllocator " << standardOps / 1e6
+              << " Mops/s, SizeClassAllocator " << sizeClassOps / 1e6 << " Mops/s ("
+              << sizeClassOps / standardOps << "x)" << std::endl;
+
+    EXPECT_EQ(sizeClass.getStats().currentAllocations, 0u);
+  }
+}
+
+// スレッドをまたいだ解放と空きスパンの返却
+TEST_F(AllocatorBenchmarkTest, CrossThreadFreeAndRelease) {
+  SizeClassAllocator allocator;
+  std::vector<void*> blocks(100'000);
+
+  std::thread producer([&]() {
+    for (auto& block : blocks) {
+      block = allocator.allocate(64);
+      ASSERT_NE(block, nullptr);
+      std::memset(block, 0xAB, 64);
+    }
+  });
+  producer.join();
+
+  size_t mappedBefore = allocator.getMappedBytes();
+
+  std::thread consumer([&]() {
+    for (void* block : blocks) {
+      allocator.deallocate(block);
+    }
+  });
+  consumer.join();
+
+  const auto& stats = allocator.getStats();
+  EXPECT_EQ(stats.totalAllocations, blocks.size());
+  EXPECT_EQ(stats.currentAllocations, 0u);
+  EXPECT_EQ(stats.currentBytes, 0u);
+
+  allocator.releaseFreeMemory();
+  EXPECT_LT(allocator.getMappedBytes(), mappedBefore);
+}
+
+// 大サイズと高アライメントの要求
+TEST_F(AllocatorBenchmarkTest, LargeAndAlignedAllocations) {
+  SizeClassAllocator allocator;
+
+  void* large = allocator.allocate(1024 * 1024);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(allocator.getSize(large), 1024u * 1024u);
+  std::memset(large, 0, 1024 * 1024);
+
+  void* aligned = allocator.allocate(40, 64);
+  ASSERT_NE(aligned, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0u);
+
+  EXPECT_EQ(allocator.getAllocatedObjects().size(), 2u);
+
+  allocator.deallocate(large);
+  allocator.deallocate(aligned);
+  EXPECT_EQ(allocator.getStats().currentAllocations, 0u);
+}
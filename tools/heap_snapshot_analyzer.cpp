@@ -0,0 +1,190 @@
+/**
+ * @file heap_snapshot_analyzer.cpp
+ * @brief ヒープスナップショット解析ツール
+ *
+ * ParallelGC::writeHeapSnapshot で書き出したスナップショットを読み込み、
+ * 支配木・保持サイズ・最短保持経路を計算して表示します。
+ * 本番プロセスの外で実行するため、リーク調査で対象プロセスのメモリを消費しません。
+ *
+ * @author AeroJS Team
+ * @version 1.0.0
+ * @copyright MIT License
+ */
+
+#include "../src/utils/memory/gc/heap_snapshot_analyzer.h"
+#include "../src/utils/memory/gc/heap_snapshot_format.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using aerojs::utils::memory::HeapSnapshotAnalyzer;
+
+namespace {
+
+struct CommandLineArgs {
+    std::string snapshotFile;
+    size_t topCount = 20;
+    size_t typeCount = 20;
+    std::vector<uint64_t> pathTargets;
+    bool showHelp = false;
+};
+
+void PrintUsage(const char* programName) {
+    std::cout << "AeroJS ヒープスナップショット解析ツール\n\n";
+    std::cout << "使用方法:\n";
+    std::cout << "  " << programName << " [オプション] <スナップショット>\n\n";
+    std::cout << "オプション:\n";
+    std::cout << "  -h, --help              このヘルプを表示\n";
+    std::cout << "  --top <N>               保持サイズ上位N件を表示 (デフォルト: 20)\n";
+    std::cout << "  --types <N>             型別集計の上位N件を表示 (デフォルト: 20)\n";
+    std::cout << "  --path <アドレス>       ルートからの最短保持経路を表示 (複数指定可)\n\n";
+    std::cout << "例:\n";
+    std::cout << "  " << programName << " heap.ajsheap\n";
+    std::cout << "  " << programName << " --top 50 --path 0x7f12a4c01230 heap.ajsheap\n";
+}
+
+bool ParseArgs(int argc, char* argv[], CommandLineArgs& args) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            args.showHelp = true;
+        } else if (arg == "--top" && i + 1 < argc) {
+            args.topCount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--types" && i + 1 < argc) {
+            args.typeCount = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--path" && i + 1 < argc) {
+            args.pathTargets.push_back(std::strtoull(argv[++i], nullptr, 0));
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "不明なオプション: " << arg << "\n";
+            return false;
+        } else {
+            args.snapshotFile = arg;
+        }
+    }
+    return true;
+}
+
+std::string FormatNode(const HeapSnapshotAnalyzer& analyzer, uint32_t index) {
+    const auto& node = analyzer.node(index);
+    std::ostringstream out;
+    out << analyzer.typeName(node.typeId) << " @0x" << std::hex << node.id << std::dec
+        << " [" << aerojs::utils::memory::heapsnapshot::spaceName(node.space) << "]";
+    return out.str();
+}
+
+void PrintSummary(const HeapSnapshotAnalyzer& analyzer) {
+    uint64_t totalSize = 0, reachableSize = 0;
+    size_t reachable = 0;
+    for (uint32_t i = 1; i < analyzer.nodeCount(); i++) {
+        totalSize += analyzer.node(i).selfSize;
+        if (analyzer.isReachable(i)) {
+            reachable++;
+            reachableSize += analyzer.node(i).selfSize;
+        }
+    }
+
+    std::cout << "ノード数:       " << analyzer.nodeCount() - 1 << "\n";
+    std::cout << "辺数:           " << analyzer.edgeCount() - analyzer.rootCount() << "\n";
+    std::cout << "ルート数:       " << analyzer.rootCount() << "\n";
+    std::cout << "合計サイズ:     " << totalSize << " バイト\n";
+    std::cout << "到達可能:       " << reachable << " ノード / " << reachableSize << " バイト\n";
+    std::cout << "到達不能:       " << (analyzer.nodeCount() - 1 - reachable) << " ノード / "
+              << (totalSize - reachableSize) << " バイト\n\n";
+}
+
+void PrintTypeStatistics(const HeapSnapshotAnalyzer& analyzer, size_t count) {
+    struct TypeStats {
+        size_t objects = 0;
+        uint64_t selfSize = 0;
+    };
+    std::map<uint32_t, TypeStats> byType;
+    for (uint32_t i = 1; i < analyzer.nodeCount(); i++) {
+        auto& stats = byType[analyzer.node(i).typeId];
+        stats.objects++;
+        stats.selfSize += analyzer.node(i).selfSize;
+    }
+
+    std::vector<std::pair<uint32_t, TypeStats>> sorted(byType.begin(), byType.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.second.selfSize > b.second.selfSize; });
+
+    std::cout << "型別集計（自己サイズ順）:\n";
+    std::cout << std::setw(12) << "個数" << std::setw(16) << "自己サイズ" << "  型\n";
+    for (size_t i = 0; i < std::min(count, sorted.size()); i++) {
+        std::cout << std::setw(12) << sorted[i].second.objects
+                  << std::setw(16) << sorted[i].second.selfSize
+                  << "  " << analyzer.typeName(sorted[i].first) << "\n";
+    }
+    std::cout << "\n";
+}
+
+void PrintTopRetainers(const HeapSnapshotAnalyzer& analyzer, size_t count) {
+    std::cout << "保持サイズ上位:\n";
+    std::cout << std::setw(16) << "保持サイズ" << std::setw(12) << "自己サイズ" << "  ノード\n";
+    for (uint32_t index : analyzer.topRetainers(count)) {
+        std::cout << std::setw(16) << analyzer.retainedSize(index)
+                  << std::setw(12) << analyzer.node(index).selfSize
+                  << "  " << FormatNode(analyzer, index) << "\n";
+    }
+    std::cout << "\n";
+}
+
+void PrintRetainerPath(const HeapSnapshotAnalyzer& analyzer, uint64_t id) {
+    std::cout << "最短保持経路 0x" << std::hex << id << std::dec << ":\n";
+    uint32_t index = analyzer.findNode(id);
+    if (index == HeapSnapshotAnalyzer::kNoNode) {
+        std::cout << "  スナップショットに存在しません\n\n";
+        return;
+    }
+
+    auto path = analyzer.shortestRetainerPath(index);
+    if (path.empty()) {
+        std::cout << "  ルートから到達できません（取得時点で回収可能）\n\n";
+        return;
+    }
+
+    std::cout << "  (roots)\n";
+    for (size_t i = 0; i < path.size(); i++) {
+        std::cout << std::string(2 * (i + 2), ' ') << "-> " << FormatNode(analyzer, path[i])
+                  << " 保持 " << analyzer.retainedSize(path[i]) << " バイト\n";
+    }
+    std::cout << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    CommandLineArgs args;
+    if (!ParseArgs(argc, argv, args)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    if (args.showHelp || args.snapshotFile.empty()) {
+        PrintUsage(argv[0]);
+        return args.showHelp ? 0 : 1;
+    }
+
+    HeapSnapshotAnalyzer analyzer;
+    std::string error;
+    if (!analyzer.load(args.snapshotFile, &error)) {
+        std::cerr << "スナップショットを読み込めません: " << args.snapshotFile << ": " << error << "\n";
+        return 1;
+    }
+    analyzer.analyze();
+
+    PrintSummary(analyzer);
+    PrintTypeStatistics(analyzer, args.typeCount);
+    PrintTopRetainers(analyzer, args.topCount);
+    for (uint64_t id : args.pathTargets) {
+        PrintRetainerPath(analyzer, id);
+    }
+    return 0;
+}